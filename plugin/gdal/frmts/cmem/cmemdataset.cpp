@@ -0,0 +1,1215 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  Compressed In Memory Raster
+ * Purpose:  In memory raster stored as independently compressed tiles.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "gdal_priv.h"
+#include "cpl_string.h"
+
+CPL_CVSID("$Id$");
+
+CPL_C_START
+void    GDALRegister_CMEM(void);
+CPL_C_END
+
+/*
+ * Each band is split in tiles of BLOCKXSIZE x BLOCKYSIZE pixels. A tile is
+ * either absent (sparse tile, read as the nodata value, or 0 when there is
+ * no nodata value), or stored as a compressed blob made of a 2 byte header
+ * followed by the payload :
+ *   - byte 0 : codec (CMEM_CODEC_xxx)
+ *   - byte 1 : 1 if the bytes of multi-byte words have been shuffled into
+ *              byte planes before compression, 0 otherwise.
+ *
+ * Tiles are decompressed on demand into the GDAL block cache, and compressed
+ * again when dirty blocks are flushed.
+ */
+
+#define CMEM_CODEC_NONE     0
+#define CMEM_CODEC_RLE      1
+#define CMEM_CODEC_LZ4      2
+
+#define CMEM_HEADER_SIZE    2
+
+/************************************************************************/
+/* ==================================================================== */
+/*      Codecs                                                          */
+/* ==================================================================== */
+/************************************************************************/
+
+/************************************************************************/
+/*                         CMEMShuffleBytes()                           */
+/*                                                                      */
+/*      Reorder an array of nWords words of nWordSize bytes as          */
+/*      nWordSize planes of nWords bytes, which helps compression of    */
+/*      slowly varying values.                                          */
+/************************************************************************/
+
+static void CMEMShuffleBytes( const GByte *pabySrc, GByte *pabyDst,
+                              int nWords, int nWordSize )
+{
+    for( int iByte = 0; iByte < nWordSize; iByte++ )
+    {
+        const GByte *pabyIn = pabySrc + iByte;
+        GByte *pabyOut = pabyDst + (size_t)iByte * nWords;
+        for( int i = 0; i < nWords; i++ )
+        {
+            pabyOut[i] = *pabyIn;
+            pabyIn += nWordSize;
+        }
+    }
+}
+
+static void CMEMUnshuffleBytes( const GByte *pabySrc, GByte *pabyDst,
+                                int nWords, int nWordSize )
+{
+    for( int iByte = 0; iByte < nWordSize; iByte++ )
+    {
+        const GByte *pabyIn = pabySrc + (size_t)iByte * nWords;
+        GByte *pabyOut = pabyDst + iByte;
+        for( int i = 0; i < nWords; i++ )
+        {
+            *pabyOut = pabyIn[i];
+            pabyOut += nWordSize;
+        }
+    }
+}
+
+/************************************************************************/
+/*                  CMEMWriteVarInt() / CMEMReadVarInt()                */
+/************************************************************************/
+
+static GByte *CMEMWriteVarInt( GByte *pabyOut, GUInt32 nVal )
+{
+    while( nVal >= 0x80 )
+    {
+        *pabyOut++ = (GByte) (0x80 | (nVal & 0x7F));
+        nVal >>= 7;
+    }
+    *pabyOut++ = (GByte) nVal;
+    return pabyOut;
+}
+
+static const GByte *CMEMReadVarInt( const GByte *pabyIn, const GByte *pabyEnd,
+                                    GUInt32 *pnVal )
+{
+    GUInt32 nVal = 0;
+    int nShift = 0;
+    while( pabyIn < pabyEnd && nShift < 32 )
+    {
+        GByte byVal = *pabyIn++;
+        nVal |= ((GUInt32)(byVal & 0x7F)) << nShift;
+        if( (byVal & 0x80) == 0 )
+        {
+            *pnVal = nVal;
+            return pabyIn;
+        }
+        nShift += 7;
+    }
+    return NULL;
+}
+
+/************************************************************************/
+/*                        CMEMRLECompress()                             */
+/*                                                                      */
+/*      Byte oriented run length encoding. The stream is a sequence     */
+/*      of :                                                            */
+/*        - 0, varint(n), n literal bytes                               */
+/*        - 1, varint(n), a byte value repeated n times                 */
+/*      Returns the compressed size, or -1 if it does not fit in        */
+/*      nDstCapacity bytes.                                             */
+/************************************************************************/
+
+#define CMEM_RLE_MIN_RUN    4
+
+static int CMEMRLECompress( const GByte *pabySrc, int nSrcSize,
+                            GByte *pabyDst, int nDstCapacity )
+{
+    const GByte *pabySrcEnd = pabySrc + nSrcSize;
+    const GByte *pabyLiteral = pabySrc;
+    const GByte *pabyIn = pabySrc;
+    GByte *pabyOut = pabyDst;
+    GByte *pabyOutEnd = pabyDst + nDstCapacity;
+
+    while( pabyIn < pabySrcEnd )
+    {
+        const GByte *pabyRunEnd = pabyIn + 1;
+        while( pabyRunEnd < pabySrcEnd && *pabyRunEnd == *pabyIn )
+            pabyRunEnd++;
+
+        if( pabyRunEnd - pabyIn < CMEM_RLE_MIN_RUN && pabyRunEnd < pabySrcEnd )
+        {
+            pabyIn = pabyRunEnd;
+            continue;
+        }
+        if( pabyRunEnd - pabyIn < CMEM_RLE_MIN_RUN )
+            pabyIn = pabyRunEnd;
+
+        // Flush pending literals (1 + 5 bytes at most of header).
+        if( pabyIn > pabyLiteral )
+        {
+            const int nLiteral = (int) (pabyIn - pabyLiteral);
+            if( pabyOutEnd - pabyOut < 6 + nLiteral )
+                return -1;
+            *pabyOut++ = 0;
+            pabyOut = CMEMWriteVarInt( pabyOut, nLiteral );
+            memcpy( pabyOut, pabyLiteral, nLiteral );
+            pabyOut += nLiteral;
+        }
+
+        if( pabyIn < pabySrcEnd )
+        {
+            if( pabyOutEnd - pabyOut < 7 )
+                return -1;
+            *pabyOut++ = 1;
+            pabyOut = CMEMWriteVarInt( pabyOut, (GUInt32)(pabyRunEnd - pabyIn) );
+            *pabyOut++ = *pabyIn;
+            pabyIn = pabyRunEnd;
+        }
+        pabyLiteral = pabyIn;
+    }
+
+    return (int) (pabyOut - pabyDst);
+}
+
+/************************************************************************/
+/*                        CMEMRLEDecompress()                           */
+/************************************************************************/
+
+static int CMEMRLEDecompress( const GByte *pabySrc, int nSrcSize,
+                              GByte *pabyDst, int nDstSize )
+{
+    const GByte *pabyIn = pabySrc;
+    const GByte *pabySrcEnd = pabySrc + nSrcSize;
+    GByte *pabyOut = pabyDst;
+    GByte *pabyOutEnd = pabyDst + nDstSize;
+
+    while( pabyIn < pabySrcEnd )
+    {
+        const GByte byOp = *pabyIn++;
+        GUInt32 nCount = 0;
+
+        pabyIn = CMEMReadVarInt( pabyIn, pabySrcEnd, &nCount );
+        if( pabyIn == NULL || nCount > (GUInt32)(pabyOutEnd - pabyOut) )
+            return FALSE;
+
+        if( byOp == 0 )
+        {
+            if( nCount > (GUInt32)(pabySrcEnd - pabyIn) )
+                return FALSE;
+            memcpy( pabyOut, pabyIn, nCount );
+            pabyIn += nCount;
+        }
+        else if( byOp == 1 )
+        {
+            if( pabyIn == pabySrcEnd )
+                return FALSE;
+            memset( pabyOut, *pabyIn, nCount );
+            pabyIn ++;
+        }
+        else
+            return FALSE;
+        pabyOut += nCount;
+    }
+
+    return pabyOut == pabyOutEnd;
+}
+
+/************************************************************************/
+/*                        CMEMLZ4Compress()                             */
+/*                                                                      */
+/*      Greedy compressor producing the LZ4 block format : sequences    */
+/*      of a token (4 bits literal length, 4 bits match length - 4),    */
+/*      extra length bytes, literals, 2 byte little endian offset and   */
+/*      extra match length bytes. The last 5 bytes are always           */
+/*      literals and no match starts in the last 12 bytes.              */
+/*      Returns the compressed size, or -1 if it does not fit in        */
+/*      nDstCapacity bytes.                                             */
+/************************************************************************/
+
+#define CMEM_LZ4_MIN_MATCH      4
+#define CMEM_LZ4_LAST_LITERALS  5
+#define CMEM_LZ4_MF_LIMIT       12
+#define CMEM_LZ4_MAX_OFFSET     65535
+#define CMEM_LZ4_HASH_LOG       13
+
+static inline GUInt32 CMEMRead32( const GByte *pabyData )
+{
+    GUInt32 nVal;
+    memcpy( &nVal, pabyData, 4 );
+    return nVal;
+}
+
+static inline int CMEMLZ4Hash( GUInt32 nSequence )
+{
+    return (int) ((nSequence * 2654435761U) >> (32 - CMEM_LZ4_HASH_LOG));
+}
+
+static GByte *CMEMLZ4WriteLength( GByte *pabyOut, int nLength )
+{
+    while( nLength >= 255 )
+    {
+        *pabyOut++ = 255;
+        nLength -= 255;
+    }
+    *pabyOut++ = (GByte) nLength;
+    return pabyOut;
+}
+
+static int CMEMLZ4Compress( const GByte *pabySrc, int nSrcSize,
+                            GByte *pabyDst, int nDstCapacity )
+{
+    const GByte *pabyIn = pabySrc;
+    const GByte *pabyAnchor = pabySrc;
+    const GByte *pabySrcEnd = pabySrc + nSrcSize;
+    GByte *pabyOut = pabyDst;
+    GByte *pabyOutEnd = pabyDst + nDstCapacity;
+
+    if( nSrcSize > CMEM_LZ4_MF_LIMIT )
+    {
+        const GByte *pabyMatchFindLimit = pabySrcEnd - CMEM_LZ4_MF_LIMIT;
+        const GByte *pabyMatchLimit = pabySrcEnd - CMEM_LZ4_LAST_LITERALS;
+        // Positions + 1 of the last occurrence of each hashed sequence.
+        int anHashTable[1 << CMEM_LZ4_HASH_LOG];
+        memset( anHashTable, 0, sizeof(anHashTable) );
+
+        while( pabyIn < pabyMatchFindLimit )
+        {
+            const GUInt32 nSequence = CMEMRead32( pabyIn );
+            const int nHash = CMEMLZ4Hash( nSequence );
+            const int nRef = anHashTable[nHash];
+            anHashTable[nHash] = (int) (pabyIn - pabySrc) + 1;
+
+            if( nRef == 0 ||
+                (pabyIn - pabySrc) - (nRef - 1) > CMEM_LZ4_MAX_OFFSET ||
+                CMEMRead32( pabySrc + nRef - 1 ) != nSequence )
+            {
+                // Skip faster in incompressible areas.
+                pabyIn += 1 + ((pabyIn - pabyAnchor) >> 6);
+                continue;
+            }
+
+            const GByte *pabyMatch = pabySrc + nRef - 1;
+            const GByte *pabyMatchEnd = pabyIn + CMEM_LZ4_MIN_MATCH;
+            const GByte *pabyRef = pabyMatch + CMEM_LZ4_MIN_MATCH;
+            while( pabyMatchEnd < pabyMatchLimit && *pabyMatchEnd == *pabyRef )
+            {
+                pabyMatchEnd++;
+                pabyRef++;
+            }
+
+            const int nLiteral = (int) (pabyIn - pabyAnchor);
+            const int nMatch = (int) (pabyMatchEnd - pabyIn) - CMEM_LZ4_MIN_MATCH;
+            if( pabyOutEnd - pabyOut <
+                    1 + nLiteral + nLiteral / 255 + 1 + 2 + nMatch / 255 + 1 )
+                return -1;
+
+            GByte *pabyToken = pabyOut++;
+            if( nLiteral >= 15 )
+            {
+                *pabyToken = 15 << 4;
+                pabyOut = CMEMLZ4WriteLength( pabyOut, nLiteral - 15 );
+            }
+            else
+                *pabyToken = (GByte) (nLiteral << 4);
+            memcpy( pabyOut, pabyAnchor, nLiteral );
+            pabyOut += nLiteral;
+
+            const int nOffset = (int) (pabyIn - pabyMatch);
+            *pabyOut++ = (GByte) (nOffset & 0xFF);
+            *pabyOut++ = (GByte) (nOffset >> 8);
+
+            if( nMatch >= 15 )
+            {
+                *pabyToken |= 15;
+                pabyOut = CMEMLZ4WriteLength( pabyOut, nMatch - 15 );
+            }
+            else
+                *pabyToken |= (GByte) nMatch;
+
+            pabyIn = pabyMatchEnd;
+            pabyAnchor = pabyIn;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Last literals.                                                  */
+/* -------------------------------------------------------------------- */
+    const int nLiteral = (int) (pabySrcEnd - pabyAnchor);
+    if( pabyOutEnd - pabyOut < 1 + nLiteral + nLiteral / 255 + 1 )
+        return -1;
+    if( nLiteral >= 15 )
+    {
+        *pabyOut++ = 15 << 4;
+        pabyOut = CMEMLZ4WriteLength( pabyOut, nLiteral - 15 );
+    }
+    else
+        *pabyOut++ = (GByte) (nLiteral << 4);
+    memcpy( pabyOut, pabyAnchor, nLiteral );
+    pabyOut += nLiteral;
+
+    return (int) (pabyOut - pabyDst);
+}
+
+/************************************************************************/
+/*                        CMEMLZ4Decompress()                           */
+/************************************************************************/
+
+static int CMEMLZ4ReadLength( const GByte **ppabyIn, const GByte *pabySrcEnd,
+                              int *pnLength )
+{
+    const GByte *pabyIn = *ppabyIn;
+    GByte byVal;
+    do
+    {
+        if( pabyIn >= pabySrcEnd || *pnLength > INT_MAX - 255 )
+            return FALSE;
+        byVal = *pabyIn++;
+        *pnLength += byVal;
+    } while( byVal == 255 );
+    *ppabyIn = pabyIn;
+    return TRUE;
+}
+
+static int CMEMLZ4Decompress( const GByte *pabySrc, int nSrcSize,
+                              GByte *pabyDst, int nDstSize )
+{
+    const GByte *pabyIn = pabySrc;
+    const GByte *pabySrcEnd = pabySrc + nSrcSize;
+    GByte *pabyOut = pabyDst;
+    GByte *pabyOutEnd = pabyDst + nDstSize;
+
+    while( pabyIn < pabySrcEnd )
+    {
+        const GByte byToken = *pabyIn++;
+
+        int nLiteral = byToken >> 4;
+        if( nLiteral == 15 &&
+            !CMEMLZ4ReadLength( &pabyIn, pabySrcEnd, &nLiteral ) )
+            return FALSE;
+        if( nLiteral > pabySrcEnd - pabyIn || nLiteral > pabyOutEnd - pabyOut )
+            return FALSE;
+        memcpy( pabyOut, pabyIn, nLiteral );
+        pabyIn += nLiteral;
+        pabyOut += nLiteral;
+
+        // The last sequence has no match part.
+        if( pabyIn == pabySrcEnd )
+            break;
+
+        if( pabySrcEnd - pabyIn < 2 )
+            return FALSE;
+        const int nOffset = pabyIn[0] | (pabyIn[1] << 8);
+        pabyIn += 2;
+        if( nOffset == 0 || nOffset > pabyOut - pabyDst )
+            return FALSE;
+
+        int nMatch = byToken & 15;
+        if( nMatch == 15 &&
+            !CMEMLZ4ReadLength( &pabyIn, pabySrcEnd, &nMatch ) )
+            return FALSE;
+        nMatch += CMEM_LZ4_MIN_MATCH;
+        if( nMatch > pabyOutEnd - pabyOut )
+            return FALSE;
+
+        // Matches may overlap their own output, so copy byte per byte.
+        const GByte *pabyMatch = pabyOut - nOffset;
+        for( int i = 0; i < nMatch; i++ )
+            pabyOut[i] = pabyMatch[i];
+        pabyOut += nMatch;
+    }
+
+    return pabyOut == pabyOutEnd;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                              CMEMDataset                             */
+/* ==================================================================== */
+/************************************************************************/
+
+class CMEMRasterBand;
+
+class CMEMDataset : public GDALDataset
+{
+    friend class CMEMRasterBand;
+
+    int         bGeoTransformSet;
+    double      adfGeoTransform[6];
+    CPLString   osProjection;
+
+    int         nCodec;
+    int         bAutoCodec;
+
+  public:
+                 CMEMDataset();
+    virtual     ~CMEMDataset();
+
+    virtual const char *GetProjectionRef(void);
+    virtual CPLErr SetProjection( const char * );
+
+    virtual CPLErr GetGeoTransform( double * );
+    virtual CPLErr SetGeoTransform( double * );
+
+    static GDALDataset *Create( const char * pszFilename,
+                                int nXSize, int nYSize, int nBands,
+                                GDALDataType eType, char ** papszParmList );
+};
+
+/************************************************************************/
+/* ==================================================================== */
+/*                            CMEMRasterBand                            */
+/* ==================================================================== */
+/************************************************************************/
+
+class CMEMRasterBand : public GDALRasterBand
+{
+    friend class CMEMDataset;
+
+    int         nTilesPerRow;
+    int         nTilesPerCol;
+    GByte     **papabyTiles;
+    int        *panTileSize;
+    GByte      *pabyTileElided;
+
+    int         bNoDataSet;
+    double      dfNoData;
+
+    GDALColorTable *poColorTable;
+    GDALColorInterp eColorInterp;
+
+    GByte      *pabyWorkBuffer;
+    GByte      *pabyFillBlock;
+    GByte      *pabyEdgeBlock;
+
+    int         nWordSize;
+    int         nBlockBytes;
+
+    void        FillBlockWithNoData( void *pImage );
+    int         IsFillBlock( const void *pImage );
+    CPLErr      StoreTile( int iTile, const void *pImage );
+
+  public:
+                CMEMRasterBand( CMEMDataset *poDS, int nBand,
+                                GDALDataType eType,
+                                int nBlockXSize, int nBlockYSize );
+    virtual    ~CMEMRasterBand();
+
+    int         Initialize();
+
+    virtual CPLErr IReadBlock( int, int, void * );
+    virtual CPLErr IWriteBlock( int, int, void * );
+
+    virtual double GetNoDataValue( int *pbSuccess = NULL );
+    virtual CPLErr SetNoDataValue( double );
+
+    virtual GDALColorInterp GetColorInterpretation();
+    virtual CPLErr SetColorInterpretation( GDALColorInterp );
+    virtual GDALColorTable *GetColorTable();
+    virtual CPLErr SetColorTable( GDALColorTable * );
+
+    virtual const char *GetMetadataItem( const char * pszName,
+                                         const char * pszDomain = "" );
+
+    GUIntBig    GetCompressedSize();
+};
+
+/************************************************************************/
+/*                           CMEMRasterBand()                           */
+/************************************************************************/
+
+CMEMRasterBand::CMEMRasterBand( CMEMDataset *poDS, int nBand,
+                                GDALDataType eType,
+                                int nBlockXSize, int nBlockYSize )
+
+{
+    this->poDS = poDS;
+    this->nBand = nBand;
+    this->eAccess = GA_Update;
+
+    eDataType = eType;
+    this->nBlockXSize = nBlockXSize;
+    this->nBlockYSize = nBlockYSize;
+
+    nTilesPerRow = (poDS->GetRasterXSize() + nBlockXSize - 1) / nBlockXSize;
+    nTilesPerCol = (poDS->GetRasterYSize() + nBlockYSize - 1) / nBlockYSize;
+    papabyTiles = NULL;
+    panTileSize = NULL;
+    pabyTileElided = NULL;
+
+    bNoDataSet = FALSE;
+    dfNoData = 0.0;
+
+    poColorTable = NULL;
+    eColorInterp = GCI_Undefined;
+
+    pabyWorkBuffer = NULL;
+    pabyFillBlock = NULL;
+    pabyEdgeBlock = NULL;
+
+    nWordSize = GDALGetDataTypeSize( eType ) / 8;
+    nBlockBytes = nWordSize * nBlockXSize * nBlockYSize;
+}
+
+/************************************************************************/
+/*                          ~CMEMRasterBand()                           */
+/************************************************************************/
+
+CMEMRasterBand::~CMEMRasterBand()
+
+{
+    // Dirty blocks must be compressed before the tiles are freed.
+    FlushCache();
+
+    if( papabyTiles != NULL )
+    {
+        for( int i = 0; i < nTilesPerRow * nTilesPerCol; i++ )
+            VSIFree( papabyTiles[i] );
+    }
+    CPLFree( papabyTiles );
+    CPLFree( panTileSize );
+    CPLFree( pabyTileElided );
+    VSIFree( pabyWorkBuffer );
+    VSIFree( pabyFillBlock );
+    VSIFree( pabyEdgeBlock );
+
+    if( poColorTable != NULL )
+        delete poColorTable;
+}
+
+/************************************************************************/
+/*                             Initialize()                             */
+/************************************************************************/
+
+int CMEMRasterBand::Initialize()
+
+{
+    const int nTiles = nTilesPerRow * nTilesPerCol;
+
+    papabyTiles = (GByte **) VSICalloc( nTiles, sizeof(GByte *) );
+    panTileSize = (int *) VSICalloc( nTiles, sizeof(int) );
+    pabyTileElided = (GByte *) VSICalloc( nTiles, 1 );
+    // Work buffer holds a shuffled tile, and then room for the output of
+    // two codecs.
+    pabyWorkBuffer = (GByte *) VSIMalloc( 3 * (size_t)nBlockBytes +
+                                          CMEM_HEADER_SIZE );
+    if( papabyTiles == NULL || panTileSize == NULL ||
+        pabyTileElided == NULL || pabyWorkBuffer == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Unable to allocate tile index ... out of memory." );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        FillBlockWithNoData()                         */
+/************************************************************************/
+
+void CMEMRasterBand::FillBlockWithNoData( void *pImage )
+
+{
+    const double dfFill = bNoDataSet ? dfNoData : 0.0;
+    if( dfFill == 0.0 )
+        memset( pImage, 0, nBlockBytes );
+    else
+        GDALCopyWords( (void *) &dfFill, GDT_Float64, 0,
+                       pImage, eDataType, nWordSize,
+                       nBlockXSize * nBlockYSize );
+}
+
+/************************************************************************/
+/*                            IsFillBlock()                             */
+/*                                                                      */
+/*      Whether a block only contains the nodata value (or 0), and can  */
+/*      be stored as a sparse tile.                                     */
+/************************************************************************/
+
+int CMEMRasterBand::IsFillBlock( const void *pImage )
+
+{
+    if( pabyFillBlock == NULL )
+    {
+        pabyFillBlock = (GByte *) VSIMalloc( nBlockBytes );
+        if( pabyFillBlock == NULL )
+            return FALSE;
+        FillBlockWithNoData( pabyFillBlock );
+    }
+    return memcmp( pImage, pabyFillBlock, nBlockBytes ) == 0;
+}
+
+/************************************************************************/
+/*                             IReadBlock()                             */
+/************************************************************************/
+
+CPLErr CMEMRasterBand::IReadBlock( int nBlockXOff, int nBlockYOff,
+                                   void * pImage )
+
+{
+    const int iTile = nBlockXOff + nBlockYOff * nTilesPerRow;
+    const GByte *pabyTile = papabyTiles[iTile];
+
+    if( pabyTile == NULL )
+    {
+        FillBlockWithNoData( pImage );
+        return CE_None;
+    }
+
+    const int nCodec = pabyTile[0];
+    const int bShuffled = pabyTile[1];
+    const GByte *pabyPayload = pabyTile + CMEM_HEADER_SIZE;
+    const int nPayloadSize = panTileSize[iTile] - CMEM_HEADER_SIZE;
+    GByte *pabyOut = bShuffled ? pabyWorkBuffer : (GByte *) pImage;
+    int bOK;
+
+    if( nCodec == CMEM_CODEC_RLE )
+        bOK = CMEMRLEDecompress( pabyPayload, nPayloadSize,
+                                 pabyOut, nBlockBytes );
+    else if( nCodec == CMEM_CODEC_LZ4 )
+        bOK = CMEMLZ4Decompress( pabyPayload, nPayloadSize,
+                                 pabyOut, nBlockBytes );
+    else
+    {
+        bOK = (nPayloadSize == nBlockBytes);
+        if( bOK )
+            memcpy( pabyOut, pabyPayload, nBlockBytes );
+    }
+
+    if( !bOK )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Corrupted tile %d,%d of band %d.",
+                  nBlockXOff, nBlockYOff, nBand );
+        return CE_Failure;
+    }
+
+    if( bShuffled )
+        CMEMUnshuffleBytes( pabyWorkBuffer, (GByte *) pImage,
+                            nBlockXSize * nBlockYSize, nWordSize );
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                            IWriteBlock()                             */
+/************************************************************************/
+
+CPLErr CMEMRasterBand::IWriteBlock( int nBlockXOff, int nBlockYOff,
+                                    void * pImage )
+
+{
+    const int iTile = nBlockXOff + nBlockYOff * nTilesPerRow;
+
+/* -------------------------------------------------------------------- */
+/*      The part of right and bottom edge blocks that is outside of     */
+/*      the raster may be uninitialized.  Work on a copy of the valid   */
+/*      region padded with the fill value, so that the tile content     */
+/*      is deterministic and all-nodata edge blocks stay sparse.        */
+/* -------------------------------------------------------------------- */
+    const int nXValid = MIN(nBlockXSize, nRasterXSize - nBlockXOff * nBlockXSize);
+    const int nYValid = MIN(nBlockYSize, nRasterYSize - nBlockYOff * nBlockYSize);
+    if( nXValid < nBlockXSize || nYValid < nBlockYSize )
+    {
+        if( pabyEdgeBlock == NULL )
+        {
+            pabyEdgeBlock = (GByte *) VSIMalloc( nBlockBytes );
+            if( pabyEdgeBlock == NULL )
+            {
+                CPLError( CE_Failure, CPLE_OutOfMemory,
+                          "Unable to allocate edge block ... out of memory." );
+                return CE_Failure;
+            }
+        }
+        FillBlockWithNoData( pabyEdgeBlock );
+        const int nLineBytes = nBlockXSize * nWordSize;
+        for( int iLine = 0; iLine < nYValid; iLine++ )
+            memcpy( pabyEdgeBlock + iLine * nLineBytes,
+                    (GByte *) pImage + iLine * nLineBytes,
+                    nXValid * nWordSize );
+        pImage = pabyEdgeBlock;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Blocks made only of the fill value are not stored at all.       */
+/* -------------------------------------------------------------------- */
+    if( IsFillBlock( pImage ) )
+    {
+        VSIFree( papabyTiles[iTile] );
+        papabyTiles[iTile] = NULL;
+        panTileSize[iTile] = 0;
+        pabyTileElided[iTile] = TRUE;
+        return CE_None;
+    }
+
+    pabyTileElided[iTile] = FALSE;
+    return StoreTile( iTile, pImage );
+}
+
+/************************************************************************/
+/*                             StoreTile()                              */
+/*                                                                      */
+/*      Compress a block and store it as the given tile.                */
+/************************************************************************/
+
+CPLErr CMEMRasterBand::StoreTile( int iTile, const void *pImage )
+
+{
+    CMEMDataset *poGDS = (CMEMDataset *) poDS;
+
+    VSIFree( papabyTiles[iTile] );
+    papabyTiles[iTile] = NULL;
+    panTileSize[iTile] = 0;
+
+/* -------------------------------------------------------------------- */
+/*      Shuffle bytes of multi-byte data types.                         */
+/* -------------------------------------------------------------------- */
+    const GByte *pabySrc = (const GByte *) pImage;
+    const int bShuffled = (nWordSize > 1 && poGDS->nCodec != CMEM_CODEC_NONE);
+    if( bShuffled )
+    {
+        CMEMShuffleBytes( pabySrc, pabyWorkBuffer,
+                          nBlockXSize * nBlockYSize, nWordSize );
+        pabySrc = pabyWorkBuffer;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Compress after the shuffled data in the work buffer, keeping    */
+/*      the smallest result. Data that does not compress is stored raw. */
+/* -------------------------------------------------------------------- */
+    GByte *pabyCompressed = pabyWorkBuffer + nBlockBytes + CMEM_HEADER_SIZE;
+    int nCodec = CMEM_CODEC_NONE;
+    int nCompressedSize = nBlockBytes;
+
+    if( poGDS->bAutoCodec || poGDS->nCodec == CMEM_CODEC_RLE )
+    {
+        int nSize = CMEMRLECompress( pabySrc, nBlockBytes,
+                                     pabyCompressed, nCompressedSize - 1 );
+        if( nSize >= 0 )
+        {
+            nCodec = CMEM_CODEC_RLE;
+            nCompressedSize = nSize;
+        }
+    }
+
+    // In AUTO mode, a tile that RLE already shrinks 16 times (masks, mostly
+    // constant tiles) is not worth trying LZ4 on.
+    if( poGDS->bAutoCodec ? nCompressedSize > nBlockBytes / 16 :
+                            poGDS->nCodec == CMEM_CODEC_LZ4 )
+    {
+        GByte *pabyLZ4 = pabyCompressed;
+        if( nCodec == CMEM_CODEC_RLE )
+        {
+            // Keep the RLE result and compress after it.
+            pabyLZ4 = pabyCompressed + nBlockBytes;
+        }
+        int nSize = CMEMLZ4Compress( pabySrc, nBlockBytes,
+                                     pabyLZ4, nCompressedSize - 1 );
+        if( nSize >= 0 )
+        {
+            if( pabyLZ4 != pabyCompressed )
+                memmove( pabyCompressed, pabyLZ4, nSize );
+            nCodec = CMEM_CODEC_LZ4;
+            nCompressedSize = nSize;
+        }
+    }
+
+    if( nCodec == CMEM_CODEC_NONE )
+    {
+        pabySrc = (const GByte *) pImage;
+        pabyCompressed = (GByte *) pabySrc;
+    }
+
+    GByte *pabyTile = (GByte *) VSIMalloc( nCompressedSize + CMEM_HEADER_SIZE );
+    if( pabyTile == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Unable to store tile %d,%d of band %d ... out of memory.",
+                  iTile % nTilesPerRow, iTile / nTilesPerRow, nBand );
+        return CE_Failure;
+    }
+    pabyTile[0] = (GByte) nCodec;
+    pabyTile[1] = (GByte) (nCodec != CMEM_CODEC_NONE && bShuffled);
+    memcpy( pabyTile + CMEM_HEADER_SIZE, pabyCompressed, nCompressedSize );
+
+    papabyTiles[iTile] = pabyTile;
+    panTileSize[iTile] = nCompressedSize + CMEM_HEADER_SIZE;
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                         GetCompressedSize()                          */
+/************************************************************************/
+
+GUIntBig CMEMRasterBand::GetCompressedSize()
+
+{
+    GUIntBig nSize = 0;
+    for( int i = 0; i < nTilesPerRow * nTilesPerCol; i++ )
+        nSize += panTileSize[i];
+    return nSize;
+}
+
+/************************************************************************/
+/*                          GetMetadataItem()                           */
+/************************************************************************/
+
+const char *CMEMRasterBand::GetMetadataItem( const char * pszName,
+                                             const char * pszDomain )
+
+{
+    // Size of the compressed tiles, not counting blocks that are only
+    // in the block cache.
+    if( pszName != NULL && pszDomain != NULL &&
+        EQUAL(pszDomain, "IMAGE_STRUCTURE") &&
+        EQUAL(pszName, "COMPRESSED_SIZE") )
+    {
+        return CPLSPrintf( CPL_FRMT_GUIB, GetCompressedSize() );
+    }
+
+    return GDALRasterBand::GetMetadataItem( pszName, pszDomain );
+}
+
+/************************************************************************/
+/*                            GetNoDataValue()                          */
+/************************************************************************/
+
+double CMEMRasterBand::GetNoDataValue( int *pbSuccess )
+
+{
+    if( pbSuccess )
+        *pbSuccess = bNoDataSet;
+
+    if( bNoDataSet )
+        return dfNoData;
+    else
+        return 0.0;
+}
+
+/************************************************************************/
+/*                            SetNoDataValue()                          */
+/*                                                                      */
+/*                                                                      */
+/*      Note that tiles never written are read as the current nodata    */
+/*      value.                                                          */
+/************************************************************************/
+
+CPLErr CMEMRasterBand::SetNoDataValue( double dfNewValue )
+
+{
+    // Cached blocks of absent tiles hold the previous fill value.
+    FlushCache();
+
+    const int bOldNoDataSet = bNoDataSet;
+    const double dfOldNoData = dfNoData;
+    GByte *pabyOldFillBlock = pabyFillBlock;
+
+    dfNoData = dfNewValue;
+    bNoDataSet = TRUE;
+    pabyFillBlock = NULL;
+
+/* -------------------------------------------------------------------- */
+/*      Tiles that were written with only the previous fill value, and  */
+/*      thus not stored, must keep reading as that value: store them    */
+/*      for real if the fill value changes.                             */
+/* -------------------------------------------------------------------- */
+    if( pabyOldFillBlock != NULL && !IsFillBlock( pabyOldFillBlock ) )
+    {
+        for( int i = 0; i < nTilesPerRow * nTilesPerCol; i++ )
+        {
+            if( !pabyTileElided[i] )
+                continue;
+            if( StoreTile( i, pabyOldFillBlock ) != CE_None )
+            {
+                // Tiles already stored hold the right values anyway.
+                VSIFree( pabyFillBlock );
+                pabyFillBlock = pabyOldFillBlock;
+                dfNoData = dfOldNoData;
+                bNoDataSet = bOldNoDataSet;
+                return CE_Failure;
+            }
+            pabyTileElided[i] = FALSE;
+        }
+    }
+    VSIFree( pabyOldFillBlock );
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                       GetColorInterpretation()                       */
+/************************************************************************/
+
+GDALColorInterp CMEMRasterBand::GetColorInterpretation()
+
+{
+    if( poColorTable != NULL )
+        return GCI_PaletteIndex;
+    else
+        return eColorInterp;
+}
+
+/************************************************************************/
+/*                       SetColorInterpretation()                       */
+/************************************************************************/
+
+CPLErr CMEMRasterBand::SetColorInterpretation( GDALColorInterp eGCI )
+
+{
+    eColorInterp = eGCI;
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                           GetColorTable()                            */
+/************************************************************************/
+
+GDALColorTable *CMEMRasterBand::GetColorTable()
+
+{
+    return poColorTable;
+}
+
+/************************************************************************/
+/*                           SetColorTable()                            */
+/************************************************************************/
+
+CPLErr CMEMRasterBand::SetColorTable( GDALColorTable *poCT )
+
+{
+    if( poColorTable != NULL )
+        delete poColorTable;
+
+    if( poCT == NULL )
+        poColorTable = NULL;
+    else
+        poColorTable = poCT->Clone();
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                            CMEMDataset()                             */
+/************************************************************************/
+
+CMEMDataset::CMEMDataset()
+
+{
+    bGeoTransformSet = FALSE;
+    adfGeoTransform[0] = 0.0;
+    adfGeoTransform[1] = 1.0;
+    adfGeoTransform[2] = 0.0;
+    adfGeoTransform[3] = 0.0;
+    adfGeoTransform[4] = 0.0;
+    adfGeoTransform[5] = -1.0;
+
+    nCodec = CMEM_CODEC_LZ4;
+    bAutoCodec = TRUE;
+}
+
+/************************************************************************/
+/*                            ~CMEMDataset()                            */
+/************************************************************************/
+
+CMEMDataset::~CMEMDataset()
+
+{
+    FlushCache();
+}
+
+/************************************************************************/
+/*                          GetProjectionRef()                          */
+/************************************************************************/
+
+const char *CMEMDataset::GetProjectionRef()
+
+{
+    return osProjection.c_str();
+}
+
+/************************************************************************/
+/*                           SetProjection()                            */
+/************************************************************************/
+
+CPLErr CMEMDataset::SetProjection( const char *pszProjectionIn )
+
+{
+    osProjection = pszProjectionIn ? pszProjectionIn : "";
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                          GetGeoTransform()                           */
+/************************************************************************/
+
+CPLErr CMEMDataset::GetGeoTransform( double *padfGeoTransform )
+
+{
+    memcpy( padfGeoTransform, adfGeoTransform, sizeof(double) * 6 );
+    if( bGeoTransformSet )
+        return CE_None;
+    else
+        return CE_Failure;
+}
+
+/************************************************************************/
+/*                          SetGeoTransform()                           */
+/************************************************************************/
+
+CPLErr CMEMDataset::SetGeoTransform( double *padfGeoTransform )
+
+{
+    memcpy( adfGeoTransform, padfGeoTransform, sizeof(double) * 6 );
+    bGeoTransformSet = TRUE;
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                               Create()                               */
+/************************************************************************/
+
+GDALDataset *CMEMDataset::Create( CPL_UNUSED const char * pszFilename,
+                                  int nXSize, int nYSize, int nBands,
+                                  GDALDataType eType,
+                                  char **papszOptions )
+
+{
+    int nBlockXSize = atoi(CSLFetchNameValueDef( papszOptions,
+                                                 "BLOCKXSIZE", "256" ));
+    int nBlockYSize = atoi(CSLFetchNameValueDef( papszOptions,
+                                                 "BLOCKYSIZE", "256" ));
+    nBlockXSize = MAX(1, MIN(nBlockXSize, nXSize));
+    nBlockYSize = MAX(1, MIN(nBlockYSize, nYSize));
+
+    if( (GIntBig)nBlockXSize * nBlockYSize * (GDALGetDataTypeSize(eType) / 8)
+                                                            > INT_MAX / 4 )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "Too large block size : %d x %d.",
+                  nBlockXSize, nBlockYSize );
+        return NULL;
+    }
+
+    const char *pszCompress = CSLFetchNameValueDef( papszOptions,
+                                                    "COMPRESS", "AUTO" );
+    int nCodec = CMEM_CODEC_LZ4;
+    int bAutoCodec = FALSE;
+    if( EQUAL(pszCompress, "AUTO") )
+        bAutoCodec = TRUE;
+    else if( EQUAL(pszCompress, "RLE") )
+        nCodec = CMEM_CODEC_RLE;
+    else if( EQUAL(pszCompress, "NONE") )
+        nCodec = CMEM_CODEC_NONE;
+    else if( !EQUAL(pszCompress, "LZ4") )
+    {
+        CPLError( CE_Warning, CPLE_NotSupported,
+                  "COMPRESS=%s not supported. Using AUTO.", pszCompress );
+        bAutoCodec = TRUE;
+    }
+
+    CMEMDataset *poDS = new CMEMDataset();
+
+    poDS->nRasterXSize = nXSize;
+    poDS->nRasterYSize = nYSize;
+    poDS->eAccess = GA_Update;
+    poDS->nCodec = nCodec;
+    poDS->bAutoCodec = bAutoCodec;
+
+    poDS->SetMetadataItem( "COMPRESSION", bAutoCodec ? "AUTO" :
+                           nCodec == CMEM_CODEC_RLE ? "RLE" :
+                           nCodec == CMEM_CODEC_LZ4 ? "LZ4" : "NONE",
+                           "IMAGE_STRUCTURE" );
+
+    for( int iBand = 0; iBand < nBands; iBand++ )
+    {
+        CMEMRasterBand *poBand = new CMEMRasterBand( poDS, iBand+1, eType,
+                                                     nBlockXSize, nBlockYSize );
+        poDS->SetBand( iBand+1, poBand );
+        if( !poBand->Initialize() )
+        {
+            delete poDS;
+            return NULL;
+        }
+    }
+
+    return poDS;
+}
+
+/************************************************************************/
+/*                        CMEMDatasetDelete()                           */
+/************************************************************************/
+
+static CPLErr CMEMDatasetDelete( CPL_UNUSED const char* fileName )
+{
+    /* Null implementation, so that people can Delete("") */
+    return CE_None;
+}
+
+/************************************************************************/
+/*                         GDALRegister_CMEM()                          */
+/************************************************************************/
+
+void GDALRegister_CMEM()
+
+{
+    GDALDriver  *poDriver;
+
+    if( GDALGetDriverByName( "CMEM" ) == NULL )
+    {
+        poDriver = new GDALDriver();
+
+        poDriver->SetDescription( "CMEM" );
+        poDriver->SetMetadataItem( GDAL_DCAP_RASTER, "YES" );
+        poDriver->SetMetadataItem( GDAL_DMD_LONGNAME,
+                                   "Compressed In Memory Raster" );
+        poDriver->SetMetadataItem( GDAL_DMD_HELPTOPIC,
+                                   "frmt_cmem.html" );
+        poDriver->SetMetadataItem( GDAL_DMD_CREATIONDATATYPES,
+                                   "Byte Int16 UInt16 Int32 UInt32 Float32 Float64 CInt16 CInt32 CFloat32 CFloat64" );
+
+        poDriver->SetMetadataItem( GDAL_DMD_CREATIONOPTIONLIST,
+"<CreationOptionList>"
+"   <Option name='BLOCKXSIZE' type='int' default='256' description='Tile width'/>"
+"   <Option name='BLOCKYSIZE' type='int' default='256' description='Tile height'/>"
+"   <Option name='COMPRESS' type='string-select' default='AUTO'>"
+"       <Value>AUTO</Value>"
+"       <Value>LZ4</Value>"
+"       <Value>RLE</Value>"
+"       <Value>NONE</Value>"
+"   </Option>"
+"</CreationOptionList>" );
+
+        poDriver->pfnCreate = CMEMDataset::Create;
+        poDriver->pfnDelete = CMEMDatasetDelete;
+
+        GetGDALDriverManager()->RegisterDriver( poDriver );
+    }
+}
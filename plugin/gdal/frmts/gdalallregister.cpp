@@ -144,6 +144,10 @@ void CPL_STDCALL GDALAllRegister()
     GDALRegister_MEM();
 #endif
 
+#ifdef FRMT_cmem
+    GDALRegister_CMEM();
+#endif
+
 #ifdef FRMT_jdem
     GDALRegister_JDEM();
 #endif
@@ -107,7 +107,7 @@ class subfile_source : public kdu_compressed_source {
 
           if ( bCached )
           {
-              file = (VSILFILE*)VSICreateCachedFile( (VSIVirtualHandle*)file, IO_CHUNK_SIZE, IO_BUFFER_SIZE );
+              file = (VSILFILE*)VSICreateCachedFile( (VSIVirtualHandle*)file, real_filename, IO_CHUNK_SIZE, IO_BUFFER_SIZE );
               if( file == NULL )
               {
                   kdu_error e;
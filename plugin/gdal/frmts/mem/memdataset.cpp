@@ -30,9 +30,204 @@
 
 #include "memdataset.h"
 #include "cpl_string.h"
+#include "cpl_multiproc.h"
+#include "cpl_atomic_ops.h"
+#include <map>
 
 CPL_CVSID("$Id: memdataset.cpp 28899 2015-04-14 09:27:00Z rouault $");
 
+/************************************************************************/
+/* ==================================================================== */
+/*      MEM buffer pool                                                 */
+/*                                                                      */
+/*      Band buffers released by MEM datasets are kept in a process     */
+/*      wide pool, up to GDAL_MEM_POOL_MAX_SIZE megabytes, so that      */
+/*      scratch datasets of the same size created over and over again   */
+/*      reuse already faulted-in memory instead of going through the    */
+/*      system allocator each time.                                     */
+/* ==================================================================== */
+/************************************************************************/
+
+static CPLMutex        *hMEMPoolMutex = NULL;
+static std::multimap<size_t, GByte*> *poMEMPool = NULL;
+static GUIntBig         nMEMPoolBytes = 0;
+
+/* Set when the driver is registered, and cleared by GDALMEMPoolCleanup() */
+/* so that buffers released afterwards are freed instead of recreating   */
+/* the pool.                                                             */
+static int              bMEMPoolEnabled = FALSE;
+
+/************************************************************************/
+/*                          MEMPoolGetMaxSize()                         */
+/************************************************************************/
+
+static GUIntBig MEMPoolGetMaxSize()
+{
+    return (GUIntBig)atoi(CPLGetConfigOption("GDAL_MEM_POOL_MAX_SIZE", "64"))
+                                                                * 1024 * 1024;
+}
+
+/************************************************************************/
+/*                            MEMPoolAlloc()                            */
+/*                                                                      */
+/*      Returns a buffer of at least nSize bytes, and its real size in  */
+/*      *pnCapacity. Pooled buffers up to 25% larger than requested     */
+/*      may be returned.                                                */
+/************************************************************************/
+
+static GByte *MEMPoolAlloc( size_t nSize, size_t *pnCapacity, int bZero )
+{
+    GByte *pabyData = NULL;
+
+    if( bMEMPoolEnabled )
+    {
+        CPLMutexHolderD( &hMEMPoolMutex );
+        if( poMEMPool != NULL )
+        {
+            std::multimap<size_t, GByte*>::iterator oIter =
+                poMEMPool->lower_bound( nSize );
+            if( oIter != poMEMPool->end() && oIter->first - nSize <= nSize / 4 )
+            {
+                pabyData = oIter->second;
+                *pnCapacity = oIter->first;
+                nMEMPoolBytes -= oIter->first;
+                poMEMPool->erase( oIter );
+            }
+        }
+    }
+
+    if( pabyData != NULL )
+    {
+        if( bZero )
+            memset( pabyData, 0, nSize );
+        return pabyData;
+    }
+
+    *pnCapacity = nSize;
+    if( bZero )
+        return (GByte *) VSICalloc( 1, MAX(nSize, 1) );
+    return (GByte *) VSIMalloc( MAX(nSize, 1) );
+}
+
+/************************************************************************/
+/*                            MEMPoolFree()                             */
+/************************************************************************/
+
+static void MEMPoolFree( GByte *pabyData, size_t nCapacity )
+{
+    if( pabyData == NULL )
+        return;
+
+    if( bMEMPoolEnabled )
+    {
+        CPLMutexHolderD( &hMEMPoolMutex );
+        if( nMEMPoolBytes + nCapacity <= MEMPoolGetMaxSize() )
+        {
+            if( poMEMPool == NULL )
+                poMEMPool = new std::multimap<size_t, GByte*>();
+            poMEMPool->insert( std::pair<const size_t, GByte*>( nCapacity,
+                                                                pabyData ) );
+            nMEMPoolBytes += nCapacity;
+            return;
+        }
+    }
+
+    VSIFree( pabyData );
+}
+
+/************************************************************************/
+/*                         GDALMEMPoolCleanup()                         */
+/*                                                                      */
+/*      Called by the driver manager once all the datasets have been    */
+/*      closed. Not used as the unload function of the driver, since    */
+/*      MEM datasets can be destroyed after the driver.                 */
+/************************************************************************/
+
+void GDALMEMPoolCleanup()
+{
+    bMEMPoolEnabled = FALSE;
+
+    if( hMEMPoolMutex == NULL )
+        return;
+
+    {
+        CPLMutexHolderD( &hMEMPoolMutex );
+        if( poMEMPool != NULL )
+        {
+            std::multimap<size_t, GByte*>::iterator oIter;
+            for( oIter = poMEMPool->begin(); oIter != poMEMPool->end(); ++oIter )
+                VSIFree( oIter->second );
+            delete poMEMPool;
+            poMEMPool = NULL;
+        }
+        nMEMPoolBytes = 0;
+    }
+
+    CPLDestroyMutex( hMEMPoolMutex );
+    hMEMPoolMutex = NULL;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*      MEMSharedBuffer                                                 */
+/*                                                                      */
+/*      Reference counted band buffer. It is shared between a MEM       */
+/*      dataset and the clones made with CreateCopy(), until one of     */
+/*      them writes into it, in which case the writer gets its own      */
+/*      copy (see MEMDataset::MakeSharedBufferWritable()).              */
+/* ==================================================================== */
+/************************************************************************/
+
+class MEMSharedBuffer
+{
+  public:
+    GByte         *pabyData;
+    size_t         nSize;
+    size_t         nCapacity;
+    volatile int   nRefCount;
+
+    /* Set once a pointer to the buffer has been given out by GetData(), */
+    /* after which it can be written at any time and cannot be shared.   */
+    volatile int   bExposed;
+
+    static MEMSharedBuffer *Create( size_t nSize, int bZero );
+    void                    Release();
+    int                     GetRefCount() { return CPLAtomicAdd( &nRefCount, 0 ); }
+};
+
+/************************************************************************/
+/*                      MEMSharedBuffer::Create()                       */
+/************************************************************************/
+
+MEMSharedBuffer *MEMSharedBuffer::Create( size_t nSize, int bZero )
+{
+    size_t nCapacity = 0;
+    GByte *pabyData = MEMPoolAlloc( nSize, &nCapacity, bZero );
+    if( pabyData == NULL )
+        return NULL;
+
+    MEMSharedBuffer *poBuffer = new MEMSharedBuffer();
+    poBuffer->pabyData = pabyData;
+    poBuffer->nSize = nSize;
+    poBuffer->nCapacity = nCapacity;
+    poBuffer->nRefCount = 1;
+    poBuffer->bExposed = FALSE;
+    return poBuffer;
+}
+
+/************************************************************************/
+/*                      MEMSharedBuffer::Release()                      */
+/************************************************************************/
+
+void MEMSharedBuffer::Release()
+{
+    if( CPLAtomicDec( &nRefCount ) == 0 )
+    {
+        MEMPoolFree( pabyData, nCapacity );
+        delete this;
+    }
+}
+
 /************************************************************************/
 /*                        MEMCreateRasterBand()                         */
 /************************************************************************/
@@ -81,6 +276,7 @@ MEMRasterBand::MEMRasterBand( GDALDataset *poDS, int nBand,
     bOwnData = bAssumeOwnership;
 
     pabyData = pabyDataIn;
+    poSharedBuffer = NULL;
 
     bNoDataSet  = FALSE;
 
@@ -123,6 +319,37 @@ MEMRasterBand::~MEMRasterBand()
 }
 
 
+/************************************************************************/
+/*                            MakeWritable()                            */
+/************************************************************************/
+
+CPLErr MEMRasterBand::MakeWritable()
+
+{
+    // Only bands whose buffer has been allocated by a MEMDataset can share
+    // it with clones.
+    if( poSharedBuffer == NULL || poSharedBuffer->GetRefCount() == 1 )
+        return CE_None;
+
+    return ((MEMDataset *) poDS)->MakeSharedBufferWritable( poSharedBuffer );
+}
+
+/************************************************************************/
+/*                              GetData()                               */
+/************************************************************************/
+
+GByte *MEMRasterBand::GetData()
+
+{
+    // The caller may write into the buffer whenever it wants, so the buffer
+    // is unshared first, and never shared again.
+    if( MakeWritable() != CE_None )
+        return NULL;
+    if( poSharedBuffer != NULL )
+        poSharedBuffer->bExposed = TRUE;
+    return pabyData;
+}
+
 /************************************************************************/
 /*                             IReadBlock()                             */
 /************************************************************************/
@@ -166,6 +393,9 @@ CPLErr MEMRasterBand::IWriteBlock( CPL_UNUSED int nBlockXOff,
     int     nWordSize = GDALGetDataTypeSize( eDataType ) / 8;
     CPLAssert( nBlockXOff == 0 );
 
+    if( MakeWritable() != CE_None )
+        return CE_Failure;
+
     if( nPixelOffset == nWordSize )
     {
         memcpy( pabyData+nLineOffset*(size_t)nBlockYOff, 
@@ -226,6 +456,9 @@ CPLErr MEMRasterBand::IRasterIO( GDALRWFlag eRWFlag,
     }
     else
     {
+        if( MakeWritable() != CE_None )
+            return CE_Failure;
+
         for(int iLine=0;iLine<nYSize;iLine++)
         {
             GDALCopyWords( ((GByte*)pData) + nLineSpaceBuf*(size_t)iLine,
@@ -268,6 +501,19 @@ CPLErr MEMDataset::IRasterIO( GDALRWFlag eRWFlag,
         GSpacing nLineOffset = 0;
         int eDTSize = 0;
         int iBandIndex;
+
+        /* Unshare buffers first, as this may change the band pointers */
+        if( eRWFlag == GF_Write )
+        {
+            for( iBandIndex = 0; iBandIndex < nBandCount; iBandIndex++ )
+            {
+                MEMRasterBand *poBand =
+                    (MEMRasterBand*) GetRasterBand(panBandMap[iBandIndex]);
+                if( poBand != NULL && poBand->MakeWritable() != CE_None )
+                    return CE_Failure;
+            }
+        }
+
         for( iBandIndex = 0; iBandIndex < nBandCount; iBandIndex++ )
         {
             if( panBandMap[iBandIndex] != iBandIndex + 1 )
@@ -667,6 +913,9 @@ MEMDataset::~MEMDataset()
     FlushCache();
     CPLFree( pszProjection );
 
+    for( size_t i = 0; i < apoSharedBuffers.size(); i++ )
+        apoSharedBuffers[i]->Release();
+
     GDALDeinitGCPs( nGCPCount, pasGCPs );
     CPLFree( pasGCPs );
 }
@@ -805,6 +1054,52 @@ CPLErr MEMDataset::SetGCPs( int nNewCount, const GDAL_GCP *pasNewGCPList,
     return CE_None;
 }
 
+/************************************************************************/
+/*                      MakeSharedBufferWritable()                      */
+/*                                                                      */
+/*      Called before writing into a buffer. If the buffer is still     */
+/*      shared with another dataset, give this dataset its own copy     */
+/*      and repoint all the bands using it.                             */
+/************************************************************************/
+
+CPLErr MEMDataset::MakeSharedBufferWritable( MEMSharedBuffer *poBuffer )
+
+{
+    if( poBuffer->GetRefCount() == 1 )
+        return CE_None;
+
+    MEMSharedBuffer *poNewBuffer = MEMSharedBuffer::Create( poBuffer->nSize,
+                                                            FALSE );
+    if( poNewBuffer == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Unable to unshare band array ... out of memory." );
+        return CE_Failure;
+    }
+    memcpy( poNewBuffer->pabyData, poBuffer->pabyData, poBuffer->nSize );
+
+    for( int iBand = 0; iBand < nBands; iBand++ )
+    {
+        MEMRasterBand *poBand = (MEMRasterBand *) papoBands[iBand];
+        if( poBand->poSharedBuffer == poBuffer )
+        {
+            poBand->pabyData = poNewBuffer->pabyData +
+                                    (poBand->pabyData - poBuffer->pabyData);
+            poBand->poSharedBuffer = poNewBuffer;
+        }
+    }
+
+    for( size_t i = 0; i < apoSharedBuffers.size(); i++ )
+    {
+        if( apoSharedBuffers[i] == poBuffer )
+            apoSharedBuffers[i] = poNewBuffer;
+    }
+
+    poBuffer->Release();
+
+    return CE_None;
+}
+
 /************************************************************************/
 /*                              AddBand()                               */
 /*                                                                      */
@@ -826,20 +1121,23 @@ CPLErr MEMDataset::AddBand( GDALDataType eType, char **papszOptions )
 /* -------------------------------------------------------------------- */
     if( CSLFetchNameValue( papszOptions, "DATAPOINTER" ) == NULL )
     {
+        MEMSharedBuffer *poBuffer = MEMSharedBuffer::Create(
+            (size_t)nPixelSize * GetRasterXSize() * GetRasterYSize(), TRUE );
 
-        pData = (GByte *) 
-            VSICalloc(nPixelSize * GetRasterXSize(), GetRasterYSize() );
-
-        if( pData == NULL )
+        if( poBuffer == NULL )
         {
             CPLError( CE_Failure, CPLE_OutOfMemory,
                       "Unable to create band arrays ... out of memory." );
             return CE_Failure;
         }
+        apoSharedBuffers.push_back( poBuffer );
 
-        SetBand( nBandId,
-                 new MEMRasterBand( this, nBandId, pData, eType, nPixelSize, 
-                                    nPixelSize * GetRasterXSize(), TRUE ) );
+        MEMRasterBand *poNewBand =
+            new MEMRasterBand( this, nBandId, poBuffer->pabyData, eType,
+                               nPixelSize, nPixelSize * GetRasterXSize(),
+                               FALSE );
+        poNewBand->poSharedBuffer = poBuffer;
+        SetBand( nBandId, poNewBand );
 
         return CE_None;
     }
@@ -1048,6 +1346,7 @@ GDALDataset *MEMDataset::Create( CPL_UNUSED const char * pszFilename,
 /*      First allocate band data, verifying that we can get enough      */
 /*      memory.                                                         */
 /* -------------------------------------------------------------------- */
+    std::vector<MEMSharedBuffer*> apoBuffers;
     std::vector<GByte*> apbyBandData;
     int   	iBand;
     int         nWordSize = GDALGetDataTypeSize(eType) / 8;
@@ -1067,38 +1366,37 @@ GDALDataset *MEMDataset::Create( CPL_UNUSED const char * pszFilename,
 
     if( bPixelInterleaved )
     {
-        apbyBandData.push_back( 
-            (GByte *) VSICalloc( 1, nGlobalSize ) );
+        MEMSharedBuffer *poBuffer = MEMSharedBuffer::Create( nGlobalSize, TRUE );
 
-        if( apbyBandData[0] == NULL )
+        if( poBuffer == NULL )
             bAllocOK = FALSE;
         else
         {
-            for( iBand = 1; iBand < nBands; iBand++ )
-                apbyBandData.push_back( apbyBandData[0] + iBand * nWordSize );
+            apoBuffers.push_back( poBuffer );
+            for( iBand = 0; iBand < nBands; iBand++ )
+                apbyBandData.push_back( poBuffer->pabyData + iBand * nWordSize );
         }
     }
     else
     {
         for( iBand = 0; iBand < nBands; iBand++ )
         {
-            apbyBandData.push_back( 
-                (GByte *) VSICalloc( 1, ((size_t)nWordSize) * nXSize * nYSize ) );
-            if( apbyBandData[iBand] == NULL )
+            MEMSharedBuffer *poBuffer = MEMSharedBuffer::Create(
+                ((size_t)nWordSize) * nXSize * nYSize, TRUE );
+            if( poBuffer == NULL )
             {
                 bAllocOK = FALSE;
                 break;
             }
+            apoBuffers.push_back( poBuffer );
+            apbyBandData.push_back( poBuffer->pabyData );
         }
     }
 
     if( !bAllocOK )
     {
-        for( iBand = 0; iBand < (int) apbyBandData.size(); iBand++ )
-        {
-            if( apbyBandData[iBand] )
-                VSIFree( apbyBandData[iBand] );
-        }
+        for( iBand = 0; iBand < (int) apoBuffers.size(); iBand++ )
+            apoBuffers[iBand]->Release();
         CPLError( CE_Failure, CPLE_OutOfMemory,
                     "Unable to create band arrays ... out of memory." );
         return NULL;
@@ -1114,6 +1412,7 @@ GDALDataset *MEMDataset::Create( CPL_UNUSED const char * pszFilename,
     poDS->nRasterXSize = nXSize;
     poDS->nRasterYSize = nYSize;
     poDS->eAccess = GA_Update;
+    poDS->apoSharedBuffers = apoBuffers;
 
     const char *pszPixelType = CSLFetchNameValue( papszOptions, "PIXELTYPE" );
     if( pszPixelType && EQUAL(pszPixelType,"SIGNEDBYTE") )
@@ -1130,12 +1429,18 @@ GDALDataset *MEMDataset::Create( CPL_UNUSED const char * pszFilename,
         MEMRasterBand *poNewBand;
 
         if( bPixelInterleaved )
+        {
             poNewBand = new MEMRasterBand( poDS, iBand+1, apbyBandData[iBand],
                                            eType, nWordSize * nBands, 0, 
-                                           iBand == 0 );
+                                           FALSE );
+            poNewBand->poSharedBuffer = apoBuffers[0];
+        }
         else
+        {
             poNewBand = new MEMRasterBand( poDS, iBand+1, apbyBandData[iBand],
-                                           eType, 0, 0, TRUE );
+                                           eType, 0, 0, FALSE );
+            poNewBand->poSharedBuffer = apoBuffers[iBand];
+        }
 
         poDS->SetBand( iBand+1, poNewBand );
     }
@@ -1146,6 +1451,175 @@ GDALDataset *MEMDataset::Create( CPL_UNUSED const char * pszFilename,
     return poDS;
 }
 
+/************************************************************************/
+/*                        CloneSharingBuffers()                         */
+/*                                                                      */
+/*      Create a copy of a MEM dataset whose bands reference the same   */
+/*      buffers as the source. Returns NULL if some bands do not use    */
+/*      buffers allocated by the driver.                                */
+/************************************************************************/
+
+MEMDataset *MEMDataset::CloneSharingBuffers( MEMDataset *poSrcDS )
+
+{
+    int iBand;
+
+    for( iBand = 0; iBand < poSrcDS->nBands; iBand++ )
+    {
+        if( ((MEMRasterBand *) poSrcDS->papoBands[iBand])->poSharedBuffer == NULL )
+            return NULL;
+    }
+
+    // Make sure that pending writes are in the buffers.
+    poSrcDS->FlushCache();
+
+    MEMDataset *poDS = new MEMDataset();
+
+    poDS->nRasterXSize = poSrcDS->nRasterXSize;
+    poDS->nRasterYSize = poSrcDS->nRasterYSize;
+    poDS->eAccess = GA_Update;
+
+    // Buffers whose address has been given out are copied rather than
+    // shared, since writes through that address cannot be detected.
+    for( size_t i = 0; i < poSrcDS->apoSharedBuffers.size(); i++ )
+    {
+        MEMSharedBuffer *poBuffer = poSrcDS->apoSharedBuffers[i];
+        if( poBuffer->bExposed )
+        {
+            MEMSharedBuffer *poCopy = MEMSharedBuffer::Create( poBuffer->nSize,
+                                                               FALSE );
+            if( poCopy == NULL )
+            {
+                CPLError( CE_Failure, CPLE_OutOfMemory,
+                          "Unable to copy band array ... out of memory." );
+                delete poDS;
+                return NULL;
+            }
+            memcpy( poCopy->pabyData, poBuffer->pabyData, poBuffer->nSize );
+            poDS->apoSharedBuffers.push_back( poCopy );
+        }
+        else
+        {
+            CPLAtomicInc( &(poBuffer->nRefCount) );
+            poDS->apoSharedBuffers.push_back( poBuffer );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Copy dataset level information.                                 */
+/* -------------------------------------------------------------------- */
+    poDS->bGeoTransformSet = poSrcDS->bGeoTransformSet;
+    memcpy( poDS->adfGeoTransform, poSrcDS->adfGeoTransform,
+            sizeof(double) * 6 );
+    if( poSrcDS->pszProjection != NULL )
+        poDS->pszProjection = CPLStrdup( poSrcDS->pszProjection );
+    if( poSrcDS->nGCPCount > 0 )
+        poDS->SetGCPs( poSrcDS->nGCPCount, poSrcDS->pasGCPs,
+                       poSrcDS->osGCPProjection );
+
+    char **papszDomains = poSrcDS->GetMetadataDomainList();
+    for( char **papszIter = papszDomains; papszIter && *papszIter; papszIter++ )
+        poDS->SetMetadata( poSrcDS->GetMetadata( *papszIter ), *papszIter );
+    CSLDestroy( papszDomains );
+
+/* -------------------------------------------------------------------- */
+/*      Create bands referencing the same memory.                       */
+/* -------------------------------------------------------------------- */
+    for( iBand = 0; iBand < poSrcDS->nBands; iBand++ )
+    {
+        MEMRasterBand *poSrcBand = (MEMRasterBand *) poSrcDS->papoBands[iBand];
+        MEMSharedBuffer *poSrcBuffer = poSrcBand->poSharedBuffer;
+        MEMSharedBuffer *poBuffer = poSrcBuffer;
+        for( size_t i = 0; i < poSrcDS->apoSharedBuffers.size(); i++ )
+        {
+            if( poSrcDS->apoSharedBuffers[i] == poSrcBuffer )
+                poBuffer = poDS->apoSharedBuffers[i];
+        }
+        MEMRasterBand *poBand =
+            new MEMRasterBand( poDS, iBand+1,
+                               poBuffer->pabyData +
+                                (poSrcBand->pabyData - poSrcBuffer->pabyData),
+                               poSrcBand->eDataType,
+                               poSrcBand->nPixelOffset, poSrcBand->nLineOffset,
+                               FALSE );
+        poBand->poSharedBuffer = poBuffer;
+
+        poBand->bNoDataSet = poSrcBand->bNoDataSet;
+        poBand->dfNoData = poSrcBand->dfNoData;
+        if( poSrcBand->poColorTable != NULL )
+            poBand->poColorTable = poSrcBand->poColorTable->Clone();
+        poBand->eColorInterp = poSrcBand->eColorInterp;
+        if( poSrcBand->pszUnitType != NULL )
+            poBand->pszUnitType = CPLStrdup( poSrcBand->pszUnitType );
+        poBand->papszCategoryNames =
+            CSLDuplicate( poSrcBand->papszCategoryNames );
+        poBand->dfOffset = poSrcBand->dfOffset;
+        poBand->dfScale = poSrcBand->dfScale;
+        if( poSrcBand->psSavedHistograms != NULL )
+            poBand->psSavedHistograms =
+                CPLCloneXMLTree( poSrcBand->psSavedHistograms );
+
+        papszDomains = poSrcBand->GetMetadataDomainList();
+        for( char **papszIter = papszDomains; papszIter && *papszIter; papszIter++ )
+            poBand->SetMetadata( poSrcBand->GetMetadata( *papszIter ), *papszIter );
+        CSLDestroy( papszDomains );
+
+        poDS->SetBand( iBand+1, poBand );
+    }
+
+    return poDS;
+}
+
+/************************************************************************/
+/*                             CreateCopy()                             */
+/*                                                                      */
+/*      Copies of MEM datasets share the band buffers of their source   */
+/*      until either of them writes into a buffer, so that cloning a    */
+/*      scratch dataset is nearly free. Other sources go through the    */
+/*      generic implementation.                                         */
+/************************************************************************/
+
+GDALDataset *MEMDataset::CreateCopy( const char * pszFilename,
+                                     GDALDataset *poSrcDS, int bStrict,
+                                     char ** papszOptions,
+                                     GDALProgressFunc pfnProgress,
+                                     void * pProgressData )
+
+{
+    GDALDriver *poMEMDriver = (GDALDriver *) GDALGetDriverByName( "MEM" );
+
+    if( poMEMDriver != NULL && poSrcDS->GetDriver() == poMEMDriver &&
+        CSLFetchBoolean( papszOptions, "COPY_ON_WRITE", TRUE ) )
+    {
+        const char *pszInterleave =
+            CSLFetchNameValue( papszOptions, "INTERLEAVE" );
+        const char *pszSrcInterleave =
+            poSrcDS->GetMetadataItem( "INTERLEAVE", "IMAGE_STRUCTURE" );
+        int bSrcPixelInterleaved =
+            pszSrcInterleave != NULL && EQUAL(pszSrcInterleave, "PIXEL");
+
+        if( pszInterleave == NULL ||
+            EQUAL(pszInterleave, "PIXEL") == bSrcPixelInterleaved )
+        {
+            MEMDataset *poDS =
+                CloneSharingBuffers( (MEMDataset *) poSrcDS );
+            if( poDS != NULL )
+            {
+                if( pfnProgress )
+                    pfnProgress( 1.0, NULL, pProgressData );
+                return poDS;
+            }
+        }
+    }
+
+    if( poMEMDriver == NULL )
+        return NULL;
+
+    return poMEMDriver->DefaultCreateCopy( pszFilename, poSrcDS, bStrict,
+                                           papszOptions, pfnProgress,
+                                           pProgressData );
+}
+
 /************************************************************************/
 /*                     MEMDatasetIdentify()                             */
 /************************************************************************/
@@ -1177,6 +1651,8 @@ void GDALRegister_MEM()
 
     if( GDALGetDriverByName( "MEM" ) == NULL )
     {
+        bMEMPoolEnabled = TRUE;
+
         poDriver = new GDALDriver();
         
         poDriver->SetDescription( "MEM" );
@@ -1192,6 +1668,7 @@ void GDALRegister_MEM()
 "       <Value>BAND</Value>"
 "       <Value>PIXEL</Value>"
 "   </Option>"
+"   <Option name='COPY_ON_WRITE' type='boolean' default='YES' description='Whether CreateCopy() of a MEM dataset shares the band buffers of the source until one of them is written'/>"
 "</CreationOptionList>" );
 
 /* Define GDAL_NO_OPEN_FOR_MEM_DRIVER macro to undefine Open() method for MEM driver. */
@@ -1203,6 +1680,7 @@ void GDALRegister_MEM()
         poDriver->pfnIdentify = MEMDatasetIdentify;
 #endif
         poDriver->pfnCreate = MEMDataset::Create;
+        poDriver->pfnCreateCopy = MEMDataset::CreateCopy;
         poDriver->pfnDelete = MEMDatasetDelete;
 
         GetGDALDriverManager()->RegisterDriver( poDriver );
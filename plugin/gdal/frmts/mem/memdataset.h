@@ -46,9 +46,12 @@ CPL_C_END
 /************************************************************************/
 
 class MEMRasterBand;
+class MEMSharedBuffer;
 
 class CPL_DLL MEMDataset : public GDALDataset
 {
+    friend      class MEMRasterBand;
+
     int         bGeoTransformSet;
     double	adfGeoTransform[6];
 
@@ -58,6 +61,12 @@ class CPL_DLL MEMDataset : public GDALDataset
     GDAL_GCP    *pasGCPs;
     CPLString    osGCPProjection;
 
+    /* Buffers allocated by the driver, possibly shared with clones */
+    std::vector<MEMSharedBuffer*> apoSharedBuffers;
+
+    CPLErr       MakeSharedBufferWritable( MEMSharedBuffer *poBuffer );
+    static MEMDataset *CloneSharingBuffers( MEMDataset *poSrcDS );
+
   public:
                  MEMDataset();
     virtual      ~MEMDataset();
@@ -92,6 +101,11 @@ class CPL_DLL MEMDataset : public GDALDataset
     static GDALDataset *Create( const char * pszFilename,
                                 int nXSize, int nYSize, int nBands,
                                 GDALDataType eType, char ** papszParmList );
+    static GDALDataset *CreateCopy( const char * pszFilename,
+                                    GDALDataset *poSrcDS, int bStrict,
+                                    char ** papszOptions,
+                                    GDALProgressFunc pfnProgress,
+                                    void * pProgressData );
 };
 
 /************************************************************************/
@@ -108,6 +122,12 @@ class CPL_DLL MEMRasterBand : public GDALPamRasterBand
     GSpacing    nLineOffset;
     int         bOwnData;
 
+    /* Non NULL when pabyData points into a buffer of the MEMDataset */
+    /* that may be shared with copy-on-write clones.                  */
+    MEMSharedBuffer *poSharedBuffer;
+
+    CPLErr      MakeWritable();
+
     int         bNoDataSet;
     double      dfNoData;
 
@@ -166,7 +186,8 @@ class CPL_DLL MEMRasterBand : public GDALPamRasterBand
                                         GDALProgressFunc, void *pProgressData);
 
     // allow access to MEM driver's private internal memory buffer
-    GByte *GetData(void) const {return(pabyData);}
+    // (the buffer is unshared first, since the caller may write into it)
+    GByte *GetData(void);
 };
 
 #endif /* ndef MEMDATASET_H_INCLUDED */
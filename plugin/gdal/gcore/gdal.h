@@ -733,6 +733,13 @@ CPLErr CPL_DLL CPL_STDCALL GDALSetDefaultHistogram( GDALRasterBandH hBand,
 CPLErr CPL_DLL CPL_STDCALL GDALSetDefaultHistogramEx( GDALRasterBandH hBand,
                                        double dfMin, double dfMax,
                                        int nBuckets, GUIntBig *panHistogram );
+CPLErr CPL_DLL CPL_STDCALL GDALGetRasterQuantiles( GDALRasterBandH hBand,
+                                       int nCount,
+                                       const double *padfProbabilities,
+                                       double *padfQuantiles,
+                                       int bApproxOK, int bForce,
+                                       GDALProgressFunc pfnProgress,
+                                       void * pProgressData );
 int CPL_DLL CPL_STDCALL
 GDALGetRandomRasterSample( GDALRasterBandH, int, float * );
 GDALRasterBandH CPL_DLL CPL_STDCALL
@@ -64,6 +64,7 @@ void CPL_DLL GDALRegister_JPEG2000(void);
 void CPL_DLL GDALRegister_JP2KAK(void);
 void CPL_DLL GDALRegister_JPIPKAK(void);
 void CPL_DLL GDALRegister_MEM(void);
+void CPL_DLL GDALRegister_CMEM(void);
 void CPL_DLL GDALRegister_JDEM(void);
 void CPL_DLL GDALRegister_RASDAMAN(void);
 void CPL_DLL GDALRegister_GRASS(void);
@@ -600,6 +600,50 @@ public:
                                    int, const GDALColorEntry * );
 };
 
+/* ******************************************************************** */
+/*                          GDALQuantileSketch                          */
+/* ******************************************************************** */
+
+/*! Mergeable approximate quantile summary (t-digest). */
+
+class CPL_DLL GDALQuantileSketch
+{
+    double              dfCompression;
+    double              dfMin;
+    double              dfMax;
+    double              dfTotalWeight;
+    int                 bApproximate;
+
+    /* Merged centroids, sorted by increasing mean. */
+    std::vector<double> adfMean;
+    std::vector<double> adfWeight;
+
+    /* Values added since the last Compress(). */
+    std::vector<double> adfBufferMean;
+    std::vector<double> adfBufferWeight;
+
+    void                Compress();
+
+  public:
+                        GDALQuantileSketch( double dfCompression = 200.0 );
+
+    void                Add( double dfValue, double dfWeight = 1.0 );
+    void                Merge( const GDALQuantileSketch &oOther );
+
+    int                 IsEmpty() const;
+    double              GetTotalWeight();
+    double              GetMinimum() const { return dfMin; }
+    double              GetMaximum() const { return dfMax; }
+    double              GetQuantile( double dfProbability );
+
+    /** Whether the sketch was computed from a subset of the data. */
+    int                 IsApproximate() const { return bApproximate; }
+    void                SetApproximate( int bFlag ) { bApproximate = bFlag; }
+
+    CPLString           Serialize();
+    static GDALQuantileSketch *Deserialize( const char *pszSerialized );
+};
+
 /* ******************************************************************** */
 /*                            GDALRasterBand                            */
 /* ******************************************************************** */
@@ -768,6 +812,16 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
     virtual CPLErr SetDefaultHistogram( double dfMin, double dfMax,
                                         int nBuckets, GUIntBig *panHistogram );
 
+    virtual GDALQuantileSketch *ComputeQuantileSketch( int bApproxOK,
+                                        GDALProgressFunc, void *pProgressData );
+    virtual GDALQuantileSketch *GetQuantileSketch( int bApproxOK, int bForce,
+                                        GDALProgressFunc, void *pProgressData );
+    virtual CPLErr SetQuantileSketch( GDALQuantileSketch *poSketch );
+    CPLErr         GetQuantiles( int nCount, const double *padfProbabilities,
+                                 double *padfQuantiles,
+                                 int bApproxOK, int bForce,
+                                 GDALProgressFunc, void *pProgressData );
+
     virtual GDALRasterAttributeTable *GetDefaultRAT();
     virtual CPLErr SetDefaultRAT( const GDALRasterAttributeTable * );
 
@@ -610,9 +610,25 @@ GDALDataset *GDALDriver::DefaultCreateCopy( const char * pszFilename,
 /*      Copy image data.                                                */
 /* -------------------------------------------------------------------- */
     if( eErr == CE_None && nDstBands > 0 )
+    {
+        /* Collect statistics from the data being written, rather than */
+        /* reading the new dataset back afterwards. */
+        char **papszCopyOptions = NULL;
+        if( CSLTestBoolean(
+                CPLGetConfigOption("GDAL_COPY_COMPUTE_HISTOGRAM", "NO")) )
+            papszCopyOptions = CSLSetNameValue( papszCopyOptions,
+                                                "COMPUTE_HISTOGRAM", "YES" );
+        else if( CSLTestBoolean(
+                CPLGetConfigOption("GDAL_COPY_COMPUTE_STATISTICS", "NO")) )
+            papszCopyOptions = CSLSetNameValue( papszCopyOptions,
+                                                "COMPUTE_STATISTICS", "YES" );
+
         eErr = GDALDatasetCopyWholeRaster( (GDALDatasetH) poSrcDS, 
                                            (GDALDatasetH) poDstDS, 
-                                           NULL, pfnProgress, pProgressData );
+                                           papszCopyOptions,
+                                           pfnProgress, pProgressData );
+        CSLDestroy( papszCopyOptions );
+    }
 
 /* -------------------------------------------------------------------- */
 /*      Should we copy some masks over?                                 */
@@ -690,6 +706,13 @@ GDALDataset *GDALDriver::DefaultCreateCopy( const char * pszFilename,
  * In some situations, the new dataset can be created in another process through the
  * \ref gdal_api_proxy mechanism.
  *
+ * When the default CreateCopy() implementation is used, setting the
+ * GDAL_COPY_COMPUTE_STATISTICS configuration option to YES causes the
+ * statistics of each band to be computed from the data as it is written and
+ * set on the new dataset (in its .aux.xml file for PAM enabled formats).
+ * GDAL_COPY_COMPUTE_HISTOGRAM=YES also sets the default histogram.
+ * See GDALDatasetCopyWholeRaster().
+ *
  * @param pszFilename the name for the new dataset.  UTF-8 encoded.
  * @param poSrcDS the dataset being duplicated. 
  * @param bStrict TRUE if the copy must be strictly equivelent, or more
@@ -138,6 +138,7 @@ GDALDriverManager::GDALDriverManager()
 
 void GDALDatasetPoolPreventDestroy(); /* keep that in sync with gdalproxypool.cpp */
 void GDALDatasetPoolForceDestroy(); /* keep that in sync with gdalproxypool.cpp */
+void GDALMEMPoolCleanup(); /* keep that in sync with memdataset.cpp */
 
 GDALDriverManager::~GDALDriverManager()
 
@@ -209,6 +210,11 @@ GDALDriverManager::~GDALDriverManager()
 
     delete GDALGetAPIPROXYDriver();
 
+/* -------------------------------------------------------------------- */
+/*      Free the band buffers pooled by the MEM driver.                 */
+/* -------------------------------------------------------------------- */
+    GDALMEMPoolCleanup();
+
 /* -------------------------------------------------------------------- */
 /*      Cleanup local memory.                                           */
 /* -------------------------------------------------------------------- */
@@ -0,0 +1,401 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Implementation of GDALQuantileSketch, a mergeable approximate
+ *           quantile summary (t-digest).
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "gdal_priv.h"
+#include <algorithm>
+#include <limits>
+
+CPL_CVSID("$Id$");
+
+/* Serialization signature, stored as first token. */
+#define QUANTILE_SKETCH_SIGNATURE "TDIGEST1"
+
+/************************************************************************/
+/*                         GDALQuantileSketch()                         */
+/************************************************************************/
+
+/**
+ * \brief Constructor.
+ *
+ * The sketch is a merging t-digest (T. Dunning, "Computing extremely
+ * accurate quantiles using t-digests").  It keeps at most about
+ * 2 * dfCompression centroids whatever the number of values added, with
+ * a better accuracy near the tails (0.01, 0.99) than around the median.
+ *
+ * Sketches built on disjoint subsets of data (blocks, tiles, overviews,
+ * several threads...) can be combined with Merge().
+ *
+ * @param dfCompressionIn compression parameter. Higher values give more
+ * accurate results at the expense of memory. Defaults to 200.
+ *
+ * @since GDAL 2.0
+ */
+
+GDALQuantileSketch::GDALQuantileSketch( double dfCompressionIn ) :
+    dfCompression(MAX(dfCompressionIn, 10.0)),
+    dfMin(0.0), dfMax(0.0), dfTotalWeight(0.0), bApproximate(FALSE)
+{
+}
+
+/************************************************************************/
+/*                            ScaleFunction()                           */
+/*                                                                      */
+/*      The k1 scale function: centroids can be merged as long as       */
+/*      they span less than one unit of k.                              */
+/************************************************************************/
+
+static double ScaleFunction( double dfQ, double dfCompression )
+{
+    return dfCompression / (2 * M_PI) * asin( 2 * MIN(MAX(dfQ, 0.0), 1.0) - 1 );
+}
+
+/************************************************************************/
+/*                                Add()                                 */
+/************************************************************************/
+
+/**
+ * \brief Add a value to the sketch.
+ *
+ * NaN values are ignored.
+ *
+ * @param dfValue value.
+ * @param dfWeight weight of the value (number of occurences).
+ */
+
+void GDALQuantileSketch::Add( double dfValue, double dfWeight )
+{
+    if( CPLIsNan(dfValue) || !(dfWeight > 0.0) )
+        return;
+
+    if( IsEmpty() )
+        dfMin = dfMax = dfValue;
+    else
+    {
+        dfMin = MIN(dfMin, dfValue);
+        dfMax = MAX(dfMax, dfValue);
+    }
+
+    adfBufferMean.push_back( dfValue );
+    adfBufferWeight.push_back( dfWeight );
+
+    if( adfBufferMean.size() >= (size_t)(5 * dfCompression) )
+        Compress();
+}
+
+/************************************************************************/
+/*                               Merge()                                */
+/************************************************************************/
+
+/**
+ * \brief Merge another sketch into this one.
+ *
+ * After that, this sketch summarizes the union of the values of both
+ * sketches.  The result is approximate if any of them was.
+ *
+ * @param oOther sketch to merge. It is not modified.
+ */
+
+void GDALQuantileSketch::Merge( const GDALQuantileSketch &oOther )
+{
+    if( oOther.IsEmpty() )
+        return;
+
+    /* Inserting the vectors of a sketch into themselves is undefined */
+    if( &oOther == this )
+    {
+        GDALQuantileSketch oCopy( *this );
+        Merge( oCopy );
+        return;
+    }
+
+    if( IsEmpty() )
+    {
+        dfMin = oOther.dfMin;
+        dfMax = oOther.dfMax;
+    }
+    else
+    {
+        dfMin = MIN(dfMin, oOther.dfMin);
+        dfMax = MAX(dfMax, oOther.dfMax);
+    }
+    bApproximate |= oOther.bApproximate;
+
+    adfBufferMean.insert( adfBufferMean.end(),
+                          oOther.adfMean.begin(), oOther.adfMean.end() );
+    adfBufferWeight.insert( adfBufferWeight.end(),
+                            oOther.adfWeight.begin(), oOther.adfWeight.end() );
+    adfBufferMean.insert( adfBufferMean.end(),
+                          oOther.adfBufferMean.begin(),
+                          oOther.adfBufferMean.end() );
+    adfBufferWeight.insert( adfBufferWeight.end(),
+                            oOther.adfBufferWeight.begin(),
+                            oOther.adfBufferWeight.end() );
+
+    Compress();
+}
+
+/************************************************************************/
+/*                              Compress()                              */
+/*                                                                      */
+/*      Merge the buffered values with the existing centroids, in       */
+/*      increasing order, as long as the scale function permits it.     */
+/************************************************************************/
+
+void GDALQuantileSketch::Compress()
+{
+    if( adfBufferMean.empty() )
+        return;
+
+    const size_t nIn = adfMean.size() + adfBufferMean.size();
+    std::vector< std::pair<double,double> > aoIn;
+    size_t i;
+
+    aoIn.reserve( nIn );
+    for( i = 0; i < adfMean.size(); i++ )
+        aoIn.push_back( std::pair<double,double>( adfMean[i], adfWeight[i] ) );
+    for( i = 0; i < adfBufferMean.size(); i++ )
+    {
+        aoIn.push_back( std::pair<double,double>( adfBufferMean[i],
+                                                  adfBufferWeight[i] ) );
+        dfTotalWeight += adfBufferWeight[i];
+    }
+    adfBufferMean.resize( 0 );
+    adfBufferWeight.resize( 0 );
+
+    std::sort( aoIn.begin(), aoIn.end() );
+
+    adfMean.resize( 0 );
+    adfWeight.resize( 0 );
+
+    double dfWeightSoFar = 0.0;
+    double dfKLower = ScaleFunction( 0.0, dfCompression );
+    double dfCurMean = aoIn[0].first;
+    double dfCurWeight = aoIn[0].second;
+
+    for( i = 1; i < nIn; i++ )
+    {
+        const double dfQ =
+            (dfWeightSoFar + dfCurWeight + aoIn[i].second) / dfTotalWeight;
+
+        if( ScaleFunction( dfQ, dfCompression ) - dfKLower <= 1.0 )
+        {
+            dfCurWeight += aoIn[i].second;
+            dfCurMean += (aoIn[i].first - dfCurMean) * aoIn[i].second
+                                                     / dfCurWeight;
+        }
+        else
+        {
+            adfMean.push_back( dfCurMean );
+            adfWeight.push_back( dfCurWeight );
+            dfWeightSoFar += dfCurWeight;
+            dfKLower = ScaleFunction( dfWeightSoFar / dfTotalWeight,
+                                      dfCompression );
+            dfCurMean = aoIn[i].first;
+            dfCurWeight = aoIn[i].second;
+        }
+    }
+    adfMean.push_back( dfCurMean );
+    adfWeight.push_back( dfCurWeight );
+}
+
+/************************************************************************/
+/*                              IsEmpty()                               */
+/************************************************************************/
+
+/** \brief Return whether no value has been added to the sketch. */
+
+int GDALQuantileSketch::IsEmpty() const
+{
+    return adfMean.empty() && adfBufferMean.empty();
+}
+
+/************************************************************************/
+/*                           GetTotalWeight()                           */
+/************************************************************************/
+
+/** \brief Return the sum of the weights of the values in the sketch. */
+
+double GDALQuantileSketch::GetTotalWeight()
+{
+    Compress();
+    return dfTotalWeight;
+}
+
+/************************************************************************/
+/*                            GetQuantile()                             */
+/************************************************************************/
+
+/**
+ * \brief Estimate a quantile.
+ *
+ * The value is interpolated between the centroids.  The minimum and
+ * maximum values are exact.
+ *
+ * @param dfProbability probability in [0,1], e.g. 0.02 for the 2nd
+ * percentile.
+ *
+ * @return the estimated value, or NaN if the sketch is empty.
+ */
+
+double GDALQuantileSketch::GetQuantile( double dfProbability )
+{
+    Compress();
+
+    if( adfMean.empty() )
+        return std::numeric_limits<double>::quiet_NaN();
+
+    if( dfProbability <= 0.0 )
+        return dfMin;
+    if( dfProbability >= 1.0 )
+        return dfMax;
+
+    const size_t nCentroids = adfMean.size();
+    if( nCentroids == 1 )
+        return adfMean[0];
+
+    const double dfIndex = dfProbability * dfTotalWeight;
+
+/* -------------------------------------------------------------------- */
+/*      Before the center of the first centroid: interpolate from the   */
+/*      minimum.                                                        */
+/* -------------------------------------------------------------------- */
+    if( dfIndex < adfWeight[0] / 2 )
+    {
+        return dfMin + (adfMean[0] - dfMin) * dfIndex / (adfWeight[0] / 2);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Between centroid centers.                                       */
+/* -------------------------------------------------------------------- */
+    double dfWeightSoFar = adfWeight[0] / 2;
+    for( size_t i = 0; i + 1 < nCentroids; i++ )
+    {
+        const double dfDelta = (adfWeight[i] + adfWeight[i+1]) / 2;
+        if( dfWeightSoFar + dfDelta > dfIndex )
+        {
+            const double dfRatio = (dfIndex - dfWeightSoFar) / dfDelta;
+            return adfMean[i] + dfRatio * (adfMean[i+1] - adfMean[i]);
+        }
+        dfWeightSoFar += dfDelta;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      After the center of the last centroid: interpolate to the       */
+/*      maximum.                                                        */
+/* -------------------------------------------------------------------- */
+    const double dfLastHalf = adfWeight[nCentroids-1] / 2;
+    const double dfRatio = MIN(1.0, (dfIndex - dfWeightSoFar) / dfLastHalf);
+    return adfMean[nCentroids-1] + dfRatio * (dfMax - adfMean[nCentroids-1]);
+}
+
+/************************************************************************/
+/*                             Serialize()                              */
+/************************************************************************/
+
+/**
+ * \brief Serialize the sketch as a string.
+ *
+ * The string can be turned back into a sketch with Deserialize().  It is
+ * what GDALRasterBand::SetQuantileSketch() stores in the
+ * STATISTICS_QUANTILE_SKETCH metadata item.
+ */
+
+CPLString GDALQuantileSketch::Serialize()
+{
+    Compress();
+
+    CPLString osRet;
+    osRet.Printf( "%s %.17g %d %.17g %.17g %d",
+                  QUANTILE_SKETCH_SIGNATURE, dfCompression, bApproximate,
+                  dfMin, dfMax, (int) adfMean.size() );
+
+    for( size_t i = 0; i < adfMean.size(); i++ )
+        osRet += CPLSPrintf( " %.17g:%.17g", adfMean[i], adfWeight[i] );
+
+    return osRet;
+}
+
+/************************************************************************/
+/*                            Deserialize()                             */
+/************************************************************************/
+
+/**
+ * \brief Instantiate a sketch from a string produced by Serialize().
+ *
+ * @return a new sketch to be destroyed with delete, or NULL if the string
+ * is not valid.
+ */
+
+GDALQuantileSketch *GDALQuantileSketch::Deserialize( const char *pszSerialized )
+{
+    if( pszSerialized == NULL )
+        return NULL;
+
+    char **papszTokens = CSLTokenizeString2( pszSerialized, " ", 0 );
+    const int nTokens = CSLCount( papszTokens );
+
+    if( nTokens < 6 || !EQUAL(papszTokens[0], QUANTILE_SKETCH_SIGNATURE)
+        || atoi(papszTokens[5]) != nTokens - 6 )
+    {
+        CSLDestroy( papszTokens );
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Invalid serialized quantile sketch." );
+        return NULL;
+    }
+
+    GDALQuantileSketch *poSketch =
+        new GDALQuantileSketch( CPLAtof(papszTokens[1]) );
+    poSketch->bApproximate = atoi(papszTokens[2]);
+    poSketch->dfMin = CPLAtof(papszTokens[3]);
+    poSketch->dfMax = CPLAtof(papszTokens[4]);
+
+    for( int i = 6; i < nTokens; i++ )
+    {
+        const char *pszSep = strchr( papszTokens[i], ':' );
+        const double dfWeight = pszSep ? CPLAtof( pszSep + 1 ) : 0.0;
+        if( !(dfWeight > 0.0) )
+        {
+            CSLDestroy( papszTokens );
+            delete poSketch;
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Invalid serialized quantile sketch." );
+            return NULL;
+        }
+
+        /* Centroids are serialized in increasing order and don't need */
+        /* to be compressed again. */
+        poSketch->adfMean.push_back( CPLAtof( papszTokens[i] ) );
+        poSketch->adfWeight.push_back( dfWeight );
+        poSketch->dfTotalWeight += dfWeight;
+    }
+
+    CSLDestroy( papszTokens );
+    return poSketch;
+}
@@ -4674,6 +4674,442 @@ CPLErr CPL_STDCALL GDALSetDefaultHistogramEx( GDALRasterBandH hBand,
     return poBand->SetDefaultHistogram( dfMin, dfMax, nBuckets, panHistogram );
 }
 
+/************************************************************************/
+/*                    GDALAddBlockToQuantileSketch()                    */
+/************************************************************************/
+
+template<class T>
+static void GDALAddBlockToQuantileSketch( GDALQuantileSketch *poSketch,
+                                          const T *pData,
+                                          int nXCheck, int nYCheck,
+                                          int nBlockXSize, int nStride,
+                                          int bGotNoDataValue,
+                                          double dfNoDataValue )
+{
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        const T *pLine = pData + (size_t)iY * nBlockXSize * nStride;
+        for( int iX = 0; iX < nXCheck; iX++ )
+        {
+            const double dfValue = (double) pLine[iX * nStride];
+
+            if( bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue) )
+                continue;
+
+            poSketch->Add( dfValue );
+        }
+    }
+}
+
+/************************************************************************/
+/*                   GDALCountBlockValuesForSketch()                    */
+/*                                                                      */
+/*      For 8 and 16 bit integer types, counting values and feeding     */
+/*      the sketch with weighted values at the end is much cheaper.     */
+/************************************************************************/
+
+template<class T>
+static void GDALCountBlockValuesForSketch( GUIntBig *panCounts,
+                                           int nValueOffset,
+                                           const T *pData,
+                                           int nXCheck, int nYCheck,
+                                           int nBlockXSize, int nStride )
+{
+    for( int iY = 0; iY < nYCheck; iY++ )
+    {
+        const T *pLine = pData + (size_t)iY * nBlockXSize * nStride;
+        for( int iX = 0; iX < nXCheck; iX++ )
+            panCounts[(int)pLine[iX * nStride] + nValueOffset] ++;
+    }
+}
+
+/************************************************************************/
+/*                       ComputeQuantileSketch()                        */
+/************************************************************************/
+
+/**
+ * \brief Compute a quantile sketch of the band values.
+ *
+ * The sketch (see GDALQuantileSketch) summarizes the distribution of the
+ * pixel values, nodata and NaN values excluded, in bounded memory. For
+ * complex data types, the real part is used, as in ComputeStatistics().
+ *
+ * If approximate results are sufficient, the bApproxOK flag can be set to
+ * true in which case overviews, or a subset of image tiles may be used, and
+ * the sketch is flagged as approximate.
+ *
+ * Once computed, the sketch is set back on the raster band using
+ * SetQuantileSketch().
+ *
+ * @param bApproxOK If TRUE the sketch may be computed based on overviews
+ * or a subset of all tiles.
+ *
+ * @param pfnProgress a function to call to report progress, or NULL.
+ *
+ * @param pProgressData application data to pass to the progress function.
+ *
+ * @return a new sketch to be destroyed with delete by the caller, or NULL
+ * if an error occurs or processing is terminated by the user.
+ *
+ * @since GDAL 2.0
+ */
+
+GDALQuantileSketch *
+GDALRasterBand::ComputeQuantileSketch( int bApproxOK,
+                                       GDALProgressFunc pfnProgress,
+                                       void *pProgressData )
+
+{
+    if( pfnProgress == NULL )
+        pfnProgress = GDALDummyProgress;
+
+/* -------------------------------------------------------------------- */
+/*      If we have overview bands, use them.                            */
+/* -------------------------------------------------------------------- */
+    GDALRasterBand *poSrcBand = this;
+
+    if( bApproxOK && GetOverviewCount() > 0 && !HasArbitraryOverviews() )
+        poSrcBand = GetRasterSampleOverview( GDALSTAT_APPROX_NUMSAMPLES );
+
+    if( !pfnProgress( 0.0, "Compute Quantile Sketch", pProgressData ) )
+    {
+        ReportError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+        return NULL;
+    }
+
+    int bGotNoDataValue;
+    const double dfNoDataValue = GetNoDataValue( &bGotNoDataValue );
+    bGotNoDataValue = bGotNoDataValue && !CPLIsNan(dfNoDataValue);
+
+    const char* pszPixelType = GetMetadataItem("PIXELTYPE", "IMAGE_STRUCTURE");
+    int bSignedByte = (pszPixelType != NULL && EQUAL(pszPixelType, "SIGNEDBYTE"));
+
+    const GDALDataType eSrcDataType = poSrcBand->GetRasterDataType();
+    const int nStride = GDALDataTypeIsComplex(eSrcDataType) ? 2 : 1;
+
+    int nValueCount = 0, nValueOffset = 0;
+    if( eSrcDataType == GDT_Byte )
+    {
+        nValueCount = 256;
+        nValueOffset = bSignedByte ? 128 : 0;
+    }
+    else if( eSrcDataType == GDT_UInt16 )
+        nValueCount = 65536;
+    else if( eSrcDataType == GDT_Int16 || eSrcDataType == GDT_CInt16 )
+    {
+        nValueCount = 65536;
+        nValueOffset = 32768;
+    }
+
+    GUIntBig *panCounts = NULL;
+    if( nValueCount > 0 )
+    {
+        panCounts = (GUIntBig *) VSICalloc( sizeof(GUIntBig), nValueCount );
+        if( panCounts == NULL )
+        {
+            ReportError( CE_Failure, CPLE_OutOfMemory,
+                         "Out of memory in ComputeQuantileSketch()." );
+            return NULL;
+        }
+    }
+
+    GDALQuantileSketch *poSketch = new GDALQuantileSketch();
+    if( poSrcBand != this )
+        poSketch->SetApproximate( TRUE );
+
+/* -------------------------------------------------------------------- */
+/*      Figure out the ratio of blocks we will read to get an           */
+/*      approximate value.                                              */
+/* -------------------------------------------------------------------- */
+    int nSrcBlockXSize, nSrcBlockYSize;
+    poSrcBand->GetBlockSize( &nSrcBlockXSize, &nSrcBlockYSize );
+
+    const int nSrcXSize = poSrcBand->GetXSize();
+    const int nSrcYSize = poSrcBand->GetYSize();
+    const int nSrcBlocksPerRow = (nSrcXSize + nSrcBlockXSize - 1) / nSrcBlockXSize;
+    const int nSrcBlocksPerColumn =
+        (nSrcYSize + nSrcBlockYSize - 1) / nSrcBlockYSize;
+    const int nTotalBlocks = nSrcBlocksPerRow * nSrcBlocksPerColumn;
+
+    int nSampleRate = 1;
+    if( bApproxOK && poSrcBand == this && !HasArbitraryOverviews() )
+        nSampleRate = (int)MAX( 1, sqrt((double)nTotalBlocks) );
+    if( nSampleRate > 1 )
+        poSketch->SetApproximate( TRUE );
+
+    for( int iSampleBlock = 0;
+         iSampleBlock < nTotalBlocks;
+         iSampleBlock += nSampleRate )
+    {
+        const int iYBlock = iSampleBlock / nSrcBlocksPerRow;
+        const int iXBlock = iSampleBlock - nSrcBlocksPerRow * iYBlock;
+
+        GDALRasterBlock *poBlock =
+            poSrcBand->GetLockedBlockRef( iXBlock, iYBlock );
+        if( poBlock == NULL || poBlock->GetDataRef() == NULL )
+        {
+            /* A sketch missing some blocks would be silently biased. */
+            if( poBlock != NULL )
+                poBlock->DropLock();
+            CPLFree( panCounts );
+            delete poSketch;
+            return NULL;
+        }
+
+        void *pData = poBlock->GetDataRef();
+        const int nXCheck = MIN(nSrcBlockXSize,
+                                nSrcXSize - iXBlock * nSrcBlockXSize);
+        const int nYCheck = MIN(nSrcBlockYSize,
+                                nSrcYSize - iYBlock * nSrcBlockYSize);
+
+        switch( eSrcDataType )
+        {
+          case GDT_Byte:
+            if( bSignedByte )
+                GDALCountBlockValuesForSketch( panCounts, nValueOffset,
+                        (const signed char *) pData,
+                        nXCheck, nYCheck, nSrcBlockXSize, nStride );
+            else
+                GDALCountBlockValuesForSketch( panCounts, nValueOffset,
+                        (const GByte *) pData,
+                        nXCheck, nYCheck, nSrcBlockXSize, nStride );
+            break;
+          case GDT_UInt16:
+            GDALCountBlockValuesForSketch( panCounts, nValueOffset,
+                        (const GUInt16 *) pData,
+                        nXCheck, nYCheck, nSrcBlockXSize, nStride );
+            break;
+          case GDT_Int16:
+          case GDT_CInt16:
+            GDALCountBlockValuesForSketch( panCounts, nValueOffset,
+                        (const GInt16 *) pData,
+                        nXCheck, nYCheck, nSrcBlockXSize, nStride );
+            break;
+          case GDT_UInt32:
+            GDALAddBlockToQuantileSketch( poSketch, (const GUInt32 *) pData,
+                        nXCheck, nYCheck, nSrcBlockXSize, nStride,
+                        bGotNoDataValue, dfNoDataValue );
+            break;
+          case GDT_Int32:
+          case GDT_CInt32:
+            GDALAddBlockToQuantileSketch( poSketch, (const GInt32 *) pData,
+                        nXCheck, nYCheck, nSrcBlockXSize, nStride,
+                        bGotNoDataValue, dfNoDataValue );
+            break;
+          case GDT_Float32:
+          case GDT_CFloat32:
+            GDALAddBlockToQuantileSketch( poSketch, (const float *) pData,
+                        nXCheck, nYCheck, nSrcBlockXSize, nStride,
+                        bGotNoDataValue, dfNoDataValue );
+            break;
+          case GDT_Float64:
+          case GDT_CFloat64:
+            GDALAddBlockToQuantileSketch( poSketch, (const double *) pData,
+                        nXCheck, nYCheck, nSrcBlockXSize, nStride,
+                        bGotNoDataValue, dfNoDataValue );
+            break;
+          default:
+            CPLAssert( FALSE );
+        }
+
+        poBlock->DropLock();
+
+        if ( !pfnProgress( iSampleBlock / (double)nTotalBlocks,
+                           "Compute Quantile Sketch", pProgressData ) )
+        {
+            ReportError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            CPLFree( panCounts );
+            delete poSketch;
+            return NULL;
+        }
+    }
+
+    if( panCounts != NULL )
+    {
+        for( int i = 0; i < nValueCount; i++ )
+        {
+            const double dfValue = i - nValueOffset;
+            if( panCounts[i] == 0 ||
+                (bGotNoDataValue && ARE_REAL_EQUAL(dfValue, dfNoDataValue)) )
+                continue;
+            poSketch->Add( dfValue, (double) panCounts[i] );
+        }
+        CPLFree( panCounts );
+    }
+
+    if( !pfnProgress( 1.0, "Compute Quantile Sketch", pProgressData ) )
+    {
+        ReportError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+        delete poSketch;
+        return NULL;
+    }
+
+    if( poSketch->IsEmpty() )
+    {
+        ReportError( CE_Failure, CPLE_AppDefined,
+            "Failed to compute quantile sketch, no valid pixels found in sampling." );
+        delete poSketch;
+        return NULL;
+    }
+
+    SetQuantileSketch( poSketch );
+
+    return poSketch;
+}
+
+/************************************************************************/
+/*                         GetQuantileSketch()                          */
+/************************************************************************/
+
+/**
+ * \brief Fetch the quantile sketch of the band.
+ *
+ * If a sketch has been previously set with SetQuantileSketch(), and
+ * is exact or bApproxOK is TRUE, it is returned.  Otherwise, if bForce is
+ * TRUE, a sketch is computed with ComputeQuantileSketch().
+ *
+ * @param bApproxOK If TRUE an approximate sketch is acceptable.
+ * @param bForce If FALSE, the sketch is only returned if it can be
+ * obtained without scanning the image.
+ * @param pfnProgress a function to call to report progress, or NULL.
+ * @param pProgressData application data to pass to the progress function.
+ *
+ * @return a new sketch to be destroyed with delete by the caller, or NULL.
+ *
+ * @since GDAL 2.0
+ */
+
+GDALQuantileSketch *
+GDALRasterBand::GetQuantileSketch( int bApproxOK, int bForce,
+                                   GDALProgressFunc pfnProgress,
+                                   void *pProgressData )
+
+{
+    const char *pszSketch = GetMetadataItem( "STATISTICS_QUANTILE_SKETCH" );
+
+    if( pszSketch != NULL )
+    {
+        GDALQuantileSketch *poSketch =
+            GDALQuantileSketch::Deserialize( pszSketch );
+
+        if( poSketch != NULL && (bApproxOK || !poSketch->IsApproximate()) )
+            return poSketch;
+
+        delete poSketch;
+    }
+
+    if( !bForce )
+        return NULL;
+
+    return ComputeQuantileSketch( bApproxOK, pfnProgress, pProgressData );
+}
+
+/************************************************************************/
+/*                         SetQuantileSketch()                          */
+/************************************************************************/
+
+/**
+ * \brief Set the quantile sketch of the band.
+ *
+ * The default implementation stores the serialized sketch as the
+ * STATISTICS_QUANTILE_SKETCH metadata item, next to the other statistics.
+ * For PAM enabled formats it is thus saved in the .aux.xml file.
+ *
+ * @param poSketch the sketch. Ownership is not transferred.
+ *
+ * @return CE_None on success or CE_Failure on failure.
+ *
+ * @since GDAL 2.0
+ */
+
+CPLErr GDALRasterBand::SetQuantileSketch( GDALQuantileSketch *poSketch )
+
+{
+    return SetMetadataItem( "STATISTICS_QUANTILE_SKETCH",
+                            poSketch->Serialize() );
+}
+
+/************************************************************************/
+/*                            GetQuantiles()                            */
+/************************************************************************/
+
+/**
+ * \brief Fetch approximate quantiles of the band values.
+ *
+ * This is a convenience method on top of GetQuantileSketch().  For example
+ * for a 2%/98% percentile stretch, pass { 0.02, 0.98 } as the
+ * probabilities.
+ *
+ * This method is the same as the C function GDALGetRasterQuantiles().
+ *
+ * @param nCount number of quantiles to fetch.
+ * @param padfProbabilities array of nCount probabilities in [0,1].
+ * @param padfQuantiles array of nCount values receiving the quantiles.
+ * @param bApproxOK If TRUE an approximate sketch is acceptable.
+ * @param bForce If FALSE, no quantile is returned unless a sketch has
+ * already been set on the band.
+ * @param pfnProgress a function to call to report progress, or NULL.
+ * @param pProgressData application data to pass to the progress function.
+ *
+ * @return CE_None on success, CE_Warning if no sketch is available and
+ * bForce is FALSE, or CE_Failure if an error occurs.
+ *
+ * @since GDAL 2.0
+ */
+
+CPLErr GDALRasterBand::GetQuantiles( int nCount,
+                                     const double *padfProbabilities,
+                                     double *padfQuantiles,
+                                     int bApproxOK, int bForce,
+                                     GDALProgressFunc pfnProgress,
+                                     void *pProgressData )
+
+{
+    GDALQuantileSketch *poSketch =
+        GetQuantileSketch( bApproxOK, bForce, pfnProgress, pProgressData );
+
+    if( poSketch == NULL )
+        return bForce ? CE_Failure : CE_Warning;
+
+    for( int i = 0; i < nCount; i++ )
+        padfQuantiles[i] = poSketch->GetQuantile( padfProbabilities[i] );
+
+    delete poSketch;
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                       GDALGetRasterQuantiles()                       */
+/************************************************************************/
+
+/**
+ * \brief Fetch approximate quantiles of the band values.
+ *
+ * @see GDALRasterBand::GetQuantiles()
+ *
+ * @since GDAL 2.0
+ */
+
+CPLErr CPL_STDCALL GDALGetRasterQuantiles( GDALRasterBandH hBand,
+                                           int nCount,
+                                           const double *padfProbabilities,
+                                           double *padfQuantiles,
+                                           int bApproxOK, int bForce,
+                                           GDALProgressFunc pfnProgress,
+                                           void *pProgressData )
+
+{
+    VALIDATE_POINTER1( hBand, "GDALGetRasterQuantiles", CE_Failure );
+    VALIDATE_POINTER1( padfProbabilities, "GDALGetRasterQuantiles", CE_Failure );
+    VALIDATE_POINTER1( padfQuantiles, "GDALGetRasterQuantiles", CE_Failure );
+
+    GDALRasterBand *poBand = static_cast<GDALRasterBand*>(hBand);
+    return poBand->GetQuantiles( nCount, padfProbabilities, padfQuantiles,
+                                 bApproxOK, bForce,
+                                 pfnProgress, pProgressData );
+}
+
 /************************************************************************/
 /*                           GetDefaultRAT()                            */
 /************************************************************************/
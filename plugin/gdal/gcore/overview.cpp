@@ -31,6 +31,16 @@
 #include "gdal_priv.h"
 #include "gdalwarper.h"
 
+/* We restrict to 64bit processors because they are guaranteed to have SSE2 */
+/* Could possibly be used too on 32bit, but we would need to check at runtime */
+#if defined(__x86_64) || defined(_M_X64)
+#define USE_SSE2
+#endif
+
+#ifdef USE_SSE2
+#include <gdalsse_priv.h>
+#endif
+
 CPL_CVSID("$Id: overview.cpp 28142 2014-12-14 20:09:42Z goatbar $");
 
 /************************************************************************/
@@ -197,6 +207,235 @@ static int GDALFindBestEntry(int nEntryCount, const GDALColorEntry* aEntries,
     return iBestEntry;
 }
 
+/************************************************************************/
+/*                      GDALAverageRoundedT()                           */
+/*                                                                      */
+/*      Turn a sum of nCount source values into an output value,        */
+/*      with rounding to nearest for integer work types.                */
+/************************************************************************/
+
+template <class T, class Tsum>
+static inline T GDALAverageRoundedT( Tsum nTotal, int nCount )
+{
+    return (T) ((nTotal + nCount / 2) / nCount);
+}
+
+template <>
+inline float GDALAverageRoundedT<float, double>( double dfTotal, int nCount )
+{
+    return (float) (dfTotal / nCount);
+}
+
+/************************************************************************/
+/*                      GDALAverageSumIsExactT()                        */
+/*                                                                      */
+/*      Whether sums of source values do not depend on the order of     */
+/*      the additions, so that windows may be summed column by column.  */
+/************************************************************************/
+
+template <class Tsum>
+static inline int GDALAverageSumIsExactT()
+{
+    return TRUE;
+}
+
+template <>
+inline int GDALAverageSumIsExactT<double>()
+{
+    return FALSE;
+}
+
+/************************************************************************/
+/*                      GDALAverage2x2LineT()                           */
+/*                                                                      */
+/*      Average one destination line when the source spacing is 2 in    */
+/*      both directions and there is no nodata mask.                    */
+/************************************************************************/
+
+template <class T, class Tsum>
+static inline void GDALAverage2x2LineT( const T* pSrc, int nSrcLineStride,
+                                        T* pDst, int nStart, int nDstWidth )
+{
+    pSrc += 2 * nStart;
+    for( int iDstPixel = nStart; iDstPixel < nDstWidth; iDstPixel++ )
+    {
+        Tsum nTotal = 0;
+
+        nTotal += pSrc[0];
+        nTotal += pSrc[1];
+        nTotal += pSrc[nSrcLineStride];
+        nTotal += pSrc[1+nSrcLineStride];
+
+        pDst[iDstPixel] = GDALAverageRoundedT<T, Tsum>(nTotal, 4);
+        pSrc += 2;
+    }
+}
+
+template <class T, class Tsum>
+static inline void GDALAverage2x2Line( const T* pSrc, int nSrcLineStride,
+                                       T* pDst, int nDstWidth )
+{
+    GDALAverage2x2LineT<T, Tsum>(pSrc, nSrcLineStride, pDst, 0, nDstWidth);
+}
+
+#ifdef USE_SSE2
+
+/* The SSE2 versions below give exactly the same results as the generic */
+/* version : integer sums are computed exactly, and Float32 sums are     */
+/* accumulated in double precision in the same order.                    */
+
+template <>
+inline void GDALAverage2x2Line<GByte, int>( const GByte* pSrc,
+                                            int nSrcLineStride,
+                                            GByte* pDst, int nDstWidth )
+{
+    const __m128i xmm_zero = _mm_setzero_si128();
+    const __m128i xmm_one16 = _mm_set1_epi16(1);
+    const __m128i xmm_two32 = _mm_set1_epi32(2);
+    int iDstPixel = 0;
+
+    for( ; iDstPixel + 8 <= nDstWidth; iDstPixel += 8 )
+    {
+        const __m128i xmm_row0 =
+            _mm_loadu_si128((const __m128i*)(pSrc + 2 * iDstPixel));
+        const __m128i xmm_row1 =
+            _mm_loadu_si128((const __m128i*)(pSrc + 2 * iDstPixel + nSrcLineStride));
+
+        /* Vertical sums of the 16 source columns, as 16 bit integers */
+        __m128i xmm_lo = _mm_add_epi16(_mm_unpacklo_epi8(xmm_row0, xmm_zero),
+                                       _mm_unpacklo_epi8(xmm_row1, xmm_zero));
+        __m128i xmm_hi = _mm_add_epi16(_mm_unpackhi_epi8(xmm_row0, xmm_zero),
+                                       _mm_unpackhi_epi8(xmm_row1, xmm_zero));
+
+        /* Horizontal sums of adjacent columns, then (nTotal + 2) / 4 */
+        xmm_lo = _mm_srli_epi32(
+            _mm_add_epi32(_mm_madd_epi16(xmm_lo, xmm_one16), xmm_two32), 2);
+        xmm_hi = _mm_srli_epi32(
+            _mm_add_epi32(_mm_madd_epi16(xmm_hi, xmm_one16), xmm_two32), 2);
+
+        __m128i xmm_res = _mm_packs_epi32(xmm_lo, xmm_hi);
+        xmm_res = _mm_packus_epi16(xmm_res, xmm_res);
+        _mm_storel_epi64((__m128i*)(pDst + iDstPixel), xmm_res);
+    }
+
+    GDALAverage2x2LineT<GByte, int>(pSrc, nSrcLineStride, pDst,
+                                    iDstPixel, nDstWidth);
+}
+
+template <>
+inline void GDALAverage2x2Line<GUInt16, GUInt32>( const GUInt16* pSrc,
+                                                  int nSrcLineStride,
+                                                  GUInt16* pDst, int nDstWidth )
+{
+    const __m128i xmm_zero = _mm_setzero_si128();
+    const __m128i xmm_two32 = _mm_set1_epi32(2);
+    const __m128i xmm_bias32 = _mm_set1_epi32(32768);
+    const __m128i xmm_bias16 = _mm_set1_epi16(-32768);
+    int iDstPixel = 0;
+
+    for( ; iDstPixel + 4 <= nDstWidth; iDstPixel += 4 )
+    {
+        const __m128i xmm_row0 =
+            _mm_loadu_si128((const __m128i*)(pSrc + 2 * iDstPixel));
+        const __m128i xmm_row1 =
+            _mm_loadu_si128((const __m128i*)(pSrc + 2 * iDstPixel + nSrcLineStride));
+
+        /* Vertical sums of the 8 source columns, as 32 bit integers */
+        const __m128i xmm_lo = _mm_add_epi32(_mm_unpacklo_epi16(xmm_row0, xmm_zero),
+                                             _mm_unpacklo_epi16(xmm_row1, xmm_zero));
+        const __m128i xmm_hi = _mm_add_epi32(_mm_unpackhi_epi16(xmm_row0, xmm_zero),
+                                             _mm_unpackhi_epi16(xmm_row1, xmm_zero));
+
+        /* Gather even and odd columns to add them together */
+        const __m128i xmm_even = _mm_castps_si128(_mm_shuffle_ps(
+            _mm_castsi128_ps(xmm_lo), _mm_castsi128_ps(xmm_hi), _MM_SHUFFLE(2,0,2,0)));
+        const __m128i xmm_odd = _mm_castps_si128(_mm_shuffle_ps(
+            _mm_castsi128_ps(xmm_lo), _mm_castsi128_ps(xmm_hi), _MM_SHUFFLE(3,1,3,1)));
+
+        __m128i xmm_res = _mm_srli_epi32(
+            _mm_add_epi32(_mm_add_epi32(xmm_even, xmm_odd), xmm_two32), 2);
+
+        /* SSE2 has no unsigned 32->16 bit pack, so go through signed range */
+        xmm_res = _mm_packs_epi32(_mm_sub_epi32(xmm_res, xmm_bias32),
+                                  _mm_sub_epi32(xmm_res, xmm_bias32));
+        xmm_res = _mm_add_epi16(xmm_res, xmm_bias16);
+        _mm_storel_epi64((__m128i*)(pDst + iDstPixel), xmm_res);
+    }
+
+    GDALAverage2x2LineT<GUInt16, GUInt32>(pSrc, nSrcLineStride, pDst,
+                                          iDstPixel, nDstWidth);
+}
+
+template <>
+inline void GDALAverage2x2Line<float, double>( const float* pSrc,
+                                               int nSrcLineStride,
+                                               float* pDst, int nDstWidth )
+{
+    const __m128d xmm_quarter = _mm_set1_pd(0.25);
+    int iDstPixel = 0;
+
+    for( ; iDstPixel + 2 <= nDstWidth; iDstPixel += 2 )
+    {
+        const __m128 xmm_row0 = _mm_loadu_ps(pSrc + 2 * iDstPixel);
+        const __m128 xmm_row1 = _mm_loadu_ps(pSrc + 2 * iDstPixel + nSrcLineStride);
+
+        const __m128d xmm_row0_01 = _mm_cvtps_pd(xmm_row0);
+        const __m128d xmm_row0_23 = _mm_cvtps_pd(_mm_movehl_ps(xmm_row0, xmm_row0));
+        const __m128d xmm_row1_01 = _mm_cvtps_pd(xmm_row1);
+        const __m128d xmm_row1_23 = _mm_cvtps_pd(_mm_movehl_ps(xmm_row1, xmm_row1));
+
+        /* Same summation order as the generic code : ((0 + a) + b) + c) + d */
+        __m128d xmm_total = _mm_add_pd(_mm_setzero_pd(),
+                                       _mm_unpacklo_pd(xmm_row0_01, xmm_row0_23));
+        xmm_total = _mm_add_pd(xmm_total, _mm_unpackhi_pd(xmm_row0_01, xmm_row0_23));
+        xmm_total = _mm_add_pd(xmm_total, _mm_unpacklo_pd(xmm_row1_01, xmm_row1_23));
+        xmm_total = _mm_add_pd(xmm_total, _mm_unpackhi_pd(xmm_row1_01, xmm_row1_23));
+
+        /* Multiplying by 0.25 is exactly the same as dividing by 4 */
+        const __m128 xmm_res = _mm_cvtpd_ps(_mm_mul_pd(xmm_total, xmm_quarter));
+        _mm_storel_pi((__m64*)(pDst + iDstPixel), xmm_res);
+    }
+
+    GDALAverage2x2LineT<float, double>(pSrc, nSrcLineStride, pDst,
+                                       iDstPixel, nDstWidth);
+}
+
+#endif /* USE_SSE2 */
+
+/************************************************************************/
+/*                    GDALAverage2x2LineWithMask()                      */
+/************************************************************************/
+
+template <class T, class Tsum>
+static inline void GDALAverage2x2LineWithMask( const T* pSrc,
+                                               const GByte* pabyMask,
+                                               int nSrcLineStride,
+                                               T* pDst, int nDstWidth,
+                                               T tNoDataValue )
+{
+    for( int iDstPixel = 0; iDstPixel < nDstWidth; iDstPixel++ )
+    {
+        const int bValid00 = (pabyMask[0] != 0);
+        const int bValid01 = (pabyMask[1] != 0);
+        const int bValid10 = (pabyMask[nSrcLineStride] != 0);
+        const int bValid11 = (pabyMask[1+nSrcLineStride] != 0);
+        const int nCount = bValid00 + bValid01 + bValid10 + bValid11;
+        Tsum nTotal = 0;
+
+        nTotal += bValid00 ? pSrc[0] : (T)0;
+        nTotal += bValid01 ? pSrc[1] : (T)0;
+        nTotal += bValid10 ? pSrc[nSrcLineStride] : (T)0;
+        nTotal += bValid11 ? pSrc[1+nSrcLineStride] : (T)0;
+
+        if( nCount == 0 )
+            pDst[iDstPixel] = tNoDataValue;
+        else
+            pDst[iDstPixel] = GDALAverageRoundedT<T, Tsum>(nTotal, nCount);
+        pSrc += 2;
+        pabyMask += 2;
+    }
+}
+
 /************************************************************************/
 /*                    GDALResampleChunk32R_Average()                    */
 /************************************************************************/
@@ -243,13 +482,27 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
 
     pDstScanline = (T *) VSIMalloc(nDstXWidth * (GDALGetDataTypeSize(eWrkDataType) / 8));
     int* panSrcXOffShifted = (int*)VSIMalloc(2 * nDstXWidth * sizeof(int));
+    Tsum* pColumnSum = NULL;
+    int* panColumnCount = NULL;
+    const int bUseColumnSums = (poColorTable == NULL &&
+                                GDALAverageSumIsExactT<Tsum>());
+    if( bUseColumnSums )
+    {
+        pColumnSum = (Tsum*)VSIMalloc(nChunkXSize * sizeof(Tsum));
+        if( pabyChunkNodataMask != NULL )
+            panColumnCount = (int*)VSIMalloc(nChunkXSize * sizeof(int));
+    }
 
-    if( pDstScanline == NULL || panSrcXOffShifted == NULL )
+    if( pDstScanline == NULL || panSrcXOffShifted == NULL ||
+        (bUseColumnSums && pColumnSum == NULL) ||
+        (bUseColumnSums && pabyChunkNodataMask != NULL && panColumnCount == NULL) )
     {
         CPLError( CE_Failure, CPLE_OutOfMemory,
                   "GDALResampleChunk32R: Out of memory for line buffer." );
         VSIFree(pDstScanline);
         VSIFree(panSrcXOffShifted);
+        VSIFree(pColumnSum);
+        VSIFree(panColumnCount);
         return CE_Failure;
     }
 
@@ -271,6 +524,7 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
 /* ==================================================================== */
     int iDstPixel;
     int bSrcXSpacingIsTwo = TRUE;
+    int nColStart = nChunkXSize, nColEnd = 0;
     for( iDstPixel = nDstXOff; iDstPixel < nDstXOff2; iDstPixel++ )
     {
         int   nSrcXOff, nSrcXOff2;
@@ -295,6 +549,8 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
         panSrcXOffShifted[2 * (iDstPixel - nDstXOff) + 1] = nSrcXOff2 - nChunkXOff;
         if (nSrcXOff2 - nSrcXOff != 2)
             bSrcXSpacingIsTwo = FALSE;
+        nColStart = MIN(nColStart, nSrcXOff - nChunkXOff);
+        nColEnd = MAX(nColEnd, nSrcXOff2 - nChunkXOff);
     }
 
 /* ==================================================================== */
@@ -327,26 +583,24 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
 /* -------------------------------------------------------------------- */
         if (poColorTable == NULL)
         {
-            if (bSrcXSpacingIsTwo && nSrcYOff2 == nSrcYOff + 2 &&
-                pabyChunkNodataMask == NULL && (eWrkDataType == GDT_Byte || eWrkDataType == GDT_UInt16))
+            if (bSrcXSpacingIsTwo && nSrcYOff2 == nSrcYOff + 2)
             {
-                /* Optimized case : no nodata, overview by a factor of 2 and regular x and y src spacing */
-                T* pSrcScanlineShifted = pChunk + panSrcXOffShifted[0] + (nSrcYOff - nChunkYOff) * nChunkXSize;
-                for( iDstPixel = 0; iDstPixel < nDstXWidth; iDstPixel++ )
-                {
-                    Tsum nTotal;
-
-                    nTotal = pSrcScanlineShifted[0];
-                    nTotal += pSrcScanlineShifted[1];
-                    nTotal += pSrcScanlineShifted[nChunkXSize];
-                    nTotal += pSrcScanlineShifted[1+nChunkXSize];
-
-                    pDstScanline[iDstPixel] = (T) ((nTotal + 2) / 4);
-                    pSrcScanlineShifted += 2;
-                }
+                /* Optimized case : overview by a factor of 2 and regular x and y src spacing */
+                const int nSrcOffset = panSrcXOffShifted[0] + (nSrcYOff - nChunkYOff) * nChunkXSize;
+                if( pabyChunkNodataMask == NULL )
+                    GDALAverage2x2Line<T, Tsum>(pChunk + nSrcOffset, nChunkXSize,
+                                                pDstScanline, nDstXWidth);
+                else
+                    GDALAverage2x2LineWithMask<T, Tsum>(pChunk + nSrcOffset,
+                                                        pabyChunkNodataMask + nSrcOffset,
+                                                        nChunkXSize,
+                                                        pDstScanline, nDstXWidth,
+                                                        tNoDataValue);
             }
-            else
+            else if( !bUseColumnSums )
             {
+                /* Floating point sums depend on the order of the additions, */
+                /* so the pixels of each window are added row by row.        */
                 nSrcYOff -= nChunkYOff;
                 nSrcYOff2 -= nChunkYOff;
 
@@ -355,7 +609,6 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
                     int  nSrcXOff = panSrcXOffShifted[2 * iDstPixel],
                          nSrcXOff2 = panSrcXOffShifted[2 * iDstPixel + 1];
 
-                    T val;
                     Tsum dfTotal = 0;
                     int    nCount = 0, iX, iY;
 
@@ -363,11 +616,10 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
                     {
                         for( iX = nSrcXOff; iX < nSrcXOff2; iX++ )
                         {
-                            val = pChunk[iX + iY *nChunkXSize];
                             if (pabyChunkNodataMask == NULL ||
                                 pabyChunkNodataMask[iX + iY *nChunkXSize])
                             {
-                                dfTotal += val;
+                                dfTotal += pChunk[iX + iY *nChunkXSize];
                                 nCount++;
                             }
                         }
@@ -375,10 +627,76 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
 
                     if( nCount == 0 )
                         pDstScanline[iDstPixel] = tNoDataValue;
-                    else if (eWrkDataType == GDT_Byte || eWrkDataType == GDT_UInt16)
-                        pDstScanline[iDstPixel] = (T) ((dfTotal + nCount / 2) / nCount);
                     else
-                        pDstScanline[iDstPixel] = (T) (dfTotal / nCount);
+                        pDstScanline[iDstPixel] = GDALAverageRoundedT<T, Tsum>(dfTotal, nCount);
+                }
+            }
+            else
+            {
+                nSrcYOff -= nChunkYOff;
+                nSrcYOff2 -= nChunkYOff;
+
+                /* First sum the source rows column by column (and count the */
+                /* valid pixels), which is a simple loop the compiler can    */
+                /* vectorize, and then sum the columns of each window.       */
+                int iX, iY;
+
+                for( iX = nColStart; iX < nColEnd; iX++ )
+                    pColumnSum[iX] = 0;
+                if( pabyChunkNodataMask != NULL )
+                {
+                    for( iX = nColStart; iX < nColEnd; iX++ )
+                        panColumnCount[iX] = 0;
+                }
+
+                for( iY = nSrcYOff; iY < nSrcYOff2; iY++ )
+                {
+                    const T* pSrcLine = pChunk + iY * nChunkXSize;
+                    if( pabyChunkNodataMask == NULL )
+                    {
+                        for( iX = nColStart; iX < nColEnd; iX++ )
+                            pColumnSum[iX] += pSrcLine[iX];
+                    }
+                    else
+                    {
+                        const GByte* pabyMaskLine = pabyChunkNodataMask + iY * nChunkXSize;
+                        for( iX = nColStart; iX < nColEnd; iX++ )
+                        {
+                            /* Branchless on purpose: nodata pixels are often */
+                            /* scattered, which defeats branch prediction.    */
+                            const int bValid = (pabyMaskLine[iX] != 0);
+                            pColumnSum[iX] += bValid ? pSrcLine[iX] : (T)0;
+                            panColumnCount[iX] += bValid;
+                        }
+                    }
+                }
+
+                for( iDstPixel = 0; iDstPixel < nDstXWidth; iDstPixel++ )
+                {
+                    int  nSrcXOff = panSrcXOffShifted[2 * iDstPixel],
+                         nSrcXOff2 = panSrcXOffShifted[2 * iDstPixel + 1];
+
+                    Tsum dfTotal = 0;
+                    int    nCount = 0;
+
+                    for( iX = nSrcXOff; iX < nSrcXOff2; iX++ )
+                        dfTotal += pColumnSum[iX];
+
+                    if( pabyChunkNodataMask == NULL )
+                    {
+                        if( nSrcYOff2 > nSrcYOff && nSrcXOff2 > nSrcXOff )
+                            nCount = (nSrcXOff2 - nSrcXOff) * (nSrcYOff2 - nSrcYOff);
+                    }
+                    else
+                    {
+                        for( iX = nSrcXOff; iX < nSrcXOff2; iX++ )
+                            nCount += panColumnCount[iX];
+                    }
+
+                    if( nCount == 0 )
+                        pDstScanline[iDstPixel] = tNoDataValue;
+                    else
+                        pDstScanline[iDstPixel] = GDALAverageRoundedT<T, Tsum>(dfTotal, nCount);
                 }
             }
         }
@@ -436,6 +754,8 @@ GDALResampleChunk32R_AverageT( double dfXRatioDstToSrc,
     CPLFree( pDstScanline );
     CPLFree( aEntries );
     CPLFree( panSrcXOffShifted );
+    CPLFree( pColumnSum );
+    CPLFree( panColumnCount );
 
     return eErr;
 }
@@ -501,6 +821,45 @@ GDALResampleChunk32R_Average( double dfXRatioDstToSrc, double dfYRatioDstToSrc,
     return CE_Failure;
 }
 
+#ifdef USE_SSE2
+
+/************************************************************************/
+/*                  GDALGaussFullWindow2PixelsSSE2()                    */
+/*                                                                      */
+/*      Compute two destination pixels whose gauss windows are fully    */
+/*      inside the chunk and that have no nodata, one per SSE2 lane.    */
+/*      Operations are done in the same order as in the generic code,   */
+/*      so that results are identical.                                  */
+/************************************************************************/
+
+static inline void GDALGaussFullWindow2PixelsSSE2( const float* pafSrc1,
+                                                   const float* pafSrc2,
+                                                   int nSrcLineStride,
+                                                   const int* panGaussMatrix,
+                                                   int nGaussMatrixDim,
+                                                   int nWeightSum,
+                                                   float* pafDst )
+{
+    __m128d xmm_total = _mm_setzero_pd();
+    for( int j = 0; j < nGaussMatrixDim; j++ )
+    {
+        for( int i = 0; i < nGaussMatrixDim; i++ )
+        {
+            const __m128d xmm_val = _mm_set_pd(pafSrc2[i], pafSrc1[i]);
+            const __m128d xmm_weight = _mm_set1_pd((double)panGaussMatrix[i]);
+            xmm_total = _mm_add_pd(xmm_total, _mm_mul_pd(xmm_val, xmm_weight));
+        }
+        pafSrc1 += nSrcLineStride;
+        pafSrc2 += nSrcLineStride;
+        panGaussMatrix += nGaussMatrixDim;
+    }
+    const __m128 xmm_res =
+        _mm_cvtpd_ps(_mm_div_pd(xmm_total, _mm_set1_pd((double)nWeightSum)));
+    _mm_storel_pi((__m64*)pafDst, xmm_res);
+}
+
+#endif /* USE_SSE2 */
+
 /************************************************************************/
 /*                    GDALResampleChunk32R_Gauss()                      */
 /************************************************************************/
@@ -575,14 +934,22 @@ GDALResampleChunk32R_Gauss( double dfXRatioDstToSrc, double dfYRatioDstToSrc,
         nGaussMatrixDim=7;
     }
 
-    pafDstScanline = (float *) VSIMalloc((nDstXOff2 - nDstXOff) * sizeof(float));
-    if( pafDstScanline == NULL )
+    int nDstXWidth = nDstXOff2 - nDstXOff;
+    pafDstScanline = (float *) VSIMalloc(nDstXWidth * sizeof(float));
+    int* panSrcXOffGauss = (int *) VSIMalloc(3 * nDstXWidth * sizeof(int));
+    if( pafDstScanline == NULL || panSrcXOffGauss == NULL )
     {
         CPLError( CE_Failure, CPLE_OutOfMemory,
                   "GDALResampleChunk32R: Out of memory for line buffer." );
+        VSIFree(pafDstScanline);
+        VSIFree(panSrcXOffGauss);
         return CE_Failure;
     }
 
+    int nGaussWeightSum = 0;
+    for( int i = 0; i < nGaussMatrixDim * nGaussMatrixDim; i++ )
+        nGaussWeightSum += panGaussMatrix[i];
+
     int nEntryCount = 0;
     GDALColorEntry* aEntries = NULL;
     if (poColorTable)
@@ -599,6 +966,36 @@ GDALResampleChunk32R_Gauss( double dfXRatioDstToSrc, double dfYRatioDstToSrc,
     int nChunkRightXOff = nChunkXOff + nChunkXSize;
     int nChunkBottomYOff = nChunkYOff + nChunkYSize;
 
+/* ==================================================================== */
+/*      Precompute source windows in the x direction, which are the     */
+/*      same for all destination scanlines.                             */
+/* ==================================================================== */
+    int iDstPixel;
+    for( iDstPixel = nDstXOff; iDstPixel < nDstXOff2; iDstPixel++ )
+    {
+        int   nSrcXOff, nSrcXOff2;
+
+        nSrcXOff = (int) (0.5 + iDstPixel * dfXRatioDstToSrc);
+        nSrcXOff2 = (int)(0.5 + (iDstPixel+1) * dfXRatioDstToSrc) + 1;
+
+        int iSizeX = nSrcXOff2 - nSrcXOff;
+        nSrcXOff = nSrcXOff + iSizeX/2 - nGaussMatrixDim/2;
+        nSrcXOff2 = nSrcXOff + nGaussMatrixDim;
+        int nXShiftGaussMatrix = 0;
+        if(nSrcXOff < 0)
+        {
+            nXShiftGaussMatrix = -nSrcXOff;
+            nSrcXOff = 0;
+        }
+
+        if( nSrcXOff2 > nChunkRightXOff || (dfXRatioDstToSrc > 1 && iDstPixel == nOXSize-1) )
+            nSrcXOff2 = nChunkRightXOff;
+
+        panSrcXOffGauss[3 * (iDstPixel - nDstXOff)] = nSrcXOff;
+        panSrcXOffGauss[3 * (iDstPixel - nDstXOff) + 1] = nSrcXOff2;
+        panSrcXOffGauss[3 * (iDstPixel - nDstXOff) + 2] = nXShiftGaussMatrix;
+    }
+
 /* ==================================================================== */
 /*      Loop over destination scanlines.                                */
 /* ==================================================================== */
@@ -606,7 +1003,7 @@ GDALResampleChunk32R_Gauss( double dfXRatioDstToSrc, double dfYRatioDstToSrc,
     {
         float *pafSrcScanline;
         GByte *pabySrcScanlineNodataMask;
-        int   nSrcYOff, nSrcYOff2 = 0, iDstPixel;
+        int   nSrcYOff, nSrcYOff2 = 0;
 
         nSrcYOff = (int) (0.5 + iDstLine * dfYRatioDstToSrc);
         nSrcYOff2 = (int) (0.5 + (iDstLine+1) * dfYRatioDstToSrc) + 1;
@@ -637,28 +1034,41 @@ GDALResampleChunk32R_Gauss( double dfXRatioDstToSrc, double dfYRatioDstToSrc,
         else
             pabySrcScanlineNodataMask = NULL;
 
+#ifdef USE_SSE2
+        /* Can we use the SSE2 code path for pixels of this line ? */
+        int bFullWindowLine = ( poColorTable == NULL &&
+                                pabySrcScanlineNodataMask == NULL &&
+                                nYShiftGaussMatrix == 0 &&
+                                nSrcYOff2 - nSrcYOff == nGaussMatrixDim );
+#endif
+
 /* -------------------------------------------------------------------- */
 /*      Loop over destination pixels                                    */
 /* -------------------------------------------------------------------- */
         for( iDstPixel = nDstXOff; iDstPixel < nDstXOff2; iDstPixel++ )
         {
-            int   nSrcXOff, nSrcXOff2;
+            const int* panSrcXOffThis = panSrcXOffGauss + 3 * (iDstPixel - nDstXOff);
+            int   nSrcXOff = panSrcXOffThis[0];
+            int   nSrcXOff2 = panSrcXOffThis[1];
+            int   nXShiftGaussMatrix = panSrcXOffThis[2];
 
-            nSrcXOff = (int) (0.5 + iDstPixel * dfXRatioDstToSrc);
-            nSrcXOff2 = (int)(0.5 + (iDstPixel+1) * dfXRatioDstToSrc) + 1;
-
-            int iSizeX = nSrcXOff2 - nSrcXOff;
-            nSrcXOff = nSrcXOff + iSizeX/2 - nGaussMatrixDim/2;
-            nSrcXOff2 = nSrcXOff + nGaussMatrixDim;
-            int nXShiftGaussMatrix = 0;
-            if(nSrcXOff < 0)
+#ifdef USE_SSE2
+            if( bFullWindowLine && iDstPixel + 1 < nDstXOff2 &&
+                nXShiftGaussMatrix == 0 &&
+                nSrcXOff2 - nSrcXOff == nGaussMatrixDim &&
+                panSrcXOffThis[5] == 0 &&
+                panSrcXOffThis[4] - panSrcXOffThis[3] == nGaussMatrixDim )
             {
-                nXShiftGaussMatrix = -nSrcXOff;
-                nSrcXOff = 0;
+                GDALGaussFullWindow2PixelsSSE2(
+                    pafSrcScanline + nSrcXOff - nChunkXOff,
+                    pafSrcScanline + panSrcXOffThis[3] - nChunkXOff,
+                    nChunkXSize, panGaussMatrix, nGaussMatrixDim,
+                    nGaussWeightSum,
+                    pafDstScanline + iDstPixel - nDstXOff );
+                iDstPixel ++;
+                continue;
             }
-
-            if( nSrcXOff2 > nChunkRightXOff || (dfXRatioDstToSrc > 1 && iDstPixel == nOXSize-1) )
-                nSrcXOff2 = nChunkRightXOff;
+#endif
 
             if (poColorTable == NULL)
             {
@@ -748,13 +1158,14 @@ GDALResampleChunk32R_Gauss( double dfXRatioDstToSrc, double dfYRatioDstToSrc,
 
         }
 
-        eErr = poOverview->RasterIO( GF_Write, nDstXOff, iDstLine, nDstXOff2 - nDstXOff, 1,
-                                     pafDstScanline, nDstXOff2 - nDstXOff, 1, GDT_Float32,
+        eErr = poOverview->RasterIO( GF_Write, nDstXOff, iDstLine, nDstXWidth, 1,
+                                     pafDstScanline, nDstXWidth, 1, GDT_Float32,
                                      0, 0, NULL );
     }
 
     CPLFree( pafDstScanline );
     CPLFree( aEntries );
+    CPLFree( panSrcXOffGauss );
 
     return eErr;
 }
@@ -1126,14 +1537,7 @@ template<class T> static inline void GDALResampleConvolutionVertical_2cols(
     dfRes1 = dfVal1 + dfVal2;
     dfRes2 = dfVal3 + dfVal4;
 }
-/* We restrict to 64bit processors because they are guaranteed to have SSE2 */
-/* Could possibly be used too on 32bit, but we would need to check at runtime */
-#if defined(__x86_64) || defined(_M_X64)
-#define USE_SSE2
-#endif
-
 #ifdef USE_SSE2
-#include <gdalsse_priv.h>
 
 /************************************************************************/
 /*              GDALResampleConvolutionHorizontalSSE2<T>                */
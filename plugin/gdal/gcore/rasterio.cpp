@@ -3490,6 +3490,539 @@ static void GDALCopyWholeRasterGetSwathSize(GDALRasterBand *poSrcPrototypeBand,
     *pnSwathLines = nSwathLines;
 }
 
+/************************************************************************/
+/* ==================================================================== */
+/*                       GDALCopyStatsAccumulator                       */
+/*                                                                      */
+/*      Accumulates statistics, and optionally a default histogram,     */
+/*      from the swath buffers written by GDALDatasetCopyWholeRaster()  */
+/*      and GDALRasterBandCopyWholeRaster(), so that they can be set    */
+/*      on the target band without reading it back.                     */
+/* ==================================================================== */
+/************************************************************************/
+
+#define COPY_STATS_HIST_BUCKETS 256
+#define COPY_STATS_FINE_BINS    16384
+
+class GDALCopyStatsAccumulator
+{
+    GDALDataType eDT;
+    int          nStride;
+    int          bSignedByte;
+    int          bGotNoData;
+    double       dfNoData;
+    int          bHistogram;
+
+    /* Exact counts of each value, for 8 and 16 bit integer types. */
+    GUIntBig    *panValueCounts;
+    int          nValueCount;
+    int          nValueOffset;
+
+    /* Running moments, merged swath by swath (Chan et al.) */
+    GUIntBig     nCount;
+    double       dfMin;
+    double       dfMax;
+    double       dfMean;
+    double       dfM2;
+
+    /* Range adaptive fine histogram, rebinned when storing. */
+    GUIntBig    *panFineBins;
+    double       dfFineLo;
+    double       dfFineWidth;
+
+    void         GrowFineHistogram( double dfNewMin, double dfNewMax );
+
+    template<class T> void AccumulateCounts( const T* pData, size_t nValues );
+    template<class T> void AccumulateMoments( const T* pData, size_t nValues );
+
+  public:
+                 GDALCopyStatsAccumulator( GDALRasterBand *poDstBand,
+                                           GDALDataType eBufType,
+                                           int bHistogramIn );
+                ~GDALCopyStatsAccumulator();
+
+    int          IsValid() const;
+    void         Accumulate( const void *pData, size_t nValues );
+    void         Store( GDALRasterBand *poDstBand );
+};
+
+/************************************************************************/
+/*                      GDALCopyStatsAccumulator()                      */
+/************************************************************************/
+
+GDALCopyStatsAccumulator::GDALCopyStatsAccumulator( GDALRasterBand *poDstBand,
+                                                    GDALDataType eBufType,
+                                                    int bHistogramIn ) :
+    eDT(eBufType), nStride(GDALDataTypeIsComplex(eBufType) ? 2 : 1),
+    bSignedByte(FALSE), bGotNoData(FALSE), dfNoData(0.0),
+    bHistogram(bHistogramIn && !GDALDataTypeIsComplex(eBufType)),
+    panValueCounts(NULL), nValueCount(0), nValueOffset(0),
+    nCount(0), dfMin(0.0), dfMax(0.0), dfMean(0.0), dfM2(0.0),
+    panFineBins(NULL), dfFineLo(0.0), dfFineWidth(0.0)
+{
+    dfNoData = poDstBand->GetNoDataValue( &bGotNoData );
+    bGotNoData = bGotNoData && !CPLIsNan(dfNoData);
+
+    const char* pszPixelType =
+        poDstBand->GetMetadataItem("PIXELTYPE", "IMAGE_STRUCTURE");
+    bSignedByte = (pszPixelType != NULL && EQUAL(pszPixelType, "SIGNEDBYTE"));
+
+    switch( eDT )
+    {
+      case GDT_Byte:
+        nValueCount = 256;
+        nValueOffset = bSignedByte ? 128 : 0;
+        break;
+      case GDT_UInt16:
+        nValueCount = 65536;
+        break;
+      case GDT_Int16:
+      case GDT_CInt16:
+        nValueCount = 65536;
+        nValueOffset = 32768;
+        break;
+      default:
+        break;
+    }
+
+    if( nValueCount > 0 )
+        panValueCounts = (GUIntBig *)
+            VSICalloc(sizeof(GUIntBig), nValueCount);
+    else if( bHistogram )
+        panFineBins = (GUIntBig *)
+            VSICalloc(sizeof(GUIntBig), COPY_STATS_FINE_BINS);
+}
+
+/************************************************************************/
+/*                     ~GDALCopyStatsAccumulator()                      */
+/************************************************************************/
+
+GDALCopyStatsAccumulator::~GDALCopyStatsAccumulator()
+{
+    CPLFree( panValueCounts );
+    CPLFree( panFineBins );
+}
+
+/************************************************************************/
+/*                              IsValid()                               */
+/************************************************************************/
+
+int GDALCopyStatsAccumulator::IsValid() const
+{
+    if( nValueCount > 0 )
+        return panValueCounts != NULL;
+    return !bHistogram || panFineBins != NULL;
+}
+
+/************************************************************************/
+/*                          AccumulateCounts()                          */
+/************************************************************************/
+
+template<class T>
+void GDALCopyStatsAccumulator::AccumulateCounts( const T* pData,
+                                                 size_t nValues )
+{
+    for( size_t i = 0; i < nValues; i++ )
+        panValueCounts[(int)pData[i * nStride] + nValueOffset] ++;
+}
+
+/************************************************************************/
+/*                        GrowFineHistogram()                           */
+/*                                                                      */
+/*      Make sure the fine histogram covers [dfNewMin,dfNewMax],        */
+/*      doubling the bin width (merging pairs of bins) as needed.       */
+/************************************************************************/
+
+void GDALCopyStatsAccumulator::GrowFineHistogram( double dfNewMin,
+                                                  double dfNewMax )
+{
+    if( dfFineWidth == 0.0 )
+    {
+        /* All values accumulated so far (if any) are equal to dfMin. */
+        if( dfNewMin == dfNewMax && (nCount == 0 || dfMin == dfNewMin) )
+            return;
+
+        double dfLo = dfNewMin, dfHi = dfNewMax;
+        if( nCount > 0 )
+        {
+            dfLo = MIN(dfLo, dfMin);
+            dfHi = MAX(dfHi, dfMax);
+        }
+        dfFineLo = dfLo;
+        dfFineWidth = (dfHi - dfLo) / COPY_STATS_FINE_BINS;
+        /* Make sure that dfHi itself falls into the last bin. */
+        dfFineWidth *= 1.0 + 1e-10;
+        if( nCount > 0 )
+        {
+            int iBin = (int)((dfMin - dfFineLo) / dfFineWidth);
+            panFineBins[MIN(MAX(iBin, 0), COPY_STATS_FINE_BINS-1)] += nCount;
+        }
+        return;
+    }
+
+    while( dfNewMin < dfFineLo ||
+           dfNewMax >= dfFineLo + dfFineWidth * COPY_STATS_FINE_BINS )
+    {
+        const int nHalf = COPY_STATS_FINE_BINS / 2;
+        int i;
+
+        if( dfNewMin < dfFineLo )
+        {
+            /* Extend downwards: old range becomes the upper half. */
+            for( i = nHalf - 1; i >= 0; i-- )
+                panFineBins[nHalf + i] = panFineBins[2*i] + panFineBins[2*i+1];
+            memset( panFineBins, 0, sizeof(GUIntBig) * nHalf );
+            dfFineLo -= dfFineWidth * COPY_STATS_FINE_BINS;
+        }
+        else
+        {
+            for( i = 0; i < nHalf; i++ )
+                panFineBins[i] = panFineBins[2*i] + panFineBins[2*i+1];
+            memset( panFineBins + nHalf, 0, sizeof(GUIntBig) * nHalf );
+        }
+        dfFineWidth *= 2;
+    }
+}
+
+/************************************************************************/
+/*                       GDALCopyStatsIsFinite()                        */
+/*                                                                      */
+/*      CPLIsFinite() only tests for NaN where isinf() is not a         */
+/*      macro (e.g. once <cmath> is included), so check the range       */
+/*      explicitly.                                                     */
+/************************************************************************/
+
+static int GDALCopyStatsIsFinite( double dfValue )
+{
+    return !CPLIsNan(dfValue) &&
+           fabs(dfValue) <= std::numeric_limits<double>::max();
+}
+
+/************************************************************************/
+/*                         AccumulateMoments()                          */
+/************************************************************************/
+
+template<class T>
+void GDALCopyStatsAccumulator::AccumulateMoments( const T* pData,
+                                                  size_t nValues )
+{
+    GUIntBig nSwathCount = 0;
+    double   dfSwathMin = 0.0, dfSwathMax = 0.0, dfSum = 0.0;
+    size_t   i;
+
+/* -------------------------------------------------------------------- */
+/*      First pass on the swath: count, extent and mean.  NaN and       */
+/*      infinite values are skipped so the fine histogram range         */
+/*      stays finite.                                                   */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < nValues; i++ )
+    {
+        const double dfValue = (double) pData[i * nStride];
+        if( !GDALCopyStatsIsFinite(dfValue) )
+            continue;
+        if( bGotNoData && ARE_REAL_EQUAL(dfValue, dfNoData) )
+            continue;
+
+        if( nSwathCount == 0 )
+            dfSwathMin = dfSwathMax = dfValue;
+        else
+        {
+            dfSwathMin = MIN(dfSwathMin, dfValue);
+            dfSwathMax = MAX(dfSwathMax, dfValue);
+        }
+        dfSum += dfValue;
+        nSwathCount ++;
+    }
+
+    if( nSwathCount == 0 )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Second pass: sum of squared differences to the swath mean,      */
+/*      and histogram binning.                                          */
+/* -------------------------------------------------------------------- */
+    const double dfSwathMean = dfSum / nSwathCount;
+    double       dfSwathM2 = 0.0;
+
+    if( bHistogram )
+        GrowFineHistogram( dfSwathMin, dfSwathMax );
+
+    for( i = 0; i < nValues; i++ )
+    {
+        const double dfValue = (double) pData[i * nStride];
+        if( !GDALCopyStatsIsFinite(dfValue) )
+            continue;
+        if( bGotNoData && ARE_REAL_EQUAL(dfValue, dfNoData) )
+            continue;
+
+        dfSwathM2 += (dfValue - dfSwathMean) * (dfValue - dfSwathMean);
+
+        /* While all values seen are equal, the fine histogram has no */
+        /* range yet: they are binned when it gets one. */
+        if( bHistogram && dfFineWidth > 0.0 )
+        {
+            int iBin = (int)((dfValue - dfFineLo) / dfFineWidth);
+            panFineBins[MIN(MAX(iBin, 0), COPY_STATS_FINE_BINS-1)] ++;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Merge with the running moments.                                 */
+/* -------------------------------------------------------------------- */
+    if( nCount == 0 )
+    {
+        dfMin = dfSwathMin;
+        dfMax = dfSwathMax;
+        dfMean = dfSwathMean;
+        dfM2 = dfSwathM2;
+        nCount = nSwathCount;
+    }
+    else
+    {
+        const double dfDelta = dfSwathMean - dfMean;
+        const double dfTotal = (double) nCount + (double) nSwathCount;
+
+        dfMin = MIN(dfMin, dfSwathMin);
+        dfMax = MAX(dfMax, dfSwathMax);
+        dfMean += dfDelta * nSwathCount / dfTotal;
+        dfM2 += dfSwathM2 + dfDelta * dfDelta * nCount * nSwathCount / dfTotal;
+        nCount += nSwathCount;
+    }
+}
+
+/************************************************************************/
+/*                             Accumulate()                             */
+/************************************************************************/
+
+void GDALCopyStatsAccumulator::Accumulate( const void *pData, size_t nValues )
+{
+    switch( eDT )
+    {
+      case GDT_Byte:
+        if( bSignedByte )
+            AccumulateCounts( (const signed char *) pData, nValues );
+        else
+            AccumulateCounts( (const GByte *) pData, nValues );
+        break;
+      case GDT_UInt16:
+        AccumulateCounts( (const GUInt16 *) pData, nValues );
+        break;
+      case GDT_Int16:
+      case GDT_CInt16:
+        AccumulateCounts( (const GInt16 *) pData, nValues );
+        break;
+      case GDT_UInt32:
+        AccumulateMoments( (const GUInt32 *) pData, nValues );
+        break;
+      case GDT_Int32:
+      case GDT_CInt32:
+        AccumulateMoments( (const GInt32 *) pData, nValues );
+        break;
+      case GDT_Float32:
+      case GDT_CFloat32:
+        AccumulateMoments( (const float *) pData, nValues );
+        break;
+      case GDT_Float64:
+      case GDT_CFloat64:
+        AccumulateMoments( (const double *) pData, nValues );
+        break;
+      default:
+        CPLAssert( FALSE );
+    }
+}
+
+/************************************************************************/
+/*                               Store()                                */
+/*                                                                      */
+/*      Set the accumulated statistics, and the default histogram       */
+/*      if requested, on the target band.  With a PAM band they end     */
+/*      up in the .aux.xml file.                                        */
+/************************************************************************/
+
+void GDALCopyStatsAccumulator::Store( GDALRasterBand *poDstBand )
+{
+/* -------------------------------------------------------------------- */
+/*      Derive the moments from the exact value counts.                 */
+/* -------------------------------------------------------------------- */
+    if( panValueCounts != NULL )
+    {
+        int i;
+
+        for( i = 0; i < nValueCount; i++ )
+        {
+            if( panValueCounts[i] == 0 )
+                continue;
+
+            const double dfValue = i - nValueOffset;
+            if( bGotNoData && ARE_REAL_EQUAL(dfValue, dfNoData) )
+            {
+                panValueCounts[i] = 0;
+                continue;
+            }
+
+            if( nCount == 0 )
+                dfMin = dfValue;
+            dfMax = dfValue;
+            nCount += panValueCounts[i];
+            dfMean += dfValue * panValueCounts[i];
+        }
+        if( nCount > 0 )
+            dfMean /= nCount;
+
+        for( i = 0; i < nValueCount; i++ )
+        {
+            const double dfDelta = (i - nValueOffset) - dfMean;
+            dfM2 += dfDelta * dfDelta * panValueCounts[i];
+        }
+    }
+
+    if( nCount == 0 )
+    {
+        CPLDebug( "GDAL", "No valid pixels written, statistics not set." );
+        return;
+    }
+
+    poDstBand->SetStatistics( dfMin, dfMax, dfMean, sqrt(dfM2 / nCount) );
+
+    if( !bHistogram )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Build the histogram with the same bounds as                     */
+/*      GDALRasterBand::GetDefaultHistogram() would use.                */
+/* -------------------------------------------------------------------- */
+    const int nBuckets = COPY_STATS_HIST_BUCKETS;
+    double dfHistMin, dfHistMax;
+
+    if( eDT == GDT_Byte && !bSignedByte )
+    {
+        dfHistMin = -0.5;
+        dfHistMax = 255.5;
+    }
+    else if( dfMin == dfMax )
+    {
+        dfHistMin = dfMin - 0.5;
+        dfHistMax = dfMax + 0.5;
+    }
+    else
+    {
+        const double dfHalfBucket = (dfMax - dfMin) / (2 * (nBuckets - 1));
+        dfHistMin = dfMin - dfHalfBucket;
+        dfHistMax = dfMax + dfHalfBucket;
+    }
+
+    GUIntBig *panHistogram = (GUIntBig *)
+        VSICalloc(sizeof(GUIntBig), nBuckets);
+    if( panHistogram == NULL )
+        return;
+
+    const double dfScale = nBuckets / (dfHistMax - dfHistMin);
+    const int    nSrcBins = panValueCounts ? nValueCount : COPY_STATS_FINE_BINS;
+    GUIntBig    *panSrcBins = panValueCounts ? panValueCounts : panFineBins;
+
+    if( panValueCounts == NULL && dfFineWidth == 0.0 )
+    {
+        /* Single valued band. */
+        panHistogram[(int) floor((dfMin - dfHistMin) * dfScale)] = nCount;
+    }
+    else
+    {
+        for( int i = 0; i < nSrcBins; i++ )
+        {
+            if( panSrcBins[i] == 0 )
+                continue;
+
+            double dfValue;
+            if( panValueCounts != NULL )
+                dfValue = i - nValueOffset;
+            else
+                dfValue = dfFineLo + (i + 0.5) * dfFineWidth;
+
+            int nIndex = (int) floor((dfValue - dfHistMin) * dfScale);
+            panHistogram[MIN(MAX(nIndex, 0), nBuckets-1)] += panSrcBins[i];
+        }
+    }
+
+    CPLPushErrorHandler( CPLQuietErrorHandler );
+    if( poDstBand->SetDefaultHistogram( dfHistMin, dfHistMax, nBuckets,
+                                        panHistogram ) != CE_None )
+        CPLDebug( "GDAL", "Cannot store default histogram on target band." );
+    CPLPopErrorHandler();
+    CPLErrorReset();
+
+    CPLFree( panHistogram );
+}
+
+/************************************************************************/
+/*                    GDALCreateCopyStatsAccumulators()                 */
+/*                                                                      */
+/*      Instantiate one accumulator per target band if the copy         */
+/*      options request it.  Returns NULL if no statistics are to be    */
+/*      collected.                                                      */
+/************************************************************************/
+
+static GDALCopyStatsAccumulator **
+GDALCreateCopyStatsAccumulators( char **papszOptions, int nBandCount,
+                                 GDALRasterBand **papoDstBands,
+                                 GDALDataType eBufType )
+{
+    int bHistogram = CSLFetchBoolean( papszOptions, "COMPUTE_HISTOGRAM", FALSE );
+    if( !bHistogram
+        && !CSLFetchBoolean( papszOptions, "COMPUTE_STATISTICS", FALSE ) )
+        return NULL;
+
+    GDALCopyStatsAccumulator **papoAccumulators =
+        (GDALCopyStatsAccumulator **)
+            CPLCalloc(sizeof(GDALCopyStatsAccumulator*), nBandCount);
+
+    for( int iBand = 0; iBand < nBandCount; iBand++ )
+    {
+        /* The swath buffer is in eBufType.  Skip bands storing another */
+        /* data type since the written values may differ from the ones  */
+        /* we would see. */
+        if( papoDstBands[iBand]->GetRasterDataType() != eBufType )
+        {
+            CPLDebug( "GDAL", "Band %d: data type differs from swath buffer, "
+                      "statistics not computed during copy.", iBand + 1 );
+            continue;
+        }
+
+        papoAccumulators[iBand] =
+            new GDALCopyStatsAccumulator( papoDstBands[iBand], eBufType,
+                                          bHistogram );
+        if( !papoAccumulators[iBand]->IsValid() )
+        {
+            delete papoAccumulators[iBand];
+            papoAccumulators[iBand] = NULL;
+        }
+    }
+
+    return papoAccumulators;
+}
+
+/************************************************************************/
+/*                   GDALDestroyCopyStatsAccumulators()                 */
+/************************************************************************/
+
+static void
+GDALDestroyCopyStatsAccumulators( GDALCopyStatsAccumulator **papoAccumulators,
+                                  int nBandCount,
+                                  GDALRasterBand **papoDstBands, int bStore )
+{
+    if( papoAccumulators == NULL )
+        return;
+
+    for( int iBand = 0; iBand < nBandCount; iBand++ )
+    {
+        if( papoAccumulators[iBand] == NULL )
+            continue;
+        if( bStore )
+            papoAccumulators[iBand]->Store( papoDstBands[iBand] );
+        delete papoAccumulators[iBand];
+    }
+    CPLFree( papoAccumulators );
+}
+
 /************************************************************************/
 /*                     GDALDatasetCopyWholeRaster()                     */
 /************************************************************************/
@@ -3512,6 +4045,17 @@ static void GDALCopyWholeRasterGetSwathSize(GDALRasterBand *poSrcPrototypeBand,
  * on target dataset block sizes to achieve best compression.  More options may be supported in
  * the future.  
  *
+ * Starting with GDAL 2.0, "COMPUTE_STATISTICS=YES" can be specified to
+ * accumulate the minimum, maximum, mean and standard deviation of each
+ * target band from the buffers being written, and set them with
+ * GDALRasterBand::SetStatistics() once the copy is complete.
+ * "COMPUTE_HISTOGRAM=YES" does the same and also sets the default histogram
+ * (256 buckets, same bounds as GDALRasterBand::GetDefaultHistogram()) with
+ * GDALRasterBand::SetDefaultHistogram().  This avoids reading the target
+ * dataset again with ComputeStatistics().  The histogram is exact for 8 and
+ * 16 bit integer data types, and approximated from a fine grained histogram
+ * for other data types. No histogram is computed for complex data types.
+ *
  * @param hSrcDS the source dataset
  * @param hDstDS the destination dataset
  * @param papszOptions transfer hints in "StringList" Name=Value format.
@@ -3634,6 +4178,18 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
             "GDALDatasetCopyWholeRaster(): %d*%d swaths, bInterleave=%d", 
             nSwathCols, nSwathLines, bInterleave );
 
+/* -------------------------------------------------------------------- */
+/*      Do we want to compute statistics on the fly?                    */
+/* -------------------------------------------------------------------- */
+    GDALRasterBand **papoDstBands = (GDALRasterBand **)
+        CPLMalloc(sizeof(GDALRasterBand*) * nBandCount);
+    for( int iBand = 0; iBand < nBandCount; iBand++ )
+        papoDstBands[iBand] = poDstDS->GetRasterBand( iBand + 1 );
+
+    GDALCopyStatsAccumulator **papoStats =
+        GDALCreateCopyStatsAccumulators( papszOptions, nBandCount,
+                                         papoDstBands, eDT );
+
     if( nSwathCols == nXSize && poSrcDS->GetDriver() != NULL &&
         EQUAL(poSrcDS->GetDriver()->GetDescription(), "ECW") )
     {
@@ -3696,6 +4252,11 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
                                                 pSwathBuf, nThisCols, nThisLines, 
                                                 eDT, 1, &nBand,
                                                 0, 0, 0, NULL );
+
+                    if( eErr == CE_None && papoStats != NULL
+                        && papoStats[iBand] != NULL )
+                        papoStats[iBand]->Accumulate(
+                            pSwathBuf, (size_t)nThisCols * nThisLines );
                     nBlocksDone ++;
                     if( eErr == CE_None 
                         && !pfnProgress( nBlocksDone / (double)nTotalBlocks,
@@ -3762,6 +4323,19 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
                                             eDT, nBandCount, NULL, 
                                             0, 0, 0, NULL );
 
+                /* With default spacings the buffer is band sequential. */
+                for( int iBand = 0; eErr == CE_None && papoStats != NULL
+                                    && iBand < nBandCount; iBand++ )
+                {
+                    if( papoStats[iBand] == NULL )
+                        continue;
+                    const size_t nBandValues = (size_t)nThisCols * nThisLines;
+                    papoStats[iBand]->Accumulate(
+                        (GByte *) pSwathBuf
+                            + iBand * nBandValues * (GDALGetDataTypeSize(eDT) / 8),
+                        nBandValues );
+                }
+
                 nBlocksDone ++;
                 if( eErr == CE_None 
                     && !pfnProgress( nBlocksDone / (double)nTotalBlocks,
@@ -3778,6 +4352,9 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
 /* -------------------------------------------------------------------- */
 /*      Cleanup                                                         */
 /* -------------------------------------------------------------------- */
+    GDALDestroyCopyStatsAccumulators( papoStats, nBandCount, papoDstBands,
+                                      eErr == CE_None );
+    CPLFree( papoDstBands );
     CPLFree( pSwathBuf );
 
     return eErr;
@@ -3803,6 +4380,9 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
  * force alignment on target dataset block sizes to achieve best compression.
  * More options may be supported in the future.
  *
+ * Starting with GDAL 2.0, "COMPUTE_STATISTICS=YES" and "COMPUTE_HISTOGRAM=YES"
+ * are also supported, with the same meaning as in GDALDatasetCopyWholeRaster().
+ *
  * @param hSrcBand the source band
  * @param hDstBand the destination band
  * @param papszOptions transfer hints in "StringList" Name=Value format.
@@ -3888,6 +4468,9 @@ CPLErr CPL_STDCALL GDALRasterBandCopyWholeRaster(
             "GDALRasterBandCopyWholeRaster(): %d*%d swaths",
             nSwathCols, nSwathLines );
 
+    GDALCopyStatsAccumulator **papoStats =
+        GDALCreateCopyStatsAccumulators( papszOptions, 1, &poDstBand, eDT );
+
 /* ==================================================================== */
 /*      Band oriented (uninterleaved) case.                             */
 /* ==================================================================== */
@@ -3919,6 +4502,10 @@ CPLErr CPL_STDCALL GDALRasterBandCopyWholeRaster(
                                         pSwathBuf, nThisCols, nThisLines,
                                         eDT, 0, 0, NULL );
 
+            if( eErr == CE_None && papoStats != NULL && papoStats[0] != NULL )
+                papoStats[0]->Accumulate( pSwathBuf,
+                                          (size_t)nThisCols * nThisLines );
+
             if( eErr == CE_None
                 && !pfnProgress(
                     (iY+nThisLines) / (float) (nYSize),
@@ -3934,6 +4521,8 @@ CPLErr CPL_STDCALL GDALRasterBandCopyWholeRaster(
 /* -------------------------------------------------------------------- */
 /*      Cleanup                                                         */
 /* -------------------------------------------------------------------- */
+    GDALDestroyCopyStatsAccumulators( papoStats, 1, &poDstBand,
+                                      eErr == CE_None );
     CPLFree( pSwathBuf );
 
     return eErr;
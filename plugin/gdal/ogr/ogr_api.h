@@ -245,11 +245,13 @@ typedef struct OGRFieldDefnHS   *OGRFieldDefnH;
 typedef struct OGRFeatureDefnHS *OGRFeatureDefnH;
 typedef struct OGRFeatureHS     *OGRFeatureH;
 typedef struct OGRStyleTableHS *OGRStyleTableH;
+typedef struct OGRFeatureBatchHS *OGRFeatureBatchH;
 #else
 typedef void *OGRFieldDefnH;
 typedef void *OGRFeatureDefnH;
 typedef void *OGRFeatureH;
 typedef void *OGRStyleTableH;
+typedef void *OGRFeatureBatchH;
 #endif
 typedef struct OGRGeomFieldDefnHS *OGRGeomFieldDefnH;
 
@@ -351,6 +353,7 @@ OGRErr CPL_DLL OGR_F_SetGeometry( OGRFeatureH, OGRGeometryH );
 OGRGeometryH CPL_DLL OGR_F_GetGeometryRef( OGRFeatureH );
 OGRGeometryH CPL_DLL OGR_F_StealGeometry( OGRFeatureH );
 OGRFeatureH CPL_DLL OGR_F_Clone( OGRFeatureH );
+void   CPL_DLL OGR_F_Reset( OGRFeatureH );
 int    CPL_DLL OGR_F_Equal( OGRFeatureH, OGRFeatureH );
 
 int    CPL_DLL OGR_F_GetFieldCount( OGRFeatureH );
@@ -419,6 +422,20 @@ OGRStyleTableH CPL_DLL OGR_F_GetStyleTable( OGRFeatureH );
 void   CPL_DLL OGR_F_SetStyleTableDirectly( OGRFeatureH, OGRStyleTableH );
 void   CPL_DLL OGR_F_SetStyleTable( OGRFeatureH, OGRStyleTableH );
 
+/* OGRFeatureBatch */
+
+OGRFeatureBatchH CPL_DLL OGR_FB_Create( OGRFeatureDefnH ) CPL_WARN_UNUSED_RESULT;
+void   CPL_DLL OGR_FB_Destroy( OGRFeatureBatchH );
+int    CPL_DLL OGR_FB_GetFeatureCount( OGRFeatureBatchH );
+const GIntBig CPL_DLL *OGR_FB_GetFIDs( OGRFeatureBatchH );
+const GByte CPL_DLL *OGR_FB_GetFieldValidity( OGRFeatureBatchH, int );
+const void CPL_DLL *OGR_FB_GetFieldValues( OGRFeatureBatchH, int );
+const GIntBig CPL_DLL *OGR_FB_GetFieldOffsets( OGRFeatureBatchH, int );
+const GByte CPL_DLL *OGR_FB_GetFieldData( OGRFeatureBatchH, int );
+const GByte CPL_DLL *OGR_FB_GetGeomFieldValidity( OGRFeatureBatchH, int );
+const GIntBig CPL_DLL *OGR_FB_GetGeomFieldOffsets( OGRFeatureBatchH, int );
+const GByte CPL_DLL *OGR_FB_GetGeomFieldData( OGRFeatureBatchH, int );
+
 void   CPL_DLL OGR_F_FillUnsetWithDefault( OGRFeatureH hFeat,
                                            int bNotNullableOnly,
                                            char** papszOptions );
@@ -454,10 +471,13 @@ void     CPL_DLL OGR_L_SetSpatialFilterRectEx( OGRLayerH, int iGeomField,
 OGRErr CPL_DLL OGR_L_SetAttributeFilter( OGRLayerH, const char * );
 void   CPL_DLL OGR_L_ResetReading( OGRLayerH );
 OGRFeatureH CPL_DLL OGR_L_GetNextFeature( OGRLayerH );
+int    CPL_DLL OGR_L_GetNextFeatureInto( OGRLayerH, OGRFeatureH );
+int    CPL_DLL OGR_L_GetNextFeatureBatch( OGRLayerH, OGRFeatureBatchH, int );
 OGRErr CPL_DLL OGR_L_SetNextByIndex( OGRLayerH, GIntBig );
 OGRFeatureH CPL_DLL OGR_L_GetFeature( OGRLayerH, GIntBig );
 OGRErr CPL_DLL OGR_L_SetFeature( OGRLayerH, OGRFeatureH );
 OGRErr CPL_DLL OGR_L_CreateFeature( OGRLayerH, OGRFeatureH );
+OGRErr CPL_DLL OGR_L_CreateFeatures( OGRLayerH, OGRFeatureH *, int );
 OGRErr CPL_DLL OGR_L_DeleteFeature( OGRLayerH, GIntBig );
 OGRFeatureDefnH CPL_DLL OGR_L_GetLayerDefn( OGRLayerH );
 OGRSpatialReferenceH CPL_DLL OGR_L_GetSpatialRef( OGRLayerH );
@@ -35,6 +35,8 @@
 #include "ogr_featurestyle.h"
 #include "cpl_atomic_ops.h"
 
+#include <vector>
+
 /**
  * \file ogr_feature.h
  *
@@ -269,7 +271,18 @@ class CPL_DLL OGRFeature
     GIntBig              nFID;
     OGRFeatureDefn      *poDefn;
     OGRGeometry        **papoGeometries;
+    OGRLazyGeometry    **papoLazyGeometries;
     OGRField            *pauFields;
+    char               **papszSpareStrings;
+    int                  nSpareStringCount;
+
+    char               *DupFieldString( int iField, const char *pszValue );
+    void                FreeSpareStrings();
+    void                MaterializeGeomField( int iField );
+    void                FreeLazyGeometry( int iField );
+    void                SetGeomFieldFrom( int iField,
+                                          OGRFeature *poSrcFeature,
+                                          int iSrcField );
 
   protected: 
     char *              m_pszStyleString;
@@ -281,6 +294,8 @@ class CPL_DLL OGRFeature
     virtual            ~OGRFeature();                        
 
     OGRFeatureDefn     *GetDefnRef() { return poDefn; }
+
+    void                Reset();
     
     OGRErr              SetGeometryDirectly( OGRGeometry * );
     OGRErr              SetGeometry( OGRGeometry * );
@@ -300,6 +315,10 @@ class CPL_DLL OGRFeature
     OGRErr              SetGeomFieldDirectly( int iField, OGRGeometry * );
     OGRErr              SetGeomField( int iField, OGRGeometry * );
 
+    OGRLazyGeometry    *GetGeomFieldLazyRef( int iField );
+    OGRErr              SetGeomFieldLazyDirectly( int iField,
+                                                  OGRLazyGeometry * );
+
     OGRFeature         *Clone();
     virtual OGRBoolean  Equal( OGRFeature * poFeature );
 
@@ -429,6 +448,97 @@ class CPL_DLL OGRFeature
     static void         DestroyFeature( OGRFeature * );
 };
 
+/************************************************************************/
+/*                            OGRFeatureBatch                           */
+/************************************************************************/
+
+#ifndef DOXYGEN_SKIP
+class OGRFeatureBatchColumn
+{
+  public:
+    int                  nValueSize; /* 0 for variable length values */
+    std::vector<GByte>   abyValidity;
+    std::vector<GByte>   abyValues;
+    std::vector<GIntBig> anOffsets;
+    std::vector<GByte>   abyData;
+};
+#endif
+
+/**
+ * A set of features stored column by column, as filled by
+ * OGRLayer::GetNextFeatureBatch().
+ *
+ * Each attribute field is a column with a validity bitmap (bit i, least
+ * significant bit first, is set if the field of the i-th feature is set)
+ * and either an array of fixed size values (OFTInteger as int,
+ * OFTInteger64 as GIntBig, OFTReal as double, OFTDate, OFTTime and
+ * OFTDateTime as OGRField with the Date member set), or GetFeatureCount()+1
+ * byte offsets into a data buffer for the variable length types (strings
+ * without their nul terminator, binary content, packed list elements, and
+ * nul terminated strings for OFTStringList). Geometry fields are stored as
+ * WKB blobs with offsets: little endian ISO WKB when converted from an
+ * OGRGeometry, or the WKB stored by the data source.
+ *
+ * @since GDAL 2.0
+ */
+
+class CPL_DLL OGRFeatureBatch
+{
+  private:
+    OGRFeatureDefn      *poDefn;
+    int                  nFeatureCount;
+    std::vector<GIntBig> anFIDs;
+    std::vector<OGRFeatureBatchColumn> aoFields;
+    std::vector<OGRFeatureBatchColumn> aoGeomFields;
+    OGRFeature          *poConversionFeature;
+
+    void                SetValid( OGRFeatureBatchColumn& oColumn );
+    void                SetFixedValue( int iField, const void* pValue );
+    GByte              *AllocVarValue( OGRFeatureBatchColumn& oColumn,
+                                       size_t nSize );
+    void                SetVarValue( OGRFeatureBatchColumn& oColumn,
+                                     const void* pData, size_t nSize );
+    OGRFeature         *GetConversionFeature();
+    void                SetFieldFromConversionFeature( int iField );
+
+  public:
+                        OGRFeatureBatch( OGRFeatureDefn * );
+                       ~OGRFeatureBatch();
+
+    OGRFeatureDefn     *GetDefnRef() { return poDefn; }
+    void                Reset( OGRFeatureDefn *poNewDefn = NULL );
+
+    int                 GetFeatureCount() const { return nFeatureCount; }
+    const GIntBig      *GetFIDs() const;
+
+    const GByte        *GetFieldValidity( int iField ) const;
+    const void         *GetFieldValues( int iField ) const;
+    const GIntBig      *GetFieldOffsets( int iField ) const;
+    const GByte        *GetFieldData( int iField ) const;
+    int                 IsFieldSet( int iFeature, int iField ) const;
+
+    const GByte        *GetGeomFieldValidity( int iGeomField ) const;
+    const GIntBig      *GetGeomFieldOffsets( int iGeomField ) const;
+    const GByte        *GetGeomFieldData( int iGeomField ) const;
+
+    OGRFeature         *GetFeature( int iFeature );
+
+    void                BeginFeature( GIntBig nFID );
+    void                AddFeature( OGRFeature *poFeature );
+    void                SetFieldInteger( int iField, int nValue );
+    void                SetFieldInteger64( int iField, GIntBig nValue );
+    void                SetFieldDouble( int iField, double dfValue );
+    void                SetFieldString( int iField, const char *pszValue,
+                                        int nLength = -1 );
+    void                SetFieldBinary( int iField, const GByte *pabyData,
+                                        int nBytes );
+    void                SetFieldFromString( int iField, const char *pszValue );
+    void                SetFieldRaw( int iField, const OGRField *psField );
+    void                SetGeomFieldWKB( int iGeomField, const GByte *pabyWKB,
+                                         size_t nSize );
+    void                SetGeomField( int iGeomField, OGRGeometry *poGeom );
+};
+
 /************************************************************************/
 /*                           OGRFeatureQuery                            */
 /************************************************************************/
@@ -436,12 +546,14 @@ class CPL_DLL OGRFeature
 class OGRLayer;
 class swq_expr_node;
 class swq_custom_func_registrar;
+class OGRFeatureQueryProgram;
 
 class CPL_DLL OGRFeatureQuery
 {
   private:
     OGRFeatureDefn *poTargetDefn;
     void           *pSWQExpr;
+    OGRFeatureQueryProgram *poProgram;
 
     char          **FieldCollector( void *, char ** );
 
@@ -456,6 +568,7 @@ class CPL_DLL OGRFeatureQuery
     OGRErr      Compile( OGRFeatureDefn *, const char *,
                          int bCheck = TRUE, swq_custom_func_registrar* poCustomFuncRegistrar = NULL );
     int         Evaluate( OGRFeature * );
+    int         EvaluateBatch( OGRFeatureBatch *, GByte *pabyResults );
 
     GIntBig       *EvaluateAgainstIndices( OGRLayer *, OGRErr * );
     
@@ -1206,6 +1206,72 @@ class CPL_DLL OGRMultiLineString : public OGRMultiCurve
     static OGRMultiCurve* CastToMultiCurve(OGRMultiLineString* poMLS);
 };
 
+/************************************************************************/
+/*                           OGRLazyGeometry                            */
+/************************************************************************/
+
+/**
+ * Geometry kept in its WKB encoding until its object tree is needed.
+ *
+ * The type, coordinate dimension, emptiness and envelope of the geometry
+ * are computed from the bytes when it is created, and exportToWkb() copies
+ * the bytes when the requested encoding matches the stored one, so that a
+ * geometry read by a driver can be filtered on its envelope and written to
+ * another driver without being parsed into OGRGeometry objects. The
+ * geometry is only parsed by materialize().
+ *
+ * Lazy geometries are attached to features with
+ * OGRFeature::SetGeomFieldLazyDirectly(): OGRFeature::GetGeomFieldRef()
+ * materializes them transparently.
+ *
+ * @since GDAL 2.0
+ */
+
+class CPL_DLL OGRLazyGeometry
+{
+    GByte                *pabyWkb;
+    int                   nWkbSize;
+    OGRwkbGeometryType    eGeometryType;
+    int                   bIs3D;
+    int                   bIsEmpty;
+    int                   nByteOrder;     /* 0 or 1, or -1 if mixed */
+    int                   bHasOldOgcZ;    /* type codes with the 25D bit */
+    int                   bHasIsoZ;       /* type codes above 1000 */
+    OGREnvelope3D         sEnvelope;
+    OGRSpatialReference  *poSRS;
+
+                          OGRLazyGeometry();
+                          OGRLazyGeometry( const OGRLazyGeometry& );
+    OGRLazyGeometry&      operator=( const OGRLazyGeometry& );
+
+    int                   ScanWkb( const GByte *pabyData, int nSize,
+                                   int nParentType, int nDepth,
+                                   int *pnConsumed );
+
+  public:
+                          ~OGRLazyGeometry();
+
+    static OGRLazyGeometry *CreateFromWkb( const GByte *pabyData, int nSize,
+                                           OGRSpatialReference *poSRS = NULL );
+
+    OGRLazyGeometry      *clone() const;
+
+    OGRwkbGeometryType    getGeometryType() const { return eGeometryType; }
+    int                   getCoordinateDimension() const
+                                { return bIs3D ? 3 : 2; }
+    OGRBoolean            IsEmpty() const { return bIsEmpty; }
+    void                  getEnvelope( OGREnvelope *psEnvelope ) const;
+    void                  getEnvelope( OGREnvelope3D *psEnvelope ) const;
+    OGRSpatialReference  *getSpatialReference() const { return poSRS; }
+
+    const GByte          *getWkb() const { return pabyWkb; }
+    int                   WkbSize() const { return nWkbSize; }
+    OGRErr                exportToWkb( OGRwkbByteOrder, unsigned char *,
+                                       OGRwkbVariant=wkbVariantOldOgc ) const;
+
+    OGRGeometry          *materialize() const;
+};
+
 
 /************************************************************************/
 /*                          OGRGeometryFactory                          */
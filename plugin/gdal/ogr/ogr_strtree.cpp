@@ -0,0 +1,354 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  The OGRSTRTree class implementation.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogr_strtree.h"
+#include "ogrsf_frmts.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+CPL_CVSID("$Id$");
+
+/************************************************************************/
+/*                        Envelope comparators.                         */
+/*                                                                      */
+/*      Envelopes are compared on their centers (the sums of their      */
+/*      bounds, which order them the same way).                         */
+/************************************************************************/
+
+template<class T> struct OGRSTRTreeCompareX
+{
+    bool operator()( const T& a, const T& b ) const
+    {
+        return a.sEnvelope.MinX + a.sEnvelope.MaxX <
+               b.sEnvelope.MinX + b.sEnvelope.MaxX;
+    }
+};
+
+template<class T> struct OGRSTRTreeCompareY
+{
+    bool operator()( const T& a, const T& b ) const
+    {
+        return a.sEnvelope.MinY + a.sEnvelope.MaxY <
+               b.sEnvelope.MinY + b.sEnvelope.MaxY;
+    }
+};
+
+/************************************************************************/
+/*                             OGRSTRTree()                             */
+/************************************************************************/
+
+/**
+ * \brief Constructor
+ *
+ * @param nNodeCapacityIn maximum number of children of a node of the tree.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRSTRTree::OGRSTRTree( int nNodeCapacityIn ) :
+    nNodeCapacity(MAX(2, nNodeCapacityIn)), bBuilt(FALSE), nItems(0)
+{
+}
+
+/************************************************************************/
+/*                            ~OGRSTRTree()                             */
+/************************************************************************/
+
+OGRSTRTree::~OGRSTRTree()
+{
+}
+
+/************************************************************************/
+/*                               Clear()                                */
+/************************************************************************/
+
+/**
+ * \brief Remove all the items of the tree.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRSTRTree::Clear()
+{
+    std::vector<OGRSTRTreeNode>().swap(asNodes);
+    bBuilt = FALSE;
+    nItems = 0;
+}
+
+/************************************************************************/
+/*                              AddItem()                               */
+/************************************************************************/
+
+/**
+ * \brief Add an item to a tree that is not built yet.
+ *
+ * @param sEnvelope envelope of the item.
+ * @param nId identifier of the item, returned by Search().
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRSTRTree::AddItem( const OGREnvelope& sEnvelope, GIntBig nId )
+{
+    if( bBuilt )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Cannot add an item to an OGRSTRTree already built");
+        return;
+    }
+
+    OGRSTRTreeNode sNode;
+    sNode.sEnvelope = sEnvelope;
+    sNode.nRef = nId;
+    sNode.nChildren = 0;
+    asNodes.push_back(sNode);
+    nItems++;
+}
+
+/************************************************************************/
+/*                            AddGeometry()                             */
+/************************************************************************/
+
+/**
+ * \brief Add an item with the envelope of a geometry.
+ *
+ * A NULL geometry is given an infinite envelope, so that the item is
+ * returned by all the searches, like OGRLayer::FilterGeometry() accepts
+ * features without geometry.
+ *
+ * @param poGeom geometry, or NULL.
+ * @param nId identifier of the item, returned by Search().
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRSTRTree::AddGeometry( OGRGeometry *poGeom, GIntBig nId )
+{
+    OGREnvelope sEnvelope;
+
+    if( poGeom == NULL )
+    {
+        sEnvelope.MinX = -DBL_MAX;
+        sEnvelope.MinY = -DBL_MAX;
+        sEnvelope.MaxX = DBL_MAX;
+        sEnvelope.MaxY = DBL_MAX;
+    }
+    else
+        poGeom->getEnvelope( &sEnvelope );
+
+    AddItem( sEnvelope, nId );
+}
+
+/************************************************************************/
+/*                             SortTiles()                              */
+/*                                                                      */
+/*      Order the nodes of a level so that each run of nNodeCapacity    */
+/*      nodes forms a compact tile: the nodes are sorted by X into      */
+/*      vertical slices of about sqrt(nParents) tiles, and each slice   */
+/*      is sorted by Y.                                                 */
+/************************************************************************/
+
+void OGRSTRTree::SortTiles( OGRSTRTreeNode *pasNodes, size_t nCount,
+                            int nNodeCapacity )
+{
+    if( nCount <= (size_t)nNodeCapacity )
+        return;
+
+    size_t nParents = (nCount + nNodeCapacity - 1) / nNodeCapacity;
+    size_t nSlices = (size_t)ceil(sqrt((double)nParents));
+    size_t nSliceSize = ((nParents + nSlices - 1) / nSlices) * nNodeCapacity;
+
+    std::sort( pasNodes, pasNodes + nCount,
+               OGRSTRTreeCompareX<OGRSTRTreeNode>() );
+
+    for( size_t i = 0; i < nCount; i += nSliceSize )
+    {
+        std::sort( pasNodes + i, pasNodes + MIN(nCount, i + nSliceSize),
+                   OGRSTRTreeCompareY<OGRSTRTreeNode>() );
+    }
+}
+
+/************************************************************************/
+/*                               Build()                                */
+/************************************************************************/
+
+/**
+ * \brief Pack the items added so far into the tree.
+ *
+ * Search() can only be used after Build(), and no item can be added
+ * afterwards.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRSTRTree::Build()
+{
+    if( bBuilt )
+        return;
+    bBuilt = TRUE;
+
+    size_t nLevelStart = 0;
+    size_t nLevelCount = asNodes.size();
+    if( nLevelCount == 0 )
+        return;
+
+    /* Reserve room for the inner nodes, so that the vector is not */
+    /* reallocated while the levels are built */
+    size_t nTotal = nLevelCount;
+    for( size_t n = nLevelCount; n > 1; )
+    {
+        n = (n + nNodeCapacity - 1) / nNodeCapacity;
+        nTotal += n;
+    }
+    if( nLevelCount == 1 )
+        nTotal ++;
+    asNodes.reserve( nTotal );
+
+    while( true )
+    {
+        SortTiles( &asNodes[nLevelStart], nLevelCount, nNodeCapacity );
+
+        size_t nParentStart = asNodes.size();
+        for( size_t i = 0; i < nLevelCount; i += nNodeCapacity )
+        {
+            size_t nChildren = MIN(nLevelCount - i, (size_t)nNodeCapacity);
+            OGRSTRTreeNode sParent;
+
+            sParent.sEnvelope = asNodes[nLevelStart + i].sEnvelope;
+            for( size_t j = 1; j < nChildren; j++ )
+            {
+                const OGREnvelope& sEnv =
+                    asNodes[nLevelStart + i + j].sEnvelope;
+                sParent.sEnvelope.MinX = MIN(sParent.sEnvelope.MinX, sEnv.MinX);
+                sParent.sEnvelope.MinY = MIN(sParent.sEnvelope.MinY, sEnv.MinY);
+                sParent.sEnvelope.MaxX = MAX(sParent.sEnvelope.MaxX, sEnv.MaxX);
+                sParent.sEnvelope.MaxY = MAX(sParent.sEnvelope.MaxY, sEnv.MaxY);
+            }
+            sParent.nRef = (GIntBig)(nLevelStart + i);
+            sParent.nChildren = (int)nChildren;
+            asNodes.push_back( sParent );
+        }
+
+        nLevelStart = nParentStart;
+        nLevelCount = asNodes.size() - nParentStart;
+        if( nLevelCount == 1 )
+            break;
+    }
+}
+
+/************************************************************************/
+/*                               Search()                               */
+/************************************************************************/
+
+/**
+ * \brief Find the items whose envelope intersects an envelope.
+ *
+ * The tree must have been built with Build().
+ *
+ * @param sEnvelope envelope to search.
+ * @param anIds vector where the identifiers of the items are returned,
+ * in ascending order.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRSTRTree::Search( const OGREnvelope& sEnvelope,
+                         std::vector<GIntBig>& anIds ) const
+{
+    anIds.resize(0);
+    if( !bBuilt || asNodes.empty() )
+        return;
+
+    std::vector<size_t> anStack;
+    anStack.push_back( asNodes.size() - 1 );
+
+    while( !anStack.empty() )
+    {
+        const OGRSTRTreeNode& sNode = asNodes[anStack.back()];
+        anStack.pop_back();
+
+        if( !sNode.sEnvelope.Intersects( sEnvelope ) )
+            continue;
+
+        if( sNode.nChildren == 0 )
+            anIds.push_back( sNode.nRef );
+        else
+        {
+            for( int i = sNode.nChildren - 1; i >= 0; i-- )
+                anStack.push_back( (size_t)sNode.nRef + i );
+        }
+    }
+
+    std::sort( anIds.begin(), anIds.end() );
+}
+
+/************************************************************************/
+/*                           BuildFromLayer()                           */
+/************************************************************************/
+
+/**
+ * \brief Build a tree indexing the features of a layer by FID.
+ *
+ * All the features returned by GetNextFeature() are read, so the spatial
+ * and attribute filters of the layer should be cleared before. The reading
+ * of the layer is reset afterwards. This can be used by layers, or layer
+ * wrappers, that can fetch features efficiently with GetFeature().
+ *
+ * @param poLayer layer.
+ * @param iGeomField index of the geometry field to index.
+ *
+ * @return a new tree, to destroy with delete, or NULL if the layer has no
+ * such geometry field.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRSTRTree *OGRSTRTree::BuildFromLayer( OGRLayer *poLayer, int iGeomField )
+{
+    if( iGeomField < 0 ||
+        iGeomField >= poLayer->GetLayerDefn()->GetGeomFieldCount() )
+        return NULL;
+
+    OGRSTRTree *poTree = new OGRSTRTree();
+    OGRFeature *poFeature;
+
+    poLayer->ResetReading();
+    while( (poFeature = poLayer->GetNextFeature()) != NULL )
+    {
+        poTree->AddGeometry( poFeature->GetGeomFieldRef(iGeomField),
+                             poFeature->GetFID() );
+        delete poFeature;
+    }
+    poLayer->ResetReading();
+
+    poTree->Build();
+    return poTree;
+}
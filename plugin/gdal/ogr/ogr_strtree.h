@@ -0,0 +1,92 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Bulk loaded, Sort-Tile-Recursive packed R-tree over feature
+ *           envelopes, for layers without a native spatial index.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef _OGR_STRTREE_H_INCLUDED
+#define _OGR_STRTREE_H_INCLUDED
+
+#include "ogr_core.h"
+
+#include <vector>
+
+class OGRGeometry;
+class OGRLayer;
+
+/************************************************************************/
+/*                              OGRSTRTree                              */
+/************************************************************************/
+
+/**
+ * Static R-tree over the envelopes of a set of items identified by an
+ * integer (typically a FID, or the position of a feature in a layer).
+ *
+ * Items are collected with AddItem(), and the tree is packed by Build()
+ * with the Sort-Tile-Recursive algorithm. Items cannot be added to a built
+ * tree: a layer whose features change is expected to discard its tree, and
+ * to build a new one when it is queried again.
+ */
+
+class CPL_DLL OGRSTRTree
+{
+    typedef struct
+    {
+        OGREnvelope sEnvelope;
+        GIntBig     nRef;       /* item id for the leaf entries, index of */
+                                /* the first child for the other nodes */
+        int         nChildren;  /* 0 for the leaf entries */
+    } OGRSTRTreeNode;
+
+    /* Leaf entries, then the nodes of each level, the root being last */
+    std::vector<OGRSTRTreeNode> asNodes;
+    int                         nNodeCapacity;
+    int                         bBuilt;
+    GIntBig                     nItems;
+
+    static void SortTiles( OGRSTRTreeNode *pasNodes, size_t nCount,
+                           int nNodeCapacity );
+
+  public:
+                OGRSTRTree( int nNodeCapacity = 16 );
+               ~OGRSTRTree();
+
+    void        AddItem( const OGREnvelope& sEnvelope, GIntBig nId );
+    void        AddGeometry( OGRGeometry *poGeom, GIntBig nId );
+    void        Build();
+    void        Clear();
+
+    int         IsBuilt() const { return bBuilt; }
+    GIntBig     GetItemCount() const { return nItems; }
+
+    void        Search( const OGREnvelope& sEnvelope,
+                        std::vector<GIntBig>& anIds ) const;
+
+    static OGRSTRTree *BuildFromLayer( OGRLayer *poLayer, int iGeomField );
+};
+
+#endif /* ndef _OGR_STRTREE_H_INCLUDED */
@@ -61,6 +61,9 @@ OGRFeature::OGRFeature( OGRFeatureDefn * poDefnIn )
     m_pszStyleString = NULL;
     m_poStyleTable = NULL;
     m_pszTmpFieldValue = NULL;
+    papszSpareStrings = NULL;
+    nSpareStringCount = 0;
+    papoLazyGeometries = NULL;
     poDefnIn->Reference();
     poDefn = poDefnIn;
 
@@ -157,8 +160,12 @@ OGRFeature::~OGRFeature()
     for( i = 0; i < nGeomFieldCount; i++ )
     {
         delete papoGeometries[i];
+        FreeLazyGeometry( i );
     }
+    CPLFree( papoLazyGeometries );
     
+    FreeSpareStrings();
+
     poDefn->Release();
 
     CPLFree( pauFields );
@@ -239,6 +246,181 @@ void OGRFeature::DestroyFeature( OGRFeature *poFeature )
     delete poFeature;
 }
 
+/************************************************************************/
+/*                               Reset()                                */
+/************************************************************************/
+
+/**
+ * \brief Reset the feature to its state after construction.
+ *
+ * All the fields are unset, the geometries and the style string are
+ * removed, and the FID is set to OGRNullFID. The field array is kept, and
+ * so are the buffers of the string fields, which are reused by the next
+ * SetField() calls on the same fields. This allows a reader to fill the
+ * same feature object again and again, as done by
+ * OGRLayer::GetNextFeatureInto().
+ *
+ * The feature definition must not have changed since the creation of the
+ * feature.
+ *
+ * This method is the same as the C function OGR_F_Reset().
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeature::Reset()
+
+{
+    int nFieldCount = poDefn->GetFieldCount();
+
+    nFID = OGRNullFID;
+
+    if( nSpareStringCount != nFieldCount )
+        FreeSpareStrings();
+
+    for( int i = 0; i < nFieldCount; i++ )
+    {
+        if( !IsFieldSet(i) )
+            continue;
+
+        if( poDefn->GetFieldDefn(i)->GetType() == OFTString &&
+            pauFields[i].String != NULL )
+        {
+            if( papszSpareStrings == NULL )
+            {
+                papszSpareStrings = (char **)
+                    CPLCalloc( nFieldCount, sizeof(char*) );
+                nSpareStringCount = nFieldCount;
+            }
+            CPLFree( papszSpareStrings[i] );
+            papszSpareStrings[i] = pauFields[i].String;
+
+            pauFields[i].Set.nMarker1 = OGRUnsetMarker;
+            pauFields[i].Set.nMarker2 = OGRUnsetMarker;
+        }
+        else
+            UnsetField( i );
+    }
+
+    int nGeomFieldCount = poDefn->GetGeomFieldCount();
+    for( int i = 0; i < nGeomFieldCount; i++ )
+    {
+        delete papoGeometries[i];
+        papoGeometries[i] = NULL;
+        FreeLazyGeometry( i );
+    }
+
+    CPLFree( m_pszStyleString );
+    m_pszStyleString = NULL;
+    SetStyleTableDirectly( NULL );
+    CPLFree( m_pszTmpFieldValue );
+    m_pszTmpFieldValue = NULL;
+}
+
+/************************************************************************/
+/*                            OGR_F_Reset()                             */
+/************************************************************************/
+
+/**
+ * \brief Reset the feature to its state after construction.
+ *
+ * This function is the same as the C++ method OGRFeature::Reset().
+ *
+ * @param hFeat handle to the feature to reset.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGR_F_Reset( OGRFeatureH hFeat )
+
+{
+    VALIDATE_POINTER0( hFeat, "OGR_F_Reset" );
+
+    ((OGRFeature *) hFeat)->Reset();
+}
+
+/************************************************************************/
+/*                          FreeSpareStrings()                          */
+/************************************************************************/
+
+void OGRFeature::FreeSpareStrings()
+
+{
+    if( papszSpareStrings == NULL )
+        return;
+
+    for( int i = 0; i < nSpareStringCount; i++ )
+        CPLFree( papszSpareStrings[i] );
+    CPLFree( papszSpareStrings );
+    papszSpareStrings = NULL;
+    nSpareStringCount = 0;
+}
+
+/************************************************************************/
+/*                          FreeLazyGeometry()                          */
+/************************************************************************/
+
+void OGRFeature::FreeLazyGeometry( int iField )
+
+{
+    if( papoLazyGeometries != NULL )
+    {
+        delete papoLazyGeometries[iField];
+        papoLazyGeometries[iField] = NULL;
+    }
+}
+
+/************************************************************************/
+/*                        MaterializeGeomField()                        */
+/*                                                                      */
+/*      Replace the lazy geometry of a field, if any, by the geometry   */
+/*      parsed from it.                                                 */
+/************************************************************************/
+
+void OGRFeature::MaterializeGeomField( int iField )
+
+{
+    if( papoLazyGeometries == NULL || papoLazyGeometries[iField] == NULL )
+        return;
+
+    papoGeometries[iField] = papoLazyGeometries[iField]->materialize();
+    if( papoGeometries[iField] == NULL )
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Cannot parse the WKB geometry of field %d", iField );
+    FreeLazyGeometry( iField );
+}
+
+/************************************************************************/
+/*                           DupFieldString()                           */
+/*                                                                      */
+/*      Copy the value of a string field, in the buffer kept for the   */
+/*      field by Reset() if there is one.                               */
+/************************************************************************/
+
+char *OGRFeature::DupFieldString( int iField, const char *pszValue )
+
+{
+    if( pszValue == NULL )
+        pszValue = "";
+
+    if( iField < nSpareStringCount && papszSpareStrings[iField] != NULL )
+    {
+        char *pszSpare = papszSpareStrings[iField];
+        size_t nLen = strlen(pszValue);
+
+        papszSpareStrings[iField] = NULL;
+        char *pszNew = (char *) VSIRealloc( pszSpare, nLen + 1 );
+        if( pszNew != NULL )
+        {
+            memcpy( pszNew, pszValue, nLen + 1 );
+            return pszNew;
+        }
+        CPLFree( pszSpare );
+    }
+
+    return CPLStrdup( pszValue );
+}
+
 /************************************************************************/
 /*                             GetDefnRef()                             */
 /************************************************************************/
@@ -422,6 +604,7 @@ OGRGeometry *OGRFeature::StealGeometry()
 {
     if( GetGeomFieldCount() > 0 )
     {
+        MaterializeGeomField( 0 );
         OGRGeometry *poReturn = papoGeometries[0];
         papoGeometries[0] = NULL;
         return poReturn;
@@ -435,6 +618,7 @@ OGRGeometry *OGRFeature::StealGeometry(int iGeomField)
 {
     if( iGeomField >= 0 && iGeomField < GetGeomFieldCount() )
     {
+        MaterializeGeomField( iGeomField );
         OGRGeometry *poReturn = papoGeometries[iGeomField];
         papoGeometries[iGeomField] = NULL;
         return poReturn;
@@ -549,8 +733,9 @@ OGRGeometry *OGRFeature::GetGeomFieldRef(int iField)
 {
     if( iField < 0 || iField >= GetGeomFieldCount() )
         return NULL;
-    else
-        return papoGeometries[iField];
+
+    MaterializeGeomField( iField );
+    return papoGeometries[iField];
 }
 
 /************************************************************************/
@@ -573,8 +758,9 @@ OGRGeometry *OGRFeature::GetGeomFieldRef(const char* pszFName)
     int iField = GetGeomFieldIndex(pszFName);
     if( iField < 0 )
         return NULL;
-    else
-        return papoGeometries[iField];
+
+    MaterializeGeomField( iField );
+    return papoGeometries[iField];
 }
 
 /************************************************************************/
@@ -649,6 +835,7 @@ OGRErr OGRFeature::SetGeomFieldDirectly( int iField, OGRGeometry * poGeomIn )
 
     delete papoGeometries[iField];
     papoGeometries[iField] = poGeomIn;
+    FreeLazyGeometry( iField );
 
     // I should be verifying that the geometry matches the defn's type.
     
@@ -722,6 +909,7 @@ OGRErr OGRFeature::SetGeomField( int iField, OGRGeometry * poGeomIn )
         return OGRERR_FAILURE;
 
     delete papoGeometries[iField];
+    FreeLazyGeometry( iField );
 
     if( poGeomIn != NULL )
         papoGeometries[iField] = poGeomIn->clone();
@@ -763,6 +951,111 @@ OGRErr OGR_F_SetGeomField( OGRFeatureH hFeat, int iField, OGRGeometryH hGeom )
     return ((OGRFeature *) hFeat)->SetGeomField(iField, (OGRGeometry *) hGeom);
 }
 
+/************************************************************************/
+/*                        GetGeomFieldLazyRef()                         */
+/************************************************************************/
+
+/**
+ * \brief Fetch the lazy geometry of a geometry field.
+ *
+ * A lazy geometry is only returned as long as the geometry of the field
+ * has not been materialized by GetGeomFieldRef() or StealGeometry(), so
+ * this can be used to get the envelope or the WKB of a geometry without
+ * parsing it:
+ *
+ * \code
+ *  OGRLazyGeometry *poLazy = poFeature->GetGeomFieldLazyRef(0);
+ *  if( poLazy != NULL )
+ *      poLazy->getEnvelope( &sEnvelope );
+ *  else if( poFeature->GetGeomFieldRef(0) != NULL )
+ *      poFeature->GetGeomFieldRef(0)->getEnvelope( &sEnvelope );
+ * \endcode
+ *
+ * @param iField geometry field to get.
+ *
+ * @return pointer to the internal lazy geometry, or NULL.  This object
+ * should not be modified.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRLazyGeometry *OGRFeature::GetGeomFieldLazyRef( int iField )
+
+{
+    if( iField < 0 || iField >= GetGeomFieldCount() ||
+        papoLazyGeometries == NULL )
+        return NULL;
+
+    return papoLazyGeometries[iField];
+}
+
+/************************************************************************/
+/*                      SetGeomFieldLazyDirectly()                      */
+/************************************************************************/
+
+/**
+ * \brief Set feature geometry of a specified geometry field, as WKB to be
+ * parsed on demand.
+ *
+ * This method updates the features geometry, and operate exactly as
+ * SetGeomFieldDirectly(), except that the geometry is only parsed when
+ * GetGeomFieldRef() or StealGeometry() is called.  Ownership of the lazy
+ * geometry is passed to the feature.
+ *
+ * @param iField geometry field to set.
+ * @param poLazyIn new lazy geometry to apply to feature, or NULL to clear
+ * the geometry.
+ *
+ * @return OGRERR_NONE if successful, or OGRERR_FAILURE if the index is
+ * invalid.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRErr OGRFeature::SetGeomFieldLazyDirectly( int iField,
+                                             OGRLazyGeometry *poLazyIn )
+
+{
+    if( iField < 0 || iField >= GetGeomFieldCount() )
+    {
+        delete poLazyIn;
+        return OGRERR_FAILURE;
+    }
+
+    delete papoGeometries[iField];
+    papoGeometries[iField] = NULL;
+    FreeLazyGeometry( iField );
+
+    if( poLazyIn != NULL )
+    {
+        if( papoLazyGeometries == NULL )
+            papoLazyGeometries = (OGRLazyGeometry **)
+                CPLCalloc( GetGeomFieldCount(), sizeof(OGRLazyGeometry*) );
+        papoLazyGeometries[iField] = poLazyIn;
+    }
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                          SetGeomFieldFrom()                          */
+/*                                                                      */
+/*      Copy a geometry field of another feature, keeping it lazy if    */
+/*      it is lazy in the source feature.                               */
+/************************************************************************/
+
+void OGRFeature::SetGeomFieldFrom( int iField, OGRFeature *poSrcFeature,
+                                   int iSrcField )
+
+{
+    OGRLazyGeometry *poLazy = poSrcFeature->GetGeomFieldLazyRef( iSrcField );
+
+    if( poLazy != NULL )
+        SetGeomFieldLazyDirectly( iField, poLazy->clone() );
+    else
+        SetGeomField( iField, poSrcFeature->GetGeomFieldRef(iSrcField) );
+}
+
 /************************************************************************/
 /*                               Clone()                                */
 /************************************************************************/
@@ -790,7 +1083,10 @@ OGRFeature *OGRFeature::Clone()
     }
     for( i = 0; i < poDefn->GetGeomFieldCount(); i++ )
     {
-        poNew->SetGeomField( i, papoGeometries[i] );
+        if( papoLazyGeometries != NULL && papoLazyGeometries[i] != NULL )
+            poNew->SetGeomFieldLazyDirectly( i, papoLazyGeometries[i]->clone() );
+        else
+            poNew->SetGeomField( i, papoGeometries[i] );
     }
 
     if( GetStyleString() != NULL )
@@ -1121,16 +1417,16 @@ int OGRFeature::IsFieldSet( int iField )
 
           case SPF_OGR_GEOM_WKT:
           case SPF_OGR_GEOMETRY:
-            return GetGeomFieldCount() > 0 && papoGeometries[0] != NULL;
+            return GetGeomFieldCount() > 0 && GetGeomFieldRef(0) != NULL;
 
           case SPF_OGR_STYLE:
             return ((OGRFeature *)this)->GetStyleString() != NULL;
 
           case SPF_OGR_GEOM_AREA:
-            if( GetGeomFieldCount() == 0 || papoGeometries[0] == NULL )
+            if( GetGeomFieldCount() == 0 || GetGeomFieldRef(0) == NULL )
                 return FALSE;
 
-            return OGR_G_Area((OGRGeometryH)papoGeometries[0]) != 0.0;
+            return OGR_G_Area((OGRGeometryH)GetGeomFieldRef(0)) != 0.0;
 
           default:
             return FALSE;
@@ -1325,9 +1621,9 @@ int OGRFeature::GetFieldAsInteger( int iField )
         }
 
         case SPF_OGR_GEOM_AREA:
-            if( GetGeomFieldCount() == 0 || papoGeometries[0] == NULL )
+            if( GetGeomFieldCount() == 0 || GetGeomFieldRef(0) == NULL )
                 return 0;
-            return (int)OGR_G_Area((OGRGeometryH)papoGeometries[0]);
+            return (int)OGR_G_Area((OGRGeometryH)GetGeomFieldRef(0));
 
         default:
             return 0;
@@ -1430,9 +1726,9 @@ GIntBig OGRFeature::GetFieldAsInteger64( int iField )
             return nFID;
         
         case SPF_OGR_GEOM_AREA:
-            if( GetGeomFieldCount() == 0 || papoGeometries[0] == NULL )
+            if( GetGeomFieldCount() == 0 || GetGeomFieldRef(0) == NULL )
                 return 0;
-            return (int)OGR_G_Area((OGRGeometryH)papoGeometries[0]);
+            return (int)OGR_G_Area((OGRGeometryH)GetGeomFieldRef(0));
 
         default:
             return 0;
@@ -1527,9 +1823,9 @@ double OGRFeature::GetFieldAsDouble( int iField )
             return (double)GetFID();
 
         case SPF_OGR_GEOM_AREA:
-            if( GetGeomFieldCount() == 0 || papoGeometries[0] == NULL )
+            if( GetGeomFieldCount() == 0 || GetGeomFieldRef(0) == NULL )
                 return 0.0;
-            return OGR_G_Area((OGRGeometryH)papoGeometries[0]);
+            return OGR_G_Area((OGRGeometryH)GetGeomFieldRef(0));
 
         default:
             return 0.0;
@@ -1628,8 +1924,8 @@ const char *OGRFeature::GetFieldAsString( int iField )
             return m_pszTmpFieldValue = CPLStrdup( szTempBuffer );
 
           case SPF_OGR_GEOMETRY:
-            if( GetGeomFieldCount() > 0 && papoGeometries[0] != NULL )
-                return papoGeometries[0]->getGeometryName();
+            if( GetGeomFieldCount() > 0 && GetGeomFieldRef(0) != NULL )
+                return GetGeomFieldRef(0)->getGeometryName();
             else
                 return "";
 
@@ -1641,21 +1937,21 @@ const char *OGRFeature::GetFieldAsString( int iField )
 
           case SPF_OGR_GEOM_WKT:
           {
-              if( GetGeomFieldCount() == 0 || papoGeometries[0] == NULL )
+              if( GetGeomFieldCount() == 0 || GetGeomFieldRef(0) == NULL )
                   return "";
 
-              if (papoGeometries[0]->exportToWkt( &m_pszTmpFieldValue ) == OGRERR_NONE )
+              if (GetGeomFieldRef(0)->exportToWkt( &m_pszTmpFieldValue ) == OGRERR_NONE )
                   return m_pszTmpFieldValue;
               else
                   return "";
           }
 
           case SPF_OGR_GEOM_AREA:
-            if( GetGeomFieldCount() == 0 || papoGeometries[0] == NULL )
+            if( GetGeomFieldCount() == 0 || GetGeomFieldRef(0) == NULL )
                 return "";
 
             CPLsnprintf( szTempBuffer, TEMP_BUFFER_SIZE, "%.16g", 
-                      OGR_G_Area((OGRGeometryH)papoGeometries[0]) );
+                      OGR_G_Area((OGRGeometryH)GetGeomFieldRef(0)) );
             return m_pszTmpFieldValue = CPLStrdup( szTempBuffer );
 
           default:
@@ -2861,7 +3157,7 @@ void OGRFeature::SetField( int iField, const char * pszValue )
         if( IsFieldSet(iField) )
             CPLFree( pauFields[iField].String );
             
-        pauFields[iField].String = CPLStrdup( pszValue );
+        pauFields[iField].String = DupFieldString( iField, pszValue );
     }
     else if( eType == OFTInteger )
     {
@@ -3625,7 +3921,7 @@ void OGRFeature::SetField( int iField, OGRField * puValue )
                  && puValue->Set.nMarker2 == OGRUnsetMarker )
             pauFields[iField] = *puValue;
         else
-            pauFields[iField].String = CPLStrdup( puValue->String );
+            pauFields[iField].String = DupFieldString( iField, puValue->String );
     }
     else if( poFDefn->GetType() == OFTDate
              || poFDefn->GetType() == OFTTime
@@ -3854,12 +4150,13 @@ void OGRFeature::DumpReadable( FILE * fpOut, char** papszOptions )
             {
                 OGRGeomFieldDefn    *poFDefn = poDefn->GetGeomFieldDefn(iField);
 
-                if( papoGeometries[iField] != NULL )
+                OGRGeometry *poGeom = GetGeomFieldRef( iField );
+                if( poGeom != NULL )
                 {
                     fprintf( fpOut, "  " );
                     if( strlen(poFDefn->GetNameRef()) > 0 && GetGeomFieldCount() > 1 )
                         fprintf( fpOut, "%s = ", poFDefn->GetNameRef() );
-                    papoGeometries[iField]->dumpReadable( fpOut, "", papszOptions );
+                    poGeom->dumpReadable( fpOut, "", papszOptions );
                 }
             }
         }
@@ -4362,10 +4659,10 @@ OGRErr OGRFeature::SetFrom( OGRFeature * poSrcFeature, int *panMap ,
         int iSrc = poSrcFeature->GetGeomFieldIndex(
                                     poGFieldDefn->GetNameRef());
         if( iSrc >= 0 )
-            SetGeomField( 0, poSrcFeature->GetGeomFieldRef(iSrc) );
+            SetGeomFieldFrom( 0, poSrcFeature, iSrc );
         else
             /* whatever the geometry field names are. For backward compatibility */
-            SetGeomField( 0, poSrcFeature->GetGeomFieldRef(0) );
+            SetGeomFieldFrom( 0, poSrcFeature, 0 );
     }
     else
     {
@@ -4377,7 +4674,7 @@ OGRErr OGRFeature::SetFrom( OGRFeature * poSrcFeature, int *panMap ,
             int iSrc = poSrcFeature->GetGeomFieldIndex(
                                         poGFieldDefn->GetNameRef());
             if( iSrc >= 0 )
-                SetGeomField( i, poSrcFeature->GetGeomFieldRef(iSrc) );
+                SetGeomFieldFrom( i, poSrcFeature, iSrc );
             else
                 SetGeomField( i, NULL );
         }
@@ -4813,6 +5110,7 @@ OGRErr OGRFeature::RemapFields( OGRFeatureDefn *poNewDefn,
 /* -------------------------------------------------------------------- */
 /*      Apply new definition and fields.                                */
 /* -------------------------------------------------------------------- */
+    FreeSpareStrings();
     CPLFree( pauFields );
     pauFields = pauNewFields;
 
@@ -4838,6 +5136,11 @@ OGRErr OGRFeature::RemapGeomFields( OGRFeatureDefn *poNewDefn,
     if( poNewDefn == NULL )
         poNewDefn = poDefn;
 
+    for( iDstField = 0; iDstField < poDefn->GetGeomFieldCount(); iDstField++ )
+        MaterializeGeomField( iDstField );
+    CPLFree( papoLazyGeometries );
+    papoLazyGeometries = NULL;
+
     papoNewGeomFields = (OGRGeometry **) CPLCalloc( poNewDefn->GetGeomFieldCount(), 
                                            sizeof(OGRGeometry*) );
 
@@ -0,0 +1,1226 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  The OGRFeatureBatch class implementation.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogr_feature.h"
+#include "ogr_api.h"
+#include "ogr_p.h"
+
+CPL_CVSID("$Id$");
+
+/************************************************************************/
+/*                          OGRFeatureBatch()                           */
+/************************************************************************/
+
+/**
+ * \brief Constructor
+ *
+ * The batch increments the reference count of its OGRFeatureDefn.
+ *
+ * This method is the same as the C function OGR_FB_Create().
+ *
+ * @param poDefnIn feature class (layer) definition of the features of the
+ * batch.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRFeatureBatch::OGRFeatureBatch( OGRFeatureDefn * poDefnIn ) :
+    poDefn(poDefnIn), nFeatureCount(0), poConversionFeature(NULL)
+{
+    poDefn->Reference();
+    Reset();
+}
+
+/************************************************************************/
+/*                          ~OGRFeatureBatch()                          */
+/************************************************************************/
+
+OGRFeatureBatch::~OGRFeatureBatch()
+
+{
+    delete poConversionFeature;
+    poDefn->Release();
+}
+
+/************************************************************************/
+/*                                Reset()                               */
+/************************************************************************/
+
+/**
+ * \brief Remove all the features of the batch.
+ *
+ * Allocated buffers are kept so that refilling the batch with a similar
+ * number of features does not need new allocations. The columns are
+ * resized to the current fields of the feature definition.
+ *
+ * @param poNewDefn if not NULL, the feature definition to use from now on.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::Reset( OGRFeatureDefn *poNewDefn )
+
+{
+    if( poNewDefn != NULL && poNewDefn != poDefn )
+    {
+        poNewDefn->Reference();
+        poDefn->Release();
+        poDefn = poNewDefn;
+    }
+
+    /* The field count of the definition may have changed */
+    delete poConversionFeature;
+    poConversionFeature = NULL;
+
+    nFeatureCount = 0;
+    anFIDs.resize(0);
+
+    aoFields.resize( poDefn->GetFieldCount() );
+    for( int iField = 0; iField < (int)aoFields.size(); iField++ )
+    {
+        OGRFeatureBatchColumn& oColumn = aoFields[iField];
+        switch( poDefn->GetFieldDefn(iField)->GetType() )
+        {
+            case OFTInteger:
+                oColumn.nValueSize = (int)sizeof(int);
+                break;
+            case OFTInteger64:
+                oColumn.nValueSize = (int)sizeof(GIntBig);
+                break;
+            case OFTReal:
+                oColumn.nValueSize = (int)sizeof(double);
+                break;
+            case OFTDate:
+            case OFTTime:
+            case OFTDateTime:
+                oColumn.nValueSize = (int)sizeof(OGRField);
+                break;
+            default:
+                oColumn.nValueSize = 0;
+                break;
+        }
+        oColumn.abyValidity.resize(0);
+        oColumn.abyValues.resize(0);
+        oColumn.anOffsets.resize(0);
+        oColumn.abyData.resize(0);
+        if( oColumn.nValueSize == 0 )
+            oColumn.anOffsets.push_back(0);
+    }
+
+    aoGeomFields.resize( poDefn->GetGeomFieldCount() );
+    for( int iGeomField = 0; iGeomField < (int)aoGeomFields.size(); iGeomField++ )
+    {
+        OGRFeatureBatchColumn& oColumn = aoGeomFields[iGeomField];
+        oColumn.nValueSize = 0;
+        oColumn.abyValidity.resize(0);
+        oColumn.abyValues.resize(0);
+        oColumn.anOffsets.resize(1);
+        oColumn.anOffsets[0] = 0;
+        oColumn.abyData.resize(0);
+    }
+}
+
+/************************************************************************/
+/*                              GetFIDs()                               */
+/************************************************************************/
+
+/**
+ * \brief Return the array of the GetFeatureCount() feature ids.
+ *
+ * @since GDAL 2.0
+ */
+
+const GIntBig *OGRFeatureBatch::GetFIDs() const
+
+{
+    return anFIDs.empty() ? NULL : &anFIDs[0];
+}
+
+/************************************************************************/
+/*                          GetFieldValidity()                          */
+/************************************************************************/
+
+/**
+ * \brief Return the validity bitmap of a field.
+ *
+ * Bit i (byte i / 8, bit i % 8) is set if the field of the i-th feature
+ * of the batch is set.
+ *
+ * @param iField the field index.
+ * @return the bitmap, or NULL if the batch is empty.
+ *
+ * @since GDAL 2.0
+ */
+
+const GByte *OGRFeatureBatch::GetFieldValidity( int iField ) const
+
+{
+    if( iField < 0 || iField >= (int)aoFields.size() ||
+        aoFields[iField].abyValidity.empty() )
+        return NULL;
+    return &aoFields[iField].abyValidity[0];
+}
+
+/************************************************************************/
+/*                           GetFieldValues()                           */
+/************************************************************************/
+
+/**
+ * \brief Return the values of a fixed size field.
+ *
+ * The array has one entry per feature. Entries of unset fields are zeroed.
+ *
+ * @param iField the field index.
+ * @return the array, or NULL for a variable length field or an empty batch.
+ *
+ * @since GDAL 2.0
+ */
+
+const void *OGRFeatureBatch::GetFieldValues( int iField ) const
+
+{
+    if( iField < 0 || iField >= (int)aoFields.size() ||
+        aoFields[iField].abyValues.empty() )
+        return NULL;
+    return &aoFields[iField].abyValues[0];
+}
+
+/************************************************************************/
+/*                          GetFieldOffsets()                           */
+/************************************************************************/
+
+/**
+ * \brief Return the offsets of the values of a variable length field.
+ *
+ * The array has GetFeatureCount() + 1 entries. The value of the i-th
+ * feature is made of the bytes [offsets[i], offsets[i+1]) of
+ * GetFieldData().
+ *
+ * @param iField the field index.
+ * @return the array, or NULL for a fixed size field.
+ *
+ * @since GDAL 2.0
+ */
+
+const GIntBig *OGRFeatureBatch::GetFieldOffsets( int iField ) const
+
+{
+    if( iField < 0 || iField >= (int)aoFields.size() ||
+        aoFields[iField].anOffsets.empty() )
+        return NULL;
+    return &aoFields[iField].anOffsets[0];
+}
+
+/************************************************************************/
+/*                            GetFieldData()                            */
+/************************************************************************/
+
+/**
+ * \brief Return the data buffer of a variable length field.
+ *
+ * @param iField the field index.
+ * @return the buffer, or NULL if it is empty.
+ *
+ * @since GDAL 2.0
+ */
+
+const GByte *OGRFeatureBatch::GetFieldData( int iField ) const
+
+{
+    if( iField < 0 || iField >= (int)aoFields.size() ||
+        aoFields[iField].abyData.empty() )
+        return NULL;
+    return &aoFields[iField].abyData[0];
+}
+
+/************************************************************************/
+/*                             IsFieldSet()                             */
+/************************************************************************/
+
+/**
+ * \brief Test if a field of a feature of the batch is set.
+ *
+ * @param iFeature the feature index in the batch.
+ * @param iField the field index.
+ * @return TRUE if the field is set.
+ *
+ * @since GDAL 2.0
+ */
+
+int OGRFeatureBatch::IsFieldSet( int iFeature, int iField ) const
+
+{
+    if( iFeature < 0 || iFeature >= nFeatureCount ||
+        iField < 0 || iField >= (int)aoFields.size() )
+        return FALSE;
+    return (aoFields[iField].abyValidity[iFeature / 8] &
+            (1 << (iFeature % 8))) != 0;
+}
+
+/************************************************************************/
+/*                        GetGeomFieldValidity()                        */
+/************************************************************************/
+
+/**
+ * \brief Return the validity bitmap of a geometry field.
+ *
+ * @see GetFieldValidity()
+ *
+ * @since GDAL 2.0
+ */
+
+const GByte *OGRFeatureBatch::GetGeomFieldValidity( int iGeomField ) const
+
+{
+    if( iGeomField < 0 || iGeomField >= (int)aoGeomFields.size() ||
+        aoGeomFields[iGeomField].abyValidity.empty() )
+        return NULL;
+    return &aoGeomFields[iGeomField].abyValidity[0];
+}
+
+/************************************************************************/
+/*                        GetGeomFieldOffsets()                         */
+/************************************************************************/
+
+/**
+ * \brief Return the offsets of the WKB blobs of a geometry field.
+ *
+ * @see GetFieldOffsets()
+ *
+ * @since GDAL 2.0
+ */
+
+const GIntBig *OGRFeatureBatch::GetGeomFieldOffsets( int iGeomField ) const
+
+{
+    if( iGeomField < 0 || iGeomField >= (int)aoGeomFields.size() )
+        return NULL;
+    return &aoGeomFields[iGeomField].anOffsets[0];
+}
+
+/************************************************************************/
+/*                          GetGeomFieldData()                          */
+/************************************************************************/
+
+/**
+ * \brief Return the buffer with the WKB blobs of a geometry field.
+ *
+ * @see GetFieldData()
+ *
+ * @since GDAL 2.0
+ */
+
+const GByte *OGRFeatureBatch::GetGeomFieldData( int iGeomField ) const
+
+{
+    if( iGeomField < 0 || iGeomField >= (int)aoGeomFields.size() ||
+        aoGeomFields[iGeomField].abyData.empty() )
+        return NULL;
+    return &aoGeomFields[iGeomField].abyData[0];
+}
+
+/************************************************************************/
+/*                             GetFeature()                             */
+/************************************************************************/
+
+/**
+ * \brief Build an OGRFeature from a feature of the batch.
+ *
+ * @param iFeature the feature index in the batch.
+ * @return a new feature to delete by the caller, or NULL.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRFeature *OGRFeatureBatch::GetFeature( int iFeature )
+
+{
+    if( iFeature < 0 || iFeature >= nFeatureCount )
+        return NULL;
+
+    OGRFeature *poFeature = new OGRFeature( poDefn );
+    poFeature->SetFID( anFIDs[iFeature] );
+
+    for( int iField = 0; iField < (int)aoFields.size(); iField++ )
+    {
+        if( !IsFieldSet(iFeature, iField) )
+            continue;
+
+        OGRFeatureBatchColumn& oColumn = aoFields[iField];
+        if( oColumn.nValueSize > 0 )
+        {
+            const GByte* pabyValue =
+                &oColumn.abyValues[(size_t)iFeature * oColumn.nValueSize];
+            switch( poDefn->GetFieldDefn(iField)->GetType() )
+            {
+                case OFTInteger:
+                    poFeature->SetField( iField, *(const int*)pabyValue );
+                    break;
+                case OFTInteger64:
+                    poFeature->SetField( iField, *(const GIntBig*)pabyValue );
+                    break;
+                case OFTReal:
+                    poFeature->SetField( iField, *(const double*)pabyValue );
+                    break;
+                default:
+                    poFeature->SetField( iField, (OGRField*)pabyValue );
+                    break;
+            }
+            continue;
+        }
+
+        size_t nStart = (size_t)oColumn.anOffsets[iFeature];
+        size_t nSize = (size_t)oColumn.anOffsets[iFeature+1] - nStart;
+        GByte* pabyData = (nSize > 0) ? &oColumn.abyData[nStart] : NULL;
+        switch( poDefn->GetFieldDefn(iField)->GetType() )
+        {
+            case OFTString:
+            case OFTWideString:
+            {
+                CPLString osValue;
+                if( nSize > 0 )
+                    osValue.assign( (const char*)pabyData, nSize );
+                poFeature->SetField( iField, osValue.c_str() );
+                break;
+            }
+
+            case OFTBinary:
+                poFeature->SetField( iField, (int)nSize, pabyData );
+                break;
+
+            case OFTIntegerList:
+                poFeature->SetField( iField, (int)(nSize / sizeof(int)),
+                                     (int*)pabyData );
+                break;
+
+            case OFTInteger64List:
+                poFeature->SetField( iField, (int)(nSize / sizeof(GIntBig)),
+                                     (const GIntBig*)pabyData );
+                break;
+
+            case OFTRealList:
+                poFeature->SetField( iField, (int)(nSize / sizeof(double)),
+                                     (double*)pabyData );
+                break;
+
+            case OFTStringList:
+            {
+                std::vector<char*> apszList;
+                for( size_t i = 0; i < nSize;
+                     i += strlen((const char*)pabyData + i) + 1 )
+                    apszList.push_back( (char*)pabyData + i );
+                apszList.push_back( NULL );
+                poFeature->SetField( iField, &apszList[0] );
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    for( int iGeomField = 0; iGeomField < (int)aoGeomFields.size(); iGeomField++ )
+    {
+        OGRFeatureBatchColumn& oColumn = aoGeomFields[iGeomField];
+        if( !(oColumn.abyValidity[iFeature / 8] & (1 << (iFeature % 8))) )
+            continue;
+
+        size_t nStart = (size_t)oColumn.anOffsets[iFeature];
+        size_t nSize = (size_t)oColumn.anOffsets[iFeature+1] - nStart;
+        OGRSpatialReference* poSRS =
+            poDefn->GetGeomFieldDefn(iGeomField)->GetSpatialRef();
+        OGRLazyGeometry* poLazy = OGRLazyGeometry::CreateFromWkb(
+            &oColumn.abyData[nStart], (int)nSize, poSRS );
+        if( poLazy != NULL )
+        {
+            poFeature->SetGeomFieldLazyDirectly( iGeomField, poLazy );
+            continue;
+        }
+
+        OGRGeometry* poGeom = NULL;
+        if( OGRGeometryFactory::createFromWkb( &oColumn.abyData[nStart], NULL,
+                                               &poGeom, (int)nSize ) == OGRERR_NONE )
+        {
+            poGeom->assignSpatialReference( poSRS );
+            poFeature->SetGeomFieldDirectly( iGeomField, poGeom );
+        }
+    }
+
+    return poFeature;
+}
+
+/************************************************************************/
+/*                            BeginFeature()                            */
+/************************************************************************/
+
+/**
+ * \brief Append a new feature, with all its fields unset, to the batch.
+ *
+ * The SetFieldXXX() and SetGeomFieldXXX() methods then apply to this
+ * feature. This is meant for drivers filling a batch.
+ *
+ * @param nFID feature id of the new feature.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::BeginFeature( GIntBig nFID )
+
+{
+    int bNewValidityByte = (nFeatureCount % 8) == 0;
+
+    anFIDs.push_back( nFID );
+    nFeatureCount ++;
+
+    for( size_t iField = 0; iField < aoFields.size(); iField++ )
+    {
+        OGRFeatureBatchColumn& oColumn = aoFields[iField];
+        if( bNewValidityByte )
+            oColumn.abyValidity.push_back( 0 );
+        if( oColumn.nValueSize > 0 )
+            oColumn.abyValues.resize( oColumn.abyValues.size() +
+                                      oColumn.nValueSize );
+        else
+            oColumn.anOffsets.push_back( oColumn.anOffsets.back() );
+    }
+
+    for( size_t iGeomField = 0; iGeomField < aoGeomFields.size(); iGeomField++ )
+    {
+        OGRFeatureBatchColumn& oColumn = aoGeomFields[iGeomField];
+        if( bNewValidityByte )
+            oColumn.abyValidity.push_back( 0 );
+        oColumn.anOffsets.push_back( oColumn.anOffsets.back() );
+    }
+}
+
+/************************************************************************/
+/*                             AddFeature()                             */
+/************************************************************************/
+
+/**
+ * \brief Append a copy of a feature to the batch.
+ *
+ * @param poFeature a feature of the same feature definition as the batch.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::AddFeature( OGRFeature *poFeature )
+
+{
+    BeginFeature( poFeature->GetFID() );
+
+    int nFieldCount = MIN( (int)aoFields.size(), poFeature->GetFieldCount() );
+    for( int iField = 0; iField < nFieldCount; iField++ )
+    {
+        if( poFeature->IsFieldSet(iField) )
+            SetFieldRaw( iField, poFeature->GetRawFieldRef(iField) );
+    }
+
+    int nGeomFieldCount = MIN( (int)aoGeomFields.size(),
+                               poFeature->GetGeomFieldCount() );
+    for( int iGeomField = 0; iGeomField < nGeomFieldCount; iGeomField++ )
+    {
+        OGRLazyGeometry *poLazy = poFeature->GetGeomFieldLazyRef(iGeomField);
+        if( poLazy != NULL )
+        {
+            GByte* pabyWKB = AllocVarValue( aoGeomFields[iGeomField],
+                                            poLazy->WkbSize() );
+            poLazy->exportToWkb( wkbNDR, pabyWKB, wkbVariantIso );
+        }
+        else
+            SetGeomField( iGeomField, poFeature->GetGeomFieldRef(iGeomField) );
+    }
+}
+
+/************************************************************************/
+/*                              SetValid()                              */
+/************************************************************************/
+
+void OGRFeatureBatch::SetValid( OGRFeatureBatchColumn& oColumn )
+
+{
+    int iFeature = nFeatureCount - 1;
+    oColumn.abyValidity[iFeature / 8] |= (GByte)(1 << (iFeature % 8));
+}
+
+/************************************************************************/
+/*                           SetFixedValue()                            */
+/************************************************************************/
+
+void OGRFeatureBatch::SetFixedValue( int iField, const void* pValue )
+
+{
+    OGRFeatureBatchColumn& oColumn = aoFields[iField];
+    memcpy( &oColumn.abyValues[(size_t)(nFeatureCount - 1) * oColumn.nValueSize],
+            pValue, oColumn.nValueSize );
+    SetValid( oColumn );
+}
+
+/************************************************************************/
+/*                           AllocVarValue()                            */
+/*                                                                      */
+/*      Reserve nSize bytes for the value of the current feature,       */
+/*      replacing any value previously set.                             */
+/************************************************************************/
+
+GByte *OGRFeatureBatch::AllocVarValue( OGRFeatureBatchColumn& oColumn,
+                                       size_t nSize )
+
+{
+    size_t nStart = (size_t)oColumn.anOffsets[nFeatureCount - 1];
+    oColumn.abyData.resize( nStart + nSize );
+    oColumn.anOffsets[nFeatureCount] = nStart + nSize;
+    SetValid( oColumn );
+    return nSize > 0 ? &oColumn.abyData[nStart] : NULL;
+}
+
+/************************************************************************/
+/*                            SetVarValue()                             */
+/************************************************************************/
+
+void OGRFeatureBatch::SetVarValue( OGRFeatureBatchColumn& oColumn,
+                                   const void* pData, size_t nSize )
+
+{
+    GByte* pabyDst = AllocVarValue( oColumn, nSize );
+    if( nSize > 0 )
+        memcpy( pabyDst, pData, nSize );
+}
+
+/************************************************************************/
+/*                        GetConversionFeature()                        */
+/*                                                                      */
+/*      Values not of the type of their field are converted with the    */
+/*      OGRFeature::SetField() methods, so as to get the same result    */
+/*      than reading features one at a time.                            */
+/************************************************************************/
+
+OGRFeature *OGRFeatureBatch::GetConversionFeature()
+
+{
+    if( poConversionFeature == NULL )
+        poConversionFeature = new OGRFeature( poDefn );
+    return poConversionFeature;
+}
+
+/************************************************************************/
+/*                   SetFieldFromConversionFeature()                    */
+/************************************************************************/
+
+void OGRFeatureBatch::SetFieldFromConversionFeature( int iField )
+
+{
+    if( poConversionFeature->IsFieldSet(iField) )
+    {
+        SetFieldRaw( iField, poConversionFeature->GetRawFieldRef(iField) );
+        poConversionFeature->UnsetField( iField );
+    }
+}
+
+/************************************************************************/
+/*                          SetFieldInteger()                           */
+/************************************************************************/
+
+/**
+ * \brief Set a field of the current feature from an integer.
+ *
+ * @see BeginFeature()
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetFieldInteger( int iField, int nValue )
+
+{
+    OGRFieldDefn* poFieldDefn = poDefn->GetFieldDefn( iField );
+    if( poFieldDefn == NULL )
+        return;
+
+    if( poFieldDefn->GetType() == OFTInteger &&
+        poFieldDefn->GetSubType() == OFSTNone )
+    {
+        SetFixedValue( iField, &nValue );
+    }
+    else if( poFieldDefn->GetType() == OFTInteger64 )
+    {
+        GIntBig nValue64 = nValue;
+        SetFixedValue( iField, &nValue64 );
+    }
+    else
+    {
+        GetConversionFeature()->SetField( iField, nValue );
+        SetFieldFromConversionFeature( iField );
+    }
+}
+
+/************************************************************************/
+/*                         SetFieldInteger64()                          */
+/************************************************************************/
+
+/**
+ * \brief Set a field of the current feature from a 64 bit integer.
+ *
+ * @see BeginFeature()
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetFieldInteger64( int iField, GIntBig nValue )
+
+{
+    OGRFieldDefn* poFieldDefn = poDefn->GetFieldDefn( iField );
+    if( poFieldDefn == NULL )
+        return;
+
+    if( poFieldDefn->GetType() == OFTInteger64 )
+    {
+        SetFixedValue( iField, &nValue );
+    }
+    else
+    {
+        GetConversionFeature()->SetField( iField, nValue );
+        SetFieldFromConversionFeature( iField );
+    }
+}
+
+/************************************************************************/
+/*                           SetFieldDouble()                           */
+/************************************************************************/
+
+/**
+ * \brief Set a field of the current feature from a double.
+ *
+ * @see BeginFeature()
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetFieldDouble( int iField, double dfValue )
+
+{
+    OGRFieldDefn* poFieldDefn = poDefn->GetFieldDefn( iField );
+    if( poFieldDefn == NULL )
+        return;
+
+    if( poFieldDefn->GetType() == OFTReal &&
+        poFieldDefn->GetSubType() == OFSTNone )
+    {
+        SetFixedValue( iField, &dfValue );
+    }
+    else
+    {
+        GetConversionFeature()->SetField( iField, dfValue );
+        SetFieldFromConversionFeature( iField );
+    }
+}
+
+/************************************************************************/
+/*                           SetFieldString()                           */
+/************************************************************************/
+
+/**
+ * \brief Set a string field of the current feature.
+ *
+ * Fields that are not of type OFTString are set as with
+ * SetFieldFromString().
+ *
+ * @param iField the field index.
+ * @param pszValue the value, not necessarily nul terminated if nLength
+ * is given.
+ * @param nLength number of bytes of pszValue, or -1 to use strlen().
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetFieldString( int iField, const char *pszValue,
+                                      int nLength )
+
+{
+    OGRFieldDefn* poFieldDefn = poDefn->GetFieldDefn( iField );
+    if( poFieldDefn == NULL )
+        return;
+
+    if( poFieldDefn->GetType() == OFTString ||
+        poFieldDefn->GetType() == OFTWideString )
+    {
+        SetVarValue( aoFields[iField], pszValue,
+                     nLength >= 0 ? (size_t)nLength : strlen(pszValue) );
+    }
+    else if( nLength >= 0 )
+    {
+        CPLString osValue;
+        osValue.assign( pszValue, nLength );
+        SetFieldFromString( iField, osValue.c_str() );
+    }
+    else
+        SetFieldFromString( iField, pszValue );
+}
+
+/************************************************************************/
+/*                           SetFieldBinary()                           */
+/************************************************************************/
+
+/**
+ * \brief Set a binary field of the current feature.
+ *
+ * @see BeginFeature()
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetFieldBinary( int iField, const GByte *pabyData,
+                                      int nBytes )
+
+{
+    OGRFieldDefn* poFieldDefn = poDefn->GetFieldDefn( iField );
+    if( poFieldDefn == NULL )
+        return;
+
+    if( poFieldDefn->GetType() == OFTBinary )
+    {
+        SetVarValue( aoFields[iField], pabyData, nBytes );
+    }
+    else
+    {
+        GetConversionFeature()->SetField( iField, nBytes, (GByte*)pabyData );
+        SetFieldFromConversionFeature( iField );
+    }
+}
+
+/************************************************************************/
+/*                         SetFieldFromString()                         */
+/************************************************************************/
+
+/**
+ * \brief Set a field of the current feature from its string representation.
+ *
+ * The value is parsed as OGRFeature::SetField(int, const char*) does.
+ *
+ * @see BeginFeature()
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetFieldFromString( int iField, const char *pszValue )
+
+{
+    OGRFieldDefn* poFieldDefn = poDefn->GetFieldDefn( iField );
+    if( poFieldDefn == NULL )
+        return;
+
+    if( poFieldDefn->GetType() == OFTString ||
+        poFieldDefn->GetType() == OFTWideString )
+    {
+        SetVarValue( aoFields[iField], pszValue, strlen(pszValue) );
+    }
+    else
+    {
+        GetConversionFeature()->SetField( iField, pszValue );
+        SetFieldFromConversionFeature( iField );
+    }
+}
+
+/************************************************************************/
+/*                            SetFieldRaw()                             */
+/************************************************************************/
+
+/**
+ * \brief Set a field of the current feature from a value of its type.
+ *
+ * The value is copied. Unset values are ignored.
+ *
+ * @see BeginFeature()
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetFieldRaw( int iField, const OGRField *psField )
+
+{
+    OGRFieldDefn* poFieldDefn = poDefn->GetFieldDefn( iField );
+    if( poFieldDefn == NULL ||
+        (psField->Set.nMarker1 == OGRUnsetMarker &&
+         psField->Set.nMarker2 == OGRUnsetMarker) )
+        return;
+
+    OGRFeatureBatchColumn& oColumn = aoFields[iField];
+    switch( poFieldDefn->GetType() )
+    {
+        case OFTInteger:
+            SetFixedValue( iField, &psField->Integer );
+            break;
+
+        case OFTInteger64:
+            SetFixedValue( iField, &psField->Integer64 );
+            break;
+
+        case OFTReal:
+            SetFixedValue( iField, &psField->Real );
+            break;
+
+        case OFTDate:
+        case OFTTime:
+        case OFTDateTime:
+        {
+            OGRField sField;
+            memset( &sField, 0, sizeof(sField) );
+            sField.Date = psField->Date;
+            SetFixedValue( iField, &sField );
+            break;
+        }
+
+        case OFTString:
+        case OFTWideString:
+            SetVarValue( oColumn, psField->String, strlen(psField->String) );
+            break;
+
+        case OFTBinary:
+            SetVarValue( oColumn, psField->Binary.paData,
+                         psField->Binary.nCount );
+            break;
+
+        case OFTIntegerList:
+            SetVarValue( oColumn, psField->IntegerList.paList,
+                         psField->IntegerList.nCount * sizeof(int) );
+            break;
+
+        case OFTInteger64List:
+            SetVarValue( oColumn, psField->Integer64List.paList,
+                         psField->Integer64List.nCount * sizeof(GIntBig) );
+            break;
+
+        case OFTRealList:
+            SetVarValue( oColumn, psField->RealList.paList,
+                         psField->RealList.nCount * sizeof(double) );
+            break;
+
+        case OFTStringList:
+        {
+            size_t nSize = 0;
+            int i;
+            for( i = 0; i < psField->StringList.nCount; i++ )
+                nSize += strlen(psField->StringList.paList[i]) + 1;
+            GByte* pabyDst = AllocVarValue( oColumn, nSize );
+            for( i = 0; i < psField->StringList.nCount; i++ )
+            {
+                size_t nLen = strlen(psField->StringList.paList[i]) + 1;
+                memcpy( pabyDst, psField->StringList.paList[i], nLen );
+                pabyDst += nLen;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/************************************************************************/
+/*                          SetGeomFieldWKB()                           */
+/************************************************************************/
+
+/**
+ * \brief Set a geometry field of the current feature from a WKB blob.
+ *
+ * @param iGeomField the geometry field index.
+ * @param pabyWKB the WKB blob, copied.
+ * @param nSize size of pabyWKB in bytes.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetGeomFieldWKB( int iGeomField, const GByte *pabyWKB,
+                                       size_t nSize )
+
+{
+    if( iGeomField < 0 || iGeomField >= (int)aoGeomFields.size() )
+        return;
+    SetVarValue( aoGeomFields[iGeomField], pabyWKB, nSize );
+}
+
+/************************************************************************/
+/*                            SetGeomField()                            */
+/************************************************************************/
+
+/**
+ * \brief Set a geometry field of the current feature from a geometry.
+ *
+ * The geometry is exported as little endian ISO WKB. NULL geometries
+ * leave the field unset.
+ *
+ * @see BeginFeature()
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRFeatureBatch::SetGeomField( int iGeomField, OGRGeometry *poGeom )
+
+{
+    if( poGeom == NULL || iGeomField < 0 ||
+        iGeomField >= (int)aoGeomFields.size() )
+        return;
+
+    GByte* pabyWKB = AllocVarValue( aoGeomFields[iGeomField],
+                                    poGeom->WkbSize() );
+    poGeom->exportToWkb( wkbNDR, pabyWKB, wkbVariantIso );
+}
+
+/************************************************************************/
+/*                            OGR_FB_Create()                           */
+/************************************************************************/
+
+/**
+ * \brief Create an empty feature batch.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::OGRFeatureBatch().
+ *
+ * @param hDefn handle to the feature class (layer) definition of the
+ * features of the batch.
+ * @return a handle to the new batch, to destroy with OGR_FB_Destroy().
+ *
+ * @since GDAL 2.0
+ */
+
+OGRFeatureBatchH OGR_FB_Create( OGRFeatureDefnH hDefn )
+
+{
+    VALIDATE_POINTER1( hDefn, "OGR_FB_Create", NULL );
+
+    return (OGRFeatureBatchH) new OGRFeatureBatch( (OGRFeatureDefn *) hDefn );
+}
+
+/************************************************************************/
+/*                           OGR_FB_Destroy()                           */
+/************************************************************************/
+
+/**
+ * \brief Destroy a feature batch.
+ *
+ * @param hBatch handle to the batch to destroy.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGR_FB_Destroy( OGRFeatureBatchH hBatch )
+
+{
+    delete (OGRFeatureBatch *) hBatch;
+}
+
+/************************************************************************/
+/*                       OGR_FB_GetFeatureCount()                       */
+/************************************************************************/
+
+/**
+ * \brief Return the number of features of the batch.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::GetFeatureCount().
+ *
+ * @since GDAL 2.0
+ */
+
+int OGR_FB_GetFeatureCount( OGRFeatureBatchH hBatch )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFeatureCount", 0 );
+
+    return ((OGRFeatureBatch *) hBatch)->GetFeatureCount();
+}
+
+/************************************************************************/
+/*                           OGR_FB_GetFIDs()                           */
+/************************************************************************/
+
+/**
+ * \brief Return the feature ids of the features of the batch.
+ *
+ * This function is the same as the C++ method OGRFeatureBatch::GetFIDs().
+ *
+ * @since GDAL 2.0
+ */
+
+const GIntBig *OGR_FB_GetFIDs( OGRFeatureBatchH hBatch )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFIDs", NULL );
+
+    return ((OGRFeatureBatch *) hBatch)->GetFIDs();
+}
+
+/************************************************************************/
+/*                       OGR_FB_GetFieldValidity()                      */
+/************************************************************************/
+
+/**
+ * \brief Return the validity bitmap of a field.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::GetFieldValidity().
+ *
+ * @since GDAL 2.0
+ */
+
+const GByte *OGR_FB_GetFieldValidity( OGRFeatureBatchH hBatch, int iField )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFieldValidity", NULL );
+
+    return ((OGRFeatureBatch *) hBatch)->GetFieldValidity( iField );
+}
+
+/************************************************************************/
+/*                        OGR_FB_GetFieldValues()                       */
+/************************************************************************/
+
+/**
+ * \brief Return the values of a fixed size field.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::GetFieldValues().
+ *
+ * @since GDAL 2.0
+ */
+
+const void *OGR_FB_GetFieldValues( OGRFeatureBatchH hBatch, int iField )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFieldValues", NULL );
+
+    return ((OGRFeatureBatch *) hBatch)->GetFieldValues( iField );
+}
+
+/************************************************************************/
+/*                       OGR_FB_GetFieldOffsets()                       */
+/************************************************************************/
+
+/**
+ * \brief Return the offsets of the values of a variable length field.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::GetFieldOffsets().
+ *
+ * @since GDAL 2.0
+ */
+
+const GIntBig *OGR_FB_GetFieldOffsets( OGRFeatureBatchH hBatch, int iField )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFieldOffsets", NULL );
+
+    return ((OGRFeatureBatch *) hBatch)->GetFieldOffsets( iField );
+}
+
+/************************************************************************/
+/*                         OGR_FB_GetFieldData()                        */
+/************************************************************************/
+
+/**
+ * \brief Return the data buffer of a variable length field.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::GetFieldData().
+ *
+ * @since GDAL 2.0
+ */
+
+const GByte *OGR_FB_GetFieldData( OGRFeatureBatchH hBatch, int iField )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetFieldData", NULL );
+
+    return ((OGRFeatureBatch *) hBatch)->GetFieldData( iField );
+}
+
+/************************************************************************/
+/*                     OGR_FB_GetGeomFieldValidity()                    */
+/************************************************************************/
+
+/**
+ * \brief Return the validity bitmap of a geometry field.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::GetGeomFieldValidity().
+ *
+ * @since GDAL 2.0
+ */
+
+const GByte *OGR_FB_GetGeomFieldValidity( OGRFeatureBatchH hBatch,
+                                          int iGeomField )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetGeomFieldValidity", NULL );
+
+    return ((OGRFeatureBatch *) hBatch)->GetGeomFieldValidity( iGeomField );
+}
+
+/************************************************************************/
+/*                     OGR_FB_GetGeomFieldOffsets()                     */
+/************************************************************************/
+
+/**
+ * \brief Return the offsets of the WKB blobs of a geometry field.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::GetGeomFieldOffsets().
+ *
+ * @since GDAL 2.0
+ */
+
+const GIntBig *OGR_FB_GetGeomFieldOffsets( OGRFeatureBatchH hBatch,
+                                           int iGeomField )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetGeomFieldOffsets", NULL );
+
+    return ((OGRFeatureBatch *) hBatch)->GetGeomFieldOffsets( iGeomField );
+}
+
+/************************************************************************/
+/*                       OGR_FB_GetGeomFieldData()                      */
+/************************************************************************/
+
+/**
+ * \brief Return the buffer with the WKB blobs of a geometry field.
+ *
+ * This function is the same as the C++ method
+ * OGRFeatureBatch::GetGeomFieldData().
+ *
+ * @since GDAL 2.0
+ */
+
+const GByte *OGR_FB_GetGeomFieldData( OGRFeatureBatchH hBatch, int iGeomField )
+
+{
+    VALIDATE_POINTER1( hBatch, "OGR_FB_GetGeomFieldData", NULL );
+
+    return ((OGRFeatureBatch *) hBatch)->GetGeomFieldData( iGeomField );
+}
@@ -46,6 +46,877 @@ const char* SpecialFieldNames[SPECIAL_FIELD_COUNT]
 const swq_field_type SpecialFieldTypes[SPECIAL_FIELD_COUNT] 
 = {SWQ_INTEGER, SWQ_STRING, SWQ_STRING, SWQ_STRING, SWQ_FLOAT};
 
+static swq_expr_node *OGRFeatureFetcher( swq_expr_node *op, void *pFeatureIn );
+
+/************************************************************************/
+/* ==================================================================== */
+/*                        OGRFeatureQueryProgram                        */
+/*                                                                      */
+/*      Flat, typed form of a checked expression, built once by        */
+/*      Compile().  Comparisons between columns and constants are      */
+/*      evaluated directly against the OGRField values of a feature,   */
+/*      or against the columns of an OGRFeatureBatch, without          */
+/*      allocating any swq_expr_node.  Sub-expressions that cannot be  */
+/*      compiled (arithmetic, functions, geometry fields, ...) are     */
+/*      kept as a private clone of the node tree and evaluated with    */
+/*      swq_expr_node::Evaluate().  Results are the same as the ones   */
+/*      of SWQGeneralEvaluator().                                      */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Kind of the value returned by OGRFeatureFetcher() for a column */
+#define OQV_INTEGER     0
+#define OQV_INTEGER64   1
+#define OQV_FLOAT       2
+#define OQV_STRING      3
+
+/* Comparison domain, as selected by SWQGeneralEvaluator() */
+#define OQD_FLOAT       0
+#define OQD_INTEGER     1
+#define OQD_STRING      2
+
+/* Instructions that are not a swq_op */
+#define OQI_FALSE       1000
+#define OQI_FALLBACK    1001
+
+class OGRFeatureQueryOperand
+{
+  public:
+    int         bIsColumn;
+    int         iField;
+    int         nKind;          /* OQV_xxx, for a column */
+    int         bFID;
+    OGRFieldType eRawType;      /* type of the OGRField read directly, or */
+                                /* OFTMaxType to go through GetFieldAsXXX() */
+
+    GIntBig     nValue;         /* constant, in the domain of the instruction */
+    double      dfValue;
+    CPLString   osValue;
+};
+
+class OGRFeatureQueryInstr
+{
+  public:
+    int         nOp;            /* swq_op, OQI_FALSE or OQI_FALLBACK */
+    int         nDomain;        /* OQD_xxx */
+    int         bTimestampEQ;
+    char        chEscape;
+    int         iSub1;          /* operands of SWQ_AND, SWQ_OR and SWQ_NOT */
+    int         iSub2;
+    int         iFirstOperand;  /* operands of the other operations */
+    int         nOperands;
+    swq_expr_node *poFallback;  /* owned */
+};
+
+class OGRFeatureQueryProgram
+{
+    std::vector<OGRFeatureQueryInstr>   aoInstrs;
+    std::vector<OGRFeatureQueryOperand> aoOperands;
+    int                                 iRoot;
+    int                                 nLayerFieldCount;
+
+    int         AddInstr( int nOp );
+    int         AddFallback( swq_expr_node *poNode );
+    int         CompileOperand( OGRFeatureDefn *poDefn,
+                                swq_expr_node *poNode,
+                                OGRFeatureQueryOperand& oOperand );
+    int         CompileNode( OGRFeatureDefn *poDefn, swq_expr_node *poNode );
+
+    template<class Accessor> double  AsDouble( const OGRFeatureQueryOperand&,
+                                               Accessor& );
+    template<class Accessor> GIntBig AsInteger( const OGRFeatureQueryOperand&,
+                                                Accessor& );
+    template<class Accessor> const char *AsString( const OGRFeatureQueryOperand&,
+                                                   Accessor&, int iSlot );
+    template<class Accessor> int     EvaluateInstr( int iInstr, Accessor& );
+
+  public:
+                OGRFeatureQueryProgram();
+               ~OGRFeatureQueryProgram();
+
+    int         Compile( OGRFeatureDefn *poDefn, swq_expr_node *poExpr );
+    int         IsValidFor( OGRFeatureDefn *poDefn );
+
+    /* Returns TRUE, FALSE, or -1 if the result is NULL */
+    template<class Accessor> int Evaluate( Accessor& oAccessor )
+        { return EvaluateInstr( iRoot, oAccessor ); }
+};
+
+/************************************************************************/
+/*                       OGRFeatureQueryProgram()                       */
+/************************************************************************/
+
+OGRFeatureQueryProgram::OGRFeatureQueryProgram()
+
+{
+    iRoot = -1;
+    nLayerFieldCount = 0;
+}
+
+/************************************************************************/
+/*                      ~OGRFeatureQueryProgram()                       */
+/************************************************************************/
+
+OGRFeatureQueryProgram::~OGRFeatureQueryProgram()
+
+{
+    for( size_t i = 0; i < aoInstrs.size(); i++ )
+        delete aoInstrs[i].poFallback;
+}
+
+/************************************************************************/
+/*                              AddInstr()                              */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::AddInstr( int nOp )
+
+{
+    OGRFeatureQueryInstr oInstr;
+
+    oInstr.nOp = nOp;
+    oInstr.nDomain = OQD_INTEGER;
+    oInstr.bTimestampEQ = FALSE;
+    oInstr.chEscape = '\0';
+    oInstr.iSub1 = -1;
+    oInstr.iSub2 = -1;
+    oInstr.iFirstOperand = (int)aoOperands.size();
+    oInstr.nOperands = 0;
+    oInstr.poFallback = NULL;
+    aoInstrs.push_back( oInstr );
+
+    return (int)aoInstrs.size() - 1;
+}
+
+/************************************************************************/
+/*                            AddFallback()                             */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::AddFallback( swq_expr_node *poNode )
+
+{
+    int iInstr = AddInstr( OQI_FALLBACK );
+
+    /* Our own copy, since some drivers rewrite the expression tree */
+    /* after the filter has been compiled. */
+    aoInstrs[iInstr].poFallback = poNode->Clone();
+
+    return iInstr;
+}
+
+/************************************************************************/
+/*                           CompileOperand()                           */
+/*                                                                      */
+/*      Only columns of the layer (and FID) and constants are           */
+/*      directly evaluated.                                             */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::CompileOperand( OGRFeatureDefn *poDefn,
+                                            swq_expr_node *poNode,
+                                            OGRFeatureQueryOperand& oOperand )
+
+{
+    oOperand.bIsColumn = FALSE;
+    oOperand.iField = -1;
+    oOperand.nKind = OQV_INTEGER;
+    oOperand.bFID = FALSE;
+    oOperand.eRawType = OFTMaxType;
+    oOperand.nValue = 0;
+    oOperand.dfValue = 0.0;
+
+    if( poNode->eNodeType == SNT_CONSTANT )
+        return poNode->field_type != SWQ_GEOMETRY;
+
+    if( poNode->eNodeType != SNT_COLUMN || poNode->table_index != 0 )
+        return FALSE;
+
+    oOperand.bIsColumn = TRUE;
+    oOperand.iField = poNode->field_index;
+
+    if( poNode->field_index == nLayerFieldCount + SPF_FID )
+        oOperand.bFID = TRUE;
+    else if( poNode->field_index < 0 ||
+             poNode->field_index >= nLayerFieldCount )
+        return FALSE;
+
+    switch( poNode->field_type )
+    {
+      case SWQ_INTEGER:
+      case SWQ_BOOLEAN:
+        oOperand.nKind = OQV_INTEGER;
+        break;
+
+      case SWQ_INTEGER64:
+        oOperand.nKind = OQV_INTEGER64;
+        break;
+
+      case SWQ_FLOAT:
+        oOperand.nKind = OQV_FLOAT;
+        break;
+
+      case SWQ_GEOMETRY:
+        return FALSE;
+
+      default:
+        oOperand.nKind = OQV_STRING;
+        break;
+    }
+
+    if( !oOperand.bFID )
+    {
+        OGRFieldType eType = poDefn->GetFieldDefn(oOperand.iField)->GetType();
+        if( (oOperand.nKind == OQV_INTEGER && eType == OFTInteger) ||
+            (oOperand.nKind == OQV_INTEGER64 && eType == OFTInteger64) ||
+            (oOperand.nKind == OQV_FLOAT && eType == OFTReal) ||
+            (oOperand.nKind == OQV_STRING && eType == OFTString) )
+            oOperand.eRawType = eType;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        OGRFeatureQueryValueType()                    */
+/*                                                                      */
+/*      Type of the value node that swq_expr_node::Evaluate() would    */
+/*      pass to SWQGeneralEvaluator() for this operand.                 */
+/************************************************************************/
+
+static swq_field_type OGRFeatureQueryValueType( swq_expr_node *poNode,
+                                           const OGRFeatureQueryOperand& oOp )
+{
+    if( !oOp.bIsColumn )
+        return poNode->field_type;
+
+    switch( oOp.nKind )
+    {
+      case OQV_INTEGER:   return SWQ_INTEGER;
+      case OQV_INTEGER64: return SWQ_INTEGER64;
+      case OQV_FLOAT:     return SWQ_FLOAT;
+      default:            return SWQ_STRING;
+    }
+}
+
+/************************************************************************/
+/*                            CompileNode()                             */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::CompileNode( OGRFeatureDefn *poDefn,
+                                         swq_expr_node *poNode )
+
+{
+    int i;
+
+    /* Only boolean operations have a non NULL result as soon as one of */
+    /* their operands is NULL. */
+    if( poNode->eNodeType != SNT_OPERATION ||
+        poNode->field_type != SWQ_BOOLEAN )
+        return AddFallback( poNode );
+
+/* -------------------------------------------------------------------- */
+/*      Logical operators.                                              */
+/* -------------------------------------------------------------------- */
+    if( poNode->nOperation == SWQ_AND || poNode->nOperation == SWQ_OR ||
+        poNode->nOperation == SWQ_NOT )
+    {
+        int nExpected = (poNode->nOperation == SWQ_NOT) ? 1 : 2;
+        if( poNode->nSubExprCount != nExpected )
+            return AddFallback( poNode );
+
+        /* The operands must take the integer path of the evaluator */
+        for( i = 0; i < nExpected; i++ )
+        {
+            swq_field_type eType = poNode->papoSubExpr[i]->field_type;
+            if( !SWQ_IS_INTEGER(eType) && eType != SWQ_BOOLEAN )
+                return AddFallback( poNode );
+        }
+
+        int iSub1 = CompileNode( poDefn, poNode->papoSubExpr[0] );
+        int iSub2 = -1;
+        if( nExpected == 2 )
+            iSub2 = CompileNode( poDefn, poNode->papoSubExpr[1] );
+
+        int iInstr = AddInstr( poNode->nOperation );
+        aoInstrs[iInstr].iSub1 = iSub1;
+        aoInstrs[iInstr].iSub2 = iSub2;
+        return iInstr;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Comparisons.                                                    */
+/* -------------------------------------------------------------------- */
+    switch( poNode->nOperation )
+    {
+      case SWQ_EQ:
+      case SWQ_NE:
+      case SWQ_GE:
+      case SWQ_LE:
+      case SWQ_LT:
+      case SWQ_GT:
+        if( poNode->nSubExprCount != 2 )
+            return AddFallback( poNode );
+        break;
+
+      case SWQ_IN:
+        if( poNode->nSubExprCount < 2 )
+            return AddFallback( poNode );
+        break;
+
+      case SWQ_BETWEEN:
+        if( poNode->nSubExprCount != 3 )
+            return AddFallback( poNode );
+        break;
+
+      case SWQ_LIKE:
+        if( poNode->nSubExprCount != 2 && poNode->nSubExprCount != 3 )
+            return AddFallback( poNode );
+        break;
+
+      case SWQ_ISNULL:
+        if( poNode->nSubExprCount != 1 ||
+            poNode->papoSubExpr[0]->eNodeType != SNT_COLUMN )
+            return AddFallback( poNode );
+        break;
+
+      default:
+        return AddFallback( poNode );
+    }
+
+    int nOperands = poNode->nSubExprCount;
+    std::vector<OGRFeatureQueryOperand> aoNew( nOperands );
+    int bHasNullConstant = FALSE;
+
+    for( i = 0; i < nOperands; i++ )
+    {
+        if( !CompileOperand( poDefn, poNode->papoSubExpr[i], aoNew[i] ) )
+            return AddFallback( poNode );
+        if( !aoNew[i].bIsColumn && poNode->papoSubExpr[i]->is_null )
+            bHasNullConstant = TRUE;
+    }
+
+    if( poNode->nOperation == SWQ_ISNULL )
+    {
+        int iInstr = AddInstr( SWQ_ISNULL );
+        aoOperands.push_back( aoNew[0] );
+        aoInstrs[iInstr].nOperands = 1;
+        return iInstr;
+    }
+
+    /* A NULL operand makes the comparison FALSE, whatever the values */
+    if( bHasNullConstant )
+        return AddInstr( OQI_FALSE );
+
+    swq_field_type eType0 =
+        OGRFeatureQueryValueType( poNode->papoSubExpr[0], aoNew[0] );
+    swq_field_type eType1 =
+        OGRFeatureQueryValueType( poNode->papoSubExpr[1], aoNew[1] );
+    int nDomain;
+
+    if( eType0 == SWQ_FLOAT || eType1 == SWQ_FLOAT )
+        nDomain = OQD_FLOAT;
+    else if( SWQ_IS_INTEGER(eType0) || eType0 == SWQ_BOOLEAN )
+        nDomain = OQD_INTEGER;
+    else
+        nDomain = OQD_STRING;
+
+    char chEscape = '\0';
+    if( poNode->nOperation == SWQ_LIKE )
+    {
+        if( nDomain != OQD_STRING )
+            return AddFallback( poNode );
+        if( nOperands == 3 )
+        {
+            if( aoNew[2].bIsColumn ||
+                poNode->papoSubExpr[2]->string_value == NULL )
+                return AddFallback( poNode );
+            chEscape = poNode->papoSubExpr[2]->string_value[0];
+            nOperands = 2;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Resolve the operands in the domain of the comparison. Only     */
+/*      the first two operands are converted to float by the            */
+/*      evaluator, so the other ones must already be of that type.      */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < nOperands; i++ )
+    {
+        OGRFeatureQueryOperand& oOp = aoNew[i];
+        swq_expr_node *poSub = poNode->papoSubExpr[i];
+
+        if( oOp.bIsColumn )
+        {
+            int bOK;
+            if( nDomain == OQD_FLOAT )
+                bOK = oOp.nKind == OQV_FLOAT ||
+                      (i < 2 && oOp.nKind != OQV_STRING);
+            else if( nDomain == OQD_INTEGER )
+                bOK = oOp.nKind == OQV_INTEGER || oOp.nKind == OQV_INTEGER64;
+            else
+                bOK = oOp.nKind == OQV_STRING;
+            if( !bOK )
+                return AddFallback( poNode );
+        }
+        else if( nDomain == OQD_FLOAT )
+        {
+            if( i < 2 && SWQ_IS_INTEGER(poSub->field_type) )
+                oOp.dfValue = (double) poSub->int_value;
+            else
+                oOp.dfValue = poSub->float_value;
+        }
+        else if( nDomain == OQD_INTEGER )
+        {
+            oOp.nValue = poSub->int_value;
+        }
+        else
+        {
+            if( poSub->string_value == NULL )
+                return AddFallback( poNode );
+            oOp.osValue = poSub->string_value;
+        }
+    }
+
+    int iInstr = AddInstr( poNode->nOperation );
+    OGRFeatureQueryInstr& oInstr = aoInstrs[iInstr];
+
+    oInstr.nDomain = nDomain;
+    oInstr.chEscape = chEscape;
+    oInstr.bTimestampEQ = (eType0 == SWQ_TIMESTAMP || eType0 == SWQ_STRING) &&
+                          (eType1 == SWQ_TIMESTAMP || eType1 == SWQ_STRING);
+    oInstr.nOperands = nOperands;
+    for( i = 0; i < nOperands; i++ )
+        aoOperands.push_back( aoNew[i] );
+
+    return iInstr;
+}
+
+/************************************************************************/
+/*                              Compile()                               */
+/*                                                                      */
+/*      Returns FALSE if nothing could be compiled.                     */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::Compile( OGRFeatureDefn *poDefn,
+                                     swq_expr_node *poExpr )
+
+{
+    nLayerFieldCount = poDefn->GetFieldCount();
+    iRoot = CompileNode( poDefn, poExpr );
+
+    return aoInstrs[iRoot].nOp != OQI_FALLBACK;
+}
+
+/************************************************************************/
+/*                             IsValidFor()                             */
+/*                                                                      */
+/*      Check that the fields read directly still have the type they   */
+/*      had at compilation time.                                        */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::IsValidFor( OGRFeatureDefn *poDefn )
+
+{
+    if( poDefn->GetFieldCount() != nLayerFieldCount )
+        return FALSE;
+
+    for( size_t i = 0; i < aoOperands.size(); i++ )
+    {
+        const OGRFeatureQueryOperand& oOp = aoOperands[i];
+        if( oOp.eRawType != OFTMaxType &&
+            poDefn->GetFieldDefn(oOp.iField)->GetType() != oOp.eRawType )
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        AsDouble(), AsInteger()                       */
+/************************************************************************/
+
+template<class Accessor>
+double OGRFeatureQueryProgram::AsDouble( const OGRFeatureQueryOperand& oOp,
+                                         Accessor& oAccessor )
+{
+    if( !oOp.bIsColumn )
+        return oOp.dfValue;
+    if( oOp.nKind == OQV_FLOAT )
+        return oAccessor.GetDouble( oOp );
+    if( oOp.nKind == OQV_INTEGER )
+        return (double) oAccessor.GetInteger( oOp );
+    return (double) oAccessor.GetInteger64( oOp );
+}
+
+template<class Accessor>
+GIntBig OGRFeatureQueryProgram::AsInteger( const OGRFeatureQueryOperand& oOp,
+                                           Accessor& oAccessor )
+{
+    if( !oOp.bIsColumn )
+        return oOp.nValue;
+    if( oOp.nKind == OQV_INTEGER )
+        return oAccessor.GetInteger( oOp );
+    return oAccessor.GetInteger64( oOp );
+}
+
+template<class Accessor>
+const char *OGRFeatureQueryProgram::AsString( const OGRFeatureQueryOperand& oOp,
+                                              Accessor& oAccessor, int iSlot )
+{
+    if( !oOp.bIsColumn )
+        return oOp.osValue.c_str();
+    return oAccessor.GetString( oOp, iSlot );
+}
+
+/************************************************************************/
+/*                       OGRFeatureQueryStringEQ()                      */
+/*                                                                      */
+/*      Same as the SWQ_EQ string case of SWQGeneralEvaluator(): when   */
+/*      comparing timestamps, the +00 at the end might be discarded    */
+/*      if the other member has no explicit timezone.                  */
+/************************************************************************/
+
+static int OGRFeatureQueryStringEQ( const char *pszA, const char *pszB,
+                                    int bTimestampEQ )
+{
+    if( bTimestampEQ )
+    {
+        size_t nLenA = strlen(pszA);
+        size_t nLenB = strlen(pszB);
+
+        if( nLenA > 3 && nLenB > 3 )
+        {
+            if( strcmp(pszA + nLenA - 3, "+00") == 0 &&
+                pszB[nLenB - 3] == ':' )
+                return EQUALN(pszA, pszB, nLenB);
+            if( pszA[nLenA - 3] == ':' &&
+                strcmp(pszB + nLenB - 3, "+00") == 0 )
+                return EQUALN(pszA, pszB, nLenA);
+        }
+    }
+
+    return strcasecmp(pszA, pszB) == 0;
+}
+
+/************************************************************************/
+/*                           EvaluateInstr()                            */
+/************************************************************************/
+
+template<class Accessor>
+int OGRFeatureQueryProgram::EvaluateInstr( int iInstr, Accessor& oAccessor )
+
+{
+    const OGRFeatureQueryInstr& oInstr = aoInstrs[iInstr];
+    const OGRFeatureQueryOperand *paoOps = NULL;
+    int i;
+
+    switch( oInstr.nOp )
+    {
+      case OQI_FALSE:
+        return FALSE;
+
+      case OQI_FALLBACK:
+        return oAccessor.EvaluateFallback( oInstr.poFallback );
+
+      /* Any NULL operand makes AND, OR and NOT return FALSE */
+      case SWQ_AND:
+      {
+          if( EvaluateInstr( oInstr.iSub1, oAccessor ) <= 0 )
+              return FALSE;
+          return EvaluateInstr( oInstr.iSub2, oAccessor ) > 0;
+      }
+
+      case SWQ_OR:
+      {
+          int bRes1 = EvaluateInstr( oInstr.iSub1, oAccessor );
+          if( bRes1 < 0 )
+              return FALSE;
+          if( bRes1 && aoInstrs[oInstr.iSub2].nOp != OQI_FALLBACK )
+              return TRUE;
+          int bRes2 = EvaluateInstr( oInstr.iSub2, oAccessor );
+          if( bRes2 < 0 )
+              return FALSE;
+          return bRes1 || bRes2;
+      }
+
+      case SWQ_NOT:
+      {
+          int bRes = EvaluateInstr( oInstr.iSub1, oAccessor );
+          if( bRes < 0 )
+              return FALSE;
+          return !bRes;
+      }
+
+      default:
+        break;
+    }
+
+    paoOps = &aoOperands[oInstr.iFirstOperand];
+
+    if( oInstr.nOp == SWQ_ISNULL )
+        return !oAccessor.IsSet( paoOps[0] );
+
+    for( i = 0; i < oInstr.nOperands; i++ )
+    {
+        if( paoOps[i].bIsColumn && !oAccessor.IsSet( paoOps[i] ) )
+            return FALSE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Floating point comparisons.                                     */
+/* -------------------------------------------------------------------- */
+    if( oInstr.nDomain == OQD_FLOAT )
+    {
+        double dfValue = AsDouble( paoOps[0], oAccessor );
+
+        switch( oInstr.nOp )
+        {
+          case SWQ_EQ: return dfValue == AsDouble( paoOps[1], oAccessor );
+          case SWQ_NE: return dfValue != AsDouble( paoOps[1], oAccessor );
+          case SWQ_GT: return dfValue >  AsDouble( paoOps[1], oAccessor );
+          case SWQ_LT: return dfValue <  AsDouble( paoOps[1], oAccessor );
+          case SWQ_GE: return dfValue >= AsDouble( paoOps[1], oAccessor );
+          case SWQ_LE: return dfValue <= AsDouble( paoOps[1], oAccessor );
+          case SWQ_IN:
+            for( i = 1; i < oInstr.nOperands; i++ )
+            {
+                if( dfValue == AsDouble( paoOps[i], oAccessor ) )
+                    return TRUE;
+            }
+            return FALSE;
+          case SWQ_BETWEEN:
+            return dfValue >= AsDouble( paoOps[1], oAccessor ) &&
+                   dfValue <= AsDouble( paoOps[2], oAccessor );
+          default:
+            CPLAssert( FALSE );
+            return FALSE;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Integer comparisons.                                            */
+/* -------------------------------------------------------------------- */
+    if( oInstr.nDomain == OQD_INTEGER )
+    {
+        GIntBig nValue = AsInteger( paoOps[0], oAccessor );
+
+        switch( oInstr.nOp )
+        {
+          case SWQ_EQ: return nValue == AsInteger( paoOps[1], oAccessor );
+          case SWQ_NE: return nValue != AsInteger( paoOps[1], oAccessor );
+          case SWQ_GT: return nValue >  AsInteger( paoOps[1], oAccessor );
+          case SWQ_LT: return nValue <  AsInteger( paoOps[1], oAccessor );
+          case SWQ_GE: return nValue >= AsInteger( paoOps[1], oAccessor );
+          case SWQ_LE: return nValue <= AsInteger( paoOps[1], oAccessor );
+          case SWQ_IN:
+            for( i = 1; i < oInstr.nOperands; i++ )
+            {
+                if( nValue == AsInteger( paoOps[i], oAccessor ) )
+                    return TRUE;
+            }
+            return FALSE;
+          case SWQ_BETWEEN:
+            return nValue >= AsInteger( paoOps[1], oAccessor ) &&
+                   nValue <= AsInteger( paoOps[2], oAccessor );
+          default:
+            CPLAssert( FALSE );
+            return FALSE;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      String comparisons.                                             */
+/* -------------------------------------------------------------------- */
+    const char *pszValue = AsString( paoOps[0], oAccessor, 0 );
+
+    switch( oInstr.nOp )
+    {
+      case SWQ_EQ:
+        return OGRFeatureQueryStringEQ( pszValue,
+                                        AsString( paoOps[1], oAccessor, 1 ),
+                                        oInstr.bTimestampEQ );
+      case SWQ_NE:
+        return strcasecmp( pszValue, AsString( paoOps[1], oAccessor, 1 ) ) != 0;
+      case SWQ_GT:
+        return strcasecmp( pszValue, AsString( paoOps[1], oAccessor, 1 ) ) > 0;
+      case SWQ_LT:
+        return strcasecmp( pszValue, AsString( paoOps[1], oAccessor, 1 ) ) < 0;
+      case SWQ_GE:
+        return strcasecmp( pszValue, AsString( paoOps[1], oAccessor, 1 ) ) >= 0;
+      case SWQ_LE:
+        return strcasecmp( pszValue, AsString( paoOps[1], oAccessor, 1 ) ) <= 0;
+      case SWQ_IN:
+        for( i = 1; i < oInstr.nOperands; i++ )
+        {
+            if( strcasecmp( pszValue,
+                            AsString( paoOps[i], oAccessor, 1 ) ) == 0 )
+                return TRUE;
+        }
+        return FALSE;
+      case SWQ_BETWEEN:
+        return strcasecmp( pszValue, AsString( paoOps[1], oAccessor, 1 ) ) >= 0 &&
+               strcasecmp( pszValue, AsString( paoOps[2], oAccessor, 1 ) ) <= 0;
+      case SWQ_LIKE:
+        return swq_test_like( pszValue, AsString( paoOps[1], oAccessor, 1 ),
+                              oInstr.chEscape );
+      default:
+        CPLAssert( FALSE );
+        return FALSE;
+    }
+}
+
+/************************************************************************/
+/*                    OGRFeatureQueryFallbackResult()                   */
+/*                                                                      */
+/*      Logical value of an evaluated sub-expression, as seen by AND,  */
+/*      OR and NOT.                                                     */
+/************************************************************************/
+
+static int OGRFeatureQueryFallbackResult( swq_expr_node *poResult )
+{
+    if( poResult == NULL )
+        return -1;
+
+    int bRet = poResult->is_null ? -1 : (poResult->int_value != 0);
+    delete poResult;
+
+    return bRet;
+}
+
+/************************************************************************/
+/*                     OGRFeatureQueryFeatureAccessor                   */
+/************************************************************************/
+
+class OGRFeatureQueryFeatureAccessor
+{
+    OGRFeature *poFeature;
+    CPLString   aosValues[2];
+
+  public:
+    OGRFeatureQueryFeatureAccessor( OGRFeature *poFeatureIn ) :
+        poFeature(poFeatureIn) {}
+
+    int IsSet( const OGRFeatureQueryOperand& oOp )
+        { return poFeature->IsFieldSet( oOp.iField ); }
+
+    int GetInteger( const OGRFeatureQueryOperand& oOp )
+        { return oOp.eRawType != OFTMaxType ?
+                    poFeature->GetRawFieldRef(oOp.iField)->Integer :
+                    poFeature->GetFieldAsInteger(oOp.iField); }
+
+    GIntBig GetInteger64( const OGRFeatureQueryOperand& oOp )
+        { return oOp.eRawType != OFTMaxType ?
+                    poFeature->GetRawFieldRef(oOp.iField)->Integer64 :
+                    poFeature->GetFieldAsInteger64(oOp.iField); }
+
+    double GetDouble( const OGRFeatureQueryOperand& oOp )
+        { return oOp.eRawType != OFTMaxType ?
+                    poFeature->GetRawFieldRef(oOp.iField)->Real :
+                    poFeature->GetFieldAsDouble(oOp.iField); }
+
+    /* GetFieldAsString() may return a temporary buffer of the feature, */
+    /* that the next call would invalidate. */
+    const char *GetString( const OGRFeatureQueryOperand& oOp, int iSlot )
+    {
+        if( oOp.eRawType != OFTMaxType )
+            return poFeature->GetRawFieldRef(oOp.iField)->String;
+        aosValues[iSlot] = poFeature->GetFieldAsString(oOp.iField);
+        return aosValues[iSlot].c_str();
+    }
+
+    int EvaluateFallback( swq_expr_node *poNode )
+        { return OGRFeatureQueryFallbackResult(
+                    poNode->Evaluate( OGRFeatureFetcher, poFeature ) ); }
+};
+
+/************************************************************************/
+/*                      OGRFeatureQueryBatchAccessor                    */
+/*                                                                      */
+/*      Reads the columns of an OGRFeatureBatch. A feature is only     */
+/*      materialized for the fields that are not directly readable     */
+/*      and for the sub-expressions that were not compiled.            */
+/************************************************************************/
+
+class OGRFeatureQueryBatchAccessor
+{
+    OGRFeatureBatch *poBatch;
+    const GIntBig   *panFIDs;
+    int              iFeature;
+    OGRFeature      *poFeature;
+    CPLString        aosValues[2];
+
+    OGRFeature *GetFeature()
+    {
+        if( poFeature == NULL )
+            poFeature = poBatch->GetFeature( iFeature );
+        return poFeature;
+    }
+
+  public:
+    OGRFeatureQueryBatchAccessor( OGRFeatureBatch *poBatchIn ) :
+        poBatch(poBatchIn), panFIDs(poBatchIn->GetFIDs()),
+        iFeature(0), poFeature(NULL) {}
+    ~OGRFeatureQueryBatchAccessor() { delete poFeature; }
+
+    void SetFeatureIndex( int iFeatureIn )
+    {
+        delete poFeature;
+        poFeature = NULL;
+        iFeature = iFeatureIn;
+    }
+
+    int IsSet( const OGRFeatureQueryOperand& oOp )
+    {
+        if( oOp.bFID )
+            return panFIDs[iFeature] != OGRNullFID;
+        return poBatch->IsFieldSet( iFeature, oOp.iField );
+    }
+
+    int GetInteger( const OGRFeatureQueryOperand& oOp )
+    {
+        if( oOp.bFID )
+        {
+            GIntBig nFID = panFIDs[iFeature];
+            return (nFID > INT_MAX) ? INT_MAX :
+                   (nFID < INT_MIN) ? INT_MIN : (int) nFID;
+        }
+        if( oOp.eRawType != OFTMaxType )
+            return ((const int *)poBatch->GetFieldValues(oOp.iField))[iFeature];
+        return GetFeature()->GetFieldAsInteger( oOp.iField );
+    }
+
+    GIntBig GetInteger64( const OGRFeatureQueryOperand& oOp )
+    {
+        if( oOp.eRawType != OFTMaxType )
+            return ((const GIntBig *)poBatch->GetFieldValues(oOp.iField))[iFeature];
+        return GetFeature()->GetFieldAsInteger64( oOp.iField );
+    }
+
+    double GetDouble( const OGRFeatureQueryOperand& oOp )
+    {
+        if( oOp.eRawType != OFTMaxType )
+            return ((const double *)poBatch->GetFieldValues(oOp.iField))[iFeature];
+        return GetFeature()->GetFieldAsDouble( oOp.iField );
+    }
+
+    const char *GetString( const OGRFeatureQueryOperand& oOp, int iSlot )
+    {
+        if( oOp.eRawType != OFTMaxType )
+        {
+            const GIntBig *panOffsets = poBatch->GetFieldOffsets( oOp.iField );
+            const GByte *pabyData = poBatch->GetFieldData( oOp.iField );
+            aosValues[iSlot].assign(
+                (const char *)pabyData + panOffsets[iFeature],
+                (size_t)(panOffsets[iFeature+1] - panOffsets[iFeature]) );
+        }
+        else
+            aosValues[iSlot] = GetFeature()->GetFieldAsString( oOp.iField );
+        return aosValues[iSlot].c_str();
+    }
+
+    int EvaluateFallback( swq_expr_node *poNode )
+        { return OGRFeatureQueryFallbackResult(
+                    poNode->Evaluate( OGRFeatureFetcher, GetFeature() ) ); }
+};
+
 /************************************************************************/
 /*                          OGRFeatureQuery()                           */
 /************************************************************************/
@@ -55,6 +926,7 @@ OGRFeatureQuery::OGRFeatureQuery()
 {
     poTargetDefn = NULL;
     pSWQExpr = NULL;
+    poProgram = NULL;
 }
 
 /************************************************************************/
@@ -65,6 +937,7 @@ OGRFeatureQuery::~OGRFeatureQuery()
 
 {
     delete (swq_expr_node *) pSWQExpr;
+    delete poProgram;
 }
 
 /************************************************************************/
@@ -85,6 +958,8 @@ OGRErr OGRFeatureQuery::Compile( OGRFeatureDefn *poDefn,
         delete (swq_expr_node *) pSWQExpr;
         pSWQExpr = NULL;
     }
+    delete poProgram;
+    poProgram = NULL;
 
 /* -------------------------------------------------------------------- */
 /*      Build list of fields.                                           */
@@ -183,6 +1058,23 @@ OGRErr OGRFeatureQuery::Compile( OGRFeatureDefn *poDefn,
         pSWQExpr = NULL;
     }
 
+/* -------------------------------------------------------------------- */
+/*      Build the compiled form of a checked expression, unless        */
+/*      OGR_SQL_COMPILED_EVALUATION=NO asks for the evaluation of the  */
+/*      expression tree.                                                */
+/* -------------------------------------------------------------------- */
+    else if( bCheck &&
+             CSLTestBoolean(CPLGetConfigOption("OGR_SQL_COMPILED_EVALUATION",
+                                               "YES")) )
+    {
+        poProgram = new OGRFeatureQueryProgram();
+        if( !poProgram->Compile( poDefn, (swq_expr_node *) pSWQExpr ) )
+        {
+            delete poProgram;
+            poProgram = NULL;
+        }
+    }
+
     CPLFree( papszFieldNames );
     CPLFree( paeFieldTypes );
 
@@ -246,6 +1138,12 @@ int OGRFeatureQuery::Evaluate( OGRFeature *poFeature )
     if( pSWQExpr == NULL )
         return FALSE;
 
+    if( poProgram != NULL && poProgram->IsValidFor( poFeature->GetDefnRef() ) )
+    {
+        OGRFeatureQueryFeatureAccessor oAccessor( poFeature );
+        return poProgram->Evaluate( oAccessor ) > 0;
+    }
+
     swq_expr_node *poResult;
 
     poResult = ((swq_expr_node *) pSWQExpr)->Evaluate( OGRFeatureFetcher,
@@ -265,6 +1163,65 @@ int OGRFeatureQuery::Evaluate( OGRFeature *poFeature )
     return bLogicalResult;
 }
 
+/************************************************************************/
+/*                           EvaluateBatch()                            */
+/************************************************************************/
+
+/**
+ * \brief Evaluate the query against all the features of a batch.
+ *
+ * The batch must have been filled with features of the definition the
+ * query was compiled against. Compiled comparisons are directly evaluated
+ * on the columns of the batch, so that features are only materialized
+ * for the parts of the expression that could not be compiled.
+ *
+ * @param poBatch the batch of features.
+ * @param pabyResults array of poBatch->GetFeatureCount() values, set to
+ * TRUE for the features matching the query, and FALSE for the others.
+ *
+ * @return the number of matching features.
+ *
+ * @since GDAL 2.0
+ */
+
+int OGRFeatureQuery::EvaluateBatch( OGRFeatureBatch *poBatch,
+                                    GByte *pabyResults )
+
+{
+    int nFeatureCount = poBatch->GetFeatureCount();
+    int nMatches = 0;
+    int i;
+
+    if( pSWQExpr == NULL || poBatch->GetDefnRef() == NULL )
+    {
+        memset( pabyResults, 0, nFeatureCount );
+        return 0;
+    }
+
+    if( poProgram != NULL && poProgram->IsValidFor( poBatch->GetDefnRef() ) )
+    {
+        OGRFeatureQueryBatchAccessor oAccessor( poBatch );
+
+        for( i = 0; i < nFeatureCount; i++ )
+        {
+            oAccessor.SetFeatureIndex( i );
+            pabyResults[i] = (GByte) (poProgram->Evaluate( oAccessor ) > 0);
+            nMatches += pabyResults[i];
+        }
+        return nMatches;
+    }
+
+    for( i = 0; i < nFeatureCount; i++ )
+    {
+        OGRFeature *poFeature = poBatch->GetFeature( i );
+        pabyResults[i] = (GByte) (Evaluate( poFeature ) != 0);
+        nMatches += pabyResults[i];
+        delete poFeature;
+    }
+
+    return nMatches;
+}
+
 /************************************************************************/
 /*                            CanUseIndex()                             */
 /************************************************************************/
@@ -0,0 +1,464 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  The OGRLazyGeometry class, a geometry kept as WKB.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogr_geometry.h"
+#include "ogr_p.h"
+#include "ogr_spatialref.h"
+
+CPL_CVSID("$Id$");
+
+/* Same limit as the nesting of collections accepted by the WKB parsers */
+#define OGR_LAZY_MAX_DEPTH 32
+
+/************************************************************************/
+/*                          OGRLazyGeometry()                           */
+/************************************************************************/
+
+OGRLazyGeometry::OGRLazyGeometry() :
+    pabyWkb(NULL), nWkbSize(0), eGeometryType(wkbUnknown), bIs3D(FALSE),
+    bIsEmpty(TRUE), nByteOrder(-2), bHasOldOgcZ(FALSE), bHasIsoZ(FALSE),
+    poSRS(NULL)
+{
+    sEnvelope.MinX = 0.0;
+    sEnvelope.MaxX = 0.0;
+    sEnvelope.MinY = 0.0;
+    sEnvelope.MaxY = 0.0;
+}
+
+/************************************************************************/
+/*                          ~OGRLazyGeometry()                          */
+/************************************************************************/
+
+OGRLazyGeometry::~OGRLazyGeometry()
+{
+    CPLFree( pabyWkb );
+    if( poSRS != NULL )
+        poSRS->Release();
+}
+
+/************************************************************************/
+/*                              ScanWkb()                               */
+/*                                                                      */
+/*      Check one (sub-)geometry, and accumulate its properties. Only   */
+/*      the WKB that OGRGeometryFactory::createFromWkb() turns into     */
+/*      geometries with the same envelope and the same encoding is      */
+/*      accepted: linear types of consistent dimension, and no NaN      */
+/*      coordinate (which the parsers take as an empty point) nor       */
+/*      empty ring.                                                     */
+/************************************************************************/
+
+int OGRLazyGeometry::ScanWkb( const GByte *pabyData, int nSize,
+                              int nParentType, int nDepth,
+                              int *pnConsumed )
+{
+    if( nDepth > OGR_LAZY_MAX_DEPTH || nSize < 5 || pabyData[0] > 1 )
+        return FALSE;
+
+    OGRwkbByteOrder eByteOrder = (OGRwkbByteOrder) pabyData[0];
+    if( nByteOrder == -2 )
+        nByteOrder = eByteOrder;
+    else if( nByteOrder != (int)eByteOrder )
+        nByteOrder = -1;
+
+/* -------------------------------------------------------------------- */
+/*      Decode the type code.                                           */
+/* -------------------------------------------------------------------- */
+    GUInt32 nCode;
+    memcpy( &nCode, pabyData + 1, 4 );
+    if( OGR_SWAP( eByteOrder ) )
+        CPL_SWAP32PTR( &nCode );
+
+    int nType, b3D;
+    if( nCode & wkb25DBitInternalUse )
+    {
+        nType = (int)(nCode & ~wkb25DBitInternalUse);
+        b3D = TRUE;
+        bHasOldOgcZ = TRUE;
+    }
+    else if( nCode > 1000 && nCode < 1008 )
+    {
+        nType = (int)(nCode - 1000);
+        b3D = TRUE;
+        bHasIsoZ = TRUE;
+    }
+    else
+    {
+        nType = (int)nCode;
+        b3D = FALSE;
+    }
+    if( nType < (int)wkbPoint || nType > (int)wkbGeometryCollection )
+        return FALSE;
+
+    if( nParentType == 0 )
+    {
+        eGeometryType = (OGRwkbGeometryType) nType;
+        if( b3D )
+            eGeometryType = wkbSetZ(eGeometryType);
+        bIs3D = b3D;
+    }
+    else
+    {
+        if( b3D != bIs3D )
+            return FALSE;
+        if( (nParentType == wkbMultiPoint && nType != wkbPoint) ||
+            (nParentType == wkbMultiLineString && nType != wkbLineString) ||
+            (nParentType == wkbMultiPolygon && nType != wkbPolygon) )
+            return FALSE;
+    }
+
+    const int nPointSize = b3D ? 24 : 16;
+    int nOffset = 5;
+
+/* -------------------------------------------------------------------- */
+/*      Collections: scan the members.                                  */
+/* -------------------------------------------------------------------- */
+    if( nType >= (int)wkbMultiPoint )
+    {
+        GUInt32 nGeoms;
+        if( nSize - nOffset < 4 )
+            return FALSE;
+        memcpy( &nGeoms, pabyData + nOffset, 4 );
+        if( OGR_SWAP( eByteOrder ) )
+            CPL_SWAP32PTR( &nGeoms );
+        nOffset += 4;
+
+        /* Each member takes at least 9 bytes */
+        if( nGeoms > (GUInt32)(nSize - nOffset) / 9 )
+            return FALSE;
+
+        for( GUInt32 iGeom = 0; iGeom < nGeoms; iGeom++ )
+        {
+            int nSubConsumed = 0;
+            if( !ScanWkb( pabyData + nOffset, nSize - nOffset, nType,
+                          nDepth + 1, &nSubConsumed ) )
+                return FALSE;
+            nOffset += nSubConsumed;
+        }
+
+        *pnConsumed = nOffset;
+        return TRUE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Simple geometries: a point, a point list or a list of rings.    */
+/* -------------------------------------------------------------------- */
+    GUInt32 nRings = 1;
+    if( nType == wkbPolygon )
+    {
+        if( nSize - nOffset < 4 )
+            return FALSE;
+        memcpy( &nRings, pabyData + nOffset, 4 );
+        if( OGR_SWAP( eByteOrder ) )
+            CPL_SWAP32PTR( &nRings );
+        nOffset += 4;
+
+        if( nRings > (GUInt32)(nSize - nOffset) / 4 )
+            return FALSE;
+    }
+
+    for( GUInt32 iRing = 0; iRing < nRings; iRing++ )
+    {
+        GUInt32 nPoints = 1;
+        if( nType != wkbPoint )
+        {
+            if( nSize - nOffset < 4 )
+                return FALSE;
+            memcpy( &nPoints, pabyData + nOffset, 4 );
+            if( OGR_SWAP( eByteOrder ) )
+                CPL_SWAP32PTR( &nPoints );
+            nOffset += 4;
+
+            if( nType == wkbPolygon && nPoints == 0 )
+                return FALSE;
+        }
+
+        if( nPoints > (GUInt32)(nSize - nOffset) / nPointSize )
+            return FALSE;
+
+        for( GUInt32 iPoint = 0; iPoint < nPoints; iPoint++ )
+        {
+            double adfXYZ[3];
+
+            adfXYZ[2] = 0.0;
+            memcpy( adfXYZ, pabyData + nOffset, nPointSize );
+            if( OGR_SWAP( eByteOrder ) )
+            {
+                CPL_SWAPDOUBLE( adfXYZ + 0 );
+                CPL_SWAPDOUBLE( adfXYZ + 1 );
+                CPL_SWAPDOUBLE( adfXYZ + 2 );
+            }
+            nOffset += nPointSize;
+
+            if( CPLIsNan(adfXYZ[0]) || CPLIsNan(adfXYZ[1]) ||
+                CPLIsNan(adfXYZ[2]) )
+                return FALSE;
+
+            if( bIsEmpty )
+            {
+                sEnvelope.MinX = sEnvelope.MaxX = adfXYZ[0];
+                sEnvelope.MinY = sEnvelope.MaxY = adfXYZ[1];
+                sEnvelope.MinZ = sEnvelope.MaxZ = adfXYZ[2];
+                bIsEmpty = FALSE;
+            }
+            else
+            {
+                sEnvelope.MinX = MIN(sEnvelope.MinX, adfXYZ[0]);
+                sEnvelope.MaxX = MAX(sEnvelope.MaxX, adfXYZ[0]);
+                sEnvelope.MinY = MIN(sEnvelope.MinY, adfXYZ[1]);
+                sEnvelope.MaxY = MAX(sEnvelope.MaxY, adfXYZ[1]);
+                sEnvelope.MinZ = MIN(sEnvelope.MinZ, adfXYZ[2]);
+                sEnvelope.MaxZ = MAX(sEnvelope.MaxZ, adfXYZ[2]);
+            }
+        }
+    }
+
+    *pnConsumed = nOffset;
+    return TRUE;
+}
+
+/************************************************************************/
+/*                           CreateFromWkb()                            */
+/************************************************************************/
+
+/**
+ * \brief Create a lazy geometry from a WKB buffer.
+ *
+ * The buffer is scanned once to compute the properties of the geometry,
+ * and the bytes of the geometry are copied. Bytes after the end of the
+ * geometry are ignored, like OGRGeometryFactory::createFromWkb() does.
+ *
+ * Only the point, line string, polygon and collection types, in 2D or 3D,
+ * are handled. NULL is returned for other types, and for WKB that would
+ * not be imported unchanged (coordinates that are NaN, empty polygon rings,
+ * collections mixing 2D and 3D members). The caller can then parse the
+ * buffer with OGRGeometryFactory::createFromWkb(), which also reports the
+ * errors of corrupted WKB.
+ *
+ * @param pabyData the WKB buffer.
+ * @param nSize the size of the buffer in bytes.
+ * @param poSRS spatial reference system to assign to the materialized
+ * geometry, or NULL. It is referenced by the lazy geometry.
+ *
+ * @return a new lazy geometry, to destroy with delete, or NULL.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRLazyGeometry *OGRLazyGeometry::CreateFromWkb( const GByte *pabyData,
+                                                 int nSize,
+                                                 OGRSpatialReference *poSRS )
+{
+    if( pabyData == NULL || nSize <= 0 )
+        return NULL;
+
+    OGRLazyGeometry *poLazy = new OGRLazyGeometry();
+    int nConsumed = 0;
+
+    if( !poLazy->ScanWkb( pabyData, nSize, 0, 0, &nConsumed ) )
+    {
+        delete poLazy;
+        return NULL;
+    }
+
+    if( poLazy->bIsEmpty )
+    {
+        poLazy->sEnvelope.MinZ = 0.0;
+        poLazy->sEnvelope.MaxZ = 0.0;
+    }
+
+    poLazy->nWkbSize = nConsumed;
+    poLazy->pabyWkb = (GByte *) VSIMalloc( nConsumed );
+    if( poLazy->pabyWkb == NULL )
+    {
+        delete poLazy;
+        return NULL;
+    }
+    memcpy( poLazy->pabyWkb, pabyData, nConsumed );
+
+    poLazy->poSRS = poSRS;
+    if( poSRS != NULL )
+        poSRS->Reference();
+
+    return poLazy;
+}
+
+/************************************************************************/
+/*                               clone()                                */
+/************************************************************************/
+
+/**
+ * \brief Make a copy of this lazy geometry.
+ *
+ * The copy does not materialize the geometry.
+ *
+ * @return a new lazy geometry, to destroy with delete.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRLazyGeometry *OGRLazyGeometry::clone() const
+{
+    OGRLazyGeometry *poLazy = new OGRLazyGeometry();
+
+    poLazy->pabyWkb = (GByte *) CPLMalloc( nWkbSize );
+    memcpy( poLazy->pabyWkb, pabyWkb, nWkbSize );
+    poLazy->nWkbSize = nWkbSize;
+    poLazy->eGeometryType = eGeometryType;
+    poLazy->bIs3D = bIs3D;
+    poLazy->bIsEmpty = bIsEmpty;
+    poLazy->nByteOrder = nByteOrder;
+    poLazy->bHasOldOgcZ = bHasOldOgcZ;
+    poLazy->bHasIsoZ = bHasIsoZ;
+    poLazy->sEnvelope = sEnvelope;
+    poLazy->poSRS = poSRS;
+    if( poSRS != NULL )
+        poSRS->Reference();
+
+    return poLazy;
+}
+
+/************************************************************************/
+/*                            getEnvelope()                             */
+/************************************************************************/
+
+/**
+ * \brief Computes and returns the bounding envelope for this geometry.
+ *
+ * The envelope is the bounding box of all the coordinates of the geometry,
+ * computed when the lazy geometry was created, or zeros if the geometry
+ * is empty.
+ *
+ * @param psEnvelope the structure in which to place the results.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRLazyGeometry::getEnvelope( OGREnvelope *psEnvelope ) const
+{
+    psEnvelope->MinX = sEnvelope.MinX;
+    psEnvelope->MaxX = sEnvelope.MaxX;
+    psEnvelope->MinY = sEnvelope.MinY;
+    psEnvelope->MaxY = sEnvelope.MaxY;
+}
+
+/**
+ * \brief Computes and returns the 3D bounding envelope for this geometry.
+ *
+ * The envelope is the bounding box of all the coordinates of the geometry,
+ * computed when the lazy geometry was created, or zeros if the geometry
+ * is empty.
+ *
+ * @param psEnvelope the structure in which to place the results.
+ *
+ * @since GDAL 2.0
+ */
+
+void OGRLazyGeometry::getEnvelope( OGREnvelope3D *psEnvelope ) const
+{
+    *psEnvelope = sEnvelope;
+}
+
+/************************************************************************/
+/*                            exportToWkb()                             */
+/************************************************************************/
+
+/**
+ * \brief Convert the geometry to well known binary format.
+ *
+ * The stored bytes are copied when they already have the requested byte
+ * order and, for 3D geometries, the requested type codes. Otherwise the
+ * geometry is materialized into a temporary OGRGeometry to be exported.
+ *
+ * @param eByteOrder byte order of the output.
+ * @param pabyData buffer of at least WkbSize() bytes in which to write.
+ * @param eWkbVariant variant of the output, as in OGRGeometry::exportToWkb().
+ *
+ * @return Currently OGRERR_NONE is always returned, unless the geometry
+ * cannot be materialized.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRErr OGRLazyGeometry::exportToWkb( OGRwkbByteOrder eByteOrder,
+                                     unsigned char *pabyData,
+                                     OGRwkbVariant eWkbVariant ) const
+{
+    int bSameEncoding = (nByteOrder == (int)eByteOrder);
+
+    if( bSameEncoding && bIs3D )
+    {
+        /* wkbVariantPostGIS1 only differs from wkbVariantOldOgc for */
+        /* the curve types */
+        if( eWkbVariant == wkbVariantIso )
+            bSameEncoding = bHasIsoZ && !bHasOldOgcZ;
+        else
+            bSameEncoding = bHasOldOgcZ && !bHasIsoZ;
+    }
+
+    if( bSameEncoding )
+    {
+        memcpy( pabyData, pabyWkb, nWkbSize );
+        return OGRERR_NONE;
+    }
+
+    OGRGeometry *poGeom = materialize();
+    if( poGeom == NULL )
+        return OGRERR_CORRUPT_DATA;
+
+    OGRErr eErr = poGeom->exportToWkb( eByteOrder, pabyData, eWkbVariant );
+    delete poGeom;
+    return eErr;
+}
+
+/************************************************************************/
+/*                            materialize()                             */
+/************************************************************************/
+
+/**
+ * \brief Parse the geometry.
+ *
+ * @return a new geometry, to destroy with delete, with the spatial
+ * reference system of the lazy geometry, or NULL in case of failure.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRGeometry *OGRLazyGeometry::materialize() const
+{
+    OGRGeometry *poGeom = NULL;
+
+    if( OGRGeometryFactory::createFromWkb( pabyWkb, poSRS, &poGeom,
+                                           nWkbSize ) != OGRERR_NONE )
+    {
+        delete poGeom;
+        return NULL;
+    }
+
+    return poGeom;
+}
@@ -853,6 +853,7 @@ OGRLayer * OGRCouchDBDataSource::ExecuteSQLStats( const char *pszSQLCommand )
     if (sSelectInfo.join_defs != NULL ||
         sSelectInfo.where_expr != NULL ||
         sSelectInfo.order_defs != NULL ||
+        sSelectInfo.limit >= 0 || sSelectInfo.offset > 0 ||
         sSelectInfo.query_mode != SWQM_SUMMARY_RECORD)
     {
         return NULL;
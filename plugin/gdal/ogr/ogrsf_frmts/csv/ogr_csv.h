@@ -63,7 +63,9 @@ class OGRCSVLayer : public OGRLayer
 
     int                 bHasFieldNames;
 
-    OGRFeature *        GetNextUnfilteredFeature();
+    OGRFeature *        GetNextUnfilteredFeature(
+                                    OGRFeature *poFeatureToReuse = NULL );
+    OGRFeature *        ReadNextFeature( OGRFeature *poFeatureToReuse );
 
     int                 bNew;
     int                 bInWriteMode;
@@ -101,6 +103,10 @@ class OGRCSVLayer : public OGRLayer
     int                 bMergeDelimiter;
     
     char              **GetNextLineTokens();
+    int                 ParseBooleanToken( OGRFieldDefn* poFieldDefn,
+                                           const char* pszToken );
+    int                 CheckNumericToken( OGRFieldDefn* poFieldDefn,
+                                           char* pszToken );
 
   public:
     OGRCSVLayer( const char *pszName, VSILFILE *fp, const char *pszFilename,
@@ -113,6 +119,9 @@ class OGRCSVLayer : public OGRLayer
 
     void                ResetReading();
     OGRFeature *        GetNextFeature();
+    int                 GetNextFeatureInto( OGRFeature *poFeature );
+    int                 GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                             int nMaxFeatures );
     virtual OGRFeature* GetFeature( GIntBig nFID );
 
     OGRFeatureDefn *    GetLayerDefn() { return poFeatureDefn; }
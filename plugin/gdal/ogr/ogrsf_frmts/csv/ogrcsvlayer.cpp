@@ -1101,11 +1101,111 @@ OGRFeature* OGRCSVLayer::GetFeature(GIntBig nFID)
     return GetNextUnfilteredFeature();
 }
 
+/************************************************************************/
+/*                         ParseBooleanToken()                          */
+/*                                                                      */
+/*      Return 1 or 0 for a token of a boolean field, or -1 (and warn   */
+/*      the first time) if it is not a boolean value.                   */
+/************************************************************************/
+
+int OGRCSVLayer::ParseBooleanToken( OGRFieldDefn* poFieldDefn,
+                                    const char* pszToken )
+
+{
+    if( OGRCSVIsTrue(pszToken) || strcmp(pszToken, "1") == 0 )
+        return 1;
+    if( OGRCSVIsFalse(pszToken) || strcmp(pszToken, "0") == 0 )
+        return 0;
+    if( !bWarningBadTypeOrWidth )
+    {
+        bWarningBadTypeOrWidth = TRUE;
+        CPLError(CE_Warning, CPLE_AppDefined,
+                    "Invalid value type found in record %d for field %s. "
+                    "This warning will no longer be emitted",
+                    nNextFID, poFieldDefn->GetNameRef());
+    }
+    return -1;
+}
+
+/************************************************************************/
+/*                         CheckNumericToken()                          */
+/*                                                                      */
+/*      Return TRUE if a token of a numeric field can be set in the     */
+/*      field. Warn the first time a value does not fit the field       */
+/*      definition.                                                     */
+/************************************************************************/
+
+int OGRCSVLayer::CheckNumericToken( OGRFieldDefn* poFieldDefn,
+                                    char* pszToken )
+
+{
+    OGRFieldType eFieldType = poFieldDefn->GetType();
+    CPLValueType eType;
+
+    if (chDelimiter == ';' && eFieldType == OFTReal)
+    {
+        char* chComma = strchr(pszToken, ',');
+        if (chComma)
+            *chComma = '.';
+    }
+    eType = CPLGetValueType(pszToken);
+    if ( eType != CPL_VALUE_INTEGER && eType != CPL_VALUE_REAL )
+    {
+        if( !bWarningBadTypeOrWidth )
+        {
+            bWarningBadTypeOrWidth = TRUE;
+            CPLError(CE_Warning, CPLE_AppDefined,
+                        "Invalid value type found in record %d for field %s. "
+                        "This warning will no longer be emitted",
+                        nNextFID, poFieldDefn->GetNameRef());
+        }
+        return FALSE;
+    }
+
+    if( !bWarningBadTypeOrWidth &&
+        (eFieldType == OFTInteger || eFieldType == OFTInteger64) && eType == CPL_VALUE_REAL )
+    {
+        bWarningBadTypeOrWidth = TRUE;
+        CPLError(CE_Warning, CPLE_AppDefined,
+                 "Invalid value type found in record %d for field %s. "
+                 "This warning will no longer be emitted",
+                 nNextFID, poFieldDefn->GetNameRef());
+    }
+    else if( !bWarningBadTypeOrWidth && poFieldDefn->GetWidth() > 0 &&
+             (int)strlen(pszToken) > poFieldDefn->GetWidth() )
+    {
+        bWarningBadTypeOrWidth = TRUE;
+        CPLError(CE_Warning, CPLE_AppDefined,
+                 "Value with a width greater than field width found in record %d for field %s. "
+                 "This warning will no longer be emitted",
+                 nNextFID, poFieldDefn->GetNameRef());
+    }
+    else if( !bWarningBadTypeOrWidth && eType == CPL_VALUE_REAL &&
+             poFieldDefn->GetWidth() > 0)
+    {
+        const char* pszDot = strchr(pszToken, '.');
+        int nPrecision = 0;
+        if( pszDot != NULL )
+            nPrecision = strlen(pszDot + 1);
+        if( nPrecision > poFieldDefn->GetPrecision() )
+        {
+            bWarningBadTypeOrWidth = TRUE;
+            CPLError(CE_Warning, CPLE_AppDefined,
+                     "Value with a precision greater than field precision found in record %d for field %s. "
+                     "This warning will no longer be emitted",
+                     nNextFID, poFieldDefn->GetNameRef());
+        }
+    }
+
+    return TRUE;
+}
+
 /************************************************************************/
 /*                      GetNextUnfilteredFeature()                      */
 /************************************************************************/
 
-OGRFeature * OGRCSVLayer::GetNextUnfilteredFeature()
+OGRFeature * OGRCSVLayer::GetNextUnfilteredFeature(
+                                            OGRFeature *poFeatureToReuse )
 
 {
     if (fpCSV == NULL)
@@ -1119,11 +1219,17 @@ OGRFeature * OGRCSVLayer::GetNextUnfilteredFeature()
         return NULL;
 
 /* -------------------------------------------------------------------- */
-/*      Create the OGR feature.                                         */
+/*      Create the OGR feature, or reset the one passed by the caller.  */
 /* -------------------------------------------------------------------- */
     OGRFeature *poFeature;
 
-    poFeature = new OGRFeature( poFeatureDefn );
+    if( poFeatureToReuse != NULL )
+    {
+        poFeature = poFeatureToReuse;
+        poFeature->Reset();
+    }
+    else
+        poFeature = new OGRFeature( poFeatureDefn );
 
 /* -------------------------------------------------------------------- */
 /*      Set attributes for any indicated attribute records.             */
@@ -1158,24 +1264,9 @@ OGRFeature * OGRCSVLayer::GetNextUnfilteredFeature()
         {
             if (papszTokens[iAttr][0] != '\0' && !poFieldDefn->IsIgnored() )
             {
-                if( OGRCSVIsTrue(papszTokens[iAttr]) ||
-                    strcmp(papszTokens[iAttr], "1") == 0 )
-                {
-                    poFeature->SetField( iOGRField, 1 );
-                }
-                else if( OGRCSVIsFalse(papszTokens[iAttr]) ||
-                    strcmp(papszTokens[iAttr], "0") == 0 )
-                {
-                    poFeature->SetField( iOGRField, 0 );
-                }
-                else if( !bWarningBadTypeOrWidth )
-                {
-                    bWarningBadTypeOrWidth = TRUE;
-                    CPLError(CE_Warning, CPLE_AppDefined,
-                                "Invalid value type found in record %d for field %s. "
-                                "This warning will no longer be emitted",
-                                nNextFID, poFieldDefn->GetNameRef());
-                }
+                int nValue = ParseBooleanToken( poFieldDefn, papszTokens[iAttr] );
+                if( nValue >= 0 )
+                    poFeature->SetField( iOGRField, nValue );
             }
         }
         else if( eFieldType == OFTReal || eFieldType == OFTInteger ||
@@ -1183,62 +1274,8 @@ OGRFeature * OGRCSVLayer::GetNextUnfilteredFeature()
         {
             if (papszTokens[iAttr][0] != '\0' && !poFieldDefn->IsIgnored() )
             {
-                if (chDelimiter == ';' && eFieldType == OFTReal)
-                {
-                    char* chComma = strchr(papszTokens[iAttr], ',');
-                    if (chComma)
-                        *chComma = '.';
-                }
-                eType = CPLGetValueType(papszTokens[iAttr]);
-                if ( eType == CPL_VALUE_INTEGER || eType == CPL_VALUE_REAL )
-                {
+                if( CheckNumericToken( poFieldDefn, papszTokens[iAttr] ) )
                     poFeature->SetField( iOGRField, papszTokens[iAttr] );
-                    if( !bWarningBadTypeOrWidth &&
-                        (eFieldType == OFTInteger || eFieldType == OFTInteger64) && eType == CPL_VALUE_REAL )
-                    {
-                        bWarningBadTypeOrWidth = TRUE;
-                        CPLError(CE_Warning, CPLE_AppDefined,
-                                 "Invalid value type found in record %d for field %s. "
-                                 "This warning will no longer be emitted",
-                                 nNextFID, poFieldDefn->GetNameRef());
-                    }
-                    else if( !bWarningBadTypeOrWidth && poFieldDefn->GetWidth() > 0 &&
-                             (int)strlen(papszTokens[iAttr]) > poFieldDefn->GetWidth() )
-                    {
-                        bWarningBadTypeOrWidth = TRUE;
-                        CPLError(CE_Warning, CPLE_AppDefined,
-                                 "Value with a width greater than field width found in record %d for field %s. "
-                                 "This warning will no longer be emitted",
-                                 nNextFID, poFieldDefn->GetNameRef());
-                    }
-                    else if( !bWarningBadTypeOrWidth && eType == CPL_VALUE_REAL &&
-                             poFieldDefn->GetWidth() > 0)
-                    {
-                        const char* pszDot = strchr(papszTokens[iAttr], '.');
-                        int nPrecision = 0;
-                        if( pszDot != NULL )
-                            nPrecision = strlen(pszDot + 1);
-                        if( nPrecision > poFieldDefn->GetPrecision() )
-                        {
-                             bWarningBadTypeOrWidth = TRUE;
-                            CPLError(CE_Warning, CPLE_AppDefined,
-                                     "Value with a precision greater than field precision found in record %d for field %s. "
-                                     "This warning will no longer be emitted",
-                                     nNextFID, poFieldDefn->GetNameRef());
-                        }
-                    }
-                }
-                else
-                {
-                    if( !bWarningBadTypeOrWidth )
-                    {
-                        bWarningBadTypeOrWidth = TRUE;
-                        CPLError(CE_Warning, CPLE_AppDefined,
-                                    "Invalid value type found in record %d for field %s. "
-                                    "This warning will no longer be emitted",
-                                    nNextFID, poFieldDefn->GetNameRef());
-                    }
-                }
             }
         }
         else if (eFieldType != OFTString)
@@ -1388,6 +1425,38 @@ OGRFeature * OGRCSVLayer::GetNextUnfilteredFeature()
 
 OGRFeature *OGRCSVLayer::GetNextFeature()
 
+{
+    return ReadNextFeature( NULL );
+}
+
+/************************************************************************/
+/*                         GetNextFeatureInto()                         */
+/************************************************************************/
+
+int OGRCSVLayer::GetNextFeatureInto( OGRFeature *poFeature )
+
+{
+    if( poFeature->GetDefnRef() != poFeatureDefn )
+        return OGRLayer::GetNextFeatureInto( poFeature );
+
+    if( ReadNextFeature( poFeature ) == NULL )
+    {
+        poFeature->Reset();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                          ReadNextFeature()                           */
+/*                                                                      */
+/*      Read the next feature matching the filters, into               */
+/*      poFeatureToReuse if it is not NULL.                             */
+/************************************************************************/
+
+OGRFeature *OGRCSVLayer::ReadNextFeature( OGRFeature *poFeatureToReuse )
+
 {
     OGRFeature  *poFeature = NULL;
 
@@ -1400,7 +1469,7 @@ OGRFeature *OGRCSVLayer::GetNextFeature()
 /* -------------------------------------------------------------------- */
     while( TRUE )
     {
-        poFeature = GetNextUnfilteredFeature();
+        poFeature = GetNextUnfilteredFeature( poFeatureToReuse );
         if( poFeature == NULL )
             break;
 
@@ -1410,12 +1479,123 @@ OGRFeature *OGRCSVLayer::GetNextFeature()
                 || m_poAttrQuery->Evaluate( poFeature )) )
             break;
 
-        delete poFeature;
+        if( poFeature != poFeatureToReuse )
+            delete poFeature;
     }
 
     return poFeature;
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRCSVLayer::GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                      int nMaxFeatures )
+
+{
+    /* Filtered reads and the layouts needing more than one token per */
+    /* field go through GetNextFeature() */
+    if( m_poFilterGeom != NULL || m_poAttrQuery != NULL ||
+        bIsEurostatTSV || bKeepSourceColumns ||
+        iNfdcLatitudeS != -1 || iLatitudeField != -1 )
+        return OGRLayer::GetNextFeatureBatch( poBatch, nMaxFeatures );
+
+    if( bNeedRewindBeforeRead )
+        ResetReading();
+
+    poBatch->Reset( poFeatureDefn );
+    if (fpCSV == NULL)
+        return 0;
+
+    while( poBatch->GetFeatureCount() < nMaxFeatures )
+    {
+        char **papszTokens = GetNextLineTokens();
+        if( papszTokens == NULL )
+            break;
+
+        poBatch->BeginFeature( nNextFID );
+        const int iFeature = poBatch->GetFeatureCount() - 1;
+
+        int nAttrCount = MIN(CSLCount(papszTokens), nCSVFieldCount );
+        for( int iAttr = 0; iAttr < nAttrCount; iAttr++ )
+        {
+            char* pszToken = papszTokens[iAttr];
+
+            int iGeom = panGeomFieldIndex[iAttr];
+            if( iGeom >= 0 && pszToken[0] != '\0' &&
+                !(poFeatureDefn->GetGeomFieldDefn(iGeom)->IsIgnored()) )
+            {
+                char *pszWKT = pszToken;
+                OGRGeometry *poGeom = NULL;
+
+                if( OGRGeometryFactory::createFromWkt( &pszWKT, NULL, &poGeom )
+                    == OGRERR_NONE )
+                {
+                    poBatch->SetGeomField( iGeom, poGeom );
+                    delete poGeom;
+                }
+            }
+
+            OGRFieldDefn* poFieldDefn = poFeatureDefn->GetFieldDefn(iAttr);
+            if( poFieldDefn == NULL || poFieldDefn->IsIgnored() )
+                continue;
+
+            OGRFieldType eFieldType = poFieldDefn->GetType();
+            if( eFieldType == OFTString )
+            {
+                poBatch->SetFieldString( iAttr, pszToken );
+                if( !bWarningBadTypeOrWidth && poFieldDefn->GetWidth() > 0 &&
+                    (int)strlen(pszToken) > poFieldDefn->GetWidth() )
+                {
+                    bWarningBadTypeOrWidth = TRUE;
+                    CPLError(CE_Warning, CPLE_AppDefined,
+                                "Value with a width greater than field width found in record %d for field %s. "
+                                "This warning will no longer be emitted",
+                                nNextFID, poFieldDefn->GetNameRef());
+                }
+            }
+            else if( pszToken[0] == '\0' )
+            {
+                /* unset */
+            }
+            else if( eFieldType == OFTInteger &&
+                     poFieldDefn->GetSubType() == OFSTBoolean )
+            {
+                int nValue = ParseBooleanToken( poFieldDefn, pszToken );
+                if( nValue >= 0 )
+                    poBatch->SetFieldInteger( iAttr, nValue );
+            }
+            else if( eFieldType == OFTReal || eFieldType == OFTInteger ||
+                     eFieldType == OFTInteger64 )
+            {
+                if( CheckNumericToken( poFieldDefn, pszToken ) )
+                    poBatch->SetFieldFromString( iAttr, pszToken );
+            }
+            else
+            {
+                poBatch->SetFieldFromString( iAttr, pszToken );
+                if( !bWarningBadTypeOrWidth &&
+                    !poBatch->IsFieldSet( iFeature, iAttr ) )
+                {
+                    bWarningBadTypeOrWidth = TRUE;
+                    CPLError(CE_Warning, CPLE_AppDefined,
+                             "Invalid value type found in record %d for field %s. "
+                             "This warning will no longer be emitted",
+                             nNextFID, poFieldDefn->GetNameRef());
+                }
+            }
+        }
+
+        CSLDestroy( papszTokens );
+
+        nNextFID++;
+        m_nFeaturesRead++;
+    }
+
+    return poBatch->GetFeatureCount();
+}
+
 /************************************************************************/
 /*                           TestCapability()                           */
 /************************************************************************/
@@ -0,0 +1,1395 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Implementation of OGRExternalSorter and of the feature
+ *           serialization used for temporary files.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogr_externalsort.h"
+#include "ogr_geometry.h"
+#include "cpl_conv.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <algorithm>
+
+CPL_CVSID("$Id$");
+
+/* Size of the blocks of the sorted file indexed by their first key */
+#define SORTED_BLOCK_SIZE   16384
+
+/* Size of the buffers used to read and write temporary files */
+#define IO_BUFFER_SIZE      65536
+
+/* Minimum number of records sorted by each thread */
+#define MIN_RECORDS_PER_THREAD  65536
+
+/************************************************************************/
+/*                        OGRGetSQLMemoryLimit()                        */
+/*                                                                      */
+/*      Memory, in bytes, that OGR SQL may use for joins and sorts     */
+/*      before spilling to temporary files. Set with the               */
+/*      OGR_SQL_MEMORY_LIMIT configuration option, in megabytes.       */
+/************************************************************************/
+
+size_t OGRGetSQLMemoryLimit()
+
+{
+    GIntBig nLimitMB =
+        CPLAtoGIntBig( CPLGetConfigOption( "OGR_SQL_MEMORY_LIMIT", "100" ) );
+    if( nLimitMB < 1 )
+        nLimitMB = 1;
+    if( (GUIntBig)nLimitMB > (GUIntBig)(~((size_t)0)) / (1024 * 1024) )
+        return ~((size_t)0);
+    return (size_t)nLimitMB * 1024 * 1024;
+}
+
+/************************************************************************/
+/*                        OGRGetSQLThreadCount()                        */
+/*                                                                      */
+/*      Number of threads that OGR SQL may use for sorts and           */
+/*      aggregations, from the GDAL_NUM_THREADS configuration option.  */
+/*      Single threaded by default.                                     */
+/************************************************************************/
+
+int OGRGetSQLThreadCount()
+
+{
+    const char *pszThreads =
+        CPLGetConfigOption( "GDAL_NUM_THREADS", "1" );
+    int nThreads = EQUAL(pszThreads, "ALL_CPUS") ? CPLGetNumCPUs() :
+                                                   atoi(pszThreads);
+    return MAX( 1, MIN( nThreads, 128 ) );
+}
+
+/************************************************************************/
+/*                       OGREstimateFeatureMemory()                     */
+/************************************************************************/
+
+size_t OGREstimateFeatureMemory( OGRFeature *poFeature )
+
+{
+    OGRFeatureDefn *poDefn = poFeature->GetDefnRef();
+    size_t nSize = sizeof(OGRFeature) +
+        poDefn->GetFieldCount() * sizeof(OGRField) +
+        poDefn->GetGeomFieldCount() * sizeof(OGRGeometry*);
+
+    for( int iField = 0; iField < poDefn->GetFieldCount(); iField++ )
+    {
+        if( !poFeature->IsFieldSet( iField ) )
+            continue;
+
+        OGRField *psField = poFeature->GetRawFieldRef( iField );
+        switch( poDefn->GetFieldDefn(iField)->GetType() )
+        {
+          case OFTString:
+            nSize += strlen(psField->String) + 1;
+            break;
+          case OFTBinary:
+            nSize += psField->Binary.nCount;
+            break;
+          case OFTIntegerList:
+            nSize += psField->IntegerList.nCount * sizeof(int);
+            break;
+          case OFTInteger64List:
+            nSize += psField->Integer64List.nCount * sizeof(GIntBig);
+            break;
+          case OFTRealList:
+            nSize += psField->RealList.nCount * sizeof(double);
+            break;
+          case OFTStringList:
+            for( int i = 0; i < psField->StringList.nCount; i++ )
+                nSize += sizeof(char*) + strlen(psField->StringList.paList[i]) + 1;
+            break;
+          default:
+            break;
+        }
+    }
+
+    for( int iGeom = 0; iGeom < poDefn->GetGeomFieldCount(); iGeom++ )
+    {
+        OGRGeometry *poGeom = poFeature->GetGeomFieldRef( iGeom );
+        if( poGeom != NULL )
+            nSize += 64 + poGeom->WkbSize();
+    }
+
+    if( poFeature->GetStyleString() != NULL )
+        nSize += strlen(poFeature->GetStyleString()) + 1;
+
+    return nSize;
+}
+
+/************************************************************************/
+/*                         OGRSerializeFeature()                        */
+/************************************************************************/
+
+static void AppendBytes( std::vector<GByte>& abyOut,
+                         const void *pData, size_t nSize )
+{
+    const GByte *pabyData = (const GByte *) pData;
+    abyOut.insert( abyOut.end(), pabyData, pabyData + nSize );
+}
+
+static void AppendInt( std::vector<GByte>& abyOut, int nValue )
+{
+    AppendBytes( abyOut, &nValue, sizeof(int) );
+}
+
+static void AppendString( std::vector<GByte>& abyOut, const char *pszValue )
+{
+    int nLen = (int) strlen(pszValue);
+    AppendInt( abyOut, nLen );
+    AppendBytes( abyOut, pszValue, nLen );
+}
+
+void OGRSerializeFeature( OGRFeature *poFeature, std::vector<GByte>& abyOut )
+
+{
+    OGRFeatureDefn *poDefn = poFeature->GetDefnRef();
+    GIntBig nFID = poFeature->GetFID();
+
+    AppendBytes( abyOut, &nFID, sizeof(nFID) );
+
+    const char *pszStyle = poFeature->GetStyleString();
+    if( pszStyle == NULL )
+        AppendInt( abyOut, -1 );
+    else
+        AppendString( abyOut, pszStyle );
+
+    for( int iField = 0; iField < poDefn->GetFieldCount(); iField++ )
+    {
+        if( !poFeature->IsFieldSet( iField ) )
+        {
+            abyOut.push_back( 0 );
+            continue;
+        }
+        abyOut.push_back( 1 );
+
+        OGRField *psField = poFeature->GetRawFieldRef( iField );
+        switch( poDefn->GetFieldDefn(iField)->GetType() )
+        {
+          case OFTInteger:
+            AppendInt( abyOut, psField->Integer );
+            break;
+
+          case OFTInteger64:
+            AppendBytes( abyOut, &psField->Integer64, sizeof(GIntBig) );
+            break;
+
+          case OFTReal:
+            AppendBytes( abyOut, &psField->Real, sizeof(double) );
+            break;
+
+          case OFTString:
+            AppendString( abyOut, psField->String );
+            break;
+
+          case OFTBinary:
+            AppendInt( abyOut, psField->Binary.nCount );
+            AppendBytes( abyOut, psField->Binary.paData,
+                         psField->Binary.nCount );
+            break;
+
+          case OFTIntegerList:
+            AppendInt( abyOut, psField->IntegerList.nCount );
+            AppendBytes( abyOut, psField->IntegerList.paList,
+                         psField->IntegerList.nCount * sizeof(int) );
+            break;
+
+          case OFTInteger64List:
+            AppendInt( abyOut, psField->Integer64List.nCount );
+            AppendBytes( abyOut, psField->Integer64List.paList,
+                         psField->Integer64List.nCount * sizeof(GIntBig) );
+            break;
+
+          case OFTRealList:
+            AppendInt( abyOut, psField->RealList.nCount );
+            AppendBytes( abyOut, psField->RealList.paList,
+                         psField->RealList.nCount * sizeof(double) );
+            break;
+
+          case OFTStringList:
+            AppendInt( abyOut, psField->StringList.nCount );
+            for( int i = 0; i < psField->StringList.nCount; i++ )
+                AppendString( abyOut, psField->StringList.paList[i] );
+            break;
+
+          case OFTDate:
+          case OFTTime:
+          case OFTDateTime:
+            AppendBytes( abyOut, &psField->Date, sizeof(psField->Date) );
+            break;
+
+          default:
+            break;
+        }
+    }
+
+    for( int iGeom = 0; iGeom < poDefn->GetGeomFieldCount(); iGeom++ )
+    {
+        OGRGeometry *poGeom = poFeature->GetGeomFieldRef( iGeom );
+        if( poGeom == NULL )
+        {
+            AppendInt( abyOut, 0 );
+            continue;
+        }
+
+        int nWKBSize = poGeom->WkbSize();
+        AppendInt( abyOut, nWKBSize );
+        size_t nOffset = abyOut.size();
+        abyOut.resize( nOffset + nWKBSize );
+        poGeom->exportToWkb( wkbNDR, &abyOut[nOffset], wkbVariantIso );
+    }
+}
+
+/************************************************************************/
+/*                        OGRDeserializeFeature()                       */
+/************************************************************************/
+
+class OGRSerializedFeatureReader
+{
+    const GByte *pabyCur;
+    const GByte *pabyEnd;
+
+  public:
+    OGRSerializedFeatureReader( const GByte *pabyData, size_t nSize ) :
+        pabyCur(pabyData), pabyEnd(pabyData + nSize) {}
+
+    int Read( void *pDst, size_t nSize )
+    {
+        if( (size_t)(pabyEnd - pabyCur) < nSize )
+            return FALSE;
+        memcpy( pDst, pabyCur, nSize );
+        pabyCur += nSize;
+        return TRUE;
+    }
+
+    const GByte *Skip( size_t nSize )
+    {
+        if( (size_t)(pabyEnd - pabyCur) < nSize )
+            return NULL;
+        const GByte *pabyRet = pabyCur;
+        pabyCur += nSize;
+        return pabyRet;
+    }
+
+    int ReadCount( int& nCount )
+    {
+        return Read( &nCount, sizeof(int) ) && nCount >= 0;
+    }
+
+    int ReadString( CPLString& osValue )
+    {
+        int nLen;
+        const GByte *pabyData;
+        if( !ReadCount( nLen ) || (pabyData = Skip( nLen )) == NULL )
+            return FALSE;
+        osValue.assign( (const char *) pabyData, nLen );
+        return TRUE;
+    }
+};
+
+int OGRDeserializeFeature( const GByte *pabyData, size_t nSize,
+                           OGRFeature *poFeature )
+
+{
+    OGRFeatureDefn *poDefn = poFeature->GetDefnRef();
+    OGRSerializedFeatureReader oReader( pabyData, nSize );
+    GIntBig nFID;
+    int nLen;
+    CPLString osValue;
+
+    if( !oReader.Read( &nFID, sizeof(nFID) ) ||
+        !oReader.Read( &nLen, sizeof(int) ) )
+        return FALSE;
+    poFeature->SetFID( nFID );
+
+    if( nLen < 0 )
+        poFeature->SetStyleString( NULL );
+    else
+    {
+        const GByte *pabyStyle = oReader.Skip( nLen );
+        if( pabyStyle == NULL )
+            return FALSE;
+        osValue.assign( (const char *) pabyStyle, nLen );
+        poFeature->SetStyleString( osValue );
+    }
+
+    for( int iField = 0; iField < poDefn->GetFieldCount(); iField++ )
+    {
+        GByte bSet;
+        if( !oReader.Read( &bSet, 1 ) )
+            return FALSE;
+        if( !bSet )
+        {
+            poFeature->UnsetField( iField );
+            continue;
+        }
+
+        const GByte *pabyValues;
+        int nCount;
+
+        switch( poDefn->GetFieldDefn(iField)->GetType() )
+        {
+          case OFTInteger:
+          {
+              int nValue;
+              if( !oReader.Read( &nValue, sizeof(int) ) )
+                  return FALSE;
+              poFeature->SetField( iField, nValue );
+              break;
+          }
+
+          case OFTInteger64:
+          {
+              GIntBig nValue;
+              if( !oReader.Read( &nValue, sizeof(GIntBig) ) )
+                  return FALSE;
+              poFeature->SetField( iField, nValue );
+              break;
+          }
+
+          case OFTReal:
+          {
+              double dfValue;
+              if( !oReader.Read( &dfValue, sizeof(double) ) )
+                  return FALSE;
+              poFeature->SetField( iField, dfValue );
+              break;
+          }
+
+          case OFTString:
+            if( !oReader.ReadString( osValue ) )
+                return FALSE;
+            poFeature->SetField( iField, osValue.c_str() );
+            break;
+
+          case OFTBinary:
+            if( !oReader.ReadCount( nCount ) ||
+                (pabyValues = oReader.Skip( nCount )) == NULL )
+                return FALSE;
+            poFeature->SetField( iField, nCount, (GByte *) pabyValues );
+            break;
+
+          case OFTIntegerList:
+          {
+              if( !oReader.ReadCount( nCount ) ||
+                  (pabyValues = oReader.Skip( nCount * sizeof(int) )) == NULL )
+                  return FALSE;
+              std::vector<int> anValues( nCount + 1 );
+              memcpy( &anValues[0], pabyValues, nCount * sizeof(int) );
+              poFeature->SetField( iField, nCount, &anValues[0] );
+              break;
+          }
+
+          case OFTInteger64List:
+          {
+              if( !oReader.ReadCount( nCount ) ||
+                  (pabyValues = oReader.Skip( nCount * sizeof(GIntBig) )) == NULL )
+                  return FALSE;
+              std::vector<GIntBig> anValues( nCount + 1 );
+              memcpy( &anValues[0], pabyValues, nCount * sizeof(GIntBig) );
+              poFeature->SetField( iField, nCount, &anValues[0] );
+              break;
+          }
+
+          case OFTRealList:
+          {
+              if( !oReader.ReadCount( nCount ) ||
+                  (pabyValues = oReader.Skip( nCount * sizeof(double) )) == NULL )
+                  return FALSE;
+              std::vector<double> adfValues( nCount + 1 );
+              memcpy( &adfValues[0], pabyValues, nCount * sizeof(double) );
+              poFeature->SetField( iField, nCount, &adfValues[0] );
+              break;
+          }
+
+          case OFTStringList:
+          {
+              CPLStringList aosList;
+              if( !oReader.ReadCount( nCount ) )
+                  return FALSE;
+              for( int i = 0; i < nCount; i++ )
+              {
+                  if( !oReader.ReadString( osValue ) )
+                      return FALSE;
+                  aosList.AddString( osValue );
+              }
+              poFeature->SetField( iField, aosList.List() );
+              break;
+          }
+
+          case OFTDate:
+          case OFTTime:
+          case OFTDateTime:
+          {
+              OGRField sField;
+              if( !oReader.Read( &sField.Date, sizeof(sField.Date) ) )
+                  return FALSE;
+              poFeature->SetField( iField, &sField );
+              break;
+          }
+
+          default:
+            break;
+        }
+    }
+
+    for( int iGeom = 0; iGeom < poDefn->GetGeomFieldCount(); iGeom++ )
+    {
+        int nWKBSize;
+        const GByte *pabyWKB;
+        OGRGeometry *poGeom = NULL;
+
+        if( !oReader.ReadCount( nWKBSize ) ||
+            (pabyWKB = oReader.Skip( nWKBSize )) == NULL )
+            return FALSE;
+
+        if( nWKBSize > 0 )
+        {
+            if( OGRGeometryFactory::createFromWkb( (unsigned char *) pabyWKB,
+                                                   NULL, &poGeom, nWKBSize,
+                                                   wkbVariantIso )
+                != OGRERR_NONE )
+                return FALSE;
+            poGeom->assignSpatialReference(
+                poDefn->GetGeomFieldDefn(iGeom)->GetSpatialRef() );
+        }
+        poFeature->SetGeomFieldDirectly( iGeom, poGeom );
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                         OGRExternalSortReader                        */
+/*                                                                      */
+/*      Buffered sequential reader of the records of a section of a    */
+/*      temporary file.                                                 */
+/* ==================================================================== */
+/************************************************************************/
+
+class OGRExternalSortReader
+{
+    VSILFILE           *fp;
+    vsi_l_offset        nOffset;
+    vsi_l_offset        nEnd;
+    std::vector<GByte>  abyBuffer;
+    size_t              nBufferPos;
+    size_t              nBufferSize;
+    size_t              nChunkSize;
+
+    int                 Fill( size_t nNeeded );
+
+  public:
+    CPLString           osKey;
+    std::vector<GByte>  abyPayload;
+
+                        OGRExternalSortReader( VSILFILE *fpIn,
+                                               size_t nChunkSizeIn ) :
+                            fp(fpIn), nOffset(0), nEnd(0),
+                            nBufferPos(0), nBufferSize(0),
+                            nChunkSize(nChunkSizeIn) {}
+
+    void                Seek( vsi_l_offset nStart, vsi_l_offset nEndIn );
+    int                 ReadRecord();
+};
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+void OGRExternalSortReader::Seek( vsi_l_offset nStart, vsi_l_offset nEndIn )
+
+{
+    nOffset = nStart;
+    nEnd = nEndIn;
+    nBufferPos = 0;
+    nBufferSize = 0;
+}
+
+/************************************************************************/
+/*                                Fill()                                */
+/*                                                                      */
+/*      Make sure that nNeeded bytes are available from nBufferPos.     */
+/************************************************************************/
+
+int OGRExternalSortReader::Fill( size_t nNeeded )
+
+{
+    if( nBufferSize - nBufferPos >= nNeeded )
+        return TRUE;
+
+    size_t nRemaining = nBufferSize - nBufferPos;
+    if( nRemaining > 0 && nBufferPos > 0 )
+        memmove( &abyBuffer[0], &abyBuffer[nBufferPos], nRemaining );
+    nBufferPos = 0;
+    nBufferSize = nRemaining;
+
+    size_t nToRead = MAX( nNeeded - nRemaining, nChunkSize );
+    if( (vsi_l_offset)nToRead > nEnd - nOffset )
+        nToRead = (size_t)(nEnd - nOffset);
+    if( nRemaining + nToRead < nNeeded )
+        return FALSE;
+
+    if( abyBuffer.size() < nRemaining + nToRead )
+        abyBuffer.resize( nRemaining + nToRead );
+
+    /* The file may be shared by several readers */
+    if( VSIFSeekL( fp, nOffset, SEEK_SET ) != 0 ||
+        VSIFReadL( &abyBuffer[nRemaining], 1, nToRead, fp ) != nToRead )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot read temporary sort file." );
+        return FALSE;
+    }
+    nOffset += nToRead;
+    nBufferSize += nToRead;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                             ReadRecord()                             */
+/*                                                                      */
+/*      Returns TRUE if a record has been read in osKey and abyPayload. */
+/************************************************************************/
+
+int OGRExternalSortReader::ReadRecord()
+
+{
+    GUInt32 anSizes[2];
+
+    if( nBufferPos == nBufferSize && nOffset == nEnd )
+        return FALSE;
+
+    if( !Fill( sizeof(anSizes) ) )
+        return FALSE;
+    memcpy( anSizes, &abyBuffer[nBufferPos], sizeof(anSizes) );
+
+    if( !Fill( sizeof(anSizes) + anSizes[0] + anSizes[1] ) )
+        return FALSE;
+
+    const GByte *pabyRecord = &abyBuffer[nBufferPos] + sizeof(anSizes);
+    osKey.assign( (const char *) pabyRecord, anSizes[0] );
+    abyPayload.assign( pabyRecord + anSizes[0],
+                           pabyRecord + anSizes[0] + anSizes[1] );
+    nBufferPos += sizeof(anSizes) + anSizes[0] + anSizes[1];
+
+    return TRUE;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          OGRExternalSorter                           */
+/* ==================================================================== */
+/************************************************************************/
+
+/************************************************************************/
+/*                          OGRExternalSorter()                         */
+/*                                                                      */
+/*      If bUnique is TRUE, only the first record added with a given   */
+/*      key is kept.                                                    */
+/************************************************************************/
+
+OGRExternalSorter::OGRExternalSorter( size_t nMemoryLimitIn, int bUniqueIn )
+
+{
+    nMemoryLimit = nMemoryLimitIn;
+    bUnique = bUniqueIn;
+    bFinished = FALSE;
+    bError = FALSE;
+    nMaxRecords = 0;
+    nGarbageSize = 0;
+    fpRuns = NULL;
+    fpSorted = NULL;
+    nSortedSize = 0;
+    nSortedRecords = 0;
+    iNextRecord = 0;
+    poReader = NULL;
+}
+
+/************************************************************************/
+/*                         ~OGRExternalSorter()                         */
+/************************************************************************/
+
+OGRExternalSorter::~OGRExternalSorter()
+
+{
+    delete poReader;
+
+    if( fpRuns != NULL )
+    {
+        VSIFCloseL( fpRuns );
+        VSIUnlink( osRunsFilename );
+    }
+    if( fpSorted != NULL )
+    {
+        VSIFCloseL( fpSorted );
+        VSIUnlink( osSortedFilename );
+    }
+}
+
+/************************************************************************/
+/*                          Record accessors                            */
+/************************************************************************/
+
+#define RECORD_KEY_SIZE(pabyRecord)     (((const GUInt32 *)(pabyRecord))[0])
+#define RECORD_PAYLOAD_SIZE(pabyRecord) (((const GUInt32 *)(pabyRecord))[1])
+#define RECORD_KEY(pabyRecord)          ((pabyRecord) + 2 * sizeof(GUInt32))
+#define RECORD_SIZE(pabyRecord)         (2 * sizeof(GUInt32) + \
+                                         RECORD_KEY_SIZE(pabyRecord) + \
+                                         RECORD_PAYLOAD_SIZE(pabyRecord))
+/* Records are kept aligned for their size headers */
+#define RECORD_ALLOC_SIZE(nSize)        (((nSize) + sizeof(GUInt32) - 1) / \
+                                         sizeof(GUInt32) * sizeof(GUInt32))
+
+static int CompareKeys( const GByte *pabyKey1, size_t nKeySize1,
+                        const GByte *pabyKey2, size_t nKeySize2 )
+{
+    int nRet = memcmp( pabyKey1, pabyKey2, MIN(nKeySize1, nKeySize2) );
+    if( nRet != 0 )
+        return nRet;
+    if( nKeySize1 == nKeySize2 )
+        return 0;
+    return nKeySize1 < nKeySize2 ? -1 : 1;
+}
+
+/* Sorts offsets of records by key, and then by insertion order */
+class OGRExternalSortRecordLess
+{
+    const GByte *pabyRecords;
+
+  public:
+    OGRExternalSortRecordLess( const GByte *pabyRecordsIn ) :
+        pabyRecords(pabyRecordsIn) {}
+
+    bool operator()( size_t nOffset1, size_t nOffset2 ) const
+    {
+        const GByte *pabyRecord1 = pabyRecords + nOffset1;
+        const GByte *pabyRecord2 = pabyRecords + nOffset2;
+        int nRet = CompareKeys( RECORD_KEY(pabyRecord1),
+                                RECORD_KEY_SIZE(pabyRecord1),
+                                RECORD_KEY(pabyRecord2),
+                                RECORD_KEY_SIZE(pabyRecord2) );
+        if( nRet != 0 )
+            return nRet < 0;
+        return nOffset1 < nOffset2;
+    }
+};
+
+/* Compares the key of a record with a searched key */
+class OGRExternalSortKeyLess
+{
+    const GByte *pabyRecords;
+
+  public:
+    OGRExternalSortKeyLess( const GByte *pabyRecordsIn ) :
+        pabyRecords(pabyRecordsIn) {}
+
+    bool operator()( size_t nOffset, const CPLString& osKey ) const
+    {
+        const GByte *pabyRecord = pabyRecords + nOffset;
+        return CompareKeys( RECORD_KEY(pabyRecord),
+                            RECORD_KEY_SIZE(pabyRecord),
+                            (const GByte *) osKey.data(), osKey.size() ) < 0;
+    }
+};
+
+/************************************************************************/
+/*                           SetMaxRecords()                            */
+/*                                                                      */
+/*      Only the nMaxRecordsIn first records of the sorted output will */
+/*      be read. Must be called before adding records, and cannot be   */
+/*      combined with the unique mode.                                  */
+/************************************************************************/
+
+void OGRExternalSorter::SetMaxRecords( GUIntBig nMaxRecordsIn )
+
+{
+    CPLAssert( !bUnique && anRecordOffsets.empty() );
+    nMaxRecords = nMaxRecordsIn;
+}
+
+/************************************************************************/
+/*                            AppendRecord()                            */
+/************************************************************************/
+
+void OGRExternalSorter::AppendRecord( const void *pKey, size_t nKeySize,
+                                      const void *pPayload,
+                                      size_t nPayloadSize )
+
+{
+    GUInt32 anSizes[2];
+    anSizes[0] = (GUInt32) nKeySize;
+    anSizes[1] = (GUInt32) nPayloadSize;
+
+    size_t nOffset = abyRecords.size();
+    size_t nRecordSize = sizeof(anSizes) + nKeySize + nPayloadSize;
+
+    abyRecords.resize( nOffset + RECORD_ALLOC_SIZE(nRecordSize) );
+    memcpy( &abyRecords[nOffset], anSizes, sizeof(anSizes) );
+    if( nKeySize > 0 )
+        memcpy( &abyRecords[nOffset + sizeof(anSizes)], pKey, nKeySize );
+    if( nPayloadSize > 0 )
+        memcpy( &abyRecords[nOffset + sizeof(anSizes) + nKeySize],
+                pPayload, nPayloadSize );
+    anRecordOffsets.push_back( nOffset );
+}
+
+/************************************************************************/
+/*                             AddRecord()                              */
+/************************************************************************/
+
+int OGRExternalSorter::AddRecord( const void *pKey, size_t nKeySize,
+                                  const void *pPayload, size_t nPayloadSize )
+
+{
+    if( bFinished || bError )
+        return FALSE;
+
+    if( nMaxRecords > 0 )
+        return AddTopRecord( pKey, nKeySize, pPayload, nPayloadSize );
+
+    AppendRecord( pKey, nKeySize, pPayload, nPayloadSize );
+
+    if( abyRecords.size() + anRecordOffsets.size() * sizeof(size_t)
+        > nMemoryLimit )
+        return FlushRun();
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                            AddTopRecord()                            */
+/*                                                                      */
+/*      Top-N mode of AddRecord(). Once the heap is full, a record     */
+/*      only enters it if it sorts before its greatest record, that is */
+/*      then discarded.                                                 */
+/************************************************************************/
+
+int OGRExternalSorter::AddTopRecord( const void *pKey, size_t nKeySize,
+                                     const void *pPayload,
+                                     size_t nPayloadSize )
+
+{
+    if( (GUIntBig)anRecordOffsets.size() >= nMaxRecords )
+    {
+        /* On ties, the record added last sorts last */
+        const GByte *pabyTop = &abyRecords[anRecordOffsets[0]];
+        if( CompareKeys( (const GByte *) pKey, nKeySize,
+                         RECORD_KEY(pabyTop), RECORD_KEY_SIZE(pabyTop) ) >= 0 )
+            return TRUE;
+    }
+
+    AppendRecord( pKey, nKeySize, pPayload, nPayloadSize );
+    std::push_heap( anRecordOffsets.begin(), anRecordOffsets.end(),
+                    OGRExternalSortRecordLess( &abyRecords[0] ) );
+
+    if( (GUIntBig)anRecordOffsets.size() > nMaxRecords )
+    {
+        std::pop_heap( anRecordOffsets.begin(), anRecordOffsets.end(),
+                       OGRExternalSortRecordLess( &abyRecords[0] ) );
+        nGarbageSize += RECORD_ALLOC_SIZE(
+            RECORD_SIZE(&abyRecords[anRecordOffsets.back()]) );
+        anRecordOffsets.pop_back();
+
+        if( nGarbageSize > abyRecords.size() / 2 )
+            CompactRecords();
+    }
+
+/* -------------------------------------------------------------------- */
+/*      If the retained records do not fit in memory, fallback to a    */
+/*      full external sort. The first records of its output are the    */
+/*      same.                                                           */
+/* -------------------------------------------------------------------- */
+    if( abyRecords.size() - nGarbageSize +
+        anRecordOffsets.size() * sizeof(size_t) > nMemoryLimit )
+    {
+        CPLDebug( "OGR", "External sort: top " CPL_FRMT_GUIB " records "
+                  "do not fit in memory.", nMaxRecords );
+        nMaxRecords = 0;
+        return FlushRun();
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                           CompactRecords()                           */
+/*                                                                      */
+/*      Remove the garbage left in abyRecords by the top-N mode. The   */
+/*      relative order of the offsets, and thus the heap, is kept.     */
+/************************************************************************/
+
+void OGRExternalSorter::CompactRecords()
+
+{
+    std::vector<size_t> anSortedOffsets( anRecordOffsets );
+    std::sort( anSortedOffsets.begin(), anSortedOffsets.end() );
+
+    std::vector<GByte> abyNewRecords;
+    std::vector<size_t> anNewOffsets;
+    abyNewRecords.reserve( abyRecords.size() - nGarbageSize );
+    anNewOffsets.reserve( anSortedOffsets.size() );
+
+    for( size_t i = 0; i < anSortedOffsets.size(); i++ )
+    {
+        const GByte *pabyRecord = &abyRecords[anSortedOffsets[i]];
+        anNewOffsets.push_back( abyNewRecords.size() );
+        abyNewRecords.insert( abyNewRecords.end(), pabyRecord,
+                              pabyRecord +
+                              RECORD_ALLOC_SIZE(RECORD_SIZE(pabyRecord)) );
+    }
+
+    for( size_t i = 0; i < anRecordOffsets.size(); i++ )
+    {
+        size_t iSorted = std::lower_bound( anSortedOffsets.begin(),
+                                           anSortedOffsets.end(),
+                                           anRecordOffsets[i] ) -
+                         anSortedOffsets.begin();
+        anRecordOffsets[i] = anNewOffsets[iSorted];
+    }
+
+    abyRecords.swap( abyNewRecords );
+    nGarbageSize = 0;
+}
+
+/************************************************************************/
+/*                         SortRecordsThread()                          */
+/************************************************************************/
+
+typedef struct
+{
+    const GByte *pabyRecords;
+    size_t      *panBegin;
+    size_t      *panMiddle;
+    size_t      *panEnd;
+} OGRExternalSortJob;
+
+static void SortRecordsThread( void *pData )
+{
+    OGRExternalSortJob *psJob = (OGRExternalSortJob *) pData;
+    std::sort( psJob->panBegin, psJob->panEnd,
+               OGRExternalSortRecordLess( psJob->pabyRecords ) );
+}
+
+static void MergeRecordsThread( void *pData )
+{
+    OGRExternalSortJob *psJob = (OGRExternalSortJob *) pData;
+    std::inplace_merge( psJob->panBegin, psJob->panMiddle, psJob->panEnd,
+                        OGRExternalSortRecordLess( psJob->pabyRecords ) );
+}
+
+/************************************************************************/
+/*                       GetSortThreadCount()                           */
+/************************************************************************/
+
+static int GetSortThreadCount( size_t nRecords )
+{
+    int nThreads = OGRGetSQLThreadCount();
+    int nMaxThreads = (int) MIN( (size_t)128,
+                                 nRecords / MIN_RECORDS_PER_THREAD );
+    return MAX( 1, MIN( nThreads, nMaxThreads ) );
+}
+
+/************************************************************************/
+/*                            SortRecords()                             */
+/*                                                                      */
+/*      Sort the in-memory records, and drop duplicated keys in        */
+/*      unique mode. Large sets of records are split between threads,  */
+/*      and the sorted slices merged. As the comparison breaks ties    */
+/*      with the offsets, the result does not depend on the number of  */
+/*      threads.                                                        */
+/************************************************************************/
+
+void OGRExternalSorter::SortRecords()
+
+{
+    if( anRecordOffsets.empty() )
+        return;
+
+    const GByte *pabyRecords = &abyRecords[0];
+    size_t nRecords = anRecordOffsets.size();
+    int nThreads = GetSortThreadCount( nRecords );
+    CPLWorkerThreadPool oPool;
+
+    if( nThreads > 1 && oPool.Setup( nThreads ) )
+    {
+        std::vector<OGRExternalSortJob> asJobs( nThreads );
+        std::vector<size_t> anBounds;
+        size_t *panOffsets = &anRecordOffsets[0];
+        int i;
+
+        for( i = 0; i <= nThreads; i++ )
+            anBounds.push_back( (size_t)((GUIntBig)nRecords * i / nThreads) );
+
+        for( i = 0; i < nThreads; i++ )
+        {
+            asJobs[i].pabyRecords = pabyRecords;
+            asJobs[i].panBegin = panOffsets + anBounds[i];
+            asJobs[i].panMiddle = NULL;
+            asJobs[i].panEnd = panOffsets + anBounds[i+1];
+            oPool.SubmitJob( SortRecordsThread, &asJobs[i] );
+        }
+        oPool.WaitCompletion();
+
+        /* Merge adjacent sorted slices, two by two */
+        while( anBounds.size() > 2 )
+        {
+            std::vector<size_t> anNewBounds;
+            int nJobs = 0;
+
+            for( i = 0; i + 2 < (int)anBounds.size(); i += 2 )
+            {
+                asJobs[nJobs].panBegin = panOffsets + anBounds[i];
+                asJobs[nJobs].panMiddle = panOffsets + anBounds[i+1];
+                asJobs[nJobs].panEnd = panOffsets + anBounds[i+2];
+                oPool.SubmitJob( MergeRecordsThread, &asJobs[nJobs] );
+                nJobs ++;
+                anNewBounds.push_back( anBounds[i] );
+            }
+            if( i + 1 < (int)anBounds.size() )
+                anNewBounds.push_back( anBounds[i] );
+            anNewBounds.push_back( anBounds.back() );
+            oPool.WaitCompletion();
+
+            anBounds.swap( anNewBounds );
+        }
+    }
+    else
+    {
+        std::sort( anRecordOffsets.begin(), anRecordOffsets.end(),
+                   OGRExternalSortRecordLess( pabyRecords ) );
+    }
+
+    if( !bUnique )
+        return;
+
+    size_t nKept = 1;
+    for( size_t i = 1; i < anRecordOffsets.size(); i++ )
+    {
+        const GByte *pabyPrev = pabyRecords + anRecordOffsets[nKept - 1];
+        const GByte *pabyCur = pabyRecords + anRecordOffsets[i];
+        if( CompareKeys( RECORD_KEY(pabyPrev), RECORD_KEY_SIZE(pabyPrev),
+                         RECORD_KEY(pabyCur), RECORD_KEY_SIZE(pabyCur) ) != 0 )
+            anRecordOffsets[nKept++] = anRecordOffsets[i];
+    }
+    anRecordOffsets.resize( nKept );
+}
+
+/************************************************************************/
+/*                           WriteBuffered()                            */
+/************************************************************************/
+
+static int WriteBuffered( VSILFILE *fp, std::vector<GByte>& abyBuffer,
+                          const GByte *pabyData, size_t nSize, int bFlush )
+{
+    abyBuffer.insert( abyBuffer.end(), pabyData, pabyData + nSize );
+
+    if( abyBuffer.empty() || (!bFlush && abyBuffer.size() < IO_BUFFER_SIZE) )
+        return TRUE;
+
+    if( VSIFWriteL( &abyBuffer[0], 1, abyBuffer.size(), fp ) !=
+        abyBuffer.size() )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot write temporary sort file." );
+        return FALSE;
+    }
+    abyBuffer.resize( 0 );
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                              FlushRun()                              */
+/*                                                                      */
+/*      Write the in-memory records as a sorted run.                   */
+/************************************************************************/
+
+int OGRExternalSorter::FlushRun()
+
+{
+    if( fpRuns == NULL )
+    {
+        osRunsFilename = CPLGenerateTempFilename( "ogr_sort_runs" );
+        fpRuns = VSIFOpenL( osRunsFilename, "wb+" );
+        if( fpRuns == NULL )
+        {
+            CPLError( CE_Failure, CPLE_FileIO,
+                      "Cannot create temporary sort file %s.",
+                      osRunsFilename.c_str() );
+            bError = TRUE;
+            return FALSE;
+        }
+    }
+
+    SortRecords();
+
+    VSIFSeekL( fpRuns, 0, SEEK_END );
+    anRunOffsets.push_back( VSIFTellL( fpRuns ) );
+
+    std::vector<GByte> abyBuffer;
+    for( size_t i = 0; i < anRecordOffsets.size() && !bError; i++ )
+    {
+        const GByte *pabyRecord = &abyRecords[anRecordOffsets[i]];
+        if( !WriteBuffered( fpRuns, abyBuffer, pabyRecord,
+                            RECORD_SIZE(pabyRecord), FALSE ) )
+            bError = TRUE;
+    }
+    if( !bError && !WriteBuffered( fpRuns, abyBuffer, NULL, 0, TRUE ) )
+        bError = TRUE;
+
+    abyRecords.resize( 0 );
+    anRecordOffsets.resize( 0 );
+    nGarbageSize = 0;
+
+    return !bError;
+}
+
+/************************************************************************/
+/*                             MergeRuns()                              */
+/*                                                                      */
+/*      Merge the sorted runs into the sorted file, and index the      */
+/*      first key of each of its blocks.                               */
+/************************************************************************/
+
+int OGRExternalSorter::MergeRuns()
+
+{
+    osSortedFilename = CPLGenerateTempFilename( "ogr_sort" );
+    fpSorted = VSIFOpenL( osSortedFilename, "wb+" );
+    if( fpSorted == NULL )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot create temporary sort file %s.",
+                  osSortedFilename.c_str() );
+        return FALSE;
+    }
+
+    VSIFSeekL( fpRuns, 0, SEEK_END );
+    anRunOffsets.push_back( VSIFTellL( fpRuns ) );
+
+    int nRuns = (int)anRunOffsets.size() - 1;
+    std::vector<OGRExternalSortReader*> apoReaders;
+    std::vector<int> abValid;
+    int i;
+
+    /* Split the memory between the readers of the runs */
+    size_t nChunkSize = MAX( (size_t)4096,
+                             MIN( (size_t)IO_BUFFER_SIZE,
+                                  nMemoryLimit / (nRuns + 1) ) );
+    for( i = 0; i < nRuns; i++ )
+    {
+        apoReaders.push_back( new OGRExternalSortReader( fpRuns, nChunkSize ) );
+        apoReaders[i]->Seek( anRunOffsets[i], anRunOffsets[i+1] );
+        abValid.push_back( apoReaders[i]->ReadRecord() );
+    }
+
+    std::vector<GByte> abyBuffer;
+    CPLString osLastKey;
+    int bHasLastKey = FALSE;
+    vsi_l_offset nLastBlockOffset = 0;
+    GUInt32 anSizes[2];
+
+    while( !bError )
+    {
+        /* Smallest key, the earliest run winning ties */
+        int iMin = -1;
+        for( i = 0; i < nRuns; i++ )
+        {
+            if( abValid[i] &&
+                (iMin < 0 || apoReaders[i]->osKey < apoReaders[iMin]->osKey) )
+                iMin = i;
+        }
+        if( iMin < 0 )
+            break;
+
+        OGRExternalSortReader *poMin = apoReaders[iMin];
+        if( !bUnique || !bHasLastKey || poMin->osKey != osLastKey )
+        {
+            if( aosBlockKeys.empty() ||
+                nSortedSize - nLastBlockOffset >= SORTED_BLOCK_SIZE )
+            {
+                aosBlockKeys.push_back( poMin->osKey );
+                anBlockOffsets.push_back( nSortedSize );
+                anBlockFirstRecords.push_back( nSortedRecords );
+                nLastBlockOffset = nSortedSize;
+            }
+
+            anSizes[0] = (GUInt32) poMin->osKey.size();
+            anSizes[1] = (GUInt32) poMin->abyPayload.size();
+            if( !WriteBuffered( fpSorted, abyBuffer, (const GByte *) anSizes,
+                                sizeof(anSizes), FALSE ) ||
+                !WriteBuffered( fpSorted, abyBuffer,
+                                (const GByte *) poMin->osKey.data(),
+                                poMin->osKey.size(), FALSE ) ||
+                !WriteBuffered( fpSorted, abyBuffer,
+                                poMin->abyPayload.empty() ? NULL :
+                                    &poMin->abyPayload[0],
+                                poMin->abyPayload.size(), FALSE ) )
+                bError = TRUE;
+            nSortedSize += sizeof(anSizes) + anSizes[0] + anSizes[1];
+            nSortedRecords ++;
+
+            osLastKey = poMin->osKey;
+            bHasLastKey = TRUE;
+        }
+
+        abValid[iMin] = poMin->ReadRecord();
+    }
+
+    if( !bError && !WriteBuffered( fpSorted, abyBuffer, NULL, 0, TRUE ) )
+        bError = TRUE;
+
+    for( i = 0; i < nRuns; i++ )
+        delete apoReaders[i];
+
+    VSIFCloseL( fpRuns );
+    VSIUnlink( osRunsFilename );
+    fpRuns = NULL;
+    anRunOffsets.clear();
+
+    return !bError;
+}
+
+/************************************************************************/
+/*                               Finish()                               */
+/*                                                                      */
+/*      Must be called once all the records have been added.           */
+/************************************************************************/
+
+int OGRExternalSorter::Finish()
+
+{
+    if( bFinished )
+        return !bError;
+    bFinished = TRUE;
+
+    if( bError )
+        return FALSE;
+
+    if( fpRuns == NULL )
+    {
+        SortRecords();
+        return TRUE;
+    }
+
+    if( !anRecordOffsets.empty() && !FlushRun() )
+        return FALSE;
+
+    if( !MergeRuns() )
+    {
+        bError = TRUE;
+        return FALSE;
+    }
+
+    CPLDebug( "OGR", "External sort: " CPL_FRMT_GUIB " bytes spilled to %s.",
+              (GUIntBig) nSortedSize, osSortedFilename.c_str() );
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                             FindRecord()                             */
+/*                                                                      */
+/*      Fetch the payload of the first record with the passed key.     */
+/************************************************************************/
+
+int OGRExternalSorter::FindRecord( const CPLString& osKey,
+                                   std::vector<GByte>& abyPayload )
+
+{
+    if( !bFinished || bError )
+        return FALSE;
+
+    if( fpSorted == NULL )
+    {
+        if( anRecordOffsets.empty() )
+            return FALSE;
+
+        const GByte *pabyRecords = &abyRecords[0];
+        std::vector<size_t>::iterator oIter =
+            std::lower_bound( anRecordOffsets.begin(), anRecordOffsets.end(),
+                              osKey, OGRExternalSortKeyLess( pabyRecords ) );
+        if( oIter == anRecordOffsets.end() )
+            return FALSE;
+
+        const GByte *pabyRecord = pabyRecords + *oIter;
+        if( CompareKeys( RECORD_KEY(pabyRecord), RECORD_KEY_SIZE(pabyRecord),
+                         (const GByte *) osKey.data(), osKey.size() ) != 0 )
+            return FALSE;
+
+        const GByte *pabyPayload =
+            RECORD_KEY(pabyRecord) + RECORD_KEY_SIZE(pabyRecord);
+        abyPayload.assign( pabyPayload,
+                           pabyPayload + RECORD_PAYLOAD_SIZE(pabyRecord) );
+        return TRUE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      The blocks before the first one starting with a key greater    */
+/*      or equal to the searched one only contain smaller keys, except */
+/*      the last of them.                                               */
+/* -------------------------------------------------------------------- */
+    if( aosBlockKeys.empty() )
+        return FALSE;
+
+    size_t iBlock = std::lower_bound( aosBlockKeys.begin(), aosBlockKeys.end(),
+                                      osKey ) - aosBlockKeys.begin();
+    if( iBlock > 0 )
+        iBlock --;
+
+    if( poReader == NULL )
+        poReader = new OGRExternalSortReader( fpSorted, SORTED_BLOCK_SIZE );
+    poReader->Seek( anBlockOffsets[iBlock], nSortedSize );
+    /* The position of the reader is no longer tracked */
+    iNextRecord = nSortedRecords;
+
+    while( poReader->ReadRecord() )
+    {
+        int nCmp = poReader->osKey.compare( osKey );
+        if( nCmp > 0 )
+            return FALSE;
+        if( nCmp == 0 )
+        {
+            abyPayload.swap( poReader->abyPayload );
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/************************************************************************/
+/*                           GetRecordCount()                           */
+/************************************************************************/
+
+GUIntBig OGRExternalSorter::GetRecordCount() const
+
+{
+    if( fpSorted != NULL )
+        return nSortedRecords;
+    return anRecordOffsets.size();
+}
+
+/************************************************************************/
+/*                               Rewind()                               */
+/************************************************************************/
+
+void OGRExternalSorter::Rewind()
+
+{
+    iNextRecord = 0;
+    if( fpSorted != NULL )
+    {
+        if( poReader == NULL )
+            poReader = new OGRExternalSortReader( fpSorted, IO_BUFFER_SIZE );
+        poReader->Seek( 0, nSortedSize );
+    }
+}
+
+/************************************************************************/
+/*                           GetNextRecord()                            */
+/*                                                                      */
+/*      Sequential reading of the sorted records. Rewind() must be     */
+/*      called first if FindRecord() has been used.                     */
+/************************************************************************/
+
+int OGRExternalSorter::GetNextRecord( CPLString& osKey,
+                                      std::vector<GByte>& abyPayload )
+
+{
+    if( !bFinished || bError )
+        return FALSE;
+
+    if( fpSorted == NULL )
+    {
+        if( iNextRecord >= anRecordOffsets.size() )
+            return FALSE;
+
+        const GByte *pabyRecord =
+            &abyRecords[anRecordOffsets[(size_t)iNextRecord++]];
+        const GByte *pabyPayload =
+            RECORD_KEY(pabyRecord) + RECORD_KEY_SIZE(pabyRecord);
+        osKey.assign( (const char *) RECORD_KEY(pabyRecord),
+                      RECORD_KEY_SIZE(pabyRecord) );
+        abyPayload.assign( pabyPayload,
+                           pabyPayload + RECORD_PAYLOAD_SIZE(pabyRecord) );
+        return TRUE;
+    }
+
+    if( poReader == NULL )
+        Rewind();
+    if( !poReader->ReadRecord() )
+        return FALSE;
+    iNextRecord ++;
+
+    osKey.swap( poReader->osKey );
+    abyPayload.swap( poReader->abyPayload );
+    return TRUE;
+}
+
+/************************************************************************/
+/*                             GetRecord()                              */
+/*                                                                      */
+/*      Fetch the record at the passed position of the sorted output.  */
+/*      Reading consecutive records is as fast as with GetNextRecord().*/
+/************************************************************************/
+
+int OGRExternalSorter::GetRecord( GUIntBig iRecord, CPLString& osKey,
+                                  std::vector<GByte>& abyPayload )
+
+{
+    if( !bFinished || bError || iRecord >= GetRecordCount() )
+        return FALSE;
+
+    if( fpSorted != NULL && iRecord != iNextRecord )
+    {
+        /* Restart from the block containing the record */
+        size_t iBlock = std::upper_bound( anBlockFirstRecords.begin(),
+                                          anBlockFirstRecords.end(),
+                                          iRecord ) -
+                        anBlockFirstRecords.begin() - 1;
+
+        if( poReader == NULL )
+            poReader = new OGRExternalSortReader( fpSorted, IO_BUFFER_SIZE );
+        poReader->Seek( anBlockOffsets[iBlock], nSortedSize );
+        iNextRecord = anBlockFirstRecords[iBlock];
+
+        while( iNextRecord < iRecord )
+        {
+            if( !poReader->ReadRecord() )
+                return FALSE;
+            iNextRecord ++;
+        }
+    }
+    else
+        iNextRecord = iRecord;
+
+    return GetNextRecord( osKey, abyPayload );
+}
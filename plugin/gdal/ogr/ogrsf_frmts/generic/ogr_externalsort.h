@@ -0,0 +1,132 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Classes and functions to sort records, and spill features,
+ *           to temporary files when they do not fit in memory.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef _OGR_EXTERNALSORT_H_INCLUDED
+#define _OGR_EXTERNALSORT_H_INCLUDED
+
+#include "ogr_feature.h"
+#include "cpl_vsi.h"
+#include "cpl_string.h"
+
+#include <vector>
+
+/* Serialization of features to the temporary files of the process. */
+/* The format is native endian and not meant to be persisted. */
+void   OGRSerializeFeature( OGRFeature *poFeature, std::vector<GByte>& abyOut );
+int    OGRDeserializeFeature( const GByte *pabyData, size_t nSize,
+                              OGRFeature *poFeature );
+size_t OGREstimateFeatureMemory( OGRFeature *poFeature );
+
+size_t OGRGetSQLMemoryLimit();
+int    OGRGetSQLThreadCount();
+
+/************************************************************************/
+/*                          OGRExternalSorter                           */
+/*                                                                      */
+/*      Sorts (key, payload) records by the byte-wise order of their   */
+/*      keys, records with the same key keeping their insertion         */
+/*      order. Records are kept in memory up to a memory limit, and    */
+/*      then written as sorted runs to a temporary file, that are      */
+/*      merged by Finish() into a single sorted file.                  */
+/*                                                                      */
+/*      With SetMaxRecords(), only the records that can be among the   */
+/*      first ones of the sorted output are retained, in a heap.       */
+/************************************************************************/
+
+class OGRExternalSortReader;
+
+class OGRExternalSorter
+{
+    size_t                      nMemoryLimit;
+    int                         bUnique;
+    int                         bFinished;
+    int                         bError;
+
+    /* Records not written yet, packed in a single buffer */
+    std::vector<GByte>          abyRecords;
+    std::vector<size_t>         anRecordOffsets;
+
+    /* Top-N mode: anRecordOffsets is a heap with the greatest record */
+    /* on top, and the records removed from it leave garbage in */
+    /* abyRecords */
+    GUIntBig                    nMaxRecords;
+    size_t                      nGarbageSize;
+
+    CPLString                   osRunsFilename;
+    VSILFILE                   *fpRuns;
+    std::vector<vsi_l_offset>   anRunOffsets;
+
+    CPLString                   osSortedFilename;
+    VSILFILE                   *fpSorted;
+    vsi_l_offset                nSortedSize;
+
+    GUIntBig                    nSortedRecords;
+
+    /* Key and index of the first record of each block of the sorted file */
+    std::vector<CPLString>      aosBlockKeys;
+    std::vector<vsi_l_offset>   anBlockOffsets;
+    std::vector<GUIntBig>       anBlockFirstRecords;
+
+    GUIntBig                    iNextRecord;
+    OGRExternalSortReader      *poReader;
+
+    int         AddTopRecord( const void *pKey, size_t nKeySize,
+                              const void *pPayload, size_t nPayloadSize );
+    void        AppendRecord( const void *pKey, size_t nKeySize,
+                              const void *pPayload, size_t nPayloadSize );
+    void        CompactRecords();
+    void        SortRecords();
+    int         FlushRun();
+    int         MergeRuns();
+
+  public:
+                OGRExternalSorter( size_t nMemoryLimit, int bUnique = FALSE );
+               ~OGRExternalSorter();
+
+    void        SetMaxRecords( GUIntBig nMaxRecordsIn );
+
+    int         AddRecord( const void *pKey, size_t nKeySize,
+                           const void *pPayload, size_t nPayloadSize );
+    int         Finish();
+
+    int         IsSpilled() const { return fpSorted != NULL; }
+    GUIntBig    GetRecordCount() const;
+
+    int         FindRecord( const CPLString& osKey,
+                            std::vector<GByte>& abyPayload );
+
+    void        Rewind();
+    int         GetNextRecord( CPLString& osKey,
+                               std::vector<GByte>& abyPayload );
+    int         GetRecord( GUIntBig iRecord, CPLString& osKey,
+                           std::vector<GByte>& abyPayload );
+};
+
+#endif /* ndef _OGR_EXTERNALSORT_H_INCLUDED */
@@ -31,6 +31,8 @@
 #include "swq.h"
 #include "ogr_p.h"
 #include "ogr_gensql.h"
+#include "ogr_externalsort.h"
+#include "ogr_hashaggregate.h"
 #include "cpl_string.h"
 #include "ogr_api.h"
 #include "cpl_time.h"
@@ -80,6 +82,80 @@ int OGRGenSQLResultsLayerHasSpecialField(swq_expr_node* expr,
     return FALSE;
 }
 
+/************************************************************************/
+/*                          OGRGenSQLJoinIndex                          */
+/*                                                                      */
+/*      Features of the secondary layer of an equi-join, read once     */
+/*      and keyed by the values of their join fields. They are kept    */
+/*      in a hash set while they fit in OGR_SQL_MEMORY_LIMIT, and are  */
+/*      otherwise spilled to a temporary sorted file. As with the      */
+/*      attribute filter based lookup, the first matching feature of   */
+/*      the secondary layer is used.                                   */
+/************************************************************************/
+
+#define JOIN_KEY_INTEGER    0
+#define JOIN_KEY_REAL       1
+#define JOIN_KEY_STRING     2
+
+class OGRGenSQLJoinEntry
+{
+  public:
+    CPLString   osKey;
+    OGRFeature *poFeature;
+};
+
+class OGRGenSQLJoinIndex
+{
+  public:
+    int                 bUsable;
+    std::vector<int>    anPrimaryFields;
+    std::vector<int>    anSecondaryFields;
+    std::vector<int>    anKeyTypes;
+
+    CPLHashSet         *hEntries;
+    OGRExternalSorter  *poSorter;
+    OGRFeature         *poSpilledFeature;
+    std::vector<GByte>  abyPayload;
+    CPLString           osKey;
+
+                        OGRGenSQLJoinIndex() : bUsable(FALSE), hEntries(NULL),
+                                               poSorter(NULL),
+                                               poSpilledFeature(NULL) {}
+                       ~OGRGenSQLJoinIndex();
+};
+
+OGRGenSQLJoinIndex::~OGRGenSQLJoinIndex()
+
+{
+    if( hEntries != NULL )
+        CPLHashSetDestroy( hEntries );
+    delete poSorter;
+    delete poSpilledFeature;
+}
+
+static unsigned long OGRGenSQLJoinEntryHash( const void *pEntry )
+{
+    const CPLString& osKey = ((const OGRGenSQLJoinEntry *) pEntry)->osKey;
+    unsigned long nHash = 5381;
+
+    for( size_t i = 0; i < osKey.size(); i++ )
+        nHash = nHash * 33 + (GByte) osKey[i];
+
+    return nHash;
+}
+
+static int OGRGenSQLJoinEntryEqual( const void *pEntry1, const void *pEntry2 )
+{
+    return ((const OGRGenSQLJoinEntry *) pEntry1)->osKey ==
+           ((const OGRGenSQLJoinEntry *) pEntry2)->osKey;
+}
+
+static void OGRGenSQLJoinEntryFree( void *pEntry )
+{
+    delete ((OGRGenSQLJoinEntry *) pEntry)->poFeature;
+    delete (OGRGenSQLJoinEntry *) pEntry;
+}
+
 /************************************************************************/
 /*                       OGRGenSQLResultsLayer()                        */
 /************************************************************************/
@@ -97,10 +173,10 @@ OGRGenSQLResultsLayer::OGRGenSQLResultsLayer( GDALDataset *poSrcDS,
     this->pSelectInfo = pSelectInfo;
     poDefn = NULL;
     poSummaryFeature = NULL;
-    panFIDIndex = NULL;
+    poOrderBySorter = NULL;
     bOrderByValid = FALSE;
-    nIndexSize = 0;
     nNextIndexFID = 0;
+    nIteratedFeatures = -1;
     nExtraDSCount = 0;
     papoExtraDS = NULL;
     panGeomFieldToSrcGeomField = NULL;
@@ -500,10 +576,13 @@ OGRGenSQLResultsLayer::~OGRGenSQLResultsLayer()
 /* -------------------------------------------------------------------- */
 /*      Free various datastructures.                                    */
 /* -------------------------------------------------------------------- */
+    for( size_t iJoin = 0; iJoin < apoJoinIndexes.size(); iJoin++ )
+        delete apoJoinIndexes[iJoin];
+
     CPLFree( papoTableLayers );
     papoTableLayers = NULL;
              
-    CPLFree( panFIDIndex );
+    delete poOrderBySorter;
     CPLFree( panGeomFieldToSrcGeomField );
 
     delete poSummaryFeature;
@@ -626,6 +705,7 @@ void OGRGenSQLResultsLayer::ResetReading()
     }
 
     nNextIndexFID = 0;
+    nIteratedFeatures = -1;
 }
 
 /************************************************************************/
@@ -640,11 +720,16 @@ OGRErr OGRGenSQLResultsLayer::SetNextByIndex( GIntBig nIndex )
 {
     swq_select *psSelectInfo = (swq_select *) pSelectInfo;
 
+    /* Let the generic implementation apply LIMIT and OFFSET */
+    if( psSelectInfo->limit >= 0 || psSelectInfo->offset > 0 )
+        return OGRLayer::SetNextByIndex( nIndex );
+
     CreateOrderByIndex();
 
     if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD 
         || psSelectInfo->query_mode == SWQM_DISTINCT_LIST 
-        || panFIDIndex != NULL )
+        || psSelectInfo->query_mode == SWQM_GROUP_BY 
+        || poOrderBySorter != NULL )
     {
         nNextIndexFID = nIndex;
         return OGRERR_NONE;
@@ -700,6 +785,8 @@ GIntBig OGRGenSQLResultsLayer::GetFeatureCount( int bForce )
 {
     swq_select *psSelectInfo = (swq_select *) pSelectInfo;
 
+    GIntBig nRet;
+
     CreateOrderByIndex();
 
     if( psSelectInfo->query_mode == SWQM_DISTINCT_LIST )
@@ -712,14 +799,31 @@ GIntBig OGRGenSQLResultsLayer::GetFeatureCount( int bForce )
         if( psSummary == NULL )
             return 0;
 
-        return psSummary->count;
+        nRet = psSummary->count;
+    }
+    else if( psSelectInfo->query_mode == SWQM_GROUP_BY )
+    {
+        if( poOrderBySorter == NULL )
+            return 0;
+        if( m_poAttrQuery != NULL )
+            return OGRLayer::GetFeatureCount( bForce );
+
+        nRet = (GIntBig) poOrderBySorter->GetRecordCount();
     }
     else if( psSelectInfo->query_mode != SWQM_RECORDSET )
-        return 1;
+        nRet = 1;
     else if( m_poAttrQuery == NULL && !MustEvaluateSpatialFilterOnGenSQL() )
-        return poSrcLayer->GetFeatureCount( bForce );
+        nRet = poSrcLayer->GetFeatureCount( bForce );
     else
+        /* Iterates over GetNextFeature(), so LIMIT and OFFSET are applied */
         return OGRLayer::GetFeatureCount( bForce );
+
+    if( nRet < 0 )
+        return nRet;
+    nRet = MAX( 0, nRet - psSelectInfo->offset );
+    if( psSelectInfo->limit >= 0 )
+        nRet = MIN( nRet, psSelectInfo->limit );
+    return nRet;
 }
 
 /************************************************************************/
@@ -733,9 +837,11 @@ int OGRGenSQLResultsLayer::TestCapability( const char *pszCap )
 
     if( EQUAL(pszCap,OLCFastSetNextByIndex) )
     {
+        if( psSelectInfo->limit >= 0 || psSelectInfo->offset > 0 )
+            return FALSE;
         if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD 
             || psSelectInfo->query_mode == SWQM_DISTINCT_LIST 
-            || panFIDIndex != NULL )
+            || poOrderBySorter != NULL )
             return TRUE;
         else 
             return poSrcLayer->TestCapability( pszCap );
@@ -789,6 +895,61 @@ int OGRGenSQLResultsLayer::ContainGeomSpecialField(swq_expr_node* expr)
     return FALSE;
 }
 
+/************************************************************************/
+/*                       MustReadSourceGeometry()                       */
+/*                                                                      */
+/*      Summaries and aggregates only need the geometry of the source  */
+/*      features if a spatial filter is in place, or if the where      */
+/*      clause or a column references OGR_GEOMETRY, OGR_GEOM_WKT or    */
+/*      OGR_GEOM_AREA special fields.                                   */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::MustReadSourceGeometry()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    if( m_poFilterGeom != NULL || ( psSelectInfo->where_expr != NULL &&
+                ContainGeomSpecialField(psSelectInfo->where_expr) ) )
+        return TRUE;
+
+    for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    {
+        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+        if (psColDef->table_index == 0 && psColDef->field_index != -1)
+        {
+            if( IsGeomSourceField( psColDef->field_index ) )
+                return TRUE;
+        }
+        if (psColDef->expr != NULL && ContainGeomSpecialField(psColDef->expr))
+            return TRUE;
+    }
+
+    for( int iGroup = 0; iGroup < psSelectInfo->group_by_specs; iGroup++ )
+    {
+        if( IsGeomSourceField( psSelectInfo->group_by_defs[iGroup].field_index ) )
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/************************************************************************/
+/*                         IsGeomSourceField()                          */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::IsGeomSourceField( int iField )
+
+{
+    OGRLayer* poLayer = papoTableLayers[0];
+    int nSpecialFieldIdx = iField - poLayer->GetLayerDefn()->GetFieldCount();
+    if (nSpecialFieldIdx == SPF_OGR_GEOMETRY ||
+        nSpecialFieldIdx == SPF_OGR_GEOM_WKT ||
+        nSpecialFieldIdx == SPF_OGR_GEOM_AREA)
+        return TRUE;
+    return iField == GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poLayer->GetLayerDefn(), 0);
+}
+
 /************************************************************************/
 /*                           PrepareSummary()                           */
 /************************************************************************/
@@ -816,41 +977,8 @@ int OGRGenSQLResultsLayer::PrepareSummary()
 /*      OGR_GEOM_WKT or OGR_GEOM_AREA special fields.                   */
 /* -------------------------------------------------------------------- */
     int bSaveIsGeomIgnored = poSrcLayer->GetLayerDefn()->IsGeometryIgnored();
-    if ( m_poFilterGeom == NULL && ( psSelectInfo->where_expr == NULL ||
-                !ContainGeomSpecialField(psSelectInfo->where_expr) ) )
-    {
-        int bFoundGeomExpr = FALSE;
-        for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
-        {
-            swq_col_def *psColDef = psSelectInfo->column_defs + iField;
-            if (psColDef->table_index == 0 && psColDef->field_index != -1)
-            {
-                OGRLayer* poLayer = papoTableLayers[psColDef->table_index];
-                int nSpecialFieldIdx = psColDef->field_index -
-                                poLayer->GetLayerDefn()->GetFieldCount();
-                if (nSpecialFieldIdx == SPF_OGR_GEOMETRY ||
-                    nSpecialFieldIdx == SPF_OGR_GEOM_WKT ||
-                    nSpecialFieldIdx == SPF_OGR_GEOM_AREA)
-                {
-                    bFoundGeomExpr = TRUE;
-                    break;
-                }
-                if( psColDef->field_index ==
-                        GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poLayer->GetLayerDefn(), 0) )
-                {
-                    bFoundGeomExpr = TRUE;
-                    break;
-                }
-            }
-            if (psColDef->expr != NULL && ContainGeomSpecialField(psColDef->expr))
-            {
-                bFoundGeomExpr = TRUE;
-                break;
-            }
-        }
-        if (!bFoundGeomExpr)
-            poSrcLayer->GetLayerDefn()->SetGeometryIgnored(TRUE);
-    }
+    if( !MustReadSourceGeometry() )
+        poSrcLayer->GetLayerDefn()->SetGeometryIgnored(TRUE);
 
 /* -------------------------------------------------------------------- */
 /*      We treat COUNT(*) as a special case, and fill with              */
@@ -1257,6 +1385,325 @@ static CPLString GetFilterForJoin(swq_expr_node* poExpr, OGRFeature* poSrcFeat,
     return "";
 }
 
+/************************************************************************/
+/*                       CollectJoinKeyFields()                         */
+/*                                                                      */
+/*      Only equalities between fields of the primary and secondary    */
+/*      tables, possibly combined with AND, can use a join index.      */
+/************************************************************************/
+
+static int CollectJoinKeyFields( swq_expr_node *poExpr, int secondary_table,
+                                 OGRFeatureDefn *poPrimaryDefn,
+                                 OGRFeatureDefn *poSecondaryDefn,
+                                 OGRGenSQLJoinIndex *poIndex )
+{
+    if( poExpr->eNodeType != SNT_OPERATION || poExpr->nSubExprCount != 2 )
+        return FALSE;
+
+    if( poExpr->nOperation == SWQ_AND )
+    {
+        return CollectJoinKeyFields( poExpr->papoSubExpr[0], secondary_table,
+                                     poPrimaryDefn, poSecondaryDefn, poIndex ) &&
+               CollectJoinKeyFields( poExpr->papoSubExpr[1], secondary_table,
+                                     poPrimaryDefn, poSecondaryDefn, poIndex );
+    }
+
+    if( poExpr->nOperation != SWQ_EQ )
+        return FALSE;
+
+    swq_expr_node *poPrimary = poExpr->papoSubExpr[0];
+    swq_expr_node *poSecondary = poExpr->papoSubExpr[1];
+    if( poPrimary->eNodeType != SNT_COLUMN ||
+        poSecondary->eNodeType != SNT_COLUMN )
+        return FALSE;
+
+    if( poPrimary->table_index == secondary_table )
+    {
+        swq_expr_node *poTmp = poPrimary;
+        poPrimary = poSecondary;
+        poSecondary = poTmp;
+    }
+    if( poPrimary->table_index != 0 ||
+        poSecondary->table_index != secondary_table ||
+        poPrimary->field_index < 0 ||
+        poPrimary->field_index >= poPrimaryDefn->GetFieldCount() ||
+        poSecondary->field_index < 0 ||
+        poSecondary->field_index >= poSecondaryDefn->GetFieldCount() )
+        return FALSE;
+
+    OGRFieldType eType1 =
+        poPrimaryDefn->GetFieldDefn(poPrimary->field_index)->GetType();
+    OGRFieldType eType2 =
+        poSecondaryDefn->GetFieldDefn(poSecondary->field_index)->GetType();
+    int bIsInteger1 = eType1 == OFTInteger || eType1 == OFTInteger64;
+    int bIsInteger2 = eType2 == OFTInteger || eType2 == OFTInteger64;
+    int nKeyType;
+
+    /* Same comparison rules as the attribute filter based lookup */
+    if( bIsInteger1 && bIsInteger2 )
+        nKeyType = JOIN_KEY_INTEGER;
+    else if( (bIsInteger1 || eType1 == OFTReal) &&
+             (bIsInteger2 || eType2 == OFTReal) )
+        nKeyType = JOIN_KEY_REAL;
+    else if( eType1 == OFTString && eType2 == OFTString )
+        nKeyType = JOIN_KEY_STRING;
+    else
+        return FALSE;
+
+    poIndex->anPrimaryFields.push_back( poPrimary->field_index );
+    poIndex->anSecondaryFields.push_back( poSecondary->field_index );
+    poIndex->anKeyTypes.push_back( nKeyType );
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                           BuildJoinKey()                             */
+/*                                                                      */
+/*      Returns FALSE if the feature cannot match anything.            */
+/************************************************************************/
+
+static int BuildJoinKey( OGRFeature *poFeature,
+                         const std::vector<int>& anFields,
+                         const std::vector<int>& anKeyTypes,
+                         CPLString& osKey )
+{
+    osKey.resize( 0 );
+
+    for( size_t i = 0; i < anFields.size(); i++ )
+    {
+        int iField = anFields[i];
+
+        // null keys never match.
+        if( !poFeature->IsFieldSet( iField ) )
+            return FALSE;
+
+        switch( anKeyTypes[i] )
+        {
+          case JOIN_KEY_INTEGER:
+          {
+              GIntBig nValue = poFeature->GetFieldAsInteger64( iField );
+              osKey.append( (const char *) &nValue, sizeof(nValue) );
+              break;
+          }
+
+          case JOIN_KEY_REAL:
+          {
+              double dfValue = poFeature->GetFieldAsDouble( iField );
+              if( CPLIsNan(dfValue) )
+                  return FALSE;
+              if( dfValue == 0.0 )
+                  dfValue = 0.0; /* -0 == 0 */
+              osKey.append( (const char *) &dfValue, sizeof(dfValue) );
+              break;
+          }
+
+          default:
+          {
+              /* String comparisons are case insensitive */
+              const char *pszValue = poFeature->GetFieldAsString( iField );
+              for( ; *pszValue != '\0'; pszValue++ )
+                  osKey += (char) toupper( (unsigned char) *pszValue );
+              osKey += '\0';
+              break;
+          }
+        }
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                            GetJoinIndex()                            */
+/************************************************************************/
+
+OGRGenSQLJoinIndex *OGRGenSQLResultsLayer::GetJoinIndex( int iJoin )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    if( apoJoinIndexes.empty() )
+        apoJoinIndexes.resize( psSelectInfo->join_count, NULL );
+    if( apoJoinIndexes[iJoin] != NULL )
+        return apoJoinIndexes[iJoin];
+
+    OGRGenSQLJoinIndex *poIndex = new OGRGenSQLJoinIndex();
+    apoJoinIndexes[iJoin] = poIndex;
+
+    swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+    OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
+
+    /* Reading the secondary layer would disturb the reading of the */
+    /* primary one if they are the same layer. */
+    if( poJoinLayer == poSrcLayer ||
+        !CSLTestBoolean( CPLGetConfigOption( "OGR_SQL_HASH_JOIN", "YES" ) ) ||
+        !CollectJoinKeyFields( psJoinInfo->poExpr,
+                               psJoinInfo->secondary_table,
+                               poSrcLayer->GetLayerDefn(),
+                               poJoinLayer->GetLayerDefn(), poIndex ) )
+        return poIndex;
+
+/* -------------------------------------------------------------------- */
+/*      Hash the features of the secondary layer, as long as they fit  */
+/*      in memory.                                                      */
+/* -------------------------------------------------------------------- */
+    size_t nMemoryLimit = OGRGetSQLMemoryLimit();
+    size_t nMemoryUsed = 0;
+    int bSpill = FALSE;
+    OGRFeature *poFeature;
+    OGRGenSQLJoinEntry sSearched;
+
+    poJoinLayer->SetAttributeFilter( NULL );
+    poJoinLayer->ResetReading();
+
+    poIndex->hEntries = CPLHashSetNew( OGRGenSQLJoinEntryHash,
+                                       OGRGenSQLJoinEntryEqual,
+                                       OGRGenSQLJoinEntryFree );
+
+    while( (poFeature = poJoinLayer->GetNextFeature()) != NULL )
+    {
+        if( !BuildJoinKey( poFeature, poIndex->anSecondaryFields,
+                           poIndex->anKeyTypes, sSearched.osKey ) ||
+            CPLHashSetLookup( poIndex->hEntries, &sSearched ) != NULL )
+        {
+            delete poFeature;
+            continue;
+        }
+
+        OGRGenSQLJoinEntry *psEntry = new OGRGenSQLJoinEntry();
+        psEntry->osKey = sSearched.osKey;
+        psEntry->poFeature = poFeature;
+        CPLHashSetInsert( poIndex->hEntries, psEntry );
+
+        nMemoryUsed += OGREstimateFeatureMemory( poFeature ) +
+                       psEntry->osKey.size() + sizeof(OGRGenSQLJoinEntry) +
+                       4 * sizeof(void*);
+        if( nMemoryUsed > nMemoryLimit )
+        {
+            bSpill = TRUE;
+            break;
+        }
+    }
+
+    if( !bSpill )
+    {
+        CPLDebug( "GenSQL", "JOIN on %s: %d features hashed in memory.",
+                  poJoinLayer->GetName(),
+                  CPLHashSetSize( poIndex->hEntries ) );
+        poIndex->bUsable = TRUE;
+        poJoinLayer->ResetReading();
+        return poIndex;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Otherwise start again and write them to a sorted file.         */
+/* -------------------------------------------------------------------- */
+    CPLHashSetDestroy( poIndex->hEntries );
+    poIndex->hEntries = NULL;
+
+    poIndex->poSorter = new OGRExternalSorter( nMemoryLimit, TRUE );
+    poJoinLayer->ResetReading();
+
+    int bOK = TRUE;
+    while( bOK && (poFeature = poJoinLayer->GetNextFeature()) != NULL )
+    {
+        if( BuildJoinKey( poFeature, poIndex->anSecondaryFields,
+                          poIndex->anKeyTypes, poIndex->osKey ) )
+        {
+            poIndex->abyPayload.resize( 0 );
+            OGRSerializeFeature( poFeature, poIndex->abyPayload );
+            bOK = poIndex->poSorter->AddRecord(
+                poIndex->osKey.data(), poIndex->osKey.size(),
+                &poIndex->abyPayload[0], poIndex->abyPayload.size() );
+        }
+        delete poFeature;
+    }
+    poJoinLayer->ResetReading();
+
+    if( !bOK || !poIndex->poSorter->Finish() )
+    {
+        CPLDebug( "GenSQL", "JOIN on %s: cannot build join index, "
+                  "using attribute filters.", poJoinLayer->GetName() );
+        delete poIndex->poSorter;
+        poIndex->poSorter = NULL;
+        return poIndex;
+    }
+
+    CPLDebug( "GenSQL", "JOIN on %s: features spilled to a sorted file.",
+              poJoinLayer->GetName() );
+    poIndex->poSpilledFeature = new OGRFeature( poJoinLayer->GetLayerDefn() );
+    poIndex->bUsable = TRUE;
+
+    return poIndex;
+}
+
+/************************************************************************/
+/*                          FetchJoinFeature()                          */
+/*                                                                      */
+/*      Fetch the feature of the secondary table of a join matching    */
+/*      the passed primary feature. *pbOwned is set to TRUE if the     */
+/*      caller must delete it.                                          */
+/************************************************************************/
+
+OGRFeature *OGRGenSQLResultsLayer::FetchJoinFeature( int iJoin,
+                                                     OGRFeature *poSrcFeat,
+                                                     int *pbOwned )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+    OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
+    OGRGenSQLJoinIndex *poIndex = GetJoinIndex( iJoin );
+
+    *pbOwned = FALSE;
+
+    if( poIndex->bUsable )
+    {
+        if( !BuildJoinKey( poSrcFeat, poIndex->anPrimaryFields,
+                           poIndex->anKeyTypes, poIndex->osKey ) )
+            return NULL;
+
+        if( poIndex->hEntries != NULL )
+        {
+            OGRGenSQLJoinEntry sSearched;
+            sSearched.osKey.swap( poIndex->osKey );
+            OGRGenSQLJoinEntry *psEntry = (OGRGenSQLJoinEntry *)
+                CPLHashSetLookup( poIndex->hEntries, &sSearched );
+            sSearched.osKey.swap( poIndex->osKey );
+            return psEntry ? psEntry->poFeature : NULL;
+        }
+
+        if( !poIndex->poSorter->FindRecord( poIndex->osKey,
+                                            poIndex->abyPayload ) ||
+            !OGRDeserializeFeature( &poIndex->abyPayload[0],
+                                    poIndex->abyPayload.size(),
+                                    poIndex->poSpilledFeature ) )
+            return NULL;
+        return poIndex->poSpilledFeature;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Otherwise look for it with an attribute filter.                 */
+/* -------------------------------------------------------------------- */
+    CPLString osFilter = GetFilterForJoin(psJoinInfo->poExpr, poSrcFeat,
+                                          poJoinLayer,
+                                          psJoinInfo->secondary_table);
+    //CPLDebug("OGR", "Filter = %s\n", osFilter.c_str());
+
+    // if source key is null, we can't do join.
+    if( osFilter.size() == 0 )
+        return NULL;
+
+    OGRFeature *poJoinFeature = NULL;
+
+    poJoinLayer->ResetReading();
+    if( poJoinLayer->SetAttributeFilter( osFilter.c_str() ) == OGRERR_NONE )
+        poJoinFeature = poJoinLayer->GetNextFeature();
+
+    *pbOwned = TRUE;
+    return poJoinFeature;
+}
+
 /************************************************************************/
 /*                          TranslateFeature()                          */
 /************************************************************************/
@@ -1279,38 +1726,19 @@ OGRFeature *OGRGenSQLResultsLayer::TranslateFeature( OGRFeature *poSrcFeat )
 /*      Fetch the corresponding features from any jointed tables.       */
 /* -------------------------------------------------------------------- */
     int iJoin;
+    std::vector<int> abJoinFeatureOwned;
 
     for( iJoin = 0; iJoin < psSelectInfo->join_count; iJoin++ )
     {
-        CPLString osFilter;
-
-        swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+        int bOwned = FALSE;
 
         /* OGRMultiFeatureFetcher assumes that the features are pushed in */
         /* apoFeatures with increasing secondary_table, so make sure */
         /* we have taken care of this */
-        CPLAssert(psJoinInfo->secondary_table == iJoin + 1);
-
-        OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
-        
-        osFilter = GetFilterForJoin(psJoinInfo->poExpr, poSrcFeat, poJoinLayer, 
-                                    psJoinInfo->secondary_table);
-        //CPLDebug("OGR", "Filter = %s\n", osFilter.c_str());
+        CPLAssert(psSelectInfo->join_defs[iJoin].secondary_table == iJoin + 1);
 
-        // if source key is null, we can't do join.
-        if( osFilter.size() == 0 )
-        {
-            apoFeatures.push_back( NULL );
-            continue;
-        }
-
-        OGRFeature *poJoinFeature = NULL;
-
-        poJoinLayer->ResetReading();
-        if( poJoinLayer->SetAttributeFilter( osFilter.c_str() ) == OGRERR_NONE )
-            poJoinFeature = poJoinLayer->GetNextFeature();
-
-        apoFeatures.push_back( poJoinFeature );
+        apoFeatures.push_back( FetchJoinFeature( iJoin, poSrcFeat, &bOwned ) );
+        abJoinFeatureOwned.push_back( bOwned );
     }
 
 /* -------------------------------------------------------------------- */
@@ -1533,7 +1961,8 @@ OGRFeature *OGRGenSQLResultsLayer::TranslateFeature( OGRFeature *poSrcFeat )
             iRegularField ++;
         }
 
-        delete poJoinFeature;
+        if( abJoinFeatureOwned[iJoin] )
+            delete poJoinFeature;
     }
 
     return poDstFeat;
@@ -1550,6 +1979,55 @@ OGRFeature *OGRGenSQLResultsLayer::GetNextFeature()
 
     CreateOrderByIndex();
 
+/* -------------------------------------------------------------------- */
+/*      Skip the features before the OFFSET. Without filters to        */
+/*      evaluate, indexed results can be directly positioned.          */
+/* -------------------------------------------------------------------- */
+    if( nIteratedFeatures < 0 )
+    {
+        nIteratedFeatures = 0;
+
+        if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD
+            || psSelectInfo->query_mode == SWQM_DISTINCT_LIST
+            || (poOrderBySorter != NULL && m_poAttrQuery == NULL &&
+                !MustEvaluateSpatialFilterOnGenSQL()) )
+        {
+            nNextIndexFID += psSelectInfo->offset;
+        }
+        else
+        {
+            for( GIntBig i = 0; i < psSelectInfo->offset; i++ )
+            {
+                OGRFeature *poFeature = GetNextResultFeature();
+                if( poFeature == NULL )
+                    return NULL;
+                delete poFeature;
+            }
+        }
+    }
+
+    if( psSelectInfo->limit >= 0 &&
+        nIteratedFeatures >= psSelectInfo->limit )
+        return NULL;
+
+    OGRFeature *poFeature = GetNextResultFeature();
+    if( poFeature != NULL )
+        nIteratedFeatures ++;
+
+    return poFeature;
+}
+
+/************************************************************************/
+/*                        GetNextResultFeature()                        */
+/*                                                                      */
+/*      Next feature of the result set, before LIMIT and OFFSET.       */
+/************************************************************************/
+
+OGRFeature *OGRGenSQLResultsLayer::GetNextResultFeature()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
 /* -------------------------------------------------------------------- */
 /*      Handle summary sets.                                            */
 /* -------------------------------------------------------------------- */
@@ -1566,8 +2044,10 @@ OGRFeature *OGRGenSQLResultsLayer::GetNextFeature()
     {
         OGRFeature *poFeature;
 
-        if( panFIDIndex != NULL )
+        if( poOrderBySorter != NULL )
             poFeature =  GetFeature( nNextIndexFID++ );
+        else if( psSelectInfo->query_mode == SWQM_GROUP_BY )
+            return NULL;
         else
         {
             OGRFeature *poSrcFeat = poSrcLayer->GetNextFeature();
@@ -1641,26 +2121,64 @@ OGRFeature *OGRGenSQLResultsLayer::GetFeature( GIntBig nFID )
         return poSummaryFeature->Clone();
     }
 
+    OGRFeature *poSrcFeature;
+    OGRFeature *poResult;
+
 /* -------------------------------------------------------------------- */
-/*      Are we running in sorted mode?  If so, run the fid through      */
-/*      the index.                                                      */
+/*      Handle request for a group, whose result feature has been       */
+/*      materialized.                                                   */
 /* -------------------------------------------------------------------- */
-    if( panFIDIndex != NULL )
+    if( psSelectInfo->query_mode == SWQM_GROUP_BY )
     {
-        if( nFID < 0 || nFID >= nIndexSize )
+        if( poOrderBySorter == NULL || nFID < 0 ||
+            !poOrderBySorter->GetRecord( (GUIntBig)nFID, osOrderByKey,
+                                         abyOrderByPayload ) )
             return NULL;
-        else
-            nFID = panFIDIndex[nFID];
-    }
 
-/* -------------------------------------------------------------------- */
+        poResult = new OGRFeature( poDefn );
+        if( !OGRDeserializeFeature( &abyOrderByPayload[0],
+                                    abyOrderByPayload.size(),
+                                    poResult ) )
+        {
+            delete poResult;
+            return NULL;
+        }
+        poResult->SetFID( nFID );
+        return poResult;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Are we running in sorted mode?  If so, the nFID-th sorted       */
+/*      source feature has been materialized.                           */
+/* -------------------------------------------------------------------- */
+    if( poOrderBySorter != NULL )
+    {
+        if( nFID < 0 ||
+            !poOrderBySorter->GetRecord( (GUIntBig)nFID, osOrderByKey,
+                                         abyOrderByPayload ) )
+            return NULL;
+
+        poSrcFeature = new OGRFeature( poSrcLayer->GetLayerDefn() );
+        if( !OGRDeserializeFeature( &abyOrderByPayload[0],
+                                    abyOrderByPayload.size(),
+                                    poSrcFeature ) )
+        {
+            delete poSrcFeature;
+            return NULL;
+        }
+        nFID = poSrcFeature->GetFID();
+    }
+
+/* -------------------------------------------------------------------- */
 /*      Handle request for random record.                               */
 /* -------------------------------------------------------------------- */
-    OGRFeature *poSrcFeature = poSrcLayer->GetFeature( nFID );
-    OGRFeature *poResult;
+    else
+    {
+        poSrcFeature = poSrcLayer->GetFeature( nFID );
 
-    if( poSrcFeature == NULL )
-        return NULL;
+        if( poSrcFeature == NULL )
+            return NULL;
+    }
 
     poResult = TranslateFeature( poSrcFeature );
     poResult->SetFID( nFID );
@@ -1710,28 +2228,37 @@ OGRFeatureDefn *OGRGenSQLResultsLayer::GetLayerDefn()
 /************************************************************************/
 /*                         CreateOrderByIndex()                         */
 /*                                                                      */
-/*      This method is responsible for creating an index providing      */
-/*      ordered access to the features according to the supplied        */
-/*      ORDER BY clauses.                                               */
+/*      This method is responsible for materializing the source        */
+/*      features in the order of the supplied ORDER BY clauses.        */
 /*                                                                      */
 /*      This is accomplished by making one pass through all the         */
-/*      eligible source features, and capturing the order by fields     */
-/*      of all records in memory.  A quick sort is then applied to      */
-/*      this in memory copy of the order-by fields to create the        */
-/*      required index.                                                 */
+/*      eligible source features, and adding them to an external       */
+/*      sorter with a key made of their order-by fields. The sorter    */
+/*      spills to temporary files above OGR_SQL_MEMORY_LIMIT. With a   */
+/*      LIMIT clause, only the first LIMIT + OFFSET features are kept. */
 /*                                                                      */
-/*      Keeping all the key values in memory will *not* scale up to     */
-/*      very large input datasets.                                      */
+/*      The sorted features are then read back from the sorter, so the */
+/*      source layer does not need fast random access.                 */
+/*                                                                      */
+/*      With GROUP BY, the result features are materialized instead,   */
+/*      by CreateGroupByIndex().                                        */
 /************************************************************************/
 
 void OGRGenSQLResultsLayer::CreateOrderByIndex()
 
 {
     swq_select *psSelectInfo = (swq_select *) pSelectInfo;
-    OGRField *pasIndexFields;
-    GIntBig      i;
     int nOrderItems = psSelectInfo->order_specs;
-    GIntBig *panFIDList;
+
+    if( psSelectInfo->query_mode == SWQM_GROUP_BY )
+    {
+        if( !bOrderByValid )
+        {
+            bOrderByValid = TRUE;
+            CreateGroupByIndex();
+        }
+        return;
+    }
 
     if( ! (psSelectInfo->order_specs > 0
            && psSelectInfo->query_mode == SWQM_RECORDSET
@@ -1746,399 +2273,685 @@ void OGRGenSQLResultsLayer::CreateOrderByIndex()
     ResetReading();
 
 /* -------------------------------------------------------------------- */
-/*      Allocate set of key values, and the output index.               */
+/*      Filters evaluated on the result set could remove some of the   */
+/*      first sorted features, so the top-N retention cannot be used.  */
 /* -------------------------------------------------------------------- */
-    size_t nFeaturesAlloc = 100;
+    poOrderBySorter = new OGRExternalSorter( OGRGetSQLMemoryLimit() );
 
-    panFIDIndex = NULL;
-    pasIndexFields = (OGRField *) 
-        CPLCalloc(sizeof(OGRField), nOrderItems * nFeaturesAlloc);
-    panFIDList = (GIntBig *) CPLMalloc(sizeof(GIntBig) * nFeaturesAlloc);
+    if( psSelectInfo->limit >= 0 && m_poAttrQuery == NULL &&
+        !MustEvaluateSpatialFilterOnGenSQL() )
+    {
+        poOrderBySorter->SetMaxRecords(
+            MAX( 1, psSelectInfo->limit + psSelectInfo->offset ) );
+    }
 
 /* -------------------------------------------------------------------- */
-/*      Read in all the key values.                                     */
+/*      Read in all the source features.                                */
 /* -------------------------------------------------------------------- */
     OGRFeature *poSrcFeat;
-    nIndexSize = 0;
+    int bOK = TRUE;
 
-    while( (poSrcFeat = poSrcLayer->GetNextFeature()) != NULL )
+    while( bOK && (poSrcFeat = poSrcLayer->GetNextFeature()) != NULL )
     {
-        int iKey;
+        BuildOrderByKey( poSrcFeat, osOrderByKey );
 
-        if ((size_t)nIndexSize == nFeaturesAlloc)
-        {
-            GIntBig nNewFeaturesAlloc = (nFeaturesAlloc * 4) / 3;
-            if( (GIntBig)(size_t)(sizeof(OGRField) * nOrderItems * nNewFeaturesAlloc) !=
-                    (GIntBig)sizeof(OGRField) * nOrderItems * nNewFeaturesAlloc )
-            {
-                CPLError(CE_Failure, CPLE_AppDefined, "Cannot allocate pasIndexFields");
-                VSIFree(pasIndexFields);
-                VSIFree(panFIDList);
-                nIndexSize = 0;
-                return;
-            }
-            OGRField* pasNewIndexFields = (OGRField *)
-                VSIRealloc(pasIndexFields,
-                           sizeof(OGRField) * nOrderItems * (size_t)nNewFeaturesAlloc);
-            if (pasNewIndexFields == NULL)
-            {
-                CPLError(CE_Failure, CPLE_AppDefined, "Cannot allocate pasIndexFields");
-                VSIFree(pasIndexFields);
-                VSIFree(panFIDList);
-                nIndexSize = 0;
-                return;
-            }
-            pasIndexFields = pasNewIndexFields;
+        abyOrderByPayload.resize( 0 );
+        OGRSerializeFeature( poSrcFeat, abyOrderByPayload );
+        delete poSrcFeat;
+
+        bOK = poOrderBySorter->AddRecord( osOrderByKey.data(),
+                                          osOrderByKey.size(),
+                                          &abyOrderByPayload[0],
+                                          abyOrderByPayload.size() );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Sort the records.                                               */
+/* -------------------------------------------------------------------- */
+    if( !bOK || !poOrderBySorter->Finish() )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Cannot sort the features of layer %s.",
+                  poSrcLayer->GetName() );
+        delete poOrderBySorter;
+        poOrderBySorter = NULL;
+    }
+    else
+    {
+        CPLDebug( "GenSQL", "CreateOrderByIndex() = " CPL_FRMT_GUIB
+                  " features", poOrderBySorter->GetRecordCount() );
+    }
+
+    ResetReading();
+}
+
+/************************************************************************/
+/*                       AppendSortableInteger()                        */
+/*                                                                      */
+/*      Big endian encoding, with the sign bit flipped, so that keys   */
+/*      compare byte-wise in the integer order.                        */
+/************************************************************************/
+
+static void AppendSortableInteger( CPLString& osKey, GIntBig nValue )
+{
+    GUIntBig nBits = ((GUIntBig) nValue) ^ (((GUIntBig)1) << 63);
+
+    for( int i = 7; i >= 0; i-- )
+        osKey += (char) (GByte) (nBits >> (i * 8));
+}
+
+/************************************************************************/
+/*                        AppendSortableReal()                          */
+/************************************************************************/
+
+static void AppendSortableReal( CPLString& osKey, double dfValue )
+{
+    GUIntBig nBits;
+
+    if( dfValue == 0.0 )
+        dfValue = 0.0; /* -0 == 0 */
+    memcpy( &nBits, &dfValue, sizeof(nBits) );
+
+    /* Negative values in reverse order, before positive ones */
+    if( nBits >> 63 )
+        nBits = ~nBits;
+    else
+        nBits |= ((GUIntBig)1) << 63;
+
+    for( int i = 7; i >= 0; i-- )
+        osKey += (char) (GByte) (nBits >> (i * 8));
+}
+
+/************************************************************************/
+/*                        ReadSortableInteger()                         */
+/************************************************************************/
+
+static GIntBig ReadSortableInteger( const GByte *pabyKey )
+{
+    GUIntBig nBits = 0;
+
+    for( int i = 0; i < 8; i++ )
+        nBits = (nBits << 8) | pabyKey[i];
+
+    return (GIntBig) (nBits ^ (((GUIntBig)1) << 63));
+}
+
+/************************************************************************/
+/*                         ReadSortableReal()                           */
+/************************************************************************/
 
-            GIntBig* panNewFIDList = (GIntBig *)
-                VSIRealloc(panFIDList, sizeof(GIntBig) *  (size_t)nNewFeaturesAlloc);
-            if (panNewFIDList == NULL)
+static double ReadSortableReal( const GByte *pabyKey )
+{
+    GUIntBig nBits = 0;
+    double dfValue;
+
+    for( int i = 0; i < 8; i++ )
+        nBits = (nBits << 8) | pabyKey[i];
+
+    if( nBits >> 63 )
+        nBits &= ~(((GUIntBig)1) << 63);
+    else
+        nBits = ~nBits;
+    memcpy( &dfValue, &nBits, sizeof(dfValue) );
+
+    return dfValue;
+}
+
+/************************************************************************/
+/*                           AppendFieldKey()                           */
+/*                                                                      */
+/*      Append the sortable encoding of a field of a source feature.   */
+/*      A group key also distinguishes the time zones of dates, and    */
+/*      the values of the other field types by their string           */
+/*      representation, so that it can be decoded by DecodeFieldKey(). */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::AppendFieldKey( CPLString& osKey,
+                                            OGRFeature *poSrcFeat,
+                                            int iField, int bGroupKey )
+
+{
+    if( iField >= iFIDFieldIndex )
+    {
+        osKey += '\1';
+        if( iField < iFIDFieldIndex + SPECIAL_FIELD_COUNT )
+        {
+            switch (SpecialFieldTypes[iField - iFIDFieldIndex])
             {
-                VSIFree(pasIndexFields);
-                VSIFree(panFIDList);
-                nIndexSize = 0;
-                return;
-            }
-            panFIDList = panNewFIDList;
+              case SWQ_INTEGER:
+              case SWQ_INTEGER64:
+                AppendSortableInteger(
+                    osKey, poSrcFeat->GetFieldAsInteger64(iField) );
+                break;
 
-            memset(pasIndexFields + nFeaturesAlloc, 0,
-                   sizeof(OGRField) * nOrderItems * (size_t)(nNewFeaturesAlloc - nFeaturesAlloc));
+              case SWQ_FLOAT:
+                AppendSortableReal(
+                    osKey, poSrcFeat->GetFieldAsDouble(iField) );
+                break;
 
-            nFeaturesAlloc = (size_t)nNewFeaturesAlloc;
+              default:
+                osKey += poSrcFeat->GetFieldAsString(iField);
+                osKey += '\0';
+                break;
+            }
         }
+    }
+    else if( !poSrcFeat->IsFieldSet( iField ) )
+    {
+        osKey += '\0';
+    }
+    else
+    {
+        OGRField *psSrcField = poSrcFeat->GetRawFieldRef( iField );
 
-        for( iKey = 0; iKey < nOrderItems; iKey++ )
+        osKey += '\1';
+        switch( poSrcLayer->GetLayerDefn()->GetFieldDefn(iField)->GetType() )
         {
-            swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
-            OGRFieldDefn *poFDefn;
-            OGRField *psSrcField, *psDstField;
+          case OFTInteger:
+            AppendSortableInteger( osKey, psSrcField->Integer );
+            break;
 
-            psDstField = pasIndexFields + nIndexSize * nOrderItems + iKey;
+          case OFTInteger64:
+            AppendSortableInteger( osKey, psSrcField->Integer64 );
+            break;
 
-            if ( psKeyDef->field_index >= iFIDFieldIndex)
-            {
-                if ( psKeyDef->field_index < iFIDFieldIndex + SPECIAL_FIELD_COUNT )
-                {
-                    switch (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex])
-                    {
-                      case SWQ_INTEGER:
-                        psDstField->Integer = poSrcFeat->GetFieldAsInteger(psKeyDef->field_index);
-                        break;
+          case OFTReal:
+            AppendSortableReal( osKey, psSrcField->Real );
+            break;
 
-                      case SWQ_INTEGER64:
-                        psDstField->Integer64 = poSrcFeat->GetFieldAsInteger64(psKeyDef->field_index);
-                        break;
+          case OFTString:
+            osKey += psSrcField->String;
+            osKey += '\0';
+            break;
 
-                      case SWQ_FLOAT:
-                        psDstField->Real = poSrcFeat->GetFieldAsDouble(psKeyDef->field_index);
-                        break;
+          case OFTDate:
+          case OFTTime:
+          case OFTDateTime:
+            /* Same order as OGRCompareDate() */
+            AppendSortableInteger( osKey, psSrcField->Date.Year );
+            osKey += (char) psSrcField->Date.Month;
+            osKey += (char) psSrcField->Date.Day;
+            osKey += (char) psSrcField->Date.Hour;
+            osKey += (char) psSrcField->Date.Minute;
+            AppendSortableReal( osKey, psSrcField->Date.Second );
+            if( bGroupKey )
+                osKey += (char) psSrcField->Date.TZFlag;
+            break;
 
-                      default:
-                        psDstField->String = CPLStrdup( poSrcFeat->GetFieldAsString(psKeyDef->field_index) );
-                        break;
-                    }
-                }
-                continue;
-            }
-            
-            poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn( 
-                psKeyDef->field_index );
-
-            psSrcField = poSrcFeat->GetRawFieldRef( psKeyDef->field_index );
-
-            if( poFDefn->GetType() == OFTInteger 
-                || poFDefn->GetType() == OFTInteger64 
-                || poFDefn->GetType() == OFTReal
-                || poFDefn->GetType() == OFTDate
-                || poFDefn->GetType() == OFTTime
-                || poFDefn->GetType() == OFTDateTime)
-                memcpy( psDstField, psSrcField, sizeof(OGRField) );
-            else if( poFDefn->GetType() == OFTString )
+          default:
+            /* Other types do not take part in the ordering */
+            if( bGroupKey )
             {
-                if( poSrcFeat->IsFieldSet( psKeyDef->field_index ) )
-                    psDstField->String = CPLStrdup( psSrcField->String );
-                else
-                    memcpy( psDstField, psSrcField, sizeof(OGRField) );
+                osKey += poSrcFeat->GetFieldAsString(iField);
+                osKey += '\0';
             }
+            break;
         }
+    }
+}
 
-        panFIDList[nIndexSize] = poSrcFeat->GetFID();
-        delete poSrcFeat;
+/************************************************************************/
+/*                          BuildOrderByKey()                           */
+/*                                                                      */
+/*      Build a key of the order-by fields of a source feature, that   */
+/*      sorts byte-wise in the order of the ORDER BY clauses. Strings  */
+/*      compare with strcmp(), and NULL values first in ascending      */
+/*      order. The bytes of descending keys are inverted.              */
+/************************************************************************/
 
-        nIndexSize++;
-    }
+void OGRGenSQLResultsLayer::BuildOrderByKey( OGRFeature *poSrcFeat,
+                                             CPLString& osKey )
 
-    //CPLDebug("GenSQL", "CreateOrderByIndex() = %d features", nIndexSize);
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
 
-/* -------------------------------------------------------------------- */
-/*      Initialize panFIDIndex                                          */
-/* -------------------------------------------------------------------- */
-    panFIDIndex = (GIntBig *) VSIMalloc(sizeof(GIntBig) * (size_t)nIndexSize);
-    if( panFIDIndex == NULL )
-    {
-        CPLError(CE_Failure, CPLE_AppDefined, "Cannot allocate panFIDIndex");
-        VSIFree(pasIndexFields);
-        VSIFree(panFIDList);
-        nIndexSize = 0;
-        return;
-    }
-    for( i = 0; i < nIndexSize; i++ )
-        panFIDIndex[i] = i;
+    osKey.resize( 0 );
 
-/* -------------------------------------------------------------------- */
-/*      Quick sort the records.                                         */
-/* -------------------------------------------------------------------- */
-    if( !SortIndexSection( pasIndexFields, 0, nIndexSize ) )
+    for( int iKey = 0; iKey < psSelectInfo->order_specs; iKey++ )
     {
-        VSIFree(pasIndexFields);
-        VSIFree(panFIDList);
-        nIndexSize = 0;
-        VSIFree(panFIDIndex);
-        panFIDIndex = NULL;
-        return;
+        swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
+        size_t nStart = osKey.size();
+
+        AppendFieldKey( osKey, poSrcFeat, psKeyDef->field_index, FALSE );
+
+        if( !psKeyDef->ascending_flag )
+        {
+            for( size_t i = nStart; i < osKey.size(); i++ )
+                osKey[i] = (char) ~osKey[i];
+        }
     }
+}
 
-/* -------------------------------------------------------------------- */
-/*      Rework the FID map to map to real FIDs.                         */
-/* -------------------------------------------------------------------- */
-    int bAlreadySorted = TRUE;
-    for( i = 0; i < nIndexSize; i++ )
+/************************************************************************/
+/*                           DecodeFieldKey()                           */
+/*                                                                      */
+/*      Decode the value of a source field from a group key built by   */
+/*      AppendFieldKey(), and set it in a field of poFeature if it is  */
+/*      not NULL. Returns the position after the value in the key.    */
+/************************************************************************/
+
+const GByte *OGRGenSQLResultsLayer::DecodeFieldKey( const GByte *pabyKey,
+                                                    const GByte *pabyEnd,
+                                                    int iSrcField,
+                                                    OGRFeature *poFeature,
+                                                    int iField )
+
+{
+    if( pabyKey >= pabyEnd )
+        return pabyEnd;
+
+    if( *pabyKey == '\0' )
     {
-        if (panFIDIndex[i] != i)
-            bAlreadySorted = FALSE;
-        panFIDIndex[i] = panFIDList[panFIDIndex[i]];
+        if( poFeature != NULL )
+            poFeature->UnsetField( iField );
+        return pabyKey + 1;
     }
+    pabyKey ++;
 
-    CPLFree( panFIDList );
-
-/* -------------------------------------------------------------------- */
-/*      Free the key field values.                                      */
-/* -------------------------------------------------------------------- */
-    for( int iKey = 0; iKey < nOrderItems; iKey++ )
+    OGRFieldType eType;
+    if( iSrcField >= iFIDFieldIndex )
     {
-        swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
-        OGRFieldDefn *poFDefn;
+        if( iSrcField >= iFIDFieldIndex + SPECIAL_FIELD_COUNT )
+            return pabyKey;
 
-        if ( psKeyDef->field_index >= iFIDFieldIndex &&
-            psKeyDef->field_index < iFIDFieldIndex + SPECIAL_FIELD_COUNT )
+        switch (SpecialFieldTypes[iSrcField - iFIDFieldIndex])
         {
-            /* warning: only special fields of type string should be deallocated */
-            if (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex] == SWQ_STRING)
-            {
-                for( i = 0; i < nIndexSize; i++ )
-                {
-                    OGRField *psField = pasIndexFields + iKey + i * nOrderItems;
-                    CPLFree( psField->String );
-                }
-            }
-            continue;
-        }
+          case SWQ_INTEGER:
+          case SWQ_INTEGER64:
+            eType = OFTInteger64;
+            break;
 
-        poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn( 
-            psKeyDef->field_index );
+          case SWQ_FLOAT:
+            eType = OFTReal;
+            break;
 
-        if( poFDefn->GetType() == OFTString )
-        {
-            for( i = 0; i < nIndexSize; i++ )
-            {
-                OGRField *psField = pasIndexFields + iKey + i * nOrderItems;
-                
-                if( psField->Set.nMarker1 != OGRUnsetMarker 
-                    || psField->Set.nMarker2 != OGRUnsetMarker )
-                    CPLFree( psField->String );
-            }
+          default:
+            eType = OFTString;
+            break;
         }
     }
+    else
+        eType = poSrcLayer->GetLayerDefn()->GetFieldDefn(iSrcField)->GetType();
 
-    CPLFree( pasIndexFields );
-
-    /* If it is already sorted, then free than panFIDIndex array */
-    /* so that GetNextFeature() can call a sequential GetNextFeature() */
-    /* on the source array. Very useful for layers where random access */
-    /* is slow. */
-    /* Use case: the GML result of a WFS GetFeature with a SORTBY */
-    if (bAlreadySorted)
+    switch( eType )
     {
-        CPLFree( panFIDIndex );
-        panFIDIndex = NULL;
+      case OFTInteger:
+      case OFTInteger64:
+        if( pabyEnd - pabyKey < 8 )
+            return pabyEnd;
+        if( poFeature != NULL )
+            poFeature->SetField( iField, ReadSortableInteger( pabyKey ) );
+        return pabyKey + 8;
+
+      case OFTReal:
+        if( pabyEnd - pabyKey < 8 )
+            return pabyEnd;
+        if( poFeature != NULL )
+            poFeature->SetField( iField, ReadSortableReal( pabyKey ) );
+        return pabyKey + 8;
+
+      case OFTDate:
+      case OFTTime:
+      case OFTDateTime:
+        if( pabyEnd - pabyKey < 21 )
+            return pabyEnd;
+        if( poFeature != NULL )
+            poFeature->SetField( iField,
+                                 (int) ReadSortableInteger( pabyKey ),
+                                 pabyKey[8], pabyKey[9],
+                                 pabyKey[10], pabyKey[11],
+                                 (float) ReadSortableReal( pabyKey + 12 ),
+                                 pabyKey[20] );
+        return pabyKey + 21;
 
-        nIndexSize = 0;
+      default:
+      {
+          const GByte *pabyNul = (const GByte *)
+              memchr( pabyKey, '\0', pabyEnd - pabyKey );
+          if( pabyNul == NULL )
+              return pabyEnd;
+          if( poFeature != NULL )
+              poFeature->SetField( iField, (const char *) pabyKey );
+          return pabyNul + 1;
+      }
     }
+}
 
-    ResetReading();
+/************************************************************************/
+/*                          BuildGroupByKey()                           */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::BuildGroupByKey( OGRFeature *poSrcFeat,
+                                             CPLString& osKey )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    osKey.resize( 0 );
+
+    for( int iKey = 0; iKey < psSelectInfo->group_by_specs; iKey++ )
+        AppendFieldKey( osKey, poSrcFeat,
+                        psSelectInfo->group_by_defs[iKey].field_index, TRUE );
 }
 
 /************************************************************************/
-/*                          SortIndexSection()                          */
+/*                         GetAggregateValue()                          */
 /*                                                                      */
-/*      Sort the records in a section of the index.                     */
+/*      Value of a source feature passed to an aggregate function.     */
+/*      Dates are aggregated as Unix times, and times as seconds       */
+/*      since midnight. Returns FALSE if the value is NULL.            */
 /************************************************************************/
 
-int OGRGenSQLResultsLayer::SortIndexSection( OGRField *pasIndexFields, 
-                                              GIntBig nStart, GIntBig nEntries )
+static int GetAggregateValue( OGRFeature *poSrcFeat, swq_col_def *psColDef,
+                              double *pdfValue )
 
 {
-    if( nEntries < 2 )
-        return TRUE;
+    int iField = psColDef->field_index;
 
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
-    int      nOrderItems = psSelectInfo->order_specs;
+    *pdfValue = 0.0;
 
-    GIntBig nFirstGroup = nEntries / 2;
-    GIntBig nFirstStart = nStart;
-    GIntBig nSecondGroup = nEntries - nFirstGroup;
-    GIntBig nSecondStart = nStart + nFirstGroup;
-    GIntBig iMerge = 0;
-    GIntBig *panMerged;
+    if( psColDef->col_func == SWQCF_COUNT )
+    {
+        /* psColDef->field_index can be -1 in the case of a COUNT(*) */
+        if( iField < 0 )
+            return TRUE;
 
-    if( !SortIndexSection( pasIndexFields, nFirstStart, nFirstGroup ) ||
-        !SortIndexSection( pasIndexFields, nSecondStart, nSecondGroup ) )
-        return FALSE;
+        OGRFeatureDefn *poSrcDefn = poSrcFeat->GetDefnRef();
+        if( IS_GEOM_FIELD_INDEX(poSrcDefn, iField) )
+            return poSrcFeat->GetGeomFieldRef(
+                ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(poSrcDefn, iField) ) != NULL;
 
-    panMerged = (GIntBig *) VSIMalloc( sizeof(GIntBig) * (size_t)nEntries );
-    if( panMerged == NULL )
-    {
-        CPLError(CE_Failure, CPLE_AppDefined, "Cannot allocated panMerged");
-        return FALSE;
+        return poSrcFeat->IsFieldSet( iField );
     }
-        
-    while( iMerge < nEntries )
+
+    if( iField < 0 || !poSrcFeat->IsFieldSet( iField ) )
+        return FALSE;
+
+    if( psColDef->field_type == SWQ_DATE ||
+        psColDef->field_type == SWQ_TIME ||
+        psColDef->field_type == SWQ_TIMESTAMP )
     {
-        int  nResult;
+        int nYear, nMonth, nDay, nHour, nMin, nTZFlag;
+        float fSec;
 
-        if( nFirstGroup == 0 )
-            nResult = -1;
-        else if( nSecondGroup == 0 )
-            nResult = 1;
-        else
-            nResult = Compare( pasIndexFields 
-                               + panFIDIndex[nFirstStart] * nOrderItems, 
-                               pasIndexFields 
-                               + panFIDIndex[nSecondStart] * nOrderItems );
+        if( !poSrcFeat->GetFieldAsDateTime( iField, &nYear, &nMonth, &nDay,
+                                            &nHour, &nMin, &fSec, &nTZFlag ) )
+            return FALSE;
 
-        if( nResult < 0 )
+        if( psColDef->field_type == SWQ_TIME )
         {
-            panMerged[iMerge++] = panFIDIndex[nSecondStart++];
-            nSecondGroup--;
+            *pdfValue = nHour * 3600 + nMin * 60 + (double) fSec;
         }
         else
         {
-            panMerged[iMerge++] = panFIDIndex[nFirstStart++];
-            nFirstGroup--;
+            struct tm brokendowntime;
+            brokendowntime.tm_year = nYear - 1900;
+            brokendowntime.tm_mon = nMonth - 1;
+            brokendowntime.tm_mday = nDay;
+            brokendowntime.tm_hour = nHour;
+            brokendowntime.tm_min = nMin;
+            brokendowntime.tm_sec = (int)fSec;
+            *pdfValue = (double) CPLYMDHMSToUnixTime(&brokendowntime) +
+                        fmod((double)fSec, 1);
         }
+        return TRUE;
     }
 
-    /* Copy the merge list back into the main index */
-
-    memcpy( panFIDIndex + nStart, panMerged, sizeof(GIntBig) * (size_t)nEntries );
-    CPLFree( panMerged );
-    
+    *pdfValue = poSrcFeat->GetFieldAsDouble( iField );
     return TRUE;
 }
 
 /************************************************************************/
-/*                              Compare()                               */
+/*                         SetAggregateField()                          */
+/************************************************************************/
+
+static void SetAggregateField( OGRFeature *poFeature, int iField,
+                               swq_col_def *psColDef,
+                               const OGRAggregateState *psState )
+
+{
+    if( psColDef->col_func == SWQCF_COUNT )
+    {
+        poFeature->SetField( iField, psState->nCount );
+        return;
+    }
+
+    /* Aggregates of no value are NULL */
+    if( psState->nCount == 0 )
+    {
+        poFeature->UnsetField( iField );
+        return;
+    }
+
+    double dfValue;
+    switch( psColDef->col_func )
+    {
+      case SWQCF_AVG:
+        dfValue = psState->dfSum / psState->nCount;
+        break;
+      case SWQCF_MIN:
+        dfValue = psState->dfMin;
+        break;
+      case SWQCF_MAX:
+        dfValue = psState->dfMax;
+        break;
+      default:
+        dfValue = psState->dfSum;
+        break;
+    }
+
+    if( psColDef->field_type == SWQ_TIME )
+    {
+        double dfSec = fmod( dfValue, 60 );
+        GIntBig nMinutes = (GIntBig) floor( dfValue / 60 );
+        poFeature->SetField( iField, 0, 0, 0,
+                             (int)(nMinutes / 60), (int)(nMinutes % 60),
+                             (float) dfSec, 0 );
+    }
+    else if( psColDef->field_type == SWQ_DATE ||
+             psColDef->field_type == SWQ_TIMESTAMP )
+    {
+        struct tm brokendowntime;
+        double dfFloor = floor( dfValue );
+        CPLUnixTimeToYMDHMS((GIntBig)dfFloor, &brokendowntime);
+        poFeature->SetField( iField,
+                             brokendowntime.tm_year + 1900,
+                             brokendowntime.tm_mon + 1,
+                             brokendowntime.tm_mday,
+                             brokendowntime.tm_hour,
+                             brokendowntime.tm_min,
+                             (float)(brokendowntime.tm_sec + dfValue - dfFloor),
+                             0 );
+    }
+    else
+        poFeature->SetField( iField, dfValue );
+}
+
+/************************************************************************/
+/*                         FillGroupByFeature()                         */
+/*                                                                      */
+/*      Set the fields of a result feature from the key and aggregate  */
+/*      states of a group, and build its ORDER BY key from the parts   */
+/*      of the group key, as ordering fields are grouping fields.      */
 /************************************************************************/
 
-int OGRGenSQLResultsLayer::Compare( OGRField *pasFirstTuple,
-                                    OGRField *pasSecondTuple )
+void OGRGenSQLResultsLayer::FillGroupByFeature(
+    const CPLString& osKey, const std::vector<OGRAggregateState>& asStates,
+    OGRFeature *poFeature, CPLString& osOrderKey )
 
 {
     swq_select *psSelectInfo = (swq_select *) pSelectInfo;
-    int  nResult = 0, iKey;
+    const GByte *pabyStart = (const GByte *) osKey.data();
+    const GByte *pabyEnd = pabyStart + osKey.size();
+    const GByte *pabyKey = pabyStart;
+    std::vector<size_t> anBounds;
+    int iField, iGroup;
 
-    for( iKey = 0; nResult == 0 && iKey < psSelectInfo->order_specs; iKey++ )
+    for( iGroup = 0; iGroup < psSelectInfo->group_by_specs; iGroup++ )
     {
-        swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
-        OGRFieldDefn *poFDefn;
+        int iSrcField = psSelectInfo->group_by_defs[iGroup].field_index;
 
-        if( psKeyDef->field_index >= iFIDFieldIndex + SPECIAL_FIELD_COUNT )
-        {
-            CPLAssert( FALSE );
-            return 0;
-        }
-        else if( psKeyDef->field_index >= iFIDFieldIndex )
-            poFDefn = NULL;
-        else
-            poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn( 
-                psKeyDef->field_index );
-        
-        if( (pasFirstTuple[iKey].Set.nMarker1 == OGRUnsetMarker 
-             && pasFirstTuple[iKey].Set.nMarker2 == OGRUnsetMarker)
-            || (pasSecondTuple[iKey].Set.nMarker1 == OGRUnsetMarker 
-                && pasSecondTuple[iKey].Set.nMarker2 == OGRUnsetMarker) )
-            nResult = 0;
-        else if ( poFDefn == NULL )
-        {
-            switch (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex])
-            {
-              case SWQ_INTEGER:
-                if( pasFirstTuple[iKey].Integer < pasSecondTuple[iKey].Integer )
-                    nResult = -1;
-                else if( pasFirstTuple[iKey].Integer > pasSecondTuple[iKey].Integer )
-                    nResult = 1;
-                break;
-              case SWQ_INTEGER64:
-                if( pasFirstTuple[iKey].Integer64 < pasSecondTuple[iKey].Integer64 )
-                    nResult = -1;
-                else if( pasFirstTuple[iKey].Integer64 > pasSecondTuple[iKey].Integer64 )
-                    nResult = 1;
-                break;
-              case SWQ_FLOAT:
-                if( pasFirstTuple[iKey].Real < pasSecondTuple[iKey].Real )
-                    nResult = -1;
-                else if( pasFirstTuple[iKey].Real > pasSecondTuple[iKey].Real )
-                    nResult = 1;
-                break;
-              case SWQ_STRING:
-                nResult = strcmp(pasFirstTuple[iKey].String,
-                                 pasSecondTuple[iKey].String);
-                break;
+        anBounds.push_back( pabyKey - pabyStart );
 
-              default:
-                CPLAssert( FALSE );
-                nResult = 0;
-            }
-        }
-        else if( poFDefn->GetType() == OFTInteger )
+        for( iField = 0; iField < psSelectInfo->result_columns; iField++ )
         {
-            if( pasFirstTuple[iKey].Integer < pasSecondTuple[iKey].Integer )
-                nResult = -1;
-            else if( pasFirstTuple[iKey].Integer 
-                     > pasSecondTuple[iKey].Integer )
-                nResult = 1;
+            swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+            if( psColDef->col_func == SWQCF_NONE &&
+                psColDef->field_index == iSrcField )
+                DecodeFieldKey( pabyKey, pabyEnd, iSrcField, poFeature, iField );
         }
-        else if( poFDefn->GetType() == OFTInteger64 )
+
+        pabyKey = DecodeFieldKey( pabyKey, pabyEnd, iSrcField, NULL, -1 );
+    }
+    anBounds.push_back( pabyKey - pabyStart );
+
+    int iAggregate = 0;
+    for( iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    {
+        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+        if( psColDef->col_func != SWQCF_NONE )
+            SetAggregateField( poFeature, iField, psColDef,
+                               &asStates[iAggregate++] );
+    }
+
+    osOrderKey.resize( 0 );
+    for( int iKey = 0; iKey < psSelectInfo->order_specs; iKey++ )
+    {
+        swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
+
+        for( iGroup = 0; iGroup < psSelectInfo->group_by_specs; iGroup++ )
         {
-            if( pasFirstTuple[iKey].Integer64 < pasSecondTuple[iKey].Integer64 )
-                nResult = -1;
-            else if( pasFirstTuple[iKey].Integer64 
-                     > pasSecondTuple[iKey].Integer64 )
-                nResult = 1;
+            if( psSelectInfo->group_by_defs[iGroup].field_index ==
+                                                    psKeyDef->field_index )
+                break;
         }
-        else if( poFDefn->GetType() == OFTString )
-            nResult = strcmp(pasFirstTuple[iKey].String,
-                             pasSecondTuple[iKey].String);
-        else if( poFDefn->GetType() == OFTReal )
+        if( iGroup == psSelectInfo->group_by_specs )
+            continue;
+
+        size_t nStart = osOrderKey.size();
+        osOrderKey.append( osKey, anBounds[iGroup],
+                           anBounds[iGroup + 1] - anBounds[iGroup] );
+
+        if( !psKeyDef->ascending_flag )
         {
-            if( pasFirstTuple[iKey].Real < pasSecondTuple[iKey].Real )
-                nResult = -1;
-            else if( pasFirstTuple[iKey].Real > pasSecondTuple[iKey].Real )
-                nResult = 1;
+            for( size_t i = nStart; i < osOrderKey.size(); i++ )
+                osOrderKey[i] = (char) ~osOrderKey[i];
         }
-        else if( poFDefn->GetType() == OFTDate ||
-                 poFDefn->GetType() == OFTTime ||
-                 poFDefn->GetType() == OFTDateTime)
+    }
+}
+
+/************************************************************************/
+/*                         CreateGroupByIndex()                         */
+/*                                                                      */
+/*      Aggregate the source features by group with a hash            */
+/*      aggregator, and materialize the result features in            */
+/*      poOrderBySorter, keyed by their ORDER BY key. Without ORDER   */
+/*      BY, groups are returned in the order of their values.         */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::CreateGroupByIndex()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    int iField;
+
+    ResetReading();
+    ApplyFiltersToSource();
+
+    int bSaveIsGeomIgnored = poSrcLayer->GetLayerDefn()->IsGeometryIgnored();
+    if( !MustReadSourceGeometry() )
+        poSrcLayer->GetLayerDefn()->SetGeometryIgnored(TRUE);
+
+/* -------------------------------------------------------------------- */
+/*      Aggregate the source features.                                  */
+/* -------------------------------------------------------------------- */
+    std::vector<int> anAggregateColumns;
+    for( iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    {
+        if( psSelectInfo->column_defs[iField].col_func != SWQCF_NONE )
+            anAggregateColumns.push_back( iField );
+    }
+
+    int nAggregates = (int) anAggregateColumns.size();
+    std::vector<double> adfValues( nAggregates + 1 );
+    std::vector<int> abValueSet( nAggregates + 1 );
+    OGRHashAggregator oAggregator( nAggregates, OGRGetSQLMemoryLimit() );
+    CPLString osKey;
+    OGRFeature *poSrcFeat;
+    int bOK = TRUE;
+
+    while( bOK && (poSrcFeat = poSrcLayer->GetNextFeature()) != NULL )
+    {
+        BuildGroupByKey( poSrcFeat, osKey );
+
+        for( int i = 0; i < nAggregates; i++ )
         {
-            nResult = OGRCompareDate(&pasFirstTuple[iKey],
-                                     &pasSecondTuple[iKey]);
+            abValueSet[i] = GetAggregateValue(
+                poSrcFeat, psSelectInfo->column_defs + anAggregateColumns[i],
+                &adfValues[i] );
         }
+        delete poSrcFeat;
 
-        if( psKeyDef->ascending_flag )
-            nResult *= -1;
+        bOK = oAggregator.AddRow( osKey.data(), osKey.size(),
+                                  &adfValues[0], &abValueSet[0] );
     }
 
-    return nResult;
+    poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
+    ClearFilters();
+
+    if( !bOK || !oAggregator.Finish() )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Cannot aggregate the features of layer %s.",
+                  poSrcLayer->GetName() );
+        return;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Materialize the result features in the ORDER BY order. When    */
+/*      there is no filter on the results, only the first LIMIT +      */
+/*      OFFSET ones are kept.                                           */
+/* -------------------------------------------------------------------- */
+    poOrderBySorter = new OGRExternalSorter( OGRGetSQLMemoryLimit() );
+
+    if( psSelectInfo->limit >= 0 && m_poAttrQuery == NULL &&
+        !MustEvaluateSpatialFilterOnGenSQL() )
+    {
+        poOrderBySorter->SetMaxRecords(
+            MAX( 1, psSelectInfo->limit + psSelectInfo->offset ) );
+    }
+
+    std::vector<OGRAggregateState> asStates;
+    OGRFeature oFeature( poDefn );
+
+    while( bOK && oAggregator.GetNextGroup( osKey, asStates ) )
+    {
+        FillGroupByFeature( osKey, asStates, &oFeature, osOrderByKey );
+
+        abyOrderByPayload.resize( 0 );
+        OGRSerializeFeature( &oFeature, abyOrderByPayload );
+
+        bOK = poOrderBySorter->AddRecord( osOrderByKey.data(),
+                                          osOrderByKey.size(),
+                                          &abyOrderByPayload[0],
+                                          abyOrderByPayload.size() );
+    }
+
+    if( !bOK || !poOrderBySorter->Finish() )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Cannot sort the groups of layer %s.",
+                  poSrcLayer->GetName() );
+        delete poOrderBySorter;
+        poOrderBySorter = NULL;
+    }
+    else
+    {
+        CPLDebug( "GenSQL", "CreateGroupByIndex() = " CPL_FRMT_GUIB
+                  " groups", poOrderBySorter->GetRecordCount() );
+    }
+
+    ResetReading();
 }
 
 
@@ -2217,6 +3030,12 @@ void OGRGenSQLResultsLayer::FindAndSetIgnoredFields()
         AddFieldDefnToSet(psOrderDef->table_index, psOrderDef->field_index, hSet);
     }
 
+    for( int iGroup = 0; iGroup < psSelectInfo->group_by_specs; iGroup++ )
+    {
+        swq_order_def *psGroupDef = psSelectInfo->group_by_defs + iGroup;
+        AddFieldDefnToSet(psGroupDef->table_index, psGroupDef->field_index, hSet);
+    }
+
 /* -------------------------------------------------------------------- */
 /*      2nd phase : now, we can exclude the unused fields               */
 /* -------------------------------------------------------------------- */
@@ -2249,10 +3068,9 @@ void OGRGenSQLResultsLayer::FindAndSetIgnoredFields()
 
 void OGRGenSQLResultsLayer::InvalidateOrderByIndex()
 {
-    CPLFree( panFIDIndex );
-    panFIDIndex = NULL;
+    delete poOrderBySorter;
+    poOrderBySorter = NULL;
 
-    nIndexSize = 0;
     bOrderByValid = FALSE;
 }
 
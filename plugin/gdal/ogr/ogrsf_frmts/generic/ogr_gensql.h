@@ -34,6 +34,7 @@
 #include "ogrsf_frmts.h"
 #include "swq.h"
 #include "cpl_hash_set.h"
+#include "ogr_hashaggregate.h"
 
 #define GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poFDefn, iGeom) \
     ((poFDefn)->GetFieldCount() + SPECIAL_FIELD_COUNT + (iGeom))
@@ -49,6 +50,9 @@
 /*                        OGRGenSQLResultsLayer                         */
 /************************************************************************/
 
+class OGRGenSQLJoinIndex;
+class OGRExternalSorter;
+
 class CPL_DLL OGRGenSQLResultsLayer : public OGRLayer
 {
   private:
@@ -66,23 +70,47 @@ class CPL_DLL OGRGenSQLResultsLayer : public OGRLayer
     
     int        *panGeomFieldToSrcGeomField;
 
-    GIntBig     nIndexSize;
-    GIntBig    *panFIDIndex;
+    /* Source features in ORDER BY order, or result features of GROUP BY */
+    OGRExternalSorter *poOrderBySorter;
     int         bOrderByValid;
+    CPLString   osOrderByKey;
+    std::vector<GByte> abyOrderByPayload;
 
     GIntBig      nNextIndexFID;
     OGRFeature  *poSummaryFeature;
 
+    /* Number of features returned since ResetReading(), or -1 if the */
+    /* OFFSET has not been applied yet */
+    GIntBig      nIteratedFeatures;
+
     int         iFIDFieldIndex;
 
     int         nExtraDSCount;
     GDALDataset **papoExtraDS;
 
+    /* Lookup structures of the joins, built on first use */
+    std::vector<OGRGenSQLJoinIndex*> apoJoinIndexes;
+
+    OGRGenSQLJoinIndex *GetJoinIndex( int iJoin );
+    OGRFeature *FetchJoinFeature( int iJoin, OGRFeature *poSrcFeat,
+                                  int *pbOwned );
+
     OGRFeature *TranslateFeature( OGRFeature * );
+    OGRFeature *GetNextResultFeature();
     void        CreateOrderByIndex();
-    int         SortIndexSection( OGRField *pasIndexFields, 
-                                  GIntBig nStart, GIntBig nEntries );
-    int         Compare( OGRField *pasFirst, OGRField *pasSecond );
+    void        BuildOrderByKey( OGRFeature *poSrcFeat, CPLString& osKey );
+    void        AppendFieldKey( CPLString& osKey, OGRFeature *poSrcFeat,
+                                int iField, int bGroupKey );
+
+    void        CreateGroupByIndex();
+    void        BuildGroupByKey( OGRFeature *poSrcFeat, CPLString& osKey );
+    const GByte *DecodeFieldKey( const GByte *pabyKey, const GByte *pabyEnd,
+                                 int iSrcField, OGRFeature *poFeature,
+                                 int iField );
+    void        FillGroupByFeature( const CPLString& osKey,
+                                    const std::vector<OGRAggregateState>& asStates,
+                                    OGRFeature *poFeature,
+                                    CPLString& osOrderKey );
 
     void        ClearFilters();
     void        ApplyFiltersToSource();
@@ -92,6 +120,8 @@ class CPL_DLL OGRGenSQLResultsLayer : public OGRLayer
     void        AddFieldDefnToSet(int iTable, int iColumn, CPLHashSet* hSet);
 
     int         ContainGeomSpecialField(swq_expr_node* expr);
+    int         MustReadSourceGeometry();
+    int         IsGeomSourceField( int iField );
 
     void        InvalidateOrderByIndex();
     
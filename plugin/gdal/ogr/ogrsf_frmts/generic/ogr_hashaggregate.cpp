@@ -0,0 +1,716 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Implements OGRHashAggregator, that aggregates rows by group
+ *           for the GROUP BY clause of OGR SQL.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogr_hashaggregate.h"
+#include "ogr_externalsort.h"
+#include "cpl_conv.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <algorithm>
+
+CPL_CVSID("$Id$");
+
+/* Number of rows of a batch aggregated by a single job */
+#define BATCH_ROWS          4096
+
+/* Initial number of slots of the hash tables. Must be a power of two */
+#define INITIAL_SLOT_COUNT  256
+
+/************************************************************************/
+/*                            HashKey()                                 */
+/*                                                                      */
+/*      FNV-1a, with a final mix as the low bits select the slot.      */
+/************************************************************************/
+
+static GUInt32 HashKey( const GByte *pabyKey, size_t nKeySize )
+{
+    GUInt32 nHash = 2166136261U;
+
+    for( size_t i = 0; i < nKeySize; i++ )
+    {
+        nHash ^= pabyKey[i];
+        nHash *= 16777619U;
+    }
+
+    nHash ^= nHash >> 16;
+    nHash *= 0x85ebca6bU;
+    nHash ^= nHash >> 13;
+    return nHash;
+}
+
+/************************************************************************/
+/*                            CompareKeys()                             */
+/*                                                                      */
+/*      Same order as the one of OGRExternalSorter.                    */
+/************************************************************************/
+
+static int CompareKeys( const GByte *pabyKey1, size_t nKeySize1,
+                        const GByte *pabyKey2, size_t nKeySize2 )
+{
+    int nRet = memcmp( pabyKey1, pabyKey2, MIN(nKeySize1, nKeySize2) );
+    if( nRet != 0 )
+        return nRet;
+    if( nKeySize1 == nKeySize2 )
+        return 0;
+    return nKeySize1 < nKeySize2 ? -1 : 1;
+}
+
+/************************************************************************/
+/*                            UpdateState()                             */
+/************************************************************************/
+
+static void UpdateState( OGRAggregateState *psState, double dfValue )
+{
+    if( psState->nCount == 0 )
+    {
+        psState->dfMin = dfValue;
+        psState->dfMax = dfValue;
+    }
+    else if( dfValue < psState->dfMin )
+        psState->dfMin = dfValue;
+    else if( dfValue > psState->dfMax )
+        psState->dfMax = dfValue;
+
+    psState->nCount ++;
+    psState->dfSum += dfValue;
+}
+
+/************************************************************************/
+/*                            MergeState()                              */
+/************************************************************************/
+
+static void MergeState( OGRAggregateState *psState,
+                        const OGRAggregateState *psOther )
+{
+    if( psOther->nCount == 0 )
+        return;
+
+    if( psState->nCount == 0 )
+    {
+        *psState = *psOther;
+        return;
+    }
+
+    psState->nCount += psOther->nCount;
+    psState->dfSum += psOther->dfSum;
+    if( psOther->dfMin < psState->dfMin )
+        psState->dfMin = psOther->dfMin;
+    if( psOther->dfMax > psState->dfMax )
+        psState->dfMax = psOther->dfMax;
+}
+
+/************************************************************************/
+/*                        OGRHashAggregateBatch                         */
+/*                                                                      */
+/*      Rows read by the caller and not aggregated yet.                */
+/************************************************************************/
+
+class OGRHashAggregateBatch
+{
+  public:
+    std::vector<GByte>          abyKeys;
+    std::vector<size_t>         anKeyOffsets;   /* row count + 1 */
+    std::vector<double>         adfValues;
+    std::vector<GByte>          abyValueSet;
+
+    /* Table the batch is aggregated into by the job */
+    OGRHashAggregateTable      *poTable;
+
+                OGRHashAggregateBatch() : poTable(NULL)
+                    { anKeyOffsets.push_back( 0 ); }
+
+    size_t      GetRowCount() const { return anKeyOffsets.size() - 1; }
+
+    void        Clear()
+    {
+        abyKeys.resize( 0 );
+        anKeyOffsets.resize( 1 );
+        adfValues.resize( 0 );
+        abyValueSet.resize( 0 );
+    }
+};
+
+/************************************************************************/
+/*                        OGRHashAggregateTable                         */
+/*                                                                      */
+/*      Open addressing hash table, with linear probing, of the        */
+/*      aggregate states of the groups. The slots hold the index + 1   */
+/*      of the entries, whose keys are packed in a single buffer.      */
+/************************************************************************/
+
+class OGRHashAggregateTable
+{
+    int                         nAggregates;
+
+    std::vector<GUInt32>        anSlots;
+    std::vector<GUInt32>        anHashes;
+    std::vector<size_t>         anKeyOffsets;   /* entry count + 1 */
+    std::vector<GByte>          abyKeys;
+    std::vector<OGRAggregateState> asStates;
+
+    void        Grow();
+
+  public:
+                OGRHashAggregateTable( int nAggregatesIn );
+
+    GUInt32     GetEntryCount() const { return (GUInt32) anHashes.size(); }
+    const GByte *GetKey( GUInt32 iEntry ) const
+                    { return abyKeys.empty() ? NULL :
+                                    &abyKeys[0] + anKeyOffsets[iEntry]; }
+    size_t      GetKeySize( GUInt32 iEntry ) const
+                    { return anKeyOffsets[iEntry + 1] - anKeyOffsets[iEntry]; }
+    OGRAggregateState *GetStates( GUInt32 iEntry )
+                    { return nAggregates == 0 ? NULL :
+                                    &asStates[(size_t)iEntry * nAggregates]; }
+
+    OGRAggregateState *FindOrInsert( const GByte *pabyKey, size_t nKeySize,
+                                     GUInt32 nHash );
+    void        AddBatch( const OGRHashAggregateBatch *poBatch );
+    void        Merge( OGRHashAggregateTable *poOther );
+    void        Clear();
+    size_t      GetMemoryUsage() const;
+};
+
+/************************************************************************/
+/*                       OGRHashAggregateTable()                        */
+/************************************************************************/
+
+OGRHashAggregateTable::OGRHashAggregateTable( int nAggregatesIn ) :
+    nAggregates(nAggregatesIn)
+
+{
+    Clear();
+}
+
+/************************************************************************/
+/*                               Clear()                                */
+/*                                                                      */
+/*      The buffers are released, and not just emptied, so that the    */
+/*      memory is actually given back after the tables are spilled.    */
+/************************************************************************/
+
+void OGRHashAggregateTable::Clear()
+
+{
+    std::vector<GUInt32>( INITIAL_SLOT_COUNT, 0 ).swap( anSlots );
+    std::vector<GUInt32>().swap( anHashes );
+    std::vector<size_t>( 1, 0 ).swap( anKeyOffsets );
+    std::vector<GByte>().swap( abyKeys );
+    std::vector<OGRAggregateState>().swap( asStates );
+}
+
+/************************************************************************/
+/*                           GetMemoryUsage()                           */
+/*                                                                      */
+/*      Allocated, rather than used, size of the buffers.               */
+/************************************************************************/
+
+size_t OGRHashAggregateTable::GetMemoryUsage() const
+
+{
+    return anSlots.capacity() * sizeof(GUInt32) +
+           anHashes.capacity() * sizeof(GUInt32) +
+           anKeyOffsets.capacity() * sizeof(size_t) +
+           abyKeys.capacity() +
+           asStates.capacity() * sizeof(OGRAggregateState);
+}
+
+/************************************************************************/
+/*                                Grow()                                */
+/************************************************************************/
+
+void OGRHashAggregateTable::Grow()
+
+{
+    size_t nSlots = anSlots.size() * 2;
+    size_t nMask = nSlots - 1;
+
+    anSlots.assign( nSlots, 0 );
+
+    for( GUInt32 iEntry = 0; iEntry < GetEntryCount(); iEntry++ )
+    {
+        size_t iSlot = anHashes[iEntry] & nMask;
+        while( anSlots[iSlot] != 0 )
+            iSlot = (iSlot + 1) & nMask;
+        anSlots[iSlot] = iEntry + 1;
+    }
+}
+
+/************************************************************************/
+/*                            FindOrInsert()                            */
+/*                                                                      */
+/*      Return the states of the group, that are created empty if it  */
+/*      was not in the table yet.                                       */
+/************************************************************************/
+
+OGRAggregateState *OGRHashAggregateTable::FindOrInsert( const GByte *pabyKey,
+                                                        size_t nKeySize,
+                                                        GUInt32 nHash )
+
+{
+    /* Keep the load factor below one half */
+    if( (anHashes.size() + 1) * 2 > anSlots.size() )
+        Grow();
+
+    size_t nMask = anSlots.size() - 1;
+    size_t iSlot = nHash & nMask;
+
+    while( anSlots[iSlot] != 0 )
+    {
+        GUInt32 iEntry = anSlots[iSlot] - 1;
+
+        if( anHashes[iEntry] == nHash &&
+            GetKeySize( iEntry ) == nKeySize &&
+            memcmp( GetKey( iEntry ), pabyKey, nKeySize ) == 0 )
+            return GetStates( iEntry );
+
+        iSlot = (iSlot + 1) & nMask;
+    }
+
+    GUInt32 iEntry = GetEntryCount();
+    OGRAggregateState sEmptyState = { 0, 0.0, 0.0, 0.0 };
+
+    anSlots[iSlot] = iEntry + 1;
+    anHashes.push_back( nHash );
+    abyKeys.insert( abyKeys.end(), pabyKey, pabyKey + nKeySize );
+    anKeyOffsets.push_back( abyKeys.size() );
+    asStates.resize( asStates.size() + nAggregates, sEmptyState );
+
+    return GetStates( iEntry );
+}
+
+/************************************************************************/
+/*                              AddBatch()                              */
+/************************************************************************/
+
+void OGRHashAggregateTable::AddBatch( const OGRHashAggregateBatch *poBatch )
+
+{
+    size_t nRows = poBatch->GetRowCount();
+
+    for( size_t iRow = 0; iRow < nRows; iRow++ )
+    {
+        const GByte *pabyKey = poBatch->abyKeys.empty() ? NULL :
+            &poBatch->abyKeys[0] + poBatch->anKeyOffsets[iRow];
+        size_t nKeySize = poBatch->anKeyOffsets[iRow + 1] -
+                          poBatch->anKeyOffsets[iRow];
+
+        OGRAggregateState *pasStates =
+            FindOrInsert( pabyKey, nKeySize, HashKey( pabyKey, nKeySize ) );
+
+        for( int i = 0; i < nAggregates; i++ )
+        {
+            size_t iValue = iRow * nAggregates + i;
+            if( poBatch->abyValueSet[iValue] )
+                UpdateState( pasStates + i, poBatch->adfValues[iValue] );
+        }
+    }
+}
+
+/************************************************************************/
+/*                               Merge()                                */
+/*                                                                      */
+/*      Merge the groups of another table into this one, and clear     */
+/*      the other table.                                                */
+/************************************************************************/
+
+void OGRHashAggregateTable::Merge( OGRHashAggregateTable *poOther )
+
+{
+    for( GUInt32 iEntry = 0; iEntry < poOther->GetEntryCount(); iEntry++ )
+    {
+        OGRAggregateState *pasStates =
+            FindOrInsert( poOther->GetKey( iEntry ),
+                          poOther->GetKeySize( iEntry ),
+                          poOther->anHashes[iEntry] );
+        OGRAggregateState *pasOtherStates = poOther->GetStates( iEntry );
+
+        for( int i = 0; i < nAggregates; i++ )
+            MergeState( pasStates + i, pasOtherStates + i );
+    }
+
+    poOther->Clear();
+}
+
+/************************************************************************/
+/*                      AggregateBatchThread()                          */
+/************************************************************************/
+
+static void AggregateBatchThread( void *pData )
+{
+    OGRHashAggregateBatch *poBatch = (OGRHashAggregateBatch *) pData;
+    poBatch->poTable->AddBatch( poBatch );
+}
+
+/* Orders the entries of a table by key */
+class OGRHashAggregateEntryLess
+{
+    const OGRHashAggregateTable *poTable;
+
+  public:
+    OGRHashAggregateEntryLess( const OGRHashAggregateTable *poTableIn ) :
+        poTable(poTableIn) {}
+
+    bool operator()( GUInt32 iEntry1, GUInt32 iEntry2 ) const
+    {
+        return CompareKeys( poTable->GetKey( iEntry1 ),
+                            poTable->GetKeySize( iEntry1 ),
+                            poTable->GetKey( iEntry2 ),
+                            poTable->GetKeySize( iEntry2 ) ) < 0;
+    }
+};
+
+/************************************************************************/
+/*                         OGRHashAggregator()                          */
+/************************************************************************/
+
+OGRHashAggregator::OGRHashAggregator( int nAggregatesIn,
+                                      size_t nMemoryLimitIn ) :
+    nAggregates(nAggregatesIn),
+    nMemoryLimit(nMemoryLimitIn),
+    bError(FALSE),
+    poPool(NULL),
+    iFillingSet(0),
+    iFillingBatch(0),
+    iRunningSet(-1),
+    poSorter(NULL),
+    bFinished(FALSE),
+    iNextEntry(0),
+    bPendingRecord(FALSE)
+
+{
+    int nThreads = OGRGetSQLThreadCount();
+
+    for( int i = 0; i < nThreads; i++ )
+        apoTables.push_back( new OGRHashAggregateTable( nAggregates ) );
+    for( int i = 0; i < 2 * nThreads; i++ )
+        apoBatches.push_back( new OGRHashAggregateBatch() );
+}
+
+/************************************************************************/
+/*                         ~OGRHashAggregator()                         */
+/************************************************************************/
+
+OGRHashAggregator::~OGRHashAggregator()
+
+{
+    /* Jobs could still be running on the batches */
+    WaitBatches();
+    delete poPool;
+
+    for( size_t i = 0; i < apoTables.size(); i++ )
+        delete apoTables[i];
+    for( size_t i = 0; i < apoBatches.size(); i++ )
+        delete apoBatches[i];
+
+    delete poSorter;
+}
+
+/************************************************************************/
+/*                           SubmitBatches()                            */
+/*                                                                      */
+/*      Start aggregating a set of batches, each one into its table.   */
+/*      The worker threads are only started once there are enough      */
+/*      rows to fill a set of batches.                                  */
+/************************************************************************/
+
+void OGRHashAggregator::SubmitBatches( int iSet, int bStartThreads )
+
+{
+    if( poPool == NULL && bStartThreads && apoTables.size() > 1 )
+    {
+        poPool = new CPLWorkerThreadPool();
+        if( !poPool->Setup( (int) apoTables.size() ) )
+        {
+            delete poPool;
+            poPool = NULL;
+        }
+    }
+
+    for( int i = 0; i < (int) apoTables.size(); i++ )
+    {
+        OGRHashAggregateBatch *poBatch = GetBatch( iSet, i );
+        if( poBatch->GetRowCount() == 0 )
+            continue;
+
+        if( poPool != NULL )
+        {
+            poBatch->poTable = apoTables[i];
+            poPool->SubmitJob( AggregateBatchThread, poBatch );
+        }
+        else
+            apoTables[0]->AddBatch( poBatch );
+    }
+
+    iRunningSet = iSet;
+}
+
+/************************************************************************/
+/*                            WaitBatches()                             */
+/************************************************************************/
+
+void OGRHashAggregator::WaitBatches()
+
+{
+    if( iRunningSet < 0 )
+        return;
+
+    if( poPool != NULL )
+        poPool->WaitCompletion();
+
+    for( int i = 0; i < (int) apoTables.size(); i++ )
+        GetBatch( iRunningSet, i )->Clear();
+
+    iRunningSet = -1;
+}
+
+/************************************************************************/
+/*                           GetMemoryUsage()                           */
+/************************************************************************/
+
+size_t OGRHashAggregator::GetMemoryUsage()
+
+{
+    size_t nUsage = 0;
+
+    for( size_t i = 0; i < apoTables.size(); i++ )
+        nUsage += apoTables[i]->GetMemoryUsage();
+
+    return nUsage;
+}
+
+/************************************************************************/
+/*                            SpillTables()                             */
+/*                                                                      */
+/*      Write the partial states of the groups of the tables to the    */
+/*      sorter, and clear the tables. No job must be running.          */
+/************************************************************************/
+
+int OGRHashAggregator::SpillTables()
+
+{
+    if( poSorter == NULL )
+    {
+        CPLDebug( "OGR", "Spilling GROUP BY aggregates to disk" );
+        poSorter = new OGRExternalSorter( MAX( (size_t)1, nMemoryLimit / 4 ) );
+    }
+
+    OGRAggregateState sDummyState;
+
+    for( size_t iTable = 0; iTable < apoTables.size(); iTable++ )
+    {
+        OGRHashAggregateTable *poTable = apoTables[iTable];
+
+        for( GUInt32 iEntry = 0; iEntry < poTable->GetEntryCount(); iEntry++ )
+        {
+            OGRAggregateState *pasStates = poTable->GetStates( iEntry );
+
+            if( !poSorter->AddRecord( poTable->GetKey( iEntry ),
+                                      poTable->GetKeySize( iEntry ),
+                                      pasStates ? pasStates : &sDummyState,
+                                      nAggregates * sizeof(OGRAggregateState) ) )
+            {
+                bError = TRUE;
+                return FALSE;
+            }
+        }
+
+        poTable->Clear();
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                               AddRow()                               */
+/*                                                                      */
+/*      Add a row, with the value of each aggregate. The values of     */
+/*      the aggregates for which pabValueSet is FALSE are ignored.     */
+/************************************************************************/
+
+int OGRHashAggregator::AddRow( const void *pKey, size_t nKeySize,
+                               const double *padfValues,
+                               const int *pabValueSet )
+
+{
+    if( bFinished || bError )
+        return FALSE;
+
+    OGRHashAggregateBatch *poBatch = GetBatch( iFillingSet, iFillingBatch );
+    const GByte *pabyKey = (const GByte *) pKey;
+
+    poBatch->abyKeys.insert( poBatch->abyKeys.end(),
+                             pabyKey, pabyKey + nKeySize );
+    poBatch->anKeyOffsets.push_back( poBatch->abyKeys.size() );
+    for( int i = 0; i < nAggregates; i++ )
+    {
+        poBatch->adfValues.push_back( padfValues[i] );
+        poBatch->abyValueSet.push_back( (GByte) (pabValueSet[i] != 0) );
+    }
+
+    if( poBatch->GetRowCount() < BATCH_ROWS )
+        return TRUE;
+
+    iFillingBatch ++;
+    if( iFillingBatch < (int) apoTables.size() )
+        return TRUE;
+
+/* -------------------------------------------------------------------- */
+/*      The set of batches is full: wait for the aggregation of the    */
+/*      other set, and start aggregating this one.                     */
+/* -------------------------------------------------------------------- */
+    WaitBatches();
+
+    if( GetMemoryUsage() > nMemoryLimit && !SpillTables() )
+        return FALSE;
+
+    SubmitBatches( iFillingSet, TRUE );
+
+    iFillingSet = 1 - iFillingSet;
+    iFillingBatch = 0;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                               Finish()                               */
+/*                                                                      */
+/*      Aggregate the remaining rows, and merge the partial            */
+/*      aggregates of the tables or of the sorter.                     */
+/************************************************************************/
+
+int OGRHashAggregator::Finish()
+
+{
+    if( bFinished || bError )
+        return FALSE;
+
+    WaitBatches();
+    SubmitBatches( iFillingSet, FALSE );
+    WaitBatches();
+
+    delete poPool;
+    poPool = NULL;
+
+    bFinished = TRUE;
+
+    if( poSorter != NULL || GetMemoryUsage() > nMemoryLimit )
+    {
+        if( !SpillTables() || !poSorter->Finish() )
+        {
+            bError = TRUE;
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    for( size_t i = 1; i < apoTables.size(); i++ )
+        apoTables[0]->Merge( apoTables[i] );
+
+    OGRHashAggregateTable *poTable = apoTables[0];
+    anSortedEntries.resize( poTable->GetEntryCount() );
+    for( GUInt32 iEntry = 0; iEntry < poTable->GetEntryCount(); iEntry++ )
+        anSortedEntries[iEntry] = iEntry;
+
+    std::sort( anSortedEntries.begin(), anSortedEntries.end(),
+               OGRHashAggregateEntryLess( poTable ) );
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                            GetNextGroup()                            */
+/************************************************************************/
+
+int OGRHashAggregator::GetNextGroup( CPLString& osKey,
+                                     std::vector<OGRAggregateState>& asStates )
+
+{
+    if( !bFinished || bError )
+        return FALSE;
+
+/* -------------------------------------------------------------------- */
+/*      In memory groups.                                               */
+/* -------------------------------------------------------------------- */
+    if( poSorter == NULL )
+    {
+        if( iNextEntry >= anSortedEntries.size() )
+            return FALSE;
+
+        OGRHashAggregateTable *poTable = apoTables[0];
+        GUInt32 iEntry = anSortedEntries[iNextEntry++];
+        OGRAggregateState *pasStates = poTable->GetStates( iEntry );
+
+        osKey.assign( (const char *) poTable->GetKey( iEntry ),
+                      poTable->GetKeySize( iEntry ) );
+        asStates.resize( nAggregates );
+        for( int i = 0; i < nAggregates; i++ )
+            asStates[i] = pasStates[i];
+        return TRUE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Spilled groups: the partial states of a group are in           */
+/*      consecutive records.                                            */
+/* -------------------------------------------------------------------- */
+    if( !bPendingRecord &&
+        !poSorter->GetNextRecord( osPendingKey, abyPendingStates ) )
+        return FALSE;
+
+    size_t nStatesSize = nAggregates * sizeof(OGRAggregateState);
+
+    osKey = osPendingKey;
+    asStates.resize( nAggregates );
+    if( nAggregates > 0 && abyPendingStates.size() == nStatesSize )
+        memcpy( &asStates[0], &abyPendingStates[0], nStatesSize );
+
+    bPendingRecord = FALSE;
+    while( poSorter->GetNextRecord( osPendingKey, abyPendingStates ) )
+    {
+        if( osPendingKey != osKey )
+        {
+            bPendingRecord = TRUE;
+            break;
+        }
+
+        if( abyPendingStates.size() != nStatesSize )
+            continue;
+
+        for( int i = 0; i < nAggregates; i++ )
+        {
+            OGRAggregateState sState;
+            memcpy( &sState, &abyPendingStates[i * sizeof(sState)],
+                    sizeof(sState) );
+            MergeState( &asStates[i], &sState );
+        }
+    }
+
+    return TRUE;
+}
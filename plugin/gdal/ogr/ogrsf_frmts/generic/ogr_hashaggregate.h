@@ -0,0 +1,112 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Hash based aggregation of rows by group, for the GROUP BY
+ *           clause of OGR SQL.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef _OGR_HASHAGGREGATE_H_INCLUDED
+#define _OGR_HASHAGGREGATE_H_INCLUDED
+
+#include "cpl_string.h"
+
+#include <vector>
+
+/* Running state of an aggregate over the values of a group. The values */
+/* that are not set are not accounted, so COUNT(*) must pass set values. */
+typedef struct
+{
+    GIntBig     nCount;
+    double      dfSum;
+    double      dfMin;
+    double      dfMax;
+} OGRAggregateState;
+
+/************************************************************************/
+/*                          OGRHashAggregator                           */
+/*                                                                      */
+/*      Aggregates rows made of a group key and of a value per         */
+/*      aggregate. Rows are buffered in batches that are aggregated    */
+/*      by worker threads into their own open addressing hash tables,  */
+/*      merged by Finish(). When the tables exceed the memory limit,   */
+/*      their partial states are spilled to an external sorter, and    */
+/*      combined when reading it back.                                 */
+/*                                                                      */
+/*      Groups are returned in the byte-wise order of their keys.      */
+/************************************************************************/
+
+class OGRHashAggregateTable;
+class OGRHashAggregateBatch;
+class OGRExternalSorter;
+class CPLWorkerThreadPool;
+
+class OGRHashAggregator
+{
+    int                         nAggregates;
+    size_t                      nMemoryLimit;
+    int                         bError;
+
+    std::vector<OGRHashAggregateTable*> apoTables;
+    CPLWorkerThreadPool        *poPool;
+
+    /* Two sets of one batch per table: one is filled while the other */
+    /* one is being aggregated */
+    std::vector<OGRHashAggregateBatch*> apoBatches;
+    int                         iFillingSet;
+    int                         iFillingBatch;
+    int                         iRunningSet;
+
+    OGRExternalSorter          *poSorter;
+
+    /* Reading of the groups */
+    int                         bFinished;
+    std::vector<GUInt32>        anSortedEntries;
+    size_t                      iNextEntry;
+    CPLString                   osPendingKey;
+    std::vector<GByte>          abyPendingStates;
+    int                         bPendingRecord;
+
+    OGRHashAggregateBatch *GetBatch( int iSet, int iBatch )
+                    { return apoBatches[iSet * apoTables.size() + iBatch]; }
+
+    void        SubmitBatches( int iSet, int bStartThreads );
+    void        WaitBatches();
+    size_t      GetMemoryUsage();
+    int         SpillTables();
+
+  public:
+                OGRHashAggregator( int nAggregates, size_t nMemoryLimit );
+               ~OGRHashAggregator();
+
+    int         AddRow( const void *pKey, size_t nKeySize,
+                        const double *padfValues, const int *pabValueSet );
+    int         Finish();
+
+    int         GetNextGroup( CPLString& osKey,
+                              std::vector<OGRAggregateState>& asStates );
+};
+
+#endif /* ndef _OGR_HASHAGGREGATE_H_INCLUDED */
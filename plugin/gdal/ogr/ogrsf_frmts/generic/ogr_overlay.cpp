@@ -0,0 +1,946 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Overlay operations between layers (intersection, union, ...),
+ *           driven by an in-memory spatial index and worker threads.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "ogr_overlay.h"
+#include "ogr_strtree.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <vector>
+
+CPL_CVSID("$Id$");
+
+/* Number of features of the driving layer processed by a batch of jobs, */
+/* per thread */
+#define FEATURES_PER_THREAD     64
+
+/************************************************************************/
+/*         helper functions for layer overlay methods                   */
+/************************************************************************/
+
+/************************************************************************/
+/*                      OGROverlayGetThreadCount()                      */
+/*                                                                      */
+/*      Number of threads processing the features of the driving       */
+/*      layer, from GDAL_NUM_THREADS. Single threaded by default.      */
+/************************************************************************/
+
+static int OGROverlayGetThreadCount()
+{
+    const char *pszThreads = CPLGetConfigOption( "GDAL_NUM_THREADS", "1" );
+    int nThreads = EQUAL(pszThreads, "ALL_CPUS") ? CPLGetNumCPUs() :
+                                                   atoi(pszThreads);
+    return MAX( 1, MIN( nThreads, 128 ) );
+}
+
+static
+OGRErr create_field_map(OGRFeatureDefn *poDefn, int **map)
+{
+    OGRErr ret = OGRERR_NONE;
+    int n = poDefn->GetFieldCount();
+    if (n > 0) {
+        *map = (int*)VSIMalloc(sizeof(int) * n);
+        if (!(*map)) return OGRERR_NOT_ENOUGH_MEMORY;
+        for(int i=0;i<n;i++)
+            (*map)[i] = -1;
+    }
+    return ret;
+}
+
+static
+OGRErr set_result_schema(OGRLayer *pLayerResult,
+                         OGRFeatureDefn *poDefnInput,
+                         OGRFeatureDefn *poDefnMethod,
+                         int *mapInput,
+                         int *mapMethod,
+                         int combined,
+                         char** papszOptions)
+{
+    OGRErr ret = OGRERR_NONE;
+    OGRFeatureDefn *poDefnResult = pLayerResult->GetLayerDefn();
+    const char* pszInputPrefix = CSLFetchNameValue(papszOptions, "INPUT_PREFIX");
+    const char* pszMethodPrefix = CSLFetchNameValue(papszOptions, "METHOD_PREFIX");
+    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
+    if (poDefnResult->GetFieldCount() > 0) {
+        // the user has defined the schema of the output layer
+        for( int iField = 0; iField < poDefnInput->GetFieldCount(); iField++ ) {
+            CPLString osName(poDefnInput->GetFieldDefn(iField)->GetNameRef());
+            if( pszInputPrefix != NULL )
+                osName = pszInputPrefix + osName;
+            mapInput[iField] = poDefnResult->GetFieldIndex(osName);
+        }
+        if (!mapMethod) return ret;
+        for( int iField = 0; iField < poDefnMethod->GetFieldCount(); iField++ ) {
+            CPLString osName(poDefnMethod->GetFieldDefn(iField)->GetNameRef());
+            if( pszMethodPrefix != NULL )
+                osName = pszMethodPrefix + osName;
+            mapMethod[iField] = poDefnResult->GetFieldIndex(osName);
+        }
+    } else {
+        // use schema from the input layer or from input and method layers
+        int nFieldsInput = poDefnInput->GetFieldCount();
+        for( int iField = 0; iField < nFieldsInput; iField++ ) {
+            OGRFieldDefn oFieldDefn(poDefnInput->GetFieldDefn(iField));
+            if( pszInputPrefix != NULL )
+                oFieldDefn.SetName(CPLSPrintf("%s%s", pszInputPrefix, oFieldDefn.GetNameRef()));
+            ret = pLayerResult->CreateField(&oFieldDefn);
+            if (ret != OGRERR_NONE) {
+                if (!bSkipFailures)
+                    return ret;
+                else {
+                    CPLErrorReset();
+                    ret = OGRERR_NONE;
+                }
+            }
+            mapInput[iField] = iField;
+        }
+        if (!combined) return ret;
+        if (!mapMethod) return ret;
+        for( int iField = 0; iField < poDefnMethod->GetFieldCount(); iField++ ) {
+            OGRFieldDefn oFieldDefn(poDefnMethod->GetFieldDefn(iField));
+            if( pszMethodPrefix != NULL )
+                oFieldDefn.SetName(CPLSPrintf("%s%s", pszMethodPrefix, oFieldDefn.GetNameRef()));
+            ret = pLayerResult->CreateField(&oFieldDefn);
+            if (ret != OGRERR_NONE) {
+                if (!bSkipFailures)
+                    return ret;
+                else {
+                    CPLErrorReset();
+                    ret = OGRERR_NONE;
+                }
+            }
+            mapMethod[iField] = nFieldsInput+iField;
+        }
+    }
+    return ret;
+}
+
+static OGRGeometry* promote_to_multi(OGRGeometry* poGeom)
+{
+    OGRwkbGeometryType eType = wkbFlatten(poGeom->getGeometryType());
+    if( eType == wkbPolygon )
+        return OGRGeometryFactory::forceToMultiPolygon(poGeom);
+    else if( eType == wkbLineString )
+        return OGRGeometryFactory::forceToMultiLineString(poGeom);
+    else
+        return poGeom;
+}
+
+/************************************************************************/
+/*                           OGROverlayIndex                            */
+/*                                                                      */
+/*      The features with a geometry of a layer, read once with the    */
+/*      current filters of the layer, and their spatial index.         */
+/************************************************************************/
+
+class OGROverlayIndex
+{
+  public:
+    std::vector<OGRFeature*>    apoFeatures;
+    OGRSTRTree                  oTree;
+
+               ~OGROverlayIndex();
+
+    void        Load( OGRLayer *poLayer );
+};
+
+OGROverlayIndex::~OGROverlayIndex()
+{
+    for( size_t i = 0; i < apoFeatures.size(); i++ )
+        delete apoFeatures[i];
+}
+
+void OGROverlayIndex::Load( OGRLayer *poLayer )
+{
+    OGRFeature *poFeature;
+
+    poLayer->ResetReading();
+    while( (poFeature = poLayer->GetNextFeature()) != NULL )
+    {
+        OGRGeometry *poGeom = poFeature->GetGeometryRef();
+        if( poGeom == NULL )
+        {
+            delete poFeature;
+            continue;
+        }
+
+        OGREnvelope sEnvelope;
+        poGeom->getEnvelope( &sEnvelope );
+        oTree.AddItem( sEnvelope, (GIntBig) apoFeatures.size() );
+        apoFeatures.push_back( poFeature );
+    }
+    poLayer->ResetReading();
+
+    oTree.Build();
+}
+
+/************************************************************************/
+/*                            OGROverlayJob                             */
+/*                                                                      */
+/*      The parts of the result computed for a feature of the driving  */
+/*      layer. iIndexed is the index of the feature of the indexed     */
+/*      layer whose fields are also copied into the result, or -1.     */
+/************************************************************************/
+
+typedef struct
+{
+    OGRGeometry    *poGeom;
+    int             iIndexed;
+} OGROverlayPart;
+
+class OGROverlayEngine;
+
+class OGROverlayJob
+{
+  public:
+    OGROverlayEngine           *poEngine;
+    OGRFeature                 *poFeature;
+    std::vector<OGROverlayPart> asParts;
+
+    /* Index whose features iIndexed refers to */
+    OGROverlayIndex            *poIndex;
+    /* Set when the feature must be processed again with the index of */
+    /* all the features of the indexed layer */
+    int                         bNeedUnfilteredIndex;
+
+                OGROverlayJob() : poEngine(NULL), poFeature(NULL),
+                                  poIndex(NULL), bNeedUnfilteredIndex(FALSE) {}
+
+    void        AddPart( OGRGeometry *poGeom, int iIndexed );
+};
+
+void OGROverlayJob::AddPart( OGRGeometry *poGeom, int iIndexed )
+{
+    if( poGeom == NULL || poGeom->IsEmpty() )
+    {
+        delete poGeom;
+        return;
+    }
+
+    OGROverlayPart sPart;
+    sPart.poGeom = poGeom;
+    sPart.iIndexed = iIndexed;
+    asParts.push_back( sPart );
+}
+
+/************************************************************************/
+/*                           OGROverlayEngine                           */
+/************************************************************************/
+
+class OGROverlayEngine
+{
+    OGRLayer           *poLayerInput;
+    OGRLayer           *poLayerMethod;
+    OGRLayer           *poLayerResult;
+    OGROverlayOperation eOperation;
+
+    int                 bSkipFailures;
+    int                 bPromoteToMulti;
+    GDALProgressFunc    pfnProgress;
+    void               *pProgressArg;
+    double              dfProgressMax;
+    double              dfProgressCounter;
+
+    OGRFeatureDefn     *poDefnResult;
+    int                *mapInput;
+    int                *mapMethod;
+
+    CPLWorkerThreadPool *poPool;
+    int                 nThreads;
+
+    /* State of the current pass: the features of the driving layer are */
+    /* overlaid with the ones of the indexed layer */
+    int                 bMethodDriven;
+    OGRLayer           *poIndexedLayer;
+    OGROverlayIndex    *poIndex;
+    OGRGeometry        *poIndexFilter;
+    OGROverlayIndex    *poUnfilteredIndex;
+
+    int         Progress();
+    int         GetCandidates( OGROverlayJob *poJob,
+                               std::vector<GIntBig>& anCandidates );
+    OGROverlayIndex *GetUnfilteredIndex();
+    OGROverlayJob   *NewJob( OGRFeature *poFeature );
+    OGRErr      WriteParts( OGROverlayJob *poJob );
+    OGRErr      WriteFeature( OGRFeature *poFeature );
+    OGRErr      RunJobs( std::vector<OGROverlayJob*>& apoJobs );
+    OGRErr      RunPass( OGRLayer *poDriving, OGRLayer *poIndexed,
+                         OGROverlayIndex *poIndexIn );
+    OGRErr      RunMethodPass( OGROverlayIndex *poMethodIndex );
+    OGRErr      CopyMethodFeatures( OGROverlayIndex *poMethodIndex );
+
+    static void ProcessJobThread( void *pData );
+
+  public:
+                OGROverlayEngine( OGRLayer *poLayerInput,
+                                  OGRLayer *poLayerMethod,
+                                  OGRLayer *poLayerResult,
+                                  OGROverlayOperation eOperation,
+                                  char** papszOptions,
+                                  GDALProgressFunc pfnProgress,
+                                  void * pProgressArg );
+               ~OGROverlayEngine();
+
+    void        ProcessFeature( OGROverlayJob *poJob );
+
+    OGRErr      Run( char** papszOptions );
+};
+
+/************************************************************************/
+/*                          OGROverlayEngine()                          */
+/************************************************************************/
+
+OGROverlayEngine::OGROverlayEngine( OGRLayer *poLayerInputIn,
+                                    OGRLayer *poLayerMethodIn,
+                                    OGRLayer *poLayerResultIn,
+                                    OGROverlayOperation eOperationIn,
+                                    char** papszOptions,
+                                    GDALProgressFunc pfnProgressIn,
+                                    void * pProgressArgIn ) :
+    poLayerInput(poLayerInputIn), poLayerMethod(poLayerMethodIn),
+    poLayerResult(poLayerResultIn), eOperation(eOperationIn),
+    pfnProgress(pfnProgressIn), pProgressArg(pProgressArgIn),
+    dfProgressMax(0), dfProgressCounter(0),
+    poDefnResult(NULL), mapInput(NULL), mapMethod(NULL),
+    poPool(NULL), nThreads(OGROverlayGetThreadCount()),
+    bMethodDriven(FALSE), poIndexedLayer(NULL), poIndex(NULL),
+    poIndexFilter(NULL), poUnfilteredIndex(NULL)
+{
+    bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
+    bPromoteToMulti = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
+}
+
+/************************************************************************/
+/*                         ~OGROverlayEngine()                          */
+/************************************************************************/
+
+OGROverlayEngine::~OGROverlayEngine()
+{
+    delete poPool;
+    if (mapInput) VSIFree(mapInput);
+    if (mapMethod) VSIFree(mapMethod);
+}
+
+/************************************************************************/
+/*                              Progress()                              */
+/*                                                                      */
+/*      Account a feature of a driving layer.                          */
+/************************************************************************/
+
+int OGROverlayEngine::Progress()
+{
+    if (pfnProgress) {
+        double p = dfProgressCounter/dfProgressMax;
+        if (p > 0) {
+            if (!pfnProgress(p, "", pProgressArg)) {
+                CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
+                return FALSE;
+            }
+        }
+        dfProgressCounter += 1.0;
+    }
+    return TRUE;
+}
+
+/************************************************************************/
+/*                           GetCandidates()                            */
+/*                                                                      */
+/*      Return, in the order of the indexed layer, the features that   */
+/*      would be read from it with the geometry of a driving feature   */
+/*      (intersected with its original spatial filter) as spatial      */
+/*      filter.  FALSE is returned when the driving feature does not   */
+/*      intersect that filter, and is then skipped.                    */
+/*                                                                      */
+/*      If that intersection cannot be computed, the spatial filter    */
+/*      used to be reset, so that all the features of the layer were   */
+/*      read.  As the features outside of the original filter are not  */
+/*      in the index, FALSE is returned and the job is flagged to be   */
+/*      processed again, by the main thread, with GetUnfilteredIndex(). */
+/************************************************************************/
+
+int OGROverlayEngine::GetCandidates( OGROverlayJob *poJob,
+                                     std::vector<GIntBig>& anCandidates )
+{
+    OGRGeometry *poGeom = poJob->poFeature->GetGeometryRef();
+    OGRGeometry *poFilter = poGeom;
+    OGRGeometry *poIntersection = NULL;
+
+    anCandidates.resize(0);
+
+    if( poJob->poIndex == poUnfilteredIndex )
+    {
+        /* Like a NULL spatial filter */
+        for( size_t i = 0; i < poUnfilteredIndex->apoFeatures.size(); i++ )
+            anCandidates.push_back( (GIntBig) i );
+        return TRUE;
+    }
+
+    if( poIndexFilter != NULL )
+    {
+        if( !poGeom->Intersects(poIndexFilter) )
+            return FALSE;
+        poIntersection = poGeom->Intersection(poIndexFilter);
+        if( poIntersection == NULL )
+        {
+            poJob->bNeedUnfilteredIndex = TRUE;
+            return FALSE;
+        }
+        poFilter = poIntersection;
+    }
+
+    OGROverlayIndex *poJobIndex = poJob->poIndex;
+    OGREnvelope sEnvelope;
+    poFilter->getEnvelope( &sEnvelope );
+    poJobIndex->oTree.Search( sEnvelope, anCandidates );
+
+/* -------------------------------------------------------------------- */
+/*      Keep the candidates that really intersect the filter, with a   */
+/*      prepared geometry if there are several ones.                   */
+/* -------------------------------------------------------------------- */
+    OGRPreparedGeometry *poPrepared = NULL;
+    if( anCandidates.size() > 1 && OGRHasPreparedGeometrySupport() )
+        poPrepared = OGRCreatePreparedGeometry( poFilter );
+
+    size_t nKept = 0;
+    for( size_t i = 0; i < anCandidates.size(); i++ )
+    {
+        OGRGeometry *poOther =
+            poJobIndex->apoFeatures[(size_t)anCandidates[i]]->GetGeometryRef();
+        int bIntersects;
+        if( poPrepared != NULL )
+            bIntersects = OGRPreparedGeometryIntersects( poPrepared, poOther );
+        else
+            bIntersects = poFilter->Intersects( poOther );
+        if( bIntersects )
+            anCandidates[nKept++] = anCandidates[i];
+    }
+    anCandidates.resize( nKept );
+
+    OGRDestroyPreparedGeometry( poPrepared );
+    delete poIntersection;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                         GetUnfilteredIndex()                         */
+/*                                                                      */
+/*      Index of all the features of the indexed layer, ignoring its   */
+/*      spatial filter, loaded on first use.  Only to be called by the  */
+/*      main thread.                                                    */
+/************************************************************************/
+
+OGROverlayIndex *OGROverlayEngine::GetUnfilteredIndex()
+{
+    if( poUnfilteredIndex == NULL )
+    {
+        poIndexedLayer->SetSpatialFilter( NULL );
+        poUnfilteredIndex = new OGROverlayIndex();
+        poUnfilteredIndex->Load( poIndexedLayer );
+        poIndexedLayer->SetSpatialFilter( poIndexFilter );
+    }
+    return poUnfilteredIndex;
+}
+
+/************************************************************************/
+/*                               NewJob()                               */
+/************************************************************************/
+
+OGROverlayJob *OGROverlayEngine::NewJob( OGRFeature *poFeature )
+{
+    OGROverlayJob *poJob = new OGROverlayJob();
+    poJob->poEngine = this;
+    poJob->poFeature = poFeature;
+    poJob->poIndex = poIndex;
+    return poJob;
+}
+
+/************************************************************************/
+/*                           ProcessFeature()                           */
+/*                                                                      */
+/*      Compute the parts of the result for a driving feature. This    */
+/*      only reads shared data, so that it can run in worker threads.  */
+/************************************************************************/
+
+void OGROverlayEngine::ProcessFeature( OGROverlayJob *poJob )
+{
+    OGRGeometry *x_geom = poJob->poFeature->GetGeometryRef();
+    OGROverlayIndex *poJobIndex = poJob->poIndex;
+    std::vector<GIntBig> anCandidates;
+
+    if( !GetCandidates( poJob, anCandidates ) )
+        return;
+
+    OGROverlayOperation eOp = eOperation;
+    if( bMethodDriven )
+        eOp = OGR_OVERLAY_SYMDIFFERENCE;
+
+    switch( eOp )
+    {
+      case OGR_OVERLAY_INTERSECTION:
+      case OGR_OVERLAY_UNION:
+      case OGR_OVERLAY_IDENTITY:
+      {
+        // the parts of x intersecting y, and with UNION and IDENTITY
+        // what remains of x
+        OGRGeometry *x_geom_diff = NULL;
+        if( eOp != OGR_OVERLAY_INTERSECTION )
+            x_geom_diff = x_geom->clone();
+
+        for( size_t i = 0; i < anCandidates.size(); i++ )
+        {
+            int iY = (int) anCandidates[i];
+            OGRGeometry *y_geom = poJobIndex->apoFeatures[iY]->GetGeometryRef();
+            OGRGeometry* poIntersection = x_geom->Intersection(y_geom);
+            if( poIntersection == NULL || poIntersection->IsEmpty() ||
+                (x_geom->getDimension() == 2 &&
+                y_geom->getDimension() == 2 &&
+                poIntersection->getDimension() < 2) )
+            {
+                delete poIntersection;
+                continue;
+            }
+            poJob->AddPart( poIntersection, iY );
+            if( eOp != OGR_OVERLAY_INTERSECTION )
+            {
+                OGRGeometry *x_geom_diff_new = x_geom_diff ? x_geom_diff->Difference(y_geom) : NULL;
+                delete x_geom_diff;
+                x_geom_diff = x_geom_diff_new;
+            }
+        }
+
+        if( eOp != OGR_OVERLAY_INTERSECTION )
+            poJob->AddPart( x_geom_diff, -1 );
+        break;
+      }
+
+      case OGR_OVERLAY_SYMDIFFERENCE:
+      case OGR_OVERLAY_UPDATE:
+      {
+        // x minus all the y
+        OGRGeometry *geom = x_geom->clone();
+        for( size_t i = 0; i < anCandidates.size(); i++ )
+        {
+            OGRGeometry *y_geom =
+                poJobIndex->apoFeatures[(size_t)anCandidates[i]]->GetGeometryRef();
+            OGRGeometry *geom_new = geom->Difference(y_geom);
+            delete geom;
+            geom = geom_new;
+            if (geom == NULL || geom->IsEmpty()) break;
+        }
+        poJob->AddPart( geom, -1 );
+        break;
+      }
+
+      case OGR_OVERLAY_CLIP:
+      case OGR_OVERLAY_ERASE:
+      {
+        // incrementally add area from y to geom
+        OGRGeometry *geom = NULL;
+        for( size_t i = 0; i < anCandidates.size(); i++ )
+        {
+            OGRGeometry *y_geom =
+                poJobIndex->apoFeatures[(size_t)anCandidates[i]]->GetGeometryRef();
+            if (!geom) {
+                geom = y_geom->clone();
+            } else {
+                OGRGeometry *geom_new = geom->Union(y_geom);
+                delete geom;
+                geom = geom_new;
+            }
+        }
+
+        // x intersection, or x minus, the sum of y
+        if (geom) {
+            if( eOp == OGR_OVERLAY_CLIP )
+                poJob->AddPart( x_geom->Intersection(geom), -1 );
+            else
+                poJob->AddPart( x_geom->Difference(geom), -1 );
+            delete geom;
+        }
+        break;
+      }
+    }
+}
+
+/************************************************************************/
+/*                          ProcessJobThread()                          */
+/************************************************************************/
+
+void OGROverlayEngine::ProcessJobThread( void *pData )
+{
+    OGROverlayJob *poJob = (OGROverlayJob *) pData;
+    poJob->poEngine->ProcessFeature( poJob );
+}
+
+/************************************************************************/
+/*                            WriteFeature()                            */
+/************************************************************************/
+
+OGRErr OGROverlayEngine::WriteFeature( OGRFeature *z )
+{
+    OGRErr ret = poLayerResult->CreateFeature(z);
+    delete z;
+    if (ret != OGRERR_NONE) {
+        if (!bSkipFailures)
+            return ret;
+        CPLErrorReset();
+    }
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                             WriteParts()                             */
+/*                                                                      */
+/*      Create the result features of a job, in the order the parts    */
+/*      were computed.                                                  */
+/************************************************************************/
+
+OGRErr OGROverlayEngine::WriteParts( OGROverlayJob *poJob )
+{
+    OGRErr ret = OGRERR_NONE;
+
+    for( size_t i = 0; i < poJob->asParts.size(); i++ )
+    {
+        OGRGeometry *poGeom = poJob->asParts[i].poGeom;
+        poJob->asParts[i].poGeom = NULL;
+        if( ret != OGRERR_NONE )
+        {
+            delete poGeom;
+            continue;
+        }
+
+        OGRFeature *z = new OGRFeature(poDefnResult);
+        if( bMethodDriven )
+            z->SetFieldsFrom(poJob->poFeature, mapMethod);
+        else
+        {
+            z->SetFieldsFrom(poJob->poFeature, mapInput);
+            if( poJob->asParts[i].iIndexed >= 0 )
+                z->SetFieldsFrom(
+                    poJob->poIndex->apoFeatures[poJob->asParts[i].iIndexed],
+                    mapMethod);
+        }
+        if( bPromoteToMulti )
+            poGeom = promote_to_multi(poGeom);
+        z->SetGeometryDirectly(poGeom);
+        ret = WriteFeature(z);
+    }
+    poJob->asParts.resize(0);
+
+    return ret;
+}
+
+/************************************************************************/
+/*                              RunJobs()                               */
+/*                                                                      */
+/*      Process a batch of driving features, on the worker threads if  */
+/*      any, and write their results in the order of the features.     */
+/************************************************************************/
+
+OGRErr OGROverlayEngine::RunJobs( std::vector<OGROverlayJob*>& apoJobs )
+{
+    OGRErr ret = OGRERR_NONE;
+
+    if( poPool != NULL && apoJobs.size() > 1 )
+    {
+        for( size_t i = 0; i < apoJobs.size(); i++ )
+            poPool->SubmitJob( ProcessJobThread, apoJobs[i] );
+        poPool->WaitCompletion();
+    }
+    else
+    {
+        for( size_t i = 0; i < apoJobs.size(); i++ )
+            ProcessFeature( apoJobs[i] );
+    }
+
+    for( size_t i = 0; i < apoJobs.size(); i++ )
+    {
+        if( apoJobs[i]->bNeedUnfilteredIndex )
+        {
+            apoJobs[i]->bNeedUnfilteredIndex = FALSE;
+            apoJobs[i]->poIndex = GetUnfilteredIndex();
+            ProcessFeature( apoJobs[i] );
+        }
+    }
+
+    for( size_t i = 0; i < apoJobs.size(); i++ )
+    {
+        if( ret == OGRERR_NONE )
+            ret = WriteParts( apoJobs[i] );
+        else
+        {
+            for( size_t j = 0; j < apoJobs[i]->asParts.size(); j++ )
+                delete apoJobs[i]->asParts[j].poGeom;
+        }
+        if( !bMethodDriven )
+            delete apoJobs[i]->poFeature;
+        delete apoJobs[i];
+    }
+    apoJobs.resize(0);
+
+    return ret;
+}
+
+/************************************************************************/
+/*                              RunPass()                               */
+/*                                                                      */
+/*      Overlay the features of the input layer with the ones of the   */
+/*      method layer, indexed in poIndexIn.                            */
+/************************************************************************/
+
+OGRErr OGROverlayEngine::RunPass( OGRLayer *poDriving, OGRLayer *poIndexed,
+                                  OGROverlayIndex *poIndexIn )
+{
+    OGRErr ret = OGRERR_NONE;
+    OGRGeometry *poFilter = poIndexed->GetSpatialFilter();
+    std::vector<OGROverlayJob*> apoJobs;
+    size_t nBatchSize = (size_t) MAX(1, nThreads) * FEATURES_PER_THREAD;
+
+    bMethodDriven = FALSE;
+    poIndexedLayer = poIndexed;
+    poIndex = poIndexIn;
+    poIndexFilter = poFilter ? poFilter->clone() : NULL;
+
+    poDriving->ResetReading();
+    while (OGRFeature *x = poDriving->GetNextFeature()) {
+
+        if (!Progress()) {
+            delete x;
+            ret = OGRERR_FAILURE;
+            break;
+        }
+
+        if (x->GetGeometryRef() == NULL) {
+            delete x;
+            continue;
+        }
+
+        apoJobs.push_back( NewJob( x ) );
+
+        if( apoJobs.size() == nBatchSize )
+        {
+            ret = RunJobs( apoJobs );
+            if( ret != OGRERR_NONE )
+                break;
+        }
+    }
+
+    if( ret == OGRERR_NONE )
+        ret = RunJobs( apoJobs );
+    else
+    {
+        for( size_t i = 0; i < apoJobs.size(); i++ )
+        {
+            delete apoJobs[i]->poFeature;
+            delete apoJobs[i];
+        }
+    }
+
+    delete poIndexFilter;
+    poIndexFilter = NULL;
+    delete poUnfilteredIndex;
+    poUnfilteredIndex = NULL;
+
+    return ret;
+}
+
+/************************************************************************/
+/*                           RunMethodPass()                            */
+/*                                                                      */
+/*      For UNION and SYMDIFFERENCE, add the parts of the features of  */
+/*      the method layer that are not covered by the input layer.      */
+/************************************************************************/
+
+OGRErr OGROverlayEngine::RunMethodPass( OGROverlayIndex *poMethodIndex )
+{
+    OGRErr ret = OGRERR_NONE;
+    OGROverlayIndex oInputIndex;
+    OGRGeometry *poFilter = poLayerInput->GetSpatialFilter();
+    std::vector<OGROverlayJob*> apoJobs;
+    size_t nBatchSize = (size_t) MAX(1, nThreads) * FEATURES_PER_THREAD;
+
+    oInputIndex.Load( poLayerInput );
+
+    bMethodDriven = TRUE;
+    poIndexedLayer = poLayerInput;
+    poIndex = &oInputIndex;
+    poIndexFilter = poFilter ? poFilter->clone() : NULL;
+
+    for( size_t i = 0; i < poMethodIndex->apoFeatures.size(); i++ )
+    {
+        if (!Progress()) {
+            ret = OGRERR_FAILURE;
+            break;
+        }
+
+        apoJobs.push_back( NewJob( poMethodIndex->apoFeatures[i] ) );
+
+        if( apoJobs.size() == nBatchSize )
+        {
+            ret = RunJobs( apoJobs );
+            if( ret != OGRERR_NONE )
+                break;
+        }
+    }
+
+    if( ret == OGRERR_NONE )
+        ret = RunJobs( apoJobs );
+    else
+    {
+        for( size_t i = 0; i < apoJobs.size(); i++ )
+            delete apoJobs[i];
+    }
+
+    delete poIndexFilter;
+    poIndexFilter = NULL;
+    delete poUnfilteredIndex;
+    poUnfilteredIndex = NULL;
+    poIndex = NULL;
+
+    return ret;
+}
+
+/************************************************************************/
+/*                         CopyMethodFeatures()                         */
+/*                                                                      */
+/*      For UPDATE, add the features of the method layer.              */
+/************************************************************************/
+
+OGRErr OGROverlayEngine::CopyMethodFeatures( OGROverlayIndex *poMethodIndex )
+{
+    for( size_t i = 0; i < poMethodIndex->apoFeatures.size(); i++ )
+    {
+        if (!Progress())
+            return OGRERR_FAILURE;
+
+        OGRFeature *y = poMethodIndex->apoFeatures[i];
+        OGRFeature *z = new OGRFeature(poDefnResult);
+        if (mapMethod) z->SetFieldsFrom(y, mapMethod);
+        z->SetGeometry(y->GetGeometryRef());
+        OGRErr ret = WriteFeature(z);
+        if (ret != OGRERR_NONE)
+            return ret;
+    }
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                                Run()                                 */
+/************************************************************************/
+
+OGRErr OGROverlayEngine::Run( char** papszOptions )
+{
+    OGRErr ret = OGRERR_NONE;
+    OGRFeatureDefn *poDefnInput = poLayerInput->GetLayerDefn();
+    OGRFeatureDefn *poDefnMethod = poLayerMethod->GetLayerDefn();
+    int bUseMethodFields = (eOperation != OGR_OVERLAY_CLIP &&
+                            eOperation != OGR_OVERLAY_ERASE);
+    int bCombined = (eOperation != OGR_OVERLAY_CLIP &&
+                     eOperation != OGR_OVERLAY_ERASE &&
+                     eOperation != OGR_OVERLAY_UPDATE);
+    int bMethodPass = (eOperation == OGR_OVERLAY_UNION ||
+                       eOperation == OGR_OVERLAY_SYMDIFFERENCE ||
+                       eOperation == OGR_OVERLAY_UPDATE);
+
+    // check for GEOS
+    if (!OGRGeometryFactory::haveGEOS()) {
+        return OGRERR_UNSUPPORTED_OPERATION;
+    }
+
+    // get resources
+    ret = create_field_map(poDefnInput, &mapInput);
+    if (ret != OGRERR_NONE) return ret;
+    if (bUseMethodFields) {
+        ret = create_field_map(poDefnMethod, &mapMethod);
+        if (ret != OGRERR_NONE) return ret;
+    }
+    ret = set_result_schema(poLayerResult, poDefnInput,
+                            bUseMethodFields ? poDefnMethod : NULL,
+                            mapInput, mapMethod, bCombined, papszOptions);
+    if (ret != OGRERR_NONE) return ret;
+    poDefnResult = poLayerResult->GetLayerDefn();
+
+    dfProgressMax = (double) poLayerInput->GetFeatureCount(0);
+    if (bMethodPass)
+        dfProgressMax += (double) poLayerMethod->GetFeatureCount(0);
+
+    if( nThreads > 1 )
+    {
+        poPool = new CPLWorkerThreadPool();
+        if( !poPool->Setup( nThreads ) )
+        {
+            delete poPool;
+            poPool = NULL;
+        }
+    }
+
+    // index the method layer once, and overlay the input layer with it
+    OGROverlayIndex oMethodIndex;
+    oMethodIndex.Load( poLayerMethod );
+
+    ret = RunPass( poLayerInput, poLayerMethod, &oMethodIndex );
+
+    if( ret == OGRERR_NONE && eOperation == OGR_OVERLAY_UPDATE )
+        ret = CopyMethodFeatures( &oMethodIndex );
+    else if( ret == OGRERR_NONE && bMethodPass )
+        ret = RunMethodPass( &oMethodIndex );
+
+    if (ret == OGRERR_NONE && pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
+      CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
+      ret = OGRERR_FAILURE;
+    }
+
+    return ret;
+}
+
+/************************************************************************/
+/*                          OGRLayerOverlay()                           */
+/*                                                                      */
+/*      The features of the method layer are read once and indexed     */
+/*      with an STR tree, instead of being read again with a spatial   */
+/*      filter for each input feature. The candidates of each input    */
+/*      feature are checked with a prepared geometry, and the input    */
+/*      features are processed by batches on worker threads, the       */
+/*      results being written in the order of the input features.      */
+/************************************************************************/
+
+OGRErr OGRLayerOverlay( OGRLayer *poLayerInput,
+                        OGRLayer *poLayerMethod,
+                        OGRLayer *poLayerResult,
+                        OGROverlayOperation eOperation,
+                        char** papszOptions,
+                        GDALProgressFunc pfnProgress,
+                        void * pProgressArg )
+{
+    OGROverlayEngine oEngine( poLayerInput, poLayerMethod, poLayerResult,
+                              eOperation, papszOptions,
+                              pfnProgress, pProgressArg );
+    return oEngine.Run( papszOptions );
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  OpenGIS Simple Features Reference Implementation
+ * Purpose:  Overlay operations between layers (intersection, union, ...),
+ *           driven by an in-memory spatial index and worker threads.
+ * Author:   GDAL project contributors
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef _OGR_OVERLAY_H_INCLUDED
+#define _OGR_OVERLAY_H_INCLUDED
+
+#include "ogrsf_frmts.h"
+
+typedef enum
+{
+    OGR_OVERLAY_INTERSECTION,
+    OGR_OVERLAY_UNION,
+    OGR_OVERLAY_SYMDIFFERENCE,
+    OGR_OVERLAY_IDENTITY,
+    OGR_OVERLAY_UPDATE,
+    OGR_OVERLAY_CLIP,
+    OGR_OVERLAY_ERASE
+} OGROverlayOperation;
+
+/* Implementation of OGRLayer::Intersection(), Union(), SymDifference(), */
+/* Identity(), Update(), Clip() and Erase() */
+OGRErr OGRLayerOverlay( OGRLayer *poLayerInput,
+                        OGRLayer *poLayerMethod,
+                        OGRLayer *poLayerResult,
+                        OGROverlayOperation eOperation,
+                        char** papszOptions,
+                        GDALProgressFunc pfnProgress,
+                        void * pProgressArg );
+
+#endif /* ndef _OGR_OVERLAY_H_INCLUDED */
@@ -66,6 +66,8 @@ class OGRLayerWithTransaction: public OGRLayerDecorator
     virtual OGRFeature *GetFeature( GIntBig nFID );
     virtual OGRErr      ISetFeature( OGRFeature *poFeature );
     virtual OGRErr      ICreateFeature( OGRFeature *poFeature );
+    virtual OGRErr      ICreateFeatures( OGRFeature **papoFeatures,
+                                         int nFeatureCount );
   
 };
 
@@ -609,3 +611,10 @@ OGRErr       OGRLayerWithTransaction::ICreateFeature( OGRFeature *poFeature )
     return eErr;
 }
 
+OGRErr       OGRLayerWithTransaction::ICreateFeatures( OGRFeature **papoFeatures,
+                                                      int nFeatureCount )
+{
+    /* Each feature must be translated to the decorated layer definition */
+    return OGRLayer::ICreateFeatures(papoFeatures, nFeatureCount);
+}
+
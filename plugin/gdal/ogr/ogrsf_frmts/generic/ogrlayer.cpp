@@ -34,6 +34,7 @@
 #include "ogr_attrind.h"
 #include "swq.h"
 #include "ograpispy.h"
+#include "ogr_overlay.h"
 
 CPL_CVSID("$Id: ogrlayer.cpp 28928 2015-04-17 10:24:19Z rouault $");
 
@@ -550,6 +551,177 @@ OGRFeatureH OGR_L_GetNextFeature( OGRLayerH hLayer )
     return (OGRFeatureH) ((OGRLayer *)hLayer)->GetNextFeature();
 }
 
+/************************************************************************/
+/*                         GetNextFeatureInto()                         */
+/************************************************************************/
+
+/**
+ * \brief Fetch the next available feature from this layer into an existing
+ * feature.
+ *
+ * This is the same as GetNextFeature(), except that the feature is read
+ * into a feature object owned by the caller, typically created once with
+ * the layer definition and passed again for each read. The feature is
+ * reset with OGRFeature::Reset() first, so that its field array and the
+ * buffers of its string fields are reused. Drivers having a native
+ * implementation fill the feature directly, which avoids the allocation of
+ * an OGRFeature object per feature in loops that only read features.
+ *
+ * The default implementation moves the content of the feature returned by
+ * GetNextFeature() into the passed feature.
+ *
+ * This method is the same as the C function OGR_L_GetNextFeatureInto().
+ *
+ * @param poFeature the feature to fill. It must have been created with the
+ * definition returned by GetLayerDefn().
+ *
+ * @return TRUE if a feature was read, FALSE at the end of the layer or in
+ * case of error.
+ *
+ * @since GDAL 2.0
+ */
+
+int OGRLayer::GetNextFeatureInto( OGRFeature *poFeature )
+
+{
+    OGRFeatureDefn *poDefn = GetLayerDefn();
+
+    if( poFeature->GetDefnRef() != poDefn )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "GetNextFeatureInto(): the feature does not use the "
+                  "definition of the layer" );
+        return FALSE;
+    }
+
+    OGRFeature *poNext = GetNextFeature();
+
+    poFeature->Reset();
+    if( poNext == NULL )
+        return FALSE;
+
+    poFeature->SetFID( poNext->GetFID() );
+    for( int i = 0; i < poDefn->GetFieldCount(); i++ )
+    {
+        if( poNext->IsFieldSet( i ) )
+            poFeature->SetField( i, poNext->GetRawFieldRef( i ) );
+    }
+    for( int i = 0; i < poDefn->GetGeomFieldCount(); i++ )
+    {
+        OGRLazyGeometry *poLazy = poNext->GetGeomFieldLazyRef( i );
+        if( poLazy != NULL )
+            poFeature->SetGeomFieldLazyDirectly( i, poLazy->clone() );
+        else
+            poFeature->SetGeomFieldDirectly( i, poNext->StealGeometry( i ) );
+    }
+    if( poNext->GetStyleString() != NULL )
+        poFeature->SetStyleString( poNext->GetStyleString() );
+
+    delete poNext;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                      OGR_L_GetNextFeatureInto()                      */
+/************************************************************************/
+
+/**
+ * \brief Fetch the next available feature from this layer into an existing
+ * feature.
+ *
+ * This function is the same as the C++ method
+ * OGRLayer::GetNextFeatureInto().
+ *
+ * @param hLayer handle to the layer from which feature are read.
+ * @param hFeat handle to the feature to fill, created with OGR_F_Create()
+ * from the definition of the layer.
+ *
+ * @return TRUE if a feature was read, FALSE at the end of the layer or in
+ * case of error.
+ *
+ * @since GDAL 2.0
+ */
+
+int OGR_L_GetNextFeatureInto( OGRLayerH hLayer, OGRFeatureH hFeat )
+
+{
+    VALIDATE_POINTER1( hLayer, "OGR_L_GetNextFeatureInto", FALSE );
+    VALIDATE_POINTER1( hFeat, "OGR_L_GetNextFeatureInto", FALSE );
+
+    return ((OGRLayer *)hLayer)->GetNextFeatureInto( (OGRFeature *) hFeat );
+}
+
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+/**
+ * \brief Fetch the next available features from this layer, column by column.
+ *
+ * The features that GetNextFeature() would return next are stored in
+ * the batch, which is reset first and switched to the layer definition.
+ * Reading one batch of features at a time avoids the creation of an
+ * OGRFeature object per feature by drivers having a native implementation.
+ *
+ * The default implementation fills the batch from GetNextFeature().
+ *
+ * This method is the same as the C function OGR_L_GetNextFeatureBatch().
+ *
+ * @param poBatch the batch to fill.
+ * @param nMaxFeatures maximum number of features to read.
+ *
+ * @return the number of features read, 0 at the end of the layer.
+ *
+ * @since GDAL 2.0
+ */
+
+int OGRLayer::GetNextFeatureBatch( OGRFeatureBatch *poBatch, int nMaxFeatures )
+
+{
+    OGRFeature *poFeature;
+
+    poBatch->Reset( GetLayerDefn() );
+    while( poBatch->GetFeatureCount() < nMaxFeatures &&
+           (poFeature = GetNextFeature()) != NULL )
+    {
+        poBatch->AddFeature( poFeature );
+        delete poFeature;
+    }
+
+    return poBatch->GetFeatureCount();
+}
+
+/************************************************************************/
+/*                     OGR_L_GetNextFeatureBatch()                      */
+/************************************************************************/
+
+/**
+ * \brief Fetch the next available features from this layer, column by column.
+ *
+ * This function is the same as the C++ method
+ * OGRLayer::GetNextFeatureBatch().
+ *
+ * @param hLayer handle to the layer from which features are read.
+ * @param hBatch handle to the batch to fill, created with OGR_FB_Create().
+ * @param nMaxFeatures maximum number of features to read.
+ *
+ * @return the number of features read, 0 at the end of the layer.
+ *
+ * @since GDAL 2.0
+ */
+
+int OGR_L_GetNextFeatureBatch( OGRLayerH hLayer, OGRFeatureBatchH hBatch,
+                               int nMaxFeatures )
+
+{
+    VALIDATE_POINTER1( hLayer, "OGR_L_GetNextFeatureBatch", 0 );
+    VALIDATE_POINTER1( hBatch, "OGR_L_GetNextFeatureBatch", 0 );
+
+    return ((OGRLayer *)hLayer)->GetNextFeatureBatch(
+                                (OGRFeatureBatch *) hBatch, nMaxFeatures );
+}
+
 /************************************************************************/
 /*                    ConvertNonLinearGeomsIfNecessary()                */
 /************************************************************************/
@@ -561,6 +733,9 @@ void OGRLayer::ConvertNonLinearGeomsIfNecessary( OGRFeature *poFeature )
         int nGeomFieldCount = GetLayerDefn()->GetGeomFieldCount();
         for(int i=0;i<nGeomFieldCount;i++)
         {
+            /* Lazy geometries are always linear: do not parse them */
+            if( poFeature->GetGeomFieldLazyRef(i) != NULL )
+                continue;
             OGRGeometry* poGeom = poFeature->GetGeomFieldRef(i);
             if( poGeom != NULL && OGR_GT_IsNonLinear(poGeom->getGeometryType()) )
             {
@@ -650,6 +825,221 @@ OGRErr OGR_L_CreateFeature( OGRLayerH hLayer, OGRFeatureH hFeat )
     return ((OGRLayer *) hLayer)->CreateFeature( (OGRFeature *) hFeat );
 }
 
+/************************************************************************/
+/*                       OGRLayerEstimateFeatureSize()                  */
+/*                                                                      */
+/*      Approximate number of bytes a driver will have to write for     */
+/*      the feature, used to size the transactions of CreateFeatures(). */
+/************************************************************************/
+
+static GIntBig OGRLayerEstimateFeatureSize( OGRFeature *poFeature )
+
+{
+    OGRFeatureDefn *poDefn = poFeature->GetDefnRef();
+    GIntBig nSize = 8;
+
+    for( int iField = 0; iField < poDefn->GetFieldCount(); iField++ )
+    {
+        if( !poFeature->IsFieldSet( iField ) )
+            continue;
+
+        OGRField *psField = poFeature->GetRawFieldRef( iField );
+        switch( poDefn->GetFieldDefn( iField )->GetType() )
+        {
+            case OFTString:
+                nSize += strlen( psField->String );
+                break;
+            case OFTBinary:
+                nSize += psField->Binary.nCount;
+                break;
+            case OFTIntegerList:
+                nSize += 4 * (GIntBig) psField->IntegerList.nCount;
+                break;
+            case OFTInteger64List:
+                nSize += 8 * (GIntBig) psField->Integer64List.nCount;
+                break;
+            case OFTRealList:
+                nSize += 8 * (GIntBig) psField->RealList.nCount;
+                break;
+            case OFTStringList:
+                for( int i = 0; i < psField->StringList.nCount; i++ )
+                    nSize += strlen( psField->StringList.paList[i] ) + 1;
+                break;
+            default:
+                nSize += 8;
+                break;
+        }
+    }
+
+    for( int iGeom = 0; iGeom < poDefn->GetGeomFieldCount(); iGeom++ )
+    {
+        OGRLazyGeometry *poLazy = poFeature->GetGeomFieldLazyRef( iGeom );
+        if( poLazy != NULL )
+        {
+            nSize += poLazy->WkbSize();
+            continue;
+        }
+
+        OGRGeometry *poGeom = poFeature->GetGeomFieldRef( iGeom );
+        if( poGeom != NULL )
+            nSize += poGeom->WkbSize();
+    }
+
+    return nSize;
+}
+
+/************************************************************************/
+/*                           CreateFeatures()                           */
+/************************************************************************/
+
+/**
+ * \brief Create and write new features within a layer.
+ *
+ * This is the same as calling CreateFeature() on each feature of the array,
+ * but lets the driver write several features at once: the GeoPackage driver
+ * inserts them with multi-row INSERT statements, and the PostgreSQL driver
+ * uses COPY even when PG_USE_COPY is not set (in which case the FID of the
+ * features is not set back). Other drivers write the features one by one.
+ *
+ * When the layer supports transactions and no transaction is active, the
+ * features are written by chunks, each one in its own transaction. A chunk
+ * ends when it holds OGR_BULK_INSERT_MAX_ROWS features (20000 by default)
+ * or when the estimated size of its features exceeds OGR_BULK_INSERT_MAX_BYTES
+ * (64 MB by default), so that the caller does not have to manage the
+ * transactions itself nor to guess their size. Within a transaction started
+ * by the caller, the features are written in that transaction.
+ *
+ * Writing stops at the first failure. The features of the failing chunk are
+ * then rolled back if the method started the transaction, but those of the
+ * previous chunks remain written.
+ *
+ * This method is the same as the C function OGR_L_CreateFeatures().
+ *
+ * @param papoFeatures the features to write to disk.
+ * @param nFeatureCount number of features in the array.
+ *
+ * @return OGRERR_NONE on success.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRErr OGRLayer::CreateFeatures( OGRFeature **papoFeatures, int nFeatureCount )
+
+{
+    if( nFeatureCount <= 0 )
+        return OGRERR_NONE;
+
+    for( int i = 0; i < nFeatureCount; i++ )
+        ConvertNonLinearGeomsIfNecessary( papoFeatures[i] );
+
+    if( !TestCapability( OLCTransactions ) )
+        return ICreateFeatures( papoFeatures, nFeatureCount );
+
+    int nMaxRows = atoi(CPLGetConfigOption("OGR_BULK_INSERT_MAX_ROWS",
+                                           "20000"));
+    if( nMaxRows <= 0 )
+        nMaxRows = INT_MAX;
+    GIntBig nMaxBytes = CPLAtoGIntBig(
+        CPLGetConfigOption("OGR_BULK_INSERT_MAX_BYTES", "67108864"));
+    if( nMaxBytes <= 0 )
+        nMaxBytes = GINTBIG_MAX;
+
+    int iStart = 0;
+    while( iStart < nFeatureCount )
+    {
+/* -------------------------------------------------------------------- */
+/*      Collect the features of the chunk.                              */
+/* -------------------------------------------------------------------- */
+        int nChunk = 0;
+        GIntBig nBytes = 0;
+        while( iStart + nChunk < nFeatureCount && nChunk < nMaxRows &&
+               (nChunk == 0 || nBytes < nMaxBytes) )
+        {
+            nBytes += OGRLayerEstimateFeatureSize( papoFeatures[iStart + nChunk] );
+            nChunk++;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Write it in its own transaction, unless the caller has          */
+/*      already started one.                                            */
+/* -------------------------------------------------------------------- */
+        /* Do not let the error of that probe replace a pending one */
+        CPLErr eLastErrType = CPLGetLastErrorType();
+        int nLastErrNo = CPLGetLastErrorNo();
+        CPLString osLastErrMsg = CPLGetLastErrorMsg();
+        CPLPushErrorHandler( CPLQuietErrorHandler );
+        int bOwnTransaction = (StartTransaction() == OGRERR_NONE);
+        CPLPopErrorHandler();
+        CPLErrorSetState( eLastErrType, nLastErrNo, osLastErrMsg );
+
+        OGRErr eErr = ICreateFeatures( papoFeatures + iStart, nChunk );
+
+        if( bOwnTransaction )
+        {
+            if( eErr == OGRERR_NONE )
+                eErr = CommitTransaction();
+            else
+                RollbackTransaction();
+        }
+        if( eErr != OGRERR_NONE )
+            return eErr;
+
+        iStart += nChunk;
+    }
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                          ICreateFeatures()                           */
+/*                                                                      */
+/*      Default implementation, writing the features one by one.       */
+/************************************************************************/
+
+OGRErr OGRLayer::ICreateFeatures( OGRFeature **papoFeatures, int nFeatureCount )
+
+{
+    for( int i = 0; i < nFeatureCount; i++ )
+    {
+        OGRErr eErr = ICreateFeature( papoFeatures[i] );
+        if( eErr != OGRERR_NONE )
+            return eErr;
+    }
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                        OGR_L_CreateFeatures()                        */
+/************************************************************************/
+
+/**
+ * \brief Create and write new features within a layer.
+ *
+ * This function is the same as the C++ method OGRLayer::CreateFeatures().
+ *
+ * @param hLayer handle to the layer to write the features to.
+ * @param pahFeatures handles of the features to write to disk.
+ * @param nFeatureCount number of features in the array.
+ *
+ * @return OGRERR_NONE on success.
+ *
+ * @since GDAL 2.0
+ */
+
+OGRErr OGR_L_CreateFeatures( OGRLayerH hLayer, OGRFeatureH *pahFeatures,
+                             int nFeatureCount )
+
+{
+    VALIDATE_POINTER1( hLayer, "OGR_L_CreateFeatures", OGRERR_INVALID_HANDLE );
+    if( nFeatureCount > 0 )
+        VALIDATE_POINTER1( pahFeatures, "OGR_L_CreateFeatures",
+                           OGRERR_INVALID_HANDLE );
+
+    return ((OGRLayer *) hLayer)->CreateFeatures( (OGRFeature **) pahFeatures,
+                                                  nFeatureCount );
+}
+
 /************************************************************************/
 /*                            CreateField()                             */
 /************************************************************************/
@@ -1834,128 +2224,6 @@ OGRErr OGR_L_SetIgnoredFields( OGRLayerH hLayer, const char **papszFields )
     return ((OGRLayer *) hLayer)->SetIgnoredFields( papszFields );
 }
 
-/************************************************************************/
-/*         helper functions for layer overlay methods                   */
-/************************************************************************/
-
-static
-OGRErr clone_spatial_filter(OGRLayer *pLayer, OGRGeometry **ppGeometry)
-{
-    OGRErr ret = OGRERR_NONE;
-    OGRGeometry *g = pLayer->GetSpatialFilter();
-    *ppGeometry = g ? g->clone() : NULL;
-    return ret;
-}
-
-static
-OGRErr create_field_map(OGRFeatureDefn *poDefn, int **map)
-{
-    OGRErr ret = OGRERR_NONE;
-    int n = poDefn->GetFieldCount();
-    if (n > 0) {
-        *map = (int*)VSIMalloc(sizeof(int) * n);
-        if (!(*map)) return OGRERR_NOT_ENOUGH_MEMORY;
-        for(int i=0;i<n;i++)
-            (*map)[i] = -1;
-    }
-    return ret;
-}
-
-static
-OGRErr set_result_schema(OGRLayer *pLayerResult,
-                         OGRFeatureDefn *poDefnInput, 
-                         OGRFeatureDefn *poDefnMethod,
-                         int *mapInput,
-                         int *mapMethod,
-                         int combined,
-                         char** papszOptions)
-{
-    OGRErr ret = OGRERR_NONE;
-    OGRFeatureDefn *poDefnResult = pLayerResult->GetLayerDefn();
-    const char* pszInputPrefix = CSLFetchNameValue(papszOptions, "INPUT_PREFIX");
-    const char* pszMethodPrefix = CSLFetchNameValue(papszOptions, "METHOD_PREFIX");
-    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
-    if (poDefnResult->GetFieldCount() > 0) {
-        // the user has defined the schema of the output layer
-        for( int iField = 0; iField < poDefnInput->GetFieldCount(); iField++ ) {
-            CPLString osName(poDefnInput->GetFieldDefn(iField)->GetNameRef());
-            if( pszInputPrefix != NULL )
-                osName = pszInputPrefix + osName;
-            mapInput[iField] = poDefnResult->GetFieldIndex(osName);
-        }
-        if (!mapMethod) return ret;
-        for( int iField = 0; iField < poDefnMethod->GetFieldCount(); iField++ ) {
-            CPLString osName(poDefnMethod->GetFieldDefn(iField)->GetNameRef());
-            if( pszMethodPrefix != NULL )
-                osName = pszMethodPrefix + osName;
-            mapMethod[iField] = poDefnResult->GetFieldIndex(osName);
-        }
-    } else {
-        // use schema from the input layer or from input and method layers
-        int nFieldsInput = poDefnInput->GetFieldCount();
-        for( int iField = 0; iField < nFieldsInput; iField++ ) {
-            OGRFieldDefn oFieldDefn(poDefnInput->GetFieldDefn(iField));
-            if( pszInputPrefix != NULL )
-                oFieldDefn.SetName(CPLSPrintf("%s%s", pszInputPrefix, oFieldDefn.GetNameRef()));
-            ret = pLayerResult->CreateField(&oFieldDefn);
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) 
-                    return ret;
-                else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-            mapInput[iField] = iField;
-        }
-        if (!combined) return ret;
-        if (!mapMethod) return ret;
-        for( int iField = 0; iField < poDefnMethod->GetFieldCount(); iField++ ) {
-            OGRFieldDefn oFieldDefn(poDefnMethod->GetFieldDefn(iField));
-            if( pszMethodPrefix != NULL )
-                oFieldDefn.SetName(CPLSPrintf("%s%s", pszMethodPrefix, oFieldDefn.GetNameRef()));
-            ret = pLayerResult->CreateField(&oFieldDefn);
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) 
-                    return ret;
-                else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-            mapMethod[iField] = nFieldsInput+iField;
-        }
-    }
-    return ret;
-}
-
-static
-OGRGeometry *set_filter_from(OGRLayer *pLayer, OGRGeometry *pGeometryExistingFilter, OGRFeature *pFeature)
-{
-    OGRGeometry *geom = pFeature->GetGeometryRef();
-    if (!geom) return NULL;
-    if (pGeometryExistingFilter) {
-        if (!geom->Intersects(pGeometryExistingFilter)) return NULL;
-        OGRGeometry *intersection = geom->Intersection(pGeometryExistingFilter);
-        pLayer->SetSpatialFilter(intersection);
-        if (intersection) delete intersection;
-    } else {
-        pLayer->SetSpatialFilter(geom);
-    }
-    return geom;
-}
-
-static OGRGeometry* promote_to_multi(OGRGeometry* poGeom)
-{
-    OGRwkbGeometryType eType = wkbFlatten(poGeom->getGeometryType());
-    if( eType == wkbPolygon )
-        return OGRGeometryFactory::forceToMultiPolygon(poGeom);
-    else if( eType == wkbLineString )
-        return OGRGeometryFactory::forceToMultiLineString(poGeom);
-    else
-        return poGeom;
-}
-
 /************************************************************************/
 /*                          Intersection()                              */
 /************************************************************************/
@@ -1974,8 +2242,13 @@ static OGRGeometry* promote_to_multi(OGRGeometry* poGeom)
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, this method and the other overlay methods
+ * (Union(), SymDifference(), Identity(), Update(), Clip() and Erase())
+ * load the features of the method layer in memory and index them
+ * spatially once. Union() and SymDifference() do the same with the
+ * features of the input layer. The features of the input layer are
+ * then processed on GDAL_NUM_THREADS threads (1 by default, ALL_CPUS
+ * to use all the CPUs).
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2019,132 +2292,12 @@ OGRErr OGRLayer::Intersection( OGRLayer *pLayerMethod,
                                GDALProgressFunc pfnProgress, 
                                void * pProgressArg )
 {
-    OGRErr ret = OGRERR_NONE;
-    OGRFeatureDefn *poDefnInput = GetLayerDefn();
-    OGRFeatureDefn *poDefnMethod = pLayerMethod->GetLayerDefn();
-    OGRFeatureDefn *poDefnResult = NULL;
-    OGRGeometry *pGeometryMethodFilter = NULL;
-    int *mapInput = NULL;
-    int *mapMethod = NULL;
-    OGREnvelope sEnvelopeMethod;
-    GBool bEnvelopeSet;
-    double progress_max = (double) GetFeatureCount(0);
-    double progress_counter = 0;
-    double progress_ticker = 0;
-    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
-    int bPromoteToMulti = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
-
-    // check for GEOS
-    if (!OGRGeometryFactory::haveGEOS()) {
-        return OGRERR_UNSUPPORTED_OPERATION;
-    }
-
-    // get resources
-    ret = clone_spatial_filter(pLayerMethod, &pGeometryMethodFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnInput, &mapInput);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnMethod, &mapMethod);
-    if (ret != OGRERR_NONE) goto done;
-    ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, 1, papszOptions);
-    if (ret != OGRERR_NONE) goto done;
-    poDefnResult = pLayerResult->GetLayerDefn();
-    bEnvelopeSet = pLayerMethod->GetExtent(&sEnvelopeMethod, 1) == OGRERR_NONE;
-
-    ResetReading();
-    while (OGRFeature *x = GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // is it worth to proceed?
-        if (bEnvelopeSet) {
-            OGRGeometry *x_geom = x->GetGeometryRef();
-            if (x_geom) {
-                OGREnvelope x_env;
-                x_geom->getEnvelope(&x_env);
-                if (x_env.MaxX < sEnvelopeMethod.MinX 
-                    || x_env.MaxY < sEnvelopeMethod.MinY
-                    || sEnvelopeMethod.MaxX < x_env.MinX
-                    || sEnvelopeMethod.MaxY < x_env.MinY) {
-                    delete x;
-                    continue;
-                }
-            } else {
-                delete x;
-                continue;
-            }
-        }
-
-        // set up the filter for method layer
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x);
-        if (!x_geom) {
-            delete x;
-            continue;
-        }
-
-        pLayerMethod->ResetReading();
-        while (OGRFeature *y = pLayerMethod->GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            OGRGeometry* poIntersection = x_geom->Intersection(y_geom);
-            if( poIntersection == NULL || poIntersection->IsEmpty() ||
-                (x_geom->getDimension() == 2 &&
-                y_geom->getDimension() == 2 &&
-                poIntersection->getDimension() < 2) )
-            {
-                delete poIntersection;
-                delete y;
-            }
-            else
-            {
-                OGRFeature *z = new OGRFeature(poDefnResult);
-                z->SetFieldsFrom(x, mapInput);
-                z->SetFieldsFrom(y, mapMethod);
-                if( bPromoteToMulti )
-                    poIntersection = promote_to_multi(poIntersection);
-                z->SetGeometryDirectly(poIntersection);
-                delete y;
-                ret = pLayerResult->CreateFeature(z);
-                delete z;
-                if (ret != OGRERR_NONE) {
-                    if (!bSkipFailures) {
-                        delete x; 
-                        goto done;
-                    } else {
-                        CPLErrorReset();
-                        ret = OGRERR_NONE;
-                    }
-                }
-            }
-        }
-
-        delete x;
-    }
-    if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
-      CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-      ret = OGRERR_FAILURE;
-      goto done;
-    }
-done:
-    // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    if (pGeometryMethodFilter) delete pGeometryMethodFilter;
-    if (mapInput) VSIFree(mapInput);
-    if (mapMethod) VSIFree(mapMethod);
-    return ret;
+    return OGRLayerOverlay( this, pLayerMethod, pLayerResult,
+                            OGR_OVERLAY_INTERSECTION, papszOptions,
+                            pfnProgress, pProgressArg );
 }
 
+
 /************************************************************************/
 /*                       OGR_L_Intersection()                           */
 /************************************************************************/
@@ -2163,8 +2316,8 @@ done:
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see OGRLayer::Intersection() for how the
+ * features are indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2240,8 +2393,8 @@ OGRErr OGR_L_Intersection( OGRLayerH pLayerInput,
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see Intersection() for how the features are
+ * indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2285,207 +2438,12 @@ OGRErr OGRLayer::Union( OGRLayer *pLayerMethod,
                         GDALProgressFunc pfnProgress, 
                         void * pProgressArg )
 {
-    OGRErr ret = OGRERR_NONE;
-    OGRFeatureDefn *poDefnInput = GetLayerDefn();
-    OGRFeatureDefn *poDefnMethod = pLayerMethod->GetLayerDefn();
-    OGRFeatureDefn *poDefnResult = NULL;
-    OGRGeometry *pGeometryMethodFilter = NULL;
-    OGRGeometry *pGeometryInputFilter = NULL;
-    int *mapInput = NULL;
-    int *mapMethod = NULL;
-    double progress_max = (double) GetFeatureCount(0) + (double) pLayerMethod->GetFeatureCount(0);
-    double progress_counter = 0;
-    double progress_ticker = 0;
-    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
-    int bPromoteToMulti = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
-
-    // check for GEOS
-    if (!OGRGeometryFactory::haveGEOS()) {
-        return OGRERR_UNSUPPORTED_OPERATION;
-    }
-
-    // get resources
-    ret = clone_spatial_filter(this, &pGeometryInputFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = clone_spatial_filter(pLayerMethod, &pGeometryMethodFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnInput, &mapInput);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnMethod, &mapMethod);
-    if (ret != OGRERR_NONE) goto done;
-    ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, 1, papszOptions);
-    if (ret != OGRERR_NONE) goto done;
-    poDefnResult = pLayerResult->GetLayerDefn();
-
-    // add features based on input layer
-    ResetReading();
-    while (OGRFeature *x = GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x);
-        if (!x_geom) {
-            delete x; 
-            continue;
-        }
-        
-        OGRGeometry *x_geom_diff = x_geom->clone(); // this will be the geometry of the result feature
-        pLayerMethod->ResetReading();
-        while (OGRFeature *y = pLayerMethod->GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            OGRGeometry *poIntersection = x_geom->Intersection(y_geom);
-            if( poIntersection == NULL || poIntersection->IsEmpty() ||
-                (x_geom->getDimension() == 2 &&
-                y_geom->getDimension() == 2 &&
-                poIntersection->getDimension() < 2) )
-            {
-                delete poIntersection;
-                delete y;
-            }
-            else
-            {
-                OGRFeature *z = new OGRFeature(poDefnResult);
-                z->SetFieldsFrom(x, mapInput);
-                z->SetFieldsFrom(y, mapMethod);
-                if( bPromoteToMulti )
-                    poIntersection = promote_to_multi(poIntersection);
-                z->SetGeometryDirectly(poIntersection);
-                OGRGeometry *x_geom_diff_new = x_geom_diff ? x_geom_diff->Difference(y_geom) : NULL;
-                if (x_geom_diff) delete x_geom_diff;
-                x_geom_diff = x_geom_diff_new;
-                delete y;
-                ret = pLayerResult->CreateFeature(z);
-                delete z;
-                if (ret != OGRERR_NONE) {
-                    if (!bSkipFailures) {
-                        delete x;
-                        if (x_geom_diff)
-                            delete x_geom_diff;
-                        goto done;
-                    } else {
-                        CPLErrorReset();
-                        ret = OGRERR_NONE;
-                    }
-                }
-            }
-        }
-
-        if( x_geom_diff == NULL || x_geom_diff->IsEmpty() )
-        {
-            delete x_geom_diff;
-            delete x;
-        }
-        else
-        {
-            OGRFeature *z = new OGRFeature(poDefnResult);
-            z->SetFieldsFrom(x, mapInput);
-            if( bPromoteToMulti )
-                x_geom_diff = promote_to_multi(x_geom_diff);
-            z->SetGeometryDirectly(x_geom_diff);
-            delete x;
-            ret = pLayerResult->CreateFeature(z);
-            delete z;
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-
-    // restore filter on method layer and add features based on it
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    pLayerMethod->ResetReading();
-    while (OGRFeature *x = pLayerMethod->GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on input layer
-        OGRGeometry *x_geom = set_filter_from(this, pGeometryInputFilter, x);
-        if (!x_geom) {
-            delete x; 
-            continue;
-        }
-        
-        OGRGeometry *x_geom_diff = x_geom->clone(); // this will be the geometry of the result feature
-        ResetReading();
-        while (OGRFeature *y = GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            OGRGeometry *x_geom_diff_new = x_geom_diff ? x_geom_diff->Difference(y_geom) : NULL;
-            if (x_geom_diff) delete x_geom_diff;
-            x_geom_diff = x_geom_diff_new;
-            delete y;
-        }
-
-        if( x_geom_diff == NULL || x_geom_diff->IsEmpty() )
-        {
-            delete x_geom_diff;
-            delete x;
-        }
-        else
-        {
-            OGRFeature *z = new OGRFeature(poDefnResult);
-            z->SetFieldsFrom(x, mapMethod);
-            if( bPromoteToMulti )
-                x_geom_diff = promote_to_multi(x_geom_diff);
-            z->SetGeometryDirectly(x_geom_diff);
-            delete x;
-            ret = pLayerResult->CreateFeature(z);
-            delete z;
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-    if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
-      CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-      ret = OGRERR_FAILURE;
-      goto done;
-    }
-done:
-    // release resources
-    SetSpatialFilter(pGeometryInputFilter);
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    if (pGeometryMethodFilter) delete pGeometryMethodFilter;
-    if (pGeometryInputFilter) delete pGeometryInputFilter;
-    if (mapInput) VSIFree(mapInput);
-    if (mapMethod) VSIFree(mapMethod);
-    return ret;
+    return OGRLayerOverlay( this, pLayerMethod, pLayerResult,
+                            OGR_OVERLAY_UNION, papszOptions,
+                            pfnProgress, pProgressArg );
 }
 
+
 /************************************************************************/
 /*                           OGR_L_Union()                              */
 /************************************************************************/
@@ -2507,8 +2465,8 @@ done:
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see OGRLayer::Intersection() for how the
+ * features are indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2584,8 +2542,8 @@ OGRErr OGR_L_Union( OGRLayerH pLayerInput,
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see Intersection() for how the features are
+ * indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2629,176 +2587,12 @@ OGRErr OGRLayer::SymDifference( OGRLayer *pLayerMethod,
                                 GDALProgressFunc pfnProgress, 
                                 void * pProgressArg )
 {
-    OGRErr ret = OGRERR_NONE;
-    OGRFeatureDefn *poDefnInput = GetLayerDefn();
-    OGRFeatureDefn *poDefnMethod = pLayerMethod->GetLayerDefn();
-    OGRFeatureDefn *poDefnResult = NULL;
-    OGRGeometry *pGeometryMethodFilter = NULL;
-    OGRGeometry *pGeometryInputFilter = NULL;
-    int *mapInput = NULL;
-    int *mapMethod = NULL;
-    double progress_max = (double) GetFeatureCount(0) + (double) pLayerMethod->GetFeatureCount(0);
-    double progress_counter = 0;
-    double progress_ticker = 0;
-    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
-    int bPromoteToMulti = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
-
-    // check for GEOS
-    if (!OGRGeometryFactory::haveGEOS()) {
-        return OGRERR_UNSUPPORTED_OPERATION;
-    }
-
-    // get resources
-    ret = clone_spatial_filter(this, &pGeometryInputFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = clone_spatial_filter(pLayerMethod, &pGeometryMethodFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnInput, &mapInput);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnMethod, &mapMethod);
-    if (ret != OGRERR_NONE) goto done;
-    ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, 1, papszOptions);
-    if (ret != OGRERR_NONE) goto done;
-    poDefnResult = pLayerResult->GetLayerDefn();
-
-    // add features based on input layer
-    ResetReading();
-    while (OGRFeature *x = GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x);
-        if (!x_geom) {
-            delete x; 
-            continue;
-        }
-        
-        OGRGeometry *geom = x_geom->clone(); // this will be the geometry of the result feature
-        pLayerMethod->ResetReading();
-        while (OGRFeature *y = pLayerMethod->GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            OGRGeometry *geom_new = geom ? geom->Difference(y_geom) : NULL;
-            if (geom) delete geom;
-            geom = geom_new;
-            delete y;
-            if (geom && geom->IsEmpty()) break;
-        }
-
-        OGRFeature *z = NULL;
-        if (geom && !geom->IsEmpty()) {
-            z = new OGRFeature(poDefnResult);
-            z->SetFieldsFrom(x, mapInput);
-            if( bPromoteToMulti )
-                geom = promote_to_multi(geom);
-            z->SetGeometryDirectly(geom);
-        } else {
-            if (geom) delete geom;
-        }
-        delete x;
-        if (z) {
-            ret = pLayerResult->CreateFeature(z);
-            delete z;
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-
-    // restore filter on method layer and add features based on it
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    pLayerMethod->ResetReading();
-    while (OGRFeature *x = pLayerMethod->GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on input layer
-        OGRGeometry *x_geom = set_filter_from(this, pGeometryInputFilter, x);
-        if (!x_geom) {
-            delete x; 
-            continue;
-        }
-        
-        OGRGeometry *geom = x_geom->clone(); // this will be the geometry of the result feature
-        ResetReading();
-        while (OGRFeature *y = GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            OGRGeometry *geom_new = geom ? geom->Difference(y_geom) : NULL;
-            if (geom) delete geom;
-            geom = geom_new;
-            delete y;
-            if (geom == NULL || geom->IsEmpty()) break;
-        }
-
-        OGRFeature *z = NULL;
-        if (geom && !geom->IsEmpty()) {
-            z = new OGRFeature(poDefnResult);
-            z->SetFieldsFrom(x, mapMethod);
-            if( bPromoteToMulti )
-                geom = promote_to_multi(geom);
-            z->SetGeometryDirectly(geom);
-        } else {
-            if (geom) delete geom;
-        }
-        delete x;
-        if (z) {
-            ret = pLayerResult->CreateFeature(z);
-            delete z;
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-    if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
-      CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-      ret = OGRERR_FAILURE;
-      goto done;
-    }
-done:
-    // release resources
-    SetSpatialFilter(pGeometryInputFilter);
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    if (pGeometryMethodFilter) delete pGeometryMethodFilter;
-    if (pGeometryInputFilter) delete pGeometryInputFilter;
-    if (mapInput) VSIFree(mapInput);
-    if (mapMethod) VSIFree(mapMethod);
-    return ret;
+    return OGRLayerOverlay( this, pLayerMethod, pLayerResult,
+                            OGR_OVERLAY_SYMDIFFERENCE, papszOptions,
+                            pfnProgress, pProgressArg );
 }
 
+
 /************************************************************************/
 /*                        OGR_L_SymDifference()                         */
 /************************************************************************/
@@ -2820,8 +2614,8 @@ done:
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see OGRLayer::Intersection() for how the
+ * features are indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2895,8 +2689,8 @@ OGRErr OGR_L_SymDifference( OGRLayerH pLayerInput,
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see Intersection() for how the features are
+ * indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -2940,139 +2734,12 @@ OGRErr OGRLayer::Identity( OGRLayer *pLayerMethod,
                            GDALProgressFunc pfnProgress, 
                            void * pProgressArg )
 {
-    OGRErr ret = OGRERR_NONE;
-    OGRFeatureDefn *poDefnInput = GetLayerDefn();
-    OGRFeatureDefn *poDefnMethod = pLayerMethod->GetLayerDefn();
-    OGRFeatureDefn *poDefnResult = NULL;
-    OGRGeometry *pGeometryMethodFilter = NULL;
-    int *mapInput = NULL;
-    int *mapMethod = NULL;
-    double progress_max = (double) GetFeatureCount(0);
-    double progress_counter = 0;
-    double progress_ticker = 0;
-    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
-    int bPromoteToMulti = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
-
-    // check for GEOS
-    if (!OGRGeometryFactory::haveGEOS()) {
-        return OGRERR_UNSUPPORTED_OPERATION;
-    }
-
-    // get resources
-    ret = clone_spatial_filter(pLayerMethod, &pGeometryMethodFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnInput, &mapInput);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnMethod, &mapMethod);
-    if (ret != OGRERR_NONE) goto done;
-    ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, 1, papszOptions);
-    if (ret != OGRERR_NONE) goto done;
-    poDefnResult = pLayerResult->GetLayerDefn();
-
-    // split the features in input layer to the result layer
-    ResetReading();
-    while (OGRFeature *x = GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x);
-        if (!x_geom) {
-            delete x; 
-            continue;
-        }
-        
-        OGRGeometry *x_geom_diff = x_geom->clone(); // this will be the geometry of the result feature
-        pLayerMethod->ResetReading();
-        while (OGRFeature *y = pLayerMethod->GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            OGRGeometry* poIntersection = x_geom->Intersection(y_geom);
-            if( poIntersection == NULL || poIntersection->IsEmpty() ||
-                (x_geom->getDimension() == 2 &&
-                y_geom->getDimension() == 2 &&
-                poIntersection->getDimension() < 2) )
-            {
-                delete poIntersection;
-                delete y;
-            }
-            else
-            {
-                OGRFeature *z = new OGRFeature(poDefnResult);
-                z->SetFieldsFrom(x, mapInput);
-                z->SetFieldsFrom(y, mapMethod);
-                if( bPromoteToMulti )
-                    poIntersection = promote_to_multi(poIntersection);
-                z->SetGeometryDirectly(poIntersection);
-                OGRGeometry *x_geom_diff_new = x_geom_diff ? x_geom_diff->Difference(y_geom) : NULL;
-                if (x_geom_diff) delete x_geom_diff;
-                x_geom_diff = x_geom_diff_new;
-                delete y;
-                ret = pLayerResult->CreateFeature(z);
-                delete z;
-                if (ret != OGRERR_NONE) {
-                    if (!bSkipFailures) {
-                        delete x;
-                        delete x_geom_diff;
-                        goto done;
-                    } else {
-                        CPLErrorReset();
-                        ret = OGRERR_NONE;
-                    }
-                }
-            }
-        }
-
-        if( x_geom_diff == NULL || x_geom_diff->IsEmpty() )
-        {
-            delete x_geom_diff;
-            delete x;
-        }
-        else
-        {
-            OGRFeature *z = new OGRFeature(poDefnResult);
-            z->SetFieldsFrom(x, mapInput);
-            if( bPromoteToMulti )
-                x_geom_diff = promote_to_multi(x_geom_diff);
-            z->SetGeometryDirectly(x_geom_diff);
-            delete x;
-            ret = pLayerResult->CreateFeature(z);
-            delete z;
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-    if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
-      CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-      ret = OGRERR_FAILURE;
-      goto done;
-    }
-done:
-    // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    if (pGeometryMethodFilter) delete pGeometryMethodFilter;
-    if (mapInput) VSIFree(mapInput);
-    if (mapMethod) VSIFree(mapMethod);
-    return ret;
+    return OGRLayerOverlay( this, pLayerMethod, pLayerResult,
+                            OGR_OVERLAY_IDENTITY, papszOptions,
+                            pfnProgress, pProgressArg );
 }
 
+
 /************************************************************************/
 /*                         OGR_L_Identity()                             */
 /************************************************************************/
@@ -3092,8 +2759,8 @@ done:
  * layer, then the attribute in the result feature will get the value
  * from the feature of the method layer (even if it is undefined).
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see OGRLayer::Intersection() for how the
+ * features are indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3169,8 +2836,8 @@ OGRErr OGR_L_Identity( OGRLayerH pLayerInput,
  * the attribute in the result feature the originates from the method
  * layer will get the value from the feature of the method layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see Intersection() for how the features are
+ * indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3214,145 +2881,12 @@ OGRErr OGRLayer::Update( OGRLayer *pLayerMethod,
                          GDALProgressFunc pfnProgress, 
                          void * pProgressArg )
 {
-    OGRErr ret = OGRERR_NONE;
-    OGRFeatureDefn *poDefnInput = GetLayerDefn();
-    OGRFeatureDefn *poDefnMethod = pLayerMethod->GetLayerDefn();
-    OGRFeatureDefn *poDefnResult = NULL;
-    OGRGeometry *pGeometryMethodFilter = NULL;
-    int *mapInput = NULL;
-    int *mapMethod = NULL;
-    double progress_max = (double) GetFeatureCount(0) + (double) pLayerMethod->GetFeatureCount(0);
-    double progress_counter = 0;
-    double progress_ticker = 0;
-    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
-    int bPromoteToMulti = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
-
-    // check for GEOS
-    if (!OGRGeometryFactory::haveGEOS()) {
-        return OGRERR_UNSUPPORTED_OPERATION;
-    }
-
-    // get resources
-    ret = clone_spatial_filter(pLayerMethod, &pGeometryMethodFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnInput, &mapInput);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnMethod, &mapMethod);
-    if (ret != OGRERR_NONE) goto done;
-    ret = set_result_schema(pLayerResult, poDefnInput, poDefnMethod, mapInput, mapMethod, 0, papszOptions);
-    if (ret != OGRERR_NONE) goto done;
-    poDefnResult = pLayerResult->GetLayerDefn();
-
-    // add clipped features from the input layer
-    ResetReading();
-    while (OGRFeature *x = GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x);
-        if (!x_geom) {
-            delete x; 
-            continue;
-        }
-        
-        OGRGeometry *x_geom_diff = x_geom->clone(); //this will be the geometry of a result feature
-        pLayerMethod->ResetReading();
-        while (OGRFeature *y = pLayerMethod->GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            OGRGeometry *x_geom_diff_new = x_geom_diff ? x_geom_diff->Difference(y_geom) : NULL;
-            if (x_geom_diff) delete x_geom_diff;
-            x_geom_diff = x_geom_diff_new;
-            delete y;
-        }
-
-        if( x_geom_diff == NULL || x_geom_diff->IsEmpty() )
-        {
-            delete x_geom_diff;
-            delete x;
-        }
-        else
-        {
-            OGRFeature *z = new OGRFeature(poDefnResult);
-            z->SetFieldsFrom(x, mapInput);
-            if( bPromoteToMulti )
-                x_geom_diff = promote_to_multi(x_geom_diff);
-            z->SetGeometryDirectly(x_geom_diff);
-            delete x;
-            ret = pLayerResult->CreateFeature(z);
-            delete z;
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-
-    // restore the original filter and add features from the update layer
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    pLayerMethod->ResetReading();
-    while (OGRFeature *y = pLayerMethod->GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete y;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        OGRGeometry *y_geom = y->GetGeometryRef();
-        if (!y_geom) {delete y; continue;}
-        OGRFeature *z = new OGRFeature(poDefnResult);
-        if (mapMethod) z->SetFieldsFrom(y, mapMethod);
-        z->SetGeometry(y_geom);
-        delete y;
-        ret = pLayerResult->CreateFeature(z);
-        delete z;
-        if (ret != OGRERR_NONE) {
-            if (!bSkipFailures) {
-                goto done;
-            } else {
-                CPLErrorReset();
-                ret = OGRERR_NONE;
-            }
-        }
-    }
-    if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
-      CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-      ret = OGRERR_FAILURE;
-      goto done;
-    }
-done:
-    // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    if (pGeometryMethodFilter) delete pGeometryMethodFilter;
-    if (mapInput) VSIFree(mapInput);
-    if (mapMethod) VSIFree(mapMethod);
-    return ret;
+    return OGRLayerOverlay( this, pLayerMethod, pLayerResult,
+                            OGR_OVERLAY_UPDATE, papszOptions,
+                            pfnProgress, pProgressArg );
 }
 
+
 /************************************************************************/
 /*                          OGR_L_Update()                              */
 /************************************************************************/
@@ -3374,8 +2908,8 @@ done:
  * the attribute in the result feature the originates from the method
  * layer will get the value from the feature of the method layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see OGRLayer::Intersection() for how the
+ * features are indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3444,8 +2978,8 @@ OGRErr OGR_L_Update( OGRLayerH pLayerInput,
  * schema of the result layer can be set by the user or, if it is
  * empty, is initialized to contain all fields in the input layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see Intersection() for how the features are
+ * indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3489,113 +3023,12 @@ OGRErr OGRLayer::Clip( OGRLayer *pLayerMethod,
                        GDALProgressFunc pfnProgress, 
                        void * pProgressArg )
 {
-    OGRErr ret = OGRERR_NONE;
-    OGRFeatureDefn *poDefnInput = GetLayerDefn();
-    OGRFeatureDefn *poDefnResult = NULL;
-    OGRGeometry *pGeometryMethodFilter = NULL;
-    int *mapInput = NULL;
-    double progress_max = (double) GetFeatureCount(0);
-    double progress_counter = 0;
-    double progress_ticker = 0;
-    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
-    int bPromoteToMulti = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
-
-    // check for GEOS
-    if (!OGRGeometryFactory::haveGEOS()) {
-        return OGRERR_UNSUPPORTED_OPERATION;
-    }
-
-    ret = clone_spatial_filter(pLayerMethod, &pGeometryMethodFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnInput, &mapInput);
-    if (ret != OGRERR_NONE) goto done;
-    ret = set_result_schema(pLayerResult, poDefnInput, NULL, mapInput, NULL, 0, papszOptions);
-    if (ret != OGRERR_NONE) goto done;
-    
-    poDefnResult = pLayerResult->GetLayerDefn();
-    ResetReading();
-    while (OGRFeature *x = GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on method layer
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x);
-        if (!x_geom) {
-            delete x; 
-            continue;
-        }
-        
-        OGRGeometry *geom = NULL; // this will be the geometry of the result feature 
-        pLayerMethod->ResetReading();
-        // incrementally add area from y to geom
-        while (OGRFeature *y = pLayerMethod->GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            if (!geom) {
-                geom = y_geom->clone();
-            } else {
-                OGRGeometry *geom_new = geom->Union(y_geom);
-                delete geom;
-                geom = geom_new;
-            }
-            delete y;
-        }
-
-        // possibly add a new feature with area x intersection sum of y
-        OGRFeature *z = NULL;
-        if (geom) {
-            OGRGeometry* poIntersection = x_geom->Intersection(geom);
-            if( poIntersection != NULL && !poIntersection->IsEmpty() )
-            {
-                z = new OGRFeature(poDefnResult);
-                z->SetFieldsFrom(x, mapInput);
-                if( bPromoteToMulti )
-                    poIntersection = promote_to_multi(poIntersection);
-                z->SetGeometryDirectly(poIntersection);
-            }
-            else
-                delete poIntersection;
-            delete geom;
-        }
-        delete x;
-        if (z) {
-            if (z->GetGeometryRef() != NULL && !z->GetGeometryRef()->IsEmpty())
-                ret = pLayerResult->CreateFeature(z);
-            delete z;
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-    if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
-      CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-      ret = OGRERR_FAILURE;
-      goto done;
-    }
-done:
-    // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    if (pGeometryMethodFilter) delete pGeometryMethodFilter;
-    if (mapInput) VSIFree(mapInput);
-    return ret;
+    return OGRLayerOverlay( this, pLayerMethod, pLayerResult,
+                            OGR_OVERLAY_CLIP, papszOptions,
+                            pfnProgress, pProgressArg );
 }
 
+
 /************************************************************************/
 /*                           OGR_L_Clip()                               */
 /************************************************************************/
@@ -3610,8 +3043,8 @@ done:
  * schema of the result layer can be set by the user or, if it is
  * empty, is initialized to contain all fields in the input layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see OGRLayer::Intersection() for how the
+ * features are indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3680,8 +3113,8 @@ OGRErr OGR_L_Clip( OGRLayerH pLayerInput,
  * it is empty, is initialized to contain all fields in the input
  * layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see Intersection() for how the features are
+ * indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -3725,114 +3158,12 @@ OGRErr OGRLayer::Erase( OGRLayer *pLayerMethod,
                         GDALProgressFunc pfnProgress, 
                         void * pProgressArg )
 {
-    OGRErr ret = OGRERR_NONE;
-    OGRFeatureDefn *poDefnInput = GetLayerDefn();
-    OGRFeatureDefn *poDefnResult = NULL;
-    OGRGeometry *pGeometryMethodFilter = NULL;
-    int *mapInput = NULL;
-    double progress_max = (double) GetFeatureCount(0);
-    double progress_counter = 0;
-    double progress_ticker = 0;
-    int bSkipFailures = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "SKIP_FAILURES", "NO"));
-    int bPromoteToMulti = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "PROMOTE_TO_MULTI", "NO"));
-
-    // check for GEOS
-    if (!OGRGeometryFactory::haveGEOS()) {
-        return OGRERR_UNSUPPORTED_OPERATION;
-    }
-
-    // get resources
-    ret = clone_spatial_filter(pLayerMethod, &pGeometryMethodFilter);
-    if (ret != OGRERR_NONE) goto done;
-    ret = create_field_map(poDefnInput, &mapInput);
-    if (ret != OGRERR_NONE) goto done;
-    ret = set_result_schema(pLayerResult, poDefnInput, NULL, mapInput, NULL, 0, papszOptions);
-    if (ret != OGRERR_NONE) goto done;
-    poDefnResult = pLayerResult->GetLayerDefn();
-
-    ResetReading();
-    while (OGRFeature *x = GetNextFeature()) {
-
-        if (pfnProgress) {
-            double p = progress_counter/progress_max;
-            if (p > progress_ticker) {
-                if (!pfnProgress(p, "", pProgressArg)) {
-                    CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-                    ret = OGRERR_FAILURE;
-                    delete x;
-                    goto done;
-                }
-            }
-            progress_counter += 1.0;
-        }
-
-        // set up the filter on the method layer
-        OGRGeometry *x_geom = set_filter_from(pLayerMethod, pGeometryMethodFilter, x);
-        if (!x_geom) {
-            delete x; 
-            continue;
-        }
-
-        OGRGeometry *geom = NULL; // this will be the geometry of the result feature
-        pLayerMethod->ResetReading();
-        // incrementally add area from y to geom
-        while (OGRFeature *y = pLayerMethod->GetNextFeature()) {
-            OGRGeometry *y_geom = y->GetGeometryRef();
-            if (!y_geom) {delete y; continue;}
-            if (!geom) {
-                geom = y_geom->clone();
-            } else {
-                OGRGeometry *geom_new = geom->Union(y_geom);
-                delete geom;
-                geom = geom_new;
-            }
-            delete y;
-        }
-
-        // possibly add a new feature with area x minus sum of y
-        OGRFeature *z = NULL;
-        if (geom) {
-            OGRGeometry* x_geom_diff = x_geom->Difference(geom);
-            if( x_geom_diff != NULL && !x_geom_diff->IsEmpty() )
-            {
-                z = new OGRFeature(poDefnResult);
-                z->SetFieldsFrom(x, mapInput);
-                if( bPromoteToMulti )
-                    x_geom_diff = promote_to_multi(x_geom_diff);
-                z->SetGeometryDirectly(x_geom_diff);
-            }
-            else
-                delete x_geom_diff;
-            delete geom;
-        }
-        delete x;
-        if (z) {
-            if (z->GetGeometryRef() != NULL && !z->GetGeometryRef()->IsEmpty())
-                ret = pLayerResult->CreateFeature(z);
-            delete z;
-            if (ret != OGRERR_NONE) {
-                if (!bSkipFailures) {
-                    goto done;
-                } else {
-                    CPLErrorReset();
-                    ret = OGRERR_NONE;
-                }
-            }
-        }
-    }
-    if (pfnProgress && !pfnProgress(1.0, "", pProgressArg)) {
-      CPLError(CE_Failure, CPLE_UserInterrupt, "User terminated");
-      ret = OGRERR_FAILURE;
-      goto done;
-    }
-done:
-    // release resources
-    pLayerMethod->SetSpatialFilter(pGeometryMethodFilter);
-    if (pGeometryMethodFilter) delete pGeometryMethodFilter;
-    if (mapInput) VSIFree(mapInput);
-    return ret;
+    return OGRLayerOverlay( this, pLayerMethod, pLayerResult,
+                            OGR_OVERLAY_ERASE, papszOptions,
+                            pfnProgress, pProgressArg );
 }
 
+
 /************************************************************************/
 /*                           OGR_L_Erase()                              */
 /************************************************************************/
@@ -3847,8 +3178,8 @@ done:
  * it is empty, is initialized to contain all fields in the input
  * layer.
  *
- * \note For best performance use the minimum amount of features in
- * the method layer and copy it into a memory layer.
+ * \note Since GDAL 2.0, see OGRLayer::Intersection() for how the
+ * features are indexed in memory and processed on several threads.
  *
  * \note This method relies on GEOS support. Do not use unless the
  * GEOS support is compiled in.
@@ -97,6 +97,27 @@ OGRFeature *OGRLayerDecorator::GetNextFeature()
     return m_poDecoratedLayer->GetNextFeature();
 }
 
+int         OGRLayerDecorator::GetNextFeatureInto( OGRFeature *poFeature )
+{
+    if( !m_poDecoratedLayer ) { poFeature->Reset(); return FALSE; }
+    /* The feature uses the definition of the decorator, which the */
+    /* decorated layer would reject if it is not its own */
+    if( GetLayerDefn() != m_poDecoratedLayer->GetLayerDefn() )
+        return OGRLayer::GetNextFeatureInto(poFeature);
+    return m_poDecoratedLayer->GetNextFeatureInto(poFeature);
+}
+
+int         OGRLayerDecorator::GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                                    int nMaxFeatures )
+{
+    if( !m_poDecoratedLayer ) { poBatch->Reset(); return 0; }
+    /* Decorators exposing their own layer definition (e.g. a clone of the */
+    /* decorated one) translate the features in GetNextFeature() */
+    if( GetLayerDefn() != m_poDecoratedLayer->GetLayerDefn() )
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxFeatures);
+    return m_poDecoratedLayer->GetNextFeatureBatch(poBatch, nMaxFeatures);
+}
+
 OGRErr      OGRLayerDecorator::SetNextByIndex( GIntBig nIndex )
 {
     if( !m_poDecoratedLayer ) return OGRERR_FAILURE;
@@ -121,6 +142,13 @@ OGRErr      OGRLayerDecorator::ICreateFeature( OGRFeature *poFeature )
     return m_poDecoratedLayer->CreateFeature(poFeature);
 }
 
+OGRErr      OGRLayerDecorator::ICreateFeatures( OGRFeature **papoFeatures,
+                                                int nFeatureCount )
+{
+    if( !m_poDecoratedLayer ) return OGRERR_FAILURE;
+    return m_poDecoratedLayer->CreateFeatures(papoFeatures, nFeatureCount);
+}
+
 OGRErr      OGRLayerDecorator::DeleteFeature( GIntBig nFID )
 {
     if( !m_poDecoratedLayer ) return OGRERR_FAILURE;
@@ -326,6 +326,17 @@ OGRErr      OGRProxiedLayer::ICreateFeature( OGRFeature *poFeature )
     return poUnderlyingLayer->CreateFeature(poFeature);
 }
 
+/************************************************************************/
+/*                           ICreateFeatures()                          */
+/************************************************************************/
+
+OGRErr      OGRProxiedLayer::ICreateFeatures( OGRFeature **papoFeatures,
+                                              int nFeatureCount )
+{
+    if( poUnderlyingLayer == NULL && !OpenUnderlyingLayer() ) return OGRERR_FAILURE;
+    return poUnderlyingLayer->CreateFeatures(papoFeatures, nFeatureCount);
+}
+
 /************************************************************************/
 /*                           DeleteFeature()                            */
 /************************************************************************/
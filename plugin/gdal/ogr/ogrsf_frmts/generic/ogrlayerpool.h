@@ -122,6 +122,8 @@ class OGRProxiedLayer : public OGRAbstractProxiedLayer
     virtual OGRFeature *GetFeature( GIntBig nFID );
     virtual OGRErr      ISetFeature( OGRFeature *poFeature );
     virtual OGRErr      ICreateFeature( OGRFeature *poFeature );
+    virtual OGRErr      ICreateFeatures( OGRFeature **papoFeatures,
+                                         int nFeatureCount );
     virtual OGRErr      DeleteFeature( GIntBig nFID );
 
     virtual const char *GetName();
@@ -95,6 +95,19 @@ OGRFeature *OGRMutexedLayer::GetNextFeature()
     return OGRLayerDecorator::GetNextFeature();
 }
 
+int         OGRMutexedLayer::GetNextFeatureInto( OGRFeature *poFeature )
+{
+    CPLMutexHolderOptionalLockD(m_hMutex);
+    return OGRLayerDecorator::GetNextFeatureInto(poFeature);
+}
+
+int         OGRMutexedLayer::GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                                  int nMaxFeatures )
+{
+    CPLMutexHolderOptionalLockD(m_hMutex);
+    return OGRLayerDecorator::GetNextFeatureBatch(poBatch, nMaxFeatures);
+}
+
 OGRErr      OGRMutexedLayer::SetNextByIndex( GIntBig nIndex )
 {
     CPLMutexHolderOptionalLockD(m_hMutex);
@@ -119,6 +132,13 @@ OGRErr      OGRMutexedLayer::ICreateFeature( OGRFeature *poFeature )
     return OGRLayerDecorator::ICreateFeature(poFeature);
 }
 
+OGRErr      OGRMutexedLayer::ICreateFeatures( OGRFeature **papoFeatures,
+                                              int nFeatureCount )
+{
+    CPLMutexHolderOptionalLockD(m_hMutex);
+    return OGRLayerDecorator::ICreateFeatures(papoFeatures, nFeatureCount);
+}
+
 OGRErr      OGRMutexedLayer::DeleteFeature( GIntBig nFID )
 {
     CPLMutexHolderOptionalLockD(m_hMutex);
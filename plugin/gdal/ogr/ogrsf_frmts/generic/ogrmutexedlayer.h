@@ -67,10 +67,15 @@ class CPL_DLL OGRMutexedLayer : public OGRLayerDecorator
 
     virtual void        ResetReading();
     virtual OGRFeature *GetNextFeature();
+    virtual int         GetNextFeatureInto( OGRFeature *poFeature );
+    virtual int         GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                             int nMaxFeatures );
     virtual OGRErr      SetNextByIndex( GIntBig nIndex );
     virtual OGRFeature *GetFeature( GIntBig nFID );
     virtual OGRErr      ISetFeature( OGRFeature *poFeature );
     virtual OGRErr      ICreateFeature( OGRFeature *poFeature );
+    virtual OGRErr      ICreateFeatures( OGRFeature **papoFeatures,
+                                         int nFeatureCount );
     virtual OGRErr      DeleteFeature( GIntBig nFID );
 
     virtual const char *GetName();
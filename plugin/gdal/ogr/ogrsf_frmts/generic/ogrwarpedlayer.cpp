@@ -241,6 +241,25 @@ OGRFeature *OGRWarpedLayer::GetNextFeature()
     }
 }
 
+/************************************************************************/
+/*                         GetNextFeatureInto()                         */
+/*                        GetNextFeatureBatch()                         */
+/*                                                                      */
+/*      Go through GetNextFeature(), so that the features are warped,   */
+/*      instead of forwarding to the decorated layer.                   */
+/************************************************************************/
+
+int OGRWarpedLayer::GetNextFeatureInto( OGRFeature *poFeature )
+{
+    return OGRLayer::GetNextFeatureInto( poFeature );
+}
+
+int OGRWarpedLayer::GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                         int nMaxFeatures )
+{
+    return OGRLayer::GetNextFeatureBatch( poBatch, nMaxFeatures );
+}
+
 /************************************************************************/
 /*                             GetFeature()                             */
 /************************************************************************/
@@ -295,6 +314,17 @@ OGRErr      OGRWarpedLayer::ICreateFeature( OGRFeature *poFeature )
     return eErr;
 }
 
+/************************************************************************/
+/*                           ICreateFeatures()                          */
+/************************************************************************/
+
+OGRErr      OGRWarpedLayer::ICreateFeatures( OGRFeature **papoFeatures,
+                                             int nFeatureCount )
+{
+    /* Each feature must be reprojected by ICreateFeature() */
+    return OGRLayer::ICreateFeatures(papoFeatures, nFeatureCount);
+}
+
 
 /************************************************************************/
 /*                            GetLayerDefn()                           */
@@ -73,9 +73,14 @@ class OGRWarpedLayer : public OGRLayerDecorator
                                               double dfMaxX, double dfMaxY );
 
     virtual OGRFeature *GetNextFeature();
+    virtual int         GetNextFeatureInto( OGRFeature *poFeature );
+    virtual int         GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                             int nMaxFeatures );
     virtual OGRFeature *GetFeature( GIntBig nFID );
     virtual OGRErr      ISetFeature( OGRFeature *poFeature );
     virtual OGRErr      ICreateFeature( OGRFeature *poFeature );
+    virtual OGRErr      ICreateFeatures( OGRFeature **papoFeatures,
+                                         int nFeatureCount );
 
     virtual OGRFeatureDefn *GetLayerDefn();
 
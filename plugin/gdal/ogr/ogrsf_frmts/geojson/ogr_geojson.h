@@ -32,6 +32,7 @@
 
 #include "cpl_port.h"
 #include <ogrsf_frmts.h>
+#include "ogr_strtree.h"
 
 #include <cstdio>
 #include <vector> // used by OGRGeoJSONLayer
@@ -83,6 +84,15 @@ private:
     FeaturesSeq seqFeatures_;
     FeaturesSeq::iterator iterCurrent_;
 
+    // Spatial index of seqFeatures_, built on the first spatially
+    // filtered read.
+    OGRSTRTree* poSpatialIndex_;
+    std::vector<GIntBig> seqCandidates_;
+    size_t nNextCandidate_;
+    bool bCandidatesComputed_;
+
+    void GetSpatialFilterCandidates( std::vector<GIntBig>& seqCandidates );
+    bool MatchFilters( OGRFeature* poFeature );
 
     // CPL_UNUSED OGRGeoJSONDataSource* poDS_;
     OGRFeatureDefn* poFeatureDefn_;
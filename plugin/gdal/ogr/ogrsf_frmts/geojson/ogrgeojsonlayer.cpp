@@ -52,7 +52,9 @@ OGRGeoJSONLayer::OGRGeoJSONLayer( const char* pszName,
                                   OGRSpatialReference* poSRSIn,
                                   OGRwkbGeometryType eGType,
                                   CPL_UNUSED OGRGeoJSONDataSource* poDS )
-  : iterCurrent_( seqFeatures_.end() ), /* poDS_( poDS ), */ poFeatureDefn_(new OGRFeatureDefn( pszName ) )
+  : iterCurrent_( seqFeatures_.end() ), poSpatialIndex_( NULL ),
+    nNextCandidate_( 0 ), bCandidatesComputed_( false ),
+    /* poDS_( poDS ), */ poFeatureDefn_(new OGRFeatureDefn( pszName ) )
 {
     /* CPLAssert( NULL != poDS_ ); */
     CPLAssert( NULL != poFeatureDefn_ );
@@ -73,6 +75,8 @@ OGRGeoJSONLayer::~OGRGeoJSONLayer()
     std::for_each(seqFeatures_.begin(), seqFeatures_.end(),
                   OGRFeature::DestroyFeature);
 
+    delete poSpatialIndex_;
+
     if( NULL != poFeatureDefn_ )
     {
         poFeatureDefn_->Release();
@@ -96,8 +100,19 @@ GIntBig OGRGeoJSONLayer::GetFeatureCount( int bForce )
 {
     if (m_poFilterGeom == NULL && m_poAttrQuery == NULL)
         return static_cast<int>( seqFeatures_.size() );
-    else
+    else if (m_poFilterGeom == NULL)
         return OGRLayer::GetFeatureCount(bForce);
+
+    std::vector<GIntBig> seqCandidates;
+    GetSpatialFilterCandidates( seqCandidates );
+
+    GIntBig nCount = 0;
+    for( size_t i = 0; i < seqCandidates.size(); ++i )
+    {
+        if( MatchFilters( seqFeatures_[(size_t)seqCandidates[i]] ) )
+            ++nCount;
+    }
+    return nCount;
 }
 
 /************************************************************************/
@@ -107,6 +122,44 @@ GIntBig OGRGeoJSONLayer::GetFeatureCount( int bForce )
 void OGRGeoJSONLayer::ResetReading()
 {
     iterCurrent_ = seqFeatures_.begin();
+    seqCandidates_.clear();
+    nNextCandidate_ = 0;
+    bCandidatesComputed_ = false;
+}
+
+/************************************************************************/
+/*                     GetSpatialFilterCandidates                       */
+/************************************************************************/
+
+void OGRGeoJSONLayer::GetSpatialFilterCandidates(
+                                    std::vector<GIntBig>& seqCandidates )
+{
+    // The index is built on the first spatial filter, and discarded by
+    // AddFeature().
+    if( NULL == poSpatialIndex_ )
+    {
+        poSpatialIndex_ = new OGRSTRTree();
+        for( size_t i = 0; i < seqFeatures_.size(); ++i )
+        {
+            poSpatialIndex_->AddGeometry( seqFeatures_[i]->GetGeometryRef(),
+                                          static_cast<GIntBig>(i) );
+        }
+        poSpatialIndex_->Build();
+    }
+
+    poSpatialIndex_->Search( m_sFilterEnvelope, seqCandidates );
+}
+
+/************************************************************************/
+/*                           MatchFilters                               */
+/************************************************************************/
+
+bool OGRGeoJSONLayer::MatchFilters( OGRFeature* poFeature )
+{
+    return (m_poFilterGeom == NULL
+            || FilterGeometry( poFeature->GetGeometryRef() ) )
+        && (m_poAttrQuery == NULL
+            || m_poAttrQuery->Evaluate( poFeature ));
 }
 
 /************************************************************************/
@@ -115,16 +168,37 @@ void OGRGeoJSONLayer::ResetReading()
 
 OGRFeature* OGRGeoJSONLayer::GetNextFeature()
 {
+    // With a spatial filter, only visit the features selected by the
+    // spatial index.
+    if( m_poFilterGeom != NULL && !bCandidatesComputed_ )
+    {
+        GetSpatialFilterCandidates( seqCandidates_ );
+        bCandidatesComputed_ = true;
+        nNextCandidate_ = 0;
+    }
+
     while ( iterCurrent_ != seqFeatures_.end() )
     {
+        if( m_poFilterGeom != NULL )
+        {
+            const size_t nCurrent = iterCurrent_ - seqFeatures_.begin();
+            while( nNextCandidate_ < seqCandidates_.size()
+                   && seqCandidates_[nNextCandidate_] < (GIntBig)nCurrent )
+                ++nNextCandidate_;
+            if( nNextCandidate_ == seqCandidates_.size() )
+            {
+                iterCurrent_ = seqFeatures_.end();
+                break;
+            }
+            iterCurrent_ = seqFeatures_.begin() +
+                           (size_t)seqCandidates_[nNextCandidate_++];
+        }
+
         OGRFeature* poFeature = (*iterCurrent_);
         CPLAssert( NULL != poFeature );
         ++iterCurrent_;
         
-        if((m_poFilterGeom == NULL
-            || FilterGeometry( poFeature->GetGeometryRef() ) )
-        && (m_poAttrQuery == NULL
-            || m_poAttrQuery->Evaluate( poFeature )) )
+        if( MatchFilters( poFeature ) )
         {
             OGRFeature* poFeatureCopy = poFeature->Clone();
             CPLAssert( NULL != poFeatureCopy );
@@ -149,6 +223,7 @@ int OGRGeoJSONLayer::TestCapability( const char* pszCap )
 {
     if( EQUAL(pszCap, OLCFastFeatureCount) ||
         EQUAL(pszCap, OLCFastGetExtent) ||
+        EQUAL(pszCap, OLCFastSpatialFilter) ||
         EQUAL(pszCap, OLCStringsAsUTF8) )
     {
         return TRUE;
@@ -210,6 +285,9 @@ void OGRGeoJSONLayer::AddFeature( OGRFeature* poFeature )
     if( (GIntBig)(int)poNewFeature->GetFID() != poNewFeature->GetFID() )
         SetMetadataItem(OLMD_FID64, "YES");
 
+    delete poSpatialIndex_;
+    poSpatialIndex_ = NULL;
+
     seqFeatures_.push_back( poNewFeature );
 }
 
@@ -327,6 +327,8 @@ class OGRGeoPackageLayer : public OGRLayer, public IOGRSQLiteGetSpatialWhere
                                            sqlite3_stmt *hStmt );
 
     OGRFeature*         TranslateFeature(sqlite3_stmt* hStmt);
+    void                TranslateFeatureBatch(sqlite3_stmt* hStmt,
+                                              OGRFeatureBatch* poBatch);
 
   public:
 
@@ -396,12 +398,16 @@ class OGRGeoPackageTableLayer : public OGRGeoPackageLayer
                                          int bApproxOK = TRUE );
     void                ResetReading();
 	OGRErr              ICreateFeature( OGRFeature *poFeater );
+    OGRErr              ICreateFeatures( OGRFeature **papoFeatures,
+                                         int nFeatureCount );
     OGRErr              ISetFeature( OGRFeature *poFeature );
     OGRErr              DeleteFeature(GIntBig nFID);
     virtual void        SetSpatialFilter( OGRGeometry * );
     OGRErr              SetAttributeFilter( const char *pszQuery );
     OGRErr              SyncToDisk();
     OGRFeature*         GetNextFeature();
+    int                 GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                             int nMaxFeatures );
     OGRFeature*         GetFeature(GIntBig nFID);
     OGRErr              StartTransaction();
     OGRErr              CommitTransaction();
@@ -459,6 +465,12 @@ class OGRGeoPackageTableLayer : public OGRGeoPackageLayer
     OGRErr              SaveExtent();
     OGRErr              BuildColumns();
     OGRBoolean          IsGeomFieldSet( OGRFeature *poFeature );
+    void                GetGeomFieldEnvelope( OGRFeature *poFeature,
+                                              OGREnvelope *poEnv );
+    OGRErr              FeaturePrepareInsert( OGRFeature *poFeature,
+                                              int *pbHasDefaultValue );
+    OGRErr              FeatureInsertRows( OGRFeature **papoFeatures,
+                                           int nFeatureCount );
     CPLString           FeatureGenerateUpdateSQL( OGRFeature *poFeature );
     CPLString           FeatureGenerateInsertSQL( OGRFeature *poFeature, int bAddFID, int bBindNullFields );
     OGRErr              FeatureBindUpdateParameters( OGRFeature *poFeature, sqlite3_stmt *poStmt );
@@ -141,7 +141,23 @@ OGRFeature *OGRGeoPackageLayer::GetNextFeature()
         if( poFeature == NULL )
             return NULL;
 
-        if( (m_poFilterGeom == NULL
+        /* Try to decide on the envelope of a geometry not parsed yet */
+        int bGeomMatch = (m_poFilterGeom == NULL);
+        OGRLazyGeometry *poLazy = NULL;
+        if( m_poFilterGeom != NULL &&
+            (poLazy = poFeature->GetGeomFieldLazyRef(m_iGeomFieldFilter)) != NULL )
+        {
+            OGREnvelope sGeomEnv;
+            poLazy->getEnvelope( &sGeomEnv );
+            if( !sGeomEnv.Intersects( m_sFilterEnvelope ) )
+            {
+                delete poFeature;
+                continue;
+            }
+            bGeomMatch = m_bFilterIsEnvelope && m_sFilterEnvelope.Contains( sGeomEnv );
+        }
+
+        if( (bGeomMatch
             || FilterGeometry( poFeature->GetGeomFieldRef(m_iGeomFieldFilter) ) )
             && (m_poAttrQuery == NULL
                 || m_poAttrQuery->Evaluate( poFeature )) )
@@ -189,8 +205,15 @@ OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
             OGRSpatialReference* poSrs = poGeomFieldDefn->GetSpatialRef();
             int iGpkgSize = sqlite3_column_bytes(hStmt, iGeomCol);
             GByte *pabyGpkg = (GByte *)sqlite3_column_blob(hStmt, iGeomCol);
-            OGRGeometry *poGeom = GPkgGeometryToOGR(pabyGpkg, iGpkgSize, poSrs);
-            if ( ! poGeom )
+
+            /* Keep the geometry as WKB until it is needed */
+            OGRLazyGeometry *poLazy = GPkgGeometryToLazy(pabyGpkg, iGpkgSize, poSrs);
+            OGRGeometry *poGeom = NULL;
+            if ( poLazy )
+                poFeature->SetGeomFieldLazyDirectly( 0, poLazy );
+            else
+                poGeom = GPkgGeometryToOGR(pabyGpkg, iGpkgSize, poSrs);
+            if ( ! poLazy && ! poGeom )
             {
                 // Try also spatialite geometry blobs
                 if( OGRSQLiteLayer::ImportSpatiaLiteGeometry( pabyGpkg, iGpkgSize,
@@ -199,7 +222,8 @@ OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
                     CPLError( CE_Failure, CPLE_AppDefined, "Unable to read geometry");
                 }
             }
-            poFeature->SetGeometryDirectly( poGeom );
+            if ( poGeom )
+                poFeature->SetGeometryDirectly( poGeom );
         }
     }
     
@@ -274,6 +298,145 @@ OGRFeature *OGRGeoPackageLayer::TranslateFeature( sqlite3_stmt* hStmt )
     return poFeature;
 }
 
+/************************************************************************/
+/*                       TranslateFeatureBatch()                        */
+/*                                                                      */
+/*      Append the current result to a feature batch. Same as           */
+/*      TranslateFeature(), except that the WKB of standard GeoPackage  */
+/*      geometry blobs is copied without building a geometry.           */
+/************************************************************************/
+
+void OGRGeoPackageLayer::TranslateFeatureBatch( sqlite3_stmt* hStmt,
+                                                OGRFeatureBatch* poBatch )
+
+{
+    if( iFIDCol >= 0 )
+        poBatch->BeginFeature( sqlite3_column_int64( hStmt, iFIDCol ) );
+    else
+        poBatch->BeginFeature( iNextShapeId );
+
+    iNextShapeId++;
+
+    m_nFeaturesRead++;
+
+/* -------------------------------------------------------------------- */
+/*      Process Geometry if we have a column.                           */
+/* -------------------------------------------------------------------- */
+    if( iGeomCol >= 0 )
+    {
+        OGRGeomFieldDefn* poGeomFieldDefn = m_poFeatureDefn->GetGeomFieldDefn(0);
+        if ( sqlite3_column_type(hStmt, iGeomCol) != SQLITE_NULL &&
+            !poGeomFieldDefn->IsIgnored() )
+        {
+            int iGpkgSize = sqlite3_column_bytes(hStmt, iGeomCol);
+            GByte *pabyGpkg = (GByte *)sqlite3_column_blob(hStmt, iGeomCol);
+            GPkgHeader oHeader;
+            if( iGpkgSize >= 8 &&
+                GPkgHeaderFromWKB(pabyGpkg, &oHeader) == OGRERR_NONE &&
+                !oHeader.bEmpty && !oHeader.bExtended &&
+                oHeader.szHeader + 5 <= (size_t)iGpkgSize )
+            {
+                poBatch->SetGeomFieldWKB( 0, pabyGpkg + oHeader.szHeader,
+                                          iGpkgSize - oHeader.szHeader );
+            }
+            else
+            {
+                OGRGeometry *poGeom = GPkgGeometryToOGR(pabyGpkg, iGpkgSize, NULL);
+                if ( ! poGeom )
+                {
+                    // Try also spatialite geometry blobs
+                    if( OGRSQLiteLayer::ImportSpatiaLiteGeometry( pabyGpkg, iGpkgSize,
+                                                                  &poGeom ) != OGRERR_NONE )
+                    {
+                        CPLError( CE_Failure, CPLE_AppDefined, "Unable to read geometry");
+                    }
+                }
+                poBatch->SetGeomField( 0, poGeom );
+                delete poGeom;
+            }
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      set the fields.                                                 */
+/* -------------------------------------------------------------------- */
+    for( int iField = 0; iField < m_poFeatureDefn->GetFieldCount(); iField++ )
+    {
+        OGRFieldDefn *poFieldDefn = m_poFeatureDefn->GetFieldDefn( iField );
+        if ( poFieldDefn->IsIgnored() )
+            continue;
+
+        int iRawField = panFieldOrdinals[iField];
+
+        if( sqlite3_column_type( hStmt, iRawField ) == SQLITE_NULL )
+            continue;
+
+        switch( poFieldDefn->GetType() )
+        {
+            case OFTInteger:
+                poBatch->SetFieldInteger( iField,
+                    sqlite3_column_int( hStmt, iRawField ) );
+                break;
+
+            case OFTInteger64:
+                poBatch->SetFieldInteger64( iField,
+                    sqlite3_column_int64( hStmt, iRawField ) );
+                break;
+
+            case OFTReal:
+                poBatch->SetFieldDouble( iField,
+                    sqlite3_column_double( hStmt, iRawField ) );
+                break;
+
+            case OFTBinary:
+            {
+                const int nBytes = sqlite3_column_bytes( hStmt, iRawField );
+
+                poBatch->SetFieldBinary( iField,
+                    (const GByte*)sqlite3_column_blob( hStmt, iRawField ),
+                    nBytes );
+                break;
+            }
+
+            case OFTDate:
+            {
+                const char* pszTxt = (const char*)sqlite3_column_text( hStmt, iRawField );
+                int nYear, nMonth, nDay;
+                if( sscanf(pszTxt, "%d-%d-%d", &nYear, &nMonth, &nDay) == 3 )
+                {
+                    OGRField sField;
+                    memset( &sField, 0, sizeof(sField) );
+                    sField.Date.Year = (GInt16)nYear;
+                    sField.Date.Month = (GByte)nMonth;
+                    sField.Date.Day = (GByte)nDay;
+                    poBatch->SetFieldRaw( iField, &sField );
+                }
+                break;
+            }
+
+            case OFTDateTime:
+            {
+                const char* pszTxt = (const char*)sqlite3_column_text( hStmt, iRawField );
+                OGRField sField;
+                if( OGRParseXMLDateTime(pszTxt, &sField) )
+                    poBatch->SetFieldRaw( iField, &sField );
+                break;
+            }
+
+            case OFTString:
+            {
+                const char* pszTxt = (const char*)sqlite3_column_text( hStmt, iRawField );
+                poBatch->SetFieldString( iField, pszTxt,
+                    sqlite3_column_bytes( hStmt, iRawField ) );
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
 /************************************************************************/
 /*                      GetFIDColumn()                                  */
 /************************************************************************/
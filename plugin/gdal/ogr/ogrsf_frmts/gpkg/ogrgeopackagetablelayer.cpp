@@ -134,7 +134,7 @@ OGRErr OGRGeoPackageTableLayer::BuildColumns()
 OGRBoolean OGRGeoPackageTableLayer::IsGeomFieldSet( OGRFeature *poFeature )
 {
     if ( poFeature->GetDefnRef()->GetGeomFieldCount() && 
-         poFeature->GetGeomFieldRef(0) )
+         (poFeature->GetGeomFieldLazyRef(0) || poFeature->GetGeomFieldRef(0)) )
     {
         return TRUE;        
     }
@@ -144,18 +144,36 @@ OGRBoolean OGRGeoPackageTableLayer::IsGeomFieldSet( OGRFeature *poFeature )
     }
 }
 
+//----------------------------------------------------------------------
+// GetGeomFieldEnvelope()
+// 
+// Utility method to get the envelope of the geometry of a feature,
+// without parsing it if it is still kept as WKB.
+//
+void OGRGeoPackageTableLayer::GetGeomFieldEnvelope( OGRFeature *poFeature,
+                                                    OGREnvelope *poEnv )
+{
+    OGRLazyGeometry* poLazy = poFeature->GetGeomFieldLazyRef(0);
+    if ( poLazy )
+        poLazy->getEnvelope(poEnv);
+    else
+        poFeature->GetGeomFieldRef(0)->getEnvelope(poEnv);
+}
+
 OGRErr OGRGeoPackageTableLayer::FeatureBindParameters( OGRFeature *poFeature,
                                                        sqlite3_stmt *poStmt,
                                                        int *pnColCount,
                                                        int bAddFID,
                                                        int bBindNullFields )
 {
-    int nColCount = 1;
     int err;
     
     if ( ! (poFeature && poStmt && pnColCount) )
         return OGRERR_FAILURE;
 
+    /* The values are bound from the *pnColCount-th parameter on */
+    int nColCount = *pnColCount;
+
     OGRFeatureDefn *poFeatureDefn = poFeature->GetDefnRef();
 
     if( bAddFID )
@@ -168,9 +186,17 @@ OGRErr OGRGeoPackageTableLayer::FeatureBindParameters( OGRFeature *poFeature,
     {
         GByte *pabyWkb = NULL;
 
+        /* Geometry not parsed yet: the WKB is copied as it is */
+        OGRLazyGeometry* poLazy = poFeature->GetGeomFieldLazyRef(0);
+        OGRGeometry* poGeom = poLazy ? NULL : poFeature->GetGeomFieldRef(0);
+        if ( poLazy )
+        {
+            size_t szWkb;
+            pabyWkb = GPkgGeometryFromLazy(poLazy, m_iSrs, &szWkb);
+            err = sqlite3_bind_blob(poStmt, nColCount++, pabyWkb, szWkb, CPLFree);
+        }
         /* Non-NULL geometry */
-        OGRGeometry* poGeom = poFeature->GetGeomFieldRef(0);
-        if ( poGeom )
+        else if ( poGeom )
         {
             size_t szWkb;
             pabyWkb = GPkgGeometryFromOGR(poGeom, m_iSrs, &szWkb);
@@ -323,7 +349,7 @@ OGRErr OGRGeoPackageTableLayer::FeatureBindParameters( OGRFeature *poFeature,
 OGRErr OGRGeoPackageTableLayer::FeatureBindUpdateParameters( OGRFeature *poFeature, sqlite3_stmt *poStmt )
 {
 
-    int nColCount;
+    int nColCount = 1;
     OGRErr err = FeatureBindParameters( poFeature, poStmt, &nColCount, FALSE, TRUE );
     if ( err != OGRERR_NONE )
         return err;
@@ -354,11 +380,67 @@ OGRErr OGRGeoPackageTableLayer::FeatureBindInsertParameters( OGRFeature *poFeatu
                                                              int bAddFID,
                                                              int bBindNullFields )
 {    
-    int nColCount;
+    int nColCount = 1;
     return FeatureBindParameters( poFeature, poStmt, &nColCount, bAddFID, bBindNullFields );
 }   
 
 
+//----------------------------------------------------------------------
+// FeaturePrepareInsert()
+// 
+// Fill the unset fields of a feature about to be inserted with their
+// default value when needed, and check its FID. *pbHasDefaultValue is set
+// when an unset field has a default value left to the database, in which
+// case the field must not be bound to NULL.
+//
+OGRErr OGRGeoPackageTableLayer::FeaturePrepareInsert( OGRFeature *poFeature,
+                                                      int *pbHasDefaultValue )
+{
+    /* Substitute default values for null Date/DateTime fields as the standard */
+    /* format of SQLite is not the one mandated by GeoPackage */
+    poFeature->FillUnsetWithDefault(FALSE, NULL);
+    *pbHasDefaultValue = FALSE;
+    int iField;
+    int nFieldCount = m_poFeatureDefn->GetFieldCount();
+    for( iField = 0; iField < nFieldCount; iField++ )
+    {
+        if( poFeature->IsFieldSet( iField ) )
+            continue;
+        const char* pszDefault = poFeature->GetFieldDefnRef(iField)->GetDefault();
+        if( pszDefault != NULL )
+        {
+            *pbHasDefaultValue = TRUE;
+            break;
+        }
+    }
+
+    /* In case the FID column has also been created as a regular field */
+    if( m_iFIDAsRegularColumnIndex >= 0 )
+    {
+        if( poFeature->GetFID() == OGRNullFID )
+        {
+            if( poFeature->IsFieldSet( m_iFIDAsRegularColumnIndex ) )
+            {
+                poFeature->SetFID(
+                    poFeature->GetFieldAsInteger64(m_iFIDAsRegularColumnIndex));
+            }
+        }
+        else
+        {
+            if( !poFeature->IsFieldSet( m_iFIDAsRegularColumnIndex ) ||
+                poFeature->GetFieldAsInteger64(m_iFIDAsRegularColumnIndex) != poFeature->GetFID() )
+            {
+                CPLError(CE_Failure, CPLE_AppDefined,
+                            "Inconsistent values of FID and field of same name");
+                return OGRERR_FAILURE;
+            }
+        }
+    }
+
+    return OGRERR_NONE;
+}
+
+
 //----------------------------------------------------------------------
 // FeatureGenerateInsertSQL()
 // 
@@ -1095,46 +1177,9 @@ OGRErr OGRGeoPackageTableLayer::ICreateFeature( OGRFeature *poFeature )
     if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
         return OGRERR_FAILURE;
 
-    /* Substitute default values for null Date/DateTime fields as the standard */
-    /* format of SQLite is not the one mandated by GeoPackage */
-    poFeature->FillUnsetWithDefault(FALSE, NULL);
-    int bHasDefaultValue = FALSE;
-    int iField;
-    int nFieldCount = m_poFeatureDefn->GetFieldCount();
-    for( iField = 0; iField < nFieldCount; iField++ )
-    {
-        if( poFeature->IsFieldSet( iField ) )
-            continue;
-        const char* pszDefault = poFeature->GetFieldDefnRef(iField)->GetDefault();
-        if( pszDefault != NULL )
-        {
-            bHasDefaultValue = TRUE;
-            break;
-        }
-    }
-
-    /* In case the FID column has also been created as a regular field */
-    if( m_iFIDAsRegularColumnIndex >= 0 )
-    {
-        if( poFeature->GetFID() == OGRNullFID )
-        {
-            if( poFeature->IsFieldSet( m_iFIDAsRegularColumnIndex ) )
-            {
-                poFeature->SetFID(
-                    poFeature->GetFieldAsInteger64(m_iFIDAsRegularColumnIndex));
-            }
-        }
-        else
-        {
-            if( !poFeature->IsFieldSet( m_iFIDAsRegularColumnIndex ) ||
-                poFeature->GetFieldAsInteger64(m_iFIDAsRegularColumnIndex) != poFeature->GetFID() )
-            {
-                CPLError(CE_Failure, CPLE_AppDefined,
-                            "Inconsistent values of FID and field of same name");
-                return CE_Failure;
-            }
-        }
-    }
+    int bHasDefaultValue;
+    if( FeaturePrepareInsert(poFeature, &bHasDefaultValue) != OGRERR_NONE )
+        return OGRERR_FAILURE;
 
     /* If there's a unset field with a default value, then we must create */
     /* a specific INSERT statement to avoid unset fields to be bound to NULL */
@@ -1203,7 +1248,7 @@ OGRErr OGRGeoPackageTableLayer::ICreateFeature( OGRFeature *poFeature )
     if ( IsGeomFieldSet(poFeature) )
     {
         OGREnvelope oEnv;
-        poFeature->GetGeomFieldRef(0)->getEnvelope(&oEnv);
+        GetGeomFieldEnvelope(poFeature, &oEnv);
         UpdateExtent(&oEnv);
     }
 
@@ -1225,6 +1270,192 @@ OGRErr OGRGeoPackageTableLayer::ICreateFeature( OGRFeature *poFeature )
 }
 
 
+/************************************************************************/
+/*                          ICreateFeatures()                           */
+/*                                                                      */
+/*      Features without FID nor unset field having a default value     */
+/*      are inserted by multi-row INSERT statements. The other ones     */
+/*      go through ICreateFeature().                                    */
+/************************************************************************/
+
+OGRErr OGRGeoPackageTableLayer::ICreateFeatures( OGRFeature **papoFeatures,
+                                                 int nFeatureCount )
+{
+    if( !m_poDS->GetUpdate() )
+    {
+        return OGRERR_FAILURE;
+    }
+
+    if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
+        return OGRERR_FAILURE;
+
+    int i = 0;
+    while( i < nFeatureCount )
+    {
+        /* Collect the run of features that can share the same statement */
+        int nRun = 0;
+        while( i + nRun < nFeatureCount )
+        {
+            OGRFeature* poFeature = papoFeatures[i + nRun];
+            int bHasDefaultValue;
+            if( FeaturePrepareInsert(poFeature, &bHasDefaultValue) != OGRERR_NONE )
+                return OGRERR_FAILURE;
+            if( bHasDefaultValue || poFeature->GetFID() != OGRNullFID )
+                break;
+            nRun ++;
+        }
+
+        if( nRun >= 2 )
+        {
+            if( FeatureInsertRows(papoFeatures + i, nRun) != OGRERR_NONE )
+                return OGRERR_FAILURE;
+            i += nRun;
+        }
+        else
+        {
+            /* Too short a run: insert its features one by one, together */
+            /* with the feature that ended it */
+            int nEnd = MIN(i + nRun + 1, nFeatureCount);
+            for( ; i < nEnd; i++ )
+            {
+                OGRErr eErr = ICreateFeature(papoFeatures[i]);
+                if( eErr != OGRERR_NONE )
+                    return eErr;
+            }
+        }
+    }
+
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                         FeatureInsertRows()                          */
+/*                                                                      */
+/*      Insert features, with all their fields bound and no FID, with   */
+/*      "INSERT INTO ... VALUES (...), (...)" statements.               */
+/************************************************************************/
+
+OGRErr OGRGeoPackageTableLayer::FeatureInsertRows( OGRFeature **papoFeatures,
+                                                   int nFeatureCount )
+{
+    CPLString osCommand = FeatureGenerateInsertSQL(papoFeatures[0], FALSE, TRUE);
+    size_t nValuesPos = osCommand.find(") VALUES ");
+    int nCols = (m_poFeatureDefn->GetGeomFieldCount() ? 1 : 0) +
+                m_poFeatureDefn->GetFieldCount() -
+                ((m_iFIDAsRegularColumnIndex >= 0) ? 1 : 0);
+
+    /* Stay below the default SQLITE_MAX_VARIABLE_NUMBER (999) */
+    int nMaxRows = (nCols > 0) ? MIN(100, 999 / nCols) : 0;
+    /* Multi-row VALUES clauses need SQLite 3.7.11 */
+    if( nValuesPos == std::string::npos || nMaxRows < 2 ||
+        sqlite3_libversion_number() < 3007011 )
+    {
+        for( int i = 0; i < nFeatureCount; i++ )
+        {
+            OGRErr eErr = ICreateFeature(papoFeatures[i]);
+            if( eErr != OGRERR_NONE )
+                return eErr;
+        }
+        return OGRERR_NONE;
+    }
+
+    nValuesPos += strlen(") VALUES ");
+    CPLString osRow = osCommand.substr(nValuesPos);
+    osCommand.resize(nValuesPos);
+
+    sqlite3 *poDb = m_poDS->GetDB();
+    sqlite3_stmt *poStmt = NULL;
+    int nStmtRows = 0;
+    int i = 0;
+    while( i < nFeatureCount )
+    {
+        int nRows = MIN(nMaxRows, nFeatureCount - i);
+
+        /* Prepare a statement for that many rows, unless it is the */
+        /* previous one */
+        if( nRows != nStmtRows )
+        {
+            if( poStmt )
+                sqlite3_finalize(poStmt);
+            poStmt = NULL;
+
+            CPLString osSQL(osCommand);
+            for( int iRow = 0; iRow < nRows; iRow++ )
+            {
+                if( iRow > 0 )
+                    osSQL += ", ";
+                osSQL += osRow;
+            }
+            int err = sqlite3_prepare_v2(poDb, osSQL, -1, &poStmt, NULL);
+            if ( err != SQLITE_OK )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "failed to prepare SQL: %s", osSQL.c_str());
+                if( poStmt )
+                    sqlite3_finalize(poStmt);
+                return OGRERR_FAILURE;
+            }
+            nStmtRows = nRows;
+        }
+
+        /* Bind the values of each row after the ones of the previous row */
+        int nColCount = 1;
+        for( int iRow = 0; iRow < nRows; iRow++ )
+        {
+            if( FeatureBindParameters( papoFeatures[i + iRow], poStmt,
+                                       &nColCount, FALSE, TRUE ) != OGRERR_NONE )
+            {
+                sqlite3_finalize(poStmt);
+                return OGRERR_FAILURE;
+            }
+        }
+
+        int err = sqlite3_step(poStmt);
+        if ( ! (err == SQLITE_OK || err == SQLITE_DONE) )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "failed to execute insert : %s",
+                      sqlite3_errmsg(poDb) ? sqlite3_errmsg(poDb) : "");
+            sqlite3_finalize(poStmt);
+            return OGRERR_FAILURE;
+        }
+        sqlite3_reset(poStmt);
+        sqlite3_clear_bindings(poStmt);
+
+        /* The rows of a statement get consecutive ids, the last one */
+        /* being the last inserted rowid. This holds as the rows have no */
+        /* explicit id, SQLite then giving each of them the largest */
+        /* rowid of the table plus one, and as the GeoPackage triggers */
+        /* do not insert in that table. It would not if the largest */
+        /* rowid reached 2^63-1, SQLite then picking random free rowids. */
+        GIntBig nLastFID = sqlite3_last_insert_rowid(poDb);
+        for( int iRow = 0; iRow < nRows; iRow++ )
+        {
+            OGRFeature* poFeature = papoFeatures[i + iRow];
+
+            /* Update the layer extents with this new object */
+            if ( IsGeomFieldSet(poFeature) )
+            {
+                OGREnvelope oEnv;
+                GetGeomFieldEnvelope(poFeature, &oEnv);
+                UpdateExtent(&oEnv);
+            }
+
+            GIntBig nFID = nLastFID - (nRows - 1) + iRow;
+            poFeature->SetFID(nFID);
+            if( m_iFIDAsRegularColumnIndex >= 0 )
+                poFeature->SetField( m_iFIDAsRegularColumnIndex, nFID );
+        }
+
+        i += nRows;
+    }
+
+    sqlite3_finalize(poStmt);
+
+    return OGRERR_NONE;
+}
+
+
 /************************************************************************/
 /*                          ISetFeature()                                */
 /************************************************************************/
@@ -1348,7 +1579,7 @@ OGRErr OGRGeoPackageTableLayer::ISetFeature( OGRFeature *poFeature )
         if ( IsGeomFieldSet(poFeature) )
         {
             OGREnvelope oEnv;
-            poFeature->GetGeomFieldRef(0)->getEnvelope(&oEnv);
+            GetGeomFieldEnvelope(poFeature, &oEnv);
             UpdateExtent(&oEnv);
         }
     }
@@ -1458,6 +1689,64 @@ OGRFeature* OGRGeoPackageTableLayer::GetNextFeature()
     return poFeature;
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRGeoPackageTableLayer::GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                                  int nMaxFeatures )
+{
+    /* Filtered reads go through GetNextFeature() */
+    if( m_poFilterGeom != NULL || m_poAttrQuery != NULL )
+        return OGRLayer::GetNextFeatureBatch( poBatch, nMaxFeatures );
+
+    poBatch->Reset( m_poFeatureDefn );
+
+    if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
+        return 0;
+
+    CreateSpatialIndexIfNecessary();
+
+    while( poBatch->GetFeatureCount() < nMaxFeatures )
+    {
+        if( m_poQueryStatement == NULL )
+        {
+            ResetStatement();
+            if (m_poQueryStatement == NULL)
+                break;
+        }
+
+        if( bDoStep )
+        {
+            int rc = sqlite3_step( m_poQueryStatement );
+            if( rc != SQLITE_ROW )
+            {
+                if ( rc != SQLITE_DONE )
+                {
+                    sqlite3_reset(m_poQueryStatement);
+                    CPLError( CE_Failure, CPLE_AppDefined,
+                            "In GetNextFeatureBatch(): sqlite3_step() : %s",
+                            sqlite3_errmsg(m_poDS->GetDB()) );
+                }
+
+                ClearStatement();
+                break;
+            }
+        }
+        else
+            bDoStep = TRUE;
+
+        TranslateFeatureBatch( m_poQueryStatement, poBatch );
+        if( m_iFIDAsRegularColumnIndex >= 0 )
+        {
+            poBatch->SetFieldInteger64( m_iFIDAsRegularColumnIndex,
+                poBatch->GetFIDs()[poBatch->GetFeatureCount() - 1] );
+        }
+    }
+
+    return poBatch->GetFeatureCount();
+}
+
 /************************************************************************/
 /*                        GetFeature()                                  */
 /************************************************************************/
@@ -383,18 +383,15 @@ int SQLiteFieldFromOGR(OGRFieldType nType)
 *
 */
 
-GByte* GPkgGeometryFromOGR(const OGRGeometry *poGeometry, int iSrsId, size_t *pszWkb)
+/* Allocate a BLOB and write its header, leaving room for szGeomWkb */
+/* bytes of WKB after it. */
+static GByte* GPkgAllocBlob(OGRBoolean bPoint, OGRBoolean bEmpty, int iDims,
+                            const OGREnvelope3D& oEnv3d, int iSrsId,
+                            size_t szGeomWkb, size_t *pszWkb, size_t *pszHeader)
 {
-    CPLAssert( poGeometry != NULL );
-    
-    GByte *pabyPtr;
     GByte byFlags = 0;
     GByte byEnv = 1;
     OGRwkbByteOrder eByteOrder = (OGRwkbByteOrder)CPL_IS_LSB;
-    OGRErr err;
-    OGRBoolean bPoint = (wkbFlatten(poGeometry->getGeometryType()) == wkbPoint);
-    OGRBoolean bEmpty = poGeometry->IsEmpty();
-    int iDims = poGeometry->getCoordinateDimension();
 
     /* Header has 8 bytes for sure, and optional extra space for bounds */
     size_t szHeader = 2+1+1+4;    
@@ -404,10 +401,11 @@ GByte* GPkgGeometryFromOGR(const OGRGeometry *poGeometry, int iSrsId, size_t *ps
     }
     
     /* Total BLOB size is header + WKB size */
-    size_t szWkb = szHeader + poGeometry->WkbSize();
+    size_t szWkb = szHeader + szGeomWkb;
     GByte *pabyWkb = (GByte *)CPLMalloc(szWkb);
     if (pszWkb)
         *pszWkb = szWkb;
+    *pszHeader = szHeader;
     
     /* Header Magic */
     pabyWkb[0] = 0x47;
@@ -456,32 +454,45 @@ GByte* GPkgGeometryFromOGR(const OGRGeometry *poGeometry, int iSrsId, size_t *ps
     if ( ! bEmpty && ! bPoint )
     {
         double *padPtr = (double*)(pabyWkb+8);
+        padPtr[0] = oEnv3d.MinX;
+        padPtr[1] = oEnv3d.MaxX;
+        padPtr[2] = oEnv3d.MinY;
+        padPtr[3] = oEnv3d.MaxY;
         if ( iDims == 3 )
         {
-            OGREnvelope3D oEnv3d;
-            poGeometry->getEnvelope(&oEnv3d);
-            padPtr[0] = oEnv3d.MinX;
-            padPtr[1] = oEnv3d.MaxX;
-            padPtr[2] = oEnv3d.MinY;
-            padPtr[3] = oEnv3d.MaxY;
             padPtr[4] = oEnv3d.MinZ;
             padPtr[5] = oEnv3d.MaxZ;
         }
-        else
-        {
-            OGREnvelope oEnv;
-            poGeometry->getEnvelope(&oEnv);
-            padPtr[0] = oEnv.MinX;
-            padPtr[1] = oEnv.MaxX;
-            padPtr[2] = oEnv.MinY;
-            padPtr[3] = oEnv.MaxY;
-        }
     }
     
-    pabyPtr = pabyWkb + szHeader;
+    return pabyWkb;
+}
+
+GByte* GPkgGeometryFromOGR(const OGRGeometry *poGeometry, int iSrsId, size_t *pszWkb)
+{
+    CPLAssert( poGeometry != NULL );
+    
+    OGRwkbByteOrder eByteOrder = (OGRwkbByteOrder)CPL_IS_LSB;
+    OGRErr err;
+    OGRBoolean bPoint = (wkbFlatten(poGeometry->getGeometryType()) == wkbPoint);
+    OGRBoolean bEmpty = poGeometry->IsEmpty();
+    int iDims = poGeometry->getCoordinateDimension();
+    size_t szHeader;
+
+    OGREnvelope3D oEnv3d;
+    if ( ! bEmpty && ! bPoint )
+    {
+        if ( iDims == 3 )
+            poGeometry->getEnvelope(&oEnv3d);
+        else
+            poGeometry->getEnvelope((OGREnvelope*)&oEnv3d);
+    }
+
+    GByte *pabyWkb = GPkgAllocBlob(bPoint, bEmpty, iDims, oEnv3d, iSrsId,
+                                   poGeometry->WkbSize(), pszWkb, &szHeader);
     
     /* Use the wkbVariantIso for ISO SQL/MM output (differs for 3d geometry) */
-    err = poGeometry->exportToWkb(eByteOrder, pabyPtr, wkbVariantIso);
+    err = poGeometry->exportToWkb(eByteOrder, pabyWkb + szHeader, wkbVariantIso);
     if ( err != OGRERR_NONE )
     {
         CPLFree(pabyWkb);
@@ -491,6 +502,51 @@ GByte* GPkgGeometryFromOGR(const OGRGeometry *poGeometry, int iSrsId, size_t *ps
     return pabyWkb; 
 }
 
+/* Same as GPkgGeometryFromOGR(), for a geometry kept as WKB: the WKB is */
+/* copied as it is when it already is native ISO WKB. */
+GByte* GPkgGeometryFromLazy(const OGRLazyGeometry *poLazy, int iSrsId, size_t *pszWkb)
+{
+    CPLAssert( poLazy != NULL );
+    
+    OGRwkbByteOrder eByteOrder = (OGRwkbByteOrder)CPL_IS_LSB;
+    OGRBoolean bPoint = (wkbFlatten(poLazy->getGeometryType()) == wkbPoint);
+    OGRBoolean bEmpty = poLazy->IsEmpty();
+    int iDims = poLazy->getCoordinateDimension();
+    size_t szHeader;
+
+    OGREnvelope3D oEnv3d;
+    poLazy->getEnvelope(&oEnv3d);
+
+    GByte *pabyWkb = GPkgAllocBlob(bPoint, bEmpty, iDims, oEnv3d, iSrsId,
+                                   poLazy->WkbSize(), pszWkb, &szHeader);
+
+    if ( poLazy->exportToWkb(eByteOrder, pabyWkb + szHeader, wkbVariantIso) != OGRERR_NONE )
+    {
+        CPLFree(pabyWkb);
+        return NULL;
+    }
+    
+    return pabyWkb; 
+}
+
+/* Same as GPkgGeometryToOGR(), but the WKB is only parsed on demand. */
+/* NULL is returned for the WKB not handled by OGRLazyGeometry. */
+OGRLazyGeometry* GPkgGeometryToLazy(const GByte *pabyGpkg, size_t szGpkg, OGRSpatialReference *poSrs)
+{
+    CPLAssert( pabyGpkg != NULL );
+    
+    GPkgHeader oHeader;
+    
+    /* Read header */
+    if ( szGpkg < 8 || GPkgHeaderFromWKB(pabyGpkg, &oHeader) != OGRERR_NONE ||
+         oHeader.bExtended || szGpkg <= oHeader.szHeader )
+        return NULL;
+
+    return OGRLazyGeometry::CreateFromWkb(pabyGpkg + oHeader.szHeader,
+                                          (int)(szGpkg - oHeader.szHeader),
+                                          poSrs);
+}
+
 
 OGRErr GPkgHeaderFromWKB(const GByte *pabyGpkg, GPkgHeader *poHeader)
 {
@@ -72,7 +72,9 @@ const char*         GPkgFieldFromOGR(OGRFieldType nType, OGRFieldSubType eSubTyp
 OGRwkbGeometryType  GPkgGeometryTypeToWKB(const char *pszGpkgType, int bHasZ);
 
 GByte*              GPkgGeometryFromOGR(const OGRGeometry *poGeometry, int iSrsId, size_t *szWkb);
+GByte*              GPkgGeometryFromLazy(const OGRLazyGeometry *poLazy, int iSrsId, size_t *szWkb);
 OGRGeometry*        GPkgGeometryToOGR(const GByte *pabyGpkg, size_t szGpkg, OGRSpatialReference *poSrs);
+OGRLazyGeometry*    GPkgGeometryToLazy(const GByte *pabyGpkg, size_t szGpkg, OGRSpatialReference *poSrs);
 OGRErr              GPkgEnvelopeToOGR(GByte *pabyGpkg, size_t szGpkg, OGREnvelope *poEnv);
 
 OGRErr              GPkgHeaderFromWKB(const GByte *pabyGpkg, GPkgHeader *poHeader);
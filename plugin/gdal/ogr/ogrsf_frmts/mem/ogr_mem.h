@@ -32,6 +32,7 @@
 #define _OGRMEM_H_INCLUDED
 
 #include "ogrsf_frmts.h"
+#include "ogr_strtree.h"
 
 /************************************************************************/
 /*                             OGRMemLayer                              */
@@ -54,6 +55,19 @@ class OGRMemLayer : public OGRLayer
 
     int                 bHasHoles;
 
+    /* Spatial index of the features, built on the first spatially */
+    /* filtered read and discarded when features are written */
+    OGRSTRTree         *poSpatialIndex;
+    int                 iSpatialIndexGeomField;
+    int                 bCandidatesComputed;
+    int                 bScanSequentially;
+    std::vector<GIntBig> anCandidateFIDs;
+    size_t              iNextCandidate;
+
+    void                GetSpatialFilterCandidates( std::vector<GIntBig>& anFIDs );
+    void                InvalidateSpatialIndex();
+    int                 MatchFilters( OGRFeature *poFeature );
+
   public:
                         OGRMemLayer( const char * pszName,
                                      OGRSpatialReference *poSRS,
@@ -63,6 +63,12 @@ OGRMemLayer::OGRMemLayer( const char * pszName, OGRSpatialReference *poSRSIn,
     bUpdatable = TRUE;
     bAdvertizeUTF8 = FALSE;
     bHasHoles = FALSE;
+
+    poSpatialIndex = NULL;
+    iSpatialIndexGeomField = -1;
+    bCandidatesComputed = FALSE;
+    bScanSequentially = FALSE;
+    iNextCandidate = 0;
 }
 
 /************************************************************************/
@@ -86,6 +92,8 @@ OGRMemLayer::~OGRMemLayer()
     }
     CPLFree( papoFeatures );
 
+    delete poSpatialIndex;
+
     if( poFeatureDefn )
         poFeatureDefn->Release();
 }
@@ -98,6 +106,83 @@ void OGRMemLayer::ResetReading()
 
 {
     iNextReadFID = 0;
+
+    bCandidatesComputed = FALSE;
+    bScanSequentially = FALSE;
+    anCandidateFIDs.resize(0);
+    iNextCandidate = 0;
+}
+
+/************************************************************************/
+/*                       InvalidateSpatialIndex()                       */
+/*                                                                      */
+/*      Discard the spatial index after features have been written.    */
+/*      A read in progress continues with a sequential scan from the    */
+/*      last returned feature.                                          */
+/************************************************************************/
+
+void OGRMemLayer::InvalidateSpatialIndex()
+
+{
+    if( poSpatialIndex == NULL )
+        return;
+
+    delete poSpatialIndex;
+    poSpatialIndex = NULL;
+    iSpatialIndexGeomField = -1;
+
+    if( bCandidatesComputed )
+    {
+        bScanSequentially = TRUE;
+        anCandidateFIDs.resize(0);
+        iNextCandidate = 0;
+    }
+}
+
+/************************************************************************/
+/*                     GetSpatialFilterCandidates()                     */
+/*                                                                      */
+/*      Return the FIDs, in ascending order, of the features whose      */
+/*      geometry envelope intersects the spatial filter envelope,       */
+/*      building the spatial index if needed.                           */
+/************************************************************************/
+
+void OGRMemLayer::GetSpatialFilterCandidates( std::vector<GIntBig>& anFIDs )
+
+{
+    if( poSpatialIndex != NULL && iSpatialIndexGeomField != m_iGeomFieldFilter )
+    {
+        delete poSpatialIndex;
+        poSpatialIndex = NULL;
+    }
+
+    if( poSpatialIndex == NULL )
+    {
+        poSpatialIndex = new OGRSTRTree();
+        iSpatialIndexGeomField = m_iGeomFieldFilter;
+        for( GIntBig i = 0; i < nMaxFeatureCount; i++ )
+        {
+            if( papoFeatures[i] != NULL )
+                poSpatialIndex->AddGeometry(
+                    papoFeatures[i]->GetGeomFieldRef(m_iGeomFieldFilter), i );
+        }
+        poSpatialIndex->Build();
+    }
+
+    poSpatialIndex->Search( m_sFilterEnvelope, anFIDs );
+}
+
+/************************************************************************/
+/*                            MatchFilters()                            */
+/************************************************************************/
+
+int OGRMemLayer::MatchFilters( OGRFeature *poFeature )
+
+{
+    return (m_poFilterGeom == NULL
+            || FilterGeometry( poFeature->GetGeomFieldRef(m_iGeomFieldFilter) ) )
+        && (m_poAttrQuery == NULL
+            || m_poAttrQuery->Evaluate( poFeature ) );
 }
 
 /************************************************************************/
@@ -107,6 +192,38 @@ void OGRMemLayer::ResetReading()
 OGRFeature *OGRMemLayer::GetNextFeature()
 
 {
+/* -------------------------------------------------------------------- */
+/*      With a spatial filter, only visit the features selected by     */
+/*      the spatial index.                                              */
+/* -------------------------------------------------------------------- */
+    if( m_poFilterGeom != NULL && !bScanSequentially )
+    {
+        if( !bCandidatesComputed )
+        {
+            GetSpatialFilterCandidates( anCandidateFIDs );
+            bCandidatesComputed = TRUE;
+            iNextCandidate = 0;
+        }
+
+        while( iNextCandidate < anCandidateFIDs.size() )
+        {
+            GIntBig nFID = anCandidateFIDs[iNextCandidate++];
+            if( nFID < iNextReadFID )
+                continue;
+            iNextReadFID = nFID + 1;
+
+            OGRFeature *poFeature = papoFeatures[nFID];
+            if( poFeature != NULL && MatchFilters( poFeature ) )
+            {
+                m_nFeaturesRead++;
+                return poFeature->Clone();
+            }
+        }
+
+        iNextReadFID = nMaxFeatureCount;
+        return NULL;
+    }
+
     while( iNextReadFID < nMaxFeatureCount )
     {
         OGRFeature *poFeature = papoFeatures[iNextReadFID++];
@@ -114,10 +231,7 @@ OGRFeature *OGRMemLayer::GetNextFeature()
         if( poFeature == NULL )
             continue;
 
-        if( (m_poFilterGeom == NULL
-             || FilterGeometry( poFeature->GetGeomFieldRef(m_iGeomFieldFilter) ) )
-            && (m_poAttrQuery == NULL
-                || m_poAttrQuery->Evaluate( poFeature ) ) )
+        if( MatchFilters( poFeature ) )
         {
             m_nFeaturesRead++;
             return poFeature->Clone();
@@ -212,6 +326,8 @@ OGRErr OGRMemLayer::ISetFeature( OGRFeature *poFeature )
         nMaxFeatureCount = nNewCount;
     }
 
+    InvalidateSpatialIndex();
+
     if( papoFeatures[poFeature->GetFID()] != NULL )
     {
         delete papoFeatures[poFeature->GetFID()];
@@ -292,19 +408,41 @@ OGRErr OGRMemLayer::DeleteFeature( GIntBig nFID )
 /************************************************************************/
 /*                          GetFeatureCount()                           */
 /*                                                                      */
-/*      If a spatial filter is in effect, we turn control over to       */
-/*      the generic counter.  Otherwise we return the total count.      */
-/*      Eventually we should consider implementing a more efficient     */
-/*      way of counting features matching a spatial query.              */
+/*      If a filter is in effect, we count the matching features       */
+/*      in place, looking only at the candidates of the spatial        */
+/*      index if there is a spatial filter.  Otherwise we return the   */
+/*      total count.                                                    */
 /************************************************************************/
 
-GIntBig OGRMemLayer::GetFeatureCount( int bForce )
+GIntBig OGRMemLayer::GetFeatureCount( CPL_UNUSED int bForce )
 
 {
-    if( m_poFilterGeom != NULL || m_poAttrQuery != NULL )
-        return OGRLayer::GetFeatureCount( bForce );
-    else
+    if( m_poFilterGeom == NULL && m_poAttrQuery == NULL )
         return nFeatureCount;
+
+    GIntBig nCount = 0;
+
+    if( m_poFilterGeom != NULL )
+    {
+        std::vector<GIntBig> anFIDs;
+        GetSpatialFilterCandidates( anFIDs );
+        for( size_t i = 0; i < anFIDs.size(); i++ )
+        {
+            OGRFeature *poFeature = papoFeatures[anFIDs[i]];
+            if( poFeature != NULL && MatchFilters( poFeature ) )
+                nCount++;
+        }
+    }
+    else
+    {
+        for( GIntBig i = 0; i < nMaxFeatureCount; i++ )
+        {
+            if( papoFeatures[i] != NULL && MatchFilters( papoFeatures[i] ) )
+                nCount++;
+        }
+    }
+
+    return nCount;
 }
 
 /************************************************************************/
@@ -325,7 +463,7 @@ int OGRMemLayer::TestCapability( const char * pszCap )
         return m_poFilterGeom == NULL && m_poAttrQuery == NULL;
 
     else if( EQUAL(pszCap,OLCFastSpatialFilter) )
-        return FALSE;
+        return TRUE;
 
     else if( EQUAL(pszCap,OLCDeleteFeature) )
         return bUpdatable;
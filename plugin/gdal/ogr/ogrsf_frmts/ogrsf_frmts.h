@@ -84,6 +84,8 @@ class CPL_DLL OGRLayer : public GDALMajorObject
 
     virtual OGRErr      ISetFeature( OGRFeature *poFeature );
     virtual OGRErr      ICreateFeature( OGRFeature *poFeature );
+    virtual OGRErr      ICreateFeatures( OGRFeature **papoFeatures,
+                                         int nFeatureCount );
 
   public:
     OGRLayer();
@@ -103,11 +105,15 @@ class CPL_DLL OGRLayer : public GDALMajorObject
 
     virtual void        ResetReading() = 0;
     virtual OGRFeature *GetNextFeature() = 0;
+    virtual int         GetNextFeatureInto( OGRFeature *poFeature );
+    virtual int         GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                             int nMaxFeatures );
     virtual OGRErr      SetNextByIndex( GIntBig nIndex );
     virtual OGRFeature *GetFeature( GIntBig nFID );
 
     OGRErr      SetFeature( OGRFeature *poFeature );
     OGRErr      CreateFeature( OGRFeature *poFeature );
+    OGRErr      CreateFeatures( OGRFeature **papoFeatures, int nFeatureCount );
 
     virtual OGRErr      DeleteFeature( GIntBig nFID );
 
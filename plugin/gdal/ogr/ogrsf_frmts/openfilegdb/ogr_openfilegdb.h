@@ -75,6 +75,8 @@ class OGROpenFileGDBLayer : public OGRLayer
     int               BuildLayerDefinition();
     int               BuildGeometryColumnGDBv10();
     OGRFeature       *GetCurrentFeature();
+    void              AddCurrentFeatureToSpatialIndex(const OGRField* psField);
+    void              AppendCurrentFeature(OGRFeatureBatch* poBatch);
 
     FileGDBOGRGeometryConverter* m_poGeomConverter;
     
@@ -127,6 +129,8 @@ public:
 
   virtual void        ResetReading();
   virtual OGRFeature* GetNextFeature();
+  virtual int         GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                           int nMaxFeatures );
   virtual OGRFeature* GetFeature( GIntBig nFeatureId );
   virtual OGRErr      SetNextByIndex( GIntBig nIndex );
 
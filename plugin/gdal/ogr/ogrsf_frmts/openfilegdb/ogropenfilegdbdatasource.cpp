@@ -924,12 +924,18 @@ OGRLayer* OGROpenFileGDBDataSource::ExecuteSQL( const char *pszSQLCommand,
         if( oSelect.preparse(pszSQLCommand) != OGRERR_NONE )
             return NULL;
 
+        /* The optimized layers below implement neither GROUP BY, nor */
+        /* LIMIT and OFFSET */
+        const int bHasLimitOrOffset = oSelect.limit >= 0 || oSelect.offset > 0;
+        const int bHasGroupBy = oSelect.group_by_specs > 0;
+
 /* -------------------------------------------------------------------- */
 /*      MIN/MAX/SUM/AVG/COUNT optimization                              */
 /* -------------------------------------------------------------------- */
         if( oSelect.join_count == 0 && oSelect.poOtherSelect == NULL &&
             oSelect.table_count == 1 && oSelect.order_specs == 0 &&
-            oSelect.query_mode != SWQM_DISTINCT_LIST )
+            oSelect.query_mode != SWQM_DISTINCT_LIST && !bHasLimitOrOffset &&
+            !bHasGroupBy && oSelect.where_expr == NULL )
         {
             OGROpenFileGDBLayer* poLayer = 
                 (OGROpenFileGDBLayer*)GetLayerByName( oSelect.table_defs[0].table_name);
@@ -1060,7 +1066,8 @@ OGRLayer* OGROpenFileGDBDataSource::ExecuteSQL( const char *pszSQLCommand,
 /* -------------------------------------------------------------------- */
         if( oSelect.join_count == 0 && oSelect.poOtherSelect == NULL &&
             oSelect.table_count == 1 && oSelect.order_specs == 1 &&
-            oSelect.query_mode != SWQM_DISTINCT_LIST )
+            oSelect.query_mode != SWQM_DISTINCT_LIST && !bHasLimitOrOffset &&
+            !bHasGroupBy )
         {
             OGROpenFileGDBLayer* poLayer = 
                 (OGROpenFileGDBLayer*)GetLayerByName( oSelect.table_defs[0].table_name);
@@ -1242,6 +1242,27 @@ OGRErr OGROpenFileGDBLayer::SetAttributeFilter( const char* pszFilter )
     return eErr;
 }
 
+/***********************************************************************/
+/*                  AddCurrentFeatureToSpatialIndex()                  */
+/***********************************************************************/
+
+void OGROpenFileGDBLayer::AddCurrentFeatureToSpatialIndex(const OGRField* psField)
+{
+    OGREnvelope sFeatureEnvelope;
+    if( m_poLyrTable->GetFeatureExtent(psField,
+                                       &sFeatureEnvelope) )
+    {
+        CPLRectObj sBounds;
+        sBounds.minx = sFeatureEnvelope.MinX;
+        sBounds.miny = sFeatureEnvelope.MinY;
+        sBounds.maxx = sFeatureEnvelope.MaxX;
+        sBounds.maxy = sFeatureEnvelope.MaxY;
+        CPLQuadTreeInsertWithBounds(m_pQuadTree,
+                                    (void*)(size_t)m_poLyrTable->GetCurRow(),
+                                    &sBounds);
+    }
+}
+
 /***********************************************************************/
 /*                         GetCurrentFeature()                         */
 /***********************************************************************/
@@ -1266,21 +1287,7 @@ OGRFeature* OGROpenFileGDBLayer::GetCurrentFeature()
             if( psField != NULL )
             {
                 if( m_eSpatialIndexState == SPI_IN_BUILDING )
-                {
-                    OGREnvelope sFeatureEnvelope;
-                    if( m_poLyrTable->GetFeatureExtent(psField,
-                                                       &sFeatureEnvelope) )
-                    {
-                        CPLRectObj sBounds;
-                        sBounds.minx = sFeatureEnvelope.MinX;
-                        sBounds.miny = sFeatureEnvelope.MinY;
-                        sBounds.maxx = sFeatureEnvelope.MaxX;
-                        sBounds.maxy = sFeatureEnvelope.MaxY;
-                        CPLQuadTreeInsertWithBounds(m_pQuadTree,
-                                                    (void*)(size_t)iRow,
-                                                    &sBounds);
-                    }
-                }
+                    AddCurrentFeatureToSpatialIndex(psField);
 
                 if( m_poFilterGeom != NULL &&
                     m_eSpatialIndexState != SPI_COMPLETED &&
@@ -1438,6 +1445,115 @@ OGRFeature* OGROpenFileGDBLayer::GetNextFeature()
     }
 }
 
+/***********************************************************************/
+/*                        AppendCurrentFeature()                       */
+/*                                                                     */
+/*      Same as GetCurrentFeature(), but appends the feature to a      */
+/*      batch. Only used when there is no spatial filter.              */
+/***********************************************************************/
+
+void OGROpenFileGDBLayer::AppendCurrentFeature(OGRFeatureBatch* poBatch)
+{
+    int iOGRIdx = 0;
+    poBatch->BeginFeature(m_poLyrTable->GetCurRow() + 1);
+    for(int iGDBIdx=0;iGDBIdx<m_poLyrTable->GetFieldCount();iGDBIdx++)
+    {
+        if( iGDBIdx == m_iGeomFieldIdx )
+        {
+            if( m_poFeatureDefn->GetGeomFieldDefn(0)->IsIgnored() )
+            {
+                if( m_eSpatialIndexState == SPI_IN_BUILDING )
+                    m_eSpatialIndexState = SPI_INVALID;
+                continue;
+            }
+
+            const OGRField* psField = m_poLyrTable->GetFieldValue(iGDBIdx);
+            if( psField != NULL )
+            {
+                if( m_eSpatialIndexState == SPI_IN_BUILDING )
+                    AddCurrentFeatureToSpatialIndex(psField);
+
+                OGRGeometry* poGeom = m_poGeomConverter->GetAsGeometry(psField);
+                if( poGeom != NULL )
+                {
+                    OGRwkbGeometryType eFlattenType = wkbFlatten(poGeom->getGeometryType());
+                    if( eFlattenType == wkbPolygon )
+                        poGeom = OGRGeometryFactory::forceToMultiPolygon(poGeom);
+                    else if( eFlattenType == wkbLineString )
+                        poGeom = OGRGeometryFactory::forceToMultiLineString(poGeom);
+                    poBatch->SetGeomField(0, poGeom);
+                    delete poGeom;
+                }
+            }
+        }
+        else
+        {
+            if( !m_poFeatureDefn->GetFieldDefn(iOGRIdx)->IsIgnored() )
+            {
+                const OGRField* psField = m_poLyrTable->GetFieldValue(iGDBIdx);
+                if( psField != NULL )
+                {
+                    if( iGDBIdx == m_iFieldToReadAsBinary )
+                        poBatch->SetFieldString(iOGRIdx, (const char*) psField->Binary.paData);
+                    else
+                        poBatch->SetFieldRaw(iOGRIdx, psField);
+                }
+            }
+            iOGRIdx ++;
+        }
+    }
+
+    if( m_poLyrTable->HasDeletedFeaturesListed() )
+    {
+        poBatch->SetFieldInteger(m_poFeatureDefn->GetFieldCount() - 1,
+                                 m_poLyrTable->IsCurRowDeleted());
+    }
+}
+
+/***********************************************************************/
+/*                        GetNextFeatureBatch()                        */
+/***********************************************************************/
+
+int OGROpenFileGDBLayer::GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                              int nMaxFeatures )
+{
+    /* Filtered reads go through GetNextFeature() */
+    if( m_poFilterGeom != NULL || m_poAttrQuery != NULL ||
+        m_nFilteredFeatureCount >= 0 || m_poIterator != NULL )
+        return OGRLayer::GetNextFeatureBatch(poBatch, nMaxFeatures);
+
+    if( !BuildLayerDefinition() )
+    {
+        poBatch->Reset();
+        return 0;
+    }
+    poBatch->Reset(m_poFeatureDefn);
+    if( m_bEOF )
+        return 0;
+
+    while( poBatch->GetFeatureCount() < nMaxFeatures &&
+           m_iCurFeat != m_poLyrTable->GetTotalRecordCount() )
+    {
+        m_iCurFeat = m_poLyrTable->GetAndSelectNextNonEmptyRow(m_iCurFeat);
+        if( m_iCurFeat < 0 )
+        {
+            m_bEOF = TRUE;
+            break;
+        }
+
+        m_iCurFeat ++;
+        AppendCurrentFeature(poBatch);
+        if( m_eSpatialIndexState == SPI_IN_BUILDING &&
+            m_iCurFeat == m_poLyrTable->GetTotalRecordCount() )
+        {
+            CPLDebug("OpenFileGDB", "SPI_COMPLETED");
+            m_eSpatialIndexState = SPI_COMPLETED;
+        }
+    }
+
+    return poBatch->GetFeatureCount();
+}
+
 /***********************************************************************/
 /*                          GetFeature()                               */
 /***********************************************************************/
@@ -1440,6 +1440,41 @@ OGRErr OGRPGTableLayer::ICreateFeature( OGRFeature *poFeature )
     return eErr;
 }
 
+/************************************************************************/
+/*                          ICreateFeatures()                           */
+/************************************************************************/
+
+OGRErr OGRPGTableLayer::ICreateFeatures( OGRFeature **papoFeatures,
+                                         int nFeatureCount )
+{
+    /* Features written in bulk are sent with COPY, unless PG_USE_COPY is */
+    /* explicitly set to NO */
+    int bForceCopy = FALSE;
+    if( bUseCopy == USE_COPY_UNSET &&
+        CSLTestBoolean( CPLGetConfigOption( "PG_USE_COPY", "YES") ) )
+    {
+        bUseCopy = TRUE;
+        bForceCopy = TRUE;
+    }
+
+    OGRErr eErr = OGRLayer::ICreateFeatures( papoFeatures, nFeatureCount );
+
+    if( bForceCopy )
+    {
+        /* Ending the COPY restores the default insertion mode */
+        if( bCopyActive )
+        {
+            OGRErr eErrEndCopy = poDS->EndCopy();
+            if( eErr == OGRERR_NONE )
+                eErr = eErrEndCopy;
+        }
+        else
+            bUseCopy = USE_COPY_UNSET;
+    }
+
+    return eErr;
+}
+
 /************************************************************************/
 /*                       OGRPGEscapeColumnName( )                       */
 /************************************************************************/
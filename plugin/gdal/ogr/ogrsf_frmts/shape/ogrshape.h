@@ -49,7 +49,12 @@
 /* ==================================================================== */
 OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
                                OGRFeatureDefn * poDefn, int iShape, 
-                               SHPObject *psShape, const char *pszSHPEncoding );
+                               SHPObject *psShape, const char *pszSHPEncoding,
+                               OGRFeature *poFeatureToReuse = NULL );
+void SHPReadOGRFeatureBatch( SHPHandle hSHP, DBFHandle hDBF,
+                             OGRFeatureDefn * poDefn, int iShape,
+                             const char *pszSHPEncoding,
+                             OGRFeatureBatch *poBatch );
 OGRGeometry *SHPReadOGRObject( SHPHandle hSHP, int iShape, SHPObject *psShape );
 OGRFeatureDefn *SHPReadOGRFeatureDefn( const char * pszName,
                                        SHPHandle hSHP, DBFHandle hDBF,
@@ -173,7 +178,9 @@ class OGRShapeLayer : public OGRAbstractProxiedLayer
 
     const char         *GetFullName() { return pszFullName; }
 
-    OGRFeature *        FetchShape(int iShapeId);
+    OGRFeature *        FetchShape(int iShapeId,
+                                   OGRFeature *poFeatureToReuse = NULL);
+    OGRFeature *        ReadNextFeature( OGRFeature *poFeatureToReuse );
     int                 GetFeatureCountWithSpatialFilterOnly();
 
   public:
@@ -188,6 +195,9 @@ class OGRShapeLayer : public OGRAbstractProxiedLayer
 
     void                ResetReading();
     OGRFeature *        GetNextFeature();
+    int                 GetNextFeatureInto( OGRFeature *poFeature );
+    int                 GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                             int nMaxFeatures );
     virtual OGRErr      SetNextByIndex( GIntBig nIndex );
 
     OGRFeature         *GetFeature( GIntBig nFeatureId );
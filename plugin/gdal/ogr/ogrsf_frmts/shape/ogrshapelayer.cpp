@@ -672,7 +672,8 @@ OGRErr OGRShapeLayer::SetNextByIndex( GIntBig nIndex )
 /*      if the shapeid bbox intersects the geometry.                    */
 /************************************************************************/
 
-OGRFeature *OGRShapeLayer::FetchShape(int iShapeId /*, OGREnvelope* psShapeExtent */)
+OGRFeature *OGRShapeLayer::FetchShape(int iShapeId /*, OGREnvelope* psShapeExtent */,
+                                      OGRFeature *poFeatureToReuse)
 
 {
     OGRFeature *poFeature;
@@ -694,7 +695,8 @@ OGRFeature *OGRShapeLayer::FetchShape(int iShapeId /*, OGREnvelope* psShapeExten
             || psShape->nSHPType == SHPT_NULL )
         {
             poFeature = SHPReadOGRFeature( hSHP, hDBF, poFeatureDefn,
-                                           iShapeId, psShape, osEncoding );
+                                           iShapeId, psShape, osEncoding,
+                                           poFeatureToReuse );
         }
         else if( m_sFilterEnvelope.MaxX < psShape->dfXMin 
                  || m_sFilterEnvelope.MaxY < psShape->dfYMin
@@ -711,13 +713,15 @@ OGRFeature *OGRShapeLayer::FetchShape(int iShapeId /*, OGREnvelope* psShapeExten
             psShapeExtent->MaxX = psShape->dfXMax;
             psShapeExtent->MaxY = psShape->dfYMax;*/
             poFeature = SHPReadOGRFeature( hSHP, hDBF, poFeatureDefn,
-                                           iShapeId, psShape, osEncoding );
+                                           iShapeId, psShape, osEncoding,
+                                           poFeatureToReuse );
         }                
     } 
     else 
     {
         poFeature = SHPReadOGRFeature( hSHP, hDBF, poFeatureDefn,
-                                       iShapeId, NULL, osEncoding );
+                                       iShapeId, NULL, osEncoding,
+                                       poFeatureToReuse );
     }    
     
     return poFeature;
@@ -729,6 +733,38 @@ OGRFeature *OGRShapeLayer::FetchShape(int iShapeId /*, OGREnvelope* psShapeExten
 
 OGRFeature *OGRShapeLayer::GetNextFeature()
 
+{
+    return ReadNextFeature( NULL );
+}
+
+/************************************************************************/
+/*                         GetNextFeatureInto()                         */
+/************************************************************************/
+
+int OGRShapeLayer::GetNextFeatureInto( OGRFeature *poFeature )
+
+{
+    if( poFeature->GetDefnRef() != poFeatureDefn )
+        return OGRLayer::GetNextFeatureInto( poFeature );
+
+    if( ReadNextFeature( poFeature ) == NULL )
+    {
+        poFeature->Reset();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                          ReadNextFeature()                           */
+/*                                                                      */
+/*      Read the next feature matching the filters, into               */
+/*      poFeatureToReuse if it is not NULL.                             */
+/************************************************************************/
+
+OGRFeature *OGRShapeLayer::ReadNextFeature( OGRFeature *poFeatureToReuse )
+
 {
     if (!TouchLayer())
         return NULL;
@@ -762,7 +798,8 @@ OGRFeature *OGRShapeLayer::GetNextFeature()
             
             // Check the shape object's geometry, and if it matches
             // any spatial filter, return it.  
-            poFeature = FetchShape((int)panMatchingFIDs[iMatchingFID] /*, &oShapeExtent*/);
+            poFeature = FetchShape((int)panMatchingFIDs[iMatchingFID] /*, &oShapeExtent*/,
+                                   poFeatureToReuse);
             
             iMatchingFID++;
 
@@ -781,10 +818,12 @@ OGRFeature *OGRShapeLayer::GetNextFeature()
                 else if( VSIFEofL(VSI_SHP_GetVSIL(hDBF->fp)) )
                     return NULL; /* There's an I/O error */
                 else
-                    poFeature = FetchShape(iNextShapeId /*, &oShapeExtent */);
+                    poFeature = FetchShape(iNextShapeId /*, &oShapeExtent */,
+                                           poFeatureToReuse);
             }
             else
-                poFeature = FetchShape(iNextShapeId /*, &oShapeExtent */);
+                poFeature = FetchShape(iNextShapeId /*, &oShapeExtent */,
+                                       poFeatureToReuse);
 
             iNextShapeId++;
         }
@@ -805,7 +844,8 @@ OGRFeature *OGRShapeLayer::GetNextFeature()
                 return poFeature;
             }
 
-            delete poFeature;
+            if( poFeature != poFeatureToReuse )
+                delete poFeature;
         }
     }
 }
@@ -1374,6 +1414,49 @@ OGRErr OGRShapeLayer::GetExtent (OGREnvelope *psExtent, int bForce)
     return OGRERR_NONE;
 }
 
+/************************************************************************/
+/*                        GetNextFeatureBatch()                         */
+/************************************************************************/
+
+int OGRShapeLayer::GetNextFeatureBatch( OGRFeatureBatch *poBatch,
+                                        int nMaxFeatures )
+
+{
+    if (!TouchLayer())
+    {
+        poBatch->Reset( poFeatureDefn );
+        return 0;
+    }
+
+    /* Filtered reads go through GetNextFeature() */
+    if( m_poAttrQuery != NULL || m_poFilterGeom != NULL ||
+        panMatchingFIDs != NULL )
+        return OGRLayer::GetNextFeatureBatch( poBatch, nMaxFeatures );
+
+    poBatch->Reset( poFeatureDefn );
+    while( poBatch->GetFeatureCount() < nMaxFeatures &&
+           iNextShapeId < nTotalShapeCount )
+    {
+        if( hDBF )
+        {
+            if( DBFIsRecordDeleted( hDBF, iNextShapeId ) )
+            {
+                iNextShapeId++;
+                continue;
+            }
+            if( VSIFEofL(VSI_SHP_GetVSIL(hDBF->fp)) )
+                break; /* There's an I/O error */
+        }
+
+        SHPReadOGRFeatureBatch( hSHP, hDBF, poFeatureDefn, iNextShapeId,
+                                osEncoding, poBatch );
+        iNextShapeId++;
+        m_nFeaturesRead++;
+    }
+
+    return poBatch->GetFeatureCount();
+}
+
 /************************************************************************/
 /*                           TestCapability()                           */
 /************************************************************************/
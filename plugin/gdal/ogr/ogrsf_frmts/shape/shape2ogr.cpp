@@ -1060,7 +1060,8 @@ OGRFeatureDefn *SHPReadOGRFeatureDefn( const char * pszName,
 
 OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
                                OGRFeatureDefn * poDefn, int iShape,
-                               SHPObject *psShape, const char *pszSHPEncoding )
+                               SHPObject *psShape, const char *pszSHPEncoding,
+                               OGRFeature *poFeatureToReuse )
 
 {
     if( iShape < 0 
@@ -1083,7 +1084,18 @@ OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
         return NULL;
     }
 
-    OGRFeature  *poFeature = new OGRFeature( poDefn );
+/* -------------------------------------------------------------------- */
+/*      Fill the feature passed by the caller, or create a new one.     */
+/* -------------------------------------------------------------------- */
+    OGRFeature  *poFeature;
+
+    if( poFeatureToReuse != NULL )
+    {
+        poFeature = poFeatureToReuse;
+        poFeature->Reset();
+    }
+    else
+        poFeature = new OGRFeature( poDefn );
 
 /* -------------------------------------------------------------------- */
 /*      Fetch geometry from Shapefile to OGRFeature.                    */
@@ -1199,6 +1211,105 @@ OGRFeature *SHPReadOGRFeature( SHPHandle hSHP, DBFHandle hDBF,
     return( poFeature );
 }
 
+/************************************************************************/
+/*                       SHPReadOGRFeatureBatch()                       */
+/*                                                                      */
+/*      Append a shape and its attributes to a feature batch. This is   */
+/*      the same as SHPReadOGRFeature() without the creation of an      */
+/*      OGRFeature. The caller checks that the record is not deleted.   */
+/************************************************************************/
+
+void SHPReadOGRFeatureBatch( SHPHandle hSHP, DBFHandle hDBF,
+                             OGRFeatureDefn * poDefn, int iShape,
+                             const char *pszSHPEncoding,
+                             OGRFeatureBatch *poBatch )
+
+{
+    poBatch->BeginFeature( iShape );
+
+    if( hSHP != NULL && !poDefn->IsGeometryIgnored() )
+    {
+        OGRGeometry* poGeometry = SHPReadOGRObject( hSHP, iShape, NULL );
+        poBatch->SetGeomField( 0, poGeometry );
+        delete poGeometry;
+    }
+
+    for( int iField = 0; iField < poDefn->GetFieldCount(); iField++ )
+    {
+        OGRFieldDefn* poFieldDefn = poDefn->GetFieldDefn(iField);
+        if (poFieldDefn->IsIgnored() )
+            continue;
+
+        switch( poFieldDefn->GetType() )
+        {
+          case OFTString:
+          {
+              const char *pszFieldVal = 
+                  DBFReadStringAttribute( hDBF, iShape, iField );
+              if( pszFieldVal != NULL && pszFieldVal[0] != '\0' )
+              {
+                if( pszSHPEncoding[0] != '\0' )
+                {
+                    char *pszUTF8Field = CPLRecode( pszFieldVal,
+                                                    pszSHPEncoding, CPL_ENC_UTF8);
+                    poBatch->SetFieldString( iField, pszUTF8Field );
+                    CPLFree( pszUTF8Field );
+                }
+                else
+                    poBatch->SetFieldString( iField, pszFieldVal );
+              }
+          }
+          break;
+
+          case OFTInteger:
+          case OFTInteger64:
+          case OFTReal:
+            if( !DBFIsAttributeNULL( hDBF, iShape, iField ) )
+                poBatch->SetFieldFromString( iField,
+                                    DBFReadStringAttribute( hDBF, iShape,
+                                                            iField ) );
+            break;
+
+          case OFTDate:
+          {
+              OGRField sFld;
+              if( DBFIsAttributeNULL( hDBF, iShape, iField ) )
+                  continue;
+
+              const char* pszDateValue = 
+                  DBFReadStringAttribute(hDBF,iShape,iField);
+
+              /* See SHPReadOGRFeature() */
+              if (pszDateValue[0] == '\0')
+                  continue;
+
+              memset( &sFld, 0, sizeof(sFld) );
+
+              if( strlen(pszDateValue) >= 10 &&
+                  pszDateValue[2] == '/' && pszDateValue[5] == '/' )
+              {
+                  sFld.Date.Month = (GByte)atoi(pszDateValue+0);
+                  sFld.Date.Day   = (GByte)atoi(pszDateValue+3);
+                  sFld.Date.Year  = (GInt16)atoi(pszDateValue+6);
+              }
+              else
+              {
+                  int nFullDate = atoi(pszDateValue);
+                  sFld.Date.Year = (GInt16)(nFullDate / 10000);
+                  sFld.Date.Month = (GByte)((nFullDate / 100) % 100);
+                  sFld.Date.Day = (GByte)(nFullDate % 100);
+              }
+
+              poBatch->SetFieldRaw( iField, &sFld );
+          }
+          break;
+
+          default:
+            CPLAssert( FALSE );
+        }
+    }
+}
+
 /************************************************************************/
 /*                             GrowField()                              */
 /************************************************************************/
@@ -2301,8 +2301,10 @@ OGRLayer * OGRWFSDataSource::ExecuteSQL( const char *pszSQLCommand,
                 return poResLayer;
             }
         }
+        /* The server-side join layer does not implement LIMIT and OFFSET */
         else if( bStandardJoinsWFS2 &&
                  psSelectInfo->join_count > 0 &&
+                 psSelectInfo->limit < 0 && psSelectInfo->offset == 0 &&
                  psSelectInfo->poOtherSelect == NULL )
         {
             // Just to make sure everything is valid, but we won't use
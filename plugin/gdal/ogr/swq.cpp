@@ -261,10 +261,15 @@ int swqlex( YYSTYPE *ppNode, swq_parse_context *context )
             nReturn = SWQT_UNION;
         else if( EQUAL(osToken,"ALL") )
             nReturn = SWQT_ALL;
+        else if( EQUAL(osToken,"LIMIT") )
+            nReturn = SWQT_LIMIT;
+        else if( EQUAL(osToken,"OFFSET") )
+            nReturn = SWQT_OFFSET;
+        else if( EQUAL(osToken,"GROUP") )
+            nReturn = SWQT_GROUP;
 
         /* Unhandled by OGR SQL */
-        else if( EQUAL(osToken,"LIMIT") ||
-                 EQUAL(osToken,"OUTER") ||
+        else if( EQUAL(osToken,"OUTER") ||
                  EQUAL(osToken,"INNER") )
             nReturn = SWQT_RESERVED_KEYWORD;
 
@@ -343,34 +348,37 @@ swq_select_summarize( swq_select *select_info,
     
     if( def->distinct_flag )
     {
-        GIntBig  i;
+        int bFound;
 
-        /* This should be implemented with a much more complicated
-           data structure to achieve any sort of efficiency. */
-        for( i = 0; i < summary->count; i++ )
+        if( value == NULL )
         {
-            if( value == NULL )
-            {
-                if (summary->distinct_list[i] == NULL)
-                    break;
-            }
-            else if( summary->distinct_list[i] != NULL &&
-                     strcmp(value,summary->distinct_list[i]) == 0 )
-                break;
+            bFound = summary->distinct_has_null;
+            summary->distinct_has_null = TRUE;
         }
-        
-        if( i == summary->count )
+        else
         {
-            char  **old_list = summary->distinct_list;
-            
-            summary->distinct_list = (char **) 
-                CPLMalloc(sizeof(char *) * (size_t)(summary->count+1));
-            memcpy( summary->distinct_list, old_list, 
-                    sizeof(char *) * (size_t)summary->count );
-            summary->distinct_list[(summary->count)++] = 
-                (value != NULL) ? CPLStrdup( value ) : NULL;
-
-            CPLFree(old_list);
+            if( summary->distinct_set == NULL )
+                summary->distinct_set = CPLHashSetNew( CPLHashSetHashStr,
+                                                       CPLHashSetEqualStr,
+                                                       NULL );
+            bFound = CPLHashSetLookup( summary->distinct_set,
+                                       value ) != NULL;
+        }
+
+        if( !bFound )
+        {
+            /* Grow the list by doubling its capacity */
+            if( (summary->count & (summary->count - 1)) == 0 )
+            {
+                summary->distinct_list = (char **) 
+                    CPLRealloc( summary->distinct_list, sizeof(char *) *
+                                (size_t)MAX(1, summary->count * 2) );
+            }
+
+            char *pszItem = (value != NULL) ? CPLStrdup( value ) : NULL;
+            summary->distinct_list[(summary->count)++] = pszItem;
+            if( pszItem != NULL )
+                CPLHashSetInsert( summary->distinct_set, pszItem );
         }
     }
 
@@ -847,7 +855,10 @@ static const char* apszSQLReservedKeywords[] = {
     "ASC",
     "DESC",
     "UNION",
-    "ALL"
+    "ALL",
+    "LIMIT",
+    "OFFSET",
+    "GROUP"
 };
 
 int swq_is_reserved_keyword(const char* pszStr)
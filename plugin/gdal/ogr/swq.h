@@ -23,6 +23,7 @@
 
 #include "cpl_conv.h"
 #include "cpl_string.h"
+#include "cpl_hash_set.h"
 #include "ogr_core.h"
 
 #if defined(_WIN32) && !defined(_WIN32_WCE)
@@ -242,7 +243,7 @@ CPLErr swq_expr_compile2( const char *where_clause,
 /*
 ** Evaluation related.
 */
-int swq_test_like( const char *input, const char *pattern );
+int swq_test_like( const char *input, const char *pattern, char chEscape );
 
 swq_expr_node *SWQGeneralEvaluator( swq_expr_node *, swq_expr_node **);
 swq_field_type SWQGeneralChecker( swq_expr_node *node, int bAllowMismatchTypeOnFieldComparison );
@@ -257,6 +258,7 @@ const char*    SWQFieldTypeToString( swq_field_type field_type );
 #define SWQM_SUMMARY_RECORD  1
 #define SWQM_RECORDSET       2
 #define SWQM_DISTINCT_LIST   3
+#define SWQM_GROUP_BY        4
 
 typedef enum {
     SWQCF_NONE = 0,
@@ -290,6 +292,8 @@ typedef struct {
     GIntBig     count;
     
     char        **distinct_list; /* items of the list can be NULL */
+    CPLHashSet  *distinct_set;   /* the non NULL items of distinct_list */
+    int         distinct_has_null;
     double      sum;
     double      min;
     double      max;
@@ -331,6 +335,7 @@ public:
 class swq_select
 {
     void        postpreparse();
+    int         IsGroupByField( int table_index, int field_index );
 
 public:
     swq_select();
@@ -362,6 +367,15 @@ public:
     int         order_specs;
     swq_order_def *order_defs;
 
+    /* GROUP BY clause. ascending_flag is not used */
+    void        PushGroupBy( const char* pszTableName, const char *pszFieldName );
+    int         group_by_specs;
+    swq_order_def *group_by_defs;
+
+    /* LIMIT and OFFSET clauses. limit is -1 when there is none */
+    GIntBig     limit;
+    GIntBig     offset;
+
     swq_select *poOtherSelect;
     void        PushUnionAll( swq_select* poOtherSelectIn );
 
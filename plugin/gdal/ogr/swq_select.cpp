@@ -56,6 +56,12 @@ swq_select::swq_select()
     order_specs = 0;
     order_defs = NULL;
 
+    group_by_specs = 0;
+    group_by_defs = NULL;
+
+    limit = -1;
+    offset = 0;
+
     poOtherSelect = NULL;
 }
 
@@ -100,6 +106,10 @@ swq_select::~swq_select()
 
             CPLFree( column_summary[i].distinct_list );
         }
+
+        if( column_summary != NULL 
+            && column_summary[i].distinct_set != NULL )
+            CPLHashSetDestroy( column_summary[i].distinct_set );
     }
 
     CPLFree( column_defs );
@@ -114,6 +124,14 @@ swq_select::~swq_select()
     
     CPLFree( order_defs );
 
+    for( i = 0; i < group_by_specs; i++ )
+    {
+        CPLFree( group_by_defs[i].table_name );
+        CPLFree( group_by_defs[i].field_name );
+    }
+
+    CPLFree( group_by_defs );
+
     for( i = 0; i < join_count; i++ )
     {
         delete join_defs[i].poExpr;
@@ -208,6 +226,8 @@ void swq_select::Dump( FILE *fp )
         fprintf( fp, "  QUERY MODE: RECORDSET\n" );
     else if( query_mode == SWQM_DISTINCT_LIST )
         fprintf( fp, "  QUERY MODE: DISTINCT LIST\n" );
+    else if( query_mode == SWQM_GROUP_BY )
+        fprintf( fp, "  QUERY MODE: GROUP BY\n" );
     else
         fprintf( fp, "  QUERY MODE: %d/unknown\n", query_mode );
 
@@ -296,6 +316,18 @@ void swq_select::Dump( FILE *fp )
         where_expr->Dump( fp, 2 );
     }
 
+/* -------------------------------------------------------------------- */
+/*      Group by                                                        */
+/* -------------------------------------------------------------------- */
+
+    for( i = 0; i < group_by_specs; i++ )
+    {
+        fprintf( fp, "  GROUP BY: %s (%d/%d)\n",
+                 group_by_defs[i].field_name,
+                 group_by_defs[i].table_index,
+                 group_by_defs[i].field_index );
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Order by                                                        */
 /* -------------------------------------------------------------------- */
@@ -311,6 +343,14 @@ void swq_select::Dump( FILE *fp )
         else
             fprintf( fp, " DESC\n" );
     }
+
+/* -------------------------------------------------------------------- */
+/*      Limit and offset                                                */
+/* -------------------------------------------------------------------- */
+    if( limit >= 0 )
+        fprintf( fp, "  LIMIT: " CPL_FRMT_GIB "\n", limit );
+    if( offset > 0 )
+        fprintf( fp, "  OFFSET: " CPL_FRMT_GIB "\n", offset );
 }
 
 /************************************************************************/
@@ -419,6 +459,12 @@ char* swq_select::Unparse()
         CPLFree(pszTmp);
     }
 
+    for( i = 0; i < group_by_specs; i++ )
+    {
+        osSelect += (i == 0) ? " GROUP BY " : ", ";
+        osSelect += swq_expr_node::QuoteIfNecessary(group_by_defs[i].field_name, '"');
+    }
+
     for( i = 0; i < order_specs; i++ )
     {
         osSelect += " ORDER BY ";
@@ -427,6 +473,11 @@ char* swq_select::Unparse()
             osSelect += " DESC";
     }
 
+    if( limit >= 0 )
+        osSelect += CPLSPrintf(" LIMIT " CPL_FRMT_GIB, limit);
+    if( offset > 0 )
+        osSelect += CPLSPrintf(" OFFSET " CPL_FRMT_GIB, offset);
+
     return CPLStrdup(osSelect);
 }
 
@@ -755,6 +806,24 @@ void swq_select::PushOrderBy( const char* pszTableName, const char *pszFieldName
     order_defs[order_specs-1].ascending_flag = bAscending;
 }
 
+/************************************************************************/
+/*                            PushGroupBy()                             */
+/************************************************************************/
+
+void swq_select::PushGroupBy( const char* pszTableName, const char *pszFieldName )
+
+{
+    group_by_specs++;
+    group_by_defs = (swq_order_def *) 
+        CPLRealloc( group_by_defs, sizeof(swq_order_def) * group_by_specs );
+
+    group_by_defs[group_by_specs-1].table_name = CPLStrdup(pszTableName ? pszTableName : "");
+    group_by_defs[group_by_specs-1].field_name = CPLStrdup(pszFieldName);
+    group_by_defs[group_by_specs-1].table_index = -1;
+    group_by_defs[group_by_specs-1].field_index = -1;
+    group_by_defs[group_by_specs-1].ascending_flag = TRUE;
+}
+
 /************************************************************************/
 /*                              PushJoin()                              */
 /************************************************************************/
@@ -1010,6 +1079,22 @@ static int CheckCompatibleJoinExpr( swq_expr_node* poExpr,
     return FALSE;
 }
 
+/************************************************************************/
+/*                           IsGroupByField()                           */
+/************************************************************************/
+
+int swq_select::IsGroupByField( int table_index, int field_index )
+
+{
+    for( int i = 0; i < group_by_specs; i++ )
+    {
+        if( group_by_defs[i].table_index == table_index &&
+            group_by_defs[i].field_index == field_index )
+            return TRUE;
+    }
+    return FALSE;
+}
+
 /************************************************************************/
 /*                               parse()                                */
 /*                                                                      */
@@ -1091,6 +1176,50 @@ CPLErr swq_select::parse( swq_field_list *field_list,
         }
     }
 
+/* -------------------------------------------------------------------- */
+/*      Process column names in GROUP BY specs.                         */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < group_by_specs; i++ )
+    {
+        swq_order_def *def = group_by_defs + i;
+
+        /* identify field */
+        swq_field_type field_type;
+        def->field_index = swq_identify_field( def->table_name,
+                                               def->field_name, field_list,
+                                               &field_type, &(def->table_index) );
+        if( def->field_index == -1 )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined, 
+                      "Unrecognised field name %s in GROUP BY.", 
+                      def->table_name[0] ? CPLSPrintf("%s.%s", def->table_name, def->field_name) : def->field_name );
+            return CE_Failure;
+        }
+
+        if( def->table_index != 0 )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Cannot use field '%s' of a secondary table in a GROUP BY clause",
+                      def->field_name );
+            return CE_Failure;
+        }
+
+        if( field_type == SWQ_GEOMETRY )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Cannot use geometry field '%s' in a GROUP BY clause",
+                      def->field_name );
+            return CE_Failure;
+        }
+    }
+
+    if( group_by_specs > 0 && query_mode == SWQM_DISTINCT_LIST )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "SELECT DISTINCT not supported with GROUP BY." );
+        return CE_Failure;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Check if we are producing a one row summary result or a set     */
 /*      of records.  Generate an error if we get conflicting            */
@@ -1151,6 +1280,10 @@ CPLErr swq_select::parse( swq_field_list *field_list,
                 this_indicator = SWQM_RECORDSET;
         }
 
+        /* With GROUP BY, fields and aggregates can be mixed */
+        if( group_by_specs > 0 && this_indicator != -1 )
+            this_indicator = SWQM_GROUP_BY;
+
         if( this_indicator != query_mode
              && this_indicator != -1
             && query_mode != 0 )
@@ -1218,6 +1351,61 @@ CPLErr swq_select::parse( swq_field_list *field_list,
         }
     }
 
+/* -------------------------------------------------------------------- */
+/*      With GROUP BY, the other fields can only be used through        */
+/*      aggregate functions.                                            */
+/* -------------------------------------------------------------------- */
+    if( query_mode == SWQM_GROUP_BY )
+    {
+        for( i = 0; i < result_columns; i++ )
+        {
+            swq_col_def *def = column_defs + i;
+
+            if( def->col_func == SWQCF_NONE &&
+                !IsGroupByField( def->table_index, def->field_index ) )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Field '%s' must appear in the GROUP BY clause or be used in an aggregate function.",
+                          def->field_name );
+                return CE_Failure;
+            }
+
+            if( def->col_func != SWQCF_NONE && def->distinct_flag )
+            {
+                CPLError( CE_Failure, CPLE_NotSupported,
+                          "COUNT(DISTINCT) not supported with GROUP BY." );
+                return CE_Failure;
+            }
+
+            if( def->col_func == SWQCF_CUSTOM )
+            {
+                CPLError( CE_Failure, CPLE_NotSupported,
+                          "Custom field functions not supported with GROUP BY." );
+                return CE_Failure;
+            }
+
+            if( def->col_func != SWQCF_NONE && def->table_index > 0 )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Cannot use field '%s' of a secondary table in an aggregate function with GROUP BY",
+                          def->field_name );
+                return CE_Failure;
+            }
+        }
+
+        for( i = 0; i < order_specs; i++ )
+        {
+            if( !IsGroupByField( order_defs[i].table_index,
+                                 order_defs[i].field_index ) )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Field '%s' of the ORDER BY clause must appear in the GROUP BY clause.",
+                          order_defs[i].field_name );
+                return CE_Failure;
+            }
+        }
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Post process the where clause, subbing in field indexes and     */
 /*      doing final validation.                                         */
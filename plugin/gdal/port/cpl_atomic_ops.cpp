@@ -110,3 +110,55 @@ int CPLAtomicAdd(volatile int* ptr, int increment)
 }
 
 #endif
+
+/************************************************************************/
+/*                           CPLAtomicAdd64()                           */
+/************************************************************************/
+
+#if defined(__MACH__) && defined(__APPLE__)
+
+GIntBig CPLAtomicAdd64(volatile GIntBig* ptr, GIntBig increment)
+{
+  return OSAtomicAdd64(increment, (volatile int64_t*)(ptr));
+}
+
+#elif defined(_MSC_VER) && defined(_M_X64)
+
+GIntBig CPLAtomicAdd64(volatile GIntBig* ptr, GIntBig increment)
+{
+  return InterlockedExchangeAdd64((volatile LONGLONG*)(ptr), (LONGLONG)(increment)) + increment;
+}
+
+#elif defined(__GNUC__) && defined(__x86_64__)
+
+GIntBig CPLAtomicAdd64(volatile GIntBig* ptr, GIntBig increment)
+{
+  GIntBig temp = increment;
+  __asm__ __volatile__("lock; xaddq %0,%1"
+                       : "+r" (temp), "+m" (*ptr)
+                       : : "memory");
+  return temp + increment;
+}
+
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+
+GIntBig CPLAtomicAdd64(volatile GIntBig* ptr, GIntBig increment)
+{
+  return __sync_add_and_fetch(ptr, increment);
+}
+
+#else
+
+#include "cpl_multiproc.h"
+
+static CPLMutex *hAtomicOp64Mutex = NULL;
+
+/* Slow, but safe, implemenation using a mutex */
+GIntBig CPLAtomicAdd64(volatile GIntBig* ptr, GIntBig increment)
+{
+    CPLMutexHolder oMutex(&hAtomicOp64Mutex);
+    (*ptr) += increment;
+    return *ptr;
+}
+
+#endif
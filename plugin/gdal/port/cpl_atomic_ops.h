@@ -60,6 +60,24 @@ CPL_C_START
   */
 int CPL_DLL CPLAtomicAdd(volatile int* ptr, int increment);
 
+/** Add a value to a pointed 64-bit integer in a thread and SMP-safe way
+  * and return the resulting value of the operation.
+  *
+  * This is the 64-bit counterpart of CPLAtomicAdd(), for counters that
+  * may overflow 32 bits such as byte counts.
+  * The variables for this function must be aligned on a 64-bit boundary.
+  *
+  * An efficient implementation exists on MacOSX, MS Windows x64, x86_64
+  * with GCC and platforms where GCC provides 8-byte atomic builtins.
+  * Elsewhere the atomicity is done with a mutex.
+  *
+  * @param ptr a pointer to a 64-bit integer to increment
+  * @param increment the amount to add to the pointed integer
+  * @return the pointed value AFTER the result of the addition
+  * @since GDAL 2.0
+  */
+GIntBig CPL_DLL CPLAtomicAdd64(volatile GIntBig* ptr, GIntBig increment);
+
 /** Increment of 1 the pointed integer in a thread and SMP-safe way
   * and return the resulting value of the operation.
   *
@@ -849,6 +849,7 @@ extern int ZEXPORT cpl_zipOpenNewFileInZip3 (
     zi->ci.stream.next_out = zi->ci.buffered_data;
     zi->ci.stream.total_in = 0;
     zi->ci.stream.total_out = 0;
+    zi->ci.stream.data_type = Z_BINARY;
 
     if ((err==ZIP_OK) && (zi->ci.method == Z_DEFLATED) && (!zi->ci.raw))
     {
@@ -1212,13 +1213,49 @@ extern int ZEXPORT cpl_zipClose (
 /************************************************************************/
 
 #include "cpl_minizip_unzip.h"
+#include "cpl_vsi_virtual.h"
 
 typedef struct
 {
     zipFile   hZip;
     char    **papszFilenames;
+
+    /* Multi-threaded compression of the current file, written raw */
+    VSIVirtualHandle *poDeflateHandle;
+    uLong     nCRC;
+    uLong     nUncompressedSize;
 } CPLZip;
 
+/************************************************************************/
+/*                         CPLZipRawWriteHandle                         */
+/*                                                                      */
+/*      Forwards already deflated data to the current file of a zip     */
+/*      opened in raw mode.                                             */
+/************************************************************************/
+
+class CPLZipRawWriteHandle : public VSIVirtualHandle
+{
+    zipFile   hZip;
+    vsi_l_offset nCurOffset;
+
+  public:
+    CPLZipRawWriteHandle( zipFile hZipIn ) : hZip(hZipIn), nCurOffset(0) {}
+
+    virtual int       Seek( vsi_l_offset, int ) { return -1; }
+    virtual vsi_l_offset Tell() { return nCurOffset; }
+    virtual size_t    Read( void *, size_t, size_t ) { return 0; }
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb )
+    {
+        if( cpl_zipWriteInFileInZip( hZip, pBuffer,
+                                     (unsigned int)(nSize * nMemb) ) != ZIP_OK )
+            return 0;
+        nCurOffset += nSize * nMemb;
+        return nMemb;
+    }
+    virtual int       Eof() { return 1; }
+    virtual int       Close() { return 0; }
+};
+
 /************************************************************************/
 /*                            CPLCreateZip()                            */
 /************************************************************************/
@@ -1263,6 +1300,9 @@ void *CPLCreateZip( const char *pszZipFilename, char **papszOptions )
     CPLZip* psZip = (CPLZip*)CPLMalloc(sizeof(CPLZip));
     psZip->hZip = hZip;
     psZip->papszFilenames = papszFilenames;
+    psZip->poDeflateHandle = NULL;
+    psZip->nCRC = 0;
+    psZip->nUncompressedSize = 0;
     return psZip;
 }
 
@@ -1282,6 +1322,9 @@ CPLErr CPLCreateFileInZip( void *hZip, const char *pszFilename,
     if( psZip == NULL )
         return CE_Failure;
 
+    if( psZip->poDeflateHandle != NULL )
+        CPLCloseFileInZip( hZip );
+
     if( CSLFindString(psZip->papszFilenames, pszFilename ) >= 0)
     {
         CPLError(CE_Failure, CPLE_AppDefined,
@@ -1290,18 +1333,34 @@ CPLErr CPLCreateFileInZip( void *hZip, const char *pszFilename,
     }
 
     int bCompressed = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "COMPRESSED", "TRUE"));
+    int nThreads = atoi(CSLFetchNameValueDef(papszOptions, "NUM_THREADS", "1"));
+    size_t nChunkSize = (size_t)
+        CPLAtoGIntBig(CSLFetchNameValueDef(papszOptions, "CHUNK_SIZE", "1048576"));
+
+    /* In multi-threaded mode, the file is opened raw, and the deflated */
+    /* stream is produced by VSICreateGZipWritable() */
+    int bRaw = bCompressed && nThreads > 1;
 
-    nErr = cpl_zipOpenNewFileInZip( psZip->hZip, pszFilename, NULL, 
-                                    NULL, 0, NULL, 0, "", 
-                                    bCompressed ? Z_DEFLATED : 0, bCompressed ? Z_DEFAULT_COMPRESSION : 0 );
+    nErr = cpl_zipOpenNewFileInZip2( psZip->hZip, pszFilename, NULL, 
+                                     NULL, 0, NULL, 0, "", 
+                                     bCompressed ? Z_DEFLATED : 0, bCompressed ? Z_DEFAULT_COMPRESSION : 0,
+                                     bRaw );
 
     if( nErr != ZIP_OK )
         return CE_Failure;
-    else
+
+    if( bRaw )
     {
-        psZip->papszFilenames = CSLAddString(psZip->papszFilenames, pszFilename);
-        return CE_None;
+        psZip->poDeflateHandle =
+            VSICreateGZipWritable( new CPLZipRawWriteHandle(psZip->hZip),
+                                   CPL_DEFLATE_TYPE_RAW_DEFLATE, TRUE,
+                                   nThreads, nChunkSize );
+        psZip->nCRC = crc32(0L, Z_NULL, 0);
+        psZip->nUncompressedSize = 0;
     }
+
+    psZip->papszFilenames = CSLAddString(psZip->papszFilenames, pszFilename);
+    return CE_None;
 }
 
 /************************************************************************/
@@ -1317,6 +1376,17 @@ CPLErr CPLWriteFileInZip( void *hZip, const void *pBuffer, int nBufferSize )
     if( psZip == NULL )
         return CE_Failure;
 
+    if( psZip->poDeflateHandle != NULL )
+    {
+        psZip->nCRC = crc32(psZip->nCRC, (const Bytef*)pBuffer,
+                            (uInt)nBufferSize);
+        psZip->nUncompressedSize += (uLong)nBufferSize;
+        if( psZip->poDeflateHandle->Write(pBuffer, 1, nBufferSize) !=
+                                                        (size_t)nBufferSize )
+            return CE_Failure;
+        return CE_None;
+    }
+
     nErr = cpl_zipWriteInFileInZip( psZip->hZip, pBuffer, 
                                     (unsigned int) nBufferSize );
 
@@ -1339,7 +1409,20 @@ CPLErr CPLCloseFileInZip( void *hZip )
     if( psZip == NULL )
         return CE_Failure;
 
-    nErr = cpl_zipCloseFileInZip( psZip->hZip );
+    if( psZip->poDeflateHandle != NULL )
+    {
+        int nRet = psZip->poDeflateHandle->Close();
+        delete psZip->poDeflateHandle;
+        psZip->poDeflateHandle = NULL;
+
+        nErr = cpl_zipCloseFileInZipRaw( psZip->hZip,
+                                         psZip->nUncompressedSize,
+                                         psZip->nCRC );
+        if( nRet != 0 )
+            return CE_Failure;
+    }
+    else
+        nErr = cpl_zipCloseFileInZip( psZip->hZip );
 
     if( nErr != ZIP_OK )
         return CE_Failure;
@@ -1360,6 +1443,9 @@ CPLErr CPLCloseZip( void *hZip )
     if( psZip == NULL )
         return CE_Failure;
 
+    if( psZip->poDeflateHandle != NULL )
+        CPLCloseFileInZip( hZip );
+
     nErr = cpl_zipClose(psZip->hZip, NULL);
 
     psZip->hZip = NULL;
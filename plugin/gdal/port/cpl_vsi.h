@@ -143,6 +143,7 @@ vsi_l_offset CPL_DLL VSIFTellL( VSILFILE * );
 void CPL_DLL    VSIRewindL( VSILFILE * );
 size_t CPL_DLL  VSIFReadL( void *, size_t, size_t, VSILFILE * );
 int CPL_DLL     VSIFReadMultiRangeL( int nRanges, void ** ppData, const vsi_l_offset* panOffsets, const size_t* panSizes, VSILFILE * );
+size_t CPL_DLL  VSIFReadAtL( VSILFILE *, vsi_l_offset nOffset, void* pBuffer, size_t nSize );
 size_t CPL_DLL  VSIFWriteL( const void *, size_t, size_t, VSILFILE * );
 int CPL_DLL     VSIFEofL( VSILFILE * );
 int CPL_DLL     VSIFTruncateL( VSILFILE *, vsi_l_offset );
@@ -150,7 +151,21 @@ int CPL_DLL     VSIFFlushL( VSILFILE * );
 int CPL_DLL     VSIFPrintfL( VSILFILE *, const char *, ... ) CPL_PRINT_FUNC_FORMAT(2, 3);
 int CPL_DLL     VSIFPutcL( int, VSILFILE * );
 
-int CPL_DLL     VSIIngestFile( VSILFILE* fp,
+/** Opaque type for an asynchronous read request. See VSIFReadAsyncL() */
+typedef struct VSIAsyncReadRequest VSIAsyncReadRequest;
+/** Completion callback of an asynchronous read request */
+typedef void (*VSIAsyncReadCallback)( VSIAsyncReadRequest* psRequest, void* pUserData );
+
+VSIAsyncReadRequest CPL_DLL *VSIFReadAsyncL( VSILFILE *, vsi_l_offset nOffset,
+                                             void* pBuffer, size_t nSize,
+                                             VSIAsyncReadCallback pfnCallback,
+                                             void* pUserData );
+int CPL_DLL     VSIAsyncReadIsComplete( VSIAsyncReadRequest* psRequest );
+void CPL_DLL    VSIAsyncReadWait( VSIAsyncReadRequest* psRequest );
+size_t CPL_DLL  VSIAsyncReadGetResult( VSIAsyncReadRequest* psRequest );
+void CPL_DLL    VSIAsyncReadFree( VSIAsyncReadRequest* psRequest );
+
+int CPL_DLL     VSIIngestFile(VSILFILE* fp,
                                const char* pszFilename,
                                GByte** ppabyRet,
                                vsi_l_offset* pnSize,
@@ -238,6 +253,13 @@ VSILFILE CPL_DLL *VSIFileFromMemBuffer( const char *pszFilename,
                                     GByte *pabyData, 
                                     vsi_l_offset nDataLength,
                                     int bTakeOwnership );
+/** Function releasing a buffer registered with VSIFileFromMemBufferEx() */
+typedef void (*VSIMemBufferReleaseFunc)( GByte* pabyData, void* pUserData );
+VSILFILE CPL_DLL *VSIFileFromMemBufferEx( const char *pszFilename,
+                                          GByte *pabyData,
+                                          vsi_l_offset nDataLength,
+                                          VSIMemBufferReleaseFunc pfnRelease,
+                                          void *pReleaseUserData );
 GByte CPL_DLL *VSIGetMemFileBuffer( const char *pszFilename, 
                                     vsi_l_offset *pnDataLength, 
                                     int bUnlinkAndSeize );
@@ -245,6 +267,42 @@ GByte CPL_DLL *VSIGetMemFileBuffer( const char *pszFilename,
 typedef size_t (*VSIWriteFunction)(const void* ptr, size_t size, size_t nmemb, FILE* stream);
 void CPL_DLL VSIStdoutSetRedirection( VSIWriteFunction pFct, FILE* stream );
 
+/* ==================================================================== */
+/*      I/O statistics.                                                 */
+/* ==================================================================== */
+
+/** Number of buckets of the latency histograms of VSIIOStats. Bucket i
+ * counts the operations that took less than 2^i microseconds (and at least
+ * 2^(i-1)), the last bucket counting all slower operations. */
+#define VSI_IO_STATS_LATENCY_BUCKETS  24
+
+/** Cumulated I/O statistics of a virtual file system handler.
+ * See VSIGetIOStats() */
+typedef struct
+{
+    GIntBig     nOpens;
+    GIntBig     nOpenFailures;
+    GIntBig     nStats;
+    GIntBig     nReads;
+    GIntBig     nBytesRead;
+    GIntBig     nMultiRangeReads;
+    GIntBig     nRangesRead;
+    GIntBig     nAsyncReads;
+    GIntBig     nWrites;
+    GIntBig     nBytesWritten;
+    GIntBig     nSeeks;
+    GIntBig     anOpenLatency[VSI_IO_STATS_LATENCY_BUCKETS];
+    GIntBig     anReadLatency[VSI_IO_STATS_LATENCY_BUCKETS];
+    GIntBig     anWriteLatency[VSI_IO_STATS_LATENCY_BUCKETS];
+} VSIIOStats;
+
+void CPL_DLL    VSISetIOStatsEnabled( int bEnabled );
+int CPL_DLL     VSIIsIOStatsEnabled( void );
+int CPL_DLL     VSIGetIOStats( const char* pszPrefix, VSIIOStats* psStats );
+char CPL_DLL  **VSIGetIOStatsPrefixes( void );
+void CPL_DLL    VSIResetIOStats( void );
+char CPL_DLL   *VSIGetIOStatsAsJSON( void );
+
 /* ==================================================================== */
 /*      Time quering.                                                   */
 /* ==================================================================== */
@@ -36,8 +36,10 @@
 #include "cpl_vsi_virtual.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
+#include "cpl_atomic_ops.h"
 #include <time.h>
 #include <map>
+#include <algorithm>
 
 #if defined(WIN32CE)
 #  include <wce_errno.h>
@@ -49,16 +51,19 @@ CPL_CVSID("$Id: cpl_vsi_mem.cpp 28976 2015-04-22 21:58:51Z rouault $");
 /*
 ** Notes on Multithreading:
 **
-** VSIMemFilesystemHandler: This class maintains a mutex to protect
-** access and update of the oFileList array which has all the "files" in 
-** the memory filesystem area.  It is expected that multiple threads would
-** want to create and read different files at the same time and so might
-** collide access oFileList without the mutex.
+** VSIMemFilesystemHandler: The "files" of the memory filesystem area are
+** spread over VSIMEM_SHARD_COUNT shards according to a hash of their name.
+** Each shard has its own mutex protecting its file list, so that threads
+** creating, opening and deleting different files rarely wait for each
+** other.  ReadDir() locks the shards one at a time.  Rename(), which may
+** move files between shards, locks all the shards, always in ascending
+** order.
 **
-** VSIMemFile: In theory we could allow different threads to update the
-** the same memory file, but for simplicity we restrict to single writer,
-** multiple reader as an expectation on the application code (not enforced
-** here), which means we don't need to do any protection of this class.
+** VSIMemFile: Each file has a mutex protecting its content and length, so
+** that several threads may read and write the same memory file through
+** different handles.  The reference count is updated with atomic
+** operations, and a file found in a shard is referenced by the shard, so
+** it cannot be destroyed while the shard mutex is held.
 **
 ** VSIMemHandle: This is essentially a "current location" representing
 ** on accessor to a file, and is inherently intended only to be used in 
@@ -69,8 +74,14 @@ CPL_CVSID("$Id: cpl_vsi_mem.cpp 28976 2015-04-22 21:58:51Z rouault $");
 ** Multiple threads accessing the memory filesystem are ok as long as
 **  1) A given VSIMemHandle (ie. FILE * at app level) isn't used by multiple 
 **     threads at once. 
-**  2) A given memory file isn't accessed by more than one thread unless
-**     all threads are just reading.
+**  2) A buffer obtained with VSIGetMemFileBuffer() isn't used while other
+**     threads write to the same file, as it is not covered by the file
+**     mutex.
+**
+** A given memory file may otherwise be read and written by several threads
+** at once through different handles: each Read(), Write() or Truncate()
+** call runs under the file mutex, and is thus atomic, but the order of
+** the calls of different threads is not defined.
 */ 
 
 /************************************************************************/
@@ -83,7 +94,7 @@ class VSIMemFile
 {
 public:
     CPLString     osFilename;
-    int           nRefCount;
+    volatile int  nRefCount;
 
     int           bIsDirectory;
 
@@ -94,9 +105,19 @@ public:
 
     time_t        mTime;
 
+    /* Set for the buffers registered with VSIFileFromMemBufferEx() */
+    VSIMemBufferReleaseFunc pfnRelease;
+    void         *pReleaseUserData;
+
+    /* Protects pabyData, nLength, nAllocLength and mTime */
+    CPLMutex     *hMutex;
+
                   VSIMemFile();
     virtual       ~VSIMemFile();
 
+    void          Reference() { CPLAtomicInc(&nRefCount); }
+    void          Release() { if( CPLAtomicDec(&nRefCount) == 0 ) delete this; }
+
     bool          SetLength( vsi_l_offset nNewSize );
 };
 
@@ -121,6 +142,7 @@ class VSIMemHandle : public VSIVirtualHandle
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
     virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    ReadAt( vsi_l_offset nOffset, void *pBuffer, size_t nSize );
     virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
     virtual int       Eof();
     virtual int       Close();
@@ -133,11 +155,19 @@ class VSIMemHandle : public VSIVirtualHandle
 /* ==================================================================== */
 /************************************************************************/
 
-class VSIMemFilesystemHandler : public VSIFilesystemHandler 
+#define VSIMEM_SHARD_COUNT 64
+
+class VSIMemShard
 {
 public:
     std::map<CPLString,VSIMemFile*>   oFileList;
     CPLMutex        *hMutex;
+};
+
+class VSIMemFilesystemHandler : public VSIFilesystemHandler 
+{
+public:
+    VSIMemShard      aoShards[VSIMEM_SHARD_COUNT];
 
                      VSIMemFilesystemHandler();
     virtual          ~VSIMemFilesystemHandler();
@@ -153,6 +183,11 @@ public:
 
     static  void     NormalizePath( CPLString & );
 
+    VSIMemShard     &GetShard( const CPLString& osFilename );
+    void             LockAllShards();
+    void             UnlockAllShards();
+
+    /* The mutex of the shard of the file must be held */
     int              Unlink_unlocked( const char *pszFilename );
 };
 
@@ -176,6 +211,11 @@ VSIMemFile::VSIMemFile()
     nLength = 0;
     nAllocLength = 0;
     time(&mTime);
+    pfnRelease = NULL;
+    pReleaseUserData = NULL;
+    hMutex = CPLCreateMutex();
+    if( hMutex != NULL )
+        CPLReleaseMutex( hMutex );
 }
 
 /************************************************************************/
@@ -189,12 +229,19 @@ VSIMemFile::~VSIMemFile()
         CPLDebug( "VSIMemFile", "Memory file %s deleted with %d references.",
                   osFilename.c_str(), nRefCount );
 
-    if( bOwnData && pabyData )
+    if( pfnRelease != NULL )
+        pfnRelease( pabyData, pReleaseUserData );
+    else if( bOwnData && pabyData )
         CPLFree( pabyData );
+
+    if( hMutex != NULL )
+        CPLDestroyMutex( hMutex );
 }
 
 /************************************************************************/
 /*                             SetLength()                              */
+/*                                                                      */
+/*      The mutex of the file must be held.                             */
 /************************************************************************/
 
 bool VSIMemFile::SetLength( vsi_l_offset nNewLength )
@@ -258,8 +305,7 @@ bool VSIMemFile::SetLength( vsi_l_offset nNewLength )
 int VSIMemHandle::Close()
 
 {
-    if( --(poFile->nRefCount) == 0 )
-        delete poFile;
+    poFile->Release();
 
     poFile = NULL;
 
@@ -273,6 +319,8 @@ int VSIMemHandle::Close()
 int VSIMemHandle::Seek( vsi_l_offset nOffset, int nWhence )
 
 {
+    CPLMutexHolder oHolder( poFile->hMutex );
+
     bExtendFileAtNextWrite = FALSE;
     if( nWhence == SEEK_CUR )
         this->nOffset += nOffset;
@@ -327,6 +375,8 @@ vsi_l_offset VSIMemHandle::Tell()
 size_t VSIMemHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
 
 {
+    CPLMutexHolder oHolder( poFile->hMutex );
+
     // FIXME: Integer overflow check should be placed here:
     size_t nBytesToRead = nSize * nCount; 
 
@@ -349,6 +399,29 @@ size_t VSIMemHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
     return nCount;
 }
 
+/************************************************************************/
+/*                               ReadAt()                               */
+/*                                                                      */
+/*      Does not use the handle state, so it may be called from         */
+/*      several threads at once.                                        */
+/************************************************************************/
+
+size_t VSIMemHandle::ReadAt( vsi_l_offset nReadOffset, void *pBuffer,
+                             size_t nSize )
+
+{
+    CPLMutexHolder oHolder( poFile->hMutex );
+
+    if( nReadOffset >= poFile->nLength )
+        return 0;
+    if( nSize > poFile->nLength - nReadOffset )
+        nSize = (size_t)(poFile->nLength - nReadOffset);
+
+    memcpy( pBuffer, poFile->pabyData + nReadOffset, nSize );
+
+    return nSize;
+}
+
 /************************************************************************/
 /*                               Write()                                */
 /************************************************************************/
@@ -361,6 +434,9 @@ size_t VSIMemHandle::Write( const void * pBuffer, size_t nSize, size_t nCount )
         errno = EACCES;
         return 0;
     }
+
+    CPLMutexHolder oHolder( poFile->hMutex );
+
     if( bExtendFileAtNextWrite )
     {
         bExtendFileAtNextWrite = FALSE;
@@ -409,6 +485,8 @@ int VSIMemHandle::Truncate( vsi_l_offset nNewSize )
         return -1;
     }
 
+    CPLMutexHolder oHolder( poFile->hMutex );
+
     bExtendFileAtNextWrite = FALSE;
     if (poFile->SetLength( nNewSize ))
         return 0;
@@ -429,7 +507,12 @@ int VSIMemHandle::Truncate( vsi_l_offset nNewSize )
 VSIMemFilesystemHandler::VSIMemFilesystemHandler()
 
 {
-    hMutex = NULL;
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
+    {
+        aoShards[i].hMutex = CPLCreateMutex();
+        if( aoShards[i].hMutex != NULL )
+            CPLReleaseMutex( aoShards[i].hMutex );
+    }
 }
 
 /************************************************************************/
@@ -439,17 +522,66 @@ VSIMemFilesystemHandler::VSIMemFilesystemHandler()
 VSIMemFilesystemHandler::~VSIMemFilesystemHandler()
 
 {
-    std::map<CPLString,VSIMemFile*>::const_iterator iter;
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
+    {
+        std::map<CPLString,VSIMemFile*>::const_iterator iter;
+        std::map<CPLString,VSIMemFile*>& oFileList = aoShards[i].oFileList;
+
+        for( iter = oFileList.begin(); iter != oFileList.end(); ++iter )
+        {
+            iter->second->nRefCount--;
+            delete iter->second;
+        }
+
+        if( aoShards[i].hMutex != NULL )
+            CPLDestroyMutex( aoShards[i].hMutex );
+        aoShards[i].hMutex = NULL;
+    }
+}
+
+/************************************************************************/
+/*                              GetShard()                              */
+/************************************************************************/
+
+VSIMemShard &VSIMemFilesystemHandler::GetShard( const CPLString& osFilename )
+
+{
+    /* FNV-1a hash of the normalized filename */
+    GUInt32 nHash = 2166136261U;
+    for( size_t i = 0; i < osFilename.size(); i++ )
+    {
+        nHash ^= (GByte) osFilename[i];
+        nHash *= 16777619U;
+    }
+    return aoShards[nHash % VSIMEM_SHARD_COUNT];
+}
+
+/************************************************************************/
+/*                           LockAllShards()                            */
+/************************************************************************/
+
+void VSIMemFilesystemHandler::LockAllShards()
 
-    for( iter = oFileList.begin(); iter != oFileList.end(); ++iter )
+{
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
     {
-        iter->second->nRefCount--;
-        delete iter->second;
+        if( aoShards[i].hMutex != NULL )
+            CPLAcquireMutex( aoShards[i].hMutex, 1000.0 );
     }
+}
 
-    if( hMutex != NULL )
-        CPLDestroyMutex( hMutex );
-    hMutex = NULL;
+/************************************************************************/
+/*                          UnlockAllShards()                           */
+/************************************************************************/
+
+void VSIMemFilesystemHandler::UnlockAllShards()
+
+{
+    for( int i = VSIMEM_SHARD_COUNT - 1; i >= 0; i-- )
+    {
+        if( aoShards[i].hMutex != NULL )
+            CPLReleaseMutex( aoShards[i].hMutex );
+    }
 }
 
 /************************************************************************/
@@ -461,18 +593,22 @@ VSIMemFilesystemHandler::Open( const char *pszFilename,
                                const char *pszAccess )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
     VSIMemFile *poFile;
     CPLString osFilename = pszFilename;
     NormalizePath( osFilename );
 
+    VSIMemShard& oShard = GetShard( osFilename );
+    CPLMutexHolder oHolder( oShard.hMutex );
+
 /* -------------------------------------------------------------------- */
 /*      Get the filename we are opening, create if needed.              */
 /* -------------------------------------------------------------------- */
-    if( oFileList.find(osFilename) == oFileList.end() )
+    std::map<CPLString,VSIMemFile*>::iterator oIter =
+        oShard.oFileList.find(osFilename);
+    if( oIter == oShard.oFileList.end() )
         poFile = NULL;
     else
-        poFile = oFileList[osFilename];
+        poFile = oIter->second;
 
     if( strstr(pszAccess,"w") == NULL && poFile == NULL )
     {
@@ -483,13 +619,16 @@ VSIMemFilesystemHandler::Open( const char *pszFilename,
     if( strstr(pszAccess,"w") )
     {
         if( poFile )
+        {
+            CPLMutexHolder oFileHolder( poFile->hMutex );
             poFile->SetLength( 0 );
+        }
         else
         {
             poFile = new VSIMemFile;
             poFile->osFilename = osFilename;
-            oFileList[poFile->osFilename] = poFile;
-            poFile->nRefCount++; // for file list
+            oShard.oFileList[poFile->osFilename] = poFile;
+            poFile->Reference(); // for file list
         }
     }
 
@@ -513,10 +652,13 @@ VSIMemFilesystemHandler::Open( const char *pszFilename,
     else
         poHandle->bUpdate = FALSE;
 
-    poFile->nRefCount++;
+    poFile->Reference();
 
     if( strstr(pszAccess,"a") )
+    {
+        CPLMutexHolder oFileHolder( poFile->hMutex );
         poHandle->nOffset = poFile->nLength;
+    }
 
     return poHandle;
 }
@@ -532,8 +674,6 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
 {
     (void) nFlags;
 
-    CPLMutexHolder oHolder( &hMutex );
-
     CPLString osFilename = pszFilename;
     NormalizePath( osFilename );
 
@@ -546,13 +686,18 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
         return 0;
     }
 
-    if( oFileList.find(osFilename) == oFileList.end() )
+    VSIMemShard& oShard = GetShard( osFilename );
+    CPLMutexHolder oHolder( oShard.hMutex );
+
+    std::map<CPLString,VSIMemFile*>::iterator oIter =
+        oShard.oFileList.find(osFilename);
+    if( oIter == oShard.oFileList.end() )
     {
         errno = ENOENT;
         return -1;
     }
 
-    VSIMemFile *poFile = oFileList[osFilename];
+    VSIMemFile *poFile = oIter->second;
 
     memset( pStatBuf, 0, sizeof(VSIStatBufL) );
 
@@ -563,6 +708,7 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
     }
     else
     {
+        CPLMutexHolder oFileHolder( poFile->hMutex );
         pStatBuf->st_size = poFile->nLength;
         pStatBuf->st_mode = S_IFREG;
         pStatBuf->st_mtime = poFile->mTime;
@@ -578,8 +724,11 @@ int VSIMemFilesystemHandler::Stat( const char * pszFilename,
 int VSIMemFilesystemHandler::Unlink( const char * pszFilename )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-    return Unlink_unlocked(pszFilename);
+    CPLString osFilename = pszFilename;
+    NormalizePath( osFilename );
+
+    CPLMutexHolder oHolder( GetShard( osFilename ).hMutex );
+    return Unlink_unlocked(osFilename);
 }
 
 /************************************************************************/
@@ -592,21 +741,22 @@ int VSIMemFilesystemHandler::Unlink_unlocked( const char * pszFilename )
     CPLString osFilename = pszFilename;
     NormalizePath( osFilename );
 
-    VSIMemFile *poFile;
+    std::map<CPLString,VSIMemFile*>& oFileList =
+        GetShard( osFilename ).oFileList;
+    std::map<CPLString,VSIMemFile*>::iterator oIter =
+        oFileList.find(osFilename);
 
-    if( oFileList.find(osFilename) == oFileList.end() )
+    if( oIter == oFileList.end() )
     {
         errno = ENOENT;
         return -1;
     }
     else
     {
-        poFile = oFileList[osFilename];
+        VSIMemFile *poFile = oIter->second;
 
-        if( --(poFile->nRefCount) == 0 )
-            delete poFile;
-
-        oFileList.erase( oFileList.find(osFilename) );
+        oFileList.erase( oIter );
+        poFile->Release();
 
         return 0;
     }
@@ -622,13 +772,14 @@ int VSIMemFilesystemHandler::Mkdir( const char * pszPathname,
 {
     (void) nMode;
 
-    CPLMutexHolder oHolder( &hMutex );
-
     CPLString osPathname = pszPathname;
 
     NormalizePath( osPathname );
 
-    if( oFileList.find(osPathname) != oFileList.end() )
+    VSIMemShard& oShard = GetShard( osPathname );
+    CPLMutexHolder oHolder( oShard.hMutex );
+
+    if( oShard.oFileList.find(osPathname) != oShard.oFileList.end() )
     {
         errno = EEXIST;
         return -1;
@@ -638,8 +789,8 @@ int VSIMemFilesystemHandler::Mkdir( const char * pszPathname,
 
     poFile->osFilename = osPathname;
     poFile->bIsDirectory = TRUE;
-    oFileList[osPathname] = poFile;
-    poFile->nRefCount++; /* referenced by file list */
+    oShard.oFileList[osPathname] = poFile;
+    poFile->Reference(); /* referenced by file list */
 
     return 0;
 }
@@ -661,50 +812,47 @@ int VSIMemFilesystemHandler::Rmdir( const char * pszPathname )
 char **VSIMemFilesystemHandler::ReadDir( const char *pszPath )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     CPLString osPath = pszPath;
 
     NormalizePath( osPath );
 
     std::map<CPLString,VSIMemFile*>::const_iterator iter;
-    char **papszDir = NULL;
+    std::vector<CPLString> aosNames;
     int nPathLen = strlen(osPath);
 
     if( osPath[nPathLen-1] == '/' )
         nPathLen--;
 
-    /* In case of really big number of files in the directory, CSLAddString */
-    /* can be slow (see #2158). We then directly build the list. */
-    int nItems=0;
-    int nAllocatedItems=0;
-
-    for( iter = oFileList.begin(); iter != oFileList.end(); ++iter )
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
     {
-        const char *pszFilePath = iter->second->osFilename.c_str();
-        if( EQUALN(osPath,pszFilePath,nPathLen)
-            && pszFilePath[nPathLen] == '/' 
-            && strstr(pszFilePath+nPathLen+1,"/") == NULL )
+        CPLMutexHolder oHolder( aoShards[i].hMutex );
+        std::map<CPLString,VSIMemFile*>& oFileList = aoShards[i].oFileList;
+
+        for( iter = oFileList.begin(); iter != oFileList.end(); ++iter )
         {
-            if (nItems == 0)
-            {
-                papszDir = (char**) CPLCalloc(2,sizeof(char*));
-                nAllocatedItems = 1;
-            }
-            else if (nItems >= nAllocatedItems)
+            const char *pszFilePath = iter->second->osFilename.c_str();
+            if( EQUALN(osPath,pszFilePath,nPathLen)
+                && pszFilePath[nPathLen] == '/' 
+                && strstr(pszFilePath+nPathLen+1,"/") == NULL )
             {
-                nAllocatedItems = nAllocatedItems * 2;
-                papszDir = (char**)CPLRealloc(papszDir, 
-                                              (nAllocatedItems+2)*sizeof(char*));
+                aosNames.push_back(pszFilePath+nPathLen+1);
             }
-
-            papszDir[nItems] = CPLStrdup(pszFilePath+nPathLen+1);
-            papszDir[nItems+1] = NULL;
-
-            nItems++;
         }
     }
 
+    if( aosNames.empty() )
+        return NULL;
+
+    /* Return the names in the same order as the files would be in a */
+    /* single list */
+    std::sort( aosNames.begin(), aosNames.end() );
+
+    /* In case of really big number of files in the directory, CSLAddString */
+    /* can be slow (see #2158). We then directly build the list. */
+    char **papszDir = (char**) CPLCalloc(aosNames.size() + 1, sizeof(char*));
+    for( size_t i = 0; i < aosNames.size(); i++ )
+        papszDir[i] = CPLStrdup(aosNames[i]);
+
     return papszDir;
 }
 
@@ -716,8 +864,6 @@ int VSIMemFilesystemHandler::Rename( const char *pszOldPath,
                                      const char *pszNewPath )
 
 {
-    CPLMutexHolder oHolder( &hMutex );
-
     CPLString osOldPath = pszOldPath;
     CPLString osNewPath = pszNewPath;
 
@@ -727,30 +873,52 @@ int VSIMemFilesystemHandler::Rename( const char *pszOldPath,
     if ( osOldPath.compare(osNewPath) == 0 )
         return 0;
 
-    if( oFileList.find(osOldPath) == oFileList.end() )
+    LockAllShards();
+
+    std::map<CPLString,VSIMemFile*>& oOldFileList =
+        GetShard( osOldPath ).oFileList;
+    if( oOldFileList.find(osOldPath) == oOldFileList.end() )
     {
+        UnlockAllShards();
         errno = ENOENT;
         return -1;
     }
-    else
+
+/* -------------------------------------------------------------------- */
+/*      Detach the file and, if it is a directory, its children from    */
+/*      their shards, before attaching them under their new names.      */
+/* -------------------------------------------------------------------- */
+    std::vector<VSIMemFile*> apoMovedFiles;
+    for( int i = 0; i < VSIMEM_SHARD_COUNT; i++ )
     {
-        std::map<CPLString,VSIMemFile*>::iterator it = oFileList.find(osOldPath);
-        while (it != oFileList.end() && it->first.ifind(osOldPath) == 0)
+        std::map<CPLString,VSIMemFile*>& oFileList = aoShards[i].oFileList;
+        std::map<CPLString,VSIMemFile*>::iterator it = oFileList.begin();
+        while (it != oFileList.end())
         {
-            const CPLString osRemainder = it->first.substr(osOldPath.size());
-            if (osRemainder.empty() || osRemainder[0] == '/')
+            if( it->first.ifind(osOldPath) == 0 &&
+                (it->first.size() == osOldPath.size() ||
+                 it->first[osOldPath.size()] == '/') )
             {
-                const CPLString osNewFullPath = osNewPath + osRemainder;
-                Unlink_unlocked(osNewFullPath);
-                oFileList[osNewFullPath] = it->second;
-                it->second->osFilename = osNewFullPath;
+                apoMovedFiles.push_back(it->second);
                 oFileList.erase(it++);
             }
             else ++it;
         }
+    }
 
-        return 0;
+    for( size_t i = 0; i < apoMovedFiles.size(); i++ )
+    {
+        VSIMemFile* poFile = apoMovedFiles[i];
+        const CPLString osNewFullPath =
+            osNewPath + poFile->osFilename.substr(osOldPath.size());
+        Unlink_unlocked(osNewFullPath);
+        GetShard( osNewFullPath ).oFileList[osNewFullPath] = poFile;
+        poFile->osFilename = osNewFullPath;
     }
+
+    UnlockAllShards();
+
+    return 0;
 }
 
 /************************************************************************/
@@ -832,6 +1000,52 @@ void VSIInstallMemFileHandler()
     VSIFileManager::InstallHandler( "/vsimem/", new VSIMemFilesystemHandler );
 }
 
+/************************************************************************/
+/*                    VSIFileFromMemBufferInternal()                    */
+/************************************************************************/
+
+static VSILFILE *VSIFileFromMemBufferInternal( const char *pszFilename,
+                                               GByte *pabyData,
+                                               vsi_l_offset nDataLength,
+                                               int bTakeOwnership,
+                                               VSIMemBufferReleaseFunc pfnRelease,
+                                               void *pReleaseUserData )
+
+{
+    if( VSIFileManager::GetHandler("") 
+        == VSIFileManager::GetHandler("/vsimem/") )
+        VSIInstallMemFileHandler();
+
+    VSIMemFilesystemHandler *poHandler = (VSIMemFilesystemHandler *) 
+        VSIFileManager::GetHandler("/vsimem/");
+
+    if (pszFilename == NULL)
+        return NULL;
+
+    CPLString osFilename = pszFilename;
+    VSIMemFilesystemHandler::NormalizePath( osFilename );
+
+    VSIMemFile *poFile = new VSIMemFile;
+
+    poFile->osFilename = osFilename;
+    poFile->bOwnData = bTakeOwnership;
+    poFile->pabyData = pabyData;
+    poFile->nLength = nDataLength;
+    poFile->nAllocLength = nDataLength;
+    poFile->pfnRelease = pfnRelease;
+    poFile->pReleaseUserData = pReleaseUserData;
+
+    {
+        VSIMemShard& oShard = poHandler->GetShard( osFilename );
+        CPLMutexHolder oHolder( oShard.hMutex );
+        poHandler->Unlink_unlocked(osFilename);
+        oShard.oFileList[poFile->osFilename] = poFile;
+        poFile->Reference();
+    }
+
+    return (VSILFILE *) poHandler->Open( osFilename, "r+" );
+}
+
 /************************************************************************/
 /*                        VSIFileFromMemBuffer()                        */
 /************************************************************************/
@@ -863,35 +1077,43 @@ VSILFILE *VSIFileFromMemBuffer( const char *pszFilename,
                           int bTakeOwnership )
 
 {
-    if( VSIFileManager::GetHandler("") 
-        == VSIFileManager::GetHandler("/vsimem/") )
-        VSIInstallMemFileHandler();
-
-    VSIMemFilesystemHandler *poHandler = (VSIMemFilesystemHandler *) 
-        VSIFileManager::GetHandler("/vsimem/");
-
-    if (pszFilename == NULL)
-        return NULL;
-
-    CPLString osFilename = pszFilename;
-    VSIMemFilesystemHandler::NormalizePath( osFilename );
+    return VSIFileFromMemBufferInternal( pszFilename, pabyData, nDataLength,
+                                         bTakeOwnership, NULL, NULL );
+}
 
-    VSIMemFile *poFile = new VSIMemFile;
+/************************************************************************/
+/*                       VSIFileFromMemBufferEx()                       */
+/************************************************************************/
 
-    poFile->osFilename = osFilename;
-    poFile->bOwnData = bTakeOwnership;
-    poFile->pabyData = pabyData;
-    poFile->nLength = nDataLength;
-    poFile->nAllocLength = nDataLength;
+/**
+ * \brief Create memory "file" from a caller-owned buffer.
+ *
+ * Like VSIFileFromMemBuffer() with bTakeOwnership = FALSE, the buffer is
+ * used without copy and cannot be extended by writes. But instead of the
+ * caller having to keep it alive until it knows the file is no longer
+ * used, pfnRelease is called with the buffer once the file has been
+ * unlinked (or replaced) and all the handles on it have been closed.
+ * pfnRelease may be called from any thread.
+ *
+ * @param pszFilename the filename to be created.
+ * @param pabyData the data buffer for the file.
+ * @param nDataLength the length of buffer in bytes.
+ * @param pfnRelease function called to release the buffer, or NULL.
+ * @param pReleaseUserData user data passed to pfnRelease.
+ *
+ * @return open file handle on created file (see VSIFOpenL()).
+ * @since GDAL 2.0
+ */
 
-    {
-        CPLMutexHolder oHolder( &poHandler->hMutex );
-        poHandler->Unlink_unlocked(osFilename);
-        poHandler->oFileList[poFile->osFilename] = poFile;
-        poFile->nRefCount++;
-    }
+VSILFILE *VSIFileFromMemBufferEx( const char *pszFilename,
+                                  GByte *pabyData,
+                                  vsi_l_offset nDataLength,
+                                  VSIMemBufferReleaseFunc pfnRelease,
+                                  void *pReleaseUserData )
 
-    return (VSILFILE *) poHandler->Open( osFilename, "r+" );
+{
+    return VSIFileFromMemBufferInternal( pszFilename, pabyData, nDataLength,
+                                         FALSE, pfnRelease, pReleaseUserData );
 }
 
 /************************************************************************/
@@ -906,6 +1128,12 @@ VSILFILE *VSIFileFromMemBuffer( const char *pszFilename,
  * object will be deleted, and ownership of the buffer will pass to the 
  * caller otherwise the underlying file will remain in existance. 
  *
+ * Starting with GDAL 2.0, if bUnlinkAndSeize is TRUE and the buffer cannot
+ * be handed over, because other handles are still opened on the file or
+ * because it was registered with VSIFileFromMemBufferEx(), the file is
+ * unlinked and a copy of the buffer is returned instead. The original
+ * buffer is released when the last handle is closed.
+ *
  * @param pszFilename the name of the file to grab the buffer of.
  * @param pnDataLength (file) length returned in this variable.
  * @param bUnlinkAndSeize TRUE to remove the file, or FALSE to leave unaltered.
@@ -927,29 +1155,59 @@ GByte *VSIGetMemFileBuffer( const char *pszFilename,
     CPLString osFilename = pszFilename;
     VSIMemFilesystemHandler::NormalizePath( osFilename );
 
-    CPLMutexHolder oHolder( &poHandler->hMutex );
+    VSIMemShard& oShard = poHandler->GetShard( osFilename );
+    CPLMutexHolder oHolder( oShard.hMutex );
 
-    if( poHandler->oFileList.find(osFilename) == poHandler->oFileList.end() )
+    std::map<CPLString,VSIMemFile*>::iterator oIter =
+        oShard.oFileList.find(osFilename);
+    if( oIter == oShard.oFileList.end() )
         return NULL;
 
-    VSIMemFile *poFile = poHandler->oFileList[osFilename];
+    VSIMemFile *poFile = oIter->second;
     GByte *pabyData;
 
-    pabyData = poFile->pabyData;
-    if( pnDataLength != NULL )
-        *pnDataLength = poFile->nLength;
-    
-    if( bUnlinkAndSeize )
     {
-        if( !poFile->bOwnData )
-            CPLDebug( "VSIMemFile", 
-                      "File doesn't own data in VSIGetMemFileBuffer!" );
-        else
+        CPLMutexHolder oFileHolder( poFile->hMutex );
+
+        pabyData = poFile->pabyData;
+        if( pnDataLength != NULL )
+            *pnDataLength = poFile->nLength;
+
+        /* The file list holds one reference, the open handles the others */
+        if( bUnlinkAndSeize &&
+            (poFile->pfnRelease != NULL ||
+             CPLAtomicAdd( &(poFile->nRefCount), 0 ) > 1) )
+        {
+            /* The buffer is still needed: hand over a copy of it */
+            if( poFile->nLength != (size_t)poFile->nLength )
+                pabyData = NULL;
+            else
+                pabyData = (GByte *)
+                    VSIMalloc( MAX(1, (size_t)poFile->nLength) );
+            if( pabyData == NULL )
+            {
+                CPLError( CE_Failure, CPLE_OutOfMemory,
+                          "Cannot allocate a copy of %s.",
+                          osFilename.c_str() );
+                return NULL;
+            }
+            memcpy( pabyData, poFile->pabyData, (size_t)poFile->nLength );
+        }
+        else if( bUnlinkAndSeize )
+        {
+            if( !poFile->bOwnData )
+                CPLDebug( "VSIMemFile", 
+                          "File doesn't own data in VSIGetMemFileBuffer!" );
+            /* The caller becomes responsible for the buffer */
             poFile->bOwnData = FALSE;
+        }
+    }
 
-        poHandler->oFileList.erase( poHandler->oFileList.find(osFilename) );
-        --(poFile->nRefCount);
-        delete poFile;
+    if( bUnlinkAndSeize )
+    {
+        oShard.oFileList.erase( oIter );
+        /* Handles still opened on the file keep it alive */
+        poFile->Release();
     }
 
     return pabyData;
@@ -52,21 +52,76 @@
 /*                           VSIVirtualHandle                           */
 /************************************************************************/
 
-class CPL_DLL VSIVirtualHandle { 
+class CPL_DLL VSIVirtualHandle {
+    /* Created by the default ReadAsync() implementation, to serialize */
+    /* its Seek()/Read() calls with the synchronous API */
+    CPLMutex         *hAsyncMutex;
+    /* Number of ReadAsync() requests not yet completed */
+    int               nAsyncPending;
+    /* Statistics of the handler that opened the file, set by VSIFOpenL() */
+    VSIIOStats       *psIOStats;
+
+    friend VSIAsyncReadRequest *VSICreateAsyncReadRequest( VSIVirtualHandle*,
+                                                           vsi_l_offset, void*,
+                                                           size_t,
+                                                           VSIAsyncReadCallback,
+                                                           void* );
+    friend void       VSICompleteAsyncReadRequest( VSIAsyncReadRequest*, size_t );
+
   public:
+                      VSIVirtualHandle() : hAsyncMutex(NULL), nAsyncPending(0),
+                                         psIOStats(NULL) {}
+
     virtual int       Seek( vsi_l_offset nOffset, int nWhence ) = 0;
     virtual vsi_l_offset Tell() = 0;
     virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb ) = 0;
     virtual int       ReadMultiRange( int nRanges, void ** ppData, const vsi_l_offset* panOffsets, const size_t* panSizes );
+    virtual size_t    ReadAt( vsi_l_offset nOffset, void *pBuffer, size_t nSize );
     virtual size_t    Write( const void *pBuffer, size_t nSize,size_t nMemb)=0;
     virtual int       Eof() = 0;
     virtual int       Flush() {return 0;}
     virtual int       Close() = 0;
     virtual int       Truncate( CPL_UNUSED vsi_l_offset nNewSize ) { return -1; }
     virtual void     *GetNativeFileDescriptor() { return NULL; }
-    virtual           ~VSIVirtualHandle() { }
+    virtual VSIAsyncReadRequest *ReadAsync( vsi_l_offset nOffset, void* pBuffer,
+                                            size_t nSize,
+                                            VSIAsyncReadCallback pfnCallback,
+                                            void* pUserData );
+    virtual           ~VSIVirtualHandle() { if( hAsyncMutex ) CPLDestroyMutex(hAsyncMutex); }
+
+    void              WaitAsyncReads();
+    CPLMutex         *GetAsyncMutex() { return hAsyncMutex; }
+    VSIIOStats       *GetIOStats() { return psIOStats; }
+    void              SetIOStats( VSIIOStats* psStatsIn ) { psIOStats = psStatsIn; }
+};
+
+/************************************************************************/
+/*                         VSIAsyncReadRequest                          */
+/*                                                                      */
+/*      Helpers for ReadAsync() implementations. The job run for a      */
+/*      request must end with VSICompleteAsyncReadRequest().            */
+/************************************************************************/
+
+struct VSIAsyncReadRequest
+{
+    VSIVirtualHandle     *poHandle;
+    vsi_l_offset          nOffset;
+    void                 *pBuffer;
+    size_t                nSize;
+    VSIAsyncReadCallback  pfnCallback;
+    void                 *pUserData;
+    size_t                nResult;
+    volatile int          bComplete;
 };
 
+VSIAsyncReadRequest *VSICreateAsyncReadRequest( VSIVirtualHandle* poHandle,
+                                                vsi_l_offset nOffset,
+                                                void* pBuffer, size_t nSize,
+                                                VSIAsyncReadCallback pfnCallback,
+                                                void* pUserData );
+void VSICompleteAsyncReadRequest( VSIAsyncReadRequest* psRequest, size_t nResult );
+void VSISubmitAsyncReadJob( CPLThreadFunc pfnFunc, void* pData );
+
 /************************************************************************/
 /*                         VSIFilesystemHandler                         */
 /************************************************************************/
@@ -103,6 +158,8 @@ class CPL_DLL VSIFileManager
 private:
     VSIFilesystemHandler *poDefaultHandler;
     std::map<std::string, VSIFilesystemHandler *> oHandlers;
+    /* I/O statistics, per handler prefix. "" is the default handler */
+    std::map<std::string, VSIIOStats *> oIOStats;
 
     VSIFileManager();
 
@@ -111,9 +168,12 @@ private:
 public:
     ~VSIFileManager();
 
-    static VSIFilesystemHandler *GetHandler( const char * );
+    static VSIFilesystemHandler *GetHandler( const char *,
+                                             VSIIOStats** ppsIOStats = NULL );
     static void InstallHandler( const std::string& osPrefix, 
                                 VSIFilesystemHandler * );
+    static VSIIOStats *GetIOStats( const std::string& osPrefix );
+    static std::vector<std::string> GetIOStatsPrefixes();
     /* RemoveHandler is never defined. */
     /* static void RemoveHandler( const std::string& osPrefix ); */
 };
@@ -194,7 +254,14 @@ VSIVirtualHandle CPL_DLL *VSICreateBufferedReaderHandle(VSIVirtualHandle* poBase
 VSIVirtualHandle* VSICreateBufferedReaderHandle(VSIVirtualHandle* poBaseHandle,
                                                 const GByte* pabyBeginningContent,
                                                 vsi_l_offset nSheatFileSize);
-VSIVirtualHandle* VSICreateCachedFile( VSIVirtualHandle* poBaseHandle, size_t nChunkSize = 32768, size_t nCacheSize = 0 );
+VSIVirtualHandle* VSICreateCachedFile( VSIVirtualHandle* poBaseHandle, const char* pszFilename, size_t nChunkSize = 32768, size_t nCacheSize = 0 );
+void VSICachedFileInvalidate( const char* pszFilename );
+void VSICleanupCachedFiles();
 VSIVirtualHandle CPL_DLL *VSICreateGZipWritable( VSIVirtualHandle* poBaseHandle, int bRegularZLibIn, int bAutoCloseBaseHandle );
 
+#define CPL_DEFLATE_TYPE_GZIP        0
+#define CPL_DEFLATE_TYPE_ZLIB        1
+#define CPL_DEFLATE_TYPE_RAW_DEFLATE 2
+VSIVirtualHandle CPL_DLL *VSICreateGZipWritable( VSIVirtualHandle* poBaseHandle, int nDeflateType, int bAutoCloseBaseHandle, int nThreads, size_t nChunkSize );
+
 #endif /* ndef CPL_VSI_VIRTUAL_H_INCLUDED */
@@ -32,10 +32,58 @@
 #include "cpl_vsi_virtual.h"
 #include "cpl_multiproc.h"
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
+#include "cpl_atomic_ops.h"
 #include <string>
 
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
 CPL_CVSID("$Id: cpl_vsil.cpp 28849 2015-04-05 14:05:18Z goatbar $");
 
+/* Set from CPL_VSIL_STATS when the file manager is created, or by */
+/* VSISetIOStatsEnabled(). Read without lock by the VSIF*L() calls. */
+static volatile int bVSIIOStatsEnabled = FALSE;
+
+/************************************************************************/
+/*                        VSIIOStatsGetMicroSec()                       */
+/************************************************************************/
+
+static GIntBig VSIIOStatsGetMicroSec()
+{
+#ifdef WIN32
+    LARGE_INTEGER nCounter, nFreq;
+    QueryPerformanceCounter(&nCounter);
+    QueryPerformanceFrequency(&nFreq);
+    /* Split the conversion to avoid overflowing after a few days */
+    return (GIntBig)(nCounter.QuadPart / nFreq.QuadPart) * 1000000 +
+           (GIntBig)(nCounter.QuadPart % nFreq.QuadPart) * 1000000 / nFreq.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (GIntBig)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+/************************************************************************/
+/*                        VSIIOStatsAddLatency()                        */
+/************************************************************************/
+
+static void VSIIOStatsAddLatency( GIntBig* panHistogram, GIntBig nStart )
+{
+    GIntBig nElapsed = VSIIOStatsGetMicroSec() - nStart;
+    int iBucket = 0;
+    while( nElapsed > 0 && iBucket < VSI_IO_STATS_LATENCY_BUCKETS - 1 )
+    {
+        nElapsed >>= 1;
+        iBucket ++;
+    }
+    CPLAtomicAdd64( panHistogram + iBucket, 1 );
+}
+
 /************************************************************************/
 /*                             VSIReadDir()                             */
 /************************************************************************/
@@ -297,6 +345,8 @@ int VSIUnlink( const char * pszFilename )
     VSIFilesystemHandler *poFSHandler = 
         VSIFileManager::GetHandler( pszFilename );
 
+    VSICachedFileInvalidate( pszFilename );
+
     return poFSHandler->Unlink( pszFilename );
 }
 
@@ -328,6 +378,9 @@ int VSIRename( const char * oldpath, const char * newpath )
     VSIFilesystemHandler *poFSHandler = 
         VSIFileManager::GetHandler( oldpath );
 
+    VSICachedFileInvalidate( oldpath );
+    VSICachedFileInvalidate( newpath );
+
     return poFSHandler->Rename( oldpath, newpath );
 }
 
@@ -436,8 +489,11 @@ int VSIStatExL( const char * pszFilename, VSIStatBufL *psStatBuf, int nFlags )
         pszFilename = szAltPath;
     }
 
+    VSIIOStats* psIOStats = NULL;
     VSIFilesystemHandler *poFSHandler =
-        VSIFileManager::GetHandler( pszFilename );
+        VSIFileManager::GetHandler( pszFilename, &psIOStats );
+    if( bVSIIOStatsEnabled && psIOStats != NULL )
+        CPLAtomicAdd64( &psIOStats->nStats, 1 );
 
     if (nFlags == 0)
         nFlags = VSI_STAT_EXISTS_FLAG | VSI_STAT_NATURE_FLAG | VSI_STAT_SIZE_FLAG;
@@ -508,10 +564,33 @@ int VSIIsCaseSensitiveFS( const char * pszFilename )
 VSILFILE *VSIFOpenL( const char * pszFilename, const char * pszAccess )
 
 {
+    VSIIOStats* psIOStats = NULL;
     VSIFilesystemHandler *poFSHandler = 
-        VSIFileManager::GetHandler( pszFilename );
-        
-    VSILFILE* fp = (VSILFILE *) poFSHandler->Open( pszFilename, pszAccess );
+        VSIFileManager::GetHandler( pszFilename, &psIOStats );
+
+    /* Chunks cached by the VSI_CACHE readers would become stale */
+    if( strchr(pszAccess, 'w') || strchr(pszAccess, '+') ||
+        strchr(pszAccess, 'a') )
+        VSICachedFileInvalidate( pszFilename );
+
+    const int bStats = bVSIIOStatsEnabled;
+    GIntBig nStart = bStats ? VSIIOStatsGetMicroSec() : 0;
+
+    VSIVirtualHandle* poHandle = poFSHandler->Open( pszFilename, pszAccess );
+
+    if( bStats && psIOStats != NULL )
+    {
+        CPLAtomicAdd64( &psIOStats->nOpens, 1 );
+        if( poHandle == NULL )
+            CPLAtomicAdd64( &psIOStats->nOpenFailures, 1 );
+        VSIIOStatsAddLatency( psIOStats->anOpenLatency, nStart );
+    }
+    /* Always attached, so that enabling the statistics later also */
+    /* accounts for the files already opened */
+    if( poHandle != NULL )
+        poHandle->SetIOStats( psIOStats );
+
+    VSILFILE* fp = (VSILFILE *) poHandle;
 
     VSIDebug3( "VSIFOpenL(%s,%s) = %p", pszFilename, pszAccess, fp );
         
@@ -543,7 +622,9 @@ int VSIFCloseL( VSILFILE * fp )
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
     
     VSIDebug1( "VSICloseL(%p)", fp );
-    
+
+    poFileHandle->WaitAsyncReads();
+
     int nResult = poFileHandle->Close();
     
     delete poFileHandle;
@@ -577,6 +658,11 @@ int VSIFSeekL( VSILFILE * fp, vsi_l_offset nOffset, int nWhence )
 {
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
     
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
+    if( bVSIIOStatsEnabled && poFileHandle->GetIOStats() != NULL )
+        CPLAtomicAdd64( &poFileHandle->GetIOStats()->nSeeks, 1 );
+
     return poFileHandle->Seek( nOffset, nWhence );
 }
 
@@ -605,6 +691,8 @@ vsi_l_offset VSIFTellL( VSILFILE * fp )
 {
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
     
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
     return poFileHandle->Tell();
 }
 
@@ -643,6 +731,8 @@ int VSIFFlushL( VSILFILE * fp )
 {
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
     
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
     return poFileHandle->Flush();
 }
 
@@ -675,7 +765,18 @@ size_t VSIFReadL( void * pBuffer, size_t nSize, size_t nCount, VSILFILE * fp )
 {
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
     
-    return poFileHandle->Read( pBuffer, nSize, nCount );
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
+    VSIIOStats* psIOStats = poFileHandle->GetIOStats();
+    if( !bVSIIOStatsEnabled || psIOStats == NULL )
+        return poFileHandle->Read( pBuffer, nSize, nCount );
+
+    GIntBig nStart = VSIIOStatsGetMicroSec();
+    size_t nRet = poFileHandle->Read( pBuffer, nSize, nCount );
+    CPLAtomicAdd64( &psIOStats->nReads, 1 );
+    CPLAtomicAdd64( &psIOStats->nBytesRead, (GIntBig)(nRet * nSize) );
+    VSIIOStatsAddLatency( psIOStats->anReadLatency, nStart );
+    return nRet;
 }
 
 
@@ -712,7 +813,216 @@ int VSIFReadMultiRangeL( int nRanges, void ** ppData,
 {
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
 
-    return poFileHandle->ReadMultiRange( nRanges, ppData, panOffsets, panSizes );
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
+    VSIIOStats* psIOStats = poFileHandle->GetIOStats();
+    if( !bVSIIOStatsEnabled || psIOStats == NULL )
+        return poFileHandle->ReadMultiRange( nRanges, ppData, panOffsets, panSizes );
+
+    GIntBig nStart = VSIIOStatsGetMicroSec();
+    int nRet = poFileHandle->ReadMultiRange( nRanges, ppData, panOffsets, panSizes );
+    CPLAtomicAdd64( &psIOStats->nMultiRangeReads, 1 );
+    CPLAtomicAdd64( &psIOStats->nRangesRead, nRanges );
+    if( nRet == 0 )
+    {
+        GIntBig nBytes = 0;
+        for( int i = 0; i < nRanges; i++ )
+            nBytes += panSizes[i];
+        CPLAtomicAdd64( &psIOStats->nBytesRead, nBytes );
+    }
+    VSIIOStatsAddLatency( psIOStats->anReadLatency, nStart );
+    return nRet;
+}
+
+/************************************************************************/
+/*                             VSIFReadAtL()                            */
+/************************************************************************/
+
+/**
+ * \brief Read bytes at a given offset.
+ *
+ * Reads nSize bytes at offset nOffset of the indicated file into pBuffer.
+ * The current offset of the file is not modified.
+ *
+ * On regular files (Unix only), the read is done with pread(), and
+ * several threads may call VSIFReadAtL() concurrently on the same file
+ * handle, as long as no other VSIF*L() call is done on it at the same
+ * time. With CPL_VSIL_UNIX_POSITIONAL_IO=YES, such files are opened
+ * without stdio buffering, which saves one buffer per handle when
+ * VSIFReadAtL() is the main way of reading them. Other file systems
+ * emulate it with a seek and a read, which is not thread-safe.
+ *
+ * @param fp file handle opened with VSIFOpenL().
+ * @param nOffset offset in bytes at which the data should be read.
+ * @param pBuffer buffer into which the data should be read (at least
+ *                nSize bytes).
+ * @param nSize number of bytes to read.
+ *
+ * @return the number of bytes read, lower than nSize in case of error or
+ * end of file.
+ * @since GDAL 2.0
+ */
+
+size_t VSIFReadAtL( VSILFILE * fp, vsi_l_offset nOffset,
+                    void* pBuffer, size_t nSize )
+{
+    VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
+
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
+    VSIIOStats* psIOStats = poFileHandle->GetIOStats();
+    if( !bVSIIOStatsEnabled || psIOStats == NULL )
+        return poFileHandle->ReadAt( nOffset, pBuffer, nSize );
+
+    GIntBig nStart = VSIIOStatsGetMicroSec();
+    size_t nRet = poFileHandle->ReadAt( nOffset, pBuffer, nSize );
+    CPLAtomicAdd64( &psIOStats->nReads, 1 );
+    CPLAtomicAdd64( &psIOStats->nBytesRead, (GIntBig)nRet );
+    VSIIOStatsAddLatency( psIOStats->anReadLatency, nStart );
+    return nRet;
+}
+
+/* Protects the completion state of the asynchronous requests, and the */
+/* pending request count of the handles */
+static CPLMutex* hAsyncReadMutex = NULL;
+static CPLCond* hAsyncReadCond = NULL;
+static CPLWorkerThreadPool* poAsyncReadPool = NULL;
+
+/************************************************************************/
+/*                           VSIFReadAsyncL()                           */
+/************************************************************************/
+
+/**
+ * \brief Start an asynchronous read.
+ *
+ * Queues the read of nSize bytes at offset nOffset of the indicated file
+ * into pBuffer, and returns immediately. The request is then run by a
+ * pool of worker threads, whose size is set by the
+ * CPL_VSIL_ASYNC_NUM_THREADS configuration option (4 by default, or
+ * ALL_CPUS). Several requests may be pending at the same time on the same
+ * file. The current offset of the file is not modified.
+ *
+ * Completion can be checked with VSIAsyncReadIsComplete() or waited for
+ * with VSIAsyncReadWait(). If pfnCallback is not NULL, it is called from
+ * the thread that ran the request, once the read is done and just before
+ * the request is marked as complete. The callback must not call
+ * VSIAsyncReadWait() or VSIAsyncReadFree() on the request.
+ *
+ * pBuffer must stay valid until the request is complete, and the request
+ * must be freed with VSIAsyncReadFree(). Pending requests are waited for
+ * by VSIFCloseL().
+ *
+ * File systems that do not have a native implementation run the request
+ * as a Seek() + Read() sequence, serialized with the other VSIF*L() calls
+ * on the file. Native implementations exist for regular files and
+ * /vsicurl/.
+ *
+ * @param fp file handle opened with VSIFOpenL().
+ * @param nOffset offset in bytes at which the data should be read.
+ * @param pBuffer buffer into which the data should be read (at least
+ *                nSize bytes).
+ * @param nSize number of bytes to read.
+ * @param pfnCallback completion callback, or NULL.
+ * @param pUserData user data passed to pfnCallback.
+ *
+ * @return the request handle.
+ * @since GDAL 2.0
+ */
+
+VSIAsyncReadRequest *VSIFReadAsyncL( VSILFILE * fp, vsi_l_offset nOffset,
+                                     void* pBuffer, size_t nSize,
+                                     VSIAsyncReadCallback pfnCallback,
+                                     void* pUserData )
+{
+    VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
+
+    if( bVSIIOStatsEnabled && poFileHandle->GetIOStats() != NULL )
+        CPLAtomicAdd64( &poFileHandle->GetIOStats()->nAsyncReads, 1 );
+
+    return poFileHandle->ReadAsync( nOffset, pBuffer, nSize,
+                                    pfnCallback, pUserData );
+}
+
+/************************************************************************/
+/*                       VSIAsyncReadIsComplete()                       */
+/************************************************************************/
+
+/**
+ * \brief Return whether an asynchronous read is complete.
+ *
+ * @param psRequest request returned by VSIFReadAsyncL().
+ * @return TRUE if the request is complete.
+ * @since GDAL 2.0
+ */
+
+int VSIAsyncReadIsComplete( VSIAsyncReadRequest* psRequest )
+{
+    CPLMutexHolder oHolder( &hAsyncReadMutex );
+
+    return psRequest->bComplete;
+}
+
+/************************************************************************/
+/*                          VSIAsyncReadWait()                          */
+/************************************************************************/
+
+/**
+ * \brief Wait for the completion of an asynchronous read.
+ *
+ * @param psRequest request returned by VSIFReadAsyncL().
+ * @since GDAL 2.0
+ */
+
+void VSIAsyncReadWait( VSIAsyncReadRequest* psRequest )
+{
+    CPLMutexHolder oHolder( &hAsyncReadMutex );
+
+    while( !psRequest->bComplete )
+        CPLCondWait( hAsyncReadCond, hAsyncReadMutex );
+}
+
+/************************************************************************/
+/*                        VSIAsyncReadGetResult()                       */
+/************************************************************************/
+
+/**
+ * \brief Return the number of bytes read by an asynchronous read.
+ *
+ * Waits for the completion of the request if needed. A result lower than
+ * the requested size indicates an error or the end of file.
+ *
+ * @param psRequest request returned by VSIFReadAsyncL().
+ * @return the number of bytes read.
+ * @since GDAL 2.0
+ */
+
+size_t VSIAsyncReadGetResult( VSIAsyncReadRequest* psRequest )
+{
+    VSIAsyncReadWait( psRequest );
+
+    return psRequest->nResult;
+}
+
+/************************************************************************/
+/*                          VSIAsyncReadFree()                          */
+/************************************************************************/
+
+/**
+ * \brief Free an asynchronous read request.
+ *
+ * Waits for the completion of the request if needed.
+ *
+ * @param psRequest request returned by VSIFReadAsyncL(), or NULL.
+ * @since GDAL 2.0
+ */
+
+void VSIAsyncReadFree( VSIAsyncReadRequest* psRequest )
+{
+    if( psRequest == NULL )
+        return;
+
+    VSIAsyncReadWait( psRequest );
+    CPLFree( psRequest );
 }
 
 /************************************************************************/
@@ -744,7 +1054,18 @@ size_t VSIFWriteL( const void *pBuffer, size_t nSize, size_t nCount, VSILFILE *f
 {
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
     
-    return poFileHandle->Write( pBuffer, nSize, nCount );
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
+    VSIIOStats* psIOStats = poFileHandle->GetIOStats();
+    if( !bVSIIOStatsEnabled || psIOStats == NULL )
+        return poFileHandle->Write( pBuffer, nSize, nCount );
+
+    GIntBig nStart = VSIIOStatsGetMicroSec();
+    size_t nRet = poFileHandle->Write( pBuffer, nSize, nCount );
+    CPLAtomicAdd64( &psIOStats->nWrites, 1 );
+    CPLAtomicAdd64( &psIOStats->nBytesWritten, (GIntBig)(nRet * nSize) );
+    VSIIOStatsAddLatency( psIOStats->anWriteLatency, nStart );
+    return nRet;
 }
 
 /************************************************************************/
@@ -773,6 +1094,8 @@ int VSIFEofL( VSILFILE * fp )
 {
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
     
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
     return poFileHandle->Eof();
 }
 
@@ -800,6 +1123,8 @@ int VSIFTruncateL( VSILFILE * fp, vsi_l_offset nNewSize )
 {
     VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
 
+    CPLMutexHolder oHolder( poFileHandle->GetAsyncMutex() );
+
     return poFileHandle->Truncate(nNewSize);
 }
 
@@ -1079,6 +1404,14 @@ VSIFileManager::~VSIFileManager()
     }
 
     delete poDefaultHandler;
+
+    std::map<std::string,VSIIOStats*>::const_iterator iterStats;
+    for( iterStats = oIOStats.begin();
+         iterStats != oIOStats.end();
+         ++iterStats )
+    {
+        CPLFree( iterStats->second );
+    }
 }
 
 
@@ -1117,6 +1450,8 @@ VSIFileManager *VSIFileManager::Get()
         nConstructerPID = (int)CPLGetPID();
         //printf("Thread %d: VSIFileManager in construction\n", nConstructerPID);
         poManager = new VSIFileManager;
+        bVSIIOStatsEnabled =
+            CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_STATS", "NO"));
         VSIInstallLargeFileHandler();
         VSIInstallSubFileHandler();
         VSIInstallMemFileHandler();
@@ -1143,7 +1478,13 @@ VSIFileManager *VSIFileManager::Get()
 /*                             GetHandler()                             */
 /************************************************************************/
 
-VSIFilesystemHandler *VSIFileManager::GetHandler( const char *pszPath )
+/**
+ * Return the handler of pszPath. If ppsIOStats is not NULL, it is set to
+ * the I/O statistics of that handler.
+ */
+
+VSIFilesystemHandler *VSIFileManager::GetHandler( const char *pszPath,
+                                                  VSIIOStats** ppsIOStats )
 
 {
     VSIFileManager *poThis = Get();
@@ -1156,22 +1497,26 @@ VSIFilesystemHandler *VSIFileManager::GetHandler( const char *pszPath )
     {
         const char* pszIterKey = iter->first.c_str();
         int nIterKeyLen = iter->first.size();
-        if( strncmp(pszPath,pszIterKey,nIterKeyLen) == 0 )
-            return iter->second;
+        if( strncmp(pszPath,pszIterKey,nIterKeyLen) == 0 ||
 
-        /* "/vsimem\foo" should be handled as "/vsimem/foo" */
-        if (nIterKeyLen && nPathLen > nIterKeyLen &&
-            pszIterKey[nIterKeyLen-1] == '/' &&
-            pszPath[nIterKeyLen-1] == '\\' &&
-            strncmp(pszPath,pszIterKey,nIterKeyLen-1) == 0 )
-            return iter->second;
+            /* "/vsimem\foo" should be handled as "/vsimem/foo" */
+            (nIterKeyLen && nPathLen > nIterKeyLen &&
+             pszIterKey[nIterKeyLen-1] == '/' &&
+             pszPath[nIterKeyLen-1] == '\\' &&
+             strncmp(pszPath,pszIterKey,nIterKeyLen-1) == 0) ||
 
-        /* /vsimem should be treated as a match for /vsimem/ */
-        if( nPathLen == nIterKeyLen - 1
-            && strncmp(pszPath,pszIterKey,nIterKeyLen-1) == 0 )
+            /* /vsimem should be treated as a match for /vsimem/ */
+            (nPathLen == nIterKeyLen - 1
+             && strncmp(pszPath,pszIterKey,nIterKeyLen-1) == 0) )
+        {
+            if( ppsIOStats != NULL )
+                *ppsIOStats = GetIOStats( iter->first );
             return iter->second;
+        }
     }
-    
+
+    if( ppsIOStats != NULL )
+        *ppsIOStats = GetIOStats( "" );
     return poThis->poDefaultHandler;
 }
 
@@ -1183,10 +1528,295 @@ void VSIFileManager::InstallHandler( const std::string& osPrefix,
                                      VSIFilesystemHandler *poHandler )
 
 {
+    VSIFileManager *poThis = Get();
     if( osPrefix == "" )
-        Get()->poDefaultHandler = poHandler;
+        poThis->poDefaultHandler = poHandler;
+    else
+        poThis->oHandlers[osPrefix] = poHandler;
+
+    /* Statistics are kept if a handler is replaced */
+    if( poThis->oIOStats.find(osPrefix) == poThis->oIOStats.end() )
+        poThis->oIOStats[osPrefix] = (VSIIOStats*) CPLCalloc(1, sizeof(VSIIOStats));
+}
+
+/************************************************************************/
+/*                             GetIOStats()                             */
+/************************************************************************/
+
+VSIIOStats *VSIFileManager::GetIOStats( const std::string& osPrefix )
+
+{
+    VSIFileManager *poThis = Get();
+    std::map<std::string,VSIIOStats*>::const_iterator iter =
+        poThis->oIOStats.find(osPrefix);
+    if( iter == poThis->oIOStats.end() )
+        return NULL;
+    return iter->second;
+}
+
+/************************************************************************/
+/*                         GetIOStatsPrefixes()                         */
+/************************************************************************/
+
+std::vector<std::string> VSIFileManager::GetIOStatsPrefixes()
+
+{
+    VSIFileManager *poThis = Get();
+    std::vector<std::string> aosPrefixes;
+    std::map<std::string,VSIIOStats*>::const_iterator iter;
+    for( iter = poThis->oIOStats.begin();
+         iter != poThis->oIOStats.end();
+         ++iter )
+    {
+        aosPrefixes.push_back(iter->first);
+    }
+    return aosPrefixes;
+}
+
+/************************************************************************/
+/*                        VSISetIOStatsEnabled()                        */
+/************************************************************************/
+
+/**
+ * \brief Enable or disable the collection of I/O statistics.
+ *
+ * When enabled, the VSIF*L() functions account, for each virtual file
+ * system prefix, the number of opens, reads, bytes, seeks, writes and
+ * multi-range reads, as well as histograms of the open, read and write
+ * latencies. The counters are updated with atomic operations and no lock,
+ * so the collection can be left on in production.
+ *
+ * The collection is initially enabled if the CPL_VSIL_STATS configuration
+ * option is set to YES when the first VSI*L() call is done. If the
+ * CPL_VSIL_STATS_FILE configuration option is set to a filename, stdout or
+ * stderr, the statistics are written there in JSON by
+ * VSICleanupFileManager() (that GDALDestroyDriverManager() calls).
+ *
+ * Note that a file system that reads from other files (such as /vsizip/
+ * or /vsigzip/ on a regular file) is accounted both under its own prefix
+ * and under the prefix of the underlying file.
+ *
+ * @param bEnabled TRUE to enable the statistics.
+ * @since GDAL 2.0
+ */
+
+void VSISetIOStatsEnabled( int bEnabled )
+{
+    VSIFileManager::GetIOStats( "" ); /* makes sure the manager is created */
+    bVSIIOStatsEnabled = bEnabled;
+}
+
+/************************************************************************/
+/*                         VSIIsIOStatsEnabled()                        */
+/************************************************************************/
+
+/**
+ * \brief Return whether the I/O statistics are collected.
+ *
+ * @see VSISetIOStatsEnabled()
+ * @since GDAL 2.0
+ */
+
+int VSIIsIOStatsEnabled()
+{
+    VSIFileManager::GetIOStats( "" ); /* makes sure the manager is created */
+    return bVSIIOStatsEnabled;
+}
+
+/************************************************************************/
+/*                            VSIGetIOStats()                           */
+/************************************************************************/
+
+/**
+ * \brief Fetch the I/O statistics of a virtual file system.
+ *
+ * The counters are read without lock, so they may be slightly out of sync
+ * with each other while other threads do I/O.
+ *
+ * @param pszPrefix the prefix of the file system, as returned by
+ * VSIGetIOStatsPrefixes() (for example "/vsicurl/"), or "" for the
+ * regular files.
+ * @param psStats structure to fill.
+ *
+ * @return TRUE on success, or FALSE if there is no such prefix.
+ * @since GDAL 2.0
+ */
+
+int VSIGetIOStats( const char* pszPrefix, VSIIOStats* psStats )
+{
+    VSIIOStats* psIOStats = VSIFileManager::GetIOStats( pszPrefix );
+    if( psIOStats == NULL )
+    {
+        memset( psStats, 0, sizeof(VSIIOStats) );
+        return FALSE;
+    }
+    memcpy( psStats, psIOStats, sizeof(VSIIOStats) );
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        VSIGetIOStatsPrefixes()                       */
+/************************************************************************/
+
+/**
+ * \brief Return the prefixes for which I/O statistics are collected.
+ *
+ * The empty string designates the regular files.
+ *
+ * @return a list of prefixes, to free with CSLDestroy().
+ * @since GDAL 2.0
+ */
+
+char **VSIGetIOStatsPrefixes()
+{
+    std::vector<std::string> aosPrefixes = VSIFileManager::GetIOStatsPrefixes();
+    CPLStringList aosList;
+    for( size_t i = 0; i < aosPrefixes.size(); i++ )
+        aosList.AddString( aosPrefixes[i].c_str() );
+    return aosList.StealList();
+}
+
+/************************************************************************/
+/*                           VSIResetIOStats()                          */
+/************************************************************************/
+
+/**
+ * \brief Reset the I/O statistics of all the file systems.
+ *
+ * @since GDAL 2.0
+ */
+
+void VSIResetIOStats()
+{
+    std::vector<std::string> aosPrefixes = VSIFileManager::GetIOStatsPrefixes();
+    for( size_t i = 0; i < aosPrefixes.size(); i++ )
+    {
+        VSIIOStats* psIOStats = VSIFileManager::GetIOStats( aosPrefixes[i] );
+        memset( psIOStats, 0, sizeof(VSIIOStats) );
+    }
+}
+
+/************************************************************************/
+/*                         VSIIOStatsAddJSON()                          */
+/************************************************************************/
+
+static void VSIIOStatsAddJSONHistogram( CPLString& osJSON,
+                                        const char* pszName,
+                                        const GIntBig* panHistogram )
+{
+    /* Keys are the (exclusive) upper bound of the buckets, in microseconds */
+    osJSON += CPLSPrintf(",\n      \"%s\": {", pszName);
+    int bFirst = TRUE;
+    for( int i = 0; i < VSI_IO_STATS_LATENCY_BUCKETS; i++ )
+    {
+        if( panHistogram[i] == 0 )
+            continue;
+        if( !bFirst )
+            osJSON += ", ";
+        bFirst = FALSE;
+        if( i == VSI_IO_STATS_LATENCY_BUCKETS - 1 )
+            osJSON += "\"inf\": ";
+        else
+            osJSON += CPLSPrintf("\"%d\": ", 1 << i);
+        osJSON += CPLSPrintf(CPL_FRMT_GIB, panHistogram[i]);
+    }
+    osJSON += "}";
+}
+
+/************************************************************************/
+/*                         VSIGetIOStatsAsJSON()                        */
+/************************************************************************/
+
+/**
+ * \brief Return the I/O statistics of the file systems as JSON.
+ *
+ * The file systems that have not been used are omitted. The latency
+ * histograms map the upper bound of each bucket, in microseconds, to
+ * the number of operations that took at least half that time and less
+ * than it. Empty buckets are omitted.
+ *
+ * @return a JSON string, to free with CPLFree().
+ * @since GDAL 2.0
+ */
+
+char *VSIGetIOStatsAsJSON()
+{
+    CPLString osJSON;
+    osJSON.Printf("{\n  \"enabled\": %s,\n  \"filesystems\": [",
+                  VSIIsIOStatsEnabled() ? "true" : "false");
+
+    std::vector<std::string> aosPrefixes = VSIFileManager::GetIOStatsPrefixes();
+    int bFirst = TRUE;
+    for( size_t i = 0; i < aosPrefixes.size(); i++ )
+    {
+        VSIIOStats sStats;
+        VSIGetIOStats( aosPrefixes[i].c_str(), &sStats );
+        if( sStats.nOpens == 0 && sStats.nStats == 0 )
+            continue;
+
+        osJSON += bFirst ? "\n" : ",\n";
+        bFirst = FALSE;
+        osJSON += CPLSPrintf("    {\n      \"prefix\": \"%s\"",
+                             aosPrefixes[i].c_str());
+#define ADD_COUNTER(name, field) \
+        osJSON += CPLSPrintf(",\n      \"%s\": " CPL_FRMT_GIB, name, sStats.field)
+        ADD_COUNTER("opens", nOpens);
+        ADD_COUNTER("open_failures", nOpenFailures);
+        ADD_COUNTER("stats", nStats);
+        ADD_COUNTER("reads", nReads);
+        ADD_COUNTER("bytes_read", nBytesRead);
+        ADD_COUNTER("multi_range_reads", nMultiRangeReads);
+        ADD_COUNTER("ranges_read", nRangesRead);
+        ADD_COUNTER("async_reads", nAsyncReads);
+        ADD_COUNTER("writes", nWrites);
+        ADD_COUNTER("bytes_written", nBytesWritten);
+        ADD_COUNTER("seeks", nSeeks);
+#undef ADD_COUNTER
+        VSIIOStatsAddJSONHistogram( osJSON, "open_latency_us",
+                                    sStats.anOpenLatency );
+        VSIIOStatsAddJSONHistogram( osJSON, "read_latency_us",
+                                    sStats.anReadLatency );
+        VSIIOStatsAddJSONHistogram( osJSON, "write_latency_us",
+                                    sStats.anWriteLatency );
+        osJSON += "\n    }";
+    }
+    osJSON += "\n  ]\n}\n";
+
+    return CPLStrdup(osJSON);
+}
+
+/************************************************************************/
+/*                           VSIDumpIOStats()                           */
+/************************************************************************/
+
+static void VSIDumpIOStats()
+{
+    const char* pszStatsFile = CPLGetConfigOption("CPL_VSIL_STATS_FILE", NULL);
+    if( poManager == NULL || !bVSIIOStatsEnabled || pszStatsFile == NULL )
+        return;
+
+    FILE* fp;
+    if( EQUAL(pszStatsFile, "stdout") )
+        fp = stdout;
+    else if( EQUAL(pszStatsFile, "stderr") )
+        fp = stderr;
     else
-        Get()->oHandlers[osPrefix] = poHandler;
+        fp = VSIFOpen(pszStatsFile, "wb");
+    if( fp == NULL )
+    {
+        CPLError(CE_Failure, CPLE_OpenFailed,
+                 "Cannot create %s", pszStatsFile);
+        return;
+    }
+
+    char* pszJSON = VSIGetIOStatsAsJSON();
+    VSIFWrite(pszJSON, 1, strlen(pszJSON), fp);
+    CPLFree(pszJSON);
+
+    if( fp == stdout || fp == stderr )
+        VSIFFlush(fp);
+    else
+        VSIFClose(fp);
 }
 
 /************************************************************************/
@@ -1196,6 +1826,29 @@ void VSIFileManager::InstallHandler( const std::string& osPrefix,
 void VSICleanupFileManager()
 
 {
+    VSIDumpIOStats();
+
+    /* Run the queued asynchronous reads before the handlers go away */
+    if( poAsyncReadPool )
+    {
+        delete poAsyncReadPool;
+        poAsyncReadPool = NULL;
+    }
+
+    if( hAsyncReadCond != NULL )
+    {
+        CPLDestroyCond(hAsyncReadCond);
+        hAsyncReadCond = NULL;
+    }
+
+    if( hAsyncReadMutex != NULL )
+    {
+        CPLDestroyMutex(hAsyncReadMutex);
+        hAsyncReadMutex = NULL;
+    }
+
+    VSICleanupCachedFiles();
+
     if( poManager )
     {
         delete poManager;
@@ -1239,3 +1892,159 @@ int VSIVirtualHandle::ReadMultiRange( int nRanges, void ** ppData,
 
     return nRet;
 }
+
+/************************************************************************/
+/*                               ReadAt()                               */
+/************************************************************************/
+
+size_t VSIVirtualHandle::ReadAt( vsi_l_offset nOffset, void *pBuffer,
+                                 size_t nSize )
+{
+    size_t nRead = 0;
+    vsi_l_offset nCurOffset = Tell();
+    if( Seek( nOffset, SEEK_SET ) == 0 )
+        nRead = Read( pBuffer, 1, nSize );
+    Seek( nCurOffset, SEEK_SET );
+
+    return nRead;
+}
+
+/************************************************************************/
+/*                      VSICreateAsyncReadRequest()                     */
+/************************************************************************/
+
+VSIAsyncReadRequest *VSICreateAsyncReadRequest( VSIVirtualHandle* poHandle,
+                                                vsi_l_offset nOffset,
+                                                void* pBuffer, size_t nSize,
+                                                VSIAsyncReadCallback pfnCallback,
+                                                void* pUserData )
+{
+    VSIAsyncReadRequest* psRequest = (VSIAsyncReadRequest*)
+        CPLCalloc(1, sizeof(VSIAsyncReadRequest));
+    psRequest->poHandle = poHandle;
+    psRequest->nOffset = nOffset;
+    psRequest->pBuffer = pBuffer;
+    psRequest->nSize = nSize;
+    psRequest->pfnCallback = pfnCallback;
+    psRequest->pUserData = pUserData;
+
+    CPLMutexHolder oHolder( &hAsyncReadMutex );
+    if( hAsyncReadCond == NULL )
+        hAsyncReadCond = CPLCreateCond();
+    poHandle->nAsyncPending ++;
+
+    return psRequest;
+}
+
+/************************************************************************/
+/*                     VSICompleteAsyncReadRequest()                    */
+/************************************************************************/
+
+void VSICompleteAsyncReadRequest( VSIAsyncReadRequest* psRequest,
+                                  size_t nResult )
+{
+    psRequest->nResult = nResult;
+    VSIIOStats* psIOStats = psRequest->poHandle->GetIOStats();
+    if( bVSIIOStatsEnabled && psIOStats != NULL )
+        CPLAtomicAdd64( &psIOStats->nBytesRead, (GIntBig)nResult );
+    if( psRequest->pfnCallback != NULL )
+        psRequest->pfnCallback( psRequest, psRequest->pUserData );
+
+    /* The handle may be closed as soon as the request is complete */
+    CPLMutexHolder oHolder( &hAsyncReadMutex );
+    psRequest->poHandle->nAsyncPending --;
+    psRequest->poHandle = NULL;
+    psRequest->bComplete = TRUE;
+    CPLCondBroadcast( hAsyncReadCond );
+}
+
+/************************************************************************/
+/*                        VSISubmitAsyncReadJob()                       */
+/************************************************************************/
+
+void VSISubmitAsyncReadJob( CPLThreadFunc pfnFunc, void* pData )
+{
+    CPLWorkerThreadPool* poPool;
+    {
+        CPLMutexHolder oHolder( &hAsyncReadMutex );
+        if( poAsyncReadPool == NULL )
+        {
+            const char* pszThreads =
+                CPLGetConfigOption("CPL_VSIL_ASYNC_NUM_THREADS", "4");
+            int nThreads;
+            if( EQUAL(pszThreads, "ALL_CPUS") )
+                nThreads = CPLGetNumCPUs();
+            else
+                nThreads = atoi(pszThreads);
+            if( nThreads < 1 )
+                nThreads = 1;
+
+            poAsyncReadPool = new CPLWorkerThreadPool();
+            if( poAsyncReadPool->Setup(nThreads) == 0 )
+                CPLDebug("VSI", "No worker thread available: "
+                         "asynchronous reads will be run synchronously");
+        }
+        poPool = poAsyncReadPool;
+    }
+
+    poPool->SubmitJob( pfnFunc, pData );
+}
+
+/************************************************************************/
+/*                         VSIDefaultAsyncRead()                        */
+/************************************************************************/
+
+static void VSIDefaultAsyncRead( void* pData )
+{
+    VSIAsyncReadRequest* psRequest = (VSIAsyncReadRequest*) pData;
+    VSIVirtualHandle* poHandle = psRequest->poHandle;
+    size_t nRead = 0;
+
+    {
+        CPLMutexHolder oHolder( poHandle->GetAsyncMutex() );
+
+        nRead = poHandle->ReadAt( psRequest->nOffset, psRequest->pBuffer,
+                                  psRequest->nSize );
+    }
+
+    VSICompleteAsyncReadRequest( psRequest, nRead );
+}
+
+/************************************************************************/
+/*                              ReadAsync()                             */
+/************************************************************************/
+
+VSIAsyncReadRequest *VSIVirtualHandle::ReadAsync( vsi_l_offset nOffset,
+                                                  void* pBuffer, size_t nSize,
+                                                  VSIAsyncReadCallback pfnCallback,
+                                                  void* pUserData )
+{
+    /* From now on, the VSIF*L() calls on this handle will take that mutex */
+    if( hAsyncMutex == NULL )
+    {
+        hAsyncMutex = CPLCreateMutex();
+        CPLReleaseMutex( hAsyncMutex );
+    }
+
+    VSIAsyncReadRequest* psRequest =
+        VSICreateAsyncReadRequest( this, nOffset, pBuffer, nSize,
+                                   pfnCallback, pUserData );
+    VSISubmitAsyncReadJob( VSIDefaultAsyncRead, psRequest );
+
+    return psRequest;
+}
+
+/************************************************************************/
+/*                            WaitAsyncReads()                          */
+/************************************************************************/
+
+void VSIVirtualHandle::WaitAsyncReads()
+{
+    /* No request was ever created */
+    if( hAsyncReadMutex == NULL )
+        return;
+
+    CPLMutexHolder oHolder( &hAsyncReadMutex );
+    while( nAsyncPending > 0 )
+        CPLCondWait( hAsyncReadCond, hAsyncReadMutex );
+}
@@ -29,9 +29,27 @@
  ****************************************************************************/
 
 #include "cpl_vsi_virtual.h"
+#include "cpl_multiproc.h"
 
 CPL_CVSID("$Id$");
 
+/*
+** Notes on the cache:
+**
+** The chunks are shared by all the VSICachedFile handles of the process.
+** A file is identified by its absolute name, its size, its modification
+** time and the chunk size, so that two datasets opened on the same file
+** share their chunks, while a file rewritten by another process is not
+** served from stale chunks (unless its size and modification time, which
+** has a one second resolution, are unchanged).  The total size of the
+** chunks is limited by VSI_CACHE_SIZE, or by the largest cache size given
+** to VSICreateCachedFile() if larger, with a single LRU list for all the
+** files.  All the cache structures are protected by hCacheMutex, which is
+** never held while doing I/O on the base handles.
+*/
+
+class VSICacheFile;
+
 /************************************************************************/
 /* ==================================================================== */
 /*                             VSICacheChunk                            */
@@ -45,8 +63,9 @@ public:
     { 
         poLRUPrev = poLRUNext = NULL;
         nDataFilled = 0;
-        bDirty = FALSE;
         pabyData = NULL;
+        poFile = NULL;
+        iBlock = 0;
     }
 
     virtual ~VSICacheChunk()
@@ -61,7 +80,7 @@ public:
         return (pabyData != NULL);
     }
 
-    int            bDirty;
+    VSICacheFile  *poFile;
     vsi_l_offset   iBlock;
 
     VSICacheChunk *poLRUPrev;
@@ -71,6 +90,173 @@ public:
     GByte          *pabyData;
 };
 
+/************************************************************************/
+/* ==================================================================== */
+/*                             VSICacheFile                             */
+/* ==================================================================== */
+/************************************************************************/
+
+/* The cached chunks of a file, shared by the handles opened on it */
+class VSICacheFile
+{
+public:
+    VSICacheFile() : nHandles(0) {}
+
+    CPLString      osKey;
+    CPLString      osFilename;
+    int            nHandles;
+    std::map<vsi_l_offset, VSICacheChunk*> oChunks;
+};
+
+static CPLMutex *hCacheMutex = NULL;
+static std::map<CPLString, VSICacheFile*> *poCacheFiles = NULL;
+static VSICacheChunk *poLRUStart = NULL;
+static VSICacheChunk *poLRUEnd = NULL;
+static GUIntBig nCacheUsed = 0;
+static GUIntBig nCacheMax = 0;
+static GUIntBig nCacheMaxRequested = 0;
+
+/************************************************************************/
+/*                     VSICacheGetCanonicalFilename()                   */
+/*                                                                      */
+/*      Make local filenames absolute, and remove redundant "/./" and   */
+/*      "//", so that the different spellings of the name of a file,    */
+/*      as given to VSIFOpenL() and VSIUnlink(), map to the same        */
+/*      cache entry.                                                    */
+/************************************************************************/
+
+static CPLString VSICacheGetCanonicalFilename( const char *pszFilename )
+
+{
+    CPLString osFilename( pszFilename );
+    if( strncmp( pszFilename, "/vsi", 4 ) == 0 )
+        return osFilename;
+
+    if( CPLIsFilenameRelative( pszFilename ) )
+    {
+        char *pszCurDir = CPLGetCurrentDir();
+        if( pszCurDir != NULL )
+        {
+            osFilename = CPLFormFilename( pszCurDir, pszFilename, NULL );
+            CPLFree( pszCurDir );
+        }
+    }
+
+#ifdef WIN32
+    for( size_t i = 0; i < osFilename.size(); i++ )
+    {
+        if( osFilename[i] == '\\' )
+            osFilename[i] = '/';
+    }
+#endif
+
+    /* Keep a leading "//" of UNC paths */
+    size_t nPos;
+    while( (nPos = osFilename.find( "/./" )) != std::string::npos )
+        osFilename.erase( nPos, 2 );
+    while( (nPos = osFilename.find( "//", 1 )) != std::string::npos )
+        osFilename.erase( nPos, 1 );
+
+    return osFilename;
+}
+
+/************************************************************************/
+/*                            VSICacheDemote()                          */
+/*                                                                      */
+/*      Demote the indicated block to the end of the LRU list.          */
+/*      Potentially integrate the link into the list if it is not       */
+/*      already there.                                                  */
+/************************************************************************/
+
+static void VSICacheDemote( VSICacheChunk *poBlock )
+
+{
+    // already at end?
+    if( poLRUEnd == poBlock )
+        return;
+    
+    if( poLRUStart == poBlock )
+        poLRUStart = poBlock->poLRUNext;
+
+    if( poBlock->poLRUPrev != NULL )
+        poBlock->poLRUPrev->poLRUNext = poBlock->poLRUNext;
+
+    if( poBlock->poLRUNext != NULL )
+        poBlock->poLRUNext->poLRUPrev = poBlock->poLRUPrev;
+
+    poBlock->poLRUNext = NULL;
+    poBlock->poLRUPrev = NULL;
+
+    if( poLRUEnd != NULL )
+    {
+        poLRUEnd->poLRUNext = poBlock;
+        poBlock->poLRUPrev = poLRUEnd;
+    }
+    poLRUEnd = poBlock;
+    
+    if( poLRUStart == NULL )
+        poLRUStart = poBlock;
+}
+
+/************************************************************************/
+/*                         VSICacheReleaseFile()                        */
+/*                                                                      */
+/*      Destroy a file that has neither handle nor chunk anymore.       */
+/************************************************************************/
+
+static void VSICacheReleaseFile( VSICacheFile *poFile )
+
+{
+    if( poFile->nHandles == 0 && poFile->oChunks.empty() )
+    {
+        poCacheFiles->erase( poFile->osKey );
+        delete poFile;
+    }
+}
+
+/************************************************************************/
+/*                          VSICacheFreeChunk()                         */
+/************************************************************************/
+
+static void VSICacheFreeChunk( VSICacheChunk *poBlock )
+
+{
+    CPLAssert( nCacheUsed >= poBlock->nDataFilled );
+
+    nCacheUsed -= poBlock->nDataFilled;
+
+    if( poLRUStart == poBlock )
+        poLRUStart = poBlock->poLRUNext;
+    if( poLRUEnd == poBlock )
+        poLRUEnd = poBlock->poLRUPrev;
+    if( poBlock->poLRUPrev != NULL )
+        poBlock->poLRUPrev->poLRUNext = poBlock->poLRUNext;
+    if( poBlock->poLRUNext != NULL )
+        poBlock->poLRUNext->poLRUPrev = poBlock->poLRUPrev;
+
+    poBlock->poFile->oChunks.erase( poBlock->iBlock );
+
+    delete poBlock;
+}
+
+/************************************************************************/
+/*                            VSICacheTrim()                            */
+/*                                                                      */
+/*      Evict the least recently used chunks until the cache fits in    */
+/*      its budget.                                                     */
+/************************************************************************/
+
+static void VSICacheTrim()
+
+{
+    while( nCacheUsed > nCacheMax && poLRUStart != NULL )
+    {
+        VSICacheFile *poFile = poLRUStart->poFile;
+        VSICacheFreeChunk( poLRUStart );
+        VSICacheReleaseFile( poFile );
+    }
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*                             VSICachedFile                            */
@@ -81,29 +267,27 @@ class VSICachedFile : public VSIVirtualHandle
 { 
   public:
     VSICachedFile( VSIVirtualHandle *poBaseHandle, 
+                   const char *pszFilename,
                    size_t nChunkSize,
                    size_t nCacheSize );
     ~VSICachedFile() { Close(); }
 
-    void          FlushLRU();
-    int           LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount, 
-                              void *pBuffer, size_t nBufferSize );
-    void          Demote( VSICacheChunk * );
+    VSICacheChunk *FindBlock( vsi_l_offset iBlock );
+    size_t        LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
+                              GByte *pabyWorkBuffer );
 
     VSIVirtualHandle *poBase;
+    VSICacheFile *poFile;
     
     vsi_l_offset  nOffset;
     vsi_l_offset  nFileSize;
 
-    GUIntBig      nCacheUsed;
-    GUIntBig      nCacheMax;
-
     size_t        nChunkSize;
 
-    VSICacheChunk *poLRUStart;
-    VSICacheChunk *poLRUEnd;
-
-    std::vector<VSICacheChunk*> apoCache;
+    /* Adaptive read-ahead */
+    vsi_l_offset  nLastBlock;
+    size_t        nReadAheadBlocks;
+    size_t        nMaxReadAheadBlocks;
 
     int            bEOF;
 
@@ -121,27 +305,73 @@ class VSICachedFile : public VSIVirtualHandle
 /*                           VSICachedFile()                            */
 /************************************************************************/
 
-VSICachedFile::VSICachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize, size_t nCacheSize )
+VSICachedFile::VSICachedFile( VSIVirtualHandle *poBaseHandle,
+                              const char *pszFilename,
+                              size_t nChunkSize, size_t nCacheSize )
 
 {
     poBase = poBaseHandle;
     this->nChunkSize = nChunkSize;
 
-    nCacheUsed = 0;
-    if ( nCacheSize == 0 )
-        nCacheMax = CPLScanUIntBig( 
-             CPLGetConfigOption( "VSI_CACHE_SIZE", "25000000" ), 40 );
-    else
-        nCacheMax = nCacheSize;
-
-    poLRUStart = NULL;
-    poLRUEnd = NULL;
-
     poBase->Seek( 0, SEEK_END );
     nFileSize = poBase->Tell();
 
     nOffset = 0;
     bEOF = FALSE;
+
+    nLastBlock = (vsi_l_offset) -2;
+    nReadAheadBlocks = 0;
+    nMaxReadAheadBlocks = (size_t) (CPLScanUIntBig(
+        CPLGetConfigOption( "VSI_CACHE_READAHEAD_MAX", "1048576" ), 40 )
+                                    / nChunkSize);
+
+    CPLString osFilename;
+    GIntBig nMTime = 0;
+    if( pszFilename != NULL )
+    {
+        osFilename = VSICacheGetCanonicalFilename( pszFilename );
+
+        VSIStatBufL sStat;
+        if( VSIStatL( pszFilename, &sStat ) == 0 )
+            nMTime = (GIntBig) sStat.st_mtime;
+    }
+
+    const GUIntBig nConfigCacheSize = CPLScanUIntBig(
+        CPLGetConfigOption( "VSI_CACHE_SIZE", "25000000" ), 40 );
+
+/* -------------------------------------------------------------------- */
+/*      Attach to the shared chunks of the file.                        */
+/* -------------------------------------------------------------------- */
+    CPLMutexHolder oHolder( &hCacheMutex );
+
+    if( poCacheFiles == NULL )
+        poCacheFiles = new std::map<CPLString, VSICacheFile*>;
+
+    /* The budget is shared: grow it to the largest size ever requested */
+    if( nCacheSize > nCacheMaxRequested )
+        nCacheMaxRequested = nCacheSize;
+    nCacheMax = MAX( nConfigCacheSize, nCacheMaxRequested );
+    VSICacheTrim();
+
+    CPLString osKey;
+    osKey.Printf( CPL_FRMT_GUIB ":" CPL_FRMT_GIB ":%d:%s", (GUIntBig) nFileSize,
+                  nMTime, (int) nChunkSize, osFilename.c_str() );
+    /* A handle without name cannot share its chunks */
+    if( pszFilename == NULL )
+        osKey += CPLSPrintf( ":%p", this );
+
+    std::map<CPLString, VSICacheFile*>::iterator oIter =
+        poCacheFiles->find( osKey );
+    if( oIter != poCacheFiles->end() )
+        poFile = oIter->second;
+    else
+    {
+        poFile = new VSICacheFile;
+        poFile->osKey = osKey;
+        poFile->osFilename = osFilename;
+        (*poCacheFiles)[osKey] = poFile;
+    }
+    poFile->nHandles ++;
 }
 
 /************************************************************************/
@@ -151,16 +381,13 @@ VSICachedFile::VSICachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize,
 int VSICachedFile::Close()
 
 {
-    size_t i;
-    for( i = 0; i < apoCache.size(); i++ )
-        delete apoCache[i];
-
-    apoCache.resize( 0 );
-
-    poLRUStart = NULL;
-    poLRUEnd = NULL;
-
-    nCacheUsed = 0;
+    if( poFile != NULL )
+    {
+        CPLMutexHolder oHolder( &hCacheMutex );
+        poFile->nHandles --;
+        VSICacheReleaseFile( poFile );
+        poFile = NULL;
+    }
 
     if( poBase )
     {
@@ -212,139 +439,32 @@ vsi_l_offset VSICachedFile::Tell()
 }
 
 /************************************************************************/
-/*                              FlushLRU()                              */
-/************************************************************************/
-
-void VSICachedFile::FlushLRU()
-
-{
-    CPLAssert( poLRUStart != NULL );
-
-    VSICacheChunk *poBlock = poLRUStart;
-
-    CPLAssert( nCacheUsed >= poBlock->nDataFilled );
-
-    nCacheUsed -= poBlock->nDataFilled;
-    
-    poLRUStart = poBlock->poLRUNext;
-    if( poLRUEnd == poBlock )
-        poLRUEnd = NULL;
-
-    if( poBlock->poLRUNext != NULL )
-        poBlock->poLRUNext->poLRUPrev = NULL;
-
-    CPLAssert( !poBlock->bDirty );
-
-    apoCache[poBlock->iBlock] = NULL;
-
-    delete poBlock;
-}
-
-/************************************************************************/
-/*                               Demote()                               */
+/*                              FindBlock()                             */
 /*                                                                      */
-/*      Demote the indicated block to the end of the LRU list.          */
-/*      Potentially integrate the link into the list if it is not       */
-/*      already there.                                                  */
+/*      hCacheMutex must be held.                                       */
 /************************************************************************/
 
-void VSICachedFile::Demote( VSICacheChunk *poBlock )
+VSICacheChunk *VSICachedFile::FindBlock( vsi_l_offset iBlock )
 
 {
-    // already at end?
-    if( poLRUEnd == poBlock )
-        return;
-    
-    if( poLRUStart == poBlock )
-        poLRUStart = poBlock->poLRUNext;
-
-    if( poBlock->poLRUPrev != NULL )
-        poBlock->poLRUPrev->poLRUNext = poBlock->poLRUNext;
-
-    if( poBlock->poLRUNext != NULL )
-        poBlock->poLRUNext->poLRUPrev = poBlock->poLRUPrev;
-
-    poBlock->poLRUNext = NULL;
-    poBlock->poLRUPrev = NULL;
-
-    if( poLRUEnd != NULL )
-        poLRUEnd->poLRUNext = poBlock;
-    poLRUEnd = poBlock;
-    
-    if( poLRUStart == NULL )
-        poLRUStart = poBlock;
+    std::map<vsi_l_offset, VSICacheChunk*>::iterator oIter =
+        poFile->oChunks.find( iBlock );
+    if( oIter == poFile->oChunks.end() )
+        return NULL;
+    return oIter->second;
 }
 
 /************************************************************************/
 /*                             LoadBlocks()                             */
 /*                                                                      */
-/*      Load the desired set of blocks.  Use pBuffer as a temporary     */
-/*      buffer if it would be helpful.                                  */
+/*      Read the desired set of blocks into pabyWorkBuffer, and add     */
+/*      them to the cache.  Return the number of bytes read.            */
 /************************************************************************/
 
-int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
-                               void *pBuffer, size_t nBufferSize )
+size_t VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
+                                  GByte *pabyWorkBuffer )
 
 {
-    if( nBlockCount == 0 )
-        return 1;
-
-    if( apoCache.size() < nStartBlock + nBlockCount )
-        apoCache.resize( nStartBlock + nBlockCount );
-
-/* -------------------------------------------------------------------- */
-/*      When we want to load only one block, we can directly load it    */
-/*      into the target buffer with no concern about intermediaries.    */
-/* -------------------------------------------------------------------- */
-    if( nBlockCount == 1 )
-    {
-        poBase->Seek( (vsi_l_offset)nStartBlock * nChunkSize, SEEK_SET );
-
-        VSICacheChunk *poBlock = new VSICacheChunk();
-        if ( !poBlock || !poBlock->Allocate( nChunkSize ) )
-        {
-            delete poBlock;
-            return 0;
-        }
-
-        apoCache[nStartBlock] = poBlock;
-
-        poBlock->iBlock = nStartBlock;
-        poBlock->nDataFilled = poBase->Read( poBlock->pabyData, 1, nChunkSize );
-        nCacheUsed += poBlock->nDataFilled;
-
-        // Merges into the LRU list. 
-        Demote( poBlock );
-
-        return 1;
-    }
-
-/* -------------------------------------------------------------------- */
-/*      If the buffer is quite large but not quite large enough to      */
-/*      hold all the blocks we will take the pain of splitting the      */
-/*      io request in two in order to avoid allocating a large          */
-/*      temporary buffer.                                               */
-/* -------------------------------------------------------------------- */
-    if( nBufferSize > nChunkSize * 20 
-        && nBufferSize < nBlockCount * nChunkSize )
-    {
-        if( !LoadBlocks( nStartBlock, 2, pBuffer, nBufferSize ) )
-            return 0;
-
-        return LoadBlocks( nStartBlock+2, nBlockCount-2, pBuffer, nBufferSize );
-    }
-
-/* -------------------------------------------------------------------- */
-/*      Do we need to allocate our own buffer?                          */
-/* -------------------------------------------------------------------- */
-    GByte *pabyWorkBuffer = (GByte *) pBuffer;
-
-    if( nBufferSize < nChunkSize * nBlockCount )
-        pabyWorkBuffer = (GByte *) CPLMalloc(nChunkSize * nBlockCount);
-
-/* -------------------------------------------------------------------- */
-/*      Read the whole request into the working buffer.                 */
-/* -------------------------------------------------------------------- */
     if( poBase->Seek( (vsi_l_offset)nStartBlock * nChunkSize, SEEK_SET ) != 0 )
         return 0;
 
@@ -353,21 +473,24 @@ int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
     if( nBlockCount * nChunkSize > nDataRead + nChunkSize - 1 )
         nBlockCount = (nDataRead + nChunkSize - 1) / nChunkSize;
 
+    CPLMutexHolder oHolder( hCacheMutex );
+
     for( size_t i = 0; i < nBlockCount; i++ )
     {
+        /* Another handle on the same file may have loaded it meanwhile */
+        if( FindBlock( nStartBlock + i ) != NULL )
+            continue;
+
         VSICacheChunk *poBlock = new VSICacheChunk();
-        if ( !poBlock || !poBlock->Allocate( nChunkSize ) )
+        if ( !poBlock->Allocate( nChunkSize ) )
         {
             delete poBlock;
-            return 0;
+            break;
         }
 
+        poBlock->poFile = poFile;
         poBlock->iBlock = nStartBlock + i;
 
-        CPLAssert( apoCache[i+nStartBlock] == NULL );
-
-        apoCache[i + nStartBlock] = poBlock;
-
         if( nDataRead >= (i+1) * nChunkSize )
             poBlock->nDataFilled = nChunkSize;
         else
@@ -376,16 +499,16 @@ int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
         memcpy( poBlock->pabyData, pabyWorkBuffer + i*nChunkSize,
                 (size_t) poBlock->nDataFilled );
 
+        poFile->oChunks[poBlock->iBlock] = poBlock;
         nCacheUsed += poBlock->nDataFilled;
 
         // Merges into the LRU list. 
-        Demote( poBlock );
+        VSICacheDemote( poBlock );
     }
 
-    if( pabyWorkBuffer != pBuffer )
-        CPLFree( pabyWorkBuffer );
+    VSICacheTrim();
 
-    return 1;
+    return nDataRead;
 }
 
 /************************************************************************/
@@ -401,72 +524,125 @@ size_t VSICachedFile::Read( void * pBuffer, size_t nSize, size_t nCount )
         return 0;
     }
 
-/* ==================================================================== */
-/*      Make sure the cache is loaded for the whole request region.     */
-/* ==================================================================== */
-    vsi_l_offset nStartBlock = nOffset / nChunkSize;
-    vsi_l_offset nEndBlock = (nOffset + nSize * nCount - 1) / nChunkSize;
+    size_t nToRead = nSize * nCount;
+    if( nToRead == 0 )
+        return 0;
+    if( nToRead > nFileSize - nOffset )
+        nToRead = (size_t) (nFileSize - nOffset);
+
+    const vsi_l_offset nEndBlock = (nOffset + nToRead - 1) / nChunkSize;
+    const vsi_l_offset nLastFileBlock = (nFileSize - 1) / nChunkSize;
+
+/* -------------------------------------------------------------------- */
+/*      A read that does not start where the previous one ended         */
+/*      resets the read-ahead window.                                   */
+/* -------------------------------------------------------------------- */
+    const vsi_l_offset nStartBlock = nOffset / nChunkSize;
+    int bSequential = (nStartBlock == nLastBlock || nStartBlock == nLastBlock + 1);
+    if( !bSequential )
+        nReadAheadBlocks = 0;
 
-    for( vsi_l_offset iBlock = nStartBlock; iBlock <= nEndBlock; iBlock++ )
+    GByte *pabyDst = (GByte *) pBuffer;
+    size_t nAmountCopied = 0;
+
+    while( nAmountCopied < nToRead )
     {
-        if( apoCache.size() <= iBlock || apoCache[iBlock] == NULL )
+        const vsi_l_offset nPos = nOffset + nAmountCopied;
+        const vsi_l_offset iBlock = nPos / nChunkSize;
+        const vsi_l_offset nStartOffset = (vsi_l_offset)iBlock * nChunkSize;
+        size_t nBlocksToLoad;
+
+/* -------------------------------------------------------------------- */
+/*      Copy from the cache if the block is there.                      */
+/* -------------------------------------------------------------------- */
         {
-            size_t nBlocksToLoad = 1;
-            while( iBlock + nBlocksToLoad <= nEndBlock
-                   && (apoCache.size() <= iBlock+nBlocksToLoad 
-                       || apoCache[iBlock+nBlocksToLoad] == NULL) )
+            CPLMutexHolder oHolder( hCacheMutex );
+
+            VSICacheChunk *poBlock = FindBlock( iBlock );
+            if( poBlock != NULL )
+            {
+                VSICacheDemote( poBlock );
+
+                if( nPos >= nStartOffset + poBlock->nDataFilled )
+                    break;
+
+                size_t nThisCopy = (size_t)
+                    ((nStartOffset + poBlock->nDataFilled) - nPos);
+                if( nThisCopy > nToRead - nAmountCopied )
+                    nThisCopy = nToRead - nAmountCopied;
+
+                memcpy( pabyDst + nAmountCopied,
+                        poBlock->pabyData + (nPos - nStartOffset),
+                        nThisCopy );
+                nAmountCopied += nThisCopy;
+                continue;
+            }
+
+/* -------------------------------------------------------------------- */
+/*      Otherwise load the missing blocks of the request, plus the      */
+/*      read-ahead window which doubles at each sequential miss.        */
+/* -------------------------------------------------------------------- */
+            if( bSequential )
+            {
+                if( nReadAheadBlocks == 0 )
+                    nReadAheadBlocks = 1;
+                else
+                    nReadAheadBlocks = MIN( nReadAheadBlocks * 2,
+                                            nMaxReadAheadBlocks );
+                if( nReadAheadBlocks > nMaxReadAheadBlocks )
+                    nReadAheadBlocks = nMaxReadAheadBlocks;
+            }
+            /* The next misses of this request are sequential */
+            bSequential = TRUE;
+
+            const vsi_l_offset nMaxBlock =
+                MIN( nEndBlock + nReadAheadBlocks, nLastFileBlock );
+            nBlocksToLoad = 1;
+            while( iBlock + nBlocksToLoad <= nMaxBlock
+                   && FindBlock( iBlock + nBlocksToLoad ) == NULL )
                 nBlocksToLoad++;
+        }
 
-            LoadBlocks( iBlock, nBlocksToLoad, pBuffer, nSize * nCount );
+        /* Read directly into the target buffer when it is large enough */
+        GByte *pabyWorkBuffer = pabyDst + nAmountCopied;
+        const int bDirect = ( nPos == nStartOffset &&
+                              nToRead - nAmountCopied >= nBlocksToLoad * nChunkSize );
+        if( !bDirect )
+        {
+            pabyWorkBuffer = (GByte *) VSIMalloc( nBlocksToLoad * nChunkSize );
+            if( pabyWorkBuffer == NULL )
+            {
+                CPLError( CE_Failure, CPLE_OutOfMemory,
+                          "Cannot allocate %d bytes",
+                          (int) (nBlocksToLoad * nChunkSize) );
+                break;
+            }
         }
-    }
-    
-/* ==================================================================== */
-/*      Copy data into the target buffer to the extent possible.        */
-/* ==================================================================== */
-    size_t nAmountCopied = 0;
 
-    while( nAmountCopied < nSize * nCount )
-    {
-        vsi_l_offset iBlock = (nOffset + nAmountCopied) / nChunkSize;
-        size_t nThisCopy;
-        VSICacheChunk *poBlock = apoCache[iBlock];
-        if( poBlock == NULL )
+        size_t nDataRead = LoadBlocks( iBlock, nBlocksToLoad, pabyWorkBuffer );
+
+        size_t nThisCopy = 0;
+        if( nStartOffset + nDataRead > nPos )
         {
-            /* We can reach that point when the amount to read exceeds */
-            /* the cache size */
-            LoadBlocks( iBlock, 1, ((GByte *) pBuffer) + nAmountCopied,
-                        MIN(nSize * nCount - nAmountCopied, nChunkSize) );
-            poBlock = apoCache[iBlock];
-            CPLAssert(poBlock != NULL);
+            nThisCopy = (size_t) (nStartOffset + nDataRead - nPos);
+            if( nThisCopy > nToRead - nAmountCopied )
+                nThisCopy = nToRead - nAmountCopied;
+            if( !bDirect )
+                memcpy( pabyDst + nAmountCopied,
+                        pabyWorkBuffer + (nPos - nStartOffset), nThisCopy );
         }
 
-        vsi_l_offset nStartOffset = (vsi_l_offset)iBlock * nChunkSize;
-        nThisCopy = (size_t)
-            ((nStartOffset + poBlock->nDataFilled) 
-             - nAmountCopied - nOffset);
-        
-        if( nThisCopy > nSize * nCount - nAmountCopied )
-            nThisCopy = nSize * nCount - nAmountCopied;
+        if( !bDirect )
+            VSIFree( pabyWorkBuffer );
 
         if( nThisCopy == 0 )
             break;
-
-        memcpy( ((GByte *) pBuffer) + nAmountCopied,
-                poBlock->pabyData 
-                + (nOffset + nAmountCopied) - nStartOffset, 
-                nThisCopy );
-
         nAmountCopied += nThisCopy;
     }
     
     nOffset += nAmountCopied;
-
-/* -------------------------------------------------------------------- */
-/*      Ensure the cache is reduced to our limit.                       */
-/* -------------------------------------------------------------------- */
-    while( nCacheUsed > nCacheMax )
-        FlushLRU();
+    if( nAmountCopied > 0 )
+        nLastBlock = (nOffset - 1) / nChunkSize;
 
     size_t nRet = nAmountCopied / nSize;
     if (nRet != nCount)
@@ -509,9 +685,94 @@ int VSICachedFile::Flush()
 /*                        VSICreateCachedFile()                         */
 /************************************************************************/
 
+/**
+ * Wrap poBaseHandle, opened read-only on pszFilename, in a handle reading
+ * through the process-wide chunk cache. The cache is limited to
+ * VSI_CACHE_SIZE bytes (25 MB by default) for all the files, or to the
+ * largest nCacheSize passed to this function if larger, and sequential
+ * reads trigger a read-ahead of up to VSI_CACHE_READAHEAD_MAX bytes (1 MB
+ * by default). If pszFilename is NULL, the chunks are not shared with
+ * other handles.
+ */
+
 VSIVirtualHandle *
-VSICreateCachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize, size_t nCacheSize )
+VSICreateCachedFile( VSIVirtualHandle *poBaseHandle, const char *pszFilename,
+                     size_t nChunkSize, size_t nCacheSize )
+
+{
+    if( poBaseHandle == NULL )
+        return NULL;
+    return new VSICachedFile( poBaseHandle, pszFilename, nChunkSize, nCacheSize );
+}
+
+/************************************************************************/
+/*                       VSICachedFileInvalidate()                      */
+/************************************************************************/
+
+/**
+ * Drop the cached chunks of pszFilename, which is about to be modified.
+ */
+
+void VSICachedFileInvalidate( const char *pszFilename )
+
+{
+    if( poCacheFiles == NULL )
+        return;
+
+    const CPLString osFilename = VSICacheGetCanonicalFilename( pszFilename );
+
+    CPLMutexHolder oHolder( &hCacheMutex );
+    if( poCacheFiles == NULL )
+        return;
+
+    std::vector<VSICacheFile*> apoFiles;
+    std::map<CPLString, VSICacheFile*>::iterator oIter;
+    for( oIter = poCacheFiles->begin(); oIter != poCacheFiles->end(); ++oIter )
+    {
+        if( oIter->second->osFilename == osFilename )
+            apoFiles.push_back( oIter->second );
+    }
+
+    for( size_t i = 0; i < apoFiles.size(); i++ )
+    {
+        while( !apoFiles[i]->oChunks.empty() )
+            VSICacheFreeChunk( apoFiles[i]->oChunks.begin()->second );
+        VSICacheReleaseFile( apoFiles[i] );
+    }
+}
+
+/************************************************************************/
+/*                        VSICleanupCachedFiles()                       */
+/************************************************************************/
+
+void VSICleanupCachedFiles()
 
 {
-    return new VSICachedFile( poBaseHandle, nChunkSize, nCacheSize );
+    if( poCacheFiles != NULL )
+    {
+        {
+            CPLMutexHolder oHolder( &hCacheMutex );
+
+            while( poLRUStart != NULL )
+            {
+                VSICacheFile *poFile = poLRUStart->poFile;
+                VSICacheFreeChunk( poLRUStart );
+                VSICacheReleaseFile( poFile );
+            }
+
+            /* Files still opened keep their (empty) entry */
+            if( poCacheFiles->empty() )
+            {
+                delete poCacheFiles;
+                poCacheFiles = NULL;
+                nCacheMaxRequested = 0;
+            }
+        }
+
+        if( poCacheFiles == NULL && hCacheMutex != NULL )
+        {
+            CPLDestroyMutex( hCacheMutex );
+            hCacheMutex = NULL;
+        }
+    }
 }
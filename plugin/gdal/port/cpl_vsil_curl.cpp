@@ -65,6 +65,18 @@ int VSICurlUninstallReadCbk(CPL_UNUSED VSILFILE* fp)
     return FALSE;
 }
 
+/************************************************************************/
+/*                  VSICurlGetRegionCacheStatistics()                   */
+/************************************************************************/
+
+void VSICurlGetRegionCacheStatistics(GUIntBig* pnHits, GUIntBig* pnMisses,
+                                     GUIntBig* pnCachedBytes)
+{
+    *pnHits = 0;
+    *pnMisses = 0;
+    *pnCachedBytes = 0;
+}
+
 #else
 
 #include <curl/curl.h>
@@ -73,13 +85,33 @@ void CPLHTTPSetOptions(CURL *http_handle, char** papszOptions);
 void VSICurlSetOptions(CURL* hCurlHandle, const char* pszURL);
 
 #include <map>
+#include <vector>
+#include <algorithm>
+
+#ifdef WIN32
+#include <process.h>
+#include <sys/utime.h>
+#define VSICurlGetProcessId() _getpid()
+#else
+#include <unistd.h>
+#include <utime.h>
+#define VSICurlGetProcessId() getpid()
+#endif
 
 #define ENABLE_DEBUG 1
 
-#define N_MAX_REGIONS       1000
+/* Number of independently locked parts of the region cache */
+#define N_REGION_CACHE_SHARDS   16
+
+/* Signature of the files of the disk cache */
+#define VSICURL_CACHE_DISK_MAGIC "GDALVCC1"
 
 #define DOWNLOAD_CHUNCK_SIZE    16384
 
+/* Minimum number of DOWNLOAD_CHUNCK_SIZE blocks fetched by each connection */
+/* when a read-ahead is split across parallel requests */
+#define N_MIN_BLOCKS_PER_CONNECTION 4
+
 typedef enum
 {
     EXIST_UNKNOWN = -1,
@@ -94,6 +126,7 @@ typedef struct
     vsi_l_offset    fileSize;
     int             bIsDirectory;
     time_t          mTime;
+    char           *pszValidator; /* ETag or Last-Modified of the remote file */
 } CachedFileProp;
 
 typedef struct
@@ -102,18 +135,80 @@ typedef struct
     char**          papszFileList; /* only file name without path */
 } CachedDirList;
 
-typedef struct
+typedef struct _CachedRegion CachedRegion;
+
+struct _CachedRegion
 {
     unsigned long   pszURLHash;
     vsi_l_offset    nFileOffsetStart;
     size_t          nSize;
     char           *pData;
-} CachedRegion;
 
+    /* Links in the LRU list of the shard, most recently used first */
+    CachedRegion   *psPrev;
+    CachedRegion   *psNext;
+};
+
+typedef struct
+{
+    CPLMutex       *hMutex;
+    CPLHashSet     *hSetRegions;
+    CachedRegion   *psMostRecent;
+    CachedRegion   *psLeastRecent;
+    size_t          nCachedBytes;
+    GUIntBig        nHits;
+    GUIntBig        nMisses;
+} CachedRegionShard;
+
+
+/************************************************************************/
+/*                       VSICurlGetValidator()                          */
+/*                                                                      */
+/*      Extract the ETag, or failing that the Last-Modified value, of   */
+/*      a block of HTTP headers.                                        */
+/************************************************************************/
 
-static const char* VSICurlGetCacheFileName()
+static CPLString VSICurlGetValidator(const char* pszHeaders)
 {
-    return "gdal_vsicurl_cache.bin";
+    CPLString osLastModified;
+
+    if (pszHeaders == NULL)
+        return "";
+
+    char** papszLines = CSLTokenizeString2(pszHeaders, "\r\n", 0);
+    for(int i=0;papszLines != NULL && papszLines[i] != NULL;i++)
+    {
+        const char* pszLine = papszLines[i];
+        if (EQUALN(pszLine, "ETag:", 5))
+        {
+            CPLString osValidator = CPLString("ETag:") + (pszLine + 5);
+            CSLDestroy(papszLines);
+            return osValidator;
+        }
+        if (EQUALN(pszLine, "Last-Modified:", 14))
+            osLastModified = CPLString("Last-Modified:") + (pszLine + 14);
+    }
+    CSLDestroy(papszLines);
+
+    return osLastModified;
+}
+
+/************************************************************************/
+/*                        VSICurlHashString64()                         */
+/*                                                                      */
+/*      64 bit FNV-1a hash, used to name the files of the disk cache.   */
+/************************************************************************/
+
+static GUIntBig VSICurlHashString64(const char* pszStr)
+{
+    GUIntBig nHash = ((GUIntBig)0xCBF29CE4U << 32) | 0x84222325U;
+    const GUIntBig nPrime = ((GUIntBig)0x100U << 32) | 0x000001B3U;
+    for( ; *pszStr != '\0'; pszStr++ )
+    {
+        nHash ^= (unsigned char)*pszStr;
+        nHash *= nPrime;
+    }
+    return nHash;
 }
 
 /************************************************************************/
@@ -184,6 +279,47 @@ static int VSICurlIsFileInList( char ** papszList, const char * pszTarget )
     return nRet;
 }
 
+/************************************************************************/
+/*                       VSICurlHashCachedRegion()                      */
+/************************************************************************/
+
+static unsigned long VSICurlHashCachedRegion(const void* elt)
+{
+    const CachedRegion* psRegion = (const CachedRegion*) elt;
+    return psRegion->pszURLHash * 31 +
+           (unsigned long)(psRegion->nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE);
+}
+
+/************************************************************************/
+/*                      VSICurlEqualCachedRegion()                      */
+/************************************************************************/
+
+static int VSICurlEqualCachedRegion(const void* elt1, const void* elt2)
+{
+    const CachedRegion* psRegion1 = (const CachedRegion*) elt1;
+    const CachedRegion* psRegion2 = (const CachedRegion*) elt2;
+    return psRegion1->pszURLHash == psRegion2->pszURLHash &&
+           psRegion1->nFileOffsetStart == psRegion2->nFileOffsetStart;
+}
+
+/************************************************************************/
+/*                       VSICurlCopyFromRegion()                        */
+/*                                                                      */
+/*      Copy at most nSize bytes of a cached block, starting at         */
+/*      nOffsetInRegion, and return the number of bytes copied.         */
+/************************************************************************/
+
+static size_t VSICurlCopyFromRegion(const char* pData, size_t nRegionSize,
+                                    vsi_l_offset nOffsetInRegion,
+                                    void* pBuffer, size_t nSize)
+{
+    if (pBuffer == NULL || nOffsetInRegion >= nRegionSize)
+        return 0;
+    size_t nToCopy = (size_t) MIN(nSize, nRegionSize - nOffsetInRegion);
+    memcpy(pBuffer, pData + nOffsetInRegion, nToCopy);
+    return nToCopy;
+}
+
 /************************************************************************/
 /*                     VSICurlFilesystemHandler                         */
 /************************************************************************/
@@ -192,6 +328,7 @@ typedef struct
 {
     CPLString       osURL;
     CURL           *hCurlHandle;
+    CURLM          *hCurlMultiHandle;
 } CachedConnection;
 
 
@@ -199,13 +336,39 @@ class VSICurlFilesystemHandler : public VSIFilesystemHandler
 {
     CPLMutex       *hMutex;
 
-    CachedRegion  **papsRegions;
-    int             nRegions;
+    CachedRegionShard asRegionShards[N_REGION_CACHE_SHARDS];
+    size_t          nMaxCachedBytesPerShard;
+
+    CachedRegionShard  *GetRegionShard(unsigned long pszURLHash,
+                                       vsi_l_offset nFileOffsetStart);
 
     std::map<CPLString, CachedFileProp*>   cacheFileSize;
     std::map<CPLString, CachedDirList*>        cacheDirList;
 
     int             bUseCacheDisk;
+    CPLString       osCacheDiskDir;
+    GIntBig         nMaxCacheDiskBytes;
+    GIntBig         nCacheDiskBytesSinceTrim;
+    int             bCacheDiskTrimmed;
+    int             nCacheDiskTmpCounter;
+    CPLMutex       *hCacheDiskMutex;
+
+    CPLString           GetCacheDiskKey(const char* pszURL,
+                                        vsi_l_offset nFileOffsetStart);
+    CPLString           GetCacheDiskFilename(const CPLString& osKey);
+    void                TrimCacheDisk();
+
+    int                 GetRegionFromCacheMemory(unsigned long pszURLHash,
+                                                 vsi_l_offset nFileOffsetStart,
+                                                 int bUpdateStatistics,
+                                                 vsi_l_offset nOffset,
+                                                 void* pBuffer, size_t nSize,
+                                                 size_t* pnCopied,
+                                                 size_t* pnRegionSize);
+    void                AddRegionToCacheMemory(unsigned long pszURLHash,
+                                               vsi_l_offset nFileOffsetStart,
+                                               size_t nSize,
+                                               const char *pData);
 
     /* Per-thread Curl connection cache */
     std::map<GIntBig, CachedConnection*> mapConnections;
@@ -230,8 +393,14 @@ public:
     virtual char   **ReadDir( const char *pszDirname, int* pbGotFileList );
 
 
-    const CachedRegion* GetRegion(const char*     pszURL,
-                                  vsi_l_offset    nFileOffsetStart);
+    int                 GetRegion(const char*     pszURL,
+                                  vsi_l_offset    nOffset,
+                                  void*           pBuffer,
+                                  size_t          nSize,
+                                  size_t*         pnCopied,
+                                  size_t*         pnRegionSize);
+    int                 IsRegionInCacheMemory(const char* pszURL,
+                                              vsi_l_offset nOffset);
 
     void                AddRegion(const char*     pszURL,
                                   vsi_l_offset    nFileOffsetStart,
@@ -240,11 +409,27 @@ public:
 
     CachedFileProp*     GetCachedFileProp(const char*     pszURL);
 
-    void                AddRegionToCacheDisk(CachedRegion* psRegion);
-    const CachedRegion* GetRegionFromCacheDisk(const char*     pszURL,
-                                               vsi_l_offset nFileOffsetStart);
+    void                SetCachedFileValidator(const char* pszURL,
+                                               const char* pszValidator);
+    int                 IsCacheDiskEnabled() const { return bUseCacheDisk; }
+
+    void                AddRegionToCacheDisk(const char* pszURL,
+                                             vsi_l_offset nFileOffsetStart,
+                                             size_t nSize,
+                                             const char* pData);
+    int                 GetRegionFromCacheDisk(const char*     pszURL,
+                                               vsi_l_offset nOffset,
+                                               void* pBuffer, size_t nSize,
+                                               size_t* pnCopied,
+                                               size_t* pnRegionSize);
+
+    int                 GetMaxBlocksPerDownload() const;
+    void                GetRegionCacheStatistics(GUIntBig* pnHits,
+                                                 GUIntBig* pnMisses,
+                                                 GUIntBig* pnCachedBytes);
 
     CURL               *GetCurlHandleFor(CPLString osURL);
+    CURLM              *GetCurlMultiHandle();
 };
 
 /************************************************************************/
@@ -270,6 +455,16 @@ class VSICurlHandle : public VSIVirtualHandle
     int             bEOF;
 
     int             DownloadRegion(vsi_l_offset startOffset, int nBlocks);
+    int             DownloadRangesParallel(int nRanges,
+                                           const vsi_l_offset* panStartOffsets,
+                                           const vsi_l_offset* panEndOffsets,
+                                           char** ppabyBuffers,
+                                           size_t* panBufferSizes);
+    int             UseParallelRanges() const;
+    int             ReadMultiRangeParallel( int nRanges, void ** ppData,
+                                            const vsi_l_offset* panOffsets,
+                                            const size_t* panSizes );
+    static void     AsyncReadFunc( void* pData );
 
     VSICurlReadCbkFunc  pfnReadCbk;
     void               *pReadCbkUserData;
@@ -286,6 +481,10 @@ class VSICurlHandle : public VSIVirtualHandle
     virtual size_t       Read( void *pBuffer, size_t nSize, size_t nMemb );
     virtual int          ReadMultiRange( int nRanges, void ** ppData,
                                          const vsi_l_offset* panOffsets, const size_t* panSizes );
+    virtual VSIAsyncReadRequest *ReadAsync( vsi_l_offset nOffset, void* pBuffer,
+                                            size_t nSize,
+                                            VSIAsyncReadCallback pfnCallback,
+                                            void* pUserData );
     virtual size_t       Write( const void *pBuffer, size_t nSize, size_t nMemb );
     virtual int          Eof();
     virtual int          Flush();
@@ -738,6 +937,16 @@ vsi_l_offset VSICurlHandle::GetFileSize()
                     pszURL, fileSize, (int)response_code);
     }
 
+    if (eExists == EXIST_YES && poFS->IsCacheDiskEnabled())
+    {
+        /* With CURLOPT_NOBODY, the headers are received as the body */
+        CPLString osValidator = VSICurlGetValidator(sWriteFuncHeaderData.pBuffer);
+        if (osValidator.size() == 0)
+            osValidator = VSICurlGetValidator(sWriteFuncData.pBuffer);
+        if (osValidator.size() != 0)
+            poFS->SetCachedFileValidator(pszURL, osValidator);
+    }
+
     CPLFree(sWriteFuncData.pBuffer);
     CPLFree(sWriteFuncHeaderData.pBuffer);
 
@@ -770,6 +979,267 @@ vsi_l_offset VSICurlHandle::Tell()
     return curOffset;
 }
 
+/************************************************************************/
+/*                      VSICurlGetMaxConnections()                      */
+/************************************************************************/
+
+static int VSICurlGetMaxConnections()
+{
+    int nMaxConnections =
+        atoi(CPLGetConfigOption("CPL_VSIL_CURL_MAX_CONNECTIONS", "8"));
+    if (nMaxConnections <= 0)
+        nMaxConnections = 8;
+    return nMaxConnections;
+}
+
+/************************************************************************/
+/*                         UseParallelRanges()                          */
+/************************************************************************/
+
+int VSICurlHandle::UseParallelRanges() const
+{
+    /* The read callback expects to receive the data in file order */
+    if (pfnReadCbk != NULL)
+        return FALSE;
+    return EQUAL(CPLGetConfigOption("CPL_VSIL_CURL_MULTIRANGE", "MULTIPART"),
+                 "PARALLEL");
+}
+
+/************************************************************************/
+/*                       DownloadRangesParallel()                       */
+/*                                                                      */
+/*      Fetch each [panStartOffsets[i], panEndOffsets[i]] range with    */
+/*      its own request, keeping at most CPL_VSIL_CURL_MAX_CONNECTIONS  */
+/*      of them in flight over the multi handle of the current thread.  */
+/*      On success, the buffers returned in ppabyBuffers must be freed  */
+/*      with CPLFree() by the caller.                                   */
+/************************************************************************/
+
+int VSICurlHandle::DownloadRangesParallel(int nRanges,
+                                          const vsi_l_offset* panStartOffsets,
+                                          const vsi_l_offset* panEndOffsets,
+                                          char** ppabyBuffers,
+                                          size_t* panBufferSizes)
+{
+    int i;
+
+    for(i=0;i<nRanges;i++)
+    {
+        ppabyBuffers[i] = NULL;
+        panBufferSizes[i] = 0;
+    }
+
+    CURLM* hMultiHandle = poFS->GetCurlMultiHandle();
+    if (hMultiHandle == NULL)
+        return FALSE;
+
+    int nMaxConnections = VSICurlGetMaxConnections();
+/* 7.16.3 */
+#if LIBCURL_VERSION_NUM >= 0x071003
+    curl_multi_setopt(hMultiHandle, CURLMOPT_MAXCONNECTS, (long)nMaxConnections);
+#endif
+
+    CURL** pahCurlHandles = (CURL**) CPLCalloc(nRanges, sizeof(CURL*));
+    CURLcode* paeResults = (CURLcode*) CPLMalloc(nRanges * sizeof(CURLcode));
+    WriteFuncStruct* pasWriteFuncData = (WriteFuncStruct*)
+        CPLMalloc(nRanges * sizeof(WriteFuncStruct));
+    WriteFuncStruct* pasWriteFuncHeaderData = (WriteFuncStruct*)
+        CPLMalloc(nRanges * sizeof(WriteFuncStruct));
+    char* pszCurlErrBufs = (char*) CPLCalloc(nRanges, CURL_ERROR_SIZE+1);
+    char* pszRangeStrs = (char*) CPLCalloc(nRanges, 64);
+
+    for(i=0;i<nRanges;i++)
+    {
+        CURL* hCurlHandle = curl_easy_init();
+        pahCurlHandles[i] = hCurlHandle;
+        paeResults[i] = CURLE_OK;
+        VSICurlSetOptions(hCurlHandle, pszURL);
+
+        VSICURLInitWriteFuncStruct(&pasWriteFuncData[i], (VSILFILE*)this, NULL, NULL);
+        curl_easy_setopt(hCurlHandle, CURLOPT_WRITEDATA, &pasWriteFuncData[i]);
+        curl_easy_setopt(hCurlHandle, CURLOPT_WRITEFUNCTION, VSICurlHandleWriteFunc);
+
+        VSICURLInitWriteFuncStruct(&pasWriteFuncHeaderData[i], NULL, NULL, NULL);
+        curl_easy_setopt(hCurlHandle, CURLOPT_HEADERDATA, &pasWriteFuncHeaderData[i]);
+        curl_easy_setopt(hCurlHandle, CURLOPT_HEADERFUNCTION, VSICurlHandleWriteFunc);
+        pasWriteFuncHeaderData[i].bIsHTTP = strncmp(pszURL, "http", 4) == 0;
+        pasWriteFuncHeaderData[i].nStartOffset = panStartOffsets[i];
+        pasWriteFuncHeaderData[i].nEndOffset = panEndOffsets[i];
+
+        char* pszRange = pszRangeStrs + i * 64;
+        sprintf(pszRange, CPL_FRMT_GUIB "-" CPL_FRMT_GUIB,
+                panStartOffsets[i], panEndOffsets[i]);
+        curl_easy_setopt(hCurlHandle, CURLOPT_RANGE, pszRange);
+        curl_easy_setopt(hCurlHandle, CURLOPT_ERRORBUFFER,
+                         pszCurlErrBufs + i * (CURL_ERROR_SIZE+1));
+    }
+
+    if (ENABLE_DEBUG)
+        CPLDebug("VSICURL", "Downloading %d ranges, %s, ..., %s, over %d connections (%s)...",
+                 nRanges, pszRangeStrs, pszRangeStrs + (nRanges - 1) * 64,
+                 MIN(nRanges, nMaxConnections), pszURL);
+
+/* -------------------------------------------------------------------- */
+/*      Run the transfers, starting a pending one each time another     */
+/*      one completes.                                                  */
+/* -------------------------------------------------------------------- */
+    int nNextToAdd = 0;
+    int nActive = 0;
+    while (TRUE)
+    {
+        while (nActive < nMaxConnections && nNextToAdd < nRanges)
+        {
+            curl_multi_add_handle(hMultiHandle, pahCurlHandles[nNextToAdd]);
+            nNextToAdd ++;
+            nActive ++;
+        }
+
+        int nStillRunning = 0;
+        while (curl_multi_perform(hMultiHandle, &nStillRunning) ==
+                                                    CURLM_CALL_MULTI_PERFORM) {}
+
+        int nMsgsInQueue = 0;
+        CURLMsg* psMsg;
+        int bOneDone = FALSE;
+        while ((psMsg = curl_multi_info_read(hMultiHandle, &nMsgsInQueue)) != NULL)
+        {
+            if (psMsg->msg == CURLMSG_DONE)
+            {
+                for(i=0;i<nRanges;i++)
+                {
+                    if (pahCurlHandles[i] == psMsg->easy_handle)
+                    {
+                        paeResults[i] = psMsg->data.result;
+                        break;
+                    }
+                }
+                curl_multi_remove_handle(hMultiHandle, psMsg->easy_handle);
+                nActive --;
+                bOneDone = TRUE;
+            }
+        }
+
+        if (nActive == 0 && nNextToAdd == nRanges)
+            break;
+        if (bOneDone)
+            continue;
+
+/* 7.28.0 */
+#if LIBCURL_VERSION_NUM >= 0x071C00
+        curl_multi_wait(hMultiHandle, NULL, 0, 1000, NULL);
+#else
+        fd_set fdread, fdwrite, fdexcep;
+        int nMaxFD = -1;
+        FD_ZERO(&fdread);
+        FD_ZERO(&fdwrite);
+        FD_ZERO(&fdexcep);
+        curl_multi_fdset(hMultiHandle, &fdread, &fdwrite, &fdexcep, &nMaxFD);
+
+        long nTimeoutMS = -1;
+        curl_multi_timeout(hMultiHandle, &nTimeoutMS);
+        if (nTimeoutMS < 0 || nTimeoutMS > 1000)
+            nTimeoutMS = 1000;
+
+        struct timeval sTimeout;
+        sTimeout.tv_sec = nTimeoutMS / 1000;
+        sTimeout.tv_usec = (nTimeoutMS % 1000) * 1000;
+        if (nMaxFD >= 0)
+            select(nMaxFD + 1, &fdread, &fdwrite, &fdexcep, &sTimeout);
+        else
+            CPLSleep(nTimeoutMS / 1000.0);
+#endif
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Check the outcome of each request: transfer status, HTTP       */
+/*      status and number of bytes received.  A range may only come     */
+/*      back short if it extends past a file size we do not know yet.   */
+/*      If any of them failed, nothing is returned, and so nothing      */
+/*      gets cached.                                                    */
+/* -------------------------------------------------------------------- */
+    CachedFileProp* cachedFileProp = poFS->GetCachedFileProp(pszURL);
+    int bRet = TRUE;
+    for(i=0;i<nRanges;i++)
+    {
+        long response_code = 0;
+        curl_easy_getinfo(pahCurlHandles[i], CURLINFO_RESPONSE_CODE, &response_code);
+        const char* pszCurlErrBuf = pszCurlErrBufs + i * (CURL_ERROR_SIZE+1);
+
+        if (bRet && paeResults[i] != CURLE_OK)
+        {
+            CPLError(CE_Failure, CPLE_AppDefined,
+                     "Download of range %s failed: %s",
+                     pszRangeStrs + i * 64,
+                     pszCurlErrBuf[0] != '\0' ? pszCurlErrBuf :
+                                        curl_easy_strerror(paeResults[i]));
+            bRet = FALSE;
+        }
+
+        if (bRet &&
+            ((response_code != 200 && response_code != 206 &&
+              response_code != 225 && response_code != 226 && response_code != 426) ||
+             pasWriteFuncHeaderData[i].bError))
+        {
+            if (ENABLE_DEBUG)
+                CPLDebug("VSICURL", "Got reponse_code=%ld for range %s",
+                         response_code, pszRangeStrs + i * 64);
+            if (response_code >= 400 && pszCurlErrBuf[0] != '\0')
+            {
+                if (strcmp(pszCurlErrBuf, "Couldn't use REST") == 0)
+                    CPLError(CE_Failure, CPLE_AppDefined, "%d: %s, %s",
+                             (int)response_code, pszCurlErrBuf,
+                             "Range downloading not supported by this server !");
+                else
+                    CPLError(CE_Failure, CPLE_AppDefined, "%d: %s",
+                             (int)response_code, pszCurlErrBuf);
+            }
+            bRet = FALSE;
+        }
+
+        if (bRet &&
+            (vsi_l_offset)pasWriteFuncData[i].nSize <
+                panEndOffsets[i] - panStartOffsets[i] + 1 &&
+            cachedFileProp->bHastComputedFileSize &&
+            panEndOffsets[i] < cachedFileProp->fileSize)
+        {
+            CPLError(CE_Failure, CPLE_AppDefined,
+                     "Got only %d bytes for range %s",
+                     (int)pasWriteFuncData[i].nSize, pszRangeStrs + i * 64);
+            bRet = FALSE;
+        }
+
+        if (bRet)
+        {
+            ppabyBuffers[i] = pasWriteFuncData[i].pBuffer;
+            panBufferSizes[i] = pasWriteFuncData[i].nSize;
+        }
+        else
+            CPLFree(pasWriteFuncData[i].pBuffer);
+        CPLFree(pasWriteFuncHeaderData[i].pBuffer);
+
+        curl_easy_cleanup(pahCurlHandles[i]);
+    }
+
+    if (!bRet)
+    {
+        for(i=0;i<nRanges;i++)
+        {
+            CPLFree(ppabyBuffers[i]);
+            ppabyBuffers[i] = NULL;
+            panBufferSizes[i] = 0;
+        }
+    }
+
+    CPLFree(pahCurlHandles);
+    CPLFree(paeResults);
+    CPLFree(pasWriteFuncData);
+    CPLFree(pasWriteFuncHeaderData);
+    CPLFree(pszCurlErrBufs);
+    CPLFree(pszRangeStrs);
+
+    return bRet;
+}
+
 /************************************************************************/
 /*                          DownloadRegion()                            */
 /************************************************************************/
@@ -786,6 +1256,72 @@ int VSICurlHandle::DownloadRegion(vsi_l_offset startOffset, int nBlocks)
     if (cachedFileProp->eExists == EXIST_NO)
         return FALSE;
 
+    /* Split large read-ahead requests over several connections */
+    if (UseParallelRanges() && cachedFileProp->bHastComputedFileSize &&
+        startOffset < cachedFileProp->fileSize)
+    {
+        int nParts = MIN(VSICurlGetMaxConnections(),
+                         nBlocks / N_MIN_BLOCKS_PER_CONNECTION);
+        if (nParts > 1)
+        {
+            vsi_l_offset nEndOffset = startOffset + (vsi_l_offset)nBlocks * DOWNLOAD_CHUNCK_SIZE - 1;
+            if (nEndOffset >= cachedFileProp->fileSize)
+                nEndOffset = cachedFileProp->fileSize - 1;
+
+            vsi_l_offset nPartSize = (vsi_l_offset)
+                ((nBlocks + nParts - 1) / nParts) * DOWNLOAD_CHUNCK_SIZE;
+            vsi_l_offset* panStartOffsets = (vsi_l_offset*)
+                CPLMalloc(nParts * sizeof(vsi_l_offset));
+            vsi_l_offset* panEndOffsets = (vsi_l_offset*)
+                CPLMalloc(nParts * sizeof(vsi_l_offset));
+            char** ppabyBuffers = (char**) CPLMalloc(nParts * sizeof(char*));
+            size_t* panBufferSizes = (size_t*) CPLMalloc(nParts * sizeof(size_t));
+
+            int nActualParts = 0;
+            for(int i=0;i<nParts;i++)
+            {
+                vsi_l_offset nPartStart = startOffset + i * nPartSize;
+                if (nPartStart > nEndOffset)
+                    break;
+                panStartOffsets[i] = nPartStart;
+                panEndOffsets[i] = MIN(nPartStart + nPartSize - 1, nEndOffset);
+                nActualParts ++;
+            }
+
+            int bRet = DownloadRangesParallel(nActualParts, panStartOffsets,
+                                              panEndOffsets, ppabyBuffers,
+                                              panBufferSizes);
+            if (bRet)
+            {
+                lastDownloadedOffset = startOffset + nBlocks * DOWNLOAD_CHUNCK_SIZE;
+
+                for(int i=0;i<nActualParts;i++)
+                {
+                    vsi_l_offset nRegionOffset = panStartOffsets[i];
+                    char* pBuffer = ppabyBuffers[i];
+                    size_t nSize = panBufferSizes[i];
+                    if (nSize > panEndOffsets[i] - panStartOffsets[i] + 1)
+                        nSize = (size_t)(panEndOffsets[i] - panStartOffsets[i] + 1);
+                    while (nSize > 0)
+                    {
+                        poFS->AddRegion(pszURL, nRegionOffset,
+                                        MIN(DOWNLOAD_CHUNCK_SIZE, nSize), pBuffer);
+                        nRegionOffset += DOWNLOAD_CHUNCK_SIZE;
+                        pBuffer += DOWNLOAD_CHUNCK_SIZE;
+                        nSize -= MIN(DOWNLOAD_CHUNCK_SIZE, nSize);
+                    }
+                    CPLFree(ppabyBuffers[i]);
+                }
+            }
+
+            CPLFree(panStartOffsets);
+            CPLFree(panEndOffsets);
+            CPLFree(ppabyBuffers);
+            CPLFree(panBufferSizes);
+            return bRet;
+        }
+    }
+
     CURL* hCurlHandle = poFS->GetCurlHandleFor(pszURL);
     VSICurlSetOptions(hCurlHandle, pszURL);
 
@@ -924,6 +1460,13 @@ int VSICurlHandle::DownloadRegion(vsi_l_offset startOffset, int nBlocks)
         }
     }
 
+    if (poFS->IsCacheDiskEnabled())
+    {
+        CPLString osValidator = VSICurlGetValidator(sWriteFuncHeaderData.pBuffer);
+        if (osValidator.size() != 0)
+            poFS->SetCachedFileValidator(pszURL, osValidator);
+    }
+
     lastDownloadedOffset = startOffset + nBlocks * DOWNLOAD_CHUNCK_SIZE;
 
     char* pBuffer = sWriteFuncData.pBuffer;
@@ -964,11 +1507,20 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
         
     //CPLDebug("VSICURL", "offset=%d, size=%d", (int)curOffset, (int)nBufferRequestSize);
 
+    /* The disk cache is keyed on the ETag/Last-Modified returned by the */
+    /* request issued by GetFileSize() */
+    if (poFS->IsCacheDiskEnabled() && !bHastComputedFileSize)
+        GetFileSize();
+
     vsi_l_offset iterOffset = curOffset;
     while (nBufferRequestSize)
     {
-        const CachedRegion* psRegion = poFS->GetRegion(pszURL, iterOffset);
-        if (psRegion == NULL)
+        size_t nCopied = 0;
+        size_t nRegionSize = 0;
+        int bCached = poFS->GetRegion(pszURL, iterOffset,
+                                      pBuffer, nBufferRequestSize,
+                                      &nCopied, &nRegionSize);
+        if (!bCached)
         {
             vsi_l_offset nOffsetToDownload =
                 (iterOffset / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
@@ -998,18 +1550,21 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
                 nBlocksToDownload = nMinBlocksToDownload;
                 
             int i;
-            /* Avoid reading already cached data */
+            /* Avoid reading already cached data. Only the memory cache */
+            /* is probed: a disk lookup per read-ahead block would cost */
+            /* more than the download it may save. */
             for(i=1;i<nBlocksToDownload;i++)
             {
-                if (poFS->GetRegion(pszURL, nOffsetToDownload + i * DOWNLOAD_CHUNCK_SIZE) != NULL)
+                if (poFS->IsRegionInCacheMemory(pszURL,
+                                    nOffsetToDownload + i * DOWNLOAD_CHUNCK_SIZE))
                 {
                     nBlocksToDownload = i;
                     break;
                 }
             }
 
-            if( nBlocksToDownload > N_MAX_REGIONS )
-                nBlocksToDownload = N_MAX_REGIONS;
+            if( nBlocksToDownload > poFS->GetMaxBlocksPerDownload() )
+                nBlocksToDownload = poFS->GetMaxBlocksPerDownload();
 
             if (DownloadRegion(nOffsetToDownload, nBlocksToDownload) == FALSE)
             {
@@ -1017,20 +1572,19 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
                     bEOF = TRUE;
                 return 0;
             }
-            psRegion = poFS->GetRegion(pszURL, iterOffset);
+            bCached = poFS->GetRegion(pszURL, iterOffset,
+                                      pBuffer, nBufferRequestSize,
+                                      &nCopied, &nRegionSize);
         }
-        if (psRegion == NULL || psRegion->pData == NULL)
+        if (!bCached || nRegionSize == 0)
         {
             bEOF = TRUE;
             return 0;
         }
-        int nToCopy = (int) MIN(nBufferRequestSize, psRegion->nSize - (iterOffset - psRegion->nFileOffsetStart));
-        memcpy(pBuffer, psRegion->pData + iterOffset - psRegion->nFileOffsetStart,
-                nToCopy);
-        pBuffer = (char*) pBuffer + nToCopy;
-        iterOffset += nToCopy;
-        nBufferRequestSize -= nToCopy;
-        if (psRegion->nSize != DOWNLOAD_CHUNCK_SIZE && nBufferRequestSize != 0)
+        pBuffer = (char*) pBuffer + nCopied;
+        iterOffset += nCopied;
+        nBufferRequestSize -= nCopied;
+        if (nRegionSize != DOWNLOAD_CHUNCK_SIZE && nBufferRequestSize != 0)
         {
             break;
         }
@@ -1046,6 +1600,186 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
 }
 
 
+/************************************************************************/
+/*                            AsyncReadFunc()                           */
+/*                                                                      */
+/*      Serve the request from the region cache, and fetch what is      */
+/*      missing with a range request of its own. Each worker thread     */
+/*      has its own connection, so that requests run concurrently.      */
+/*      Only the immutable state of the handle is used.                 */
+/************************************************************************/
+
+void VSICurlHandle::AsyncReadFunc( void* pData )
+{
+    VSIAsyncReadRequest* psRequest = (VSIAsyncReadRequest*) pData;
+    VSICurlHandle* poHandle = (VSICurlHandle*) psRequest->poHandle;
+    VSICurlFilesystemHandler* poFS = poHandle->poFS;
+    const char* pszURL = poHandle->pszURL;
+
+    vsi_l_offset nOffset = psRequest->nOffset;
+    vsi_l_offset nEndOffset = nOffset + psRequest->nSize;
+    if (poHandle->fileSize != 0 && nEndOffset > poHandle->fileSize)
+        nEndOffset = MAX(nOffset, poHandle->fileSize);
+    if (poHandle->eExists == EXIST_NO)
+        nEndOffset = nOffset;
+
+    GByte* pabyOut = (GByte*) psRequest->pBuffer;
+    vsi_l_offset iterOffset = nOffset;
+    while (iterOffset < nEndOffset)
+    {
+        size_t nCopied = 0;
+        if (!poFS->GetRegion(pszURL, iterOffset,
+                             pabyOut + (iterOffset - nOffset),
+                             (size_t)(nEndOffset - iterOffset),
+                             &nCopied, NULL) || nCopied == 0)
+            break;
+        iterOffset += nCopied;
+    }
+
+    if (iterOffset < nEndOffset)
+    {
+        vsi_l_offset nStartOffset =
+            (iterOffset / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
+        vsi_l_offset nLastOffset =
+            ((nEndOffset - 1) / DOWNLOAD_CHUNCK_SIZE + 1) * DOWNLOAD_CHUNCK_SIZE - 1;
+        if (poHandle->fileSize != 0 && nLastOffset >= poHandle->fileSize)
+            nLastOffset = poHandle->fileSize - 1;
+
+        char* pabyBuffer = NULL;
+        size_t nBufferSize = 0;
+        if (poHandle->DownloadRangesParallel(1, &nStartOffset, &nLastOffset,
+                                             &pabyBuffer, &nBufferSize))
+        {
+            if (nBufferSize > nLastOffset - nStartOffset + 1)
+                nBufferSize = (size_t)(nLastOffset - nStartOffset + 1);
+
+            if (nStartOffset + nBufferSize > iterOffset)
+            {
+                size_t nToCopy = (size_t) (MIN(nEndOffset,
+                                    nStartOffset + nBufferSize) - iterOffset);
+                memcpy(pabyOut + (iterOffset - nOffset),
+                       pabyBuffer + (iterOffset - nStartOffset), nToCopy);
+                iterOffset += nToCopy;
+            }
+
+            vsi_l_offset nRegionOffset = nStartOffset;
+            char* pabyIter = pabyBuffer;
+            while (nBufferSize > 0)
+            {
+                poFS->AddRegion(pszURL, nRegionOffset,
+                                MIN(DOWNLOAD_CHUNCK_SIZE, nBufferSize), pabyIter);
+                nRegionOffset += DOWNLOAD_CHUNCK_SIZE;
+                pabyIter += DOWNLOAD_CHUNCK_SIZE;
+                nBufferSize -= MIN(DOWNLOAD_CHUNCK_SIZE, nBufferSize);
+            }
+            CPLFree(pabyBuffer);
+        }
+    }
+
+    VSICompleteAsyncReadRequest(psRequest, (size_t)(iterOffset - nOffset));
+}
+
+/************************************************************************/
+/*                              ReadAsync()                             */
+/************************************************************************/
+
+VSIAsyncReadRequest *VSICurlHandle::ReadAsync( vsi_l_offset nOffset,
+                                               void* pBuffer, size_t nSize,
+                                               VSIAsyncReadCallback pfnCallback,
+                                               void* pUserData )
+{
+    /* The read callback expects to receive the data in file order */
+    if (pfnReadCbk != NULL)
+        return VSIVirtualHandle::ReadAsync(nOffset, pBuffer, nSize,
+                                           pfnCallback, pUserData);
+
+    /* Done here as it updates the state of the handle, and the disk */
+    /* cache is keyed on the validator returned by that request */
+    GetFileSize();
+
+    VSIAsyncReadRequest* psRequest =
+        VSICreateAsyncReadRequest(this, nOffset, pBuffer, nSize,
+                                  pfnCallback, pUserData);
+    VSISubmitAsyncReadJob(AsyncReadFunc, psRequest);
+
+    return psRequest;
+}
+
+/************************************************************************/
+/*                       ReadMultiRangeParallel()                       */
+/*                                                                      */
+/*      Alternative to the multipart request of ReadMultiRange() where  */
+/*      each group of contiguous ranges is fetched by an independent    */
+/*      request, several of them being run concurrently.                */
+/************************************************************************/
+
+int VSICurlHandle::ReadMultiRangeParallel( int nRanges, void ** ppData,
+                                           const vsi_l_offset* panOffsets,
+                                           const size_t* panSizes )
+{
+    vsi_l_offset* panStartOffsets = (vsi_l_offset*)
+        CPLMalloc(nRanges * sizeof(vsi_l_offset));
+    vsi_l_offset* panEndOffsets = (vsi_l_offset*)
+        CPLMalloc(nRanges * sizeof(vsi_l_offset));
+    int* panMergedRange = (int*) CPLMalloc(nRanges * sizeof(int));
+    int i;
+    int nMergedRanges = 0;
+
+    for(i=0;i<nRanges;i++)
+    {
+        panStartOffsets[nMergedRanges] = panOffsets[i];
+        panMergedRange[i] = nMergedRanges;
+        while (i + 1 < nRanges && panOffsets[i] + panSizes[i] == panOffsets[i+1])
+        {
+            i ++;
+            panMergedRange[i] = nMergedRanges;
+        }
+        panEndOffsets[nMergedRanges] = panOffsets[i] + panSizes[i] - 1;
+        nMergedRanges ++;
+    }
+
+    char** ppabyBuffers = (char**) CPLMalloc(nMergedRanges * sizeof(char*));
+    size_t* panBufferSizes = (size_t*) CPLMalloc(nMergedRanges * sizeof(size_t));
+
+    int nRet = -1;
+    if (DownloadRangesParallel(nMergedRanges, panStartOffsets, panEndOffsets,
+                               ppabyBuffers, panBufferSizes))
+    {
+        nRet = 0;
+        for(i=0;i<nMergedRanges;i++)
+        {
+            if ((vsi_l_offset)panBufferSizes[i] <
+                    panEndOffsets[i] - panStartOffsets[i] + 1)
+            {
+                CPLError(CE_Failure, CPLE_AppDefined,
+                         "Got only %d bytes for range " CPL_FRMT_GUIB "-" CPL_FRMT_GUIB,
+                         (int)panBufferSizes[i], panStartOffsets[i], panEndOffsets[i]);
+                nRet = -1;
+                break;
+            }
+        }
+
+        for(i=0;nRet == 0 && i<nRanges;i++)
+        {
+            int iMerged = panMergedRange[i];
+            memcpy(ppData[i],
+                   ppabyBuffers[iMerged] + (panOffsets[i] - panStartOffsets[iMerged]),
+                   panSizes[i]);
+        }
+
+        for(i=0;i<nMergedRanges;i++)
+            CPLFree(ppabyBuffers[i]);
+    }
+
+    CPLFree(panStartOffsets);
+    CPLFree(panEndOffsets);
+    CPLFree(panMergedRange);
+    CPLFree(ppabyBuffers);
+    CPLFree(panBufferSizes);
+
+    return nRet;
+}
+
 /************************************************************************/
 /*                           ReadMultiRange()                           */
 /************************************************************************/
@@ -1064,6 +1798,9 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
     if (cachedFileProp->eExists == EXIST_NO)
         return -1;
 
+    if (UseParallelRanges())
+        return ReadMultiRangeParallel(nRanges, ppData, panOffsets, panSizes);
+
     CPLString osRanges, osFirstRange, osLastRange;
     int i;
     int nMergedRanges = 0;
@@ -1445,9 +2182,37 @@ int       VSICurlHandle::Close()
 VSICurlFilesystemHandler::VSICurlFilesystemHandler()
 {
     hMutex = NULL;
-    papsRegions = NULL;
-    nRegions = 0;
-    bUseCacheDisk = CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_CURL_USE_CACHE", "NO"));
+
+    for(int i=0;i<N_REGION_CACHE_SHARDS;i++)
+    {
+        CachedRegionShard* psShard = &asRegionShards[i];
+        psShard->hMutex = NULL;
+        psShard->hSetRegions = CPLHashSetNew(VSICurlHashCachedRegion,
+                                             VSICurlEqualCachedRegion, NULL);
+        psShard->psMostRecent = NULL;
+        psShard->psLeastRecent = NULL;
+        psShard->nCachedBytes = 0;
+        psShard->nHits = 0;
+        psShard->nMisses = 0;
+    }
+
+    GIntBig nCacheSize = (GIntBig)1024 * 1024 *
+        atoi(CPLGetConfigOption("CPL_VSIL_CURL_CACHE_SIZE", "64"));
+    if (nCacheSize < DOWNLOAD_CHUNCK_SIZE * N_REGION_CACHE_SHARDS)
+        nCacheSize = DOWNLOAD_CHUNCK_SIZE * N_REGION_CACHE_SHARDS;
+    nMaxCachedBytesPerShard = (size_t)
+        MIN(nCacheSize / N_REGION_CACHE_SHARDS, (GIntBig)INT_MAX);
+
+    const char* pszCacheDiskDir = CPLGetConfigOption("CPL_VSIL_CURL_CACHE_DIR", NULL);
+    bUseCacheDisk = pszCacheDiskDir != NULL ||
+        CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_CURL_USE_CACHE", "NO"));
+    osCacheDiskDir = pszCacheDiskDir ? pszCacheDiskDir : "gdal_vsicurl_cache";
+    nMaxCacheDiskBytes = (GIntBig)1024 * 1024 *
+        atoi(CPLGetConfigOption("CPL_VSIL_CURL_CACHE_DIR_SIZE", "1024"));
+    nCacheDiskBytesSinceTrim = 0;
+    bCacheDiskTrimmed = FALSE;
+    nCacheDiskTmpCounter = 0;
+    hCacheDiskMutex = NULL;
 }
 
 /************************************************************************/
@@ -1456,18 +2221,38 @@ VSICurlFilesystemHandler::VSICurlFilesystemHandler()
 
 VSICurlFilesystemHandler::~VSICurlFilesystemHandler()
 {
+    if (ENABLE_DEBUG)
+    {
+        GUIntBig nHits, nMisses, nCachedBytes;
+        GetRegionCacheStatistics(&nHits, &nMisses, &nCachedBytes);
+        if (nHits + nMisses)
+            CPLDebug("VSICURL", "Region cache: " CPL_FRMT_GUIB " hits, "
+                     CPL_FRMT_GUIB " misses, " CPL_FRMT_GUIB " bytes cached",
+                     nHits, nMisses, nCachedBytes);
+    }
+
     int i;
-    for(i=0;i<nRegions;i++)
+    for(i=0;i<N_REGION_CACHE_SHARDS;i++)
     {
-        CPLFree(papsRegions[i]->pData);
-        CPLFree(papsRegions[i]);
+        CachedRegionShard* psShard = &asRegionShards[i];
+        CachedRegion* psRegion = psShard->psMostRecent;
+        while (psRegion)
+        {
+            CachedRegion* psNext = psRegion->psNext;
+            CPLFree(psRegion->pData);
+            CPLFree(psRegion);
+            psRegion = psNext;
+        }
+        CPLHashSetDestroy(psShard->hSetRegions);
+        if (psShard->hMutex != NULL)
+            CPLDestroyMutex(psShard->hMutex);
     }
-    CPLFree(papsRegions);
 
     std::map<CPLString, CachedFileProp*>::const_iterator iterCacheFileSize;
 
     for( iterCacheFileSize = cacheFileSize.begin(); iterCacheFileSize != cacheFileSize.end(); iterCacheFileSize++ )
     {
+        CPLFree(iterCacheFileSize->second->pszValidator);
         CPLFree(iterCacheFileSize->second);
     }
 
@@ -1482,13 +2267,19 @@ VSICurlFilesystemHandler::~VSICurlFilesystemHandler()
     std::map<GIntBig, CachedConnection*>::const_iterator iterConnections;
     for( iterConnections = mapConnections.begin(); iterConnections != mapConnections.end(); iterConnections++ )
     {
-        curl_easy_cleanup(iterConnections->second->hCurlHandle);
+        if (iterConnections->second->hCurlHandle)
+            curl_easy_cleanup(iterConnections->second->hCurlHandle);
+        if (iterConnections->second->hCurlMultiHandle)
+            curl_multi_cleanup(iterConnections->second->hCurlMultiHandle);
         delete iterConnections->second;
     }
 
     if( hMutex != NULL )
         CPLDestroyMutex( hMutex );
     hMutex = NULL;
+    if( hCacheDiskMutex != NULL )
+        CPLDestroyMutex( hCacheDiskMutex );
+    hCacheDiskMutex = NULL;
 }
 
 /************************************************************************/
@@ -1508,12 +2299,20 @@ CURL* VSICurlFilesystemHandler::GetCurlHandleFor(CPLString osURL)
         CachedConnection* psCachedConnection = new CachedConnection;
         psCachedConnection->osURL = osURL;
         psCachedConnection->hCurlHandle = hCurlHandle;
+        psCachedConnection->hCurlMultiHandle = NULL;
         mapConnections[CPLGetPID()] = psCachedConnection;
         return hCurlHandle;
     }
     else
     {
         CachedConnection* psCachedConnection = iterConnections->second;
+        if (psCachedConnection->hCurlHandle == NULL)
+        {
+            /* Entry created by GetCurlMultiHandle() */
+            psCachedConnection->hCurlHandle = curl_easy_init();
+            psCachedConnection->osURL = osURL;
+            return psCachedConnection->hCurlHandle;
+        }
         if (osURL == psCachedConnection->osURL)
             return psCachedConnection->hCurlHandle;
 
@@ -1538,137 +2337,476 @@ CURL* VSICurlFilesystemHandler::GetCurlHandleFor(CPLString osURL)
     }
 }
 
+/************************************************************************/
+/*                       GetCurlMultiHandle()                           */
+/*                                                                      */
+/*      Return the per-thread multi handle used for parallel range      */
+/*      requests. Its connection cache keeps the connections alive      */
+/*      between successive calls.                                       */
+/************************************************************************/
+
+CURLM* VSICurlFilesystemHandler::GetCurlMultiHandle()
+{
+    CPLMutexHolder oHolder( &hMutex );
+
+    CachedConnection* psCachedConnection;
+    std::map<GIntBig, CachedConnection*>::const_iterator iterConnections;
+
+    iterConnections = mapConnections.find(CPLGetPID());
+    if (iterConnections == mapConnections.end())
+    {
+        psCachedConnection = new CachedConnection;
+        psCachedConnection->hCurlHandle = NULL;
+        psCachedConnection->hCurlMultiHandle = NULL;
+        mapConnections[CPLGetPID()] = psCachedConnection;
+    }
+    else
+        psCachedConnection = iterConnections->second;
+
+    if (psCachedConnection->hCurlMultiHandle == NULL)
+        psCachedConnection->hCurlMultiHandle = curl_multi_init();
+
+    return psCachedConnection->hCurlMultiHandle;
+}
+
+
+/************************************************************************/
+/*                         GetCacheDiskKey()                            */
+/*                                                                      */
+/*      The key of a block in the disk cache is made of the URL, the    */
+/*      validator (ETag or Last-Modified) of the remote file and the    */
+/*      offset of the block, so that a modified remote file does not    */
+/*      hit stale blocks. Without validator, the disk cache is not used.*/
+/************************************************************************/
+
+CPLString VSICurlFilesystemHandler::GetCacheDiskKey(const char* pszURL,
+                                                    vsi_l_offset nFileOffsetStart)
+{
+    CPLMutexHolder oHolder( &hMutex );
+
+    /* Do not use operator[], that would insert a NULL entry for the URL */
+    std::map<CPLString, CachedFileProp*>::const_iterator oIter =
+        cacheFileSize.find(pszURL);
+    if (oIter == cacheFileSize.end())
+        return "";
+    CachedFileProp* cachedFileProp = oIter->second;
+    if (cachedFileProp == NULL || cachedFileProp->pszValidator == NULL)
+        return "";
+
+    CPLString osKey(pszURL);
+    osKey += "\n";
+    osKey += cachedFileProp->pszValidator;
+    osKey += CPLSPrintf("\n" CPL_FRMT_GUIB, nFileOffsetStart);
+    return osKey;
+}
+
+/************************************************************************/
+/*                       GetCacheDiskFilename()                         */
+/************************************************************************/
+
+CPLString VSICurlFilesystemHandler::GetCacheDiskFilename(const CPLString& osKey)
+{
+    CPLString osHash;
+    osHash.Printf("%016" CPL_FRMT_GB_WITHOUT_PREFIX "X",
+                  VSICurlHashString64(osKey));
+
+    /* Spread the files over 256 sub-directories */
+    CPLString osSubDir = CPLFormFilename(osCacheDiskDir, osHash.substr(0, 2).c_str(), NULL);
+    return CPLFormFilename(osSubDir, osHash, NULL);
+}
 
 /************************************************************************/
 /*                   GetRegionFromCacheDisk()                           */
+/*                                                                      */
+/*      Same as GetRegion(), but only looks in the disk cache. A block  */
+/*      found there is also added to the memory cache.                  */
 /************************************************************************/
 
-const CachedRegion* 
-VSICurlFilesystemHandler::GetRegionFromCacheDisk(const char* pszURL,
-                                                 vsi_l_offset nFileOffsetStart)
+int VSICurlFilesystemHandler::GetRegionFromCacheDisk(const char* pszURL,
+                                                     vsi_l_offset nOffset,
+                                                     void* pBuffer,
+                                                     size_t nSize,
+                                                     size_t* pnCopied,
+                                                     size_t* pnRegionSize)
 {
-    nFileOffsetStart = (nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
-    VSILFILE* fp = VSIFOpenL(VSICurlGetCacheFileName(), "rb");
-    if (fp)
-    {
-        unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
-        unsigned long   pszURLHashCached;
-        vsi_l_offset    nFileOffsetStartCached;
-        size_t          nSizeCached;
-        while(TRUE)
+    vsi_l_offset nFileOffsetStart = (nOffset / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
+
+    CPLString osKey = GetCacheDiskKey(pszURL, nFileOffsetStart);
+    if (osKey.size() == 0)
+        return FALSE;
+
+    CPLString osFilename = GetCacheDiskFilename(osKey);
+    VSILFILE* fp = VSIFOpenL(osFilename, "rb");
+    if (fp == NULL)
+        return FALSE;
+
+/* -------------------------------------------------------------------- */
+/*      Check the header: magic, key (to detect hash collisions), and   */
+/*      that the file has the announced size, in case it has been       */
+/*      truncated by a crash.                                           */
+/* -------------------------------------------------------------------- */
+    char szMagic[8];
+    GUInt32 nKeyLen = 0;
+    GUIntBig nSizeCached = 0;
+    int bValid = FALSE;
+    int bCorrupted = TRUE;
+    char* pabyCached = NULL;
+
+    if (VSIFReadL(szMagic, 1, 8, fp) == 8 &&
+        memcmp(szMagic, VSICURL_CACHE_DISK_MAGIC, 8) == 0 &&
+        VSIFReadL(&nKeyLen, 1, sizeof(nKeyLen), fp) == sizeof(nKeyLen))
+    {
+        char* pszKey = (char*) VSIMalloc(nKeyLen);
+        if (pszKey != NULL && VSIFReadL(pszKey, 1, nKeyLen, fp) == nKeyLen)
         {
-            if (VSIFReadL(&pszURLHashCached, 1, sizeof(unsigned long), fp) == 0)
-                break;
-            VSIFReadL(&nFileOffsetStartCached, 1, sizeof(vsi_l_offset), fp);
-            VSIFReadL(&nSizeCached, 1, sizeof(size_t), fp);
-            if (pszURLHash == pszURLHashCached &&
-                nFileOffsetStart == nFileOffsetStartCached)
+            if (nKeyLen != osKey.size() ||
+                memcmp(pszKey, osKey.c_str(), nKeyLen) != 0)
             {
-                if (ENABLE_DEBUG)
-                    CPLDebug("VSICURL", "Got data at offset " CPL_FRMT_GUIB " from disk" , nFileOffsetStart);
-                if (nSizeCached)
-                {
-                    char* pBuffer = (char*) CPLMalloc(nSizeCached);
-                    VSIFReadL(pBuffer, 1, nSizeCached, fp);
-                    AddRegion(pszURL, nFileOffsetStart, nSizeCached, pBuffer);
-                    CPLFree(pBuffer);
-                }
-                else
-                {
-                    AddRegion(pszURL, nFileOffsetStart, 0, NULL);
-                }
-                VSIFCloseL(fp);
-                return GetRegion(pszURL, nFileOffsetStart);
+                /* Another key with the same hash: leave it alone */
+                bCorrupted = FALSE;
             }
-            else
+            else if (VSIFReadL(&nSizeCached, 1, sizeof(nSizeCached), fp) == sizeof(nSizeCached) &&
+                     nSizeCached <= DOWNLOAD_CHUNCK_SIZE)
             {
-                VSIFSeekL(fp, nSizeCached, SEEK_CUR);
+                pabyCached = (char*) CPLMalloc((size_t)nSizeCached + 1);
+                char chExtra;
+                bValid = VSIFReadL(pabyCached, 1, (size_t)nSizeCached, fp) == nSizeCached &&
+                         VSIFReadL(&chExtra, 1, 1, fp) == 0;
             }
         }
-        VSIFCloseL(fp);
+        CPLFree(pszKey);
     }
-    return NULL;
+    VSIFCloseL(fp);
+
+    if (!bValid)
+    {
+        if (bCorrupted)
+        {
+            CPLDebug("VSICURL", "Removing corrupted cache entry %s", osFilename.c_str());
+            VSIUnlink(osFilename);
+        }
+        CPLFree(pabyCached);
+        return FALSE;
+    }
+
+    /* Record the access for the LRU eviction */
+#ifdef WIN32
+    _utime(osFilename, NULL);
+#else
+    utime(osFilename, NULL);
+#endif
+
+    if (ENABLE_DEBUG)
+        CPLDebug("VSICURL", "Got data at offset " CPL_FRMT_GUIB " from disk" , nFileOffsetStart);
+
+    AddRegionToCacheMemory(CPLHashSetHashStr(pszURL), nFileOffsetStart,
+                           (size_t)nSizeCached, pabyCached);
+
+    size_t nCopied = VSICurlCopyFromRegion(pabyCached, (size_t)nSizeCached,
+                                           nOffset - nFileOffsetStart,
+                                           pBuffer, nSize);
+    if (pnCopied)
+        *pnCopied = nCopied;
+    if (pnRegionSize)
+        *pnRegionSize = (size_t)nSizeCached;
+    CPLFree(pabyCached);
+
+    return TRUE;
 }
 
+/************************************************************************/
+/*                  AddRegionToCacheDisk()                              */
+/*                                                                      */
+/*      The entry is written to a temporary file renamed afterwards, so */
+/*      that concurrent readers, possibly in other processes, never see */
+/*      a partially written entry.                                      */
+/************************************************************************/
+
+void VSICurlFilesystemHandler::AddRegionToCacheDisk(const char* pszURL,
+                                                    vsi_l_offset nFileOffsetStart,
+                                                    size_t nSize,
+                                                    const char* pData)
+{
+    CPLString osKey = GetCacheDiskKey(pszURL, nFileOffsetStart);
+    if (osKey.size() == 0)
+        return;
+
+    CPLString osFilename = GetCacheDiskFilename(osKey);
+    VSIStatBufL sStat;
+    if (VSIStatL(osFilename, &sStat) == 0)
+        return;
+
+    VSIMkdir(osCacheDiskDir, 0755);
+    VSIMkdir(CPLGetPath(osFilename), 0755);
+
+    CPLString osTmpFilename;
+    {
+        CPLMutexHolder oHolder( &hCacheDiskMutex );
+        osTmpFilename.Printf("%s.%d_%d.tmp", osFilename.c_str(),
+                             (int)VSICurlGetProcessId(), nCacheDiskTmpCounter++);
+    }
+
+    VSILFILE* fp = VSIFOpenL(osTmpFilename, "wb");
+    if (fp == NULL)
+        return;
+
+    GUInt32 nKeyLen = (GUInt32)osKey.size();
+    GUIntBig nSizeCached = nSize;
+    int bOK =
+        VSIFWriteL(VSICURL_CACHE_DISK_MAGIC, 1, 8, fp) == 8 &&
+        VSIFWriteL(&nKeyLen, 1, sizeof(nKeyLen), fp) == sizeof(nKeyLen) &&
+        VSIFWriteL(osKey.c_str(), 1, nKeyLen, fp) == nKeyLen &&
+        VSIFWriteL(&nSizeCached, 1, sizeof(nSizeCached), fp) == sizeof(nSizeCached) &&
+        (nSize == 0 || VSIFWriteL(pData, 1, nSize, fp) == nSize);
+    /* Make sure the content is written before it becomes visible */
+    /* under its final name */
+    if (bOK && VSIFFlushL(fp) != 0)
+        bOK = FALSE;
+    if (VSIFCloseL(fp) != 0)
+        bOK = FALSE;
+
+    if (!bOK || VSIRename(osTmpFilename, osFilename) != 0)
+    {
+        /* Disk full, or the same entry written concurrently on a */
+        /* platform where rename() does not replace existing files */
+        VSIUnlink(osTmpFilename);
+        return;
+    }
+
+    if (ENABLE_DEBUG)
+        CPLDebug("VSICURL", "Write data at offset " CPL_FRMT_GUIB " to disk", nFileOffsetStart);
+
+    int bTrim;
+    {
+        CPLMutexHolder oHolder( &hCacheDiskMutex );
+        nCacheDiskBytesSinceTrim += 8 + sizeof(nKeyLen) + nKeyLen +
+                                    sizeof(nSizeCached) + nSize;
+        /* Trim at the first write, and then each 10% of the budget */
+        bTrim = !bCacheDiskTrimmed ||
+                nCacheDiskBytesSinceTrim > nMaxCacheDiskBytes / 10;
+        if (bTrim)
+        {
+            bCacheDiskTrimmed = TRUE;
+            nCacheDiskBytesSinceTrim = 0;
+        }
+    }
+    if (bTrim)
+        TrimCacheDisk();
+}
 
 /************************************************************************/
-/*                  AddRegionToCacheDisk()                                */
+/*                           TrimCacheDisk()                            */
+/*                                                                      */
+/*      Remove the least recently used entries of the disk cache until  */
+/*      it fits again in 90% of CPL_VSIL_CURL_CACHE_DIR_SIZE. This is   */
+/*      done on the files themselves, so that the budget is respected   */
+/*      when several processes share the same directory.                */
 /************************************************************************/
 
-void VSICurlFilesystemHandler::AddRegionToCacheDisk(CachedRegion* psRegion)
+typedef struct
+{
+    time_t          nMTime;
+    GIntBig         nSize;
+    CPLString       osFilename;
+} CacheDiskEntry;
+
+/* Only consider the names created by the cache, so that other files of */
+/* the directory (and "..") are left alone */
+static int VSICurlIsHexName(const char* pszName, int nLen)
 {
-    VSILFILE* fp = VSIFOpenL(VSICurlGetCacheFileName(), "r+b");
-    if (fp)
+    for(int i=0;i<nLen;i++)
     {
-        unsigned long   pszURLHashCached;
-        vsi_l_offset    nFileOffsetStartCached;
-        size_t          nSizeCached;
-        while(TRUE)
+        if (!isxdigit((unsigned char)pszName[i]))
+            return FALSE;
+    }
+    return pszName[nLen] == '\0' || pszName[nLen] == '.';
+}
+
+static bool VSICurlCompareCacheDiskEntries(const CacheDiskEntry& a,
+                                           const CacheDiskEntry& b)
+{
+    return a.nMTime < b.nMTime;
+}
+
+void VSICurlFilesystemHandler::TrimCacheDisk()
+{
+    std::vector<CacheDiskEntry> asEntries;
+    GIntBig nTotalSize = 0;
+    time_t nNow = time(NULL);
+
+    char** papszSubDirs = VSIReadDir(osCacheDiskDir);
+    for(int i=0;papszSubDirs != NULL && papszSubDirs[i] != NULL;i++)
+    {
+        if (strlen(papszSubDirs[i]) != 2 || !VSICurlIsHexName(papszSubDirs[i], 2))
+            continue;
+        CPLString osSubDir = CPLFormFilename(osCacheDiskDir, papszSubDirs[i], NULL);
+        char** papszFiles = VSIReadDir(osSubDir);
+        for(int j=0;papszFiles != NULL && papszFiles[j] != NULL;j++)
         {
-            if (VSIFReadL(&pszURLHashCached, 1, sizeof(unsigned long), fp) == 0)
-                break;
-            VSIFReadL(&nFileOffsetStartCached, 1, sizeof(vsi_l_offset), fp);
-            VSIFReadL(&nSizeCached, 1, sizeof(size_t), fp);
-            if (psRegion->pszURLHash == pszURLHashCached &&
-                psRegion->nFileOffsetStart == nFileOffsetStartCached)
-            {
-                CPLAssert(psRegion->nSize == nSizeCached);
-                VSIFCloseL(fp);
-                return;
-            }
-            else
+            if (strlen(papszFiles[j]) < 16 || !VSICurlIsHexName(papszFiles[j], 16))
+                continue;
+            CacheDiskEntry sEntry;
+            sEntry.osFilename = CPLFormFilename(osSubDir, papszFiles[j], NULL);
+            VSIStatBufL sStat;
+            if (VSIStatL(sEntry.osFilename, &sStat) != 0)
+                continue;
+
+            /* Leftover of a crashed writer */
+            if (EQUAL(CPLGetExtension(papszFiles[j]), "tmp"))
             {
-                VSIFSeekL(fp, nSizeCached, SEEK_CUR);
+                if (nNow - sStat.st_mtime > 3600)
+                    VSIUnlink(sEntry.osFilename);
+                continue;
             }
+
+            sEntry.nMTime = sStat.st_mtime;
+            sEntry.nSize = (GIntBig)sStat.st_size;
+            nTotalSize += sEntry.nSize;
+            asEntries.push_back(sEntry);
         }
+        CSLDestroy(papszFiles);
     }
-    else
+    CSLDestroy(papszSubDirs);
+
+    if (nTotalSize <= nMaxCacheDiskBytes)
+        return;
+
+    std::sort(asEntries.begin(), asEntries.end(), VSICurlCompareCacheDiskEntries);
+
+    GIntBig nTargetSize = nMaxCacheDiskBytes / 10 * 9;
+    int nRemoved = 0;
+    for(size_t i=0;i<asEntries.size() && nTotalSize > nTargetSize;i++)
     {
-        fp = VSIFOpenL(VSICurlGetCacheFileName(), "wb");
+        /* May fail if another process has removed it already */
+        VSIUnlink(asEntries[i].osFilename);
+        nTotalSize -= asEntries[i].nSize;
+        nRemoved ++;
     }
-    if (fp)
-    {
-        if (ENABLE_DEBUG)
-             CPLDebug("VSICURL", "Write data at offset " CPL_FRMT_GUIB " to disk" , psRegion->nFileOffsetStart);
-        VSIFWriteL(&psRegion->pszURLHash, 1, sizeof(unsigned long), fp);
-        VSIFWriteL(&psRegion->nFileOffsetStart, 1, sizeof(vsi_l_offset), fp);
-        VSIFWriteL(&psRegion->nSize, 1, sizeof(size_t), fp);
-        if (psRegion->nSize)
-            VSIFWriteL(psRegion->pData, 1, psRegion->nSize, fp);
 
-        VSIFCloseL(fp);
-    }
-    return;
+    if (ENABLE_DEBUG)
+        CPLDebug("VSICURL", "Removed %d entries from disk cache %s",
+                 nRemoved, osCacheDiskDir.c_str());
 }
 
+/************************************************************************/
+/*                          GetRegionShard()                            */
+/************************************************************************/
+
+CachedRegionShard* VSICurlFilesystemHandler::GetRegionShard(unsigned long pszURLHash,
+                                                            vsi_l_offset nFileOffsetStart)
+{
+    /* Consecutive blocks of a file go to different shards */
+    unsigned long nHash = pszURLHash +
+        (unsigned long)(nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE);
+    return &asRegionShards[nHash % N_REGION_CACHE_SHARDS];
+}
 
 /************************************************************************/
 /*                          GetRegion()                                 */
+/*                                                                      */
+/*      Look for the cached block containing nOffset, and copy at most  */
+/*      nSize bytes of it, starting at nOffset, into pBuffer. Returns   */
+/*      FALSE if the block is not cached. The data is copied while the  */
+/*      cache is locked, as the block may be evicted by another thread  */
+/*      as soon as it is released. *pnRegionSize is set to the size of  */
+/*      the block, which is smaller than DOWNLOAD_CHUNCK_SIZE at the    */
+/*      end of the file.                                                */
+/************************************************************************/
+
+int VSICurlFilesystemHandler::GetRegion(const char* pszURL,
+                                        vsi_l_offset nOffset,
+                                        void* pBuffer,
+                                        size_t nSize,
+                                        size_t* pnCopied,
+                                        size_t* pnRegionSize)
+{
+    unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
+
+    vsi_l_offset nFileOffsetStart = (nOffset / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
+
+    if (GetRegionFromCacheMemory(pszURLHash, nFileOffsetStart, TRUE,
+                                 nOffset, pBuffer, nSize,
+                                 pnCopied, pnRegionSize))
+        return TRUE;
+    if (bUseCacheDisk)
+        return GetRegionFromCacheDisk(pszURL, nOffset, pBuffer, nSize,
+                                      pnCopied, pnRegionSize);
+    return FALSE;
+}
+
+/************************************************************************/
+/*                       IsRegionInCacheMemory()                        */
+/*                                                                      */
+/*      Whether the block containing nOffset is in the memory cache.    */
+/*      The disk cache is not looked at, and statistics are not         */
+/*      updated.                                                        */
 /************************************************************************/
 
-const CachedRegion* VSICurlFilesystemHandler::GetRegion(const char* pszURL,
-                                                        vsi_l_offset nFileOffsetStart)
+int VSICurlFilesystemHandler::IsRegionInCacheMemory(const char* pszURL,
+                                                    vsi_l_offset nOffset)
 {
-    CPLMutexHolder oHolder( &hMutex );
+    return GetRegionFromCacheMemory(CPLHashSetHashStr(pszURL),
+                                    (nOffset / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE,
+                                    FALSE, nOffset, NULL, 0, NULL, NULL);
+}
 
-    unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
+/************************************************************************/
+/*                      GetRegionFromCacheMemory()                      */
+/************************************************************************/
 
-    nFileOffsetStart = (nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
-    int i;
-    for(i=0;i<nRegions;i++)
+int VSICurlFilesystemHandler::GetRegionFromCacheMemory(unsigned long pszURLHash,
+                                                       vsi_l_offset nFileOffsetStart,
+                                                       int bUpdateStatistics,
+                                                       vsi_l_offset nOffset,
+                                                       void* pBuffer,
+                                                       size_t nSize,
+                                                       size_t* pnCopied,
+                                                       size_t* pnRegionSize)
+{
+    CachedRegion sKey;
+    sKey.pszURLHash = pszURLHash;
+    sKey.nFileOffsetStart = nFileOffsetStart;
+
+    CachedRegionShard* psShard = GetRegionShard(pszURLHash, nFileOffsetStart);
     {
-        CachedRegion* psRegion = papsRegions[i];
-        if (psRegion->pszURLHash == pszURLHash &&
-            nFileOffsetStart == psRegion->nFileOffsetStart)
+        CPLMutexHolder oHolder( &psShard->hMutex );
+
+        CachedRegion* psRegion = (CachedRegion*)
+            CPLHashSetLookup(psShard->hSetRegions, &sKey);
+        if (psRegion != NULL)
         {
-            memmove(papsRegions + 1, papsRegions, i * sizeof(CachedRegion*));
-            papsRegions[0] = psRegion;
-            return psRegion;
+            if (bUpdateStatistics)
+                psShard->nHits ++;
+
+            /* Move to the head of the LRU list */
+            if (psRegion != psShard->psMostRecent)
+            {
+                psRegion->psPrev->psNext = psRegion->psNext;
+                if (psRegion->psNext)
+                    psRegion->psNext->psPrev = psRegion->psPrev;
+                else
+                    psShard->psLeastRecent = psRegion->psPrev;
+                psRegion->psPrev = NULL;
+                psRegion->psNext = psShard->psMostRecent;
+                psShard->psMostRecent->psPrev = psRegion;
+                psShard->psMostRecent = psRegion;
+            }
+
+            size_t nCopied = VSICurlCopyFromRegion(psRegion->pData,
+                                                   psRegion->nSize,
+                                                   nOffset - nFileOffsetStart,
+                                                   pBuffer, nSize);
+            if (pnCopied)
+                *pnCopied = nCopied;
+            if (pnRegionSize)
+                *pnRegionSize = psRegion->nSize;
+            return TRUE;
         }
+        if (bUpdateStatistics)
+            psShard->nMisses ++;
     }
-    if (bUseCacheDisk)
-        return GetRegionFromCacheDisk(pszURL, nFileOffsetStart);
-    return NULL;
+
+    return FALSE;
 }
 
 /************************************************************************/
@@ -1680,27 +2818,54 @@ void  VSICurlFilesystemHandler::AddRegion(const char* pszURL,
                                           size_t          nSize,
                                           const char     *pData)
 {
-    CPLMutexHolder oHolder( &hMutex );
+    AddRegionToCacheMemory(CPLHashSetHashStr(pszURL), nFileOffsetStart,
+                           nSize, pData);
+    if (bUseCacheDisk)
+        AddRegionToCacheDisk(pszURL, nFileOffsetStart, nSize, pData);
+}
 
-    unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
+/************************************************************************/
+/*                       AddRegionToCacheMemory()                       */
+/************************************************************************/
+
+void VSICurlFilesystemHandler::AddRegionToCacheMemory(unsigned long pszURLHash,
+                                                      vsi_l_offset nFileOffsetStart,
+                                                      size_t nSize,
+                                                      const char *pData)
+{
+    CachedRegionShard* psShard = GetRegionShard(pszURLHash, nFileOffsetStart);
+    CPLMutexHolder oHolder( &psShard->hMutex );
 
-    CachedRegion* psRegion;
-    if (nRegions == N_MAX_REGIONS)
+    CachedRegion sKey;
+    sKey.pszURLHash = pszURLHash;
+    sKey.nFileOffsetStart = nFileOffsetStart;
+    if (CPLHashSetLookup(psShard->hSetRegions, &sKey) != NULL)
     {
-        psRegion = papsRegions[N_MAX_REGIONS-1];
-        memmove(papsRegions + 1, papsRegions, (N_MAX_REGIONS-1) * sizeof(CachedRegion*));
-        papsRegions[0] = psRegion;
-        CPLFree(psRegion->pData);
+        /* Already downloaded by another handle */
+        return;
     }
-    else
-    {
-        papsRegions = (CachedRegion**) CPLRealloc(papsRegions, (nRegions + 1) * sizeof(CachedRegion*));
-        if (nRegions)
-            memmove(papsRegions + 1, papsRegions, nRegions * sizeof(CachedRegion*));
-        nRegions ++;
-        papsRegions[0] = psRegion = (CachedRegion*) CPLMalloc(sizeof(CachedRegion));
+
+/* -------------------------------------------------------------------- */
+/*      Evict the least recently used regions until the new one fits.   */
+/* -------------------------------------------------------------------- */
+    size_t nRegionBytes = sizeof(CachedRegion) + nSize;
+    while (psShard->psLeastRecent != NULL &&
+           psShard->nCachedBytes + nRegionBytes > nMaxCachedBytesPerShard)
+    {
+        CachedRegion* psEvicted = psShard->psLeastRecent;
+        psShard->psLeastRecent = psEvicted->psPrev;
+        if (psShard->psLeastRecent)
+            psShard->psLeastRecent->psNext = NULL;
+        else
+            psShard->psMostRecent = NULL;
+
+        CPLHashSetRemove(psShard->hSetRegions, psEvicted);
+        psShard->nCachedBytes -= sizeof(CachedRegion) + psEvicted->nSize;
+        CPLFree(psEvicted->pData);
+        CPLFree(psEvicted);
     }
 
+    CachedRegion* psRegion = (CachedRegion*) CPLMalloc(sizeof(CachedRegion));
     psRegion->pszURLHash = pszURLHash;
     psRegion->nFileOffsetStart = nFileOffsetStart;
     psRegion->nSize = nSize;
@@ -1708,8 +2873,54 @@ void  VSICurlFilesystemHandler::AddRegion(const char* pszURL,
     if (nSize)
         memcpy(psRegion->pData, pData, nSize);
 
-    if (bUseCacheDisk)
-        AddRegionToCacheDisk(psRegion);
+    psRegion->psPrev = NULL;
+    psRegion->psNext = psShard->psMostRecent;
+    if (psShard->psMostRecent)
+        psShard->psMostRecent->psPrev = psRegion;
+    else
+        psShard->psLeastRecent = psRegion;
+    psShard->psMostRecent = psRegion;
+    CPLHashSetInsert(psShard->hSetRegions, psRegion);
+    psShard->nCachedBytes += nRegionBytes;
+}
+
+/************************************************************************/
+/*                      GetMaxBlocksPerDownload()                       */
+/*                                                                      */
+/*      Limit a single download to half of the cache, so that it does   */
+/*      not evict its own blocks.                                       */
+/************************************************************************/
+
+int VSICurlFilesystemHandler::GetMaxBlocksPerDownload() const
+{
+    size_t nMaxBlocks = (nMaxCachedBytesPerShard /
+        (sizeof(CachedRegion) + DOWNLOAD_CHUNCK_SIZE)) * N_REGION_CACHE_SHARDS / 2;
+    if (nMaxBlocks < 1)
+        return 1;
+    if (nMaxBlocks > INT_MAX)
+        return INT_MAX;
+    return (int)nMaxBlocks;
+}
+
+/************************************************************************/
+/*                     GetRegionCacheStatistics()                       */
+/************************************************************************/
+
+void VSICurlFilesystemHandler::GetRegionCacheStatistics(GUIntBig* pnHits,
+                                                        GUIntBig* pnMisses,
+                                                        GUIntBig* pnCachedBytes)
+{
+    *pnHits = 0;
+    *pnMisses = 0;
+    *pnCachedBytes = 0;
+    for(int i=0;i<N_REGION_CACHE_SHARDS;i++)
+    {
+        CachedRegionShard* psShard = &asRegionShards[i];
+        CPLMutexHolder oHolder( &psShard->hMutex );
+        *pnHits += psShard->nHits;
+        *pnMisses += psShard->nMisses;
+        *pnCachedBytes += psShard->nCachedBytes;
+    }
 }
 
 /************************************************************************/
@@ -1728,12 +2939,30 @@ CachedFileProp*  VSICurlFilesystemHandler::GetCachedFileProp(const char* pszURL)
         cachedFileProp->bHastComputedFileSize = FALSE;
         cachedFileProp->fileSize = 0;
         cachedFileProp->bIsDirectory = FALSE;
+        cachedFileProp->pszValidator = NULL;
         cacheFileSize[pszURL] = cachedFileProp;
     }
 
     return cachedFileProp;
 }
 
+/************************************************************************/
+/*                       SetCachedFileValidator()                       */
+/************************************************************************/
+
+void VSICurlFilesystemHandler::SetCachedFileValidator(const char* pszURL,
+                                                      const char* pszValidator)
+{
+    CachedFileProp* cachedFileProp = GetCachedFileProp(pszURL);
+
+    CPLMutexHolder oHolder( &hMutex );
+    if (cachedFileProp->pszValidator != NULL &&
+        strcmp(cachedFileProp->pszValidator, pszValidator) == 0)
+        return;
+    CPLFree(cachedFileProp->pszValidator);
+    cachedFileProp->pszValidator = CPLStrdup(pszValidator);
+}
+
 /************************************************************************/
 /*                                Open()                                */
 /************************************************************************/
@@ -1780,7 +3009,7 @@ VSIVirtualHandle* VSICurlFilesystemHandler::Open( const char *pszFilename,
     }
 
     if( CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, pszFilename );
     else
         return poHandle;
 }
@@ -2663,13 +3892,34 @@ char** VSICurlFilesystemHandler::ReadDir( const char *pszDirname )
  * it will progressively increase the chunk size up to 2 MB to improve download
  * performance.
  *
+ * Downloaded blocks are kept in a least-recently-used cache shared by all
+ * /vsicurl/ files, whose size in MB is set with the CPL_VSIL_CURL_CACHE_SIZE
+ * configuration option (default 64, since GDAL 2.0).
+ *
+ * Starting with GDAL 2.0, the downloaded blocks can also be kept in a persistent
+ * disk cache, enabled by setting CPL_VSIL_CURL_CACHE_DIR to a directory (or
+ * CPL_VSIL_CURL_USE_CACHE to YES to use ./gdal_vsicurl_cache). Entries are keyed
+ * on the URL and the ETag or Last-Modified header of the remote file, so only
+ * servers returning one of them benefit from it. The least recently used entries
+ * are removed when the directory exceeds CPL_VSIL_CURL_CACHE_DIR_SIZE MB
+ * (default 1024). The directory can be shared by concurrent processes.
+ *
+ * Starting with GDAL 2.0, setting the configuration option CPL_VSIL_CURL_MULTIRANGE
+ * to PARALLEL (default is MULTIPART) causes the ranges of VSIFReadMultiRangeL()
+ * to be fetched by independent requests run concurrently, instead of a single
+ * multipart/byteranges request. The large read-aheads triggered by sequential
+ * reading are then also split over several connections. The maximum number of
+ * simultaneous connections is set with CPL_VSIL_CURL_MAX_CONNECTIONS (default 8).
+ *
  * The GDAL_HTTP_PROXY, GDAL_HTTP_PROXYUSERPWD and GDAL_PROXY_AUTH configuration options can be
  * used to define a proxy server. The syntax to use is the one of Curl CURLOPT_PROXY,
  * CURLOPT_PROXYUSERPWD and CURLOPT_PROXYAUTH options.
  *
  * Starting with GDAL 1.10, the file can be cached in RAM by setting the configuration option
  * VSI_CACHE to TRUE. The cache size defaults to 25 MB, but can be modified by setting
- * the configuration option VSI_CACHE_SIZE (in bytes).
+ * the configuration option VSI_CACHE_SIZE (in bytes). Since GDAL 2.0, this size is
+ * shared by all the files of the process, and the cached chunks are shared by
+ * the handles opened on the same file.
  *
  * VSIStatL() will return the size in st_size member and file
  * nature- file or directory - in st_mode member (the later only reliable with FTP
@@ -2711,4 +3961,23 @@ int VSICurlUninstallReadCbk(VSILFILE* fp)
     return ((VSICurlHandle*)fp)->UninstallReadCbk();
 }
 
+/************************************************************************/
+/*                  VSICurlGetRegionCacheStatistics()                   */
+/************************************************************************/
+
+void VSICurlGetRegionCacheStatistics(GUIntBig* pnHits, GUIntBig* pnMisses,
+                                     GUIntBig* pnCachedBytes)
+{
+    VSICurlFilesystemHandler* poFS = (VSICurlFilesystemHandler*)
+        VSIFileManager::GetHandler("/vsicurl/");
+    if (poFS == NULL)
+    {
+        *pnHits = 0;
+        *pnMisses = 0;
+        *pnCachedBytes = 0;
+        return;
+    }
+    poFS->GetRegionCacheStatistics(pnHits, pnMisses, pnCachedBytes);
+}
+
 #endif /* HAVE_CURL */
@@ -46,4 +46,8 @@ int VSICurlInstallReadCbk(VSILFILE* fp, VSICurlReadCbkFunc pfnReadCbk, void* pfn
                           int bStopOnInterrruptUntilUninstall);
 int VSICurlUninstallReadCbk(VSILFILE* fp);
 
+/* Counters of the region cache shared by all /vsicurl/ files */
+void VSICurlGetRegionCacheStatistics(GUIntBig* pnHits, GUIntBig* pnMisses,
+                                     GUIntBig* pnCachedBytes);
+
 #endif // CPL_VSIL_CURL_PRIV_H_INCLUDED
@@ -1398,7 +1398,7 @@ VSIVirtualHandle* VSICurlStreamingFSHandler::Open( const char *pszFilename,
     }
 
     if( CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, pszFilename );
     else
         return poHandle;
 }
@@ -1452,7 +1452,9 @@ int VSICurlStreamingFSHandler::Stat( const char *pszFilename,
  *
  * The file can be cached in RAM by setting the configuration option
  * VSI_CACHE to TRUE. The cache size defaults to 25 MB, but can be modified by setting
- * the configuration option VSI_CACHE_SIZE (in bytes).
+ * the configuration option VSI_CACHE_SIZE (in bytes). Since GDAL 2.0, this size is
+ * shared by all the files of the process, and the cached chunks are shared by
+ * the handles opened on the same file.
  *
  * VSIStatL() will return the size in st_size member and file
  * nature- file or directory - in st_mode member (the later only reliable with FTP
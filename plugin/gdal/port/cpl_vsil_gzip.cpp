@@ -70,6 +70,10 @@
    a .gz.properties file, so that we don't need to seek at the end of the file
    each time a Stat() is done.
 
+   For .gz files, a random access index can also be saved in a .gz.idx file
+   (see VSIGZipIndex). It gives the same benefits as snapshots from the first
+   open, and makes it possible to decompress large reads in parallel.
+
    For .zip and .gz, both reading and writing are supported, but just one mode at a time
    (read-only or write-only)
 */
@@ -78,7 +82,10 @@
 #include "cpl_vsi_virtual.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
+#include "cpl_atomic_ops.h"
+#include "cpl_worker_thread_pool.h"
 #include <map>
+#include <vector>
 
 #include <zlib.h>
 #include "cpl_minizip_unzip.h"
@@ -121,6 +128,733 @@ typedef struct
     vsi_l_offset  out;
 } GZipSnapshot;
 
+/************************************************************************/
+/* ==================================================================== */
+/*                          VSIGZipIndex                                */
+/* ==================================================================== */
+/************************************************************************/
+
+/* A random access index is a list of access points taken at deflate block
+   boundaries, in the way of examples/zran.c from the zlib distribution.
+   Contrary to snapshots, which are copies of the in-memory inflate state,
+   an access point only needs its position in the compressed stream (down to
+   the bit), its uncompressed offset, the running CRC of the gzip member and
+   the last 32 KB of uncompressed data to be used as inflate dictionary.
+   It can therefore be saved in a "<file>.idx" sidecar file, and several
+   access points can be decompressed independently from each other. */
+
+#define GZIP_INDEX_MAGIC         "GDALGZX1"
+#define GZIP_INDEX_WINSIZE       32768
+#define GZIP_INDEX_MIN_INTERVAL  (1024 * 1024) /* compressed bytes */
+#define GZIP_INDEX_MAX_POINTS    1024
+#define GZIP_MAX_UINT_CHUNK      ((size_t)1 << 30) /* bytes fed to zlib at once */
+
+typedef struct
+{
+    vsi_l_offset  nCompressedPos;   /* offset of the first whole byte of the block */
+    int           nBits;            /* number of bits of the previous byte belonging to the block */
+    vsi_l_offset  nUncompressedPos;
+    uLong         nCRC;             /* crc32 of the gzip member up to nUncompressedPos */
+    int           nWindowSize;
+    int           nDeflatedWindowSize;
+    GByte        *pabyDeflatedWindow; /* dictionary, compressed with compress2() */
+} GZipIndexPoint;
+
+class VSIGZipIndex
+{
+    volatile int  nRefCount;
+
+                  ~VSIGZipIndex();
+
+  public:
+    vsi_l_offset  nCompressedSize;
+    vsi_l_offset  nUncompressedSize;
+    GIntBig       nMTime;
+    std::vector<GZipIndexPoint> asPoints;
+
+                  VSIGZipIndex();
+
+    void          Reference() { CPLAtomicInc(&nRefCount); }
+    void          Release() { if( CPLAtomicDec(&nRefCount) == 0 ) delete this; }
+
+    int           FindPoint( vsi_l_offset nUncompressedPos ) const;
+    int           SetupStream( int iPoint, z_stream* psStream, VSILFILE* fp ) const;
+    int           Save( const char* pszBaseFileName ) const;
+
+    static CPLString     GetFilename( const char* pszBaseFileName );
+    static VSIGZipIndex* Load( const char* pszBaseFileName,
+                               vsi_l_offset nCompressedSize );
+    static VSIGZipIndex* Build( const char* pszBaseFileName,
+                                vsi_l_offset nCompressedSize );
+};
+
+/************************************************************************/
+/*                            VSIGZipIndex()                            */
+/************************************************************************/
+
+VSIGZipIndex::VSIGZipIndex()
+{
+    nRefCount = 1;
+    nCompressedSize = 0;
+    nUncompressedSize = 0;
+    nMTime = 0;
+}
+
+/************************************************************************/
+/*                           ~VSIGZipIndex()                            */
+/************************************************************************/
+
+VSIGZipIndex::~VSIGZipIndex()
+{
+    for( size_t i = 0; i < asPoints.size(); i++ )
+        CPLFree(asPoints[i].pabyDeflatedWindow);
+}
+
+/************************************************************************/
+/*                            GetFilename()                             */
+/************************************************************************/
+
+CPLString VSIGZipIndex::GetFilename( const char* pszBaseFileName )
+{
+    CPLString osIndexFilename(pszBaseFileName);
+    osIndexFilename += ".idx";
+    return osIndexFilename;
+}
+
+/************************************************************************/
+/*                             FindPoint()                              */
+/*                                                                      */
+/*      Return the last access point located at or before the passed    */
+/*      uncompressed offset, or -1 if there is none.                    */
+/************************************************************************/
+
+int VSIGZipIndex::FindPoint( vsi_l_offset nUncompressedPos ) const
+{
+    int iLow = 0;
+    int iHigh = (int)asPoints.size() - 1;
+    int iFound = -1;
+    while( iLow <= iHigh )
+    {
+        const int iMid = (iLow + iHigh) / 2;
+        if( asPoints[iMid].nUncompressedPos <= nUncompressedPos )
+        {
+            iFound = iMid;
+            iLow = iMid + 1;
+        }
+        else
+            iHigh = iMid - 1;
+    }
+    return iFound;
+}
+
+/************************************************************************/
+/*                            SetupStream()                             */
+/*                                                                      */
+/*      Reset a raw inflate stream so that it resumes decompression at  */
+/*      an access point, and position fp at the next compressed byte    */
+/*      to feed it with.                                                */
+/************************************************************************/
+
+int VSIGZipIndex::SetupStream( int iPoint, z_stream* psStream,
+                               VSILFILE* fp ) const
+{
+    const GZipIndexPoint& sPoint = asPoints[iPoint];
+
+    if( inflateReset(psStream) != Z_OK )
+        return FALSE;
+
+    if( sPoint.nBits != 0 )
+    {
+        GByte byVal = 0;
+        if( VSIFSeekL(fp, sPoint.nCompressedPos - 1, SEEK_SET) != 0 ||
+            VSIFReadL(&byVal, 1, 1, fp) != 1 ||
+            inflatePrime(psStream, sPoint.nBits,
+                         byVal >> (8 - sPoint.nBits)) != Z_OK )
+            return FALSE;
+    }
+    else if( VSIFSeekL(fp, sPoint.nCompressedPos, SEEK_SET) != 0 )
+        return FALSE;
+
+    if( sPoint.nWindowSize != 0 )
+    {
+        Bytef* pabyWindow = (Bytef*)VSIMalloc(GZIP_INDEX_WINSIZE);
+        if( pabyWindow == NULL )
+            return FALSE;
+        uLongf nWindowSize = GZIP_INDEX_WINSIZE;
+        int bOK =
+            uncompress(pabyWindow, &nWindowSize, sPoint.pabyDeflatedWindow,
+                       sPoint.nDeflatedWindowSize) == Z_OK &&
+            (int)nWindowSize == sPoint.nWindowSize &&
+            inflateSetDictionary(psStream, pabyWindow,
+                                 sPoint.nWindowSize) == Z_OK;
+        VSIFree(pabyWindow);
+        if( !bOK )
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                       VSIGZipGetHeaderSize()                         */
+/*                                                                      */
+/*      Return the size of the gzip member header at the start of the   */
+/*      buffer, or 0 if it is not a gzip header or does not fit in it.  */
+/************************************************************************/
+
+static int VSIGZipGetHeaderSize( const GByte* pabyData, size_t nSize )
+{
+    if( nSize < 10 || pabyData[0] != gz_magic[0] ||
+        pabyData[1] != gz_magic[1] || pabyData[2] != Z_DEFLATED ||
+        (pabyData[3] & RESERVED) != 0 )
+        return 0;
+
+    const int nFlags = pabyData[3];
+    size_t nPos = 10; /* magic, method, flags, time, xflags and OS code */
+
+    if( (nFlags & EXTRA_FIELD) != 0 )
+    {
+        if( nPos + 2 > nSize )
+            return 0;
+        nPos += 2 + pabyData[nPos] + (pabyData[nPos + 1] << 8);
+    }
+    if( (nFlags & ORIG_NAME) != 0 )
+    {
+        while( nPos < nSize && pabyData[nPos] != 0 ) nPos ++;
+        nPos ++;
+    }
+    if( (nFlags & COMMENT) != 0 )
+    {
+        while( nPos < nSize && pabyData[nPos] != 0 ) nPos ++;
+        nPos ++;
+    }
+    if( (nFlags & HEAD_CRC) != 0 )
+        nPos += 2;
+
+    return (nPos <= nSize) ? (int)nPos : 0;
+}
+
+/************************************************************************/
+/*                               Build()                                */
+/*                                                                      */
+/*      Decompress the whole file and collect an access point at the    */
+/*      first block boundary following each interval of compressed     */
+/*      data.                                                           */
+/************************************************************************/
+
+VSIGZipIndex* VSIGZipIndex::Build( const char* pszBaseFileName,
+                                   vsi_l_offset nCompressedSize )
+{
+    VSIStatBufL sStat;
+    if( VSIStatL(pszBaseFileName, &sStat) != 0 )
+        return NULL;
+
+    VSILFILE* fp = VSIFOpenL(pszBaseFileName, "rb");
+    if( fp == NULL )
+        return NULL;
+
+    z_stream sStream;
+    memset(&sStream, 0, sizeof(sStream));
+    if( inflateInit2(&sStream, -MAX_WBITS) != Z_OK )
+    {
+        VSIFCloseL(fp);
+        return NULL;
+    }
+
+    GByte* pabyIn = (GByte*)VSIMalloc(Z_BUFSIZE);
+    GByte* pabyWindow = (GByte*)VSIMalloc(GZIP_INDEX_WINSIZE);
+    GByte* pabyDict = (GByte*)VSIMalloc(GZIP_INDEX_WINSIZE);
+    const uLong nMaxDeflatedSize = compressBound(GZIP_INDEX_WINSIZE);
+    GByte* pabyDeflated = (GByte*)VSIMalloc(nMaxDeflatedSize);
+
+    const vsi_l_offset nInterval =
+        MAX(GZIP_INDEX_MIN_INTERVAL, nCompressedSize / GZIP_INDEX_MAX_POINTS);
+
+    VSIGZipIndex* poIndex = new VSIGZipIndex();
+    poIndex->nCompressedSize = nCompressedSize;
+    poIndex->nMTime = (GIntBig)sStat.st_mtime;
+
+    vsi_l_offset nTotalOut = 0;
+    vsi_l_offset nMemberOut = 0;
+    vsi_l_offset nLastPointPos = 0;
+    uLong nCRC = 0;
+    int nMembers = 0;
+    int bInHeader = TRUE;
+    int bOK = FALSE;
+
+    sStream.next_in = pabyIn;
+    sStream.avail_in = 0;
+    sStream.next_out = pabyWindow;
+    sStream.avail_out = GZIP_INDEX_WINSIZE;
+
+    while( pabyIn != NULL && pabyWindow != NULL && pabyDict != NULL &&
+           pabyDeflated != NULL )
+    {
+        if( bInHeader )
+        {
+            /* Make sure the whole member header is in the input buffer */
+            memmove(pabyIn, sStream.next_in, sStream.avail_in);
+            sStream.next_in = pabyIn;
+            sStream.avail_in += (uInt)VSIFReadL(pabyIn + sStream.avail_in, 1,
+                                    Z_BUFSIZE - sStream.avail_in, fp);
+            if( sStream.avail_in == 0 && nMembers > 0 )
+            {
+                bOK = TRUE;
+                break;
+            }
+
+            const int nHeaderSize =
+                VSIGZipGetHeaderSize(pabyIn, sStream.avail_in);
+            if( nHeaderSize == 0 )
+                break;
+            sStream.next_in += nHeaderSize;
+            sStream.avail_in -= nHeaderSize;
+
+            inflateReset(&sStream);
+            nCRC = crc32(0L, Z_NULL, 0);
+            nMemberOut = 0;
+            bInHeader = FALSE;
+        }
+
+        if( sStream.avail_in == 0 )
+        {
+            sStream.avail_in = (uInt)VSIFReadL(pabyIn, 1, Z_BUFSIZE, fp);
+            sStream.next_in = pabyIn;
+            if( sStream.avail_in == 0 )
+                break; /* truncated stream */
+        }
+        if( sStream.avail_out == 0 )
+        {
+            sStream.next_out = pabyWindow;
+            sStream.avail_out = GZIP_INDEX_WINSIZE;
+        }
+
+        Bytef* pabyOut = sStream.next_out;
+        const int nErr = inflate(&sStream, Z_BLOCK);
+        const uInt nProduced = (uInt)(sStream.next_out - pabyOut);
+        nCRC = crc32(nCRC, pabyOut, nProduced);
+        nTotalOut += nProduced;
+        nMemberOut += nProduced;
+
+        if( nErr == Z_STREAM_END )
+        {
+            /* Check the CRC and size of the member in its trailer */
+            GByte abyTrailer[8];
+            int i;
+            for( i = 0; i < 8; i++ )
+            {
+                if( sStream.avail_in == 0 )
+                {
+                    sStream.avail_in =
+                        (uInt)VSIFReadL(pabyIn, 1, Z_BUFSIZE, fp);
+                    sStream.next_in = pabyIn;
+                    if( sStream.avail_in == 0 )
+                        break;
+                }
+                abyTrailer[i] = *(sStream.next_in++);
+                sStream.avail_in --;
+            }
+            if( i < 8 )
+                break;
+
+            GUInt32 nReadCRC, nReadSize;
+            memcpy(&nReadCRC, abyTrailer, 4);
+            memcpy(&nReadSize, abyTrailer + 4, 4);
+            CPL_LSBPTR32(&nReadCRC);
+            CPL_LSBPTR32(&nReadSize);
+            if( nReadCRC != (GUInt32)nCRC ||
+                nReadSize != (GUInt32)(nMemberOut & 0xFFFFFFFFU) )
+            {
+                CPLError(CE_Failure, CPLE_FileIO,
+                         "CRC error while indexing %s", pszBaseFileName);
+                break;
+            }
+
+            nMembers ++;
+            bInHeader = TRUE;
+            continue;
+        }
+        if( nErr != Z_OK )
+        {
+            CPLError(CE_Failure, CPLE_FileIO,
+                     "Decompression error while indexing %s", pszBaseFileName);
+            break;
+        }
+
+        /* At the end of a block which is not the last one of the member ? */
+        if( (sStream.data_type & 128) == 0 || (sStream.data_type & 64) != 0 )
+            continue;
+
+        const vsi_l_offset nPos = VSIFTellL(fp) - sStream.avail_in;
+        if( nPos - nLastPointPos < nInterval )
+            continue;
+
+        /* The dictionary is the tail of the circular window buffer */
+        const int nFilled = GZIP_INDEX_WINSIZE - sStream.avail_out;
+        const int nWindowSize =
+            (int)MIN((vsi_l_offset)GZIP_INDEX_WINSIZE, nMemberOut);
+        if( nWindowSize > nFilled )
+        {
+            memcpy(pabyDict,
+                   pabyWindow + GZIP_INDEX_WINSIZE - (nWindowSize - nFilled),
+                   nWindowSize - nFilled);
+            memcpy(pabyDict + nWindowSize - nFilled, pabyWindow, nFilled);
+        }
+        else
+            memcpy(pabyDict, pabyWindow + nFilled - nWindowSize, nWindowSize);
+
+        uLongf nDeflatedSize = nMaxDeflatedSize;
+        if( compress2(pabyDeflated, &nDeflatedSize, pabyDict, nWindowSize,
+                      Z_DEFAULT_COMPRESSION) != Z_OK )
+            break;
+
+        GZipIndexPoint sPoint;
+        sPoint.nCompressedPos = nPos;
+        sPoint.nBits = sStream.data_type & 7;
+        sPoint.nUncompressedPos = nTotalOut;
+        sPoint.nCRC = nCRC;
+        sPoint.nWindowSize = nWindowSize;
+        sPoint.nDeflatedWindowSize = (int)nDeflatedSize;
+        sPoint.pabyDeflatedWindow = (GByte*)CPLMalloc(nDeflatedSize);
+        memcpy(sPoint.pabyDeflatedWindow, pabyDeflated, nDeflatedSize);
+        poIndex->asPoints.push_back(sPoint);
+
+        nLastPointPos = nPos;
+    }
+
+    inflateEnd(&sStream);
+    VSIFree(pabyIn);
+    VSIFree(pabyWindow);
+    VSIFree(pabyDict);
+    VSIFree(pabyDeflated);
+    VSIFCloseL(fp);
+
+    if( !bOK )
+    {
+        delete poIndex;
+        return NULL;
+    }
+
+    poIndex->nUncompressedSize = nTotalOut;
+    CPLDebug("GZIP", "Built index of %s with %d access points",
+             pszBaseFileName, (int)poIndex->asPoints.size());
+    return poIndex;
+}
+
+/************************************************************************/
+/*                                Save()                                */
+/*                                                                      */
+/*      The sidecar file is laid out as follows, all integers being     */
+/*      little endian :                                                 */
+/*        - magic "GDALGZX1",                                           */
+/*        - compressed size, uncompressed size and modification time   */
+/*          of the .gz file, as 64 bit integers,                        */
+/*        - number of access points, as 32 bit integer,                 */
+/*        - for each access point : compressed and uncompressed         */
+/*          offsets as 64 bit integers, then crc, bits, window size and */
+/*          deflated window size as 32 bit integers, then the deflated  */
+/*          window.                                                     */
+/************************************************************************/
+
+static void VSIGZipIndexWriteUInt64( VSILFILE* fp, GUIntBig nVal )
+{
+    CPL_LSBPTR64(&nVal);
+    VSIFWriteL(&nVal, 1, sizeof(nVal), fp);
+}
+
+static void VSIGZipIndexWriteUInt32( VSILFILE* fp, GUInt32 nVal )
+{
+    CPL_LSBPTR32(&nVal);
+    VSIFWriteL(&nVal, 1, sizeof(nVal), fp);
+}
+
+int VSIGZipIndex::Save( const char* pszBaseFileName ) const
+{
+    const CPLString osIndexFilename(GetFilename(pszBaseFileName));
+
+    /* Write in a temporary file and rename it, so that a concurrent */
+    /* reader never sees a partial index. */
+    const CPLString osTmpFilename(
+        CPLSPrintf("%s." CPL_FRMT_GIB ".tmp", osIndexFilename.c_str(),
+                   CPLGetPID()));
+
+    VSILFILE* fp = VSIFOpenL(osTmpFilename, "wb");
+    if( fp == NULL )
+    {
+        CPLDebug("GZIP", "Cannot create %s", osTmpFilename.c_str());
+        return FALSE;
+    }
+
+    VSIFWriteL(GZIP_INDEX_MAGIC, 1, 8, fp);
+    VSIGZipIndexWriteUInt64(fp, nCompressedSize);
+    VSIGZipIndexWriteUInt64(fp, nUncompressedSize);
+    VSIGZipIndexWriteUInt64(fp, (GUIntBig)nMTime);
+    VSIGZipIndexWriteUInt32(fp, (GUInt32)asPoints.size());
+    for( size_t i = 0; i < asPoints.size(); i++ )
+    {
+        const GZipIndexPoint& sPoint = asPoints[i];
+        VSIGZipIndexWriteUInt64(fp, sPoint.nCompressedPos);
+        VSIGZipIndexWriteUInt64(fp, sPoint.nUncompressedPos);
+        VSIGZipIndexWriteUInt32(fp, (GUInt32)sPoint.nCRC);
+        VSIGZipIndexWriteUInt32(fp, (GUInt32)sPoint.nBits);
+        VSIGZipIndexWriteUInt32(fp, (GUInt32)sPoint.nWindowSize);
+        VSIGZipIndexWriteUInt32(fp, (GUInt32)sPoint.nDeflatedWindowSize);
+        VSIFWriteL(sPoint.pabyDeflatedWindow, 1,
+                   sPoint.nDeflatedWindowSize, fp);
+    }
+
+    int bOK = (VSIFCloseL(fp) == 0);
+    if( bOK )
+        bOK = (VSIRename(osTmpFilename, osIndexFilename) == 0);
+    if( !bOK )
+    {
+        CPLDebug("GZIP", "Cannot write %s", osIndexFilename.c_str());
+        VSIUnlink(osTmpFilename);
+    }
+    return bOK;
+}
+
+/************************************************************************/
+/*                                Load()                                */
+/*                                                                      */
+/*      Read the sidecar index of a .gz file, if it exists and still    */
+/*      matches the size and modification time of the file.            */
+/************************************************************************/
+
+static int VSIGZipIndexReadUInt64( VSILFILE* fp, GUIntBig* pnVal )
+{
+    if( VSIFReadL(pnVal, 1, sizeof(*pnVal), fp) != sizeof(*pnVal) )
+        return FALSE;
+    CPL_LSBPTR64(pnVal);
+    return TRUE;
+}
+
+static int VSIGZipIndexReadUInt32( VSILFILE* fp, GUInt32* pnVal )
+{
+    if( VSIFReadL(pnVal, 1, sizeof(*pnVal), fp) != sizeof(*pnVal) )
+        return FALSE;
+    CPL_LSBPTR32(pnVal);
+    return TRUE;
+}
+
+VSIGZipIndex* VSIGZipIndex::Load( const char* pszBaseFileName,
+                                  vsi_l_offset nCompressedSize )
+{
+    VSILFILE* fp = VSIFOpenL(GetFilename(pszBaseFileName), "rb");
+    if( fp == NULL )
+        return NULL;
+
+    VSIStatBufL sStat;
+    char szMagic[8];
+    GUIntBig nIndexCompressedSize = 0, nIndexUncompressedSize = 0;
+    GUIntBig nIndexMTime = 0;
+    GUInt32 nPoints = 0;
+
+    if( VSIStatL(pszBaseFileName, &sStat) != 0 ||
+        VSIFReadL(szMagic, 1, 8, fp) != 8 ||
+        memcmp(szMagic, GZIP_INDEX_MAGIC, 8) != 0 ||
+        !VSIGZipIndexReadUInt64(fp, &nIndexCompressedSize) ||
+        !VSIGZipIndexReadUInt64(fp, &nIndexUncompressedSize) ||
+        !VSIGZipIndexReadUInt64(fp, &nIndexMTime) ||
+        !VSIGZipIndexReadUInt32(fp, &nPoints) ||
+        nIndexCompressedSize != nCompressedSize ||
+        (GIntBig)nIndexMTime != (GIntBig)sStat.st_mtime )
+    {
+        CPLDebug("GZIP", "Ignoring missing or outdated %s",
+                 GetFilename(pszBaseFileName).c_str());
+        VSIFCloseL(fp);
+        return NULL;
+    }
+
+    VSIGZipIndex* poIndex = new VSIGZipIndex();
+    poIndex->nCompressedSize = nIndexCompressedSize;
+    poIndex->nUncompressedSize = nIndexUncompressedSize;
+    poIndex->nMTime = (GIntBig)nIndexMTime;
+
+    const uLong nMaxDeflatedSize = compressBound(GZIP_INDEX_WINSIZE);
+    int bOK = TRUE;
+    for( GUInt32 i = 0; bOK && i < nPoints; i++ )
+    {
+        GUIntBig nCompressedPos = 0, nUncompressedPos = 0;
+        GUInt32 nCRC = 0, nBits = 0, nWindowSize = 0, nDeflatedSize = 0;
+        bOK = VSIGZipIndexReadUInt64(fp, &nCompressedPos) &&
+              VSIGZipIndexReadUInt64(fp, &nUncompressedPos) &&
+              VSIGZipIndexReadUInt32(fp, &nCRC) &&
+              VSIGZipIndexReadUInt32(fp, &nBits) &&
+              VSIGZipIndexReadUInt32(fp, &nWindowSize) &&
+              VSIGZipIndexReadUInt32(fp, &nDeflatedSize) &&
+              nCompressedPos <= nIndexCompressedSize &&
+              nUncompressedPos <= nIndexUncompressedSize &&
+              nBits < 8 && nWindowSize <= GZIP_INDEX_WINSIZE &&
+              nDeflatedSize <= nMaxDeflatedSize &&
+              (poIndex->asPoints.empty() ||
+               (nCompressedPos > poIndex->asPoints.back().nCompressedPos &&
+                nUncompressedPos >= poIndex->asPoints.back().nUncompressedPos));
+        if( !bOK )
+            break;
+
+        GZipIndexPoint sPoint;
+        sPoint.nCompressedPos = nCompressedPos;
+        sPoint.nBits = (int)nBits;
+        sPoint.nUncompressedPos = nUncompressedPos;
+        sPoint.nCRC = nCRC;
+        sPoint.nWindowSize = (int)nWindowSize;
+        sPoint.nDeflatedWindowSize = (int)nDeflatedSize;
+        sPoint.pabyDeflatedWindow = (GByte*)CPLMalloc(MAX(1, nDeflatedSize));
+        bOK = VSIFReadL(sPoint.pabyDeflatedWindow, 1, nDeflatedSize, fp) ==
+                                                            nDeflatedSize;
+        poIndex->asPoints.push_back(sPoint);
+    }
+    VSIFCloseL(fp);
+
+    if( !bOK )
+    {
+        CPLError(CE_Warning, CPLE_AppDefined, "%s is corrupted, ignoring it",
+                 GetFilename(pszBaseFileName).c_str());
+        delete poIndex;
+        return NULL;
+    }
+
+    return poIndex;
+}
+
+/************************************************************************/
+/*                    Parallel decompression of segments                */
+/************************************************************************/
+
+typedef struct
+{
+    const VSIGZipIndex *poIndex;
+    const char         *pszBaseFileName;
+    GByte              *pabyBuffer;       /* receives the first segment */
+    vsi_l_offset        nBufferOffset;    /* uncompressed offset of pabyBuffer */
+    int                 iNextPoint;
+    int                 iLastPoint;
+    CPLMutex           *hMutex;
+    int                 bError;
+} VSIGZipSegmentsJob;
+
+/************************************************************************/
+/*                       VSIGZipDecompressSegment()                     */
+/*                                                                      */
+/*      Decompress the data between access points iPoint and iPoint+1,  */
+/*      and check it against the CRCs recorded in the index.            */
+/************************************************************************/
+
+static int VSIGZipDecompressSegment( VSIGZipSegmentsJob* psJob, int iPoint,
+                                     z_stream* psStream, GByte* pabyIn,
+                                     VSILFILE* fp )
+{
+    const GZipIndexPoint& sStart = psJob->poIndex->asPoints[iPoint];
+    const GZipIndexPoint& sEnd = psJob->poIndex->asPoints[iPoint + 1];
+    const size_t nSize =
+        (size_t)(sEnd.nUncompressedPos - sStart.nUncompressedPos);
+    GByte* pabyOut = psJob->pabyBuffer +
+        (size_t)(sStart.nUncompressedPos - psJob->nBufferOffset);
+
+    if( !psJob->poIndex->SetupStream(iPoint, psStream, fp) )
+        return FALSE;
+
+    /* zlib counts bytes in uInt, so feed segments larger than that */
+    /* in several chunks */
+    size_t nRemaining = nSize;
+    psStream->next_out = pabyOut;
+    psStream->avail_out = 0;
+    psStream->avail_in = 0;
+    while( nRemaining != 0 || psStream->avail_out != 0 )
+    {
+        if( psStream->avail_out == 0 )
+        {
+            psStream->avail_out = (uInt)MIN(nRemaining, GZIP_MAX_UINT_CHUNK);
+            nRemaining -= psStream->avail_out;
+        }
+        if( psStream->avail_in == 0 )
+        {
+            psStream->avail_in = (uInt)VSIFReadL(pabyIn, 1, Z_BUFSIZE, fp);
+            psStream->next_in = pabyIn;
+            if( psStream->avail_in == 0 )
+                return FALSE;
+        }
+        /* Z_STREAM_END means a gzip member boundary within the segment, */
+        /* which is left to the sequential code path. */
+        if( inflate(psStream, Z_NO_FLUSH) != Z_OK )
+            return FALSE;
+    }
+
+    uLong nCRC = crc32(0L, Z_NULL, 0);
+    for( size_t nDone = 0; nDone < nSize; )
+    {
+        const uInt nChunk = (uInt)MIN(nSize - nDone, GZIP_MAX_UINT_CHUNK);
+        nCRC = crc32(nCRC, pabyOut + nDone, nChunk);
+        nDone += nChunk;
+    }
+    if( crc32_combine(sStart.nCRC, nCRC, (z_off_t)nSize) != sEnd.nCRC )
+    {
+        CPLError(CE_Failure, CPLE_FileIO, "CRC error in segment %d of %s",
+                 iPoint, psJob->pszBaseFileName);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/************************************************************************/
+/*                   VSIGZipDecompressSegmentsFunc()                    */
+/************************************************************************/
+
+static void VSIGZipDecompressSegmentsFunc( void* pData )
+{
+    VSIGZipSegmentsJob* psJob = (VSIGZipSegmentsJob*)pData;
+
+    z_stream sStream;
+    memset(&sStream, 0, sizeof(sStream));
+    GByte* pabyIn = (GByte*)VSIMalloc(Z_BUFSIZE);
+    VSILFILE* fp = VSIFOpenL(psJob->pszBaseFileName, "rb");
+    int bOK = pabyIn != NULL && fp != NULL &&
+              inflateInit2(&sStream, -MAX_WBITS) == Z_OK;
+
+    while( bOK )
+    {
+        int iPoint;
+        {
+            CPLMutexHolder oHolder(psJob->hMutex);
+            if( psJob->bError || psJob->iNextPoint >= psJob->iLastPoint )
+                break;
+            iPoint = psJob->iNextPoint ++;
+        }
+        bOK = VSIGZipDecompressSegment(psJob, iPoint, &sStream, pabyIn, fp);
+    }
+
+    if( !bOK )
+    {
+        CPLMutexHolder oHolder(psJob->hMutex);
+        psJob->bError = TRUE;
+    }
+
+    if( sStream.state != NULL )
+        inflateEnd(&sStream);
+    VSIFree(pabyIn);
+    if( fp != NULL )
+        VSIFCloseL(fp);
+}
+
+/************************************************************************/
+/*                        VSIGZipGetNumThreads()                        */
+/************************************************************************/
+
+static int VSIGZipGetNumThreads( const char* pszOption, const char* pszDefault )
+{
+    const char* pszThreads = CPLGetConfigOption(pszOption, pszDefault);
+    if( EQUAL(pszThreads, "ALL_CPUS") )
+        return CPLGetNumCPUs();
+    return atoi(pszThreads);
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                       VSIGZipHandle                                  */
+/* ==================================================================== */
+/************************************************************************/
+
 class VSIGZipHandle : public VSIVirtualHandle
 {
     VSIVirtualHandle* poBaseHandle;
@@ -148,12 +882,19 @@ class VSIGZipHandle : public VSIVirtualHandle
     GZipSnapshot* snapshots;
     vsi_l_offset snapshot_byte_interval; /* number of compressed bytes at which we create a "snapshot" */
 
+    VSIGZipIndex* poIndex;  /* optional random access index */
+    int           bCanReadParallel;
+
     void check_header();
     int get_byte();
     int gzseek( vsi_l_offset nOffset, int nWhence );
     int gzrewind ();
     uLong getLong ();
 
+    int  BuildIndex();
+    int  SeekToIndexPoint( int iPoint );
+    int  ReadParallel( GByte* pabyBuffer, size_t nLen, size_t* pnRead );
+
   public:
 
     VSIGZipHandle(VSIVirtualHandle* poBaseHandle,
@@ -183,6 +924,8 @@ class VSIGZipHandle : public VSIVirtualHandle
     vsi_l_offset      GetUncompressedSize() { return uncompressed_size; }
     
     void              SaveInfo_unlocked();
+
+    void              LoadIndex();
 };
 
 
@@ -238,8 +981,14 @@ VSIGZipHandle* VSIGZipHandle::Duplicate()
 
     poHandle->nLastReadOffset = nLastReadOffset;
 
-    /* Most important : duplicate the snapshots ! */
-
+    if (poIndex != NULL)
+    {
+        poIndex->Reference();
+        poHandle->poIndex = poIndex;
+    }
+
+    /* Most important : duplicate the snapshots ! */
+
     unsigned int i;
     for(i=0;i<compressed_size / snapshot_byte_interval + 1;i++)
     {
@@ -328,6 +1077,9 @@ VSIGZipHandle::VSIGZipHandle(VSIVirtualHandle* poBaseHandle,
     }
     stream.avail_out = Z_BUFSIZE;
 
+    poIndex = NULL;
+    bCanReadParallel = TRUE;
+
     if (offset == 0) check_header(); /* skip the .gz header */
     startOff = VSIFTellL((VSILFILE*)poBaseHandle) - stream.avail_in;
 
@@ -357,6 +1109,76 @@ void VSIGZipHandle::SaveInfo_unlocked()
     }
 }
 
+/************************************************************************/
+/*                             LoadIndex()                              */
+/************************************************************************/
+
+void VSIGZipHandle::LoadIndex()
+{
+    if (poIndex != NULL || pszBaseFileName == NULL || offset != 0 ||
+        transparent ||
+        !CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_GZIP_USE_INDEX", "YES")))
+        return;
+
+    poIndex = VSIGZipIndex::Load(pszBaseFileName, compressed_size);
+    if (poIndex != NULL && uncompressed_size == 0)
+        uncompressed_size = poIndex->nUncompressedSize;
+}
+
+/************************************************************************/
+/*                             BuildIndex()                             */
+/************************************************************************/
+
+int VSIGZipHandle::BuildIndex()
+{
+    CPLAssert(poIndex == NULL);
+
+    poIndex = VSIGZipIndex::Build(pszBaseFileName, compressed_size);
+    if (poIndex == NULL)
+        return FALSE;
+
+    poIndex->Save(pszBaseFileName);
+    uncompressed_size = poIndex->nUncompressedSize;
+    return TRUE;
+}
+
+/************************************************************************/
+/*                          SeekToIndexPoint()                          */
+/*                                                                      */
+/*      Position the stream at an access point. On failure, the index   */
+/*      is discarded and the stream rewound.                            */
+/************************************************************************/
+
+int VSIGZipHandle::SeekToIndexPoint( int iPoint )
+{
+    const GZipIndexPoint& sPoint = poIndex->asPoints[iPoint];
+
+    if (ENABLE_DEBUG)
+        CPLDebug("GZIP", "using index point %d : in=" CPL_FRMT_GUIB
+                         " out=" CPL_FRMT_GUIB,
+                 iPoint, sPoint.nCompressedPos, sPoint.nUncompressedPos);
+
+    if (!poIndex->SetupStream(iPoint, &stream, (VSILFILE*)poBaseHandle))
+    {
+        CPLError(CE_Warning, CPLE_AppDefined,
+                 "Cannot use access point %d of %s. Ignoring the index",
+                 iPoint, VSIGZipIndex::GetFilename(pszBaseFileName).c_str());
+        poIndex->Release();
+        poIndex = NULL;
+        gzrewind();
+        return FALSE;
+    }
+    stream.avail_in = 0;
+    stream.next_in = inbuf;
+    z_err = Z_OK;
+    z_eof = 0;
+    crc = sPoint.nCRC;
+    transparent = 0;
+    in = sPoint.nCompressedPos - startOff;
+    out = sPoint.nUncompressedPos;
+    return TRUE;
+}
+
 /************************************************************************/
 /*                      ~VSIGZipHandle()                                */
 /************************************************************************/
@@ -390,6 +1212,8 @@ VSIGZipHandle::~VSIGZipHandle()
         }
         CPLFree(snapshots);
     }
+    if (poIndex != NULL)
+        poIndex->Release();
     CPLFree(pszBaseFileName);
 
     if (poBaseHandle)
@@ -600,6 +1424,17 @@ int VSIGZipHandle::gzseek( vsi_l_offset offset, int whence )
     /* whence == SEEK_END is unsuppored in original gzseek. */
     if (whence == SEEK_END)
     {
+        /* Building an index costs the same full decompression as the */
+        /* slow path below, but only once */
+        /* Also done when the size is already known, from a .properties */
+        /* file for example */
+        if (offset == 0 && poIndex == NULL &&
+            pszBaseFileName != NULL && this->offset == 0 &&
+            CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_GZIP_WRITE_INDEX", "NO")))
+        {
+            BuildIndex();
+        }
+
         /* If we known the uncompressed size, we can fake a jump to */
         /* the end of the stream */
         if (offset == 0 && uncompressed_size != 0)
@@ -642,6 +1477,21 @@ int VSIGZipHandle::gzseek( vsi_l_offset offset, int whence )
             CPL_VSIL_GZ_RETURN(-1);
             return -1L;
     }
+
+    /* Jump to the closest access point of the index, if it is ahead. */
+    /* A closer snapshot may still be used below. */
+    if (poIndex != NULL)
+    {
+        int iPoint = poIndex->FindPoint(out + offset);
+        if (iPoint >= 0 && poIndex->asPoints[iPoint].nUncompressedPos > out)
+        {
+            const vsi_l_offset nTarget = out + offset;
+            if (SeekToIndexPoint(iPoint))
+                offset = nTarget - out;
+            else
+                offset = nTarget; /* rewound */
+        }
+    }
     
     unsigned int i;
     for(i=0;i<compressed_size / snapshot_byte_interval + 1;i++)
@@ -755,6 +1605,97 @@ vsi_l_offset VSIGZipHandle::Tell()
     return out;
 }
 
+/************************************************************************/
+/*                            ReadParallel()                            */
+/*                                                                      */
+/*      Serve a read spanning several segments of the index by          */
+/*      decompressing the segments in parallel. Returns FALSE, without  */
+/*      side effect, if the read is too small to benefit from it.       */
+/************************************************************************/
+
+int VSIGZipHandle::ReadParallel( GByte* pabyBuffer, size_t nLen,
+                                 size_t* pnRead )
+{
+    const vsi_l_offset nStart = out;
+
+    /* First access point at or after the start, last one before the end */
+    int iFirst = poIndex->FindPoint(nStart);
+    if (iFirst < 0 || poIndex->asPoints[iFirst].nUncompressedPos < nStart)
+        iFirst ++;
+    const int iLast = poIndex->FindPoint(nStart + nLen);
+    if (iLast - iFirst < 2)
+        return FALSE;
+
+    const int nThreads = MIN(VSIGZipGetNumThreads("GDAL_NUM_THREADS", "1"), iLast - iFirst);
+    if (nThreads < 2)
+        return FALSE;
+
+    /* Head, up to the first access point */
+    const size_t nHead =
+        (size_t)(poIndex->asPoints[iFirst].nUncompressedPos - nStart);
+    if (nHead != 0)
+    {
+        *pnRead = Read(pabyBuffer, 1, nHead);
+        if (*pnRead != nHead)
+            return TRUE;
+    }
+
+    /* Whole segments in between */
+    VSIGZipSegmentsJob sJob;
+    sJob.poIndex = poIndex;
+    sJob.pszBaseFileName = pszBaseFileName;
+    sJob.pabyBuffer = pabyBuffer + nHead;
+    sJob.nBufferOffset = poIndex->asPoints[iFirst].nUncompressedPos;
+    sJob.iNextPoint = iFirst;
+    sJob.iLastPoint = iLast;
+    sJob.hMutex = CPLCreateMutex();
+    sJob.bError = FALSE;
+    CPLReleaseMutex(sJob.hMutex);
+
+    std::vector<CPLJoinableThread*> ahThreads;
+    for (int i = 1; i < nThreads; i++)
+    {
+        CPLJoinableThread* hThread =
+            CPLCreateJoinableThread(VSIGZipDecompressSegmentsFunc, &sJob);
+        if (hThread == NULL)
+            break;
+        ahThreads.push_back(hThread);
+    }
+    VSIGZipDecompressSegmentsFunc(&sJob);
+    for (size_t i = 0; i < ahThreads.size(); i++)
+        CPLJoinThread(ahThreads[i]);
+    CPLDestroyMutex(sJob.hMutex);
+
+    if (sJob.bError)
+    {
+        /* Typically a gzip member boundary within a segment */
+        CPLDebug("GZIP", "Parallel decompression failed. "
+                 "Reverting to sequential decompression");
+        bCanReadParallel = FALSE;
+        if (!SeekToIndexPoint(iFirst) && Seek(nStart + nHead, SEEK_SET) != 0)
+        {
+            *pnRead = nHead;
+            return TRUE;
+        }
+        *pnRead = nHead + Read(pabyBuffer + nHead, 1, nLen - nHead);
+        return TRUE;
+    }
+
+    /* Tail, from the last access point */
+    const vsi_l_offset nLastPos = poIndex->asPoints[iLast].nUncompressedPos;
+    if (!SeekToIndexPoint(iLast) && Seek(nLastPos, SEEK_SET) != 0)
+    {
+        *pnRead = nHead;
+        return TRUE;
+    }
+    *pnRead = (size_t)(out - nStart);
+    if (out > nLastReadOffset)
+        nLastReadOffset = out;
+    if (*pnRead < nLen)
+        *pnRead += Read(pabyBuffer + *pnRead, 1, nLen - *pnRead);
+    return TRUE;
+}
+
 /************************************************************************/
 /*                              Read()                                  */
 /************************************************************************/
@@ -783,6 +1724,13 @@ size_t VSIGZipHandle::Read( void *buf, size_t nSize, size_t nMemb )
         return 0;  /* EOF */
     }
 
+    if (poIndex != NULL && bCanReadParallel && !transparent)
+    {
+        size_t nRead = 0;
+        if (ReadParallel((GByte*)buf, len, &nRead))
+            return nRead / nSize;
+    }
+
     next_out = (Byte*)buf;
     stream.next_out = (Bytef*)buf;
     stream.avail_out = len;
@@ -957,58 +1905,452 @@ size_t VSIGZipHandle::Write( CPL_UNUSED const void *pBuffer,
 }
 
 /************************************************************************/
-/*                               Eof()                                  */
+/*                               Eof()                                  */
+/************************************************************************/
+
+
+int VSIGZipHandle::Eof()
+{
+    if (ENABLE_DEBUG) CPLDebug("GZIP", "Eof()");
+    return z_eof && in == 0;
+}
+
+/************************************************************************/
+/*                              Flush()                                 */
+/************************************************************************/
+
+int VSIGZipHandle::Flush()
+{
+    return 0;
+}
+
+/************************************************************************/
+/*                              Close()                                 */
+/************************************************************************/
+
+int VSIGZipHandle::Close()
+{
+    return 0;
+}
+
+
+/************************************************************************/
+/* ==================================================================== */
+/*                       VSIGZipWriteHandle                             */
+/* ==================================================================== */
+/************************************************************************/
+
+class VSIGZipWriteHandle : public VSIVirtualHandle
+{
+    VSIVirtualHandle*  poBaseHandle;
+    z_stream           sStream;
+    Byte              *pabyInBuf;
+    Byte              *pabyOutBuf;
+    bool               bCompressActive;
+    vsi_l_offset       nCurOffset;
+    GUInt32            nCRC;
+    int                bRegularZLib;
+    int                bAutoCloseBaseHandle;
+
+  public:
+
+    VSIGZipWriteHandle(VSIVirtualHandle* poBaseHandle, int bRegularZLib, int bAutoCloseBaseHandleIn);
+
+    ~VSIGZipWriteHandle();
+
+    virtual int       Seek( vsi_l_offset nOffset, int nWhence );
+    virtual vsi_l_offset Tell();
+    virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       Eof();
+    virtual int       Flush();
+    virtual int       Close();
+};
+
+/************************************************************************/
+/*                         VSIGZipWriteHandle()                         */
+/************************************************************************/
+
+VSIGZipWriteHandle::VSIGZipWriteHandle( VSIVirtualHandle *poBaseHandle,
+                                        int bRegularZLibIn,
+                                        int bAutoCloseBaseHandleIn )
+
+{
+    nCurOffset = 0;
+
+    this->poBaseHandle = poBaseHandle;
+    bRegularZLib = bRegularZLibIn;
+    bAutoCloseBaseHandle = bAutoCloseBaseHandleIn;
+
+    nCRC = crc32(0L, Z_NULL, 0);
+    sStream.zalloc = (alloc_func)0;
+    sStream.zfree = (free_func)0;
+    sStream.opaque = (voidpf)0;
+    sStream.next_in = Z_NULL;
+    sStream.next_out = Z_NULL;
+    sStream.avail_in = sStream.avail_out = 0;
+
+    pabyInBuf = (Byte *) CPLMalloc( Z_BUFSIZE );
+    sStream.next_in  = pabyInBuf;
+
+    pabyOutBuf = (Byte *) CPLMalloc( Z_BUFSIZE );
+
+    if( deflateInit2( &sStream, Z_DEFAULT_COMPRESSION,
+                      Z_DEFLATED, (bRegularZLib) ? MAX_WBITS : -MAX_WBITS, 8,
+                      Z_DEFAULT_STRATEGY ) != Z_OK )
+        bCompressActive = false;
+    else
+    {
+        if (!bRegularZLib)
+        {
+            char header[11];
+
+            /* Write a very simple .gz header:
+            */
+            sprintf( header, "%c%c%c%c%c%c%c%c%c%c", gz_magic[0], gz_magic[1],
+                    Z_DEFLATED, 0 /*flags*/, 0,0,0,0 /*time*/, 0 /*xflags*/,
+                    0x03 );
+            poBaseHandle->Write( header, 1, 10 );
+        }
+
+        bCompressActive = true;
+    }
+}
+
+/************************************************************************/
+/*                       VSICreateGZipWritable()                        */
+/************************************************************************/
+
+VSIVirtualHandle* VSICreateGZipWritable( VSIVirtualHandle* poBaseHandle,
+                                         int bRegularZLibIn,
+                                         int bAutoCloseBaseHandle )
+{
+    return new VSIGZipWriteHandle( poBaseHandle, bRegularZLibIn, bAutoCloseBaseHandle );
+}
+
+/************************************************************************/
+/*                        ~VSIGZipWriteHandle()                         */
+/************************************************************************/
+
+VSIGZipWriteHandle::~VSIGZipWriteHandle()
+
+{
+    if( bCompressActive )
+        Close();
+
+    CPLFree( pabyInBuf );
+    CPLFree( pabyOutBuf );
+}
+
+/************************************************************************/
+/*                               Close()                                */
+/************************************************************************/
+
+int VSIGZipWriteHandle::Close()
+
+{
+    if( bCompressActive )
+    {
+        sStream.next_out = pabyOutBuf;
+        sStream.avail_out = Z_BUFSIZE;
+
+        deflate( &sStream, Z_FINISH );
+
+        size_t nOutBytes = Z_BUFSIZE - sStream.avail_out;
+
+        if( poBaseHandle->Write( pabyOutBuf, 1, nOutBytes ) < nOutBytes )
+            return EOF;
+
+        deflateEnd( &sStream );
+
+        if( !bRegularZLib )
+        {
+            GUInt32 anTrailer[2];
+
+            anTrailer[0] = CPL_LSBWORD32( nCRC );
+            anTrailer[1] = CPL_LSBWORD32( (GUInt32) nCurOffset );
+
+            poBaseHandle->Write( anTrailer, 1, 8 );
+        }
+
+        if( bAutoCloseBaseHandle )
+        {
+            poBaseHandle->Close();
+
+            delete poBaseHandle;
+        }
+
+        bCompressActive = false;
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                                Read()                                */
+/************************************************************************/
+
+size_t VSIGZipWriteHandle::Read( CPL_UNUSED void *pBuffer,
+                                 CPL_UNUSED size_t nSize,
+                                 CPL_UNUSED size_t nMemb )
+{
+    CPLError(CE_Failure, CPLE_NotSupported, "VSIFReadL is not supported on GZip write streams\n");
+    return 0;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+size_t VSIGZipWriteHandle::Write( const void *pBuffer, 
+                                  size_t nSize, size_t nMemb )
+
+{
+    int  nBytesToWrite, nNextByte;
+
+    nBytesToWrite = (int) (nSize * nMemb);
+    nNextByte = 0;
+
+    nCRC = crc32(nCRC, (const Bytef *)pBuffer, nBytesToWrite);
+
+    if( !bCompressActive )
+        return 0;
+
+    while( nNextByte < nBytesToWrite )
+    {
+        sStream.next_out = pabyOutBuf;
+        sStream.avail_out = Z_BUFSIZE;
+
+        if( sStream.avail_in > 0 )
+            memmove( pabyInBuf, sStream.next_in, sStream.avail_in );
+
+        int nNewBytesToWrite = MIN((int) (Z_BUFSIZE-sStream.avail_in),
+                                   nBytesToWrite - nNextByte);
+        memcpy( pabyInBuf + sStream.avail_in, 
+                ((Byte *) pBuffer) + nNextByte, 
+                nNewBytesToWrite );
+        
+        sStream.next_in = pabyInBuf;
+        sStream.avail_in += nNewBytesToWrite;
+
+        deflate( &sStream, Z_NO_FLUSH );
+
+        size_t nOutBytes = Z_BUFSIZE - sStream.avail_out;
+
+        if( nOutBytes > 0 )
+        {
+            if( poBaseHandle->Write( pabyOutBuf, 1, nOutBytes ) < nOutBytes )
+                return 0;
+        }
+
+        nNextByte += nNewBytesToWrite;
+        nCurOffset += nNewBytesToWrite;
+    }
+
+    return nMemb;
+}
+
+/************************************************************************/
+/*                               Flush()                                */
+/************************************************************************/
+
+int VSIGZipWriteHandle::Flush()
+
+{
+    // we *could* do something for this but for now we choose not to.
+
+    return 0;
+}
+
+/************************************************************************/
+/*                                Eof()                                 */
+/************************************************************************/
+
+int VSIGZipWriteHandle::Eof()
+
+{
+    return 1;
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+int VSIGZipWriteHandle::Seek( vsi_l_offset nOffset, int nWhence )
+
+{
+    if( nOffset == 0 && (nWhence == SEEK_END || nWhence == SEEK_CUR) )
+        return 0;
+    else if( nWhence == SEEK_SET && nOffset == nCurOffset )
+        return 0;
+    else
+    {
+        CPLError(CE_Failure, CPLE_NotSupported,
+                 "Seeking on writable compressed data streams not supported." );
+               
+        return -1;
+    }
+}
+
+/************************************************************************/
+/*                                Tell()                                */
+/************************************************************************/
+
+vsi_l_offset VSIGZipWriteHandle::Tell()
+
+{
+    return nCurOffset;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                       VSIGZipWriteHandleMT                           */
+/* ==================================================================== */
 /************************************************************************/
 
+/* Multi-threaded compressor, in the way of pigz. The input is cut into
+   chunks that are deflated independently on worker threads. Each chunk but
+   the first one is primed with the last 32 KB of the previous one as
+   dictionary, so that the compression ratio stays close to the one of a
+   single stream. Chunks but the last one are terminated with a sync flush,
+   which aligns them on a byte boundary without ending the deflate stream,
+   so that their outputs can be concatenated. The CRC32 or Adler-32 of each
+   chunk is computed by its worker, and combined when it is written. */
 
-int VSIGZipHandle::Eof()
+#define DEFLATE_DICT_SIZE  32768
+
+typedef struct
 {
-    if (ENABLE_DEBUG) CPLDebug("GZIP", "Eof()");
-    return z_eof && in == 0;
-}
+    int                 nDeflateType;
+    GByte              *pabyIn;
+    size_t              nInSize;
+    GByte              *pabyDict;  /* NULL for the first chunk */
+    int                 bFinal;
+    GByte              *pabyOut;
+    size_t              nOutSize;
+    uLong               nCheck;    /* crc32 or adler32 of pabyIn */
+    int                 bOK;
+
+    /* Set when run by a thread pool, to signal completion */
+    CPLMutex           *hMutex;
+    CPLCond            *hCond;
+    int                 bDone;
+} VSIDeflateJob;
 
 /************************************************************************/
-/*                              Flush()                                 */
+/*                          VSIDeflateJobFunc()                         */
 /************************************************************************/
 
-int VSIGZipHandle::Flush()
+static void VSIDeflateJobFunc( void* pData )
 {
-    return 0;
+    VSIDeflateJob* psJob = (VSIDeflateJob*)pData;
+
+    if( psJob->nDeflateType == CPL_DEFLATE_TYPE_ZLIB )
+        psJob->nCheck = adler32(adler32(0L, Z_NULL, 0),
+                                psJob->pabyIn, (uInt)psJob->nInSize);
+    else
+        psJob->nCheck = crc32(crc32(0L, Z_NULL, 0),
+                              psJob->pabyIn, (uInt)psJob->nInSize);
+
+    z_stream sStream;
+    memset(&sStream, 0, sizeof(sStream));
+    if( deflateInit2(&sStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                     8, Z_DEFAULT_STRATEGY) != Z_OK )
+        return;
+    if( psJob->pabyDict != NULL &&
+        deflateSetDictionary(&sStream, psJob->pabyDict,
+                             DEFLATE_DICT_SIZE) != Z_OK )
+    {
+        deflateEnd(&sStream);
+        return;
+    }
+
+    /* Room for the worst case, plus the sync flush marker */
+    size_t nOutAlloc = deflateBound(&sStream, (uLong)psJob->nInSize) + 16;
+    psJob->pabyOut = (GByte*)VSIMalloc(nOutAlloc);
+
+    sStream.next_in = psJob->pabyIn;
+    sStream.avail_in = (uInt)psJob->nInSize;
+    const int nFlush = psJob->bFinal ? Z_FINISH : Z_SYNC_FLUSH;
+    int nErr = Z_OK;
+    while( psJob->pabyOut != NULL )
+    {
+        sStream.next_out = psJob->pabyOut + sStream.total_out;
+        sStream.avail_out = (uInt)(nOutAlloc - sStream.total_out);
+        nErr = deflate(&sStream, nFlush);
+        if( nErr == Z_STREAM_END ||
+            (nErr == Z_OK && !psJob->bFinal && sStream.avail_out != 0) )
+            break;
+        if( nErr != Z_OK && nErr != Z_BUF_ERROR )
+            break;
+
+        nOutAlloc *= 2;
+        GByte* pabyNewOut = (GByte*)VSIRealloc(psJob->pabyOut, nOutAlloc);
+        if( pabyNewOut == NULL )
+        {
+            VSIFree(psJob->pabyOut);
+            psJob->pabyOut = NULL;
+        }
+        else
+            psJob->pabyOut = pabyNewOut;
+    }
+    psJob->nOutSize = sStream.total_out;
+    psJob->bOK = psJob->pabyOut != NULL &&
+                 (nErr == Z_STREAM_END || (nErr == Z_OK && !psJob->bFinal));
+    deflateEnd(&sStream);
 }
 
 /************************************************************************/
-/*                              Close()                                 */
+/*                       VSIDeflateJobPoolFunc()                        */
 /************************************************************************/
 
-int VSIGZipHandle::Close()
+static void VSIDeflateJobPoolFunc( void* pData )
 {
-    return 0;
-}
+    VSIDeflateJob* psJob = (VSIDeflateJob*)pData;
 
+    VSIDeflateJobFunc(psJob);
+
+    CPLMutexHolderOptionalLockD( psJob->hMutex );
+    psJob->bDone = TRUE;
+    CPLCondBroadcast(psJob->hCond);
+}
 
 /************************************************************************/
-/* ==================================================================== */
-/*                       VSIGZipWriteHandle                             */
-/* ==================================================================== */
+/*                        VSIGZipWriteHandleMT                          */
 /************************************************************************/
 
-class VSIGZipWriteHandle : public VSIVirtualHandle
+class VSIGZipWriteHandleMT : public VSIVirtualHandle
 {
     VSIVirtualHandle*  poBaseHandle;
-    z_stream           sStream;
-    Byte              *pabyInBuf;
-    Byte              *pabyOutBuf;
-    bool               bCompressActive;
-    vsi_l_offset       nCurOffset;
-    GUInt32            nCRC;
-    int                bRegularZLib;
+    int                nDeflateType;
     int                bAutoCloseBaseHandle;
+    int                nThreads;
+    size_t             nChunkSize;
+
+    CPLWorkerThreadPool *poPool;  /* NULL when single-threaded */
+    CPLMutex          *hJobMutex;
+    CPLCond           *hJobCond;
+
+    GByte             *pabyChunk;
+    size_t             nChunkFill;
+    GByte             *pabyDict;   /* last 32 KB of the previous chunk */
+    std::vector<VSIDeflateJob*> apoJobs; /* in flight, oldest first */
+
+    vsi_l_offset       nCurOffset;
+    uLong              nCheck;
+    int                bError;
+    bool               bCompressActive;
+
+    int                SubmitChunk( int bFinal );
+    int                WriteOldestJob();
 
   public:
 
-    VSIGZipWriteHandle(VSIVirtualHandle* poBaseHandle, int bRegularZLib, int bAutoCloseBaseHandleIn);
+    VSIGZipWriteHandleMT( VSIVirtualHandle* poBaseHandle, int nDeflateType,
+                          int bAutoCloseBaseHandleIn, int nThreads,
+                          size_t nChunkSize );
 
-    ~VSIGZipWriteHandle();
+    ~VSIGZipWriteHandleMT();
 
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
@@ -1020,131 +2362,230 @@ class VSIGZipWriteHandle : public VSIVirtualHandle
 };
 
 /************************************************************************/
-/*                         VSIGZipWriteHandle()                         */
+/*                        VSIGZipWriteHandleMT()                        */
 /************************************************************************/
 
-VSIGZipWriteHandle::VSIGZipWriteHandle( VSIVirtualHandle *poBaseHandle,
-                                        int bRegularZLibIn,
-                                        int bAutoCloseBaseHandleIn )
-
+VSIGZipWriteHandleMT::VSIGZipWriteHandleMT( VSIVirtualHandle* poBaseHandle,
+                                            int nDeflateType,
+                                            int bAutoCloseBaseHandleIn,
+                                            int nThreads,
+                                            size_t nChunkSize )
 {
-    nCurOffset = 0;
-
     this->poBaseHandle = poBaseHandle;
-    bRegularZLib = bRegularZLibIn;
+    this->nDeflateType = nDeflateType;
     bAutoCloseBaseHandle = bAutoCloseBaseHandleIn;
+    this->nThreads = MAX(1, nThreads);
+    /* A chunk must at least fill the dictionary of the next one */
+    this->nChunkSize = MAX(nChunkSize, 2 * DEFLATE_DICT_SIZE);
 
-    nCRC = crc32(0L, Z_NULL, 0);
-    sStream.zalloc = (alloc_func)0;
-    sStream.zfree = (free_func)0;
-    sStream.opaque = (voidpf)0;
-    sStream.next_in = Z_NULL;
-    sStream.next_out = Z_NULL;
-    sStream.avail_in = sStream.avail_out = 0;
-
-    pabyInBuf = (Byte *) CPLMalloc( Z_BUFSIZE );
-    sStream.next_in  = pabyInBuf;
+    pabyChunk = (GByte*)CPLMalloc(this->nChunkSize);
+    nChunkFill = 0;
+    pabyDict = NULL;
+    nCurOffset = 0;
+    bError = FALSE;
+    bCompressActive = true;
 
-    pabyOutBuf = (Byte *) CPLMalloc( Z_BUFSIZE );
+    poPool = NULL;
+    hJobMutex = NULL;
+    hJobCond = NULL;
+    if( this->nThreads > 1 )
+    {
+        hJobMutex = CPLCreateMutex();
+        CPLReleaseMutex(hJobMutex);
+        hJobCond = CPLCreateCond();
+        poPool = new CPLWorkerThreadPool();
+        if( hJobCond == NULL || poPool->Setup(this->nThreads) == 0 )
+        {
+            CPLDebug("VSIGZIP", "No worker thread available: "
+                     "compressing in the calling thread");
+            delete poPool;
+            poPool = NULL;
+        }
+    }
 
-    if( deflateInit2( &sStream, Z_DEFAULT_COMPRESSION,
-                      Z_DEFLATED, (bRegularZLib) ? MAX_WBITS : -MAX_WBITS, 8,
-                      Z_DEFAULT_STRATEGY ) != Z_OK )
-        bCompressActive = false;
+    if( nDeflateType == CPL_DEFLATE_TYPE_ZLIB )
+    {
+        /* Deflate with 32 KB window, default compression level */
+        const GByte abyHeader[2] = { 0x78, 0x9C };
+        nCheck = adler32(0L, Z_NULL, 0);
+        poBaseHandle->Write( abyHeader, 1, 2 );
+    }
     else
     {
-        if (!bRegularZLib)
+        nCheck = crc32(0L, Z_NULL, 0);
+        if( nDeflateType == CPL_DEFLATE_TYPE_GZIP )
         {
-            char header[11];
-
-            /* Write a very simple .gz header:
-            */
-            sprintf( header, "%c%c%c%c%c%c%c%c%c%c", gz_magic[0], gz_magic[1],
-                    Z_DEFLATED, 0 /*flags*/, 0,0,0,0 /*time*/, 0 /*xflags*/,
-                    0x03 );
-            poBaseHandle->Write( header, 1, 10 );
+            /* Same very simple .gz header as VSIGZipWriteHandle */
+            const GByte abyHeader[10] = { (GByte)gz_magic[0],
+                                          (GByte)gz_magic[1], Z_DEFLATED,
+                                          0 /*flags*/, 0,0,0,0 /*time*/,
+                                          0 /*xflags*/, 0x03 };
+            poBaseHandle->Write( abyHeader, 1, 10 );
         }
-
-        bCompressActive = true;
     }
 }
 
 /************************************************************************/
-/*                       VSICreateGZipWritable()                        */
+/*                       ~VSIGZipWriteHandleMT()                        */
 /************************************************************************/
 
-VSIVirtualHandle* VSICreateGZipWritable( VSIVirtualHandle* poBaseHandle,
-                                         int bRegularZLibIn,
-                                         int bAutoCloseBaseHandle )
+VSIGZipWriteHandleMT::~VSIGZipWriteHandleMT()
+
 {
-    return new VSIGZipWriteHandle( poBaseHandle, bRegularZLibIn, bAutoCloseBaseHandle );
+    if( bCompressActive )
+        Close();
+
+    delete poPool;
+    if( hJobCond != NULL )
+        CPLDestroyCond( hJobCond );
+    if( hJobMutex != NULL )
+        CPLDestroyMutex( hJobMutex );
+
+    CPLFree( pabyChunk );
+    CPLFree( pabyDict );
 }
 
 /************************************************************************/
-/*                        ~VSIGZipWriteHandle()                         */
+/*                            SubmitChunk()                             */
 /************************************************************************/
 
-VSIGZipWriteHandle::~VSIGZipWriteHandle()
-
+int VSIGZipWriteHandleMT::SubmitChunk( int bFinal )
 {
-    if( bCompressActive )
-        Close();
+    /* Bound the number of chunks in flight, and thus the memory usage */
+    while( (int)apoJobs.size() >= nThreads )
+    {
+        if( !WriteOldestJob() )
+            return FALSE;
+    }
 
-    CPLFree( pabyInBuf );
-    CPLFree( pabyOutBuf );
+    VSIDeflateJob* psJob = (VSIDeflateJob*)CPLCalloc(1, sizeof(VSIDeflateJob));
+    psJob->nDeflateType = nDeflateType;
+    psJob->pabyIn = pabyChunk;
+    psJob->nInSize = nChunkFill;
+    psJob->pabyDict = pabyDict;
+    psJob->bFinal = bFinal;
+
+    /* The dictionary of the next chunk is the tail of this one */
+    pabyDict = NULL;
+    if( !bFinal )
+    {
+        pabyDict = (GByte*)CPLMalloc(DEFLATE_DICT_SIZE);
+        memcpy(pabyDict, pabyChunk + nChunkFill - DEFLATE_DICT_SIZE,
+               DEFLATE_DICT_SIZE);
+        pabyChunk = (GByte*)CPLMalloc(nChunkSize);
+    }
+    else
+        pabyChunk = NULL;
+    nChunkFill = 0;
+
+    apoJobs.push_back(psJob);
+    if( poPool != NULL )
+    {
+        psJob->hMutex = hJobMutex;
+        psJob->hCond = hJobCond;
+        poPool->SubmitJob(VSIDeflateJobPoolFunc, psJob);
+    }
+    else
+        VSIDeflateJobFunc(psJob);
+
+    return TRUE;
 }
 
 /************************************************************************/
-/*                               Close()                                */
+/*                           WriteOldestJob()                           */
 /************************************************************************/
 
-int VSIGZipWriteHandle::Close()
-
+int VSIGZipWriteHandleMT::WriteOldestJob()
 {
-    if( bCompressActive )
+    VSIDeflateJob* psJob = apoJobs[0];
+    apoJobs.erase(apoJobs.begin());
+
+    if( poPool != NULL )
     {
-        sStream.next_out = pabyOutBuf;
-        sStream.avail_out = Z_BUFSIZE;
+        CPLMutexHolderOptionalLockD( hJobMutex );
+        while( !psJob->bDone )
+            CPLCondWait(hJobCond, hJobMutex);
+    }
 
-        deflate( &sStream, Z_FINISH );
+    if( !psJob->bOK )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Compression failed");
+        bError = TRUE;
+    }
+    else if( !bError &&
+             poBaseHandle->Write(psJob->pabyOut, 1, psJob->nOutSize) <
+                                                            psJob->nOutSize )
+        bError = TRUE;
 
-        size_t nOutBytes = Z_BUFSIZE - sStream.avail_out;
+    if( nDeflateType == CPL_DEFLATE_TYPE_ZLIB )
+        nCheck = adler32_combine(nCheck, psJob->nCheck, (z_off_t)psJob->nInSize);
+    else
+        nCheck = crc32_combine(nCheck, psJob->nCheck, (z_off_t)psJob->nInSize);
 
-        if( poBaseHandle->Write( pabyOutBuf, 1, nOutBytes ) < nOutBytes )
-            return EOF;
+    CPLFree(psJob->pabyIn);
+    CPLFree(psJob->pabyDict);
+    VSIFree(psJob->pabyOut);
+    CPLFree(psJob);
 
-        deflateEnd( &sStream );
+    return !bError;
+}
 
-        if( !bRegularZLib )
-        {
-            GUInt32 anTrailer[2];
+/************************************************************************/
+/*                               Close()                                */
+/************************************************************************/
 
-            anTrailer[0] = CPL_LSBWORD32( nCRC );
-            anTrailer[1] = CPL_LSBWORD32( (GUInt32) nCurOffset );
+int VSIGZipWriteHandleMT::Close()
 
-            poBaseHandle->Write( anTrailer, 1, 8 );
-        }
+{
+    if( !bCompressActive )
+        return 0;
+    bCompressActive = false;
 
-        if( bAutoCloseBaseHandle )
-        {
-            poBaseHandle->Close();
+    int nRet = 0;
+    if( !bError )
+        SubmitChunk(TRUE);
+    while( !apoJobs.empty() )
+        WriteOldestJob();
+    if( bError )
+        nRet = EOF;
 
-            delete poBaseHandle;
-        }
+    if( nRet == 0 && nDeflateType == CPL_DEFLATE_TYPE_GZIP )
+    {
+        GUInt32 anTrailer[2];
 
-        bCompressActive = false;
+        anTrailer[0] = CPL_LSBWORD32( (GUInt32) nCheck );
+        anTrailer[1] = CPL_LSBWORD32( (GUInt32) nCurOffset );
+
+        if( poBaseHandle->Write( anTrailer, 1, 8 ) < 8 )
+            nRet = EOF;
+    }
+    else if( nRet == 0 && nDeflateType == CPL_DEFLATE_TYPE_ZLIB )
+    {
+        const GByte abyTrailer[4] = { (GByte)(nCheck >> 24),
+                                      (GByte)(nCheck >> 16),
+                                      (GByte)(nCheck >> 8),
+                                      (GByte)nCheck };
+        if( poBaseHandle->Write( abyTrailer, 1, 4 ) < 4 )
+            nRet = EOF;
     }
 
-    return 0;
+    if( bAutoCloseBaseHandle )
+    {
+        poBaseHandle->Close();
+
+        delete poBaseHandle;
+    }
+
+    return nRet;
 }
 
 /************************************************************************/
 /*                                Read()                                */
 /************************************************************************/
 
-size_t VSIGZipWriteHandle::Read( CPL_UNUSED void *pBuffer,
-                                 CPL_UNUSED size_t nSize,
-                                 CPL_UNUSED size_t nMemb )
+size_t VSIGZipWriteHandleMT::Read( CPL_UNUSED void *pBuffer,
+                                   CPL_UNUSED size_t nSize,
+                                   CPL_UNUSED size_t nMemb )
 {
     CPLError(CE_Failure, CPLE_NotSupported, "VSIFReadL is not supported on GZip write streams\n");
     return 0;
@@ -1154,49 +2595,27 @@ size_t VSIGZipWriteHandle::Read( CPL_UNUSED void *pBuffer,
 /*                               Write()                                */
 /************************************************************************/
 
-size_t VSIGZipWriteHandle::Write( const void *pBuffer, 
-                                  size_t nSize, size_t nMemb )
+size_t VSIGZipWriteHandleMT::Write( const void *pBuffer,
+                                    size_t nSize, size_t nMemb )
 
 {
-    int  nBytesToWrite, nNextByte;
-
-    nBytesToWrite = (int) (nSize * nMemb);
-    nNextByte = 0;
-
-    nCRC = crc32(nCRC, (const Bytef *)pBuffer, nBytesToWrite);
-
-    if( !bCompressActive )
+    if( !bCompressActive || bError )
         return 0;
 
-    while( nNextByte < nBytesToWrite )
-    {
-        sStream.next_out = pabyOutBuf;
-        sStream.avail_out = Z_BUFSIZE;
-
-        if( sStream.avail_in > 0 )
-            memmove( pabyInBuf, sStream.next_in, sStream.avail_in );
-
-        int nNewBytesToWrite = MIN((int) (Z_BUFSIZE-sStream.avail_in),
-                                   nBytesToWrite - nNextByte);
-        memcpy( pabyInBuf + sStream.avail_in, 
-                ((Byte *) pBuffer) + nNextByte, 
-                nNewBytesToWrite );
-        
-        sStream.next_in = pabyInBuf;
-        sStream.avail_in += nNewBytesToWrite;
-
-        deflate( &sStream, Z_NO_FLUSH );
-
-        size_t nOutBytes = Z_BUFSIZE - sStream.avail_out;
-
-        if( nOutBytes > 0 )
-        {
-            if( poBaseHandle->Write( pabyOutBuf, 1, nOutBytes ) < nOutBytes )
-                return 0;
-        }
+    const GByte* pabyIn = (const GByte*)pBuffer;
+    size_t nBytesToWrite = nSize * nMemb;
 
-        nNextByte += nNewBytesToWrite;
-        nCurOffset += nNewBytesToWrite;
+    while( nBytesToWrite > 0 )
+    {
+        const size_t nToCopy = MIN(nBytesToWrite, nChunkSize - nChunkFill);
+        memcpy(pabyChunk + nChunkFill, pabyIn, nToCopy);
+        nChunkFill += nToCopy;
+        pabyIn += nToCopy;
+        nBytesToWrite -= nToCopy;
+        nCurOffset += nToCopy;
+
+        if( nChunkFill == nChunkSize && !SubmitChunk(FALSE) )
+            return 0;
     }
 
     return nMemb;
@@ -1206,11 +2625,9 @@ size_t VSIGZipWriteHandle::Write( const void *pBuffer,
 /*                               Flush()                                */
 /************************************************************************/
 
-int VSIGZipWriteHandle::Flush()
+int VSIGZipWriteHandleMT::Flush()
 
 {
-    // we *could* do something for this but for now we choose not to.
-
     return 0;
 }
 
@@ -1218,7 +2635,7 @@ int VSIGZipWriteHandle::Flush()
 /*                                Eof()                                 */
 /************************************************************************/
 
-int VSIGZipWriteHandle::Eof()
+int VSIGZipWriteHandleMT::Eof()
 
 {
     return 1;
@@ -1228,7 +2645,7 @@ int VSIGZipWriteHandle::Eof()
 /*                                Seek()                                */
 /************************************************************************/
 
-int VSIGZipWriteHandle::Seek( vsi_l_offset nOffset, int nWhence )
+int VSIGZipWriteHandleMT::Seek( vsi_l_offset nOffset, int nWhence )
 
 {
     if( nOffset == 0 && (nWhence == SEEK_END || nWhence == SEEK_CUR) )
@@ -1239,7 +2656,7 @@ int VSIGZipWriteHandle::Seek( vsi_l_offset nOffset, int nWhence )
     {
         CPLError(CE_Failure, CPLE_NotSupported,
                  "Seeking on writable compressed data streams not supported." );
-               
+
         return -1;
     }
 }
@@ -1248,12 +2665,78 @@ int VSIGZipWriteHandle::Seek( vsi_l_offset nOffset, int nWhence )
 /*                                Tell()                                */
 /************************************************************************/
 
-vsi_l_offset VSIGZipWriteHandle::Tell()
+vsi_l_offset VSIGZipWriteHandleMT::Tell()
 
 {
     return nCurOffset;
 }
 
+/************************************************************************/
+/*                       VSICreateGZipWritable()                        */
+/************************************************************************/
+
+/**
+ * \brief Create a handle compressing the data written to it into a base
+ * handle.
+ *
+ * @param poBaseHandle handle receiving the compressed data.
+ * @param nDeflateType CPL_DEFLATE_TYPE_GZIP, CPL_DEFLATE_TYPE_ZLIB or
+ *                     CPL_DEFLATE_TYPE_RAW_DEFLATE.
+ * @param bAutoCloseBaseHandle whether poBaseHandle is closed and destroyed
+ *                             when the returned handle is closed.
+ * @param nThreads number of compression threads. If greater than 1, the data
+ *                 is cut in chunks of nChunkSize bytes deflated in parallel.
+ * @param nChunkSize size of the chunks in multi-threaded mode.
+ *
+ * @since GDAL 2.0
+ */
+
+VSIVirtualHandle* VSICreateGZipWritable( VSIVirtualHandle* poBaseHandle,
+                                         int nDeflateType,
+                                         int bAutoCloseBaseHandle,
+                                         int nThreads,
+                                         size_t nChunkSize )
+{
+    if( nThreads > 1 || nDeflateType == CPL_DEFLATE_TYPE_RAW_DEFLATE )
+        return new VSIGZipWriteHandleMT( poBaseHandle, nDeflateType,
+                                         bAutoCloseBaseHandle, nThreads,
+                                         nChunkSize );
+    return new VSIGZipWriteHandle( poBaseHandle,
+                                   nDeflateType == CPL_DEFLATE_TYPE_ZLIB,
+                                   bAutoCloseBaseHandle );
+}
+
+/************************************************************************/
+/*                       VSIGetDeflateNumThreads()                      */
+/*                                                                      */
+/*      Multi-threaded compression is used by the /vsigzip/ and         */
+/*      /vsizip/ writers when CPL_VSIL_DEFLATE_NUM_THREADS is set. It   */
+/*      is not enabled by default, as the output differs from the one   */
+/*      of a single deflate stream.                                     */
+/************************************************************************/
+
+static int VSIGetDeflateNumThreads()
+{
+    return VSIGZipGetNumThreads("CPL_VSIL_DEFLATE_NUM_THREADS", "1");
+}
+
+/************************************************************************/
+/*                       VSIGetDeflateChunkSize()                       */
+/************************************************************************/
+
+static size_t VSIGetDeflateChunkSize()
+{
+    const char* pszChunkSize =
+        CPLGetConfigOption("CPL_VSIL_DEFLATE_CHUNK_SIZE", "1M");
+    size_t nChunkSize = (size_t)CPLScanUIntBig(pszChunkSize,
+                                               (int)strlen(pszChunkSize));
+    if( strchr(pszChunkSize, 'K') || strchr(pszChunkSize, 'k') )
+        nChunkSize *= 1024;
+    else if( strchr(pszChunkSize, 'M') || strchr(pszChunkSize, 'm') )
+        nChunkSize *= 1024 * 1024;
+    return nChunkSize;
+}
+
 
 /************************************************************************/
 /* ==================================================================== */
@@ -1361,7 +2844,13 @@ VSIVirtualHandle* VSIGZipFilesystemHandler::Open( const char *pszFilename,
             return NULL;
 
         else
-            return new VSIGZipWriteHandle( poVirtualHandle, strchr(pszAccess, 'z') != NULL, TRUE );
+            return VSICreateGZipWritable( poVirtualHandle,
+                                          strchr(pszAccess, 'z') != NULL ?
+                                            CPL_DEFLATE_TYPE_ZLIB :
+                                            CPL_DEFLATE_TYPE_GZIP,
+                                          TRUE,
+                                          VSIGetDeflateNumThreads(),
+                                          VSIGetDeflateChunkSize() );
     }
 
 /* -------------------------------------------------------------------- */
@@ -1421,7 +2910,10 @@ VSIGZipHandle* VSIGZipFilesystemHandler::OpenGZipReadOnly( const char *pszFilena
         poHandleLastGZipFile = NULL;
     }
 
-    return new VSIGZipHandle(poVirtualHandle, pszFilename + strlen("/vsigzip/"));
+    VSIGZipHandle* poHandle =
+        new VSIGZipHandle(poVirtualHandle, pszFilename + strlen("/vsigzip/"));
+    poHandle->LoadIndex();
+    return poHandle;
 }
 
 /************************************************************************/
@@ -1584,6 +3076,25 @@ char** VSIGZipFilesystemHandler::ReadDir( CPL_UNUSED const char *pszDirname )
  *
  * Additional documentation is to be found at http://trac.osgeo.org/gdal/wiki/UserDocs/ReadInZip
  *
+ * Starting with GDAL 2.0, if the CPL_VSIL_GZIP_WRITE_INDEX configuration
+ * option is set to YES, the first seek to the end of a .gz file that has no
+ * index yet decompresses it entirely, even if its size is already known from
+ * a .properties file, and builds a random access index saved as a
+ * "<file>.gz.idx" sidecar file. Such an index, when present and
+ * matching the size and modification time of the .gz file, is used on later
+ * opens (unless CPL_VSIL_GZIP_USE_INDEX is set to NO) to get the
+ * uncompressed size, to seek quickly, and to decompress reads spanning
+ * several indexed segments (about 1/1000th of the file, and 1 MB at least)
+ * with GDAL_NUM_THREADS threads (1 by default, so sequentially, ALL_CPUS is
+ * accepted).
+ *
+ * Starting with GDAL 2.0, if CPL_VSIL_DEFLATE_NUM_THREADS is set to a number
+ * greater than 1 or ALL_CPUS (it is 1 by default), writing is
+ * multi-threaded: the data is cut in chunks of CPL_VSIL_DEFLATE_CHUNK_SIZE
+ * bytes (1M by default, K and M suffixes are accepted) that are compressed
+ * in parallel into a single gzip stream. GDAL_NUM_THREADS is not used for
+ * writing, as the output is not byte-identical to the single-threaded one.
+ *
  * @since GDAL 1.6.0
  */
 
@@ -2139,8 +3650,19 @@ VSIVirtualHandle* VSIZipFilesystemHandler::OpenForWrite_unlocked( const char *ps
         if (chLastChar == '/' || chLastChar == '\\')
             osZipInFileName += chLastChar;
 
-        if (CPLCreateFileInZip(poZIPHandle->GetHandle(),
-                               osZipInFileName, NULL) != CE_None)
+        char** papszOptions = NULL;
+        const int nThreads = VSIGetDeflateNumThreads();
+        if (nThreads > 1)
+        {
+            papszOptions = CSLSetNameValue(papszOptions, "NUM_THREADS",
+                                           CPLSPrintf("%d", nThreads));
+            papszOptions = CSLSetNameValue(papszOptions, "CHUNK_SIZE",
+                CPLSPrintf(CPL_FRMT_GUIB, (GUIntBig)VSIGetDeflateChunkSize()));
+        }
+        CPLErr eErr = CPLCreateFileInZip(poZIPHandle->GetHandle(),
+                                         osZipInFileName, papszOptions);
+        CSLDestroy(papszOptions);
+        if (eErr != CE_None)
             return NULL;
 
         VSIZipWriteHandle* poChildHandle =
@@ -2381,6 +3903,11 @@ void  VSIZipWriteHandle::StartNewFile(VSIZipWriteHandle* poSubFile)
  * zip file. Read and write operations cannot be interleaved : the new zip must
  * be closed before being re-opened for read.
  *
+ * Starting with GDAL 2.0, if the CPL_VSIL_DEFLATE_NUM_THREADS configuration
+ * option is set to a number greater than 1 or ALL_CPUS (it is 1 by default),
+ * files written in a zip are compressed by that many threads, in chunks of CPL_VSIL_DEFLATE_CHUNK_SIZE
+ * bytes (1M by default, K and M suffixes are accepted).
+ *
  * Additional documentation is to be found at http://trac.osgeo.org/gdal/wiki/UserDocs/ReadInZip
  *
  * @since GDAL 1.6.0
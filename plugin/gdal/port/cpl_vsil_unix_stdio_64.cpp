@@ -51,6 +51,7 @@
 #include <sys/types.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 
 CPL_CVSID("$Id: cpl_vsil_unix_stdio_64.cpp 29006 2015-04-25 11:03:10Z rouault $");
 
@@ -74,6 +75,21 @@ CPL_CVSID("$Id: cpl_vsil_unix_stdio_64.cpp 29006 2015-04-25 11:03:10Z rouault $"
 #ifndef VSI_FTRUNCATE64
 #define VSI_FTRUNCATE64 ftruncate64
 #endif
+#ifndef VSI_PREAD64
+#define VSI_PREAD64 pread64
+#endif
+#ifndef VSI_PWRITE64
+#define VSI_PWRITE64 pwrite64
+#endif
+#ifndef VSI_OPEN64
+#define VSI_OPEN64 open64
+#endif
+#ifndef VSI_FSTAT64
+#define VSI_FSTAT64 fstat64
+#endif
+#ifndef VSI_FSTAT64_T
+#define VSI_FSTAT64_T stat64
+#endif
 
 #else /* not UNIX_STDIO_64 */
 
@@ -95,9 +111,89 @@ CPL_CVSID("$Id: cpl_vsil_unix_stdio_64.cpp 29006 2015-04-25 11:03:10Z rouault $"
 #ifndef VSI_FTRUNCATE64
 #define VSI_FTRUNCATE64 ftruncate
 #endif
+#ifndef VSI_PREAD64
+#define VSI_PREAD64 pread
+#endif
+#ifndef VSI_PWRITE64
+#define VSI_PWRITE64 pwrite
+#endif
+#ifndef VSI_OPEN64
+#define VSI_OPEN64 open
+#endif
+#ifndef VSI_FSTAT64
+#define VSI_FSTAT64 fstat
+#endif
+#ifndef VSI_FSTAT64_T
+#define VSI_FSTAT64_T stat
+#endif
 
 #endif /* ndef UNIX_STDIO_64 */
 
+/************************************************************************/
+/*                             VSIUnixPRead()                           */
+/************************************************************************/
+
+static size_t VSIUnixPRead( int fd, void* pBuffer, size_t nSize,
+                            vsi_l_offset nOffset )
+{
+    size_t nRead = 0;
+
+    while( nRead < nSize )
+    {
+        ssize_t nRet = VSI_PREAD64( fd, (GByte*) pBuffer + nRead,
+                                    nSize - nRead, nOffset + nRead );
+        if( nRet < 0 && errno == EINTR )
+            continue;
+        if( nRet <= 0 )
+            break;
+        nRead += nRet;
+    }
+
+    return nRead;
+}
+
+/************************************************************************/
+/*                            VSIUnixPWrite()                           */
+/************************************************************************/
+
+static size_t VSIUnixPWrite( int fd, const void* pBuffer, size_t nSize,
+                             vsi_l_offset nOffset )
+{
+    size_t nWritten = 0;
+
+    while( nWritten < nSize )
+    {
+        ssize_t nRet = VSI_PWRITE64( fd, (const GByte*) pBuffer + nWritten,
+                                     nSize - nWritten, nOffset + nWritten );
+        if( nRet < 0 && errno == EINTR )
+            continue;
+        if( nRet <= 0 )
+            break;
+        nWritten += nRet;
+    }
+
+    return nWritten;
+}
+
+/************************************************************************/
+/*                         VSIUnixAsyncReadFunc()                       */
+/*                                                                      */
+/*      Asynchronous requests are run with pread() on the file          */
+/*      descriptor, so that they neither use the buffer nor move the    */
+/*      offset of the handle, and can run concurrently with each other  */
+/*      and with the synchronous API.                                   */
+/************************************************************************/
+
+static void VSIUnixAsyncReadFunc( void* pData )
+{
+    VSIAsyncReadRequest* psRequest = (VSIAsyncReadRequest*) pData;
+    int fd = (int) (size_t) psRequest->poHandle->GetNativeFileDescriptor();
+
+    VSICompleteAsyncReadRequest( psRequest,
+        VSIUnixPRead( fd, psRequest->pBuffer, psRequest->nSize,
+                      psRequest->nOffset ) );
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIUnixStdioFilesystemHandler                  */
@@ -156,12 +252,17 @@ class VSIUnixStdioHandle : public VSIVirtualHandle
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
     virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    ReadAt( vsi_l_offset nOffset, void *pBuffer, size_t nSize );
     virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
     virtual int       Eof();
     virtual int       Flush();
     virtual int       Close();
     virtual int       Truncate( vsi_l_offset nNewSize );
     virtual void     *GetNativeFileDescriptor() { return (void*) (size_t) fileno(fp); }
+    virtual VSIAsyncReadRequest *ReadAsync( vsi_l_offset nOffset, void* pBuffer,
+                                            size_t nSize,
+                                            VSIAsyncReadCallback pfnCallback,
+                                            void* pUserData );
 };
 
 
@@ -366,6 +467,45 @@ size_t VSIUnixStdioHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
     return nResult;
 }
 
+/************************************************************************/
+/*                               ReadAt()                               */
+/************************************************************************/
+
+size_t VSIUnixStdioHandle::ReadAt( vsi_l_offset nOffset, void *pBuffer,
+                                   size_t nSize )
+{
+/* -------------------------------------------------------------------- */
+/*      pread() does not see what is still in the stdio buffer.         */
+/* -------------------------------------------------------------------- */
+    if( bLastOpWrite )
+        fflush( fp );
+
+    return VSIUnixPRead( fileno(fp), pBuffer, nSize, nOffset );
+}
+
+/************************************************************************/
+/*                              ReadAsync()                             */
+/************************************************************************/
+
+VSIAsyncReadRequest *VSIUnixStdioHandle::ReadAsync( vsi_l_offset nOffset,
+                                                    void* pBuffer, size_t nSize,
+                                                    VSIAsyncReadCallback pfnCallback,
+                                                    void* pUserData )
+{
+/* -------------------------------------------------------------------- */
+/*      pread() does not see what is still in the stdio buffer.         */
+/* -------------------------------------------------------------------- */
+    if( bLastOpWrite )
+        fflush( fp );
+
+    VSIAsyncReadRequest* psRequest =
+        VSICreateAsyncReadRequest( this, nOffset, pBuffer, nSize,
+                                   pfnCallback, pUserData );
+    VSISubmitAsyncReadJob( VSIUnixAsyncReadFunc, psRequest );
+
+    return psRequest;
+}
+
 /************************************************************************/
 /*                               Write()                                */
 /************************************************************************/
@@ -430,6 +570,340 @@ int VSIUnixStdioHandle::Truncate( vsi_l_offset nNewSize )
 }
 
 
+/************************************************************************/
+/* ==================================================================== */
+/*                       VSIUnixPositionalHandle                        */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Handle doing its I/O with pread() and pwrite() on a file descriptor. */
+/* Sequential Read() and Write() calls go through a private buffer.     */
+/* ReadAt() and ReadAsync() use neither the buffer nor the offset of    */
+/* the handle, and can be called concurrently from several threads.     */
+
+#define POSITIONAL_BUFFER_SIZE  65536
+#define DIRECT_IO_BUFFER_SIZE   (1024 * 1024)
+#define DIRECT_IO_ALIGNMENT     4096
+
+class VSIUnixPositionalHandle : public VSIVirtualHandle
+{
+    int           fd;
+    vsi_l_offset  nOffset;
+    int           bAtEOF;
+    int           bDirectIO;
+
+    GByte        *pabyBufferAlloc;
+    GByte        *pabyBuffer;
+    size_t        nBufferSize;
+    vsi_l_offset  nBufferOffset;
+    size_t        nBufferData;
+    int           bBufferDirty;
+
+    int           FlushBuffer();
+    void          DisableDirectIO();
+
+  public:
+                      VSIUnixPositionalHandle( int fdIn, int bDirectIOIn );
+    virtual          ~VSIUnixPositionalHandle();
+
+    virtual int       Seek( vsi_l_offset nOffset, int nWhence );
+    virtual vsi_l_offset Tell() { return nOffset; }
+    virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    ReadAt( vsi_l_offset nOffset, void *pBuffer, size_t nSize );
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       Eof() { return bAtEOF; }
+    virtual int       Flush() { return FlushBuffer(); }
+    virtual int       Close();
+    virtual int       Truncate( vsi_l_offset nNewSize );
+    virtual void     *GetNativeFileDescriptor() { return (void*) (size_t) fd; }
+    virtual VSIAsyncReadRequest *ReadAsync( vsi_l_offset nOffset, void* pBuffer,
+                                            size_t nSize,
+                                            VSIAsyncReadCallback pfnCallback,
+                                            void* pUserData );
+};
+
+/************************************************************************/
+/*                       VSIUnixPositionalHandle()                      */
+/************************************************************************/
+
+VSIUnixPositionalHandle::VSIUnixPositionalHandle( int fdIn, int bDirectIOIn ) :
+    fd(fdIn), nOffset(0), bAtEOF(FALSE), bDirectIO(bDirectIOIn),
+    nBufferOffset(0), nBufferData(0), bBufferDirty(FALSE)
+{
+/* -------------------------------------------------------------------- */
+/*      With O_DIRECT, the buffer must be aligned in memory, and is     */
+/*      only ever written at aligned file offsets.                      */
+/* -------------------------------------------------------------------- */
+    if( bDirectIO )
+    {
+        nBufferSize = DIRECT_IO_BUFFER_SIZE;
+        pabyBufferAlloc = (GByte*) CPLMalloc(nBufferSize + DIRECT_IO_ALIGNMENT);
+        pabyBuffer = pabyBufferAlloc + DIRECT_IO_ALIGNMENT -
+            ((size_t) pabyBufferAlloc) % DIRECT_IO_ALIGNMENT;
+    }
+    else
+    {
+        nBufferSize = POSITIONAL_BUFFER_SIZE;
+        pabyBufferAlloc = (GByte*) CPLMalloc(nBufferSize);
+        pabyBuffer = pabyBufferAlloc;
+    }
+}
+
+/************************************************************************/
+/*                      ~VSIUnixPositionalHandle()                      */
+/************************************************************************/
+
+VSIUnixPositionalHandle::~VSIUnixPositionalHandle()
+{
+    CPLFree( pabyBufferAlloc );
+}
+
+/************************************************************************/
+/*                           DisableDirectIO()                          */
+/************************************************************************/
+
+void VSIUnixPositionalHandle::DisableDirectIO()
+{
+#ifdef O_DIRECT
+    if( bDirectIO )
+    {
+        fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) & ~O_DIRECT );
+        bDirectIO = FALSE;
+    }
+#endif
+}
+
+/************************************************************************/
+/*                             FlushBuffer()                            */
+/************************************************************************/
+
+int VSIUnixPositionalHandle::FlushBuffer()
+{
+    if( !bBufferDirty )
+        return 0;
+
+    /* The end of the file is not a multiple of the alignment */
+    if( bDirectIO && (nBufferData % DIRECT_IO_ALIGNMENT) != 0 )
+        DisableDirectIO();
+
+    size_t nWritten = VSIUnixPWrite( fd, pabyBuffer, nBufferData,
+                                     nBufferOffset );
+    int nRet = (nWritten == nBufferData) ? 0 : -1;
+
+    bBufferDirty = FALSE;
+    nBufferData = 0;
+
+    return nRet;
+}
+
+/************************************************************************/
+/*                                Close()                               */
+/************************************************************************/
+
+int VSIUnixPositionalHandle::Close()
+{
+    VSIDebug1( "VSIUnixPositionalHandle::Close(%d)", fd );
+
+    int nRet = FlushBuffer();
+    if( close( fd ) != 0 )
+        nRet = -1;
+    fd = -1;
+
+    return nRet;
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+int VSIUnixPositionalHandle::Seek( vsi_l_offset nOffsetIn, int nWhence )
+{
+    bAtEOF = FALSE;
+
+    if( nWhence == SEEK_SET )
+        nOffset = nOffsetIn;
+    else if( nWhence == SEEK_CUR )
+        nOffset += nOffsetIn;
+    else if( nWhence == SEEK_END )
+    {
+        struct VSI_FSTAT64_T sStat;
+        if( VSI_FSTAT64( fd, &sStat ) != 0 )
+            return -1;
+
+        vsi_l_offset nFileSize = sStat.st_size;
+        if( bBufferDirty && nBufferOffset + nBufferData > nFileSize )
+            nFileSize = nBufferOffset + nBufferData;
+        nOffset = nFileSize + nOffsetIn;
+    }
+    else
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                                Read()                                */
+/************************************************************************/
+
+size_t VSIUnixPositionalHandle::Read( void * pBuffer, size_t nSize,
+                                      size_t nCount )
+{
+    size_t nToRead = nSize * nCount;
+    if( nToRead == 0 )
+        return 0;
+
+    if( bBufferDirty && FlushBuffer() != 0 )
+        return 0;
+
+    GByte* pabyOut = (GByte*) pBuffer;
+    size_t nDone = 0;
+    while( nDone < nToRead )
+    {
+/* -------------------------------------------------------------------- */
+/*      Serve what we can from the buffer.                              */
+/* -------------------------------------------------------------------- */
+        if( nOffset >= nBufferOffset && nOffset < nBufferOffset + nBufferData )
+        {
+            size_t nToCopy = MIN( nToRead - nDone,
+                              (size_t)(nBufferOffset + nBufferData - nOffset) );
+            memcpy( pabyOut + nDone, pabyBuffer + (nOffset - nBufferOffset),
+                    nToCopy );
+            nDone += nToCopy;
+            nOffset += nToCopy;
+            continue;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Large requests bypass the buffer, others refill it.             */
+/* -------------------------------------------------------------------- */
+        if( nToRead - nDone >= nBufferSize )
+        {
+            size_t nRead = VSIUnixPRead( fd, pabyOut + nDone, nToRead - nDone,
+                                         nOffset );
+            nDone += nRead;
+            nOffset += nRead;
+            break;
+        }
+
+        nBufferOffset = nOffset;
+        nBufferData = VSIUnixPRead( fd, pabyBuffer, nBufferSize, nOffset );
+        if( nBufferData == 0 )
+            break;
+    }
+
+    VSIDebug4( "VSIUnixPositionalHandle::Read(%d,%ld,%ld) = %ld",
+               fd, (long)nSize, (long)nCount, (long)(nDone / nSize) );
+
+    if( nDone != nToRead )
+        bAtEOF = TRUE;
+
+    return nDone / nSize;
+}
+
+/************************************************************************/
+/*                               ReadAt()                               */
+/************************************************************************/
+
+size_t VSIUnixPositionalHandle::ReadAt( vsi_l_offset nOffsetIn, void *pBuffer,
+                                        size_t nSize )
+{
+    if( bBufferDirty )
+        FlushBuffer();
+
+    return VSIUnixPRead( fd, pBuffer, nSize, nOffsetIn );
+}
+
+/************************************************************************/
+/*                              ReadAsync()                             */
+/************************************************************************/
+
+VSIAsyncReadRequest *VSIUnixPositionalHandle::ReadAsync( vsi_l_offset nOffsetIn,
+                                                         void* pBuffer, size_t nSize,
+                                                         VSIAsyncReadCallback pfnCallback,
+                                                         void* pUserData )
+{
+    if( bBufferDirty )
+        FlushBuffer();
+
+    VSIAsyncReadRequest* psRequest =
+        VSICreateAsyncReadRequest( this, nOffsetIn, pBuffer, nSize,
+                                   pfnCallback, pUserData );
+    VSISubmitAsyncReadJob( VSIUnixAsyncReadFunc, psRequest );
+
+    return psRequest;
+}
+
+/************************************************************************/
+/*                                Write()                               */
+/************************************************************************/
+
+size_t VSIUnixPositionalHandle::Write( const void * pBuffer, size_t nSize,
+                                       size_t nCount )
+{
+    size_t nToWrite = nSize * nCount;
+    if( nToWrite == 0 )
+        return 0;
+
+/* -------------------------------------------------------------------- */
+/*      Drop read data from the buffer, and flush pending writes that   */
+/*      are not contiguous with this one.                               */
+/* -------------------------------------------------------------------- */
+    if( !bBufferDirty )
+        nBufferData = 0;
+    else if( nOffset != nBufferOffset + nBufferData && FlushBuffer() != 0 )
+        return 0;
+
+    if( bDirectIO && nBufferData == 0 && (nOffset % DIRECT_IO_ALIGNMENT) != 0 )
+        DisableDirectIO();
+
+    const GByte* pabyIn = (const GByte*) pBuffer;
+    size_t nDone = 0;
+    while( nDone < nToWrite )
+    {
+        if( nBufferData == 0 && !bDirectIO && nToWrite - nDone >= nBufferSize )
+        {
+            size_t nWritten = VSIUnixPWrite( fd, pabyIn + nDone,
+                                             nToWrite - nDone, nOffset );
+            nDone += nWritten;
+            nOffset += nWritten;
+            break;
+        }
+
+        if( nBufferData == 0 )
+            nBufferOffset = nOffset;
+        size_t nToCopy = MIN( nToWrite - nDone, nBufferSize - nBufferData );
+        memcpy( pabyBuffer + nBufferData, pabyIn + nDone, nToCopy );
+        nBufferData += nToCopy;
+        bBufferDirty = TRUE;
+        nDone += nToCopy;
+        nOffset += nToCopy;
+
+        if( nBufferData == nBufferSize && FlushBuffer() != 0 )
+            return 0;
+    }
+
+    VSIDebug4( "VSIUnixPositionalHandle::Write(%d,%ld,%ld) = %ld",
+               fd, (long)nSize, (long)nCount, (long)(nDone / nSize) );
+
+    return nDone / nSize;
+}
+
+/************************************************************************/
+/*                              Truncate()                              */
+/************************************************************************/
+
+int VSIUnixPositionalHandle::Truncate( vsi_l_offset nNewSize )
+{
+    if( FlushBuffer() != 0 )
+        return -1;
+    nBufferData = 0;
+
+    return VSI_FTRUNCATE64( fd, nNewSize );
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIUnixStdioFilesystemHandler                  */
@@ -464,8 +938,64 @@ VSIUnixStdioFilesystemHandler::~VSIUnixStdioFilesystemHandler()
 }
 #endif
 
+/************************************************************************/
+/*                          VSIUnixGetOpenFlags()                       */
+/*                                                                      */
+/*      Translate a fopen() access string into open() flags. Append     */
+/*      modes are left to stdio.                                        */
+/************************************************************************/
+
+static int VSIUnixGetOpenFlags( const char* pszAccess, int* pnFlags )
+{
+    int bUpdate = strchr(pszAccess, '+') != NULL;
+
+    if( pszAccess[0] == 'r' )
+        *pnFlags = bUpdate ? O_RDWR : O_RDONLY;
+    else if( pszAccess[0] == 'w' )
+        *pnFlags = (bUpdate ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC;
+    else
+        return FALSE;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                            VSIUnixFAdvise()                          */
+/************************************************************************/
+
+static void VSIUnixFAdvise( CPL_UNUSED int fd )
+{
+#if defined(POSIX_FADV_SEQUENTIAL)
+    const char* pszAdvice = CPLGetConfigOption("CPL_VSIL_UNIX_FADVISE", NULL);
+    if( pszAdvice == NULL )
+        return;
+
+    int nAdvice;
+    if( EQUAL(pszAdvice, "SEQUENTIAL") )
+        nAdvice = POSIX_FADV_SEQUENTIAL;
+    else if( EQUAL(pszAdvice, "RANDOM") )
+        nAdvice = POSIX_FADV_RANDOM;
+    else if( EQUAL(pszAdvice, "NOREUSE") )
+        nAdvice = POSIX_FADV_NOREUSE;
+    else
+        nAdvice = POSIX_FADV_NORMAL;
+
+    posix_fadvise( fd, 0, 0, nAdvice );
+#endif
+}
+
 /************************************************************************/
 /*                                Open()                                */
+/*                                                                      */
+/*      Configuration options:                                          */
+/*       - CPL_VSIL_UNIX_POSITIONAL_IO=YES: open "r" and "w" modes      */
+/*         with open(), and do the I/O with pread()/pwrite() instead    */
+/*         of stdio.                                                    */
+/*       - CPL_VSIL_UNIX_FADVISE=SEQUENTIAL/RANDOM/NOREUSE/NORMAL:      */
+/*         access pattern passed to posix_fadvise() at open.            */
+/*       - CPL_VSIL_UNIX_O_DIRECT=YES: open "w" (write only) modes with */
+/*         O_DIRECT, so that large streaming writes bypass the page     */
+/*         cache. Implies CPL_VSIL_UNIX_POSITIONAL_IO for those files.  */
 /************************************************************************/
 
 VSIVirtualHandle *
@@ -473,20 +1003,66 @@ VSIUnixStdioFilesystemHandler::Open( const char *pszFilename,
                                      const char *pszAccess )
 
 {
-    FILE    *fp = VSI_FOPEN64( pszFilename, pszAccess );
-    int     nError = errno;
-    
-    VSIDebug3( "VSIUnixStdioFilesystemHandler::Open(\"%s\",\"%s\") = %p",
-               pszFilename, pszAccess, fp );
+    int bReadOnly = strcmp(pszAccess, "rb") == 0 || strcmp(pszAccess, "r") == 0;
+    VSIVirtualHandle *poHandle;
+    int     nError;
+
+    int bPositional =
+        CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_UNIX_POSITIONAL_IO", "NO"));
+    int bDirectIO = FALSE;
+#ifdef O_DIRECT
+    if( pszAccess[0] == 'w' && strchr(pszAccess, '+') == NULL &&
+        CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_UNIX_O_DIRECT", "NO")) )
+        bDirectIO = TRUE;
+#endif
 
-    if( fp == NULL )
+    int nFlags = 0;
+    if( (bPositional || bDirectIO) && VSIUnixGetOpenFlags(pszAccess, &nFlags) )
     {
-        errno = nError;
-        return NULL;
+#ifdef O_DIRECT
+        if( bDirectIO )
+            nFlags |= O_DIRECT;
+#endif
+        int fd = VSI_OPEN64( pszFilename, nFlags, 0666 );
+#ifdef O_DIRECT
+        /* Some file systems, like tmpfs, do not support O_DIRECT */
+        if( fd < 0 && bDirectIO && errno == EINVAL )
+        {
+            bDirectIO = FALSE;
+            fd = VSI_OPEN64( pszFilename, nFlags & ~O_DIRECT, 0666 );
+        }
+#endif
+        nError = errno;
+
+        VSIDebug3( "VSIUnixStdioFilesystemHandler::Open(\"%s\",\"%s\") = %d",
+                   pszFilename, pszAccess, fd );
+
+        if( fd < 0 )
+        {
+            errno = nError;
+            return NULL;
+        }
+
+        VSIUnixFAdvise( fd );
+        poHandle = new VSIUnixPositionalHandle( fd, bDirectIO );
     }
+    else
+    {
+        FILE    *fp = VSI_FOPEN64( pszFilename, pszAccess );
+        nError = errno;
 
-    int bReadOnly = strcmp(pszAccess, "rb") == 0 || strcmp(pszAccess, "r") == 0;
-    VSIUnixStdioHandle *poHandle = new VSIUnixStdioHandle(this, fp, bReadOnly );
+        VSIDebug3( "VSIUnixStdioFilesystemHandler::Open(\"%s\",\"%s\") = %p",
+                   pszFilename, pszAccess, fp );
+
+        if( fp == NULL )
+        {
+            errno = nError;
+            return NULL;
+        }
+
+        VSIUnixFAdvise( fileno(fp) );
+        poHandle = new VSIUnixStdioHandle(this, fp, bReadOnly );
+    }
 
     errno = nError;
 
@@ -497,7 +1073,7 @@ VSIUnixStdioFilesystemHandler::Open( const char *pszFilename,
     if( bReadOnly
         && CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
     {
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, pszFilename );
     }
     else
     {
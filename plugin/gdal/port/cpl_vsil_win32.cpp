@@ -448,7 +448,7 @@ VSIVirtualHandle *VSIWin32FilesystemHandler::Open( const char *pszFilename,
     if( (EQUAL(pszAccess,"r") || EQUAL(pszAccess,"rb"))
         && CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
     {
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, pszFilename );
     }
     else
     {
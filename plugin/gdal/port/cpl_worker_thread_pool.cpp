@@ -0,0 +1,190 @@
+/**********************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  Class to manage a pool of worker threads.
+ * Author:   GDAL project contributors
+ *
+ **********************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_worker_thread_pool.h"
+#include "cpl_conv.h"
+
+CPL_CVSID("$Id$");
+
+/************************************************************************/
+/*                         CPLWorkerThreadPool()                        */
+/************************************************************************/
+
+CPLWorkerThreadPool::CPLWorkerThreadPool() :
+    hMutex(NULL), hCond(NULL), nPendingJobs(0), bStop(FALSE)
+{
+}
+
+/************************************************************************/
+/*                        ~CPLWorkerThreadPool()                        */
+/*                                                                      */
+/*      Jobs already submitted are run before the threads terminate.    */
+/************************************************************************/
+
+CPLWorkerThreadPool::~CPLWorkerThreadPool()
+{
+    if( hMutex != NULL )
+    {
+        CPLAcquireMutex(hMutex, 1000.0);
+        bStop = TRUE;
+        CPLCondBroadcast(hCond);
+        CPLReleaseMutex(hMutex);
+    }
+
+    for( size_t i = 0; i < apoThreads.size(); i++ )
+        CPLJoinThread(apoThreads[i]);
+
+    if( hCond != NULL )
+        CPLDestroyCond(hCond);
+    if( hMutex != NULL )
+        CPLDestroyMutex(hMutex);
+}
+
+/************************************************************************/
+/*                                Setup()                               */
+/************************************************************************/
+
+/**
+ * \brief Start the worker threads.
+ *
+ * Must be called once, before any job is submitted.
+ *
+ * @param nThreads number of threads to start.
+ * @return the number of threads actually started. If 0, jobs will be
+ *         run synchronously by SubmitJob().
+ */
+
+int CPLWorkerThreadPool::Setup( int nThreads )
+{
+    CPLAssert( hMutex == NULL );
+
+    hCond = CPLCreateCond();
+    if( hCond == NULL )
+        return 0;
+    hMutex = CPLCreateMutex();
+    CPLReleaseMutex(hMutex);
+
+    for( int i = 0; i < nThreads; i++ )
+    {
+        CPLJoinableThread* hThread =
+            CPLCreateJoinableThread(WorkerThreadFunction, this);
+        if( hThread == NULL )
+            break;
+        apoThreads.push_back(hThread);
+    }
+
+    return (int)apoThreads.size();
+}
+
+/************************************************************************/
+/*                              SubmitJob()                             */
+/************************************************************************/
+
+/**
+ * \brief Queue a job.
+ *
+ * pfnFunc(pData) will be called by one of the threads of the pool, or
+ * by the calling thread itself if the pool has no thread.
+ */
+
+void CPLWorkerThreadPool::SubmitJob( CPLThreadFunc pfnFunc, void* pData )
+{
+    if( apoThreads.empty() )
+    {
+        pfnFunc(pData);
+        return;
+    }
+
+    CPLWorkerThreadJob sJob;
+    sJob.pfnFunc = pfnFunc;
+    sJob.pData = pData;
+
+    CPLMutexHolder oHolder( hMutex );
+    oJobQueue.push_back(sJob);
+    nPendingJobs ++;
+    CPLCondBroadcast(hCond);
+}
+
+/************************************************************************/
+/*                           WaitCompletion()                           */
+/************************************************************************/
+
+/**
+ * \brief Wait until all the submitted jobs have been run.
+ */
+
+void CPLWorkerThreadPool::WaitCompletion()
+{
+    if( apoThreads.empty() )
+        return;
+
+    CPLMutexHolder oHolder( hMutex );
+    while( nPendingJobs > 0 )
+        CPLCondWait(hCond, hMutex);
+}
+
+/************************************************************************/
+/*                        WorkerThreadFunction()                        */
+/************************************************************************/
+
+void CPLWorkerThreadPool::WorkerThreadFunction( void* pData )
+{
+    ((CPLWorkerThreadPool*) pData)->RunJobs();
+}
+
+/************************************************************************/
+/*                               RunJobs()                              */
+/************************************************************************/
+
+void CPLWorkerThreadPool::RunJobs()
+{
+    CPLAcquireMutex(hMutex, 1000.0);
+    while( TRUE )
+    {
+        if( oJobQueue.empty() )
+        {
+            if( bStop )
+                break;
+            CPLCondWait(hCond, hMutex);
+            continue;
+        }
+
+        CPLWorkerThreadJob sJob = oJobQueue.front();
+        oJobQueue.pop_front();
+        CPLReleaseMutex(hMutex);
+
+        sJob.pfnFunc(sJob.pData);
+
+        CPLAcquireMutex(hMutex, 1000.0);
+        nPendingJobs --;
+        if( nPendingJobs == 0 )
+            CPLCondBroadcast(hCond);
+    }
+    CPLReleaseMutex(hMutex);
+}
@@ -0,0 +1,86 @@
+/**********************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  Class to manage a pool of worker threads.
+ * Author:   GDAL project contributors
+ *
+ **********************************************************************
+ * Copyright (c) 2015, GDAL project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef CPL_WORKER_THREAD_POOL_H_INCLUDED
+#define CPL_WORKER_THREAD_POOL_H_INCLUDED
+
+#include "cpl_multiproc.h"
+
+#include <list>
+#include <vector>
+
+/**
+ * \file cpl_worker_thread_pool.h
+ *
+ * Class to manage a pool of worker threads.
+ * @since GDAL 2.0
+ */
+
+#ifndef DOXYGEN_SKIP
+typedef struct
+{
+    CPLThreadFunc  pfnFunc;
+    void          *pData;
+} CPLWorkerThreadJob;
+#endif
+
+/************************************************************************/
+/*                         CPLWorkerThreadPool                          */
+/************************************************************************/
+
+/** Pool of worker threads running jobs in submission order.
+ *
+ * When no thread can be started (for example with the stub threading
+ * model), SubmitJob() runs the job in the calling thread.
+ */
+class CPL_DLL CPLWorkerThreadPool
+{
+    std::vector<CPLJoinableThread*> apoThreads;
+    std::list<CPLWorkerThreadJob>   oJobQueue;
+    CPLMutex                       *hMutex;
+    CPLCond                        *hCond;
+    int                             nPendingJobs;
+    int                             bStop;
+
+    static void     WorkerThreadFunction( void* pData );
+    void            RunJobs();
+
+  public:
+                    CPLWorkerThreadPool();
+                   ~CPLWorkerThreadPool();
+
+    int             Setup( int nThreads );
+    void            SubmitJob( CPLThreadFunc pfnFunc, void* pData );
+    void            WaitCompletion();
+
+    /** Return the number of threads of the pool. */
+    int             GetThreadCount() const { return (int)apoThreads.size(); }
+};
+
+#endif /* CPL_WORKER_THREAD_POOL_H_INCLUDED */